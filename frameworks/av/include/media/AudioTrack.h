@@ -18,6 +18,7 @@
 #define ANDROID_AUDIOTRACK_H
 
 #include <cutils/sched_policy.h>
+#include <sys/uio.h>
 #include <media/AudioSystem.h>
 #include <media/AudioTimestamp.h>
 #include <media/IAudioTrack.h>
@@ -725,6 +726,14 @@ public:
      */
             ssize_t     write(const void* buffer, size_t size, bool blocking = true);
 
+    /* Same as write(), but gathers the data from iovcnt buffers described by iov.
+     * Each obtainBuffer() is filled from as many of the buffers as fit, so writing several
+     * small buffers costs as few obtain/release cycles as writing their concatenation.
+     * Only the total size needs to be a multiple of the frame size; a frame may span buffers.
+     * Returns the total number of bytes written, or the status codes listed for write().
+     */
+            ssize_t     writev(const struct iovec* iov, int iovcnt, bool blocking = true);
+
     /*
      * Dumps the state of an audio track.
      * Not a general-purpose API; intended only for use by media player service to dump its tracks.
@@ -490,6 +490,8 @@ private:
     status_t setLatency(uint32_t latency);
     status_t getLatency(uint32_t *latency);
     status_t setOperatingRate(float rateFloat, bool isVideo);
+    // |threadCount| of 0 lets the decoder choose based on the CPU topology.
+    status_t setDecoderThreadCount(int32_t threadCount);
     status_t getIntraRefreshPeriod(uint32_t *intraRefreshPeriod);
     status_t setIntraRefreshPeriod(uint32_t intraRefreshPeriod, bool inConfigure);
 
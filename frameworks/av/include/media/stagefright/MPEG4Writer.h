@@ -77,6 +77,7 @@ protected:
 
 private:
     class Track;
+    class AsyncWriter;
     friend struct AHandlerReflector<MPEG4Writer>;
 
     enum {
@@ -161,6 +162,7 @@ private:
 
     bool            mIsFirstChunk;
     volatile bool   mDone;                  // Writer thread is done?
+    AsyncWriter     *mAsyncWriter;          // Sample data I/O while the writer thread runs
     pthread_t       mThread;                // Thread id for the writer
     List<ChunkInfo> mChunkInfos;            // Chunk infos
     Condition       mChunkReadyCondition;   // Signal that chunks are available
@@ -207,6 +209,7 @@ private:
     void initInternal(int fd);
 
     // Acquire lock before calling these methods
+    void writeSampleData_l(const void *data, size_t size);
     off64_t addSample_l(MediaBuffer *buffer);
     off64_t addLengthPrefixedSample_l(MediaBuffer *buffer);
     off64_t addMultipleLengthPrefixedSamples_l(MediaBuffer *buffer);
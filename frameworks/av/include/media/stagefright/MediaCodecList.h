@@ -110,6 +110,15 @@ private:
     int32_t mDepth;
     AString mHrefBase;
 
+    // every XML file opened while parsing, with the stat() values the
+    // persisted cache is validated against
+    struct ConfigFile {
+        AString mPath;
+        int64_t mSize;
+        int64_t mModifiedNs;
+    };
+    Vector<ConfigFile> mConfigFiles;
+
     sp<AMessage> mGlobalSettings;
     KeyedVector<AString, CodecSettings> mOverrides;
 
@@ -121,6 +130,10 @@ private:
 
     status_t initCheck() const;
     void parseXMLFile(const char *path);
+    void configureResourcePolicies();
+
+    bool loadCache(const AString &codecsXml, const AString &performanceXml);
+    void saveCache(const AString &codecsXml, const AString &performanceXml) const;
 
     static void StartElementHandlerWrapper(
             void *me, const char *name, const char **attrs);
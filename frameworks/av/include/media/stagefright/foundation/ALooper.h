@@ -66,6 +66,7 @@ private:
 
     struct Event {
         int64_t mWhenUs;
+        int32_t mPriority;
         sp<AMessage> mMessage;
     };
 
@@ -75,6 +76,8 @@ private:
     AString mName;
 
     List<Event> mEventQueue;
+    // number of queued events with a non-zero priority
+    size_t mNumPrioritizedEvents;
 
     struct LooperThread;
     sp<LooperThread> mThread;
@@ -87,8 +90,9 @@ private:
 
     // START --- methods used only by AMessage
 
-    // posts a message on this looper with the given timeout
-    void post(const sp<AMessage> &msg, int64_t delayUs);
+    // posts a message on this looper with the given timeout. If coalesce is
+    // set, pending messages with the same what and target are dropped first.
+    void post(const sp<AMessage> &msg, int64_t delayUs, bool coalesce = false);
 
     // creates a reply token to be used with this looper
     sp<AReplyToken> createReplyToken();
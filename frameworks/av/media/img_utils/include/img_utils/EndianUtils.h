@@ -131,33 +131,26 @@ class ANDROID_API EndianOutput : public Output {
 template<typename T>
 inline status_t EndianOutput::writeHelper(const T* buf, size_t offset, size_t count) {
     assert(offset <= count);
+    if (mEndian != BIG && mEndian != LITTLE) {
+        return BAD_VALUE;
+    }
+
+    // Convert into a small batch so the wrapped output sees a few larger writes rather than
+    // one per element.
+    const size_t BATCH_SIZE = 64;
+    T tmp[BATCH_SIZE];
+    size_t batched = 0;
     status_t res = OK;
-    size_t size = sizeof(T);
-    switch(mEndian) {
-        case BIG: {
-            for (size_t i = offset; i < count; ++i) {
-                T tmp = convertToBigEndian<T>(buf[offset + i]);
-                if ((res = mOutput->write(reinterpret_cast<uint8_t*>(&tmp), 0, size))
-                        != OK) {
-                    return res;
-                }
-                mOffset += size;
+    for (size_t i = offset; i < count; ++i) {
+        tmp[batched++] = (mEndian == BIG) ? convertToBigEndian<T>(buf[offset + i]) :
+                convertToLittleEndian<T>(buf[offset + i]);
+        if (batched == BATCH_SIZE || i + 1 == count) {
+            size_t size = batched * sizeof(T);
+            if ((res = mOutput->write(reinterpret_cast<uint8_t*>(tmp), 0, size)) != OK) {
+                return res;
             }
-            break;
-        }
-        case LITTLE: {
-            for (size_t i = offset; i < count; ++i) {
-                T tmp = convertToLittleEndian<T>(buf[offset + i]);
-                if ((res = mOutput->write(reinterpret_cast<uint8_t*>(&tmp), 0, size))
-                        != OK) {
-                    return res;
-                }
-                mOffset += size;
-            }
-            break;
-        }
-        default: {
-            return BAD_VALUE;
+            mOffset += size;
+            batched = 0;
         }
     }
     return res;
@@ -92,7 +92,7 @@ void FifoBuffer::fillWrappingBuffer(WrappingBuffer *wrappingBuffer,
             wrappingBuffer->data[0] = source;
             wrappingBuffer->numFrames[0] = mFrameCapacity - startIndex;
             wrappingBuffer->data[1] = &mStorage[0];
-            wrappingBuffer->numFrames[1] = mFrameCapacity - startIndex;
+            wrappingBuffer->numFrames[1] = framesAvailable - wrappingBuffer->numFrames[0];
 
         } else {
             wrappingBuffer->data[0] = source;
@@ -105,79 +105,77 @@ void FifoBuffer::fillWrappingBuffer(WrappingBuffer *wrappingBuffer,
 
 }
 
+// The counters may live in shared memory and be updated by another process, so each one is
+// loaded only once per operation. The reader owns the read counter and the writer owns the write
+// counter, so the value loaded by the owner stays valid until it advances it.
+
 fifo_frames_t FifoBuffer::getFullDataAvailable(WrappingBuffer *wrappingBuffer) {
-    fifo_frames_t framesAvailable = mFifo->getFullFramesAvailable();
-    fifo_frames_t startIndex = mFifo->getReadIndex();
-    fillWrappingBuffer(wrappingBuffer, framesAvailable, startIndex);
+    fifo_counter_t readCounter = mFifo->getReadCounter();
+    fifo_frames_t framesAvailable = (fifo_frames_t) (mFifo->getWriteCounter() - readCounter);
+    fillWrappingBuffer(wrappingBuffer, framesAvailable, mFifo->getIndex(readCounter));
     return framesAvailable;
 }
 
 fifo_frames_t FifoBuffer::getEmptyRoomAvailable(WrappingBuffer *wrappingBuffer) {
-    fifo_frames_t framesAvailable = mFifo->getEmptyFramesAvailable();
-    fifo_frames_t startIndex = mFifo->getWriteIndex();
-    fillWrappingBuffer(wrappingBuffer, framesAvailable, startIndex);
+    fifo_counter_t writeCounter = mFifo->getWriteCounter();
+    fifo_frames_t framesAvailable = mFifo->getThreshold()
+            - (fifo_frames_t) (writeCounter - mFifo->getReadCounter());
+    fillWrappingBuffer(wrappingBuffer, framesAvailable, mFifo->getIndex(writeCounter));
     return framesAvailable;
 }
 
 fifo_frames_t FifoBuffer::read(void *buffer, fifo_frames_t numFrames) {
-    WrappingBuffer wrappingBuffer;
-    uint8_t *destination = (uint8_t *) buffer;
-    fifo_frames_t framesLeft = numFrames;
-
-    getFullDataAvailable(&wrappingBuffer);
+    fifo_counter_t readCounter = mFifo->getReadCounter();
+    fifo_frames_t framesRead = (fifo_frames_t) (mFifo->getWriteCounter() - readCounter);
+    if (framesRead <= 0) {
+        return 0;
+    }
+    if (framesRead > numFrames) {
+        framesRead = numFrames;
+    }
 
     // Read data in one or two parts.
-    int partIndex = 0;
-    while (framesLeft > 0 && partIndex < WrappingBuffer::SIZE) {
-        fifo_frames_t framesToRead = framesLeft;
-        fifo_frames_t framesAvailable = wrappingBuffer.numFrames[partIndex];
-        if (framesAvailable > 0) {
-            if (framesToRead > framesAvailable) {
-                framesToRead = framesAvailable;
-            }
-            int32_t numBytes = convertFramesToBytes(framesToRead);
-            memcpy(destination, wrappingBuffer.data[partIndex], numBytes);
-
-            destination += numBytes;
-            framesLeft -= framesToRead;
-        } else {
-            break;
-        }
-        partIndex++;
+    fifo_frames_t startIndex = mFifo->getIndex(readCounter);
+    fifo_frames_t framesToEnd = mFrameCapacity - startIndex;
+    uint8_t *destination = (uint8_t *) buffer;
+    if (framesRead <= framesToEnd) {
+        memcpy(destination, &mStorage[convertFramesToBytes(startIndex)],
+               convertFramesToBytes(framesRead));
+    } else {
+        int32_t numBytes = convertFramesToBytes(framesToEnd);
+        memcpy(destination, &mStorage[convertFramesToBytes(startIndex)], numBytes);
+        memcpy(destination + numBytes, &mStorage[0],
+               convertFramesToBytes(framesRead - framesToEnd));
     }
-    fifo_frames_t framesRead = numFrames - framesLeft;
-    mFifo->advanceReadIndex(framesRead);
+    mFifo->setReadCounter(readCounter + framesRead);
     return framesRead;
 }
 
 fifo_frames_t FifoBuffer::write(const void *buffer, fifo_frames_t numFrames) {
-    WrappingBuffer wrappingBuffer;
-    uint8_t *source = (uint8_t *) buffer;
-    fifo_frames_t framesLeft = numFrames;
-
-    getEmptyRoomAvailable(&wrappingBuffer);
+    fifo_counter_t writeCounter = mFifo->getWriteCounter();
+    fifo_frames_t framesWritten = mFifo->getThreshold()
+            - (fifo_frames_t) (writeCounter - mFifo->getReadCounter());
+    if (framesWritten <= 0) {
+        return 0;
+    }
+    if (framesWritten > numFrames) {
+        framesWritten = numFrames;
+    }
 
-    // Read data in one or two parts.
-    int partIndex = 0;
-    while (framesLeft > 0 && partIndex < WrappingBuffer::SIZE) {
-        fifo_frames_t framesToWrite = framesLeft;
-        fifo_frames_t framesAvailable = wrappingBuffer.numFrames[partIndex];
-        if (framesAvailable > 0) {
-            if (framesToWrite > framesAvailable) {
-                framesToWrite = framesAvailable;
-            }
-            int32_t numBytes = convertFramesToBytes(framesToWrite);
-            memcpy(wrappingBuffer.data[partIndex], source, numBytes);
-
-            source += numBytes;
-            framesLeft -= framesToWrite;
-        } else {
-            break;
-        }
-        partIndex++;
+    // Write data in one or two parts.
+    fifo_frames_t startIndex = mFifo->getIndex(writeCounter);
+    fifo_frames_t framesToEnd = mFrameCapacity - startIndex;
+    const uint8_t *source = (const uint8_t *) buffer;
+    if (framesWritten <= framesToEnd) {
+        memcpy(&mStorage[convertFramesToBytes(startIndex)], source,
+               convertFramesToBytes(framesWritten));
+    } else {
+        int32_t numBytes = convertFramesToBytes(framesToEnd);
+        memcpy(&mStorage[convertFramesToBytes(startIndex)], source, numBytes);
+        memcpy(&mStorage[0], source + numBytes,
+               convertFramesToBytes(framesWritten - framesToEnd));
     }
-    fifo_frames_t framesWritten = numFrames - framesLeft;
-    mFifo->advanceWriteIndex(framesWritten);
+    mFifo->setWriteCounter(writeCounter + framesWritten);
     return framesWritten;
 }
 
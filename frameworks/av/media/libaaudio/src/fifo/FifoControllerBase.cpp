@@ -26,6 +26,7 @@ using namespace android;  // TODO just import names needed
 FifoControllerBase::FifoControllerBase(fifo_frames_t capacity, fifo_frames_t threshold)
         : mCapacity(capacity)
         , mThreshold(threshold)
+        , mIndexMask((capacity > 1 && (capacity & (capacity - 1)) == 0) ? capacity - 1 : 0)
 {
 }
 
@@ -37,8 +38,7 @@ fifo_frames_t FifoControllerBase::getFullFramesAvailable() {
 }
 
 fifo_frames_t FifoControllerBase::getReadIndex() {
-    // % works with non-power of two sizes
-    return (fifo_frames_t) (getReadCounter() % mCapacity);
+    return getIndex(getReadCounter());
 }
 
 void FifoControllerBase::advanceReadIndex(fifo_frames_t numFrames) {
@@ -50,8 +50,7 @@ fifo_frames_t FifoControllerBase::getEmptyFramesAvailable() {
 }
 
 fifo_frames_t FifoControllerBase::getWriteIndex() {
-    // % works with non-power of two sizes
-    return (fifo_frames_t) (getWriteCounter() % mCapacity);
+    return getIndex(getWriteCounter());
 }
 
 void FifoControllerBase::advanceWriteIndex(fifo_frames_t numFrames) {
@@ -114,10 +114,20 @@ public:
         return mCapacity;
     }
 
+    /**
+     * @param counter a read or write counter
+     * @return index in the circular buffer of the frame at that position
+     */
+    fifo_frames_t getIndex(fifo_counter_t counter) const {
+        // A 64-bit % is a library call on 32-bit ARM, so mask when possible.
+        return (fifo_frames_t) (mIndexMask != 0 ? (counter & mIndexMask) : (counter % mCapacity));
+    }
+
 
 private:
     fifo_frames_t mCapacity;
     fifo_frames_t mThreshold;
+    fifo_counter_t mIndexMask; // capacity - 1 if the capacity is a power of two, else 0
 };
 
 }  // android
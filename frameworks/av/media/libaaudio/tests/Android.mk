@@ -40,6 +40,16 @@ LOCAL_SHARED_LIBRARIES := libaaudio
 LOCAL_MODULE := test_linear_ramp
 include $(BUILD_NATIVE_TEST)
 
+include $(CLEAR_VARS)
+LOCAL_C_INCLUDES := \
+    $(call include-path-for, audio-utils) \
+    frameworks/av/media/libaaudio/include \
+    frameworks/av/media/libaaudio/src
+LOCAL_SRC_FILES:= test_fifo_buffer.cpp
+LOCAL_SHARED_LIBRARIES := libaaudio
+LOCAL_MODULE := test_fifo_buffer
+include $(BUILD_NATIVE_TEST)
+
 include $(CLEAR_VARS)
 LOCAL_C_INCLUDES := \
     $(call include-path-for, audio-utils) \
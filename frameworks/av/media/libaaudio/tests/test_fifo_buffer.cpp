@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "fifo/FifoBuffer.h"
+
+using android::fifo_frames_t;
+using android::FifoBuffer;
+using android::WrappingBuffer;
+
+// Writes and reads blocks that do not divide the capacity, so that they cross the end of the
+// FIFO, and checks that the data comes out in order.
+static void checkWrapAround(fifo_frames_t capacity) {
+    const int32_t kBlockSize = 3;
+    FifoBuffer fifo(sizeof(int16_t), capacity);
+    int16_t next = 0;
+    int16_t expected = 0;
+    for (int i = 0; i < capacity * 4; i++) {
+        int16_t block[kBlockSize];
+        for (int j = 0; j < kBlockSize; j++) {
+            block[j] = next + j;
+        }
+        ASSERT_EQ(kBlockSize, fifo.write(block, kBlockSize));
+        next += kBlockSize;
+
+        int16_t result[kBlockSize] = {};
+        ASSERT_EQ(kBlockSize, fifo.read(result, kBlockSize));
+        for (int j = 0; j < kBlockSize; j++) {
+            ASSERT_EQ(expected++, result[j]);
+        }
+    }
+}
+
+TEST(test_fifo_buffer, fifo_wrap_power_of_two) {
+    checkWrapAround(16);
+}
+
+TEST(test_fifo_buffer, fifo_wrap_other_size) {
+    checkWrapAround(10);
+}
+
+TEST(test_fifo_buffer, fifo_limits) {
+    FifoBuffer fifo(sizeof(int16_t), 8);
+    int16_t data[12] = {};
+    ASSERT_EQ(8, fifo.write(data, 12));
+    ASSERT_EQ(0, fifo.write(data, 1));
+    ASSERT_EQ(5, fifo.read(data, 5));
+    ASSERT_EQ(3, fifo.read(data, 12));
+    ASSERT_EQ(0, fifo.read(data, 1));
+}
+
+TEST(test_fifo_buffer, fifo_wrapping_buffer_parts) {
+    FifoBuffer fifo(sizeof(int16_t), 8);
+    int16_t data[8] = {};
+    ASSERT_EQ(6, fifo.write(data, 6));
+    ASSERT_EQ(6, fifo.read(data, 6));
+    ASSERT_EQ(4, fifo.write(data, 4));
+
+    // 4 frames at index 6, split across the end.
+    WrappingBuffer wrappingBuffer;
+    ASSERT_EQ(4, fifo.getFullDataAvailable(&wrappingBuffer));
+    ASSERT_EQ(2, wrappingBuffer.numFrames[0]);
+    ASSERT_EQ(2, wrappingBuffer.numFrames[1]);
+
+    // 4 empty frames at index 2, contiguous.
+    ASSERT_EQ(4, fifo.getEmptyRoomAvailable(&wrappingBuffer));
+    ASSERT_EQ(4, wrappingBuffer.numFrames[0]);
+    ASSERT_EQ(0, wrappingBuffer.numFrames[1]);
+}
@@ -21,6 +21,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <sys/resource.h>
+#include <sys/uio.h>
 
 #include <audio_utils/clock.h>
 #include <audio_utils/primitives.h>
@@ -1868,6 +1869,14 @@ ssize_t AudioTrack::write(const void* buffer, size_t userSize, bool blocking)
 {
     MTK_ALOGV("%s: %p, userSize = %zu, blocking = %d", __FUNCTION__, this, userSize, blocking);
     ALOGV("%s: %p, userSize = %zu, blocking = %d", __FUNCTION__, this, userSize, blocking);
+    struct iovec iov;
+    iov.iov_base = const_cast<void *>(buffer);
+    iov.iov_len = userSize;
+    return writev(&iov, 1, blocking);
+}
+
+ssize_t AudioTrack::writev(const struct iovec* iov, int iovcnt, bool blocking)
+{
     if (mTransfer != TRANSFER_SYNC) {
         return INVALID_OPERATION;
     }
@@ -1882,16 +1891,30 @@ ssize_t AudioTrack::write(const void* buffer, size_t userSize, bool blocking)
         }
     }
 
-    if (ssize_t(userSize) < 0 || (buffer == NULL && userSize != 0)) {
-        // Sanity-check: user is most-likely passing an error code, and it would
-        // make the return value ambiguous (actualSize vs error).
-        ALOGE("AudioTrack::write(buffer=%p, size=%zu (%zd)", buffer, userSize, userSize);
+    if (iovcnt < 0 || (iov == NULL && iovcnt != 0)) {
+        ALOGE("AudioTrack::writev(iov=%p, iovcnt=%d)", iov, iovcnt);
         return BAD_VALUE;
     }
+    size_t userSize = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        userSize += iov[i].iov_len;
+        if (ssize_t(iov[i].iov_len) < 0 || ssize_t(userSize) < 0
+                || (iov[i].iov_base == NULL && iov[i].iov_len != 0)) {
+            // Sanity-check: user is most-likely passing an error code, and it would
+            // make the return value ambiguous (actualSize vs error).
+            ALOGE("AudioTrack::write(buffer=%p, size=%zu (%zd)",
+                    iov[i].iov_base, iov[i].iov_len, iov[i].iov_len);
+            return BAD_VALUE;
+        }
+    }
 
     size_t written = 0;
     Buffer audioBuffer;
 
+    // Position within the gathered data
+    int index = 0;
+    size_t consumed = 0;
+
     while (userSize >= mFrameSize) {
         audioBuffer.frameCount = userSize / mFrameSize;
 
@@ -1908,9 +1931,23 @@ ssize_t AudioTrack::write(const void* buffer, size_t userSize, bool blocking)
             return ssize_t(err);
         }
 
+        // Fill the whole contiguous region from as many buffers as it takes.
         size_t toWrite = audioBuffer.size;
-        memcpy(audioBuffer.i8, buffer, toWrite);
-        buffer = ((const char *) buffer) + toWrite;
+        int8_t *dst = audioBuffer.i8;
+        for (size_t remaining = toWrite; remaining > 0; ) {
+            size_t chunk = iov[index].iov_len - consumed;
+            if (chunk > remaining) {
+                chunk = remaining;
+            }
+            memcpy(dst, (const int8_t *) iov[index].iov_base + consumed, chunk);
+            dst += chunk;
+            remaining -= chunk;
+            consumed += chunk;
+            if (consumed == iov[index].iov_len) {
+                index++;
+                consumed = 0;
+            }
+        }
         userSize -= toWrite;
         written += toWrite;
 
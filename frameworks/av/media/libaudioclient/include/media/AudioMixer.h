@@ -52,14 +52,16 @@ class AudioMixer
 {
 public:
                             AudioMixer(size_t frameCount, uint32_t sampleRate,
-                                       uint32_t maxNumTracks = MAX_NUM_TRACKS);
+                                       uint32_t maxNumTracks = DEFAULT_NUM_TRACKS);
 
     /*virtual*/             ~AudioMixer();  // non-virtual saves a v-table, restore if sub-classed
 
 
-    // This mixer has a hard-coded upper limit of 32 active track inputs.
-    // Adding support for > 32 tracks would require more than simply changing this value.
-    static const uint32_t MAX_NUM_TRACKS = 32;
+    // Track capacity used when the caller does not specify maxNumTracks.
+    static const uint32_t DEFAULT_NUM_TRACKS = 32;
+    // Upper limit on maxNumTracks, set by the range of track names (TRACK0 up to 0x2000).
+    // The track table is allocated once at construction, so capacity costs memory, not time.
+    static const uint32_t MAX_NUM_TRACKS = 0x1000;
     // maximum number of channels supported by the mixer
 
     // This mixer has a hard-coded upper limit of 8 channels for output.
@@ -126,7 +128,7 @@ public:
     };
 
 
-    // For all APIs with "name": TRACK0 <= name < TRACK0 + MAX_NUM_TRACKS
+    // For all APIs with "name": TRACK0 <= name < TRACK0 + maxNumTracks()
 
     // Allocate a track name.  Returns new track name if successful, -1 on failure.
     // The failure could be because of an invalid channelMask or format, or that
@@ -146,7 +148,19 @@ public:
     void        setBufferProvider(int name, AudioBufferProvider* bufferProvider);
     void        process();
 
-    uint32_t    trackNames() const { return mTrackNames; }
+    // Use 'count' extra threads to pre-process tracks (resample, reformat, volume) in
+    // parallel before they are accumulated in order on the calling thread; 0 disables them.
+    // The calling thread also takes work, so late workers cost at most the serial mix time.
+    // Call before any track name is allocated.  Ignored when DRC is built in.
+    void        setWorkerCount(uint32_t count);
+
+    // Caches the resampler filters that tracks at common sample rates will need on a
+    // mixer running at sampleRate, so that starting such tracks does not design filters.
+    static void prebuildResamplerFilters(uint32_t sampleRate);
+
+    // Number of allocated track names, and the capacity given at construction
+    uint32_t    trackCount() const { return mState.maxNumTracks - mFreeNameCount; }
+    uint32_t    maxNumTracks() const { return mState.maxNumTracks; }
 
     size_t      getUnreleasedFrames(int name) const;
 
@@ -186,6 +200,7 @@ private:
 
     struct state_t;
     struct track_t;
+    class WorkerGroup;
 
     typedef void (*hook_t)(track_t* t, int32_t* output, size_t numOutFrames, int32_t* temp,
                            int32_t* aux);
@@ -214,8 +229,9 @@ private:
         uint16_t    frameCount;
 
         uint8_t     channelCount;   // 1 or 2, redundant with (needs & NEEDS_CHANNEL_COUNT__MASK)
-        uint8_t     unused_padding; // formerly format, was always 16
-        uint16_t    enabled;        // actually bool
+        uint8_t     changed;        // actually bool, queued in state_t::changedTracks
+        uint8_t     enabled;        // actually bool
+        uint8_t     listed;         // actually bool, present in state_t::enabledTracks
         audio_channel_mask_t channelMask;
 
         // actual buffer provider used by the track hooks, see DownmixerBufferProvider below
@@ -261,6 +277,11 @@ private:
         PassthruBufferProvider*  mTimestretchBufferProvider;
 
         int32_t     sessionId;
+        bool        allocated;      // between getTrackName() and deleteTrackName()
+
+        // mix output then scratch for parallel pre-processing, 2 * MAX_NUM_CHANNELS
+        // * frameCount samples; only allocated while the mixer has workers
+        int32_t*    workBuffer;
 
         audio_format_t mMixerFormat;     // output mix format: AUDIO_FORMAT_PCM_(FLOAT|16_BIT)
         audio_format_t mFormat;          // input track format
@@ -324,18 +345,25 @@ public:
 
     typedef void (*process_hook_t)(state_t* state);
 
-    // pad to 32-bytes to fill cache line
+    // The track table and both index lists are sized for maxNumTracks at construction,
+    // so neither process() nor the name allocation path ever reallocates them.
     struct state_t {
-        uint32_t        enabledTracks;
-        uint32_t        needsChanged;
+        uint32_t        enabledCount;   // number of entries in enabledTracks
+        uint32_t        changedCount;   // number of entries in changedTracks
         size_t          frameCount;
         process_hook_t  hook;   // one of process__*, never NULL
         int32_t         *outputTemp;
         int32_t         *resampleTemp;
         NBLog::Writer*  mNBLogWriter;   // associated NBLog::Writer or &mDummyLog
-        int32_t         reserved[1];
-        // FIXME allocate dynamically to save some memory when maxNumTracks < MAX_NUM_TRACKS
-        track_t         tracks[MAX_NUM_TRACKS] __attribute__((aligned(32)));
+        uint32_t        maxNumTracks;
+        track_t         *tracks;        // maxNumTracks entries, indexed by name - TRACK0
+        // Dense list of enabled track indices, kept by process__validate() grouped by
+        // mainBuffer, and within a group in decreasing index order.
+        uint32_t        *enabledTracks;
+        // Track indices invalidated since the last process__validate(), each at most once.
+        uint32_t        *changedTracks;
+        WorkerGroup     *workers;       // NULL unless setWorkerCount() > 0
+        uint32_t        *workTracks;    // indices handed to workers by the current process hook
 // <MTK_AUDIO
         // For DRC
         int32_t         *nonResampleTemp;
@@ -343,12 +371,9 @@ public:
 // MTK_AUDIO>
     };
 
-    // bitmask of allocated track names, where bit 0 corresponds to TRACK0 etc.
-    uint32_t        mTrackNames;
-
-    // bitmask of configured track names; ~0 if maxNumTracks == MAX_NUM_TRACKS,
-    // but will have fewer bits set if maxNumTracks < MAX_NUM_TRACKS
-    const uint32_t  mConfiguredNames;
+    // stack of free track indices; the top is the lowest index not yet handed out
+    uint32_t        *mFreeNames;
+    uint32_t        mFreeNameCount;
 
     const uint32_t  mSampleRate;
 
@@ -361,8 +386,8 @@ private:
     state_t         mState __attribute__((aligned(32)));
 
     // Call after changing either the enabled status of a track, or parameters of an enabled track.
-    // OK to call more often than that, but unnecessary.
-    void invalidateState(uint32_t mask);
+    // OK to call more often than that, but unnecessary.  'name' is the track index (name - TRACK0).
+    void invalidateState(int name);
 
     bool setChannelMasks(int name,
             audio_channel_mask_t trackChannelMask, audio_channel_mask_t mixerChannelMask);
@@ -380,9 +405,12 @@ private:
             int32_t* aux);
 
     static void process__validate(state_t* state);
+    static void groupEnabledTracks(state_t* state);
     static void process__nop(state_t* state);
     static void process__genericNoResampling(state_t* state);
     static void process__genericResampling(state_t* state);
+    static void processTrack(state_t* state, track_t& t, int32_t* out, int32_t* temp);
+    static void processTrackWork(void* arg, uint32_t item);
     static void process__OneTrack16BitsStereoNoResampling(state_t* state);
 
     static pthread_once_t   sOnceControl;
@@ -268,7 +268,9 @@ struct StreamOutCallback : public IStreamOutCallback {
 }  // namespace
 
 StreamOutHalHidl::StreamOutHalHidl(const sp<IStreamOut>& stream)
-        : StreamHalHidl(stream.get()), mStream(stream), mWriterClient(0), mEfGroup(nullptr) {
+        : StreamHalHidl(stream.get()), mStream(stream), mWriterClient(0), mEfGroup(nullptr),
+          mPresentationValid(false), mPresentationFetchedNs(0), mPresentationFrames(0),
+          mPresentationTimestamp{} {
 }
 
 StreamOutHalHidl::~StreamOutHalHidl() {
@@ -482,11 +484,13 @@ status_t StreamOutHalHidl::supportsPauseAndResume(bool *supportsPause, bool *sup
 
 status_t StreamOutHalHidl::pause() {
     if (mStream == 0) return NO_INIT;
+    invalidatePresentationPosition();
     return processReturn("pause", mStream->pause());
 }
 
 status_t StreamOutHalHidl::resume() {
     if (mStream == 0) return NO_INIT;
+    invalidatePresentationPosition();
     return processReturn("pause", mStream->resume());
 }
 
@@ -497,15 +501,48 @@ status_t StreamOutHalHidl::supportsDrain(bool *supportsDrain) {
 
 status_t StreamOutHalHidl::drain(bool earlyNotify) {
     if (mStream == 0) return NO_INIT;
+    invalidatePresentationPosition();
     return processReturn(
             "drain", mStream->drain(earlyNotify ? AudioDrain::EARLY_NOTIFY : AudioDrain::ALL));
 }
 
 status_t StreamOutHalHidl::flush() {
     if (mStream == 0) return NO_INIT;
+    invalidatePresentationPosition();
     return processReturn("pause", mStream->flush());
 }
 
+// How long another thread may reuse a presentation position fetched from the HAL.
+// AudioFlinger's writer refreshes it every mix period while it is playing.
+static const nsecs_t kMaxCachedPresentationAgeNs = 10 * 1000 * 1000;
+
+void StreamOutHalHidl::cachePresentationPosition(
+        uint64_t frames, const struct timespec& timestamp) {
+    std::lock_guard<std::mutex> lock(mPresentationLock);
+    mPresentationValid = true;
+    mPresentationFetchedNs = systemTime(SYSTEM_TIME_MONOTONIC);
+    mPresentationFrames = frames;
+    mPresentationTimestamp = timestamp;
+}
+
+bool StreamOutHalHidl::getCachedPresentationPosition(
+        uint64_t *frames, struct timespec *timestamp) {
+    std::lock_guard<std::mutex> lock(mPresentationLock);
+    if (!mPresentationValid ||
+            systemTime(SYSTEM_TIME_MONOTONIC) - mPresentationFetchedNs >
+                    kMaxCachedPresentationAgeNs) {
+        return false;
+    }
+    *frames = mPresentationFrames;
+    *timestamp = mPresentationTimestamp;
+    return true;
+}
+
+void StreamOutHalHidl::invalidatePresentationPosition() {
+    std::lock_guard<std::mutex> lock(mPresentationLock);
+    mPresentationValid = false;
+}
+
 status_t StreamOutHalHidl::getPresentationPosition(uint64_t *frames, struct timespec *timestamp) {
     if (mStream == 0) return NO_INIT;
     if (mWriterClient == gettid() && mCommandMQ) {
@@ -515,8 +552,12 @@ status_t StreamOutHalHidl::getPresentationPosition(uint64_t *frames, struct time
                     *frames = writeStatus.reply.presentationPosition.frames;
                     timestamp->tv_sec = writeStatus.reply.presentationPosition.timeStamp.tvSec;
                     timestamp->tv_nsec = writeStatus.reply.presentationPosition.timeStamp.tvNSec;
+                    cachePresentationPosition(*frames, *timestamp);
                 });
     } else {
+        if (getCachedPresentationPosition(frames, timestamp)) {
+            return OK;
+        }
         Result retval;
         Return<void> ret = mStream->getPresentationPosition(
                 [&](Result r, uint64_t hidlFrames, const TimeSpec& hidlTimeStamp) {
@@ -525,6 +566,7 @@ status_t StreamOutHalHidl::getPresentationPosition(uint64_t *frames, struct time
                         *frames = hidlFrames;
                         timestamp->tv_sec = hidlTimeStamp.tvSec;
                         timestamp->tv_nsec = hidlTimeStamp.tvNSec;
+                        cachePresentationPosition(*frames, *timestamp);
                     }
                 });
         return processReturn("getPresentationPosition", ret, retval);
@@ -18,6 +18,7 @@
 #define ANDROID_HARDWARE_STREAM_HAL_HIDL_H
 
 #include <atomic>
+#include <mutex>
 
 #include <android/hardware/audio/2.0/IStream.h>
 #include <android/hardware/audio/2.0/IStreamIn.h>
@@ -25,6 +26,7 @@
 #include <fmq/EventFlag.h>
 #include <fmq/MessageQueue.h>
 #include <media/audiohal/StreamHalInterface.h>
+#include <utils/Timers.h>
 
 #include "ConversionHelperHidl.h"
 #include "StreamPowerLog.h"
@@ -177,6 +179,15 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
     std::atomic<pid_t> mWriterClient;
     EventFlag* mEfGroup;
 
+    // Last presentation position obtained from the HAL. A position and its timestamp stay
+    // a valid pair, so threads other than the writer can reuse a recent one instead of
+    // making a synchronous HIDL call.
+    std::mutex mPresentationLock;
+    bool mPresentationValid;
+    nsecs_t mPresentationFetchedNs;
+    uint64_t mPresentationFrames;
+    struct timespec mPresentationTimestamp;
+
     // Can not be constructed directly by clients.
     StreamOutHalHidl(const sp<IStreamOut>& stream);
 
@@ -187,6 +198,9 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
             WriteCommand cmd, const char* cmdName,
             const uint8_t* data, size_t dataSize, WriterCallback callback);
     status_t prepareForWriting(size_t bufferSize);
+    void cachePresentationPosition(uint64_t frames, const struct timespec& timestamp);
+    bool getCachedPresentationPosition(uint64_t *frames, struct timespec *timestamp);
+    void invalidatePresentationPosition();
 };
 
 class StreamInHalHidl : public StreamInHalInterface, public StreamHalHidl {
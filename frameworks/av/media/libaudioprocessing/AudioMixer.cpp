@@ -29,6 +29,8 @@
 #include <math.h>
 #include <sys/types.h>
 
+#include <atomic>
+
 #include <utils/Errors.h>
 #include <utils/Log.h>
 
@@ -124,23 +126,154 @@ T min(const T& a, const T& b)
 
 // ----------------------------------------------------------------------------
 
-// Ensure mConfiguredNames bitmask is initialized properly on all architectures.
-// The value of 1 << x is undefined in C when x >= 32.
+// A fixed set of threads that share the items of one job with the thread calling run().
+// Items are claimed from a shared counter, so the caller never waits for a worker that
+// has not started an item yet; it only waits for items that are already in progress.
+class AudioMixer::WorkerGroup {
+public:
+    typedef void (*work_t)(void* arg, uint32_t item);
+
+    explicit WorkerGroup(uint32_t count);
+    ~WorkerGroup();
+
+    // Runs work(arg, item) for each item in [0, itemCount) and returns once all are done.
+    void run(work_t work, void* arg, uint32_t itemCount);
+
+private:
+    class Worker : public Thread {
+    public:
+        explicit Worker(WorkerGroup* group)
+            :   Thread(false /*canCallJava*/), mGroup(group), mGeneration(0) { }
+    private:
+        virtual bool threadLoop();
+        WorkerGroup* const mGroup;
+        uint32_t mGeneration;   // last job this worker woke up for
+    };
+
+    // claims and runs items of the current job until there are none left
+    uint32_t runItems();
+
+    Vector< sp<Worker> > mWorkers;
+
+    Mutex mLock;
+    Condition mWorkCond;        // signaled when a job is posted or on exit
+    Condition mDoneCond;        // signaled when the last active worker leaves a job
+    uint32_t mGeneration;       // incremented for each job
+    uint32_t mActive;           // workers inside runItems()
+    uint32_t mDone;             // items of the current job finished
+    bool mExit;
+
+    // current job, written under mLock once mActive is 0
+    work_t mWork;
+    void* mArg;
+    uint32_t mItemCount;
+    std::atomic<uint32_t> mNextItem;
+};
+
+AudioMixer::WorkerGroup::WorkerGroup(uint32_t count)
+    :   mGeneration(0), mActive(0), mDone(0), mExit(false),
+        mWork(NULL), mArg(NULL), mItemCount(0), mNextItem(0)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        sp<Worker> worker = new Worker(this);
+        char name[16];
+        snprintf(name, sizeof(name), "AudioMixer-w%u", i);
+        if (worker->run(name, ANDROID_PRIORITY_URGENT_AUDIO) == NO_ERROR) {
+            mWorkers.add(worker);
+        }
+    }
+}
+
+AudioMixer::WorkerGroup::~WorkerGroup()
+{
+    {
+        Mutex::Autolock _l(mLock);
+        mExit = true;
+        mWorkCond.broadcast();
+    }
+    for (size_t i = 0; i < mWorkers.size(); i++) {
+        mWorkers[i]->requestExitAndWait();
+    }
+}
+
+void AudioMixer::WorkerGroup::run(work_t work, void* arg, uint32_t itemCount)
+{
+    {
+        Mutex::Autolock _l(mLock);
+        // a worker that woke up late may still be leaving the previous job
+        while (mActive > 0) {
+            mDoneCond.wait(mLock);
+        }
+        mWork = work;
+        mArg = arg;
+        mItemCount = itemCount;
+        mDone = 0;
+        mNextItem.store(0, std::memory_order_relaxed);
+        mGeneration++;
+        mWorkCond.broadcast();
+    }
+
+    const uint32_t done = runItems();
+
+    Mutex::Autolock _l(mLock);
+    mDone += done;
+    while (mDone < mItemCount || mActive > 0) {
+        mDoneCond.wait(mLock);
+    }
+}
+
+uint32_t AudioMixer::WorkerGroup::runItems()
+{
+    uint32_t done = 0;
+    for (;;) {
+        const uint32_t item = mNextItem.fetch_add(1, std::memory_order_relaxed);
+        if (item >= mItemCount) {
+            break;
+        }
+        mWork(mArg, item);
+        done++;
+    }
+    return done;
+}
+
+bool AudioMixer::WorkerGroup::Worker::threadLoop()
+{
+    WorkerGroup* const group = mGroup;
+    {
+        Mutex::Autolock _l(group->mLock);
+        while (!group->mExit && mGeneration == group->mGeneration) {
+            group->mWorkCond.wait(group->mLock);
+        }
+        if (group->mExit) {
+            return false;
+        }
+        mGeneration = group->mGeneration;
+        group->mActive++;
+    }
+
+    const uint32_t done = group->runItems();
+
+    Mutex::Autolock _l(group->mLock);
+    group->mDone += done;
+    if (--group->mActive == 0) {
+        group->mDoneCond.broadcast();
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
 
 AudioMixer::AudioMixer(size_t frameCount, uint32_t sampleRate, uint32_t maxNumTracks)
-    :   mTrackNames(0), mConfiguredNames((maxNumTracks >= 32 ? 0 : 1 << maxNumTracks) - 1),
+    :   mFreeNames(NULL), mFreeNameCount(0),
         mSampleRate(sampleRate)
 {
-    ALOG_ASSERT(maxNumTracks <= MAX_NUM_TRACKS, "maxNumTracks %u > MAX_NUM_TRACKS %u",
-            maxNumTracks, MAX_NUM_TRACKS);
-
-    // AudioMixer is not yet capable of more than 32 active track inputs
-    ALOG_ASSERT(32 >= MAX_NUM_TRACKS, "bad MAX_NUM_TRACKS %d", MAX_NUM_TRACKS);
+    LOG_ALWAYS_FATAL_IF(maxNumTracks == 0 || maxNumTracks > MAX_NUM_TRACKS,
+            "maxNumTracks %u not in [1, MAX_NUM_TRACKS %u]", maxNumTracks, MAX_NUM_TRACKS);
 
     pthread_once(&sOnceControl, &sInitRoutine);
 
-    mState.enabledTracks= 0;
-    mState.needsChanged = 0;
+    mState.enabledCount = 0;
+    mState.changedCount = 0;
     mState.frameCount   = frameCount;
     mState.hook         = process__nop;
     mState.outputTemp   = NULL;
@@ -157,13 +290,30 @@ AudioMixer::AudioMixer(size_t frameCount, uint32_t sampleRate, uint32_t maxNumTr
         BLOCKSIZE = 16;  // google default
     }
 #endif // MTK_AUDIOMIXER_ENABLE_DRC
-    // mState.reserved
+    mState.maxNumTracks = maxNumTracks;
+    mState.tracks = new track_t[maxNumTracks];
+    mState.enabledTracks = new uint32_t[maxNumTracks];
+    mState.changedTracks = new uint32_t[maxNumTracks];
+    mState.workers = NULL;
+    mState.workTracks = new uint32_t[maxNumTracks];
+
+    // Hand out the lowest free index first, as the former bitmask allocator did.
+    mFreeNames = new uint32_t[maxNumTracks];
+    for (uint32_t i = 0; i < maxNumTracks; i++) {
+        mFreeNames[i] = maxNumTracks - 1 - i;
+    }
+    mFreeNameCount = maxNumTracks;
 
     // FIXME Most of the following initialization is probably redundant since
-    // tracks[i] should only be referenced if (mTrackNames & (1 << i)) != 0
-    // and mTrackNames is initially 0.  However, leave it here until that's verified.
+    // tracks[i] should only be referenced once allocated by getTrackName().
+    // However, leave it here until that's verified.
     track_t* t = mState.tracks;
-    for (unsigned i=0 ; i < MAX_NUM_TRACKS ; i++) {
+    for (unsigned i=0 ; i < maxNumTracks ; i++) {
+        t->changed = false;
+        t->enabled = false;
+        t->listed = false;
+        t->allocated = false;
+        t->workBuffer = NULL;
         t->resampler = NULL;
         t->downmixerBufferProvider = NULL;
         t->mReformatBufferProvider = NULL;
@@ -180,8 +330,10 @@ AudioMixer::AudioMixer(size_t frameCount, uint32_t sampleRate, uint32_t maxNumTr
 
 AudioMixer::~AudioMixer()
 {
+    delete mState.workers;
     track_t* t = mState.tracks;
-    for (unsigned i=0 ; i < MAX_NUM_TRACKS ; i++) {
+    for (unsigned i=0 ; i < mState.maxNumTracks ; i++) {
+        delete [] t->workBuffer;
         delete t->resampler;
         delete t->downmixerBufferProvider;
         delete t->mReformatBufferProvider;
@@ -195,6 +347,11 @@ AudioMixer::~AudioMixer()
 #endif // MTK_AUDIOMIXER_ENABLE_DRC
         t++;
     }
+    delete [] mState.tracks;
+    delete [] mState.enabledTracks;
+    delete [] mState.changedTracks;
+    delete [] mState.workTracks;
+    delete [] mFreeNames;
     delete [] mState.outputTemp;
     delete [] mState.resampleTemp;
 #if defined(MTK_AUDIOMIXER_ENABLE_DRC)
@@ -208,10 +365,39 @@ void AudioMixer::setNBLogWriter(NBLog::Writer *logWriter)
     mState.mNBLogWriter = logWriter;
 }
 
+void AudioMixer::setWorkerCount(uint32_t count)
+{
+#if defined(MTK_AUDIOMIXER_ENABLE_DRC)
+    // DRC processing shares per-mixer scratch buffers between tracks
+    ALOGW_IF(count > 0, "setWorkerCount(%u) ignored, DRC is enabled", count);
+#else
+    ALOG_ASSERT(mFreeNameCount == mState.maxNumTracks, "setWorkerCount() with tracks allocated");
+    delete mState.workers;
+    mState.workers = count > 0 ? new WorkerGroup(count) : NULL;
+#endif // MTK_AUDIOMIXER_ENABLE_DRC
+}
+
 static inline audio_format_t selectMixerInFormat(audio_format_t inputFormat __unused) {
     return kUseFloat && kUseNewMixer ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
 }
 
+/* static */
+void AudioMixer::prebuildResamplerFilters(uint32_t sampleRate)
+{
+    static const int32_t kTrackSampleRates[] = {
+        8000, 11025, 12000, 16000, 22050, 24000, 32000, 44100, 48000, 88200, 96000,
+    };
+    // the resampler format and quality chosen by track_t::setResampler()
+    const audio_format_t format = selectMixerInFormat(AUDIO_FORMAT_PCM_16_BIT);
+    for (size_t i = 0; i < sizeof(kTrackSampleRates) / sizeof(kTrackSampleRates[0]); i++) {
+        const int32_t trackSampleRate = kTrackSampleRates[i];
+        AudioResampler::prebuildFilters(format, sampleRate,
+                isMusicRate(trackSampleRate) ? AudioResampler::DEFAULT_QUALITY
+                                             : AudioResampler::DYN_LOW_QUALITY,
+                &trackSampleRate, 1);
+    }
+}
+
 int AudioMixer::getTrackName(audio_channel_mask_t channelMask,
         audio_format_t format, int sessionId)
 {
@@ -219,9 +405,9 @@ int AudioMixer::getTrackName(audio_channel_mask_t channelMask,
         ALOGE("AudioMixer::getTrackName invalid format (%#x)", format);
         return -1;
     }
-    uint32_t names = (~mTrackNames) & mConfiguredNames;
-    if (names != 0) {
-        int n = __builtin_ctz(names);
+    if (mFreeNameCount != 0) {
+        // only pop the name once the track is fully set up, see below
+        const int n = mFreeNames[mFreeNameCount - 1];
         ALOGV("add track (%d)", n);
         // assume default parameters for the track, except where noted below
         track_t* t = &mState.tracks[n];
@@ -301,20 +487,24 @@ int AudioMixer::getTrackName(audio_channel_mask_t channelMask,
         // prepareForDownmix() may change mDownmixRequiresFormat
         ALOGVV("mMixerFormat:%#x  mMixerInFormat:%#x\n", t->mMixerFormat, t->mMixerInFormat);
         t->prepareForReformat();
-        mTrackNames |= 1 << n;
+        t->allocated = true;
+        mFreeNameCount--;
         return TRACK0 + n;
     }
     ALOGE("AudioMixer::getTrackName out of available tracks");
     return -1;
 }
 
-void AudioMixer::invalidateState(uint32_t mask)
+void AudioMixer::invalidateState(int name)
 {
-    if (mask != 0) {
-        mState.needsChanged |= mask;
-        mState.hook = process__validate;
+    track_t& t = mState.tracks[name];
+    if (!t.changed) {
+        // each track is queued at most once, so changedTracks cannot overflow
+        t.changed = true;
+        mState.changedTracks[mState.changedCount++] = name;
     }
- }
+    mState.hook = process__validate;
+}
 
 // Called when channel masks have changed for a track name
 // TODO: Fix DownmixerBufferProvider not to (possibly) change mixer input format,
@@ -501,12 +691,16 @@ void AudioMixer::deleteTrackName(int name)
 {
     ALOGV("AudioMixer::deleteTrackName(%d)", name);
     name -= TRACK0;
-    LOG_ALWAYS_FATAL_IF(name < 0 || name >= (int)MAX_NUM_TRACKS, "bad track name %d", name);
+    LOG_ALWAYS_FATAL_IF(name < 0 || name >= (int)mState.maxNumTracks, "bad track name %d", name);
     ALOGV("deleteTrackName(%d)", name);
     track_t& track(mState.tracks[ name ]);
+    if (!track.allocated) {
+        ALOGW("deleteTrackName(%d) of a track that is not allocated", name);
+        return;
+    }
     if (track.enabled) {
         track.enabled = false;
-        invalidateState(1<<name);
+        invalidateState(name);
     }
     // delete the resampler
     delete track.resampler;
@@ -518,6 +712,8 @@ void AudioMixer::deleteTrackName(int name)
     // delete the timestretch provider
     delete track.mTimestretchBufferProvider;
     track.mTimestretchBufferProvider = NULL;
+    delete [] track.workBuffer;
+    track.workBuffer = NULL;
 
 #if defined(MTK_AUDIOMIXER_ENABLE_DRC)
     track.mDRCEnable = false;
@@ -528,32 +724,34 @@ void AudioMixer::deleteTrackName(int name)
     }
 #endif // MTK_AUDIOMIXER_ENABLE_DRC
 
-    mTrackNames &= ~(1<<name);
+    // the track may still be queued for validation, which is harmless once it is disabled
+    track.allocated = false;
+    mFreeNames[mFreeNameCount++] = name;
 }
 
 void AudioMixer::enable(int name)
 {
     name -= TRACK0;
-    ALOG_ASSERT(uint32_t(name) < MAX_NUM_TRACKS, "bad track name %d", name);
+    ALOG_ASSERT(uint32_t(name) < mState.maxNumTracks, "bad track name %d", name);
     track_t& track = mState.tracks[name];
 
     if (!track.enabled) {
         track.enabled = true;
         ALOGV("enable(%d)", name);
-        invalidateState(1 << name);
+        invalidateState(name);
     }
 }
 
 void AudioMixer::disable(int name)
 {
     name -= TRACK0;
-    ALOG_ASSERT(uint32_t(name) < MAX_NUM_TRACKS, "bad track name %d", name);
+    ALOG_ASSERT(uint32_t(name) < mState.maxNumTracks, "bad track name %d", name);
     track_t& track = mState.tracks[name];
 
     if (track.enabled) {
         track.enabled = false;
         ALOGV("disable(%d)", name);
-        invalidateState(1 << name);
+        invalidateState(name);
     }
 }
 
@@ -685,7 +883,7 @@ static inline bool setVolumeRampVariables(float newVolume, int32_t ramp,
 void AudioMixer::setParameter(int name, int target, int param, void *value)
 {
     name -= TRACK0;
-    ALOG_ASSERT(uint32_t(name) < MAX_NUM_TRACKS, "bad track name %d", name);
+    ALOG_ASSERT(uint32_t(name) < mState.maxNumTracks, "bad track name %d", name);
     track_t& track = mState.tracks[name];
 
     int valueInt = static_cast<int>(reinterpret_cast<uintptr_t>(value));
@@ -700,21 +898,21 @@ void AudioMixer::setParameter(int name, int target, int param, void *value)
                 static_cast<audio_channel_mask_t>(valueInt);
             if (setChannelMasks(name, trackChannelMask, track.mMixerChannelMask)) {
                 ALOGV("setParameter(TRACK, CHANNEL_MASK, %x)", trackChannelMask);
-                invalidateState(1 << name);
+                invalidateState(name);
             }
             } break;
         case MAIN_BUFFER:
             if (track.mainBuffer != valueBuf) {
                 track.mainBuffer = valueBuf;
                 ALOGV("setParameter(TRACK, MAIN_BUFFER, %p)", valueBuf);
-                invalidateState(1 << name);
+                invalidateState(name);
             }
             break;
         case AUX_BUFFER:
             if (track.auxBuffer != valueBuf) {
                 track.auxBuffer = valueBuf;
                 ALOGV("setParameter(TRACK, AUX_BUFFER, %p)", valueBuf);
-                invalidateState(1 << name);
+                invalidateState(name);
             }
             break;
         case FORMAT: {
@@ -724,7 +922,7 @@ void AudioMixer::setParameter(int name, int target, int param, void *value)
                 track.mFormat = format;
                 ALOGV("setParameter(TRACK, FORMAT, %#x)", format);
                 track.prepareForReformat();
-                invalidateState(1 << name);
+                invalidateState(name);
             }
             } break;
         // FIXME do we want to support setting the downmix type from AudioFlinger?
@@ -743,7 +941,7 @@ void AudioMixer::setParameter(int name, int target, int param, void *value)
                     static_cast<audio_channel_mask_t>(valueInt);
             if (setChannelMasks(name, track.channelMask, mixerChannelMask)) {
                 ALOGV("setParameter(TRACK, MIXER_CHANNEL_MASK, %#x)", mixerChannelMask);
-                invalidateState(1 << name);
+                invalidateState(name);
             }
             } break;
 #if defined(MTK_AUDIOMIXER_ENABLE_DRC)
@@ -763,18 +961,18 @@ void AudioMixer::setParameter(int name, int target, int param, void *value)
             if (track.setResampler(uint32_t(valueInt), mSampleRate)) {
                 ALOGV("setParameter(RESAMPLE, SAMPLE_RATE, %u)",
                         uint32_t(valueInt));
-                invalidateState(1 << name);
+                invalidateState(name);
             }
             break;
         case RESET:
             track.resetResampler();
-            invalidateState(1 << name);
+            invalidateState(name);
             break;
         case REMOVE:
             delete track.resampler;
             track.resampler = NULL;
             track.sampleRate = mSampleRate;
-            invalidateState(1 << name);
+            invalidateState(name);
             break;
         default:
             LOG_ALWAYS_FATAL("setParameter resample: bad param %d", param);
@@ -791,7 +989,7 @@ void AudioMixer::setParameter(int name, int target, int param, void *value)
                     &track.mAuxLevel, &track.mPrevAuxLevel, &track.mAuxInc)) {
                 ALOGV("setParameter(%s, AUXLEVEL: %04x)",
                         target == VOLUME ? "VOLUME" : "RAMP_VOLUME", track.auxLevel);
-                invalidateState(1 << name);
+                invalidateState(name);
             }
             break;
         default:
@@ -805,7 +1003,7 @@ void AudioMixer::setParameter(int name, int target, int param, void *value)
                     ALOGV("setParameter(%s, VOLUME%d: %04x)",
                             target == VOLUME ? "VOLUME" : "RAMP_VOLUME", param - VOLUME0,
                                     track.volume[param - VOLUME0]);
-                    invalidateState(1 << name);
+                    invalidateState(name);
                 }
             } else {
                 LOG_ALWAYS_FATAL("setParameter volume: bad param %d", param);
@@ -827,7 +1025,7 @@ void AudioMixer::setParameter(int name, int target, int param, void *value)
                             playbackRate->mPitch,
                             playbackRate->mStretchMode,
                             playbackRate->mFallbackMode);
-                    // invalidateState(1 << name);
+                    // invalidateState(name);
                 }
             } break;
             default:
@@ -979,7 +1177,7 @@ inline void AudioMixer::track_t::adjustVolumeRamp(bool aux, bool useFloat)
 size_t AudioMixer::getUnreleasedFrames(int name) const
 {
     name -= TRACK0;
-    if (uint32_t(name) < MAX_NUM_TRACKS) {
+    if (uint32_t(name) < mState.maxNumTracks) {
         return mState.tracks[name].getUnreleasedFrames();
     }
     return 0;
@@ -988,7 +1186,7 @@ size_t AudioMixer::getUnreleasedFrames(int name) const
 void AudioMixer::setBufferProvider(int name, AudioBufferProvider* bufferProvider)
 {
     name -= TRACK0;
-    ALOG_ASSERT(uint32_t(name) < MAX_NUM_TRACKS, "bad track name %d", name);
+    ALOG_ASSERT(uint32_t(name) < mState.maxNumTracks, "bad track name %d", name);
 
     if (mState.tracks[name].mInputBufferProvider == bufferProvider) {
         return; // don't reset any buffer providers if identical.
@@ -1016,39 +1214,46 @@ void AudioMixer::process()
 
 void AudioMixer::process__validate(state_t* state)
 {
-    ALOGW_IF(!state->needsChanged,
+    ALOGW_IF(!state->changedCount,
         "in process__validate() but nothing's invalid");
 
-    uint32_t changed = state->needsChanged;
-    state->needsChanged = 0; // clear the validation flag
-
-    // recompute which tracks are enabled / disabled
-    uint32_t enabled = 0;
-    uint32_t disabled = 0;
-    while (changed) {
-        const int i = 31 - __builtin_clz(changed);
-        const uint32_t mask = 1<<i;
-        changed &= ~mask;
+    // recompute which tracks are enabled / disabled, touching only the changed tracks;
+    // newly enabled tracks are collected at the front of changedTracks
+    uint32_t added = 0;
+    for (uint32_t k = 0; k < state->changedCount; k++) {
+        const uint32_t i = state->changedTracks[k];
         track_t& t = state->tracks[i];
-        (t.enabled ? enabled : disabled) |= mask;
+        t.changed = false;
+        if (t.enabled && !t.listed) {
+            state->changedTracks[added++] = i;
+        }
+        t.listed = t.enabled;
+    }
+    state->changedCount = 0; // clear the validation flag
+
+    uint32_t count = 0;
+    for (uint32_t k = 0; k < state->enabledCount; k++) {
+        const uint32_t i = state->enabledTracks[k];
+        if (state->tracks[i].listed) {
+            state->enabledTracks[count++] = i;
+        }
     }
-    state->enabledTracks &= ~disabled;
-    state->enabledTracks |=  enabled;
+    for (uint32_t k = 0; k < added; k++) {
+        state->enabledTracks[count++] = state->changedTracks[k];
+    }
+    state->enabledCount = count;
+    groupEnabledTracks(state);
 
     // compute everything we need...
-    int countActiveTracks = 0;
+    const int countActiveTracks = state->enabledCount;
     // TODO: fix all16BitsStereNoResample logic to
     // either properly handle muted tracks (it should ignore them)
     // or remove altogether as an obsolete optimization.
     bool all16BitsStereoNoResample = true;
     bool resampling = false;
     bool volumeRamp = false;
-    uint32_t en = state->enabledTracks;
-    while (en) {
-        const int i = 31 - __builtin_clz(en);
-        en &= ~(1<<i);
-
-        countActiveTracks++;
+    for (uint32_t k = 0; k < state->enabledCount; k++) {
+        const int i = state->enabledTracks[k];
         track_t& t = state->tracks[i];
         uint32_t n = 0;
         // FIXME can overflow (mask is only 3 bits)
@@ -1114,6 +1319,14 @@ void AudioMixer::process__validate(state_t* state)
             if (!state->resampleTemp) {
                 state->resampleTemp = new int32_t[MAX_NUM_CHANNELS * state->frameCount];
             }
+            if (state->workers != NULL) {
+                for (uint32_t k = 0; k < state->enabledCount; k++) {
+                    track_t& t = state->tracks[state->enabledTracks[k]];
+                    if (t.workBuffer == NULL && (t.needs & NEEDS_AUX) == 0) {
+                        t.workBuffer = new int32_t[2 * MAX_NUM_CHANNELS * state->frameCount];
+                    }
+                }
+            }
             state->hook = process__genericResampling;
         } else {
 #if !defined(MTK_AUDIOMIXER_ENABLE_DRC)
@@ -1129,8 +1342,7 @@ void AudioMixer::process__validate(state_t* state)
             state->hook = process__genericNoResampling;
             if (all16BitsStereoNoResample && !volumeRamp) {
                 if (countActiveTracks == 1) {
-                    const int i = 31 - __builtin_clz(state->enabledTracks);
-                    track_t& t = state->tracks[i];
+                    track_t& t = state->tracks[state->enabledTracks[0]];
                     if ((t.needs & NEEDS_MUTE) == 0) {
                         // The check prevents a muted track from acquiring a process hook.
                         //
@@ -1146,9 +1358,9 @@ void AudioMixer::process__validate(state_t* state)
         }
     }
 
-    ALOGV("mixer configuration change: %d activeTracks (%08x) "
+    ALOGV("mixer configuration change: %d activeTracks "
         "all16BitsStereoNoResample=%d, resampling=%d, volumeRamp=%d",
-        countActiveTracks, state->enabledTracks,
+        countActiveTracks,
         all16BitsStereoNoResample, resampling, volumeRamp);
 
    state->hook(state);
@@ -1157,11 +1369,8 @@ void AudioMixer::process__validate(state_t* state)
     // track hooks for subsequent mixer process
     if (countActiveTracks > 0) {
         bool allMuted = true;
-        uint32_t en = state->enabledTracks;
-        while (en) {
-            const int i = 31 - __builtin_clz(en);
-            en &= ~(1<<i);
-            track_t& t = state->tracks[i];
+        for (uint32_t k = 0; k < state->enabledCount; k++) {
+            track_t& t = state->tracks[state->enabledTracks[k]];
             if (!t.doesResample() && t.volumeRL == 0) {
                 t.needs |= NEEDS_MUTE;
                 t.hook = track__nop;
@@ -1176,8 +1385,7 @@ void AudioMixer::process__validate(state_t* state)
         // Use MTK_AUDIOMIXER_ENABLE_DRC will not enter here
         else if (all16BitsStereoNoResample) {
             if (countActiveTracks == 1) {
-                const int i = 31 - __builtin_clz(state->enabledTracks);
-                track_t& t = state->tracks[i];
+                track_t& t = state->tracks[state->enabledTracks[0]];
                 // Muted single tracks handled by allMuted above.
                 state->hook = getProcessHook(PROCESSTYPE_NORESAMPLEONETRACK,
                         t.mMixerChannelCount, t.mMixerInFormat, t.mMixerFormat);
@@ -1187,6 +1395,36 @@ void AudioMixer::process__validate(state_t* state)
     }
 }
 
+// Orders enabledTracks the way the former bitmask walk visited them: tracks sharing a
+// mainBuffer are contiguous, groups are ordered by their highest index, and each group
+// is in decreasing index order.  Only called on configuration change.
+void AudioMixer::groupEnabledTracks(state_t* state)
+{
+    uint32_t* const enabled = state->enabledTracks;
+    const uint32_t count = state->enabledCount;
+
+    // insertion sort, decreasing index
+    for (uint32_t k = 1; k < count; k++) {
+        const uint32_t i = enabled[k];
+        uint32_t j = k;
+        for (; j > 0 && enabled[j - 1] < i; j--) {
+            enabled[j] = enabled[j - 1];
+        }
+        enabled[j] = i;
+    }
+
+    // stable partition by mainBuffer
+    for (uint32_t k = 0; k < count; k++) {
+        const int32_t* const mainBuffer = state->tracks[enabled[k]].mainBuffer;
+        for (uint32_t j = k + 1; j < count; j++) {
+            if (state->tracks[enabled[j]].mainBuffer == mainBuffer) {
+                const uint32_t i = enabled[j];
+                memmove(&enabled[k + 2], &enabled[k + 1], (j - k - 1) * sizeof(*enabled));
+                enabled[++k] = i;
+            }
+        }
+    }
+}
 
 void AudioMixer::track__genericResample(track_t* t, int32_t* out, size_t outFrameCount,
         int32_t* temp, int32_t* aux)
@@ -1483,44 +1721,26 @@ void AudioMixer::track__16BitsMono(track_t* t, int32_t* out, size_t frameCount,
 void AudioMixer::process__nop(state_t* state)
 {
     ALOGVV("process__nop\n");
-    uint32_t e0 = state->enabledTracks;
-    while (e0) {
+    const uint32_t* const enabled = state->enabledTracks;
+    const uint32_t count = state->enabledCount;
+    for (uint32_t k = 0; k < count; ) {
         // process by group of tracks with same output buffer to
-        // avoid multiple memset() on same buffer
-        uint32_t e1 = e0, e2 = e0;
-        int i = 31 - __builtin_clz(e1);
-        {
-            track_t& t1 = state->tracks[i];
-            e2 &= ~(1<<i);
-            while (e2) {
-                i = 31 - __builtin_clz(e2);
-                e2 &= ~(1<<i);
-                track_t& t2 = state->tracks[i];
-                if (CC_UNLIKELY(t2.mainBuffer != t1.mainBuffer)) {
-                    e1 &= ~(1<<i);
-                }
-            }
-            e0 &= ~(e1);
-
-            memset(t1.mainBuffer, 0, state->frameCount * t1.mMixerChannelCount
-                    * audio_bytes_per_sample(t1.mMixerFormat));
-        }
+        // avoid multiple memset() on same buffer; groups are contiguous in enabledTracks
+        const track_t& t1 = state->tracks[enabled[k]];
+        memset(t1.mainBuffer, 0, state->frameCount * t1.mMixerChannelCount
+                * audio_bytes_per_sample(t1.mMixerFormat));
 
-        while (e1) {
-            i = 31 - __builtin_clz(e1);
-            e1 &= ~(1<<i);
-            {
-                track_t& t3 = state->tracks[i];
-                size_t outFrames = state->frameCount;
-                while (outFrames) {
-                    t3.buffer.frameCount = outFrames;
-                    t3.bufferProvider->getNextBuffer(&t3.buffer);
-                    if (t3.buffer.raw == NULL) break;
-                    outFrames -= t3.buffer.frameCount;
-                    t3.bufferProvider->releaseBuffer(&t3.buffer);
-                }
+        do {
+            track_t& t3 = state->tracks[enabled[k]];
+            size_t outFrames = state->frameCount;
+            while (outFrames) {
+                t3.buffer.frameCount = outFrames;
+                t3.bufferProvider->getNextBuffer(&t3.buffer);
+                if (t3.buffer.raw == NULL) break;
+                outFrames -= t3.buffer.frameCount;
+                t3.bufferProvider->releaseBuffer(&t3.buffer);
             }
-        }
+        } while (++k < count && state->tracks[enabled[k]].mainBuffer == t1.mainBuffer);
     }
 }
 
@@ -1530,46 +1750,33 @@ void AudioMixer::process__genericNoResampling(state_t* state)
     ALOGVV("process__genericNoResampling\n");
     int32_t outTemp[BLOCKSIZE * MAX_NUM_CHANNELS] __attribute__((aligned(32)));
 
+    const uint32_t* const enabled = state->enabledTracks;
+    const uint32_t count = state->enabledCount;
+
     // acquire each track's buffer
-    uint32_t enabledTracks = state->enabledTracks;
-    uint32_t e0 = enabledTracks;
-    while (e0) {
-        const int i = 31 - __builtin_clz(e0);
-        e0 &= ~(1<<i);
-        track_t& t = state->tracks[i];
+    for (uint32_t k = 0; k < count; k++) {
+        track_t& t = state->tracks[enabled[k]];
         t.buffer.frameCount = state->frameCount;
         t.bufferProvider->getNextBuffer(&t.buffer);
         t.frameCount = t.buffer.frameCount;
         t.in = t.buffer.raw;
     }
 
-    e0 = enabledTracks;
-    while (e0) {
+    for (uint32_t first = 0; first < count; ) {
         // process by group of tracks with same output buffer to
-        // optimize cache use
-        uint32_t e1 = e0, e2 = e0;
-        int j = 31 - __builtin_clz(e1);
-        track_t& t1 = state->tracks[j];
-        e2 &= ~(1<<j);
-        while (e2) {
-            j = 31 - __builtin_clz(e2);
-            e2 &= ~(1<<j);
-            track_t& t2 = state->tracks[j];
-            if (CC_UNLIKELY(t2.mainBuffer != t1.mainBuffer)) {
-                e1 &= ~(1<<j);
-            }
+        // optimize cache use; groups are contiguous in enabledTracks
+        track_t& t1 = state->tracks[enabled[first]];
+        uint32_t last = first + 1;
+        while (last < count && state->tracks[enabled[last]].mainBuffer == t1.mainBuffer) {
+            last++;
         }
-        e0 &= ~(e1);
         // this assumes output 16 bits stereo, no resampling
         int32_t *out = t1.mainBuffer;
         size_t numFrames = 0;
         do {
             memset(outTemp, 0, sizeof(outTemp));
-            e2 = e1;
-            while (e2) {
-                const int i = 31 - __builtin_clz(e2);
-                e2 &= ~(1<<i);
-                track_t& t = state->tracks[i];
+            for (uint32_t k = first; k < last; k++) {
+                track_t& t = state->tracks[enabled[k]];
                 size_t outFrames = BLOCKSIZE;
                 int32_t *aux = NULL;
                 if (CC_UNLIKELY(t.needs & NEEDS_AUX)) {
@@ -1577,10 +1784,9 @@ void AudioMixer::process__genericNoResampling(state_t* state)
                 }
                 while (outFrames) {
                     // t.in == NULL can happen if the track was flushed just after having
-                    // been enabled for mixing.
-                   if (t.in == NULL) {
-                        enabledTracks &= ~(1<<i);
-                        e1 &= ~(1<<i);
+                    // been enabled for mixing.  Such a track stays NULL, so it is skipped
+                    // for the remaining blocks and its buffer is not released below.
+                    if (t.in == NULL) {
                         break;
                     }
                     size_t inFrames = (t.frameCount > outFrames)?outFrames:t.frameCount;
@@ -1600,8 +1806,6 @@ void AudioMixer::process__genericNoResampling(state_t* state)
                         t.bufferProvider->getNextBuffer(&t.buffer);
                         t.in = t.buffer.raw;
                         if (t.in == NULL) {
-                            enabledTracks &= ~(1<<i);
-                            e1 &= ~(1<<i);
                             break;
                         }
                         t.frameCount = t.buffer.frameCount;
@@ -1626,15 +1830,15 @@ void AudioMixer::process__genericNoResampling(state_t* state)
                         * audio_bytes_per_sample(t1.mMixerFormat));
             numFrames += BLOCKSIZE;
         } while (numFrames < state->frameCount);
+        first = last;
     }
 
     // release each track's buffer
-    e0 = enabledTracks;
-    while (e0) {
-        const int i = 31 - __builtin_clz(e0);
-        e0 &= ~(1<<i);
-        track_t& t = state->tracks[i];
-        t.bufferProvider->releaseBuffer(&t.buffer);
+    for (uint32_t k = 0; k < count; k++) {
+        track_t& t = state->tracks[enabled[k]];
+        if (t.in != NULL) {
+            t.bufferProvider->releaseBuffer(&t.buffer);
+        }
     }
 }
 
@@ -1647,77 +1851,49 @@ void AudioMixer::process__genericResampling(state_t* state)
     int32_t* const outTemp = state->outputTemp;
     size_t numFrames = state->frameCount;
 
-    uint32_t e0 = state->enabledTracks;
-    while (e0) {
+    const uint32_t* const enabled = state->enabledTracks;
+    const uint32_t count = state->enabledCount;
+    for (uint32_t k = 0; k < count; ) {
         // process by group of tracks with same output buffer
-        // to optimize cache use
-        uint32_t e1 = e0, e2 = e0;
-        int j = 31 - __builtin_clz(e1);
-        track_t& t1 = state->tracks[j];
-        e2 &= ~(1<<j);
-        while (e2) {
-            j = 31 - __builtin_clz(e2);
-            e2 &= ~(1<<j);
-            track_t& t2 = state->tracks[j];
-            if (CC_UNLIKELY(t2.mainBuffer != t1.mainBuffer)) {
-                e1 &= ~(1<<j);
-            }
-        }
-        e0 &= ~(e1);
+        // to optimize cache use; groups are contiguous in enabledTracks
+        track_t& t1 = state->tracks[enabled[k]];
         int32_t *out = t1.mainBuffer;
         memset(outTemp, 0, sizeof(*outTemp) * t1.mMixerChannelCount * state->frameCount);
-        while (e1) {
-            const int i = 31 - __builtin_clz(e1);
-            e1 &= ~(1<<i);
-            track_t& t = state->tracks[i];
-            int32_t *aux = NULL;
-            if (CC_UNLIKELY(t.needs & NEEDS_AUX)) {
-                aux = t.auxBuffer;
+        uint32_t first = k;
+        uint32_t workCount = 0;
+        do {
+            const track_t& t = state->tracks[enabled[k]];
+            // tracks with an aux send accumulate into a shared effect buffer, keep them serial
+            if (t.workBuffer != NULL && (t.needs & NEEDS_AUX) == 0) {
+                state->workTracks[workCount++] = enabled[k];
             }
+        } while (++k < count && state->tracks[enabled[k]].mainBuffer == t1.mainBuffer);
 
-            // this is a little goofy, on the resampling case we don't
-            // acquire/release the buffers because it's done by
-            // the resampler.
-            if (t.needs & NEEDS_RESAMPLE) {
-                t.hook(&t, outTemp, numFrames, state->resampleTemp, aux);
-            } else {
-
-                size_t outFrames = 0;
-
-#if defined(MTK_AUDIOMIXER_ENABLE_DRC)
-                int8_t *tempBuffer = reinterpret_cast<int8_t*>(state->nonResampleTemp);
-                int channelCount = ((1 == t.channelCount) && (2 == t.mMixerChannelCount)) ? 1 : t.mMixerChannelCount;
+        if (workCount < 2) {
+            workCount = 0;
+        } else {
+            state->workers->run(processTrackWork, state, workCount);
+        }
 
-                ALOGVV("channelCount %d,  t.channelCount %d ", channelCount, t.channelCount);
-                int32_t channelSize = channelCount * audio_bytes_per_sample(t.mMixerInFormat);
-                memset(tempBuffer, 0, numFrames * channelSize);
-#endif // MTK_AUDIOMIXER_ENABLE_DRC
-                while (outFrames < numFrames) {
-                    t.buffer.frameCount = numFrames - outFrames;
-                    t.bufferProvider->getNextBuffer(&t.buffer);
-                    t.in = t.buffer.raw;
-                    // t.in == NULL can happen if the track was flushed just after having
-                    // been enabled for mixing.
-                    if (t.in == NULL) break;
-#if defined(MTK_AUDIOMIXER_ENABLE_DRC)
-                    int32_t sampleSize = t.buffer.frameCount * channelSize;
-                    memcpy(tempBuffer+ outFrames * channelSize, t.in, sampleSize);
-#else
-                    if (CC_UNLIKELY(aux != NULL)) {
-                        aux += outFrames;
+        // accumulate in the serial order, so the mix does not depend on the worker count
+        for (uint32_t w = 0; first < k; first++) {
+            track_t& t = state->tracks[enabled[first]];
+            if (w < workCount && state->workTracks[w] == enabled[first]) {
+                w++;
+                const size_t sampleCount = numFrames * t.mMixerChannelCount;
+                if (t.mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                    float* const dst = reinterpret_cast<float*>(outTemp);
+                    const float* const src = reinterpret_cast<const float*>(t.workBuffer);
+                    for (size_t i = 0; i < sampleCount; i++) {
+                        dst[i] += src[i];
+                    }
+                } else {
+                    for (size_t i = 0; i < sampleCount; i++) {
+                        outTemp[i] += t.workBuffer[i];
                     }
-                    t.hook(&t, outTemp + outFrames * t.mMixerChannelCount, t.buffer.frameCount,
-                            state->resampleTemp, aux);
-#endif // MTK_AUDIOMIXER_ENABLE_DRC
-                    outFrames += t.buffer.frameCount;
-                    t.bufferProvider->releaseBuffer(&t.buffer);
-                }
-#if defined(MTK_AUDIOMIXER_ENABLE_DRC)
-                t.hook(&t, outTemp, numFrames, state->nonResampleTemp, aux);
-                if (CC_UNLIKELY(aux != NULL)) {
-                    aux += numFrames;
                 }
-#endif // MTK_AUDIOMIXER_ENABLE_DRC
+            } else {
+                processTrack(state, t, outTemp, state->resampleTemp);
             }
         }
         convertMixerFormat(out, t1.mMixerFormat,
@@ -1733,17 +1909,80 @@ void AudioMixer::process__genericResampling(state_t* state)
     }
 }
 
+// Mixes one track of a process__genericResampling() group into out, using temp as scratch.
+void AudioMixer::processTrack(state_t* state, track_t& t, int32_t* out, int32_t* temp)
+{
+    const size_t numFrames = state->frameCount;
+    int32_t *aux = NULL;
+    if (CC_UNLIKELY(t.needs & NEEDS_AUX)) {
+        aux = t.auxBuffer;
+    }
+
+    // this is a little goofy, on the resampling case we don't
+    // acquire/release the buffers because it's done by
+    // the resampler.
+    if (t.needs & NEEDS_RESAMPLE) {
+        t.hook(&t, out, numFrames, temp, aux);
+    } else {
+
+        size_t outFrames = 0;
+
+#if defined(MTK_AUDIOMIXER_ENABLE_DRC)
+        int8_t *tempBuffer = reinterpret_cast<int8_t*>(state->nonResampleTemp);
+        int channelCount = ((1 == t.channelCount) && (2 == t.mMixerChannelCount)) ? 1 : t.mMixerChannelCount;
+
+        ALOGVV("channelCount %d,  t.channelCount %d ", channelCount, t.channelCount);
+        int32_t channelSize = channelCount * audio_bytes_per_sample(t.mMixerInFormat);
+        memset(tempBuffer, 0, numFrames * channelSize);
+#endif // MTK_AUDIOMIXER_ENABLE_DRC
+        while (outFrames < numFrames) {
+            t.buffer.frameCount = numFrames - outFrames;
+            t.bufferProvider->getNextBuffer(&t.buffer);
+            t.in = t.buffer.raw;
+            // t.in == NULL can happen if the track was flushed just after having
+            // been enabled for mixing.
+            if (t.in == NULL) break;
+#if defined(MTK_AUDIOMIXER_ENABLE_DRC)
+            int32_t sampleSize = t.buffer.frameCount * channelSize;
+            memcpy(tempBuffer+ outFrames * channelSize, t.in, sampleSize);
+#else
+            if (CC_UNLIKELY(aux != NULL)) {
+                aux += outFrames;
+            }
+            t.hook(&t, out + outFrames * t.mMixerChannelCount, t.buffer.frameCount,
+                    temp, aux);
+#endif // MTK_AUDIOMIXER_ENABLE_DRC
+            outFrames += t.buffer.frameCount;
+            t.bufferProvider->releaseBuffer(&t.buffer);
+        }
+#if defined(MTK_AUDIOMIXER_ENABLE_DRC)
+        t.hook(&t, out, numFrames, state->nonResampleTemp, aux);
+        if (CC_UNLIKELY(aux != NULL)) {
+            aux += numFrames;
+        }
+#endif // MTK_AUDIOMIXER_ENABLE_DRC
+    }
+}
+
+// Worker entry: pre-processes one track into its own workBuffer, see setWorkerCount().
+void AudioMixer::processTrackWork(void* arg, uint32_t item)
+{
+    state_t* const state = static_cast<state_t*>(arg);
+    track_t& t = state->tracks[state->workTracks[item]];
+    int32_t* const out = t.workBuffer;
+    memset(out, 0, sizeof(*out) * t.mMixerChannelCount * state->frameCount);
+    processTrack(state, t, out, out + MAX_NUM_CHANNELS * state->frameCount);
+}
+
 // one track, 16 bits stereo without resampling is the most common case
 void AudioMixer::process__OneTrack16BitsStereoNoResampling(state_t* state)
 {
     ALOGVV("process__OneTrack16BitsStereoNoResampling\n");
     // This method is only called when state->enabledTracks has exactly
-    // one bit set.  The asserts below would verify this, but are commented out
+    // one entry.  The assert below would verify this, but is commented out
     // since the whole point of this method is to optimize performance.
-    //ALOG_ASSERT(0 != state->enabledTracks, "no tracks enabled");
-    const int i = 31 - __builtin_clz(state->enabledTracks);
-    //ALOG_ASSERT((1 << i) == state->enabledTracks, "more than 1 track enabled");
-    const track_t& t = state->tracks[i];
+    //ALOG_ASSERT(state->enabledCount == 1, "more than 1 track enabled");
+    const track_t& t = state->tracks[state->enabledTracks[0]];
 
     AudioBufferProvider::Buffer& b(t.buffer);
 
@@ -1970,10 +2209,8 @@ template <int MIXTYPE, typename TO, typename TI, typename TA>
 void AudioMixer::process_NoResampleOneTrack(state_t* state)
 {
     ALOGVV("process_NoResampleOneTrack\n");
-    // CLZ is faster than CTZ on ARM, though really not sure if true after 31 - clz.
-    const int i = 31 - __builtin_clz(state->enabledTracks);
-    ALOG_ASSERT((1 << i) == state->enabledTracks, "more than 1 track enabled");
-    track_t *t = &state->tracks[i];
+    ALOG_ASSERT(state->enabledCount == 1, "more than 1 track enabled");
+    track_t *t = &state->tracks[state->enabledTracks[0]];
     const uint32_t channels = t->mMixerChannelCount;
     TO* out = reinterpret_cast<TO*>(t->mainBuffer);
     TA* aux = reinterpret_cast<TA*>(t->auxBuffer);
@@ -2351,6 +2588,7 @@ bool AudioMixer::track_t::doPostProcessing(void *buffer, audio_format_t format,
 void AudioMixer::releaseDRC(int name)
 {
     name -= TRACK0;
+    ALOG_ASSERT(uint32_t(name) < mState.maxNumTracks, "bad track name %d", name);
     track_t& track(mState.tracks[name]);
 
     if (track.mpDRCObj) {
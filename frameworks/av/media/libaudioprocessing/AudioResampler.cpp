@@ -261,6 +261,36 @@ AudioResampler* AudioResampler::create(audio_format_t format, int inChannelCount
     return resampler;
 }
 
+/*static*/
+void AudioResampler::prebuildFilters(audio_format_t format, int32_t sampleRate,
+        src_quality quality, const int32_t* inSampleRates, size_t count) {
+    // resolve DEFAULT_QUALITY as create() does, but without throttling
+    if (quality == DEFAULT_QUALITY) {
+        int ok = pthread_once(&once_control, init_routine);
+        if (ok != 0) {
+            ALOGE("%s pthread_once failed: %d", __func__, ok);
+        }
+        quality = defaultQuality;
+        if (quality == DEFAULT_QUALITY) {
+            quality = DYN_MED_QUALITY;
+        }
+    }
+    if (quality < DYN_LOW_QUALITY || quality > DYN_HIGH_QUALITY) {
+        return;
+    }
+
+    // A temporary resampler designs the filter exactly as a track's would; the shared
+    // filter stays cached after the resampler is deleted.
+    for (size_t i = 0; i < count; i++) {
+        if (inSampleRates[i] <= 0 || inSampleRates[i] == sampleRate) {
+            continue;
+        }
+        AudioResampler* resampler = create(format, 1 /* inChannelCount */, sampleRate, quality);
+        resampler->setSampleRate(inSampleRates[i]);
+        delete resampler;
+    }
+}
+
 AudioResampler::AudioResampler(int inChannelCount,
         int32_t sampleRate, src_quality quality) :
         mChannelCount(inChannelCount),
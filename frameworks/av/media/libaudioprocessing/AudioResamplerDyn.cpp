@@ -190,7 +190,9 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
+    if (mCoefBuffer != NULL) {
+        releaseFilter(mCoefBuffer);
+    }
 }
 
 template<typename TC, typename TI, typename TO>
@@ -223,22 +225,25 @@ template<typename TC, typename TI, typename TO>
 void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
         double stopBandAtten, int inSampleRate, int outSampleRate, double tbwCheat)
 {
-    TC* buf = NULL;
     static const double atten = 0.9998;   // to avoid ripple overflow
     double fcr;
     double tbw = firKaiserTbw(c.mHalfNumCoefs, stopBandAtten);
 
-    (void)posix_memalign(reinterpret_cast<void**>(&buf), 32, (c.mL+1)*c.mHalfNumCoefs*sizeof(TC));
     if (inSampleRate < outSampleRate) { // upsample
         fcr = max(0.5*tbwCheat - tbw/2, tbw/2);
     } else { // downsample
         fcr = max(0.5*tbwCheat*outSampleRate/inSampleRate - tbw/2, tbw/2);
     }
-    // create and set filter
-    firKaiserGen(buf, c.mL, c.mHalfNumCoefs, stopBandAtten, fcr, atten);
+    // get (or create) and set filter; acquire before release so an unchanged design is reused
+    FilterKey key;
+    key.L = c.mL;
+    key.halfNumCoefs = c.mHalfNumCoefs;
+    key.stopBandAtten = stopBandAtten;
+    key.fcr = fcr;
+    const TC* buf = acquireFilter(key);
     c.mFirCoefs = buf;
     if (mCoefBuffer) {
-        free(mCoefBuffer);
+        releaseFilter(mCoefBuffer);
     }
     mCoefBuffer = buf;
 #ifdef DEBUG_RESAMPLER
@@ -257,6 +262,89 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 #endif
 }
 
+template<typename TC, typename TI, typename TO>
+Mutex AudioResamplerDyn<TC, TI, TO>::sFilterLock;
+
+template<typename TC, typename TI, typename TO>
+KeyedVector<typename AudioResamplerDyn<TC, TI, TO>::FilterKey,
+        typename AudioResamplerDyn<TC, TI, TO>::Filter> AudioResamplerDyn<TC, TI, TO>::sFilters;
+
+template<typename TC, typename TI, typename TO>
+uint32_t AudioResamplerDyn<TC, TI, TO>::sFilterUseCount;
+
+template<typename TC, typename TI, typename TO>
+const TC* AudioResamplerDyn<TC, TI, TO>::acquireFilter(const FilterKey& key)
+{
+    static const double atten = 0.9998;   // to avoid ripple overflow, see createKaiserFir()
+
+    {
+        Mutex::Autolock _l(sFilterLock);
+        ssize_t index = sFilters.indexOfKey(key);
+        if (index >= 0) {
+            Filter& filter = sFilters.editValueAt(index);
+            filter.refCount++;
+            filter.lastUse = ++sFilterUseCount;
+            return filter.coefs;
+        }
+    }
+
+    // Design outside the lock, as this takes milliseconds and other
+    // mixer threads may be looking up filters concurrently.
+    TC* buf = NULL;
+    (void)posix_memalign(reinterpret_cast<void**>(&buf), 32,
+            (key.L+1)*key.halfNumCoefs*sizeof(TC));
+    LOG_ALWAYS_FATAL_IF(buf == NULL, "cannot allocate polyphase filter L:%d hnc:%d",
+            key.L, key.halfNumCoefs);
+    firKaiserGen(buf, key.L, key.halfNumCoefs, key.stopBandAtten, key.fcr, atten);
+
+    Mutex::Autolock _l(sFilterLock);
+    ssize_t index = sFilters.indexOfKey(key);
+    if (index >= 0) { // designed concurrently by another resampler
+        free(buf);
+        Filter& filter = sFilters.editValueAt(index);
+        filter.refCount++;
+        filter.lastUse = ++sFilterUseCount;
+        return filter.coefs;
+    }
+    Filter filter;
+    filter.coefs = buf;
+    filter.refCount = 1;
+    filter.lastUse = ++sFilterUseCount;
+    sFilters.add(key, filter);
+    return buf;
+}
+
+template<typename TC, typename TI, typename TO>
+void AudioResamplerDyn<TC, TI, TO>::releaseFilter(const TC* coefs)
+{
+    Mutex::Autolock _l(sFilterLock);
+    size_t idle = 0;
+    for (size_t i = 0; i < sFilters.size(); i++) {
+        Filter& filter = sFilters.editValueAt(i);
+        if (filter.coefs == coefs) {
+            LOG_ALWAYS_FATAL_IF(filter.refCount <= 0, "polyphase filter %p over-released", coefs);
+            filter.refCount--;
+        }
+        if (filter.refCount == 0) {
+            idle++;
+        }
+    }
+    // evict the least recently used unreferenced filters
+    while (idle > kMaxIdleFilters) {
+        ssize_t oldest = -1;
+        for (size_t i = 0; i < sFilters.size(); i++) {
+            const Filter& filter = sFilters.valueAt(i);
+            if (filter.refCount == 0
+                    && (oldest < 0 || filter.lastUse < sFilters.valueAt(oldest).lastUse)) {
+                oldest = i;
+            }
+        }
+        free(sFilters.valueAt(oldest).coefs);
+        sFilters.removeItemsAt(oldest);
+        idle--;
+    }
+}
+
 // recursive gcd. Using objdump, it appears the tail recursion is converted to a while loop.
 static int gcd(int n, int m)
 {
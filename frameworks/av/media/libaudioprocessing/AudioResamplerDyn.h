@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include <android/log.h>
+#include <utils/KeyedVector.h>
+#include <utils/Mutex.h>
 
 #include <media/AudioResampler.h>
 
@@ -112,6 +114,40 @@ private:
     void createKaiserFir(Constants &c, double stopBandAtten,
             int inSampleRate, int outSampleRate, double tbwCheat);
 
+    // Polyphase filter banks are shared by all resamplers with the same coefficient type TC.
+    // They are keyed by the firKaiserGen() design parameters, which fully determine them.
+    struct FilterKey {
+        int L;
+        int halfNumCoefs;
+        double stopBandAtten;
+        double fcr;
+
+        bool operator<(const FilterKey& other) const {
+            if (L != other.L) return L < other.L;
+            if (halfNumCoefs != other.halfNumCoefs) return halfNumCoefs < other.halfNumCoefs;
+            if (stopBandAtten != other.stopBandAtten) return stopBandAtten < other.stopBandAtten;
+            return fcr < other.fcr;
+        }
+    };
+
+    struct Filter {
+        TC*      coefs;
+        int      refCount;
+        uint32_t lastUse;   // value of sFilterUseCount when last acquired
+    };
+
+    // Returns the filter bank for key, designing it on first use; never NULL.
+    static const TC* acquireFilter(const FilterKey& key);
+    // Drops a reference; unreferenced banks are kept, up to kMaxIdleFilters, for reuse.
+    static void releaseFilter(const TC* coefs);
+
+    // enough for the banks prebuilt by AudioResampler::prebuildFilters() for one output rate
+    static const size_t kMaxIdleFilters = 16;
+
+    static Mutex sFilterLock;
+    static KeyedVector<FilterKey, Filter> sFilters;    // protected by sFilterLock
+    static uint32_t sFilterUseCount;                   // protected by sFilterLock
+
     template<int CHANNELS, bool LOCKED, int STRIDE>
     size_t resample(TO* out, size_t outFrameCount, AudioBufferProvider* provider);
 
@@ -126,7 +162,7 @@ private:
      resample_ABP_t mResampleFunc;     // called function for resampling
             int32_t mFilterSampleRate; // designed filter sample rate.
         src_quality mFilterQuality;    // designed filter quality.
-              void* mCoefBuffer;       // if a filter is created, this is not null
+          const TC* mCoefBuffer;       // acquired shared filter bank, or null
 };
 
 } // namespace android
@@ -54,6 +54,13 @@ public:
     static AudioResampler* create(audio_format_t format, int inChannelCount,
             int32_t sampleRate, src_quality quality=DEFAULT_QUALITY);
 
+    // Designs the polyphase filters that resamplers of the given format and quality
+    // would need to convert each of inSampleRates to sampleRate, and caches them so that
+    // later create() and setSampleRate() calls for those rates do not design filters.
+    // Only the DYN_* qualities use shared filters; other qualities are ignored.
+    static void prebuildFilters(audio_format_t format, int32_t sampleRate, src_quality quality,
+            const int32_t* inSampleRates, size_t count);
+
     virtual ~AudioResampler();
 
     virtual void init() = 0;
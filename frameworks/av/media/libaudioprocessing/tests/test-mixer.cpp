@@ -236,7 +236,7 @@ int main(int argc, char* argv[]) {
 
     // create the mixer.
     const size_t mixerFrameCount = 320; // typical numbers may range from 240 or 960
-    AudioMixer *mixer = new AudioMixer(mixerFrameCount, outputSampleRate);
+    AudioMixer *mixer = new AudioMixer(mixerFrameCount, outputSampleRate, providers.size());
     audio_format_t mixerFormat = useMixerFloat
             ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
     float f = AudioMixer::UNITY_GAIN_FLOAT / providers.size(); // normalize volume by # tracks
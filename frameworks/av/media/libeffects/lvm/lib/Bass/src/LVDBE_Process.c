@@ -27,6 +27,42 @@
 #include "AGC.h"
 #include "LVDBE_Coeffs.h"               /* Filter coefficients */
 
+/****************************************************************************************/
+/*                                                                                      */
+/*  Defines                                                                             */
+/*                                                                                      */
+/****************************************************************************************/
+
+#ifdef BUILD_FLOAT
+#define LVDBE_UNITY_GAIN    1.0f
+#else
+#define LVDBE_UNITY_GAIN    0x00007FFF
+#endif
+
+/****************************************************************************************/
+/*                                                                                      */
+/* FUNCTION:                 LVDBE_IsTransparent                                        */
+/*                                                                                      */
+/* DESCRIPTION:                                                                         */
+/*  Returns LVM_TRUE when the algorithm is off and the bypass mixer and bypass volume   */
+/*  have settled on the dry path at unity gain, so the output equals the input.          */
+/*                                                                                      */
+/****************************************************************************************/
+static LVM_INT16 LVDBE_IsTransparent(LVDBE_Instance_t *pInstance)
+{
+    if ((pInstance->Params.OperatingMode == LVDBE_OFF) &&
+        (LVC_Mixer_GetTarget(&pInstance->pData->BypassMixer.MixerStream[0]) == 0) &&
+        (LVC_Mixer_GetCurrent(&pInstance->pData->BypassMixer.MixerStream[0]) == 0) &&
+        (LVC_Mixer_GetTarget(&pInstance->pData->BypassMixer.MixerStream[1]) == LVDBE_UNITY_GAIN) &&
+        (LVC_Mixer_GetCurrent(&pInstance->pData->BypassMixer.MixerStream[1]) == LVDBE_UNITY_GAIN) &&
+        (LVC_Mixer_GetTarget(&pInstance->pData->BypassVolume.MixerStream[0]) == LVDBE_UNITY_GAIN) &&
+        (LVC_Mixer_GetCurrent(&pInstance->pData->BypassVolume.MixerStream[0]) == LVDBE_UNITY_GAIN))
+    {
+        return LVM_TRUE;
+    }
+    return LVM_FALSE;
+}
+
 /********************************************************************************************/
 /*                                                                                          */
 /* FUNCTION:                 LVDBE_Process                                                  */
@@ -94,6 +130,16 @@ LVDBE_ReturnStatus_en LVDBE_Process(LVDBE_Handle_t hInstance,
     return (LVDBE_TOOMANYSAMPLES);
   }
 
+  /*
+   * Nothing to do when off and settled, apart from moving the data
+   */
+  if (LVDBE_IsTransparent(pInstance) == LVM_TRUE) {
+    if (pInData != pOutData) {
+      Copy_16(pInData, pOutData, (LVM_INT16) (2 * NumSamples)); /* Left and right */
+    }
+    return (LVDBE_SUCCESS);
+  }
+
   /*
    * Check if the algorithm is enabled
    */
@@ -212,6 +258,18 @@ LVDBE_ReturnStatus_en LVDBE_Process(LVDBE_Handle_t hInstance,
     return(LVDBE_TOOMANYSAMPLES);
   }
 
+  /*
+   * Nothing to do when off and settled, apart from moving the data
+   */
+  if (LVDBE_IsTransparent(pInstance) == LVM_TRUE)
+  {
+    if (pInData != pOutData)
+    {
+      Copy_Float(pInData, pOutData, (LVM_INT16)(2 * NumSamples)); /* Left and right */
+    }
+    return(LVDBE_SUCCESS);
+  }
+
   /*
    * Convert 16-bit samples to Float
    */
@@ -532,6 +532,39 @@ void    LVM_SetHeadroom(LVM_Instance_t         *pInstance,
 }
 
 
+/****************************************************************************************/
+/*                                                                                      */
+/* FUNCTION:                LVM_EQNB_IsNeutral                                          */
+/*                                                                                      */
+/* DESCRIPTION:                                                                         */
+/*  Checks whether the equaliser settings leave the signal unchanged, that is every     */
+/*  band has a gain of 0dB. A neutral equaliser is bypassed so the band filters are     */
+/*  not run on every buffer.                                                            */
+/*                                                                                      */
+/* PARAMETERS:                                                                          */
+/*  pParams                 Pointer to the control parameters                           */
+/*                                                                                      */
+/* RETURNS:                                                                             */
+/*  LVM_TRUE                All bands are at 0dB                                        */
+/*  LVM_FALSE               At least one band modifies the signal                       */
+/*                                                                                      */
+/****************************************************************************************/
+
+static LVM_INT16 LVM_EQNB_IsNeutral(const LVM_ControlParams_t *pParams)
+{
+    LVM_UINT16  i;
+
+    for (i = 0; i < pParams->EQNB_NBands; i++)
+    {
+        if (pParams->pEQNB_BandDefinition[i].Gain != 0)
+        {
+            return LVM_FALSE;
+        }
+    }
+    return LVM_TRUE;
+}
+
+
 /****************************************************************************************/
 /*                                                                                      */
 /* FUNCTION:                LVM_ApplyNewSettings                                        */
@@ -712,6 +745,12 @@ LVM_ReturnStatus_en LVM_ApplyNewSettings(LVM_Handle_t   hInstance)
         {
             DBE_Params.OperatingMode    = (LVDBE_Mode_en)LocalParams.BE_OperatingMode;
         }
+        if ((LocalParams.BE_EffectLevel == 0) &&
+            (LocalParams.BE_HPF == LVM_BE_HPF_OFF))
+        {
+            /* No boost and no high pass filter, fade out through the bypass mixer */
+            DBE_Params.OperatingMode = LVDBE_OFF;
+        }
         DBE_Params.SampleRate       = (LVDBE_Fs_en)LocalParams.SampleRate;
         DBE_Params.EffectLevel      = LocalParams.BE_EffectLevel;
         DBE_Params.CentreFrequency  = (LVDBE_CentreFreq_en)LocalParams.BE_CentreFreq;
@@ -781,7 +820,8 @@ LVM_ReturnStatus_en LVM_ApplyNewSettings(LVM_Handle_t   hInstance)
          * Set the control flag
          */
         if ((LocalParams.OperatingMode == LVM_MODE_ON) &&
-            (LocalParams.EQNB_OperatingMode == LVM_EQNB_ON))
+            (LocalParams.EQNB_OperatingMode == LVM_EQNB_ON) &&
+            (LVM_EQNB_IsNeutral(&LocalParams) == LVM_FALSE))
         {
             pInstance->EQNB_Active = LVM_TRUE;
         }
@@ -18,6 +18,9 @@
 #include "BIQUAD.h"
 #include "PK_2I_D32F32CssGss_TRC_WRA_01_Private.h"
 #include "LVM_Macros.h"
+#if defined(BUILD_FLOAT) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#endif
 
 /**************************************************************************
  ASSUMPTIONS:
@@ -38,7 +41,52 @@
  pBiquadState->pDelays[6] is y(n-2)L in Q0 format
  pBiquadState->pDelays[7] is y(n-2)R in Q0 format
 ***************************************************************************/
-#ifdef BUILD_FLOAT
+#if defined(BUILD_FLOAT) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+/* NEON: the left and right channels share the coefficients, so each lane of a float32x2_t
+ * runs one channel. The delays stay in registers, and the arithmetic matches the scalar code. */
+void PK_2I_D32F32C14G11_TRC_WRA_01 ( Biquad_FLOAT_Instance_t       *pInstance,
+                                     LVM_FLOAT               *pDataIn,
+                                     LVM_FLOAT               *pDataOut,
+                                     LVM_INT16               NrSamples)
+    {
+        LVM_INT16 ii;
+        PFilter_State_Float pBiquadState = (PFilter_State_Float) pInstance;
+        const float32x2_t A0   = vdup_n_f32(pBiquadState->coefs[0]);
+        const float32x2_t B2   = vdup_n_f32(pBiquadState->coefs[1]);
+        const float32x2_t B1   = vdup_n_f32(pBiquadState->coefs[2]);
+        const float32x2_t Gain = vdup_n_f32(pBiquadState->coefs[3]);
+        float32x2_t xn1 = vld1_f32(&pBiquadState->pDelays[0]);     /* x(n-1)L, x(n-1)R */
+        float32x2_t xn2 = vld1_f32(&pBiquadState->pDelays[2]);     /* x(n-2)L, x(n-2)R */
+        float32x2_t yn1 = vld1_f32(&pBiquadState->pDelays[4]);     /* y(n-1)L, y(n-1)R */
+        float32x2_t yn2 = vld1_f32(&pBiquadState->pDelays[6]);     /* y(n-2)L, y(n-2)R */
+
+         for (ii = NrSamples; ii != 0; ii--)
+         {
+            const float32x2_t xn = vld1_f32(pDataIn);
+            float32x2_t yn;
+
+            /* yn= (A0  * (x(n) - x(n-2) ) ) + (-B2 * y(n-2)) + (-B1 * y(n-1)) */
+            yn = vmul_f32(vsub_f32(xn, xn2), A0);
+            yn = vmla_f32(yn, yn2, B2);
+            yn = vmla_f32(yn, yn1, B1);
+
+            /* output = x(n) + Gain * yn */
+            vst1_f32(pDataOut, vmla_f32(xn, yn, Gain));
+
+            xn2 = xn1;
+            xn1 = xn;
+            yn2 = yn1;
+            yn1 = yn;
+            pDataIn += 2;
+            pDataOut += 2;
+        }
+
+        vst1_f32(&pBiquadState->pDelays[0], xn1);
+        vst1_f32(&pBiquadState->pDelays[2], xn2);
+        vst1_f32(&pBiquadState->pDelays[4], yn1);
+        vst1_f32(&pBiquadState->pDelays[6], yn2);
+    }
+#elif defined(BUILD_FLOAT)
 void PK_2I_D32F32C14G11_TRC_WRA_01 ( Biquad_FLOAT_Instance_t       *pInstance,
                                      LVM_FLOAT               *pDataIn,
                                      LVM_FLOAT               *pDataOut,
@@ -159,12 +159,17 @@ void NuPlayer::Renderer::queueBuffer(
         bool audio,
         const sp<MediaCodecBuffer> &buffer,
         const sp<AMessage> &notifyConsumed) {
-    sp<AMessage> msg = new AMessage(kWhatQueueBuffer, this);
-    msg->setInt32("queueGeneration", getQueueGeneration(audio));
-    msg->setInt32("audio", static_cast<int32_t>(audio));
-    msg->setObject("buffer", buffer);
-    msg->setMessage("notifyConsumed", notifyConsumed);
-    msg->post();
+    PendingBuffer pending;
+    pending.mAudio = audio;
+    pending.mQueueGeneration = getQueueGeneration(audio);
+    pending.mBuffer = buffer;
+    pending.mNotifyConsumed = notifyConsumed;
+
+    Mutex::Autolock autoLock(mPendingBuffersLock);
+    mPendingBuffers.push_back(pending);
+    if (mPendingBuffers.size() == 1) {
+        (new AMessage(kWhatQueueBuffer, this))->post();
+    }
 }
 
 void NuPlayer::Renderer::queueEOS(bool audio, status_t finalResult) {
@@ -605,7 +610,7 @@ void NuPlayer::Renderer::onMessageReceived(const sp<AMessage> &msg) {
 
         case kWhatQueueBuffer:
         {
-            onQueueBuffer(msg);
+            onQueuePendingBuffers();
             break;
         }
 
@@ -1438,11 +1443,23 @@ void NuPlayer::Renderer::notifyAudioTearDown(AudioTearDownReason reason) {
     msg->post();
 }
 
-void NuPlayer::Renderer::onQueueBuffer(const sp<AMessage> &msg) {
-    int32_t audio;
-    CHECK(msg->findInt32("audio", &audio));
+void NuPlayer::Renderer::onQueuePendingBuffers() {
+    std::vector<PendingBuffer> pendingBuffers;
+    {
+        Mutex::Autolock autoLock(mPendingBuffersLock);
+        pendingBuffers.swap(mPendingBuffers);
+    }
 
-    if (dropBufferIfStale(audio, msg)) {
+    for (const PendingBuffer &pending : pendingBuffers) {
+        onQueueBuffer(pending);
+    }
+}
+
+void NuPlayer::Renderer::onQueueBuffer(const PendingBuffer &pending) {
+    bool audio = pending.mAudio;
+
+    if (pending.mQueueGeneration != getQueueGeneration(audio)) {
+        pending.mNotifyConsumed->post();
         return;
     }
 
@@ -1459,16 +1476,9 @@ void NuPlayer::Renderer::onQueueBuffer(const sp<AMessage> &msg) {
         }
     }
 
-    sp<RefBase> obj;
-    CHECK(msg->findObject("buffer", &obj));
-    sp<MediaCodecBuffer> buffer = static_cast<MediaCodecBuffer *>(obj.get());
-
-    sp<AMessage> notifyConsumed;
-    CHECK(msg->findMessage("notifyConsumed", &notifyConsumed));
-
     QueueEntry entry;
-    entry.mBuffer = buffer;
-    entry.mNotifyConsumed = notifyConsumed;
+    entry.mBuffer = pending.mBuffer;
+    entry.mNotifyConsumed = pending.mNotifyConsumed;
     entry.mOffset = 0;
     entry.mFinalResult = OK;
     entry.mBufferOrdinal = ++mTotalBuffersQueued;
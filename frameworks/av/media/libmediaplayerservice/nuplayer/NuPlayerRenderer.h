@@ -21,6 +21,8 @@
 #include <media/AudioResamplerPublic.h>
 #include <media/AVSyncSettings.h>
 
+#include <vector>
+
 #include "NuPlayer.h"
 
 namespace android {
@@ -154,6 +156,18 @@ private:
     uint32_t mFlags;
     List<QueueEntry> mAudioQueue;
     List<QueueEntry> mVideoQueue;
+
+    // Buffers handed over by queueBuffer() that the looper hasn't picked up
+    // yet. kWhatQueueBuffer is only posted when this becomes non-empty, so a
+    // burst of buffers costs a single looper round trip.
+    struct PendingBuffer {
+        bool mAudio;
+        int32_t mQueueGeneration;
+        sp<MediaCodecBuffer> mBuffer;
+        sp<AMessage> mNotifyConsumed;
+    };
+    Mutex mPendingBuffersLock;
+    std::vector<PendingBuffer> mPendingBuffers;
     uint32_t mNumFramesWritten;
     sp<VideoFrameScheduler> mVideoScheduler;
 
@@ -247,7 +261,8 @@ private:
     void prepareForMediaRenderingStart_l();
     void notifyIfMediaRenderingStarted_l();
 
-    void onQueueBuffer(const sp<AMessage> &msg);
+    void onQueuePendingBuffers();
+    void onQueueBuffer(const PendingBuffer &pending);
     void onQueueEOS(const sp<AMessage> &msg);
     void onFlush(const sp<AMessage> &msg);
     void onAudioSinkChanged();
@@ -144,6 +144,11 @@ std::unique_ptr<NBLog::AbstractEntry> NBLog::AbstractEntry::buildEntry(const uin
     case EVENT_AUDIO_STATE:
     case EVENT_HISTOGRAM_ENTRY_TS:
         return std::make_unique<HistogramEntry>(HistogramEntry(ptr));
+    case EVENT_UNDERRUN:
+    case EVENT_MIX_DURATION:
+    case EVENT_HAL_WRITE:
+    case EVENT_WAKEUP_LATENCY:
+        return std::make_unique<TypedEntry>(TypedEntry(ptr));
     default:
         ALOGW("Tried to create AbstractEntry of type %d", type);
         return nullptr;
@@ -339,6 +344,79 @@ NBLog::EntryIterator NBLog::HistogramEntry::copyWithAuthor(
 
 // ---------------------------------------------------------------------------
 
+/*static*/
+int NBLog::TypedEntry::fieldCount(Event event) {
+    switch (event) {
+    case EVENT_UNDERRUN:
+        return 2;
+    case EVENT_MIX_DURATION:
+    case EVENT_HAL_WRITE:
+    case EVENT_WAKEUP_LATENCY:
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+int NBLog::TypedEntry::fields(uint64_t *values, int maxFields) const {
+    EntryIterator it(mEntry);
+    const uint8_t *data = it->data;
+    size_t remaining = it->length;
+    int count = 0;
+    while (remaining > 0 && count < maxFields) {
+        size_t used = decodeVarint(data, remaining, &values[count]);
+        if (used == 0) {
+            return -1;
+        }
+        data += used;
+        remaining -= used;
+        ++count;
+    }
+    return remaining == 0 ? count : -1;
+}
+
+int64_t NBLog::TypedEntry::timestamp() const {
+    uint64_t values[kMaxFields];
+    if (fields(values, kMaxFields) < 1) {
+        return 0;
+    }
+    return (int64_t) values[0] * 1000;
+}
+
+NBLog::log_hash_t NBLog::TypedEntry::hash() const {
+    return 0;
+}
+
+int NBLog::TypedEntry::author() const {
+    uint64_t values[kMaxFields];
+    const int count = fields(values, kMaxFields);
+    const int expected = 1 + fieldCount(event());
+    if (count == expected + 1) {
+        return (int) values[expected];
+    } else {
+        return -1;
+    }
+}
+
+NBLog::EntryIterator NBLog::TypedEntry::copyWithAuthor(
+        std::unique_ptr<audio_utils_fifo_writer> &dst, int author) const {
+    // Current typed entry has {type, length, varints, length}.
+    // We now want {type, length, varints, author varint, length}
+    EntryIterator it(mEntry);
+    const size_t length = it->length;
+    uint8_t buffer[Entry::kOverhead + TypedEntry::kMaxFields * kMaxVarintSize];
+    ALOG_ASSERT(length + kMaxVarintSize <= sizeof(buffer) - Entry::kOverhead);
+    memcpy(buffer, mEntry, sizeof(entry) + length);
+    const size_t newLength = length + encodeVarint(author, buffer + sizeof(entry) + length);
+    buffer[offsetof(entry, length)] = newLength;
+    const size_t need = newLength + Entry::kOverhead;
+    buffer[need + Entry::kPreviousLengthOffset] = newLength;
+    dst->write(buffer, need);
+    return it.next();
+}
+
+// ---------------------------------------------------------------------------
+
 #if 0   // FIXME see note in NBLog.h
 NBLog::Timeline::Timeline(size_t size, void *shared)
     : mSize(roundup(size)), mOwn(shared == NULL),
@@ -535,6 +613,40 @@ void NBLog::Writer::logEventHistTs(Event event, log_hash_t hash)
     }
 }
 
+void NBLog::Writer::logUnderrun(uint32_t trackIndex, uint32_t framesMissing)
+{
+    if (!mEnabled) {
+        return;
+    }
+    const uint64_t fields[] = {trackIndex, framesMissing};
+    logTyped(EVENT_UNDERRUN, fields, 2);
+}
+
+void NBLog::Writer::logDuration(Event event, int64_t ns)
+{
+    if (!mEnabled || ns < 0 || TypedEntry::fieldCount(event) != 1) {
+        return;
+    }
+    const uint64_t fields[] = {(uint64_t) ns / 1000};
+    logTyped(event, fields, 1);
+}
+
+void NBLog::Writer::logTyped(Event event, const uint64_t *fields, int count)
+{
+    const int64_t ts = get_monotonic_ns();
+    if (ts <= 0) {
+        ALOGE("Failed to get timestamp");
+        return;
+    }
+    // leave room for the author varint added by the merger
+    uint8_t data[TypedEntry::kMaxFields * TypedEntry::kMaxVarintSize];
+    size_t length = encodeVarint((uint64_t) ts / 1000, data);
+    for (int i = 0; i < count; i++) {
+        length += encodeVarint(fields[i], data + length);
+    }
+    log(event, data, length);
+}
+
 void NBLog::Writer::logFormat(const char *fmt, log_hash_t hash, ...)
 {
     if (!mEnabled) {
@@ -745,6 +857,18 @@ void NBLog::LockedWriter::logHash(log_hash_t hash)
     Writer::logHash(hash);
 }
 
+void NBLog::LockedWriter::logUnderrun(uint32_t trackIndex, uint32_t framesMissing)
+{
+    Mutex::Autolock _l(mLock);
+    Writer::logUnderrun(trackIndex, framesMissing);
+}
+
+void NBLog::LockedWriter::logDuration(Event event, int64_t ns)
+{
+    Mutex::Autolock _l(mLock);
+    Writer::logDuration(event, ns);
+}
+
 bool NBLog::LockedWriter::isEnabled() const
 {
     Mutex::Autolock _l(mLock);
@@ -760,10 +884,18 @@ bool NBLog::LockedWriter::setEnabled(bool enabled)
 // ---------------------------------------------------------------------------
 
 const std::set<NBLog::Event> NBLog::Reader::startingTypes {NBLog::Event::EVENT_START_FMT,
-                                                           NBLog::Event::EVENT_HISTOGRAM_ENTRY_TS};
+                                                           NBLog::Event::EVENT_HISTOGRAM_ENTRY_TS,
+                                                           NBLog::Event::EVENT_UNDERRUN,
+                                                           NBLog::Event::EVENT_MIX_DURATION,
+                                                           NBLog::Event::EVENT_HAL_WRITE,
+                                                           NBLog::Event::EVENT_WAKEUP_LATENCY};
 const std::set<NBLog::Event> NBLog::Reader::endingTypes   {NBLog::Event::EVENT_END_FMT,
                                                            NBLog::Event::EVENT_HISTOGRAM_ENTRY_TS,
-                                                           NBLog::Event::EVENT_AUDIO_STATE};
+                                                           NBLog::Event::EVENT_AUDIO_STATE,
+                                                           NBLog::Event::EVENT_UNDERRUN,
+                                                           NBLog::Event::EVENT_MIX_DURATION,
+                                                           NBLog::Event::EVENT_HAL_WRITE,
+                                                           NBLog::Event::EVENT_WAKEUP_LATENCY};
 
 NBLog::Reader::Reader(const void *shared, size_t size)
     : mShared((/*const*/ Shared *) shared), /*mIMemory*/
@@ -911,6 +1043,13 @@ void NBLog::Reader::dump(int fd, size_t indent, NBLog::Reader::Snapshot &snapsho
             ++entry;
             break;
         }
+        case EVENT_UNDERRUN:
+        case EVENT_MIX_DURATION:
+        case EVENT_HAL_WRITE:
+        case EVENT_WAKEUP_LATENCY:
+            handleTyped(TypedEntry(entry), &timestamp, &body);
+            ++entry;
+            break;
         case EVENT_END_FMT:
             body.appendFormat("warning: got to end format event");
             ++entry;
@@ -993,6 +1132,77 @@ String8 NBLog::bufferDump(const EntryIterator &it)
     return bufferDump(it, it->length + Entry::kOverhead);
 }
 
+/*static*/
+size_t NBLog::encodeVarint(uint64_t value, uint8_t *dst)
+{
+    size_t i = 0;
+    while (value >= 0x80) {
+        dst[i++] = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    dst[i++] = (uint8_t) value;
+    return i;
+}
+
+/*static*/
+size_t NBLog::decodeVarint(const uint8_t *src, size_t size, uint64_t *value)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < size && i < TypedEntry::kMaxVarintSize; i++) {
+        result |= (uint64_t) (src[i] & 0x7F) << (7 * i);
+        if ((src[i] & 0x80) == 0) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+/*static*/
+const char *NBLog::typedEventName(Event event)
+{
+    switch (event) {
+    case EVENT_UNDERRUN:        return "underrun";
+    case EVENT_MIX_DURATION:    return "mix";
+    case EVENT_HAL_WRITE:       return "write";
+    case EVENT_WAKEUP_LATENCY:  return "wakeup";
+    default:                    return "unknown";
+    }
+}
+
+void NBLog::Reader::handleTyped(const TypedEntry &typedEntry, String8 *timestamp,
+                                String8 *body)
+{
+    // one event per line, so that the analyzer does not see unrelated formatted text
+    if (!body->isEmpty()) {
+        dumpLine(*timestamp, *body);
+    }
+    const Event event = typedEntry.event();
+    uint64_t values[TypedEntry::kMaxFields];
+    const int count = typedEntry.fields(values, TypedEntry::kMaxFields);
+    if (count < 1 + TypedEntry::fieldCount(event)) {
+        body->appendFormat("warning: malformed %s event", typedEventName(event));
+        dumpLine(*timestamp, *body);
+        return;
+    }
+    const int64_t ts = typedEntry.timestamp();
+    timestamp->clear();
+    timestamp->appendFormat("[%d.%03d]", (int) (ts / (1000 * 1000 * 1000)),
+                    (int) ((ts / (1000 * 1000)) % 1000));
+    if (typedEntry.author() >= 0) {
+        handleAuthor(typedEntry, body);
+    }
+    body->appendFormat("event=%s t_us=%llu", typedEventName(event),
+            (unsigned long long) values[0]);
+    if (event == EVENT_UNDERRUN) {
+        body->appendFormat(" track=%llu frames=%llu",
+                (unsigned long long) values[1], (unsigned long long) values[2]);
+    } else {
+        body->appendFormat(" us=%llu", (unsigned long long) values[1]);
+    }
+    dumpLine(*timestamp, *body);
+}
+
 NBLog::EntryIterator NBLog::Reader::handleFormat(const FormatEntry &fmtEntry,
                                                          String8 *timestamp,
                                                          String8 *body) {
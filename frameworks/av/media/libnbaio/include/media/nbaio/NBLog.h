@@ -61,6 +61,13 @@ enum Event : uint8_t {
     EVENT_AUDIO_STATE,          // audio on/off event: logged upon FastMixer::onStateChange() call
     EVENT_END_FMT,              // end of logFormat argument list
 
+    // Typed events: payload is a sequence of unsigned varints, see TypedEntry.
+    // The first is the CLOCK_MONOTONIC time in microseconds, then the fields listed here.
+    EVENT_UNDERRUN,             // track underrun: track index, frames missing
+    EVENT_MIX_DURATION,         // time spent mixing one buffer, in microseconds
+    EVENT_HAL_WRITE,            // time spent in one sink write(), in microseconds
+    EVENT_WAKEUP_LATENCY,       // how late a periodic wakeup was, in microseconds
+
     EVENT_UPPER_BOUND,          // to check for invalid events
 };
 
@@ -212,6 +219,38 @@ public:
 
 };
 
+// A single entry holding a typed event.  Fields are LEB128 unsigned varints; the merger
+// appends the author as one more varint, which is detected by the field count.
+// Every entry is self-contained, so entries lost to FIFO overrun do not corrupt others.
+class TypedEntry : public AbstractEntry {
+public:
+    explicit TypedEntry(const uint8_t *ptr) : AbstractEntry(ptr) {}
+    virtual ~TypedEntry() {}
+
+            Event       event() const { return (Event) EntryIterator(mEntry)->type; }
+
+    // number of fields after the timestamp for a typed event, or -1 if not a typed event
+    static int          fieldCount(Event event);
+
+    // decodes up to maxFields varints (timestamp first, author last if present);
+    // returns the number decoded or -1 if the payload is malformed
+            int         fields(uint64_t *values, int maxFields) const;
+
+    virtual int64_t     timestamp() const override;
+
+    // typed events have no source location
+    virtual log_hash_t  hash() const override;
+
+    virtual int         author() const override;
+
+    virtual EntryIterator    copyWithAuthor(std::unique_ptr<audio_utils_fifo_writer> &dst,
+                                       int author) const override;
+
+    // enough for the timestamp, the largest field count and the author
+    static const int    kMaxFields = 4;
+    static const size_t kMaxVarintSize = 10;    // for uint64_t
+};
+
 // ---------------------------------------------------------------------------
 
 // representation of a single log entry in private memory
@@ -273,6 +312,10 @@ struct HistIntEntry {
     static size_t  fmtEntryLength(const uint8_t *data);
     static String8 bufferDump(const uint8_t *buffer, size_t size);
     static String8 bufferDump(const EntryIterator &it);
+    // LEB128 unsigned varint; encode returns bytes written, decode returns bytes read or 0
+    static size_t  encodeVarint(uint64_t value, uint8_t *dst);
+    static size_t  decodeVarint(const uint8_t *src, size_t size, uint64_t *value);
+    static const char *typedEventName(Event event);
 public:
 
 // Located in shared memory, must be POD.
@@ -344,6 +387,10 @@ public:
     virtual void    logEnd();
     virtual void    logHash(log_hash_t hash);
     virtual void    logEventHistTs(Event event, log_hash_t hash);
+    // Typed events, timestamped now; durations are converted to microseconds.
+    virtual void    logUnderrun(uint32_t trackIndex, uint32_t framesMissing);
+    // event is EVENT_MIX_DURATION, EVENT_HAL_WRITE or EVENT_WAKEUP_LATENCY; negative is ignored
+    virtual void    logDuration(Event event, int64_t ns);
 
     virtual bool    isEnabled() const;
 
@@ -358,6 +405,8 @@ private:
     // 0 <= length <= kMaxLength
     // writes a single Entry to the FIFO
     void    log(Event event, const void *data, size_t length);
+    // writes a typed event with the current time and the given fields
+    void    logTyped(Event event, const uint64_t *fields, int count);
     // checks validity of an event before calling log above this one
     void    log(const Entry *entry, bool trusted = false);
 
@@ -394,6 +443,8 @@ public:
     virtual void    logStart(const char *fmt);
     virtual void    logEnd();
     virtual void    logHash(log_hash_t hash);
+    virtual void    logUnderrun(uint32_t trackIndex, uint32_t framesMissing);
+    virtual void    logDuration(Event event, int64_t ns);
 
     virtual bool    isEnabled() const;
     virtual bool    setEnabled(bool enabled);
@@ -477,6 +528,10 @@ private:
     EntryIterator   handleFormat(const FormatEntry &fmtEntry,
                                          String8 *timestamp,
                                          String8 *body);
+    // prints a typed event as "event=<name> t_us=<time> <field>=<value> ...",
+    // the line format parsed by the nblog_analyzer host tool
+    void            handleTyped(const TypedEntry &typedEntry, String8 *timestamp,
+                                String8 *body);
     // dummy method for handling absent author entry
     virtual void handleAuthor(const AbstractEntry& /*fmtEntry*/, String8* /*body*/) {}
 
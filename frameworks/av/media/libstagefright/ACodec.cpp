@@ -2270,6 +2270,12 @@ status_t ACodec::configureCodec(
         err = OK; // ignore error
     }
 
+    int32_t threadCount;
+    if (video && !encoder && msg->findInt32("thread-count", &threadCount)) {
+        err = setDecoderThreadCount(threadCount);
+        err = OK; // ignore error
+    }
+
     int32_t rateInt = -1;
     float rateFloat = -1;
     if (!msg->findFloat("operating-rate", &rateFloat)) {
@@ -2362,6 +2368,29 @@ status_t ACodec::setPriority(int32_t priority) {
     return OK;
 }
 
+status_t ACodec::setDecoderThreadCount(int32_t threadCount) {
+    if (threadCount < 0) {
+        return BAD_VALUE;
+    }
+    OMX_INDEXTYPE index;
+    status_t err = mOMXNode->getExtensionIndex(
+            "OMX.google.android.index.decoderThreadCount", &index);
+    if (err != OK) {
+        ALOGV("[%s] codec does not support thread count", mComponentName.c_str());
+        return err;
+    }
+    OMX_PARAM_U32TYPE params;
+    InitOMXParams(&params);
+    params.nPortIndex = kPortIndexInput;
+    params.nU32 = (OMX_U32)threadCount;
+    err = mOMXNode->setParameter(index, &params, sizeof(params));
+    if (err != OK) {
+        ALOGI("[%s] failed to set thread count %d (err %d)",
+                mComponentName.c_str(), threadCount, err);
+    }
+    return err;
+}
+
 status_t ACodec::setOperatingRate(float rateFloat, bool isVideo) {
     if (rateFloat < 0) {
         return BAD_VALUE;
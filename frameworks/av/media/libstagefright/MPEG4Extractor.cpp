@@ -184,6 +184,7 @@ private:
 // This is used to cache the full sampletable metadata for a single track,
 // possibly wrapping multiple times to cover all tracks, i.e.
 // Each MPEG4DataSource caches the sampletable metadata for a single track.
+// When the moov box is small enough, a single MPEG4DataSource caches all of it instead.
 
 struct MPEG4DataSource : public DataSource {
     explicit MPEG4DataSource(const sp<DataSource> &source);
@@ -285,6 +286,10 @@ status_t MPEG4DataSource::setCachedRange(off64_t offset, size_t size) {
 
 static const bool kUseHexDump = false;
 
+// Largest moov box fetched in a single read from a network or caching source. Bigger boxes
+// fall back to caching the sample table of each track separately.
+static const uint64_t kMaxCachedMoovSize = 32 * 1024 * 1024;
+
 static void hexdump(const void *_data, size_t size) {
     const uint8_t *data = (const uint8_t *)_data;
     size_t offset = 0;
@@ -374,6 +379,7 @@ MPEG4Extractor::MPEG4Extractor(const sp<DataSource> &source)
     : mMoofOffset(0),
       mMoofFound(false),
       mMdatFound(false),
+      mMoovCached(false),
       mDataSource(source),
       mInitCheck(NO_INIT),
       mHeaderTimescale(0),
@@ -947,12 +953,28 @@ status_t MPEG4Extractor::parseChunk(off64_t *offset, int depth) {
                 mMoofOffset = *offset;
             }
 
+            if (chunk_type == FOURCC('m', 'o', 'o', 'v') && !mMoovCached
+                    && chunk_size <= kMaxCachedMoovSize
+                    && (mDataSource->flags()
+                        & (DataSource::kWantsPrefetching
+                            | DataSource::kIsCachingDataSource))) {
+                // Fetch the whole movie box with one read, so that parsing its many
+                // small boxes does not cost a round trip each on a network source.
+                sp<MPEG4DataSource> cachedSource = new MPEG4DataSource(mDataSource);
+
+                if (cachedSource->setCachedRange(*offset, chunk_size) == OK) {
+                    mDataSource = cachedSource;
+                    mMoovCached = true;
+                }
+            }
+
             if (chunk_type == FOURCC('s', 't', 'b', 'l')) {
                 ALOGV("sampleTable chunk is %" PRIu64 " bytes long.", chunk_size);
 
-                if (mDataSource->flags()
+                // the sample table is already in memory if the moov box was cached
+                if (!mMoovCached && (mDataSource->flags()
                         & (DataSource::kWantsPrefetching
-                            | DataSource::kIsCachingDataSource)) {
+                            | DataSource::kIsCachingDataSource))) {
                     sp<MPEG4DataSource> cachedSource =
                         new MPEG4DataSource(mDataSource);
 
@@ -22,6 +22,7 @@
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <linux/falloc.h>
 #include <pthread.h>
 #include <sys/prctl.h>
 #include <sys/stat.h>
@@ -431,6 +432,231 @@ private:
     Track &operator=(const Track &);
 };
 
+// Takes the sample data of the 'mdat' box and writes it out on its own
+// thread from a ring of large buffers. Track threads then only block on
+// storage when all buffers are waiting to be written, and the file sees
+// a few large writes instead of several small ones per sample.
+class MPEG4Writer::AsyncWriter {
+public:
+    // Data passed to write() goes to the file starting at offset.
+    AsyncWriter(int fd, off64_t offset);
+    ~AsyncWriter();
+
+    // Not thread-safe; there must be a single producer at a time.
+    void write(const void *data, size_t size);
+
+    // Writes out all data passed so far and waits for it to reach the file.
+    // Returns the first error seen by any write.
+    status_t flush();
+
+private:
+    enum {
+        kNumBuffers         = 8,
+        kBufferSize         = 1024 * 1024,
+        kBufferAlignment    = 4096,
+        // Reserve file space in steps of this size ahead of the data.
+        kPreallocateBytes   = 32 * 1024 * 1024,
+    };
+
+    struct Buffer {
+        uint8_t *mData;
+        size_t mSize;
+        off64_t mOffset;
+    };
+
+    int mFd;
+    off64_t mOffset;            // file offset of the next byte to write()
+    Buffer *mCurrentBuffer;     // being filled by write(); owned by the producer
+
+    // Only used by the I/O thread
+    off64_t mPreallocatedEnd;
+    bool mCanPreallocate;
+
+    Mutex mLock;
+    Condition mCondition;
+    Buffer mBuffers[kNumBuffers];
+    List<Buffer *> mFreeBuffers;
+    List<Buffer *> mQueuedBuffers;
+    bool mWriting;
+    bool mDone;
+    status_t mError;
+    pthread_t mThread;
+
+    void queueCurrentBuffer();
+    status_t writeBuffer(const Buffer *buffer);
+    static void *ThreadWrapper(void *me);
+    void threadFunc();
+
+    AsyncWriter(const AsyncWriter &);
+    AsyncWriter &operator=(const AsyncWriter &);
+};
+
+MPEG4Writer::AsyncWriter::AsyncWriter(int fd, off64_t offset)
+    : mFd(fd),
+      mOffset(offset),
+      mCurrentBuffer(NULL),
+      mPreallocatedEnd(offset),
+      mCanPreallocate(true),
+      mWriting(false),
+      mDone(false),
+      mError(OK) {
+    for (size_t i = 0; i < kNumBuffers; ++i) {
+        void *data = NULL;
+        CHECK_EQ(posix_memalign(&data, kBufferAlignment, kBufferSize), 0);
+        mBuffers[i].mData = (uint8_t *)data;
+        mBuffers[i].mSize = 0;
+        mBuffers[i].mOffset = 0;
+        mFreeBuffers.push_back(&mBuffers[i]);
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+    pthread_create(&mThread, &attr, ThreadWrapper, this);
+    pthread_attr_destroy(&attr);
+}
+
+MPEG4Writer::AsyncWriter::~AsyncWriter() {
+    flush();
+
+    {
+        Mutex::Autolock autoLock(mLock);
+        mDone = true;
+        mCondition.broadcast();
+    }
+
+    void *dummy;
+    pthread_join(mThread, &dummy);
+
+    for (size_t i = 0; i < kNumBuffers; ++i) {
+        free(mBuffers[i].mData);
+    }
+}
+
+void MPEG4Writer::AsyncWriter::write(const void *data, size_t size) {
+    const uint8_t *src = (const uint8_t *)data;
+    while (size > 0) {
+        if (mCurrentBuffer == NULL) {
+            Mutex::Autolock autoLock(mLock);
+            if (mFreeBuffers.empty()) {
+                ALOGV("all %d I/O buffers are waiting for storage", kNumBuffers);
+                do {
+                    mCondition.wait(mLock);
+                } while (mFreeBuffers.empty());
+            }
+            mCurrentBuffer = *mFreeBuffers.begin();
+            mFreeBuffers.erase(mFreeBuffers.begin());
+            mCurrentBuffer->mSize = 0;
+            mCurrentBuffer->mOffset = mOffset;
+        }
+
+        size_t n = std::min(size, kBufferSize - mCurrentBuffer->mSize);
+        memcpy(mCurrentBuffer->mData + mCurrentBuffer->mSize, src, n);
+        mCurrentBuffer->mSize += n;
+        mOffset += n;
+        src += n;
+        size -= n;
+
+        if (mCurrentBuffer->mSize == kBufferSize) {
+            queueCurrentBuffer();
+        }
+    }
+}
+
+void MPEG4Writer::AsyncWriter::queueCurrentBuffer() {
+    Mutex::Autolock autoLock(mLock);
+    mQueuedBuffers.push_back(mCurrentBuffer);
+    mCurrentBuffer = NULL;
+    mCondition.broadcast();
+}
+
+status_t MPEG4Writer::AsyncWriter::flush() {
+    if (mCurrentBuffer != NULL) {
+        if (mCurrentBuffer->mSize > 0) {
+            queueCurrentBuffer();
+        } else {
+            Mutex::Autolock autoLock(mLock);
+            mFreeBuffers.push_back(mCurrentBuffer);
+            mCurrentBuffer = NULL;
+        }
+    }
+
+    Mutex::Autolock autoLock(mLock);
+    while (!mQueuedBuffers.empty() || mWriting) {
+        mCondition.wait(mLock);
+    }
+    return mError;
+}
+
+status_t MPEG4Writer::AsyncWriter::writeBuffer(const Buffer *buffer) {
+    off64_t end = buffer->mOffset + buffer->mSize;
+    if (mCanPreallocate && end > mPreallocatedEnd) {
+        // Reserving space ahead keeps the file contiguous and moves block
+        // allocation out of the write path. It does not change the file size.
+        if (fallocate64(mFd, FALLOC_FL_KEEP_SIZE, mPreallocatedEnd,
+                end - mPreallocatedEnd + kPreallocateBytes) == 0) {
+            mPreallocatedEnd = end + kPreallocateBytes;
+        } else {
+            ALOGV("fallocate not supported: %s", strerror(errno));
+            mCanPreallocate = false;
+        }
+    }
+
+    const uint8_t *data = buffer->mData;
+    size_t size = buffer->mSize;
+    off64_t offset = buffer->mOffset;
+    while (size > 0) {
+        ssize_t n = pwrite64(mFd, data, size, offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ALOGE("failed to write %zu bytes at %lld: %s",
+                    size, (long long)offset, strerror(errno));
+            return -errno;
+        }
+        data += n;
+        size -= n;
+        offset += n;
+    }
+    return OK;
+}
+
+// static
+void *MPEG4Writer::AsyncWriter::ThreadWrapper(void *me) {
+    static_cast<AsyncWriter *>(me)->threadFunc();
+    return NULL;
+}
+
+void MPEG4Writer::AsyncWriter::threadFunc() {
+    prctl(PR_SET_NAME, (unsigned long)"MPEG4WriterIO", 0, 0, 0);
+
+    Mutex::Autolock autoLock(mLock);
+    for (;;) {
+        while (!mDone && mQueuedBuffers.empty()) {
+            mCondition.wait(mLock);
+        }
+        if (mQueuedBuffers.empty()) {
+            break;
+        }
+
+        Buffer *buffer = *mQueuedBuffers.begin();
+        mQueuedBuffers.erase(mQueuedBuffers.begin());
+        mWriting = true;
+
+        mLock.unlock();
+        status_t err = writeBuffer(buffer);
+        mLock.lock();
+
+        if (err != OK && mError == OK) {
+            mError = err;
+        }
+        mWriting = false;
+        mFreeBuffers.push_back(buffer);
+        mCondition.broadcast();
+    }
+}
+
 MPEG4Writer::MPEG4Writer(int fd) {
     initInternal(fd);
 }
@@ -464,6 +690,7 @@ void MPEG4Writer::initInternal(int fd) {
     mStarted = false;
     mWriterThreadStarted = false;
     mSendNotify = false;
+    mAsyncWriter = NULL;
     mOffset = 0;
     mMdatOffset = 0;
     mMoovBoxBuffer = NULL;
@@ -904,6 +1131,10 @@ void MPEG4Writer::stopWriterThread() {
     void *dummy;
     pthread_join(mThread, &dummy);
     mWriterThreadStarted = false;
+
+    // The writer thread flushed it on exit.
+    delete mAsyncWriter;
+    mAsyncWriter = NULL;
     ALOGD("Writer thread stopped");
 }
 
@@ -1224,10 +1455,18 @@ void MPEG4Writer::unlock() {
     mLock.unlock();
 }
 
+void MPEG4Writer::writeSampleData_l(const void *data, size_t size) {
+    if (mAsyncWriter != NULL) {
+        mAsyncWriter->write(data, size);
+    } else {
+        ::write(mFd, data, size);
+    }
+}
+
 off64_t MPEG4Writer::addSample_l(MediaBuffer *buffer) {
     off64_t old_offset = mOffset;
 
-    ::write(mFd,
+    writeSampleData_l(
           (const uint8_t *)buffer->data() + buffer->range_offset(),
           buffer->range_length());
 
@@ -1287,16 +1526,14 @@ off64_t MPEG4Writer::addLengthPrefixedSample_l(MediaBuffer *buffer) {
     size_t length = buffer->range_length();
 
     if (mUse4ByteNalLength) {
-        uint8_t x = length >> 24;
-        ::write(mFd, &x, 1);
-        x = (length >> 16) & 0xff;
-        ::write(mFd, &x, 1);
-        x = (length >> 8) & 0xff;
-        ::write(mFd, &x, 1);
-        x = length & 0xff;
-        ::write(mFd, &x, 1);
-
-        ::write(mFd,
+        uint8_t x[4];
+        x[0] = length >> 24;
+        x[1] = (length >> 16) & 0xff;
+        x[2] = (length >> 8) & 0xff;
+        x[3] = length & 0xff;
+        writeSampleData_l(x, 4);
+
+        writeSampleData_l(
               (const uint8_t *)buffer->data() + buffer->range_offset(),
               length);
 
@@ -1304,11 +1541,11 @@ off64_t MPEG4Writer::addLengthPrefixedSample_l(MediaBuffer *buffer) {
     } else {
         CHECK_LT(length, 65536u);
 
-        uint8_t x = length >> 8;
-        ::write(mFd, &x, 1);
-        x = length & 0xff;
-        ::write(mFd, &x, 1);
-        ::write(mFd, (const uint8_t *)buffer->data() + buffer->range_offset(), length);
+        uint8_t x[2];
+        x[0] = length >> 8;
+        x[1] = length & 0xff;
+        writeSampleData_l(x, 2);
+        writeSampleData_l((const uint8_t *)buffer->data() + buffer->range_offset(), length);
         mOffset += length + 2;
     }
 
@@ -2053,6 +2290,11 @@ void MPEG4Writer::threadFunc() {
     }
 
     writeAllChunks();
+
+    // reset() writes the remaining boxes with plain writes after this.
+    if (mAsyncWriter != NULL && mAsyncWriter->flush() != OK) {
+        ALOGE("sample data was not completely written");
+    }
 }
 
 status_t MPEG4Writer::startWriterThread() {
@@ -2061,6 +2303,8 @@ status_t MPEG4Writer::startWriterThread() {
     mDone = false;
     mIsFirstChunk = true;
     mDriftTimeUs = 0;
+    // Everything from here until the writer thread stops is 'mdat' payload.
+    mAsyncWriter = new AsyncWriter(mFd, mOffset);
     for (List<Track *>::iterator it = mTracks.begin();
          it != mTracks.end(); ++it) {
         ChunkInfo info;
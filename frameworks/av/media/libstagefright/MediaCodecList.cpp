@@ -21,6 +21,7 @@
 #include "MediaCodecListOverrides.h"
 
 #include <binder/IServiceManager.h>
+#include <binder/Parcel.h>
 
 #include <media/IMediaCodecList.h>
 #include <media/IMediaPlayerService.h>
@@ -36,7 +37,10 @@
 #include <media/stagefright/MediaErrors.h>
 #include <media/stagefright/OMXClient.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <utils/threads.h>
 
 #include <cutils/properties.h>
@@ -196,15 +200,216 @@ MediaCodecList::MediaCodecList()
     : mInitCheck(NO_INIT),
       mUpdate(false),
       mGlobalSettings(new AMessage()) {
+    AString codecsXml;
+    AString performanceXml;
     char config_file_path[MEDIA_CODECS_CONFIG_FILE_PATH_MAX_LENGTH];
     if (findMediaCodecListFileFullPath("media_codecs.xml", config_file_path)) {
-        parseTopLevelXMLFile(config_file_path);
+        codecsXml = config_file_path;
     }
     if (findMediaCodecListFileFullPath("media_codecs_performance.xml",
                                        config_file_path)) {
-        parseTopLevelXMLFile(config_file_path, true/* ignore_errors */);
+        performanceXml = config_file_path;
+    }
+
+    if (loadCache(codecsXml, performanceXml)) {
+        configureResourcePolicies();
+        return;
+    }
+
+    if (!codecsXml.empty()) {
+        parseTopLevelXMLFile(codecsXml.c_str());
+    }
+    if (!performanceXml.empty()) {
+        parseTopLevelXMLFile(performanceXml.c_str(), true/* ignore_errors */);
     }
     parseTopLevelXMLFile(kProfilingResults, true/* ignore_errors */);
+
+    if (mInitCheck == OK && !mCodecInfos.isEmpty()) {
+        saveCache(codecsXml, performanceXml);
+    }
+}
+
+// The resolved codec list is persisted so that later processes can skip the
+// XML parse and the OMX round trips. The cache is only used when the build
+// fingerprints, the set of top-level XML files and the size/mtime of every
+// XML file that went into it are unchanged. Layout:
+//   CacheHeader | Parcel payload
+static const char *kCodecListCacheFile = "/data/misc/media/media_codecs_cache.bin";
+static const uint32_t kCodecListCacheMagic = 0x4d434c43;  // 'MCLC'
+static const uint32_t kCodecListCacheVersion = 1;
+
+struct CacheHeader {
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint64_t mPayloadSize;
+    uint64_t mPayloadHash;
+};
+
+// 64-bit FNV-1a
+static uint64_t hashBytes(const uint8_t *data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static AString getBuildFingerprint() {
+    char value[PROPERTY_VALUE_MAX];
+    property_get("ro.build.fingerprint", value, "");
+    AString fingerprint = value;
+    fingerprint.append("|");
+    property_get("ro.vendor.build.fingerprint", value, "");
+    fingerprint.append(value);
+    return fingerprint;
+}
+
+// size is -1 for files that could not be stat'ed
+static void statConfigFile(const char *path, int64_t *size, int64_t *modifiedNs) {
+    struct stat file_stat;
+    if (stat(path, &file_stat) != 0) {
+        *size = -1;
+        *modifiedNs = 0;
+        return;
+    }
+    *size = file_stat.st_size;
+    *modifiedNs = file_stat.st_mtim.tv_sec * 1000000000ll + file_stat.st_mtim.tv_nsec;
+}
+
+bool MediaCodecList::loadCache(const AString &codecsXml, const AString &performanceXml) {
+    int fd = open(kCodecListCacheFile, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0
+            || file_stat.st_size < (off_t)sizeof(CacheHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t fileSize = file_stat.st_size;
+    void *addr = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    CacheHeader header;
+    memcpy(&header, addr, sizeof(header));
+    const uint8_t *payload = (const uint8_t *)addr + sizeof(header);
+    if (header.mMagic != kCodecListCacheMagic
+            || header.mVersion != kCodecListCacheVersion
+            || header.mPayloadSize != fileSize - sizeof(header)
+            || header.mPayloadHash != hashBytes(payload, header.mPayloadSize)) {
+        ALOGW("ignoring invalid codec list cache %s", kCodecListCacheFile);
+        munmap(addr, fileSize);
+        return false;
+    }
+
+    Parcel parcel;
+    status_t err = parcel.setData(payload, header.mPayloadSize);
+    munmap(addr, fileSize);
+    if (err != OK) {
+        return false;
+    }
+
+    if (AString::FromParcel(parcel) != getBuildFingerprint()
+            || AString::FromParcel(parcel) != codecsXml
+            || AString::FromParcel(parcel) != performanceXml) {
+        ALOGV("codec list cache is stale");
+        return false;
+    }
+
+    Vector<ConfigFile> configFiles;
+    size_t numFiles = parcel.readInt32();
+    for (size_t i = 0; i < numFiles; ++i) {
+        ConfigFile file;
+        file.mPath = AString::FromParcel(parcel);
+        file.mSize = parcel.readInt64();
+        file.mModifiedNs = parcel.readInt64();
+        if (parcel.dataAvail() == 0) {
+            return false;
+        }
+
+        int64_t size, modifiedNs;
+        statConfigFile(file.mPath.c_str(), &size, &modifiedNs);
+        if (size != file.mSize || (size >= 0 && modifiedNs != file.mModifiedNs)) {
+            ALOGV("codec list cache is stale: %s changed", file.mPath.c_str());
+            return false;
+        }
+        configFiles.push_back(file);
+    }
+
+    sp<AMessage> globalSettings = AMessage::FromParcel(parcel);
+    if (globalSettings == NULL) {
+        return false;
+    }
+
+    Vector<sp<MediaCodecInfo> > codecInfos;
+    size_t numCodecs = parcel.readInt32();
+    for (size_t i = 0; i < numCodecs && parcel.dataAvail() > 0; ++i) {
+        sp<MediaCodecInfo> info = MediaCodecInfo::FromParcel(parcel);
+        if (info == NULL) {
+            break;
+        }
+        codecInfos.push_back(info);
+    }
+    if (codecInfos.size() != numCodecs) {
+        return false;
+    }
+
+    mConfigFiles = configFiles;
+    mGlobalSettings = globalSettings;
+    mCodecInfos = codecInfos;
+    mInitCheck = OK;
+    ALOGV("loaded %zu codecs from %s", numCodecs, kCodecListCacheFile);
+    return true;
+}
+
+void MediaCodecList::saveCache(
+        const AString &codecsXml, const AString &performanceXml) const {
+    Parcel parcel;
+    getBuildFingerprint().writeToParcel(&parcel);
+    codecsXml.writeToParcel(&parcel);
+    performanceXml.writeToParcel(&parcel);
+    parcel.writeInt32(mConfigFiles.size());
+    for (size_t i = 0; i < mConfigFiles.size(); ++i) {
+        const ConfigFile &file = mConfigFiles.itemAt(i);
+        file.mPath.writeToParcel(&parcel);
+        parcel.writeInt64(file.mSize);
+        parcel.writeInt64(file.mModifiedNs);
+    }
+    mGlobalSettings->writeToParcel(&parcel);
+    parcel.writeInt32(mCodecInfos.size());
+    for (size_t i = 0; i < mCodecInfos.size(); ++i) {
+        mCodecInfos.itemAt(i)->writeToParcel(&parcel);
+    }
+
+    CacheHeader header;
+    header.mMagic = kCodecListCacheMagic;
+    header.mVersion = kCodecListCacheVersion;
+    header.mPayloadSize = parcel.dataSize();
+    header.mPayloadHash = hashBytes(parcel.data(), parcel.dataSize());
+
+    // write to a temporary file and rename so that readers never see a
+    // partially written cache
+    AString tmpPath = kCodecListCacheFile;
+    tmpPath.append(".tmp");
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ALOGV("cannot create codec list cache: %s", strerror(errno));
+        return;
+    }
+    bool written =
+        write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header)
+        && write(fd, parcel.data(), parcel.dataSize()) == (ssize_t)parcel.dataSize();
+    close(fd);
+    if (!written || rename(tmpPath.c_str(), kCodecListCacheFile) != 0) {
+        ALOGW("failed to write codec list cache %s", kCodecListCacheFile);
+        unlink(tmpPath.c_str());
+    }
 }
 
 void MediaCodecList::parseTopLevelXMLFile(const char *codecs_xml, bool ignore_errors) {
@@ -234,30 +439,7 @@ void MediaCodecList::parseTopLevelXMLFile(const char *codecs_xml, bool ignore_er
         return;
     }
 
-    Vector<MediaResourcePolicy> policies;
-    AString value;
-    if (mGlobalSettings->findString(kPolicySupportsMultipleSecureCodecs, &value)) {
-        policies.push_back(
-                MediaResourcePolicy(
-                        String8(kPolicySupportsMultipleSecureCodecs),
-                        String8(value.c_str())));
-    }
-    if (mGlobalSettings->findString(kPolicySupportsSecureWithNonSecureCodec, &value)) {
-        policies.push_back(
-                MediaResourcePolicy(
-                        String8(kPolicySupportsSecureWithNonSecureCodec),
-                        String8(value.c_str())));
-    }
-    if (policies.size() > 0) {
-        sp<IServiceManager> sm = defaultServiceManager();
-        sp<IBinder> binder = sm->getService(String16("media.resource_manager"));
-        sp<IResourceManagerService> service = interface_cast<IResourceManagerService>(binder);
-        if (service == NULL) {
-            ALOGE("MediaCodecList: failed to get ResourceManagerService");
-        } else {
-            service->config(policies);
-        }
-    }
+    configureResourcePolicies();
 
     for (size_t i = mCodecInfos.size(); i > 0;) {
         i--;
@@ -340,6 +522,33 @@ void MediaCodecList::parseTopLevelXMLFile(const char *codecs_xml, bool ignore_er
 #endif
 }
 
+void MediaCodecList::configureResourcePolicies() {
+    Vector<MediaResourcePolicy> policies;
+    AString value;
+    if (mGlobalSettings->findString(kPolicySupportsMultipleSecureCodecs, &value)) {
+        policies.push_back(
+                MediaResourcePolicy(
+                        String8(kPolicySupportsMultipleSecureCodecs),
+                        String8(value.c_str())));
+    }
+    if (mGlobalSettings->findString(kPolicySupportsSecureWithNonSecureCodec, &value)) {
+        policies.push_back(
+                MediaResourcePolicy(
+                        String8(kPolicySupportsSecureWithNonSecureCodec),
+                        String8(value.c_str())));
+    }
+    if (policies.size() > 0) {
+        sp<IServiceManager> sm = defaultServiceManager();
+        sp<IBinder> binder = sm->getService(String16("media.resource_manager"));
+        sp<IResourceManagerService> service = interface_cast<IResourceManagerService>(binder);
+        if (service == NULL) {
+            ALOGE("MediaCodecList: failed to get ResourceManagerService");
+        } else {
+            service->config(policies);
+        }
+    }
+}
+
 MediaCodecList::~MediaCodecList() {
 }
 
@@ -348,6 +557,11 @@ status_t MediaCodecList::initCheck() const {
 }
 
 void MediaCodecList::parseXMLFile(const char *path) {
+    ConfigFile configFile;
+    configFile.mPath = path;
+    statConfigFile(path, &configFile.mSize, &configFile.mModifiedNs);
+    mConfigFiles.push_back(configFile);
+
     FILE *file = fopen(path, "r");
 
     if (file == NULL) {
@@ -44,6 +44,10 @@ struct PageCache {
 
     void appendPage(Page *page);
     size_t releaseFromStart(size_t maxBytes);
+    size_t releaseFromEnd(size_t maxBytes);
+
+    // Frees the memory of pages that are not in use.
+    void freeUnusedPages();
 
     size_t totalSize() const {
         return mTotalSize;
@@ -136,6 +140,35 @@ size_t PageCache::releaseFromStart(size_t maxBytes) {
     return bytesReleased;
 }
 
+size_t PageCache::releaseFromEnd(size_t maxBytes) {
+    size_t bytesReleased = 0;
+
+    while (maxBytes > 0 && !mActivePages.empty()) {
+        List<Page *>::iterator it = --mActivePages.end();
+
+        Page *page = *it;
+
+        if (maxBytes < page->mSize) {
+            break;
+        }
+
+        mActivePages.erase(it);
+
+        maxBytes -= page->mSize;
+        bytesReleased += page->mSize;
+
+        releasePage(page);
+    }
+
+    mTotalSize -= bytesReleased;
+    return bytesReleased;
+}
+
+void PageCache::freeUnusedPages() {
+    freePages(&mFreePages);
+    mFreePages.clear();
+}
+
 void PageCache::copy(size_t from, void *data, size_t size) {
     ALOGV("copy from %zu size %zu", from, size);
 
@@ -188,6 +221,8 @@ NuCachedSource2::NuCachedSource2(
       mLooper(new ALooper),
       mCache(new PageCache(kPageSize)),
       mCacheOffset(0),
+      mPagesPerFetch(1),
+      mFetchBytesPerSec(0),
       mFinalStatus(OK),
       mLastAccessPos(0),
       mFetching(true),
@@ -234,6 +269,12 @@ NuCachedSource2::~NuCachedSource2() {
 
     delete mCache;
     mCache = NULL;
+
+    for (List<CachedRegion>::iterator it = mRetainedRegions.begin();
+            it != mRetainedRegions.end(); ++it) {
+        delete (*it).mCache;
+    }
+    mRetainedRegions.clear();
 }
 
 // static
@@ -322,6 +363,7 @@ void NuCachedSource2::fetchInternal() {
     ALOGV("fetchInternal");
 
     bool reconnect = false;
+    size_t numPages;
 
     {
         Mutex::Autolock autoLock(mLock);
@@ -332,6 +374,15 @@ void NuCachedSource2::fetchInternal() {
 
             reconnect = true;
         }
+
+        // Don't read far past the high watermark in one go.
+        numPages = mPagesPerFetch;
+        size_t totalSize = mCache->totalSize();
+        if (totalSize + numPages * kPageSize > mHighwaterThresholdBytes) {
+            numPages = totalSize < mHighwaterThresholdBytes
+                    ? (mHighwaterThresholdBytes - totalSize + kPageSize - 1) / kPageSize
+                    : 1;
+        }
     }
 
     if (reconnect) {
@@ -357,20 +408,67 @@ void NuCachedSource2::fetchInternal() {
         }
     }
 
-    PageCache::Page *page = mCache->acquirePage();
+    off64_t offset = mCacheOffset + mCache->totalSize();
+    List<PageCache::Page *> pages;
+    size_t bytesRead = 0;
+    ssize_t n = 0;
+    int64_t startUs = ALooper::GetNowUs();
+
+    for (size_t i = 0; i < numPages; ++i) {
+        PageCache::Page *page = mCache->acquirePage();
 
-    ssize_t n = mSource->readAt(
-            mCacheOffset + mCache->totalSize(), page->mData, kPageSize);
+        n = mSource->readAt(offset + bytesRead, page->mData, kPageSize);
+
+        if (n <= 0) {
+            mCache->releasePage(page);
+            break;
+        }
+
+        page->mSize = n;
+        pages.push_back(page);
+        bytesRead += n;
+
+        if ((size_t)n < kPageSize) {
+            break;
+        }
+
+        Mutex::Autolock autoLock(mLock);
+        if (mDisconnecting) {
+            break;
+        }
+    }
 
     Mutex::Autolock autoLock(mLock);
 
-    if (n == 0 || mDisconnecting) {
+    if (mDisconnecting) {
+        n = 0;
+        while (!pages.empty()) {
+            mCache->releasePage(*pages.begin());
+            pages.erase(pages.begin());
+        }
+        bytesRead = 0;
+    }
+
+    if (bytesRead > 0) {
+        if (mFinalStatus != OK) {
+            ALOGI("retrying a previously failed read succeeded.");
+        }
+        mNumRetriesLeft = kMaxNumRetries;
+        mFinalStatus = OK;
+
+        for (List<PageCache::Page *>::iterator it = pages.begin();
+                it != pages.end(); ++it) {
+            mCache->appendPage(*it);
+        }
+
+        updateFetchSize_l(bytesRead, ALooper::GetNowUs() - startUs);
+    }
+
+    if (n == 0) {
         ALOGI("caching reached eos.");
 
         mNumRetriesLeft = 0;
         mFinalStatus = ERROR_END_OF_STREAM;
-
-        mCache->releasePage(page);
     } else if (n < 0) {
         mFinalStatus = n;
         if (n == ERROR_UNSUPPORTED || n == -EPIPE) {
@@ -380,16 +478,32 @@ void NuCachedSource2::fetchInternal() {
         }
 
         ALOGE("source returned error %zd, %d retries left", n, mNumRetriesLeft);
-        mCache->releasePage(page);
+    }
+}
+
+void NuCachedSource2::updateFetchSize_l(size_t bytesRead, int64_t durationUs) {
+    if (durationUs <= 0) {
+        durationUs = 1;
+    }
+
+    int64_t bytesPerSec = (int64_t)bytesRead * 1000000ll / durationUs;
+    if (mFetchBytesPerSec == 0) {
+        mFetchBytesPerSec = bytesPerSec;
     } else {
-        if (mFinalStatus != OK) {
-            ALOGI("retrying a previously failed read succeeded.");
-        }
-        mNumRetriesLeft = kMaxNumRetries;
-        mFinalStatus = OK;
+        mFetchBytesPerSec = (3 * mFetchBytesPerSec + bytesPerSec) / 4;
+    }
 
-        page->mSize = n;
-        mCache->appendPage(page);
+    int64_t numPages = mFetchBytesPerSec * kTargetFetchDurationUs / 1000000ll / kPageSize;
+    if (numPages < 1) {
+        numPages = 1;
+    } else if (numPages > kMaxPagesPerFetch) {
+        numPages = kMaxPagesPerFetch;
+    }
+
+    if ((size_t)numPages != mPagesPerFetch) {
+        ALOGV("fetching %lld pages at a time (%lld bytes/sec)",
+                (long long)numPages, (long long)mFetchBytesPerSec);
+        mPagesPerFetch = numPages;
     }
 }
 
@@ -533,6 +647,18 @@ ssize_t NuCachedSource2::readAt(off64_t offset, void *data, size_t size) {
         return size;
     }
 
+    // Ranges kept from before a seek are served as they are; they don't
+    // affect the read position of the active range.
+    for (List<CachedRegion>::iterator it = mRetainedRegions.begin();
+            it != mRetainedRegions.end(); ++it) {
+        const CachedRegion &region = *it;
+        if (offset >= region.mOffset
+                && offset + size <= region.mOffset + region.mCache->totalSize()) {
+            region.mCache->copy(offset - region.mOffset, data, size);
+            return size;
+        }
+    }
+
     sp<AMessage> msg = new AMessage(kWhatRead, mReflector);
     msg->setInt64("offset", offset);
     msg->setPointer("data", data);
@@ -601,15 +727,9 @@ ssize_t NuCachedSource2::readInternal(off64_t offset, void *data, size_t size) {
         return ERROR_END_OF_STREAM;
     }
 
-    if (!mFetching) {
-        mLastAccessPos = offset;
-        restartPrefetcherIfNecessary_l(
-                false, // ignoreLowWaterThreshold
-                true); // force
-    }
-
-    if (offset < mCacheOffset
-            || offset >= (off64_t)(mCacheOffset + mCache->totalSize())) {
+    if ((offset < mCacheOffset
+            || offset >= (off64_t)(mCacheOffset + mCache->totalSize()))
+            && !switchToRetainedRegion_l(offset)) {
         static const off64_t kPadding = 256 * 1024;
 
         // In the presence of multiple decoded streams, once of them will
@@ -621,6 +741,13 @@ ssize_t NuCachedSource2::readInternal(off64_t offset, void *data, size_t size) {
         seekInternal_l(seekOffset);
     }
 
+    if (!mFetching) {
+        mLastAccessPos = offset;
+        restartPrefetcherIfNecessary_l(
+                false, // ignoreLowWaterThreshold
+                true); // force
+    }
+
     size_t delta = offset - mCacheOffset;
 
     if (mFinalStatus != OK && mNumRetriesLeft == 0) {
@@ -651,19 +778,22 @@ ssize_t NuCachedSource2::readInternal(off64_t offset, void *data, size_t size) {
 }
 
 status_t NuCachedSource2::seekInternal_l(off64_t offset) {
-    mLastAccessPos = offset;
-
     if (offset >= mCacheOffset
             && offset <= (off64_t)(mCacheOffset + mCache->totalSize())) {
+        mLastAccessPos = offset;
+        return OK;
+    }
+
+    if (switchToRetainedRegion_l(offset)) {
         return OK;
     }
 
     ALOGI("new range: offset= %lld", (long long)offset);
 
+    retainActiveRegion_l();
+    mCache = new PageCache(kPageSize);
     mCacheOffset = offset;
-
-    size_t totalSize = mCache->totalSize();
-    CHECK_EQ(mCache->releaseFromStart(totalSize), totalSize);
+    mLastAccessPos = offset;
 
     mNumRetriesLeft = kMaxNumRetries;
     mFetching = true;
@@ -671,6 +801,66 @@ status_t NuCachedSource2::seekInternal_l(off64_t offset) {
     return OK;
 }
 
+// Moves the active range to the front of mRetainedRegions, keeping only the
+// part around the last read position. mCache must be replaced afterwards.
+void NuCachedSource2::retainActiveRegion_l() {
+    PageCache *cache = mCache;
+    off64_t offset = mCacheOffset;
+    mCache = NULL;
+
+    if (mLastAccessPos > offset + kRetainedRegionLeadBytes) {
+        offset += cache->releaseFromStart(mLastAccessPos - kRetainedRegionLeadBytes - offset);
+    }
+    if (cache->totalSize() > kMaxRetainedRegionBytes) {
+        cache->releaseFromEnd(cache->totalSize() - kMaxRetainedRegionBytes);
+    }
+    cache->freeUnusedPages();
+
+    if (cache->totalSize() == 0) {
+        delete cache;
+        return;
+    }
+
+    CachedRegion region;
+    region.mOffset = offset;
+    region.mCache = cache;
+    mRetainedRegions.push_front(region);
+
+    while (mRetainedRegions.size() > kMaxNumRetainedRegions) {
+        List<CachedRegion>::iterator it = --mRetainedRegions.end();
+        delete (*it).mCache;
+        mRetainedRegions.erase(it);
+    }
+}
+
+// If a retained range contains offset, makes it the active range again and
+// resumes fetching from its end.
+bool NuCachedSource2::switchToRetainedRegion_l(off64_t offset) {
+    for (List<CachedRegion>::iterator it = mRetainedRegions.begin();
+            it != mRetainedRegions.end(); ++it) {
+        CachedRegion region = *it;
+        if (offset < region.mOffset
+                || offset > (off64_t)(region.mOffset + region.mCache->totalSize())) {
+            continue;
+        }
+
+        ALOGI("back to cached range: offset= %lld", (long long)region.mOffset);
+
+        mRetainedRegions.erase(it);
+        retainActiveRegion_l();
+        mCache = region.mCache;
+        mCacheOffset = region.mOffset;
+        mLastAccessPos = offset;
+
+        mNumRetriesLeft = kMaxNumRetries;
+        mFetching = true;
+
+        return true;
+    }
+
+    return false;
+}
+
 void NuCachedSource2::resumeFetchingIfNecessary() {
     Mutex::Autolock autoLock(mLock);
 
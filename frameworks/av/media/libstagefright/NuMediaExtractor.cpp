@@ -370,6 +370,7 @@ status_t NuMediaExtractor::unselectTrack(size_t index) {
 
         info->mSampleTimeUs = -1ll;
     }
+    releaseReadAheadSamples(info);
 
     CHECK_EQ((status_t)OK, info->mSource->stop());
 
@@ -388,9 +389,49 @@ void NuMediaExtractor::releaseTrackSamples() {
 
             info->mSampleTimeUs = -1ll;
         }
+        releaseReadAheadSamples(info);
     }
 }
 
+// static
+void NuMediaExtractor::releaseReadAheadSamples(TrackInfo *info) {
+    for (MediaBuffer *sample : info->mReadAheadSamples) {
+        sample->release();
+    }
+    info->mReadAheadSamples.clear();
+}
+
+status_t NuMediaExtractor::readTrackSample(
+        TrackInfo *info, MediaSource::ReadOptions *options) {
+    if (!info->mReadAheadSamples.empty()) {
+        info->mSample = *info->mReadAheadSamples.begin();
+        info->mReadAheadSamples.erase(info->mReadAheadSamples.begin());
+        return OK;
+    }
+
+    // A remote source delivers up to kMaxReadAheadSamples samples per binder
+    // transaction. The read must not block: the source may run out of buffers
+    // while we hold on to the samples read ahead.
+    if (info->mSource->supportReadMultiple()) {
+        Vector<MediaBuffer *> samples;
+        options->setNonBlocking();
+        status_t err = info->mSource->readMultiple(&samples, kMaxReadAheadSamples, options);
+        options->clearNonBlocking();
+        if (!samples.isEmpty()) {
+            info->mSample = samples[0];
+            for (size_t i = 1; i < samples.size(); ++i) {
+                info->mReadAheadSamples.push_back(samples[i]);
+            }
+            return OK;
+        }
+        if (err != WOULD_BLOCK) {
+            return err;
+        }
+    }
+
+    return info->mSource->read(&info->mSample, options);
+}
+
 ssize_t NuMediaExtractor::fetchTrackSamples(
         int64_t seekTimeUs, MediaSource::ReadOptions::SeekMode mode) {
     TrackInfo *minInfo = NULL;
@@ -407,6 +448,7 @@ ssize_t NuMediaExtractor::fetchTrackSamples(
                 info->mSample = NULL;
                 info->mSampleTimeUs = -1ll;
             }
+            releaseReadAheadSamples(info);
         } else if (info->mFinalResult != OK) {
             continue;
         }
@@ -416,7 +458,7 @@ ssize_t NuMediaExtractor::fetchTrackSamples(
             if (seekTimeUs >= 0ll) {
                 options.setSeekTo(seekTimeUs, mode);
             }
-            status_t err = info->mSource->read(&info->mSample, &options);
+            status_t err = readTrackSample(info, &options);
 
             if (err != OK) {
                 CHECK(info->mSample == NULL);
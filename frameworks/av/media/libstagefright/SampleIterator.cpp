@@ -203,7 +203,7 @@ status_t SampleIterator::getChunkOffset(uint32_t chunk, off64_t *offset) {
     if (mTable->mChunkOffsetType == SampleTable::kChunkOffsetType32) {
         uint32_t offset32;
 
-        if (mTable->mDataSource->readAt(
+        if (mTable->readTableData_l(
                     mTable->mChunkOffsetOffset + 8 + 4 * chunk,
                     &offset32,
                     sizeof(offset32)) < (ssize_t)sizeof(offset32)) {
@@ -215,7 +215,7 @@ status_t SampleIterator::getChunkOffset(uint32_t chunk, off64_t *offset) {
         CHECK_EQ(mTable->mChunkOffsetType, SampleTable::kChunkOffsetType64);
 
         uint64_t offset64;
-        if (mTable->mDataSource->readAt(
+        if (mTable->readTableData_l(
                     mTable->mChunkOffsetOffset + 8 + 8 * chunk,
                     &offset64,
                     sizeof(offset64)) < (ssize_t)sizeof(offset64)) {
@@ -244,7 +244,7 @@ status_t SampleIterator::getSampleSizeDirect(
     switch (mTable->mSampleSizeFieldSize) {
         case 32:
         {
-            if (mTable->mDataSource->readAt(
+            if (mTable->readTableData_l(
                         mTable->mSampleSizeOffset + 12 + 4 * sampleIndex,
                         size, sizeof(*size)) < (ssize_t)sizeof(*size)) {
                 return ERROR_IO;
@@ -257,7 +257,7 @@ status_t SampleIterator::getSampleSizeDirect(
         case 16:
         {
             uint16_t x;
-            if (mTable->mDataSource->readAt(
+            if (mTable->readTableData_l(
                         mTable->mSampleSizeOffset + 12 + 2 * sampleIndex,
                         &x, sizeof(x)) < (ssize_t)sizeof(x)) {
                 return ERROR_IO;
@@ -270,7 +270,7 @@ status_t SampleIterator::getSampleSizeDirect(
         case 8:
         {
             uint8_t x;
-            if (mTable->mDataSource->readAt(
+            if (mTable->readTableData_l(
                         mTable->mSampleSizeOffset + 12 + sampleIndex,
                         &x, sizeof(x)) < (ssize_t)sizeof(x)) {
                 return ERROR_IO;
@@ -285,7 +285,7 @@ status_t SampleIterator::getSampleSizeDirect(
             CHECK_EQ(mTable->mSampleSizeFieldSize, 4u);
 
             uint8_t x;
-            if (mTable->mDataSource->readAt(
+            if (mTable->readTableData_l(
                         mTable->mSampleSizeOffset + 12 + sampleIndex / 2,
                         &x, sizeof(x)) < (ssize_t)sizeof(x)) {
                 return ERROR_IO;
@@ -137,7 +137,9 @@ SampleTable::SampleTable(const sp<DataSource> &source)
       mSyncSamples(NULL),
       mLastSyncSampleIndex(0),
       mSampleToChunkEntries(NULL),
-      mTotalSize(0) {
+      mTotalSize(0),
+      mTableBlocks(NULL),
+      mTableBlockUseCount(0) {
     mSampleIterator = new SampleIterator(this);
 }
 
@@ -162,6 +164,9 @@ SampleTable::~SampleTable() {
 
     delete mSampleIterator;
     mSampleIterator = NULL;
+
+    delete[] mTableBlocks;
+    mTableBlocks = NULL;
 }
 
 bool SampleTable::isValid() const {
@@ -593,6 +598,66 @@ uint32_t SampleTable::countSamples() const {
     return mNumSampleSizes;
 }
 
+ssize_t SampleTable::readTableData_l(off64_t offset, void *data, size_t size) {
+    if (mTableBlocks == NULL) {
+        mTableBlocks = new (std::nothrow) TableBlock[kNumTableBlocks];
+        if (mTableBlocks == NULL) {
+            return mDataSource->readAt(offset, data, size);
+        }
+        for (size_t i = 0; i < kNumTableBlocks; ++i) {
+            mTableBlocks[i].mOffset = -1;
+            mTableBlocks[i].mSize = 0;
+            mTableBlocks[i].mLastUse = 0;
+        }
+    }
+
+    uint8_t *dst = (uint8_t *)data;
+    size_t copied = 0;
+    while (copied < size) {
+        const off64_t pos = offset + copied;
+        const off64_t blockOffset = pos - pos % kTableBlockSize;
+
+        TableBlock *block = NULL;
+        TableBlock *victim = &mTableBlocks[0];
+        for (size_t i = 0; i < kNumTableBlocks; ++i) {
+            if (mTableBlocks[i].mOffset == blockOffset) {
+                block = &mTableBlocks[i];
+                break;
+            }
+            if (mTableBlocks[i].mLastUse < victim->mLastUse) {
+                victim = &mTableBlocks[i];
+            }
+        }
+        if (block == NULL) {
+            block = victim;
+            block->mSize = mDataSource->readAt(blockOffset, block->mData, kTableBlockSize);
+            if (block->mSize < 0) {
+                block->mOffset = -1;
+                return copied > 0 ? (ssize_t)copied : block->mSize;
+            }
+            block->mOffset = blockOffset;
+        }
+        block->mLastUse = ++mTableBlockUseCount;
+
+        const size_t inBlock = pos - blockOffset;
+        const size_t available =
+                (ssize_t)inBlock < block->mSize ? block->mSize - inBlock : 0;
+        const size_t n = size - copied < available ? size - copied : available;
+        memcpy(dst + copied, block->mData + inBlock, n);
+        copied += n;
+
+        if (block->mSize < (ssize_t)kTableBlockSize) {
+            // end of source or short read: do not keep the partial block, and return
+            // a short count if the data ends before the request does
+            block->mOffset = -1;
+            if (copied < size) {
+                break;
+            }
+        }
+    }
+    return copied;
+}
+
 status_t SampleTable::getMaxSampleSize(size_t *max_size) {
     Mutex::Autolock autoLock(mLock);
 
@@ -29,6 +29,7 @@
 #include <media/IMediaHTTPService.h>
 #include <media/MediaCodecBuffer.h>
 
+#include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/ColorConverter.h>
@@ -137,65 +138,214 @@ status_t StagefrightMetadataRetriever::setDataSource(
     return OK;
 }
 
-static VideoFrame *extractVideoFrame(
-        const AString &componentName,
-        const sp<MetaData> &trackMeta,
-        const sp<IMediaSource> &source,
-        int64_t frameTimeUs,
-        int seekMode) {
+// Decoders kept alive by the batch extraction calls. Hardware decoder
+// instances are a scarce resource, so only a couple are pooled at a time.
+static const size_t kMaxPooledDecoders = 2;
 
-    sp<MetaData> format = source->getFormat();
+static bool sameBuffer(const sp<ABuffer> &a, const sp<ABuffer> &b) {
+    if (a == NULL || b == NULL) {
+        return a == b;
+    }
+    return a->size() == b->size() && !memcmp(a->data(), b->data(), a->size());
+}
 
-    sp<AMessage> videoFormat;
-    if (convertMetaDataToMessage(trackMeta, &videoFormat) != OK) {
-        ALOGE("b/23680780");
-        ALOGW("Failed to convert meta data to message");
-        return NULL;
+// A started video decoder that can extract several frames in sequence. The
+// codec is flushed after every frame, so frames at different times of one
+// track, or of different tracks sharing the same codec configuration, are
+// all decoded by a single codec instance.
+struct ThumbnailDecoder {
+    ThumbnailDecoder(const AString &componentName, bool seekClosest);
+    ~ThumbnailDecoder();
+
+    status_t init(const sp<AMessage> &videoFormat);
+
+    bool matches(const AString &componentName, bool seekClosest,
+            const sp<AMessage> &videoFormat) const;
+
+    // |source| must have been started. Returns NULL on failure, after which
+    // the decoder must not be used any more.
+    VideoFrame *extractFrame(
+            const sp<MetaData> &trackMeta,
+            const sp<IMediaSource> &source,
+            int64_t frameTimeUs,
+            int seekMode,
+            uint32_t extractFlags,
+            int32_t maxDimension);
+
+private:
+    AString mComponentName;
+    bool mSeekClosest;
+    sp<AMessage> mVideoFormat;
+    sp<ALooper> mLooper;
+    sp<MediaCodec> mDecoder;
+    Vector<sp<MediaCodecBuffer> > mInputBuffers;
+    Vector<sp<MediaCodecBuffer> > mOutputBuffers;
+    sp<AMessage> mOutputFormat;
+    ColorConverter *mConverter;
+    int32_t mConverterFormat;
+
+    ThumbnailDecoder(const ThumbnailDecoder &);
+    ThumbnailDecoder &operator=(const ThumbnailDecoder &);
+};
+
+ThumbnailDecoder::ThumbnailDecoder(const AString &componentName, bool seekClosest)
+    : mComponentName(componentName),
+      mSeekClosest(seekClosest),
+      mConverter(NULL),
+      mConverterFormat(0) {
+}
+
+ThumbnailDecoder::~ThumbnailDecoder() {
+    mInputBuffers.clear();
+    mOutputBuffers.clear();
+    if (mDecoder != NULL) {
+        mDecoder->release();
     }
+    delete mConverter;
+    mConverter = NULL;
+}
+
+status_t ThumbnailDecoder::init(const sp<AMessage> &videoFormat) {
+    sp<AMessage> format = videoFormat->dup();
 
     // TODO: Use Flexible color instead
-    videoFormat->setInt32("color-format", OMX_COLOR_FormatYUV420Planar);
+    format->setInt32("color-format", OMX_COLOR_FormatYUV420Planar);
 
     // For the thumbnail extraction case, try to allocate single buffer in both
     // input and output ports, if seeking to a sync frame. NOTE: This request may
     // fail if component requires more than that for decoding.
-    bool isSeekingClosest = (seekMode == MediaSource::ReadOptions::SEEK_CLOSEST);
-    if (!isSeekingClosest) {
-        videoFormat->setInt32("android._num-input-buffers", 1);
-        videoFormat->setInt32("android._num-output-buffers", 1);
+    if (!mSeekClosest) {
+        format->setInt32("android._num-input-buffers", 1);
+        format->setInt32("android._num-output-buffers", 1);
     }
 
     status_t err;
-    sp<ALooper> looper = new ALooper;
-    looper->start();
-    sp<MediaCodec> decoder = MediaCodec::CreateByComponentName(
-            looper, componentName, &err);
-
-    if (decoder.get() == NULL || err != OK) {
-        ALOGW("Failed to instantiate decoder [%s]", componentName.c_str());
-        return NULL;
+    mLooper = new ALooper;
+    mLooper->start();
+    mDecoder = MediaCodec::CreateByComponentName(
+            mLooper, mComponentName, &err);
+
+    if (mDecoder.get() == NULL || err != OK) {
+        ALOGW("Failed to instantiate decoder [%s]", mComponentName.c_str());
+        mDecoder.clear();
+        return err != OK ? err : UNKNOWN_ERROR;
     }
 
-    err = decoder->configure(videoFormat, NULL /* surface */, NULL /* crypto */, 0 /* flags */);
+    err = mDecoder->configure(format, NULL /* surface */, NULL /* crypto */, 0 /* flags */);
     if (err != OK) {
         ALOGW("configure returned error %d (%s)", err, asString(err));
-        decoder->release();
-        return NULL;
+        return err;
     }
 
-    err = decoder->start();
+    err = mDecoder->start();
     if (err != OK) {
         ALOGW("start returned error %d (%s)", err, asString(err));
-        decoder->release();
-        return NULL;
+        return err;
     }
 
+    err = mDecoder->getInputBuffers(&mInputBuffers);
+    if (err != OK) {
+        ALOGW("failed to get input buffers: %d (%s)", err, asString(err));
+        return err;
+    }
+
+    err = mDecoder->getOutputBuffers(&mOutputBuffers);
+    if (err != OK) {
+        ALOGW("failed to get output buffers: %d (%s)", err, asString(err));
+        return err;
+    }
+
+    mVideoFormat = videoFormat;
+    return OK;
+}
+
+bool ThumbnailDecoder::matches(
+        const AString &componentName, bool seekClosest,
+        const sp<AMessage> &videoFormat) const {
+    if (mVideoFormat == NULL || mSeekClosest != seekClosest
+            || mComponentName != componentName) {
+        return false;
+    }
+
+    AString mime, otherMime;
+    int32_t width, height, otherWidth, otherHeight;
+    if (!mVideoFormat->findString("mime", &mime)
+            || !videoFormat->findString("mime", &otherMime)
+            || mime != otherMime
+            || !mVideoFormat->findInt32("width", &width)
+            || !videoFormat->findInt32("width", &otherWidth)
+            || width != otherWidth
+            || !mVideoFormat->findInt32("height", &height)
+            || !videoFormat->findInt32("height", &otherHeight)
+            || height != otherHeight) {
+        return false;
+    }
+
+    // The codec specific data is only submitted when the codec is started,
+    // so a decoder can only be reused for streams carrying identical data.
+    static const char *kCSDKeys[] = { "csd-0", "csd-1", "csd-2" };
+    for (size_t i = 0; i < sizeof(kCSDKeys) / sizeof(kCSDKeys[0]); ++i) {
+        sp<ABuffer> csd, otherCSD;
+        mVideoFormat->findBuffer(kCSDKeys[i], &csd);
+        videoFormat->findBuffer(kCSDKeys[i], &otherCSD);
+        if (!sameBuffer(csd, otherCSD)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Box filters an RGB565 image down to |dstWidth| x |dstHeight|.
+static void downscaleRGB565(
+        const uint16_t *src, int32_t srcWidth, int32_t srcHeight,
+        uint16_t *dst, int32_t dstWidth, int32_t dstHeight) {
+    for (int32_t y = 0; y < dstHeight; ++y) {
+        int32_t y0 = (int32_t)((int64_t)y * srcHeight / dstHeight);
+        int32_t y1 = (int32_t)((int64_t)(y + 1) * srcHeight / dstHeight);
+        if (y1 <= y0) {
+            y1 = y0 + 1;
+        }
+
+        for (int32_t x = 0; x < dstWidth; ++x) {
+            int32_t x0 = (int32_t)((int64_t)x * srcWidth / dstWidth);
+            int32_t x1 = (int32_t)((int64_t)(x + 1) * srcWidth / dstWidth);
+            if (x1 <= x0) {
+                x1 = x0 + 1;
+            }
+
+            uint32_t r = 0, g = 0, b = 0;
+            for (int32_t sy = y0; sy < y1; ++sy) {
+                const uint16_t *row = src + (size_t)sy * srcWidth;
+                for (int32_t sx = x0; sx < x1; ++sx) {
+                    uint16_t pixel = row[sx];
+                    r += pixel >> 11;
+                    g += (pixel >> 5) & 0x3f;
+                    b += pixel & 0x1f;
+                }
+            }
+
+            uint32_t count = (uint32_t)(y1 - y0) * (uint32_t)(x1 - x0);
+            dst[(size_t)y * dstWidth + x] =
+                (uint16_t)(((r / count) << 11) | ((g / count) << 5) | (b / count));
+        }
+    }
+}
+
+VideoFrame *ThumbnailDecoder::extractFrame(
+        const sp<MetaData> &trackMeta,
+        const sp<IMediaSource> &source,
+        int64_t frameTimeUs,
+        int seekMode,
+        uint32_t extractFlags,
+        int32_t maxDimension) {
+    sp<MetaData> format = source->getFormat();
+
     MediaSource::ReadOptions options;
     if (seekMode < MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC ||
         seekMode > MediaSource::ReadOptions::SEEK_CLOSEST) {
 
         ALOGE("Unknown seek mode: %d", seekMode);
-        decoder->release();
         return NULL;
     }
 
@@ -214,37 +364,6 @@ static VideoFrame *extractVideoFrame(
         options.setSeekTo(frameTimeUs, mode);
     }
 
-    err = source->start();
-    if (err != OK) {
-        ALOGW("source failed to start: %d (%s)", err, asString(err));
-        decoder->release();
-        return NULL;
-    }
-
-    Vector<sp<MediaCodecBuffer> > inputBuffers;
-    err = decoder->getInputBuffers(&inputBuffers);
-    if (err != OK) {
-        ALOGW("failed to get input buffers: %d (%s)", err, asString(err));
-        decoder->release();
-        source->stop();
-        return NULL;
-    }
-
-    Vector<sp<MediaCodecBuffer> > outputBuffers;
-    err = decoder->getOutputBuffers(&outputBuffers);
-    if (err != OK) {
-        ALOGW("failed to get output buffers: %d (%s)", err, asString(err));
-        decoder->release();
-        source->stop();
-        return NULL;
-    }
-
-    sp<AMessage> outputFormat = NULL;
-    bool haveMoreInputs = true;
-    size_t index, offset, size;
-    int64_t timeUs;
-    size_t retriesLeft = kRetryCount;
-    bool done = false;
     const char *mime;
     bool success = format->findCString(kKeyMIMEType, &mime);
     if (!success) {
@@ -254,7 +373,16 @@ static VideoFrame *extractVideoFrame(
 
     bool isAvcOrHevc = !strcasecmp(mime, MEDIA_MIMETYPE_VIDEO_AVC)
             || !strcasecmp(mime, MEDIA_MIMETYPE_VIDEO_HEVC);
+    bool isSeekingClosest = (seekMode == MediaSource::ReadOptions::SEEK_CLOSEST);
+    bool syncFrameOnly = !isSeekingClosest
+            && (extractFlags & StagefrightMetadataRetriever::kExtractSyncFrameOnly);
 
+    status_t err = OK;
+    bool haveMoreInputs = true;
+    size_t index, offset, size = 0;
+    int64_t timeUs;
+    size_t retriesLeft = kRetryCount;
+    bool done = false;
     bool firstSample = true;
     int64_t targetTimeUs = -1ll;
 
@@ -265,7 +393,7 @@ static VideoFrame *extractVideoFrame(
         sp<MediaCodecBuffer> codecBuffer = NULL;
 
         while (haveMoreInputs) {
-            err = decoder->dequeueInputBuffer(&inputIndex, kBufferTimeOutUs);
+            err = mDecoder->dequeueInputBuffer(&inputIndex, kBufferTimeOutUs);
             if (err != OK) {
                 ALOGW("Timed out waiting for input");
                 if (retriesLeft) {
@@ -273,7 +401,7 @@ static VideoFrame *extractVideoFrame(
                 }
                 break;
             }
-            codecBuffer = inputBuffers[inputIndex];
+            codecBuffer = mInputBuffers[inputIndex];
 
             MediaBuffer *mediaBuffer = NULL;
 
@@ -288,7 +416,6 @@ static VideoFrame *extractVideoFrame(
                 mediaBuffer->meta_data()->findInt64(kKeyTargetTime, &targetTimeUs);
                 ALOGV("Seeking closest: targetTimeUs=%lld", (long long)targetTimeUs);
             }
-            firstSample = false;
 
             if (mediaBuffer->range_length() > codecBuffer->capacity()) {
                 ALOGE("buffer size (%zu) too large for codec input size (%zu)",
@@ -301,22 +428,25 @@ static VideoFrame *extractVideoFrame(
                 memcpy(codecBuffer->data(),
                         (const uint8_t*)mediaBuffer->data() + mediaBuffer->range_offset(),
                         mediaBuffer->range_length());
-                if (isAvcOrHevc && IsIDR(codecBuffer) && !isSeekingClosest) {
+                if ((isAvcOrHevc && IsIDR(codecBuffer) && !isSeekingClosest)
+                        || (firstSample && syncFrameOnly)) {
                     // Only need to decode one IDR frame, unless we're seeking with CLOSEST
                     // option, in which case we need to actually decode to targetTimeUs.
+                    // The first sample after a sync seek is the sync frame itself.
                     haveMoreInputs = false;
                     flags |= MediaCodec::BUFFER_FLAG_EOS;
                 }
             }
+            firstSample = false;
 
             mediaBuffer->release();
             break;
         }
 
-        if (err == OK && inputIndex < inputBuffers.size()) {
+        if (err == OK && inputIndex < mInputBuffers.size()) {
             ALOGV("QueueInput: size=%zu ts=%" PRId64 " us flags=%x",
                     codecBuffer->size(), ptsUs, flags);
-            err = decoder->queueInputBuffer(
+            err = mDecoder->queueInputBuffer(
                     inputIndex,
                     codecBuffer->offset(),
                     codecBuffer->size(),
@@ -331,7 +461,7 @@ static VideoFrame *extractVideoFrame(
 
         while (err == OK) {
             // wait for a decoded buffer
-            err = decoder->dequeueOutputBuffer(
+            err = mDecoder->dequeueOutputBuffer(
                     &index,
                     &offset,
                     &size,
@@ -341,10 +471,10 @@ static VideoFrame *extractVideoFrame(
 
             if (err == INFO_FORMAT_CHANGED) {
                 ALOGV("Received format change");
-                err = decoder->getOutputFormat(&outputFormat);
+                err = mDecoder->getOutputFormat(&mOutputFormat);
             } else if (err == INFO_OUTPUT_BUFFERS_CHANGED) {
                 ALOGV("Output buffers changed");
-                err = decoder->getOutputBuffers(&outputBuffers);
+                err = mDecoder->getOutputBuffers(&mOutputBuffers);
             } else {
                 if (err == -EAGAIN /* INFO_TRY_AGAIN_LATER */ && --retriesLeft > 0) {
                     ALOGV("Timed-out waiting for output.. retries left = %zu", retriesLeft);
@@ -355,7 +485,7 @@ static VideoFrame *extractVideoFrame(
                     done = (targetTimeUs < 0ll) || (timeUs >= targetTimeUs);
                     ALOGV("Received an output buffer, timeUs=%lld", (long long)timeUs);
                     if (!done) {
-                        err = decoder->releaseOutputBuffer(index);
+                        err = mDecoder->releaseOutputBuffer(index);
                     }
                 } else {
                     ALOGW("Received error %d (%s) instead of output", err, asString(err));
@@ -366,20 +496,18 @@ static VideoFrame *extractVideoFrame(
         }
     } while (err == OK && !done);
 
-    if (err != OK || size <= 0 || outputFormat == NULL) {
+    if (err != OK || size <= 0 || mOutputFormat == NULL) {
         ALOGE("Failed to decode thumbnail frame");
-        source->stop();
-        decoder->release();
         return NULL;
     }
 
     ALOGV("successfully decoded video frame.");
-    sp<MediaCodecBuffer> videoFrameBuffer = outputBuffers.itemAt(index);
+    sp<MediaCodecBuffer> videoFrameBuffer = mOutputBuffers.itemAt(index);
 
     if (thumbNailTime >= 0) {
         if (timeUs != thumbNailTime) {
             AString mime;
-            CHECK(outputFormat->findString("mime", &mime));
+            CHECK(mOutputFormat->findString("mime", &mime));
 
             ALOGV("thumbNailTime = %lld us, timeUs = %lld us, mime = %s",
                     (long long)thumbNailTime, (long long)timeUs, mime.c_str());
@@ -387,18 +515,18 @@ static VideoFrame *extractVideoFrame(
     }
 
     int32_t width, height;
-    CHECK(outputFormat->findInt32("width", &width));
-    CHECK(outputFormat->findInt32("height", &height));
+    CHECK(mOutputFormat->findInt32("width", &width));
+    CHECK(mOutputFormat->findInt32("height", &height));
 #ifdef MTK_AOSP_ENHANCEMENT
     int32_t Stridewidth,SliceHeight;
-    CHECK(outputFormat->findInt32("stride", &Stridewidth));
-    CHECK(outputFormat->findInt32("slice-height", &SliceHeight));
+    CHECK(mOutputFormat->findInt32("stride", &Stridewidth));
+    CHECK(mOutputFormat->findInt32("slice-height", &SliceHeight));
     ALOGD("kKeyWidth=%d,kKeyHeight=%d",width,height);
     ALOGD("Stridewidth=%d,SliceHeight=%d",Stridewidth,SliceHeight);
 #endif
 
     int32_t crop_left, crop_top, crop_right, crop_bottom;
-    if (!outputFormat->findRect("crop", &crop_left, &crop_top, &crop_right, &crop_bottom)) {
+    if (!mOutputFormat->findRect("crop", &crop_left, &crop_top, &crop_right, &crop_bottom)) {
         crop_left = crop_top = 0;
         crop_right = width - 1;
         crop_bottom = height - 1;
@@ -409,9 +537,25 @@ static VideoFrame *extractVideoFrame(
         rotationAngle = 0;  // By default, no rotation
     }
 
+    int32_t cropWidth = crop_right - crop_left + 1;
+    int32_t cropHeight = crop_bottom - crop_top + 1;
+
     VideoFrame *frame = new VideoFrame;
-    frame->mWidth = crop_right - crop_left + 1;
-    frame->mHeight = crop_bottom - crop_top + 1;
+    frame->mWidth = cropWidth;
+    frame->mHeight = cropHeight;
+    if (maxDimension > 0 && (cropWidth > maxDimension || cropHeight > maxDimension)) {
+        int32_t longSide = cropWidth > cropHeight ? cropWidth : cropHeight;
+        frame->mWidth = (int32_t)((int64_t)cropWidth * maxDimension / longSide);
+        frame->mHeight = (int32_t)((int64_t)cropHeight * maxDimension / longSide);
+        if (frame->mWidth < 1) {
+            frame->mWidth = 1;
+        }
+        if (frame->mHeight < 1) {
+            frame->mHeight = 1;
+        }
+        ALOGV("downscaling %dx%d frame to %dx%d",
+                cropWidth, cropHeight, frame->mWidth, frame->mHeight);
+    }
     frame->mDisplayWidth = frame->mWidth;
     frame->mDisplayHeight = frame->mHeight;
     frame->mSize = frame->mWidth * frame->mHeight * 2;
@@ -442,23 +586,41 @@ static VideoFrame *extractVideoFrame(
     }
 
     int32_t srcFormat;
-    CHECK(outputFormat->findInt32("color-format", &srcFormat));
+    CHECK(mOutputFormat->findInt32("color-format", &srcFormat));
 
 #ifdef MTK_AOSP_ENHANCEMENT
     width=Stridewidth;
     height=SliceHeight;
 #endif
-    ColorConverter converter((OMX_COLOR_FORMATTYPE)srcFormat, OMX_COLOR_Format16bitRGB565);
+    if (mConverter == NULL || mConverterFormat != srcFormat) {
+        delete mConverter;
+        mConverter = new ColorConverter(
+                (OMX_COLOR_FORMATTYPE)srcFormat, OMX_COLOR_Format16bitRGB565);
+        mConverterFormat = srcFormat;
+    }
+
+    if (mConverter->isValid()) {
+        bool downscale = frame->mWidth != cropWidth || frame->mHeight != cropHeight;
+        uint8_t *dst = downscale
+                ? new uint8_t[(size_t)cropWidth * cropHeight * 2] : frame->mData;
 
-    if (converter.isValid()) {
-        err = converter.convert(
+        err = mConverter->convert(
                 (const uint8_t *)videoFrameBuffer->data(),
                 width, height,
                 crop_left, crop_top, crop_right, crop_bottom,
-                frame->mData,
-                frame->mWidth,
-                frame->mHeight,
-                0, 0, frame->mWidth - 1, frame->mHeight - 1);
+                dst,
+                cropWidth,
+                cropHeight,
+                0, 0, cropWidth - 1, cropHeight - 1);
+
+        if (downscale) {
+            if (err == OK) {
+                downscaleRGB565(
+                        (const uint16_t *)dst, cropWidth, cropHeight,
+                        (uint16_t *)frame->mData, frame->mWidth, frame->mHeight);
+            }
+            delete[] dst;
+        }
     } else {
         ALOGE("Unable to convert from format 0x%08x to RGB565", srcFormat);
 
@@ -466,47 +628,106 @@ static VideoFrame *extractVideoFrame(
     }
 
     videoFrameBuffer.clear();
-    source->stop();
-    decoder->releaseOutputBuffer(index);
-    decoder->release();
+    mDecoder->releaseOutputBuffer(index);
 
     if (err != OK) {
         ALOGE("Colorconverter failed to convert frame.");
 
         delete frame;
-        frame = NULL;
+        return NULL;
+    }
+
+    // Return all buffers to the codec and clear its EOS state, ready for the
+    // next frame.
+    if (mDecoder->flush() != OK) {
+        ALOGW("failed to flush decoder [%s]", mComponentName.c_str());
+        mVideoFormat.clear();
     }
 
     return frame;
 }
 
-VideoFrame *StagefrightMetadataRetriever::getFrameAtTime(
-        int64_t timeUs, int option) {
+static status_t getVideoFormat(
+        const sp<MetaData> &trackMeta, sp<AMessage> *videoFormat) {
+    if (convertMetaDataToMessage(trackMeta, videoFormat) != OK) {
+        ALOGE("b/23680780");
+        ALOGW("Failed to convert meta data to message");
+        return UNKNOWN_ERROR;
+    }
+    return OK;
+}
 
-    ALOGV("getFrameAtTime: %" PRId64 " us option: %d", timeUs, option);
+static VideoFrame *extractVideoFrame(
+        const AString &componentName,
+        const sp<MetaData> &trackMeta,
+        const sp<IMediaSource> &source,
+        int64_t frameTimeUs,
+        int seekMode) {
+    sp<AMessage> videoFormat;
+    if (getVideoFormat(trackMeta, &videoFormat) != OK) {
+        return NULL;
+    }
 
-    if (mExtractor.get() == NULL) {
-        ALOGV("no extractor.");
+    ThumbnailDecoder decoder(
+            componentName, seekMode == MediaSource::ReadOptions::SEEK_CLOSEST);
+    if (decoder.init(videoFormat) != OK) {
         return NULL;
     }
 
-    sp<MetaData> fileMeta = mExtractor->getMetaData();
+    status_t err = source->start();
+    if (err != OK) {
+        ALOGW("source failed to start: %d (%s)", err, asString(err));
+        return NULL;
+    }
+
+    VideoFrame *frame = decoder.extractFrame(
+            trackMeta, source, frameTimeUs, seekMode, 0 /* extractFlags */,
+            0 /* maxDimension */);
+
+    source->stop();
+
+    return frame;
+}
+
+static void findVideoDecoders(const char *mime, Vector<AString> *matchingCodecs) {
+#ifdef MTK_AOSP_ENHANCEMENT
+    MediaCodecList::findMatchingCodecs(
+            mime,
+            false, /* encoder */
+            0,
+            matchingCodecs);
+    ALOGD("matchingCodecs size is %zu", matchingCodecs->size());
+#else
+    MediaCodecList::findMatchingCodecs(
+            mime,
+            false, /* encoder */
+            MediaCodecList::kPreferSoftwareCodecs,
+            matchingCodecs);
+#endif
+}
+
+static status_t findVideoTrack(
+        const sp<IMediaExtractor> &extractor,
+        sp<MetaData> *fileMeta,
+        sp<MetaData> *trackMeta,
+        sp<IMediaSource> *source) {
+    *fileMeta = extractor->getMetaData();
 
-    if (fileMeta == NULL) {
+    if (*fileMeta == NULL) {
         ALOGV("extractor doesn't publish metadata, failed to initialize?");
-        return NULL;
+        return UNKNOWN_ERROR;
     }
 
     int32_t drm = 0;
-    if (fileMeta->findInt32(kKeyIsDRM, &drm) && drm != 0) {
+    if ((*fileMeta)->findInt32(kKeyIsDRM, &drm) && drm != 0) {
         ALOGE("frame grab not allowed.");
-        return NULL;
+        return PERMISSION_DENIED;
     }
 
-    size_t n = mExtractor->countTracks();
+    size_t n = extractor->countTracks();
     size_t i;
     for (i = 0; i < n; ++i) {
-        sp<MetaData> meta = mExtractor->getTrackMetaData(i);
+        sp<MetaData> meta = extractor->getTrackMetaData(i);
 
         const char *mime;
         CHECK(meta->findCString(kKeyMIMEType, &mime));
@@ -518,16 +739,117 @@ VideoFrame *StagefrightMetadataRetriever::getFrameAtTime(
 
     if (i == n) {
         ALOGV("no video track found.");
-        return NULL;
+        return NAME_NOT_FOUND;
     }
 
-    sp<MetaData> trackMeta = mExtractor->getTrackMetaData(
+    *trackMeta = extractor->getTrackMetaData(
             i, MediaExtractor::kIncludeExtensiveMetaData);
 
-    sp<IMediaSource> source = mExtractor->getTrack(i);
+    *source = extractor->getTrack(i);
 
-    if (source.get() == NULL) {
+    if (source->get() == NULL) {
         ALOGV("unable to instantiate video track.");
+        return UNKNOWN_ERROR;
+    }
+
+    return OK;
+}
+
+// Extracts a frame at each of |timesUs| from |source|, taking decoders from
+// |decoders| where one with a matching configuration exists and adding newly
+// instantiated ones to it.
+static void extractVideoFrames(
+        const sp<MetaData> &trackMeta,
+        const sp<IMediaSource> &source,
+        const Vector<int64_t> &timesUs,
+        int seekMode,
+        uint32_t extractFlags,
+        int32_t maxDimension,
+        Vector<ThumbnailDecoder *> *decoders,
+        Vector<VideoFrame *> *frames) {
+    if ((extractFlags & StagefrightMetadataRetriever::kExtractSyncFrameOnly)
+            && seekMode == MediaSource::ReadOptions::SEEK_CLOSEST) {
+        seekMode = MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC;
+    }
+    bool seekClosest = (seekMode == MediaSource::ReadOptions::SEEK_CLOSEST);
+
+    const char *mime;
+    sp<AMessage> videoFormat;
+    Vector<AString> matchingCodecs;
+    status_t err = OK;
+    if (!trackMeta->findCString(kKeyMIMEType, &mime)) {
+        err = ERROR_MALFORMED;
+    } else if ((err = getVideoFormat(trackMeta, &videoFormat)) == OK) {
+        findVideoDecoders(mime, &matchingCodecs);
+        err = source->start();
+        if (err != OK) {
+            ALOGW("source failed to start: %d (%s)", err, asString(err));
+        }
+    }
+
+    for (size_t i = 0; i < timesUs.size(); ++i) {
+        VideoFrame *frame = NULL;
+
+        for (size_t j = 0; err == OK && frame == NULL && j < matchingCodecs.size(); ++j) {
+            const AString &componentName = matchingCodecs[j];
+
+            ThumbnailDecoder *decoder = NULL;
+            for (size_t k = 0; k < decoders->size(); ++k) {
+                if (decoders->itemAt(k)->matches(componentName, seekClosest, videoFormat)) {
+                    decoder = decoders->itemAt(k);
+                    decoders->removeAt(k);
+                    break;
+                }
+            }
+
+            if (decoder == NULL) {
+                decoder = new ThumbnailDecoder(componentName, seekClosest);
+                if (decoder->init(videoFormat) != OK) {
+                    delete decoder;
+                    continue;
+                }
+            }
+
+            frame = decoder->extractFrame(
+                    trackMeta, source, timesUs[i], seekMode, extractFlags, maxDimension);
+
+            if (frame == NULL) {
+                ALOGV("%s failed to extract thumbnail, trying next decoder.",
+                        componentName.c_str());
+                delete decoder;
+                continue;
+            }
+
+            // Keep the most recently used decoder at the end of the pool.
+            if (decoders->size() >= kMaxPooledDecoders) {
+                delete decoders->itemAt(0);
+                decoders->removeAt(0);
+            }
+            decoders->push_back(decoder);
+        }
+
+        frames->push_back(frame);
+    }
+
+    if (err == OK) {
+        source->stop();
+    }
+}
+
+VideoFrame *StagefrightMetadataRetriever::getFrameAtTime(
+        int64_t timeUs, int option) {
+
+    ALOGV("getFrameAtTime: %" PRId64 " us option: %d", timeUs, option);
+
+    if (mExtractor.get() == NULL) {
+        ALOGV("no extractor.");
+        return NULL;
+    }
+
+    sp<MetaData> fileMeta;
+    sp<MetaData> trackMeta;
+    sp<IMediaSource> source;
+    if (findVideoTrack(mExtractor, &fileMeta, &trackMeta, &source) != OK) {
         return NULL;
     }
 
@@ -543,20 +865,7 @@ VideoFrame *StagefrightMetadataRetriever::getFrameAtTime(
     CHECK(trackMeta->findCString(kKeyMIMEType, &mime));
 
     Vector<AString> matchingCodecs;
-#ifdef MTK_AOSP_ENHANCEMENT
-    MediaCodecList::findMatchingCodecs(
-            mime,
-            false, /* encoder */
-            0,
-            &matchingCodecs);
-    ALOGD("matchingCodecs size is %zu", matchingCodecs.size());
-#else
-    MediaCodecList::findMatchingCodecs(
-            mime,
-            false, /* encoder */
-            MediaCodecList::kPreferSoftwareCodecs,
-            &matchingCodecs);
-#endif
+    findVideoDecoders(mime, &matchingCodecs);
 
     for (size_t i = 0; i < matchingCodecs.size(); ++i) {
         const AString &componentName = matchingCodecs[i];
@@ -572,6 +881,80 @@ VideoFrame *StagefrightMetadataRetriever::getFrameAtTime(
     return NULL;
 }
 
+status_t StagefrightMetadataRetriever::getFramesAtTimes(
+        const Vector<int64_t> &timesUs, int option, uint32_t flags,
+        int32_t maxDimension, Vector<VideoFrame *> *frames) {
+    ALOGV("getFramesAtTimes: %zu frames option: %d flags: %#x",
+            timesUs.size(), option, flags);
+
+    frames->clear();
+
+    if (mExtractor.get() == NULL) {
+        ALOGV("no extractor.");
+        return NO_INIT;
+    }
+
+    sp<MetaData> fileMeta;
+    sp<MetaData> trackMeta;
+    sp<IMediaSource> source;
+    status_t err = findVideoTrack(mExtractor, &fileMeta, &trackMeta, &source);
+    if (err != OK) {
+        return err;
+    }
+
+    Vector<ThumbnailDecoder *> decoders;
+    extractVideoFrames(
+            trackMeta, source, timesUs, option, flags, maxDimension, &decoders, frames);
+
+    for (size_t i = 0; i < decoders.size(); ++i) {
+        delete decoders[i];
+    }
+
+    return OK;
+}
+
+// static
+status_t StagefrightMetadataRetriever::ExtractThumbnails(
+        const Vector<String8> &paths, int option, uint32_t flags,
+        int32_t maxDimension, Vector<VideoFrame *> *frames) {
+    ALOGV("ExtractThumbnails: %zu files option: %d flags: %#x",
+            paths.size(), option, flags);
+
+    frames->clear();
+
+    // A negative time selects the track's own thumbnail time.
+    Vector<int64_t> timesUs;
+    timesUs.push_back(-1ll);
+
+    Vector<ThumbnailDecoder *> decoders;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        sp<DataSource> dataSource = new FileSource(paths[i].string());
+        sp<IMediaExtractor> extractor;
+        if (dataSource->initCheck() == OK) {
+            extractor = MediaExtractor::Create(dataSource);
+        }
+
+        sp<MetaData> fileMeta;
+        sp<MetaData> trackMeta;
+        sp<IMediaSource> source;
+        if (extractor == NULL
+                || findVideoTrack(extractor, &fileMeta, &trackMeta, &source) != OK) {
+            ALOGW("Unable to extract a thumbnail from '%s'.", paths[i].string());
+            frames->push_back(NULL);
+            continue;
+        }
+
+        extractVideoFrames(
+                trackMeta, source, timesUs, option, flags, maxDimension, &decoders, frames);
+    }
+
+    for (size_t i = 0; i < decoders.size(); ++i) {
+        delete decoders[i];
+    }
+
+    return OK;
+}
+
 MediaAlbumArt *StagefrightMetadataRetriever::extractAlbumArt() {
     ALOGV("extractAlbumArt (extractor: %s)", mExtractor.get() != NULL ? "YES" : "NO");
 
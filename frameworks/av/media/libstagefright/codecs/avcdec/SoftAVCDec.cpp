@@ -24,6 +24,7 @@
 #include "ih264d.h"
 #include "SoftAVCDec.h"
 
+#include <cutils/properties.h>
 #include <media/stagefright/foundation/ADebug.h>
 #include <media/stagefright/MediaDefs.h>
 #include <OMX_VideoExt.h>
@@ -66,6 +67,7 @@ SoftAVC::SoftAVC(
             320 /* width */, 240 /* height */, callbacks,
             appData, component),
       mCodecCtx(NULL),
+      mRequestedNumCores(0),
       mFlushOutBuffer(NULL),
       mOmxColorFormat(OMX_COLOR_FormatYUV420Planar),
       mIvColorFormat(IV_YUV_420P),
@@ -112,6 +114,60 @@ static size_t GetCPUCoreCount() {
     return (size_t)cpuCoreCount;
 }
 
+// Returns the number of cores in the fastest cluster. On big.LITTLE systems
+// decode threads placed on the little cores hold back the ones on the big
+// cores, so those are not counted. Falls back to |cpuCoreCount| when the
+// cpufreq nodes are not readable.
+static size_t GetPerformanceCoreCount(size_t cpuCoreCount) {
+    long maxFreq = 0;
+    size_t numPerformanceCores = 0;
+    for (size_t i = 0; i < cpuCoreCount; i++) {
+        char path[64];
+        snprintf(path, sizeof(path),
+                "/sys/devices/system/cpu/cpu%zu/cpufreq/cpuinfo_max_freq", i);
+        FILE *file = fopen(path, "r");
+        if (file == NULL) {
+            return cpuCoreCount;
+        }
+        long freq = 0;
+        int matched = fscanf(file, "%ld", &freq);
+        fclose(file);
+        if (matched != 1) {
+            return cpuCoreCount;
+        }
+        if (freq > maxFreq) {
+            maxFreq = freq;
+            numPerformanceCores = 1;
+        } else if (freq == maxFreq) {
+            numPerformanceCores++;
+        }
+    }
+    ALOGV("Number of performance cores: %zu", numPerformanceCores);
+    return numPerformanceCores;
+}
+
+// The number of decoder threads is, in order of preference, the count set by
+// the client, the debug.stagefright.avcdec.threads property, or the size of
+// the fastest cluster (but at least CODEC_MIN_NUM_CORES so that parsing and
+// decoding can overlap).
+static size_t GetDecoderCoreCount(size_t requestedNumCores) {
+    size_t cpuCoreCount = GetCPUCoreCount();
+    size_t numCores = requestedNumCores;
+    if (numCores == 0) {
+        numCores = property_get_int32("debug.stagefright.avcdec.threads", 0);
+    }
+    if (numCores == 0) {
+        numCores = GetPerformanceCoreCount(cpuCoreCount);
+        if (numCores < CODEC_MIN_NUM_CORES) {
+            numCores = CODEC_MIN_NUM_CORES;
+        }
+    }
+    if (numCores > cpuCoreCount) {
+        numCores = cpuCoreCount;
+    }
+    return numCores;
+}
+
 void SoftAVC::logVersion() {
     ivd_ctl_getversioninfo_ip_t s_ctl_ip;
     ivd_ctl_getversioninfo_op_t s_ctl_op;
@@ -247,7 +303,7 @@ status_t SoftAVC::setFlushMode() {
 status_t SoftAVC::initDecoder() {
     IV_API_CALL_STATUS_T status;
 
-    mNumCores = GetCPUCoreCount();
+    mNumCores = GetDecoderCoreCount(mRequestedNumCores);
     mCodecCtx = NULL;
 
     mStride = outputBufferWidth();
@@ -712,6 +768,41 @@ int SoftAVC::getColorAspectPreference() {
     return kPreferBitstream;
 }
 
+OMX_ERRORTYPE SoftAVC::internalSetParameter(OMX_INDEXTYPE index, const OMX_PTR params) {
+    const int32_t indexFull = index;
+
+    switch (indexFull) {
+        case kDecoderThreadCountIndex:
+        {
+            const OMX_PARAM_U32TYPE *threadCountParams = (const OMX_PARAM_U32TYPE *)params;
+
+            if (!isValidOMXParam(threadCountParams)) {
+                return OMX_ErrorBadParameter;
+            }
+
+            mRequestedNumCores = threadCountParams->nU32;
+            if (mCodecCtx != NULL) {
+                mNumCores = GetDecoderCoreCount(mRequestedNumCores);
+                setNumCores();
+            }
+            return OMX_ErrorNone;
+        }
+
+        default:
+            return SoftVideoDecoderOMXComponent::internalSetParameter(index, params);
+    }
+}
+
+OMX_ERRORTYPE SoftAVC::getExtensionIndex(
+        const char *name, OMX_INDEXTYPE *index) {
+    if (!strcmp(name, "OMX.google.android.index.decoderThreadCount")) {
+        *(int32_t*)index = kDecoderThreadCountIndex;
+        return OMX_ErrorNone;
+    }
+
+    return SoftVideoDecoderOMXComponent::getExtensionIndex(name, index);
+}
+
 }  // namespace android
 
 android::SoftOMXComponent *createSoftOMXComponent(
@@ -29,6 +29,9 @@ namespace android {
 /** Maximum number of cores supported by the codec */
 #define CODEC_MAX_NUM_CORES 4
 
+/** Minimum number of cores used when more than one is available */
+#define CODEC_MIN_NUM_CORES 2
+
 #define CODEC_MAX_WIDTH     1920
 
 #define CODEC_MAX_HEIGHT    1088
@@ -52,15 +55,26 @@ protected:
     virtual void onPortFlushCompleted(OMX_U32 portIndex);
     virtual void onReset();
     virtual int getColorAspectPreference();
+
+    virtual OMX_ERRORTYPE internalSetParameter(
+            OMX_INDEXTYPE index, const OMX_PTR params);
+
+    virtual OMX_ERRORTYPE getExtensionIndex(
+            const char *name, OMX_INDEXTYPE *index);
 private:
     // Number of input and output buffers
     enum {
         kNumBuffers = 8
     };
 
+    enum {
+        kDecoderThreadCountIndex = kDescribeColorAspectsIndex + 1,
+    };
+
     iv_obj_t *mCodecCtx;         // Codec context
 
     size_t mNumCores;            // Number of cores to be uesd by the codec
+    size_t mRequestedNumCores;   // Set by the client, 0 to use the CPU topology
 
     nsecs_t mTimeStart;   // Time at the start of decode()
     nsecs_t mTimeEnd;     // Time at the end of decode()
@@ -76,6 +76,10 @@ Input
 #include "pvmp3_dec_defs.h"
 #include "pvmp3_tables.h"
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 /*----------------------------------------------------------------------------
 ; MACROS
 ; Define module1 specific macros here
@@ -112,6 +116,22 @@ Input
 ; FUNCTION CODE
 ----------------------------------------------------------------------------*/
 
+#if defined(__aarch64__)
+
+/*
+ *  Four fxp_mul32_Q32() products at once. Each product is truncated to its
+ *  upper 32 bits before it is accumulated, and 32-bit additions wrap, so the
+ *  sums below are bit exact with the C version whatever the summation order.
+ */
+static inline int32x4_t fxp_mul32_Q32_x4(int32x4_t a, int32x4_t b)
+{
+    int64x2_t lo = vmull_s32(vget_low_s32(a), vget_low_s32(b));
+    int64x2_t hi = vmull_high_s32(a, b);
+    return vcombine_s32(vshrn_n_s64(lo, 32), vshrn_n_s64(hi, 32));
+}
+
+#endif
+
 void pvmp3_polyphase_filter_window(int32 *synth_buffer,
                                    int16 *outPcm,
                                    int32 numChannels)
@@ -122,6 +142,53 @@ void pvmp3_polyphase_filter_window(int32 *synth_buffer,
     int32 i;
 
 
+#if defined(__aarch64__)
+
+    /*
+     *  HAN_SIZE == SUBBANDS_NUMBER << 4, so the window loop of the C version
+     *  below runs once per output pair. Its four groups of taps are computed
+     *  in the four lanes; vld4q_s32 deinterleaves the matching coefficients.
+     */
+    for (int16 j = 1; j < SUBBANDS_NUMBER / 2; j++)
+    {
+        const int32 *pt_1 = &synth_buffer[(SUBBANDS_NUMBER >> 1) + j];
+        const int32 *pt_2 = &synth_buffer[(SUBBANDS_NUMBER >> 1) - j];
+
+        int32x4x4_t win = vld4q_s32(winPtr);
+
+        int32x4_t temp1 = { pt_1[SUBBANDS_NUMBER* 0], pt_1[SUBBANDS_NUMBER* 2],
+                            pt_1[SUBBANDS_NUMBER* 4], pt_1[SUBBANDS_NUMBER* 6] };
+        int32x4_t temp3 = { pt_2[SUBBANDS_NUMBER*15], pt_2[SUBBANDS_NUMBER*13],
+                            pt_2[SUBBANDS_NUMBER*11], pt_2[SUBBANDS_NUMBER* 9] };
+        int32x4_t temp2 = { pt_2[SUBBANDS_NUMBER* 1], pt_2[SUBBANDS_NUMBER* 3],
+                            pt_2[SUBBANDS_NUMBER* 5], pt_2[SUBBANDS_NUMBER* 7] };
+        int32x4_t temp4 = { pt_1[SUBBANDS_NUMBER*14], pt_1[SUBBANDS_NUMBER*12],
+                            pt_1[SUBBANDS_NUMBER*10], pt_1[SUBBANDS_NUMBER* 8] };
+
+        int32x4_t acc1 = vsetq_lane_s32(0x00000020, vdupq_n_s32(0), 0);
+        int32x4_t acc2 = acc1;
+
+        acc1 = vaddq_s32(acc1, fxp_mul32_Q32_x4(temp1, win.val[0]));
+        acc2 = vaddq_s32(acc2, fxp_mul32_Q32_x4(temp3, win.val[0]));
+        acc2 = vaddq_s32(acc2, fxp_mul32_Q32_x4(temp1, win.val[1]));
+        acc1 = vsubq_s32(acc1, fxp_mul32_Q32_x4(temp3, win.val[1]));
+        acc1 = vaddq_s32(acc1, fxp_mul32_Q32_x4(temp2, win.val[2]));
+        acc2 = vsubq_s32(acc2, fxp_mul32_Q32_x4(temp4, win.val[2]));
+        acc2 = vaddq_s32(acc2, fxp_mul32_Q32_x4(temp2, win.val[3]));
+        acc1 = vaddq_s32(acc1, fxp_mul32_Q32_x4(temp4, win.val[3]));
+
+        winPtr += 16;
+
+        sum1 = vaddvq_s32(acc1);
+        sum2 = vaddvq_s32(acc2);
+
+        int32 k = j << (numChannels - 1);
+        outPcm[k] = saturate16(sum1 >> 6);
+        outPcm[(numChannels<<5) - k] = saturate16(sum2 >> 6);
+    }
+
+#else
+
     for (int16 j = 1; j < SUBBANDS_NUMBER / 2; j++)
     {
         sum1 = 0x00000020;
@@ -200,7 +267,7 @@ void pvmp3_polyphase_filter_window(int32 *synth_buffer,
         outPcm[(numChannels<<5) - k] = saturate16(sum2 >> 6);
     }
 
-
+#endif
 
     sum1 = 0x00000020;
     sum2 = 0x00000020;
@@ -22,7 +22,14 @@
 #include <media/stagefright/ColorConverter.h>
 #include <media/stagefright/MediaErrors.h>
 
+#include <algorithm>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "libyuv/convert_argb.h"
 #include "libyuv/convert_from.h"
+#include "libyuv/convert_from_argb.h"
 
 #ifdef MTK_AOSP_ENHANCEMENT
 #include "OMX_IVCommon.h"
@@ -39,6 +46,23 @@
 
 namespace android {
 
+// Frames are split into one stripe of rows per this many pixels, up to
+// kMaxConversionThreads stripes, each converted on its own thread.
+static const size_t kMinPixelsPerThread = 1024 * 1024;
+static const size_t kMaxConversionThreads = 4;
+
+// Formats without a direct libyuv conversion go through ARGB this many rows
+// at a time, so the intermediate rows stay in cache.
+static const size_t kRowsPerBlock = 8;
+
+struct ColorConverter::Stripe {
+    ColorConverter *mConverter;
+    const BitmapParams *mSrc;
+    const BitmapParams *mDst;
+    size_t mFirstRow;
+    size_t mNumRows;
+};
+
 ColorConverter::ColorConverter(
         OMX_COLOR_FORMATTYPE from, OMX_COLOR_FORMATTYPE to)
     : mSrcFormat(from),
@@ -52,6 +76,12 @@ ColorConverter::~ColorConverter() {
 }
 
 bool ColorConverter::isValid() const {
+#ifdef USE_LIBYUV
+    if (mDstFormat == OMX_COLOR_Format32BitRGBA8888) {
+        return IsLibYUVSourceFormat(mSrcFormat);
+    }
+#endif
+
     if (mDstFormat != OMX_COLOR_Format16bitRGB565) {
         return false;
     }
@@ -107,10 +137,6 @@ status_t ColorConverter::convert(
         size_t dstWidth, size_t dstHeight,
         size_t dstCropLeft, size_t dstCropTop,
         size_t dstCropRight, size_t dstCropBottom) {
-    if (mDstFormat != OMX_COLOR_Format16bitRGB565) {
-        return ERROR_UNSUPPORTED;
-    }
-
     BitmapParams src(
             const_cast<void *>(srcBits),
             srcWidth, srcHeight,
@@ -121,6 +147,17 @@ status_t ColorConverter::convert(
             dstWidth, dstHeight,
             dstCropLeft, dstCropTop, dstCropRight, dstCropBottom);
 
+#ifdef USE_LIBYUV
+    if (mDstFormat == OMX_COLOR_Format32BitRGBA8888
+            && IsLibYUVSourceFormat(mSrcFormat)) {
+        return convertUseLibYUV(src, dst);
+    }
+#endif
+
+    if (mDstFormat != OMX_COLOR_Format16bitRGB565) {
+        return ERROR_UNSUPPORTED;
+    }
+
     status_t err;
 
     switch (mSrcFormat) {
@@ -129,13 +166,21 @@ status_t ColorConverter::convert(
             err = convertYUVToRGBHW(src, dst);//
 #else
 #ifdef USE_LIBYUV
-            err = convertYUV420PlanarUseLibYUV(src, dst);
+            err = convertUseLibYUV(src, dst);
 #else
             err = convertYUV420Planar(src, dst);
 #endif
 #endif
             break;
 
+#ifdef USE_LIBYUV
+        case OMX_COLOR_FormatCbYCrY:
+        case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
+        case OMX_COLOR_FormatYUV420SemiPlanar:
+        case OMX_TI_COLOR_FormatYUV420PackedSemiPlanar:
+            err = convertUseLibYUV(src, dst);
+            break;
+#else
         case OMX_COLOR_FormatCbYCrY:
             err = convertCbYCrY(src, dst);
             break;
@@ -151,6 +196,7 @@ status_t ColorConverter::convert(
         case OMX_TI_COLOR_FormatYUV420PackedSemiPlanar:
             err = convertTIYUV420PackedSemiPlanar(src, dst);
             break;
+#endif
 
 #ifdef MTK_AOSP_ENHANCEMENT
       /*
@@ -242,7 +288,30 @@ status_t ColorConverter::convertCbYCrY(
     return OK;
 }
 
-status_t ColorConverter::convertYUV420PlanarUseLibYUV(
+// static
+bool ColorConverter::IsLibYUVSourceFormat(OMX_COLOR_FORMATTYPE format) {
+    switch (format) {
+        case OMX_COLOR_FormatYUV420Planar:
+        case OMX_COLOR_FormatCbYCrY:
+        case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
+        case OMX_COLOR_FormatYUV420SemiPlanar:
+        case OMX_TI_COLOR_FormatYUV420PackedSemiPlanar:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// static
+void *ColorConverter::StripeThreadWrapper(void *me) {
+    Stripe *stripe = static_cast<Stripe *>(me);
+    stripe->mConverter->convertRowsUseLibYUV(
+            *stripe->mSrc, *stripe->mDst, stripe->mFirstRow, stripe->mNumRows);
+    return NULL;
+}
+
+status_t ColorConverter::convertUseLibYUV(
         const BitmapParams &src, const BitmapParams &dst) {
     if (!((src.mCropLeft & 1) == 0
             && src.cropWidth() == dst.cropWidth()
@@ -250,26 +319,156 @@ status_t ColorConverter::convertYUV420PlanarUseLibYUV(
         return ERROR_UNSUPPORTED;
     }
 
-    uint16_t *dst_ptr = (uint16_t *)dst.mBits
-        + dst.mCropTop * dst.mWidth + dst.mCropLeft;
+    const size_t height = src.cropHeight();
 
-    const uint8_t *src_y =
-        (const uint8_t *)src.mBits + src.mCropTop * src.mWidth + src.mCropLeft;
+    size_t numThreads = src.cropWidth() * height / kMinPixelsPerThread;
+    long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numThreads > kMaxConversionThreads) {
+        numThreads = kMaxConversionThreads;
+    }
+    if (numCpus > 0 && numThreads > (size_t)numCpus) {
+        numThreads = numCpus;
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
 
-    const uint8_t *src_u =
-        (const uint8_t *)src_y + src.mWidth * src.mHeight
-        + src.mCropTop * (src.mWidth / 2) + src.mCropLeft / 2;
+    // Stripes start on even rows so that they don't share chroma rows.
+    size_t rowsPerStripe = (((height + numThreads - 1) / numThreads) + 1) & ~1;
+
+    Stripe stripes[kMaxConversionThreads];
+    size_t numStripes = 0;
+    for (size_t row = 0; row < height; row += rowsPerStripe) {
+        Stripe &stripe = stripes[numStripes++];
+        stripe.mConverter = this;
+        stripe.mSrc = &src;
+        stripe.mDst = &dst;
+        stripe.mFirstRow = row;
+        stripe.mNumRows = std::min(rowsPerStripe, height - row);
+    }
 
-    const uint8_t *src_v =
-        src_u + (src.mWidth / 2) * (src.mHeight / 2);
+    pthread_t threads[kMaxConversionThreads];
+    bool started[kMaxConversionThreads];
+    for (size_t i = 1; i < numStripes; ++i) {
+        started[i] = pthread_create(
+                &threads[i], NULL, StripeThreadWrapper, &stripes[i]) == 0;
+        if (!started[i]) {
+            StripeThreadWrapper(&stripes[i]);
+        }
+    }
 
+    StripeThreadWrapper(&stripes[0]);
 
-    libyuv::I420ToRGB565(src_y, src.mWidth, src_u, src.mWidth / 2, src_v, src.mWidth / 2,
-            (uint8 *)dst_ptr, dst.mWidth * 2, dst.mWidth, dst.mHeight);
+    for (size_t i = 1; i < numStripes; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
 
     return OK;
 }
 
+void ColorConverter::convertRowsUseLibYUV(
+        const BitmapParams &src, const BitmapParams &dst,
+        size_t firstRow, size_t numRows) {
+    const bool toRGBA = mDstFormat == OMX_COLOR_Format32BitRGBA8888;
+    const size_t bpp = toRGBA ? 4 : 2;
+    const size_t width = src.cropWidth();
+    const size_t srcRow = src.mCropTop + firstRow;
+
+    uint8_t *dst_ptr = (uint8_t *)dst.mBits
+        + ((dst.mCropTop + firstRow) * dst.mWidth + dst.mCropLeft) * bpp;
+    const size_t dst_stride = dst.mWidth * bpp;
+
+    const uint8_t *bits = (const uint8_t *)src.mBits;
+
+    if (mSrcFormat == OMX_COLOR_FormatYUV420Planar) {
+        const size_t src_c_stride = src.mWidth / 2;
+
+        const uint8_t *src_y = bits + srcRow * src.mWidth + src.mCropLeft;
+
+        const uint8_t *src_u = bits + src.mWidth * src.mHeight
+            + (srcRow / 2) * src_c_stride + src.mCropLeft / 2;
+
+        const uint8_t *src_v = src_u + src_c_stride * (src.mHeight / 2);
+
+        // libyuv's ABGR is R, G, B, A in memory, i.e. RGBA8888.
+        if (toRGBA) {
+            libyuv::I420ToABGR(src_y, src.mWidth, src_u, src_c_stride, src_v, src_c_stride,
+                    dst_ptr, dst_stride, width, numRows);
+        } else {
+            libyuv::I420ToRGB565(src_y, src.mWidth, src_u, src_c_stride, src_v, src_c_stride,
+                    dst_ptr, dst_stride, width, numRows);
+        }
+        return;
+    }
+
+    // The other formats are converted to ARGB first.
+    const uint8_t *src_y = NULL;
+    const uint8_t *src_uv = NULL;
+    size_t src_stride = src.mWidth;
+    switch (mSrcFormat) {
+        case OMX_COLOR_FormatCbYCrY:
+            src_y = bits + (srcRow * src.mWidth + src.mCropLeft) * 2;
+            src_stride = src.mWidth * 2;
+            break;
+
+        case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
+        case OMX_COLOR_FormatYUV420SemiPlanar:
+            src_y = bits + srcRow * src.mWidth + src.mCropLeft;
+            src_uv = bits + src.mWidth * src.mHeight
+                + (srcRow / 2) * src.mWidth + src.mCropLeft;
+            break;
+
+        case OMX_TI_COLOR_FormatYUV420PackedSemiPlanar:
+            // The planes start at the top of the crop rectangle.
+            src_y = bits + firstRow * src.mWidth;
+            src_uv = bits + src.mWidth * (src.mHeight - src.mCropTop / 2)
+                + (firstRow / 2) * src.mWidth;
+            break;
+
+        default:
+            TRESPASS();
+    }
+
+    const size_t argb_stride = width * 4;
+    uint8_t *argb = new uint8_t[argb_stride * kRowsPerBlock];
+
+    for (size_t row = 0; row < numRows; row += kRowsPerBlock) {
+        const size_t rows = std::min(kRowsPerBlock, numRows - row);
+
+        switch (mSrcFormat) {
+            case OMX_COLOR_FormatCbYCrY:
+                libyuv::UYVYToARGB(src_y, src_stride, argb, argb_stride, width, rows);
+                break;
+
+            case OMX_QCOM_COLOR_FormatYVU420SemiPlanar:
+                libyuv::NV21ToARGB(src_y, src_stride, src_uv, src_stride,
+                        argb, argb_stride, width, rows);
+                break;
+
+            default:
+                libyuv::NV12ToARGB(src_y, src_stride, src_uv, src_stride,
+                        argb, argb_stride, width, rows);
+                break;
+        }
+
+        if (toRGBA) {
+            libyuv::ARGBToABGR(argb, argb_stride, dst_ptr, dst_stride, width, rows);
+        } else {
+            libyuv::ARGBToRGB565(argb, argb_stride, dst_ptr, dst_stride, width, rows);
+        }
+
+        src_y += rows * src_stride;
+        if (src_uv != NULL) {
+            src_uv += (rows / 2) * src_stride;
+        }
+        dst_ptr += rows * dst_stride;
+    }
+
+    delete[] argb;
+}
+
 status_t ColorConverter::convertYUV420Planar(
         const BitmapParams &src, const BitmapParams &dst) {
     if (!((src.mCropLeft & 1) == 0
@@ -59,6 +59,17 @@ sp<ABuffer> ABuffer::CreateAsCopy(const void *data, size_t capacity)
     return res;
 }
 
+// static
+sp<ABuffer> ABuffer::CreateSlice(
+        const sp<ABuffer> &parent, size_t offset, size_t size) {
+    CHECK_LE(offset, parent->size());
+    CHECK_LE(size, parent->size() - offset);
+
+    sp<ABuffer> res = new ABuffer(parent->data() + offset, size);
+    res->mParent = parent;
+    return res;
+}
+
 ABuffer::~ABuffer() {
     if (mOwnsData) {
         if (mData != NULL) {
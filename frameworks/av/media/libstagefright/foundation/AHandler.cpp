@@ -23,7 +23,21 @@
 
 namespace android {
 
-void AHandler::deliverMessage(const sp<AMessage> &msg) {
+// static
+const int64_t AHandler::kLatencyBucketLimitUs[kNumLatencyBuckets - 1] = {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000,
+};
+
+void AHandler::deliverMessage(const sp<AMessage> &msg, int64_t latencyUs) {
+    size_t bucket = 0;
+    while (bucket < kNumLatencyBuckets - 1 && latencyUs >= kLatencyBucketLimitUs[bucket]) {
+        ++bucket;
+    }
+    mLatencyHistogram[bucket]++;
+    if (latencyUs > mMaxLatencyUs) {
+        mMaxLatencyUs = latencyUs;
+    }
+
     onMessageReceived(msg);
     mMessageCounter++;
 
@@ -38,4 +52,11 @@ void AHandler::deliverMessage(const sp<AMessage> &msg) {
     }
 }
 
+void AHandler::clearStats() {
+    mMessageCounter = 0;
+    mMessages.clear();
+    memset(mLatencyHistogram, 0, sizeof(mLatencyHistogram));
+    mMaxLatencyUs = 0;
+}
+
 }  // namespace android
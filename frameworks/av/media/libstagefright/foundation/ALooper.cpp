@@ -70,7 +70,8 @@ int64_t ALooper::GetNowUs() {
 }
 
 ALooper::ALooper()
-    : mRunningLocally(false) {
+    : mNumPrioritizedEvents(0),
+      mRunningLocally(false) {
     // clean up stale AHandlers. Doing it here instead of in the destructor avoids
     // the side effect of objects being deleted from the unregister function recursively.
     gLooperRoster.unregisterStaleHandlers();
@@ -165,9 +166,29 @@ status_t ALooper::stop() {
     return OK;
 }
 
-void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
+void ALooper::post(const sp<AMessage> &msg, int64_t delayUs, bool coalesce) {
+    // Coalesced messages are released after mLock, as their items may hold
+    // the last reference to objects that do work on destruction.
+    List<Event> dropped;
     Mutex::Autolock autoLock(mLock);
 
+    if (coalesce) {
+        List<Event>::iterator it = mEventQueue.begin();
+        while (it != mEventQueue.end()) {
+            const sp<AMessage> &pending = (*it).mMessage;
+            if (pending->mWhat == msg->mWhat && pending->mTarget == msg->mTarget
+                    && !pending->contains("replyID")) {
+                if ((*it).mPriority != 0) {
+                    --mNumPrioritizedEvents;
+                }
+                dropped.push_back(*it);
+                it = mEventQueue.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
     int64_t whenUs;
     if (delayUs > 0) {
         whenUs = GetNowUs() + delayUs;
@@ -182,8 +203,13 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
 
     Event event;
     event.mWhenUs = whenUs;
+    event.mPriority = msg->priority();
     event.mMessage = msg;
 
+    if (event.mPriority != 0) {
+        ++mNumPrioritizedEvents;
+    }
+
     if (it == mEventQueue.begin()) {
         mQueueChangedCondition.signal();
     }
@@ -193,6 +219,7 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
 
 bool ALooper::loop() {
     Event event;
+    int64_t latencyUs;
 
     {
         Mutex::Autolock autoLock(mLock);
@@ -213,11 +240,27 @@ bool ALooper::loop() {
             return true;
         }
 
-        event = *mEventQueue.begin();
-        mEventQueue.erase(mEventQueue.begin());
+        // Among the messages that are already due, deliver the first one
+        // with the highest priority.
+        List<Event>::iterator next = mEventQueue.begin();
+        if (mNumPrioritizedEvents > 0) {
+            List<Event>::iterator it = next;
+            for (++it; it != mEventQueue.end() && (*it).mWhenUs <= nowUs; ++it) {
+                if ((*it).mPriority > (*next).mPriority) {
+                    next = it;
+                }
+            }
+        }
+
+        event = *next;
+        mEventQueue.erase(next);
+        if (event.mPriority != 0) {
+            --mNumPrioritizedEvents;
+        }
+        latencyUs = nowUs - event.mWhenUs;
     }
 
-    event.mMessage->deliver();
+    event.mMessage->deliver(latencyUs);
 
     // NOTE: It's important to note that at this point our "ALooper" object
     // may no longer exist (its final reference may have gone away while
@@ -112,6 +112,26 @@ static void makeFourCC(uint32_t fourcc, char *s, size_t bufsz) {
     }
 }
 
+// static
+void ALooperRoster::appendLatencyHistogram(String8 *s, const sp<AHandler> &handler) {
+    if (handler->mMessageCounter == 0) {
+        return;
+    }
+    s->append("\n    dispatch latency:");
+    for (size_t i = 0; i < AHandler::kNumLatencyBuckets; i++) {
+        if (i < AHandler::kNumLatencyBuckets - 1) {
+            s->appendFormat(" <%lldms: %u",
+                    (long long)(AHandler::kLatencyBucketLimitUs[i] / 1000),
+                    handler->mLatencyHistogram[i]);
+        } else {
+            s->appendFormat(" >=%lldms: %u",
+                    (long long)(AHandler::kLatencyBucketLimitUs[i - 1] / 1000),
+                    handler->mLatencyHistogram[i]);
+        }
+    }
+    s->appendFormat(", max %.1fms", handler->mMaxLatencyUs / 1E3);
+}
+
 void ALooperRoster::dump(int fd, const Vector<String16>& args) {
     bool clear = false;
     bool oldVerbose = verboseStats;
@@ -143,6 +163,7 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
             if (handler != NULL) {
                 handler->mVerboseStats = verboseStats;
                 s.appendFormat(": %u messages processed", handler->mMessageCounter);
+                appendLatencyHistogram(&s, handler);
                 if (verboseStats) {
                     for (size_t j = 0; j < handler->mMessages.size(); j++) {
                         char fourcc[15];
@@ -155,8 +176,7 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
                     handler->mMessages.clear();
                 }
                 if (clear || (verboseStats && !oldVerbose)) {
-                    handler->mMessageCounter = 0;
-                    handler->mMessages.clear();
+                    handler->clearStats();
                 }
             } else {
                 s.append(": <stale handler>");
@@ -51,12 +51,14 @@ status_t AReplyToken::setReply(const sp<AMessage> &reply) {
 
 AMessage::AMessage(void)
     : mWhat(0),
+      mPriority(0),
       mTarget(0),
       mNumItems(0) {
 }
 
 AMessage::AMessage(uint32_t what, const sp<const AHandler> &handler)
     : mWhat(what),
+      mPriority(0),
       mNumItems(0) {
     setTarget(handler);
 }
@@ -73,6 +75,14 @@ uint32_t AMessage::what() const {
     return mWhat;
 }
 
+void AMessage::setPriority(int32_t priority) {
+    mPriority = priority;
+}
+
+int32_t AMessage::priority() const {
+    return mPriority;
+}
+
 void AMessage::setTarget(const sp<const AHandler> &handler) {
     if (handler == NULL) {
         mTarget = 0;
@@ -148,20 +158,56 @@ static void reportStats() {
 }
 #endif
 
-inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
+// FNV-1a over the name; also returns its length so callers need no strlen().
+static inline uint32_t hashName(const char *name, size_t *len) {
+    uint32_t hash = 2166136261u;
+    const char *s = name;
+    while (*s != '\0') {
+        hash = (hash ^ (uint8_t)*s++) * 16777619u;
+    }
+    *len = s - name;
+    return hash;
+}
+
+inline size_t AMessage::findItemIndex(const char *name, size_t len, uint32_t hash) const {
 #ifdef DUMP_STATS
+    size_t checks = 0;
     size_t memchecks = 0;
 #endif
-    size_t i = 0;
-    for (; i < mNumItems; i++) {
-        if (len != mItems[i].mNameLength) {
-            continue;
+    size_t i = mNumItems;
+    if (mNumItems >= kHashThreshold) {
+        // mIndex holds at most kMaxNumItems entries, so an empty slot always ends the probe.
+        for (size_t slot = hash & (kIndexSize - 1); mIndex[slot] != 0;
+                slot = (slot + 1) & (kIndexSize - 1)) {
+            const Item &item = mItems[mIndex[slot] - 1];
+#ifdef DUMP_STATS
+            ++checks;
+#endif
+            if (hash != item.mNameHash || len != item.mNameLength) {
+                continue;
+            }
+#ifdef DUMP_STATS
+            ++memchecks;
+#endif
+            if (!memcmp(item.mName, name, len)) {
+                i = mIndex[slot] - 1;
+                break;
+            }
         }
+    } else {
+        for (i = 0; i < mNumItems; i++) {
 #ifdef DUMP_STATS
-        ++memchecks;
+            ++checks;
 #endif
-        if (!memcmp(mItems[i].mName, name, len)) {
-            break;
+            if (hash != mItems[i].mNameHash || len != mItems[i].mNameLength) {
+                continue;
+            }
+#ifdef DUMP_STATS
+            ++memchecks;
+#endif
+            if (!memcmp(mItems[i].mName, name, len)) {
+                break;
+            }
         }
     }
 #ifdef DUMP_STATS
@@ -170,23 +216,40 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
         ++gFindItemCalls;
         gAverageNumItems += mNumItems;
         gAverageNumMemChecks += memchecks;
-        gAverageNumChecks += i;
+        gAverageNumChecks += checks;
         reportStats();
     }
 #endif
     return i;
 }
 
+void AMessage::addToIndex(size_t i) {
+    size_t slot = mItems[i].mNameHash & (kIndexSize - 1);
+    while (mIndex[slot] != 0) {
+        slot = (slot + 1) & (kIndexSize - 1);
+    }
+    mIndex[slot] = (uint8_t)(i + 1);
+}
+
+void AMessage::rebuildIndex() {
+    memset(mIndex, 0, sizeof(mIndex));
+    for (size_t i = 0; i < mNumItems; ++i) {
+        addToIndex(i);
+    }
+}
+
 // assumes item's name was uninitialized or NULL
-void AMessage::Item::setName(const char *name, size_t len) {
+void AMessage::Item::setName(const char *name, size_t len, uint32_t hash) {
     mNameLength = len;
+    mNameHash = hash;
     mName = new char[len + 1];
     memcpy((void*)mName, name, len + 1);
 }
 
 AMessage::Item *AMessage::allocateItem(const char *name) {
-    size_t len = strlen(name);
-    size_t i = findItemIndex(name, len);
+    size_t len;
+    uint32_t hash = hashName(name, &len);
+    size_t i = findItemIndex(name, len, hash);
     Item *item;
 
     if (i < mNumItems) {
@@ -196,7 +259,15 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
         CHECK(mNumItems < kMaxNumItems);
         i = mNumItems++;
         item = &mItems[i];
-        item->setName(name, len);
+        item->setName(name, len, hash);
+
+        // The index is only valid while the message is at or above the
+        // threshold, so build it from scratch when first crossing it.
+        if (mNumItems == kHashThreshold) {
+            rebuildIndex();
+        } else if (mNumItems > kHashThreshold) {
+            addToIndex(i);
+        }
     }
 
     return item;
@@ -204,7 +275,9 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
 
 const AMessage::Item *AMessage::findItem(
         const char *name, Type type) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t len;
+    uint32_t hash = hashName(name, &len);
+    size_t i = findItemIndex(name, len, hash);
     if (i < mNumItems) {
         const Item *item = &mItems[i];
         return item->mType == type ? item : NULL;
@@ -214,7 +287,9 @@ const AMessage::Item *AMessage::findItem(
 }
 
 bool AMessage::findAsFloat(const char *name, float *value) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t len;
+    uint32_t hash = hashName(name, &len);
+    size_t i = findItemIndex(name, len, hash);
     if (i < mNumItems) {
         const Item *item = &mItems[i];
         switch (item->mType) {
@@ -241,7 +316,9 @@ bool AMessage::findAsFloat(const char *name, float *value) const {
 }
 
 bool AMessage::findAsInt64(const char *name, int64_t *value) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t len;
+    uint32_t hash = hashName(name, &len);
+    size_t i = findItemIndex(name, len, hash);
     if (i < mNumItems) {
         const Item *item = &mItems[i];
         switch (item->mType) {
@@ -259,7 +336,9 @@ bool AMessage::findAsInt64(const char *name, int64_t *value) const {
 }
 
 bool AMessage::contains(const char *name) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t len;
+    uint32_t hash = hashName(name, &len);
+    size_t i = findItemIndex(name, len, hash);
     return i < mNumItems;
 }
 
@@ -391,14 +470,14 @@ bool AMessage::findRect(
     return true;
 }
 
-void AMessage::deliver() {
+void AMessage::deliver(int64_t latencyUs) {
     sp<AHandler> handler = mHandler.promote();
     if (handler == NULL) {
         ALOGW("failed to deliver message as target handler %d is gone.", mTarget);
         return;
     }
 
-    handler->deliverMessage(this);
+    handler->deliverMessage(this, latencyUs);
 }
 
 status_t AMessage::post(int64_t delayUs) {
@@ -412,6 +491,17 @@ status_t AMessage::post(int64_t delayUs) {
     return OK;
 }
 
+status_t AMessage::postCoalesced(int64_t delayUs) {
+    sp<ALooper> looper = mLooper.promote();
+    if (looper == NULL) {
+        ALOGW("failed to post message as target looper for handler %d is gone.", mTarget);
+        return -ENOENT;
+    }
+
+    looper->post(this, delayUs, true /* coalesce */);
+    return OK;
+}
+
 status_t AMessage::postAndAwaitResponse(sp<AMessage> *response) {
     sp<ALooper> looper = mLooper.promote();
     if (looper == NULL) {
@@ -461,6 +551,7 @@ bool AMessage::senderAwaitsResponse(sp<AReplyToken> *replyToken) {
 
 sp<AMessage> AMessage::dup() const {
     sp<AMessage> msg = new AMessage(mWhat, mHandler.promote());
+    msg->mPriority = mPriority;
     msg->mNumItems = mNumItems;
 
 #ifdef DUMP_STATS
@@ -476,7 +567,7 @@ sp<AMessage> AMessage::dup() const {
         const Item *from = &mItems[i];
         Item *to = &msg->mItems[i];
 
-        to->setName(from->mName, from->mNameLength);
+        to->setName(from->mName, from->mNameLength, from->mNameHash);
         to->mType = from->mType;
 
         switch (from->mType) {
@@ -513,6 +604,10 @@ sp<AMessage> AMessage::dup() const {
         }
     }
 
+    if (mNumItems >= kHashThreshold) {
+        memcpy(msg->mIndex, mIndex, sizeof(mIndex));
+    }
+
     return msg;
 }
 
@@ -740,7 +835,13 @@ sp<AMessage> AMessage::FromParcel(const Parcel &parcel, size_t maxNestingLevel)
             }
         }
 
-        item->setName(name, strlen(name));
+        size_t len;
+        uint32_t hash = hashName(name, &len);
+        item->setName(name, len, hash);
+    }
+
+    if (msg->mNumItems >= kHashThreshold) {
+        msg->rebuildIndex();
     }
 
     return msg;
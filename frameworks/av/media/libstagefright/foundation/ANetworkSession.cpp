@@ -51,6 +51,7 @@ static uint64_t U64_AT(const uint8_t *ptr) {
 
 static const size_t kMaxUDPSize = 1500;
 static const int32_t kMaxUDPRetries = 200;
+static const size_t kMaxDatagramsPerSend = 32;
 
 struct ANetworkSession::NetworkThread : public Thread {
     explicit NetworkThread(ANetworkSession *session);
@@ -554,22 +555,38 @@ status_t ANetworkSession::Session::writeMore() {
 
         status_t err;
         do {
-            const Fragment &frag = *mOutFragments.begin();
-            const sp<ABuffer> &datagram = frag.mBuffer;
+            // Hand the queued datagrams to the kernel in batches, a single
+            // system call sends a whole RTP burst.
+            struct mmsghdr msgs[kMaxDatagramsPerSend];
+            struct iovec iovs[kMaxDatagramsPerSend];
+            size_t count = 0;
+            for (List<Fragment>::iterator it = mOutFragments.begin();
+                    it != mOutFragments.end() && count < kMaxDatagramsPerSend;
+                    ++it, ++count) {
+                iovs[count].iov_base = (*it).mBuffer->data();
+                iovs[count].iov_len = (*it).mBuffer->size();
+
+                memset(&msgs[count], 0, sizeof(msgs[count]));
+                msgs[count].msg_hdr.msg_iov = &iovs[count];
+                msgs[count].msg_hdr.msg_iovlen = 1;
+            }
 
             int n;
             do {
-                n = send(mSocket, datagram->data(), datagram->size(), 0);
+                n = sendmmsg(mSocket, msgs, count, 0);
             } while (n < 0 && errno == EINTR);
 
             err = OK;
 
             if (n > 0) {
-                if (frag.mFlags & FRAGMENT_FLAG_TIME_VALID) {
-                    dumpFragmentStats(frag);
-                }
+                for (int i = 0; i < n; ++i) {
+                    const Fragment &frag = *mOutFragments.begin();
+                    if (frag.mFlags & FRAGMENT_FLAG_TIME_VALID) {
+                        dumpFragmentStats(frag);
+                    }
 
-                mOutFragments.erase(mOutFragments.begin());
+                    mOutFragments.erase(mOutFragments.begin());
+                }
             } else if (n < 0) {
                 err = -errno;
             } else if (n == 0) {
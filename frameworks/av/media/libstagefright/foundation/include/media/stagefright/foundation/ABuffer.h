@@ -44,6 +44,12 @@ struct ABuffer : public RefBase {
     // create buffer from dup of some memory block
     static sp<ABuffer> CreateAsCopy(const void *data, size_t capacity);
 
+    // create buffer referencing |size| bytes of |parent| starting at |offset|
+    // bytes past parent->data(), without copying. The parent is kept alive
+    // for as long as the slice exists.
+    static sp<ABuffer> CreateSlice(
+            const sp<ABuffer> &parent, size_t offset, size_t size);
+
     void setInt32Data(int32_t data) { mInt32Data = data; }
     int32_t int32Data() const { return mInt32Data; }
 
@@ -57,6 +63,7 @@ protected:
 
 private:
     sp<AMessage> mMeta;
+    sp<ABuffer> mParent;
 
     MediaBufferBase *mMediaBufferBase;
 
@@ -21,6 +21,7 @@
 #include <media/stagefright/foundation/ALooper.h>
 #include <utils/KeyedVector.h>
 #include <utils/String16.h>
+#include <utils/String8.h>
 
 namespace android {
 
@@ -41,6 +42,8 @@ private:
         wp<AHandler> mHandler;
     };
 
+    static void appendLatencyHistogram(String8 *s, const sp<AHandler> &handler);
+
     Mutex mLock;
     KeyedVector<ALooper::handler_id, HandlerInfo> mHandlers;
     ALooper::handler_id mNextHandlerID;
@@ -133,8 +133,19 @@ struct AMessage : public RefBase {
             const char *name,
             int32_t *left, int32_t *top, int32_t *right, int32_t *bottom) const;
 
+    // Messages with a higher priority are delivered before lower priority
+    // messages that are already due on the same looper. Messages that are
+    // not yet due are still delivered in time order. The default is 0.
+    void setPriority(int32_t priority);
+    int32_t priority() const;
+
     status_t post(int64_t delayUs = 0);
 
+    // Like post(), but first drops any message with the same what() and
+    // target that is still pending on the looper, unless its sender is
+    // awaiting a response.
+    status_t postCoalesced(int64_t delayUs = 0);
+
     // Posts the message to its target and waits for a response (or error)
     // before returning.
     status_t postAndAwaitResponse(sp<AMessage> *response);
@@ -190,6 +201,7 @@ private:
     friend struct ALooper; // deliver()
 
     uint32_t mWhat;
+    int32_t mPriority;
 
     // used only for debugging
     ALooper::handler_id mTarget;
@@ -215,15 +227,22 @@ private:
         } u;
         const char *mName;
         size_t      mNameLength;
+        uint32_t    mNameHash;
         Type mType;
-        void setName(const char *name, size_t len);
+        void setName(const char *name, size_t len, uint32_t hash);
     };
 
     enum {
-        kMaxNumItems = 64
+        kMaxNumItems = 64,
+        // Messages with at least this many items also keep mIndex, an
+        // open-addressed table of (item index + 1) keyed by name hash.
+        // Smaller messages are scanned linearly, comparing hashes first.
+        kHashThreshold = 12,
+        kIndexSize = 128,   // power of 2, at least 2 * kMaxNumItems
     };
     Item mItems[kMaxNumItems];
     size_t mNumItems;
+    uint8_t mIndex[kIndexSize];
 
     Item *allocateItem(const char *name);
     void freeItemValue(Item *item);
@@ -232,9 +251,11 @@ private:
     void setObjectInternal(
             const char *name, const sp<RefBase> &obj, Type type);
 
-    size_t findItemIndex(const char *name, size_t len) const;
+    size_t findItemIndex(const char *name, size_t len, uint32_t hash) const;
+    void addToIndex(size_t i);
+    void rebuildIndex();
 
-    void deliver();
+    void deliver(int64_t latencyUs);
 
     DISALLOW_EVIL_CONSTRUCTORS(AMessage);
 };
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ALooper_test"
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+// Records the order of delivered messages. A kWhatBlock message holds the
+// looper thread until release() so that the test can queue up a backlog.
+struct RecordingHandler : public AHandler {
+    enum {
+        kWhatBlock = 100,
+    };
+
+    RecordingHandler() : mBlocked(false), mReleased(false) {}
+
+    void waitUntilBlocked() {
+        Mutex::Autolock autoLock(mLock);
+        while (!mBlocked) {
+            mCondition.wait(mLock);
+        }
+    }
+
+    void release() {
+        Mutex::Autolock autoLock(mLock);
+        mReleased = true;
+        mCondition.broadcast();
+    }
+
+    Vector<int32_t> waitForValues(size_t count) {
+        Mutex::Autolock autoLock(mLock);
+        while (mValues.size() < count) {
+            mCondition.wait(mLock);
+        }
+        return mValues;
+    }
+
+protected:
+    virtual void onMessageReceived(const sp<AMessage> &msg) {
+        Mutex::Autolock autoLock(mLock);
+        if (msg->what() == kWhatBlock) {
+            mBlocked = true;
+            mCondition.broadcast();
+            while (!mReleased) {
+                mCondition.wait(mLock);
+            }
+            return;
+        }
+        int32_t value;
+        CHECK(msg->findInt32("value", &value));
+        mValues.push_back(value);
+        mCondition.broadcast();
+    }
+
+private:
+    Mutex mLock;
+    Condition mCondition;
+    bool mBlocked;
+    bool mReleased;
+    Vector<int32_t> mValues;
+};
+
+class ALooperTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        mLooper = new ALooper;
+        mLooper->setName("ALooperTest");
+        mHandler = new RecordingHandler;
+        mLooper->registerHandler(mHandler);
+        ASSERT_EQ(OK, mLooper->start());
+
+        (new AMessage(RecordingHandler::kWhatBlock, mHandler))->post();
+        mHandler->waitUntilBlocked();
+    }
+
+    virtual void TearDown() {
+        mLooper->unregisterHandler(mHandler->id());
+        mLooper->stop();
+    }
+
+    void post(uint32_t what, int32_t value, int32_t priority = 0, bool coalesce = false) {
+        sp<AMessage> msg = new AMessage(what, mHandler);
+        msg->setInt32("value", value);
+        msg->setPriority(priority);
+        if (coalesce) {
+            msg->postCoalesced();
+        } else {
+            msg->post();
+        }
+    }
+
+    sp<ALooper> mLooper;
+    sp<RecordingHandler> mHandler;
+};
+
+TEST_F(ALooperTest, HigherPriorityDueMessagesRunFirst) {
+    post(1000, 1);
+    post(1000, 2);
+    post(1001, 3, 1 /* priority */);
+    post(1000, 4);
+    post(1001, 5, 1 /* priority */);
+    mHandler->release();
+
+    Vector<int32_t> values = mHandler->waitForValues(5);
+    ASSERT_EQ(5u, values.size());
+    EXPECT_EQ(3, values[0]);
+    EXPECT_EQ(5, values[1]);
+    EXPECT_EQ(1, values[2]);
+    EXPECT_EQ(2, values[3]);
+    EXPECT_EQ(4, values[4]);
+}
+
+TEST_F(ALooperTest, CoalescingReplacesPendingMessage) {
+    post(1002, 1);
+    post(1003, 2);
+    post(1002, 3, 0 /* priority */, true /* coalesce */);
+    post(1002, 4, 0 /* priority */, true /* coalesce */);
+    mHandler->release();
+
+    Vector<int32_t> values = mHandler->waitForValues(2);
+    ASSERT_EQ(2u, values.size());
+    EXPECT_EQ(2, values[0]);
+    EXPECT_EQ(4, values[1]);
+}
+
+} // namespace android
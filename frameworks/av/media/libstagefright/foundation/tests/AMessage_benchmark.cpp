@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures AMessage key lookup and copy cost for format-sized messages.
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/foundation/AString.h>
+
+using android::AMessage;
+using android::AString;
+using android::sp;
+
+// Keys in the style of a MediaCodec output format.
+static std::vector<AString> makeKeys(int32_t count) {
+    std::vector<AString> keys;
+    for (int32_t i = 0; i < count; ++i) {
+        keys.push_back(android::AStringPrintf("csd-param-%d", i));
+    }
+    return keys;
+}
+
+static sp<AMessage> makeMessage(const std::vector<AString> &keys) {
+    sp<AMessage> msg = new AMessage;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        msg->setInt32(keys[i].c_str(), (int32_t)i);
+    }
+    return msg;
+}
+
+static void BM_AMessage_findInt32(benchmark::State& state) {
+    std::vector<AString> keys = makeKeys(state.range(0));
+    sp<AMessage> msg = makeMessage(keys);
+    size_t next = 0;
+    while (state.KeepRunning()) {
+        int32_t value;
+        benchmark::DoNotOptimize(msg->findInt32(keys[next].c_str(), &value));
+        if (++next == keys.size()) {
+            next = 0;
+        }
+    }
+}
+BENCHMARK(BM_AMessage_findInt32)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Arg(48)->Arg(64);
+
+static void BM_AMessage_findMissing(benchmark::State& state) {
+    sp<AMessage> msg = makeMessage(makeKeys(state.range(0)));
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(msg->contains("csd-param-missing"));
+    }
+}
+BENCHMARK(BM_AMessage_findMissing)->Arg(4)->Arg(16)->Arg(48);
+
+static void BM_AMessage_build(benchmark::State& state) {
+    std::vector<AString> keys = makeKeys(state.range(0));
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(makeMessage(keys).get());
+    }
+}
+BENCHMARK(BM_AMessage_build)->Arg(8)->Arg(32)->Arg(64);
+
+static void BM_AMessage_dup(benchmark::State& state) {
+    sp<AMessage> msg = makeMessage(makeKeys(state.range(0)));
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(msg->dup().get());
+    }
+}
+BENCHMARK(BM_AMessage_dup)->Arg(8)->Arg(32)->Arg(64);
+
+BENCHMARK_MAIN();
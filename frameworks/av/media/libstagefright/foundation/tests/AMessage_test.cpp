@@ -0,0 +1,106 @@
+/*
+ * Copyright 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "AMessage_test"
+
+#include <gtest/gtest.h>
+
+#include <binder/Parcel.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/foundation/AString.h>
+
+namespace android {
+
+class AMessageTest : public ::testing::Test {
+protected:
+    static AString keyName(int32_t i) {
+        return AStringPrintf("key-%d", i);
+    }
+
+    static void fill(const sp<AMessage> &msg, int32_t count) {
+        for (int32_t i = 0; i < count; ++i) {
+            msg->setInt32(keyName(i).c_str(), i);
+        }
+    }
+
+    static void expectAll(const sp<AMessage> &msg, int32_t count) {
+        ASSERT_EQ((size_t)count, msg->countEntries());
+        for (int32_t i = 0; i < count; ++i) {
+            int32_t value;
+            ASSERT_TRUE(msg->findInt32(keyName(i).c_str(), &value)) << keyName(i).c_str();
+            EXPECT_EQ(i, value);
+        }
+        EXPECT_FALSE(msg->contains("missing"));
+        EXPECT_FALSE(msg->contains("key-"));
+    }
+};
+
+// Covers both the linear scan and the hashed index, including the count where
+// the index is first built.
+TEST_F(AMessageTest, FindAcrossSizes) {
+    for (int32_t count = 1; count <= 64; ++count) {
+        sp<AMessage> msg = new AMessage;
+        fill(msg, count);
+        expectAll(msg, count);
+    }
+}
+
+TEST_F(AMessageTest, OverwriteKeepsSingleEntry) {
+    sp<AMessage> msg = new AMessage;
+    fill(msg, 40);
+    msg->setString(keyName(7).c_str(), "seven");
+    msg->setInt64(keyName(33).c_str(), 33ll);
+    EXPECT_EQ(40u, msg->countEntries());
+
+    int32_t i32;
+    int64_t i64;
+    AString str;
+    EXPECT_FALSE(msg->findInt32(keyName(7).c_str(), &i32));
+    ASSERT_TRUE(msg->findString(keyName(7).c_str(), &str));
+    EXPECT_EQ(AString("seven"), str);
+    ASSERT_TRUE(msg->findAsInt64(keyName(33).c_str(), &i64));
+    EXPECT_EQ(33ll, i64);
+}
+
+TEST_F(AMessageTest, ClearThenRefill) {
+    sp<AMessage> msg = new AMessage;
+    fill(msg, 50);
+    msg->clear();
+    EXPECT_FALSE(msg->contains(keyName(0).c_str()));
+    msg->setInt32("other", 1);
+    fill(msg, 20);
+    EXPECT_TRUE(msg->contains("other"));
+    EXPECT_EQ(21u, msg->countEntries());
+    EXPECT_FALSE(msg->contains(keyName(30).c_str()));
+}
+
+TEST_F(AMessageTest, DupAndParcelKeepIndex) {
+    sp<AMessage> msg = new AMessage;
+    fill(msg, 48);
+    expectAll(msg->dup(), 48);
+
+    Parcel parcel;
+    msg->writeToParcel(&parcel);
+    parcel.setDataPosition(0);
+    sp<AMessage> copy = AMessage::FromParcel(parcel);
+    ASSERT_TRUE(copy != NULL);
+    expectAll(copy, 48);
+    copy->setInt32("extra", 1);
+    EXPECT_TRUE(copy->contains("extra"));
+}
+
+} // namespace android
@@ -9,11 +9,14 @@ LOCAL_MODULE_TAGS := tests
 
 LOCAL_SRC_FILES := \
 	AData_test.cpp \
+	ALooper_test.cpp \
+	AMessage_test.cpp \
 	Flagged_test.cpp \
 	TypeTraits_test.cpp \
 	Utils_test.cpp \
 
 LOCAL_SHARED_LIBRARIES := \
+	libbinder \
 	libstagefright_foundation \
 	libutils \
 
@@ -25,6 +28,26 @@ LOCAL_CLANG := true
 
 include $(BUILD_NATIVE_TEST)
 
+# AMessage lookup and copy cost
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := sf_foundation_benchmark
+
+LOCAL_SRC_FILES := \
+	AMessage_benchmark.cpp \
+
+LOCAL_SHARED_LIBRARIES := \
+	libstagefright_foundation \
+	libutils \
+
+LOCAL_C_INCLUDES := \
+	frameworks/av/include \
+
+LOCAL_CFLAGS += -Werror -Wall
+LOCAL_CLANG := true
+
+include $(BUILD_NATIVE_BENCHMARK)
+
 # Include subdirectory makefiles
 # ============================================================
 
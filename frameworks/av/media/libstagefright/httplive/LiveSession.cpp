@@ -39,6 +39,7 @@
 
 #include <ctype.h>
 #include <inttypes.h>
+#include <math.h>
 
 namespace android {
 
@@ -65,6 +66,7 @@ private:
     static const int64_t kMinBandwidthHistoryWindowUs = 5000000ll; // 5 sec
     static const int64_t kMaxBandwidthHistoryWindowUs = 30000000ll; // 30 sec
     static const int64_t kMaxBandwidthHistoryAgeUs = 60000000ll; // 60 sec
+    static const int32_t kBandwidthPercentile = 50;
 
     struct BandwidthEntry {
         int64_t mTimestampUs;
@@ -72,6 +74,11 @@ private:
         size_t mNumBytes;
     };
 
+    struct ThroughputSample {
+        double mBps;
+        double mWeight;
+    };
+
     Mutex mLock;
     List<BandwidthEntry> mBandwidthHistory;
     List<int32_t> mPrevEstimates;
@@ -81,6 +88,10 @@ private:
     int64_t mTotalTransferTimeUs;
     size_t mTotalTransferBytes;
 
+    static int compareThroughput(
+            const ThroughputSample *a, const ThroughputSample *b);
+    int32_t estimatePercentile_l() const;
+
     DISALLOW_EVIL_CONSTRUCTORS(BandwidthEstimator);
 };
 
@@ -132,6 +143,50 @@ void LiveSession::BandwidthEstimator::addBandwidthMeasurement(
     }
 }
 
+// static
+int LiveSession::BandwidthEstimator::compareThroughput(
+        const ThroughputSample *a, const ThroughputSample *b) {
+    return a->mBps < b->mBps ? -1 : (a->mBps > b->mBps ? 1 : 0);
+}
+
+// Returns the kBandwidthPercentile-th percentile of the throughput of the
+// samples in the history window, each weighted by the square root of its
+// size. Unlike the overall average, a few stalled or unusually fast
+// transfers move this only a little, which keeps the estimate from
+// oscillating between variants.
+int32_t LiveSession::BandwidthEstimator::estimatePercentile_l() const {
+    Vector<ThroughputSample> samples;
+    double totalWeight = 0;
+    for (List<BandwidthEntry>::const_iterator it = mBandwidthHistory.begin();
+            it != mBandwidthHistory.end(); ++it) {
+        if (it->mDelayUs <= 0) {
+            continue;
+        }
+        ThroughputSample sample;
+        sample.mBps = it->mNumBytes * 8E6 / it->mDelayUs;
+        sample.mWeight = sqrt((double)it->mNumBytes);
+        totalWeight += sample.mWeight;
+        samples.push_back(sample);
+    }
+
+    if (samples.isEmpty()) {
+        return mTotalTransferTimeUs > 0 ?
+                (double)mTotalTransferBytes * 8E6 / mTotalTransferTimeUs : 0;
+    }
+
+    samples.sort(compareThroughput);
+
+    double targetWeight = totalWeight * kBandwidthPercentile / 100;
+    double weight = 0;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        weight += samples[i].mWeight;
+        if (weight >= targetWeight) {
+            return samples[i].mBps;
+        }
+    }
+    return samples[samples.size() - 1].mBps;
+}
+
 bool LiveSession::BandwidthEstimator::estimateBandwidth(
         int32_t *bandwidthBps, bool *isStable, int32_t *shortTermBps) {
     AutoMutex autoLock(mLock);
@@ -151,7 +206,7 @@ bool LiveSession::BandwidthEstimator::estimateBandwidth(
         return true;
     }
 
-    *bandwidthBps = ((double)mTotalTransferBytes * 8E6 / mTotalTransferTimeUs);
+    *bandwidthBps = estimatePercentile_l();
     mPrevEstimates.push_back(*bandwidthBps);
     while (mPrevEstimates.size() > 3) {
         mPrevEstimates.erase(mPrevEstimates.begin());
@@ -23,6 +23,7 @@
 #include "HTTPDownloader.h"
 #include "LiveSession.h"
 #include "M3UParser.h"
+#include "SegmentPrefetcher.h"
 #include "include/avc_utils.h"
 #include "include/ID3.h"
 #include "mpeg2ts/AnotherPacketSource.h"
@@ -170,9 +171,11 @@ PlaylistFetcher::PlaylistFetcher(
       mSampleAesKeyItemChanged(false),
       mThresholdRatio(-1.0f),
       mDownloadState(new DownloadState()),
+      mSegmentPrefetched(false),
       mHasMetadata(false) {
     memset(mPlaylistHash, 0, sizeof(mPlaylistHash));
     mHTTPDownloader = mSession->getHTTPDownloader();
+    mPrefetcher = new SegmentPrefetcher(mSession);
 
     memset(mKeyData, 0, sizeof(mKeyData));
     memset(mAESInitVec, 0, sizeof(mAESInitVec));
@@ -507,6 +510,7 @@ void PlaylistFetcher::setStoppingThreshold(float thresholdRatio, bool disconnect
     }
     if (disconnect) {
         mHTTPDownloader->disconnect();
+        mPrefetcher->cancel();
     }
 }
 
@@ -517,6 +521,7 @@ void PlaylistFetcher::resetStoppingThreshold(bool disconnect) {
     }
     if (disconnect) {
         mHTTPDownloader->disconnect();
+        mPrefetcher->cancel();
     } else {
         // allow reconnect
         mHTTPDownloader->reconnect();
@@ -761,6 +766,7 @@ status_t PlaylistFetcher::onStart(const sp<AMessage> &msg) {
         mSeqNumber = -1;
         mTimeChangeSignaled = false;
         mDownloadState->resetState();
+        mPrefetcher->cancel();
     }
 
     postMonitorQueue();
@@ -1335,14 +1341,28 @@ void PlaylistFetcher::onDownloadNext() {
         range_length = -1;
     }
 
+    bool havePrefetchedData = false;
+    if (connectHTTP) {
+        mSegmentPrefetched = (mPrefetcher->take(
+                uri, range_offset, range_length, &buffer) == OK);
+        havePrefetchedData = mSegmentPrefetched;
+    }
+
     // block-wise download
     bool shouldPause = false;
     ssize_t bytesRead;
     do {
         int64_t startUs = ALooper::GetNowUs();
-        bytesRead = mHTTPDownloader->fetchBlock(
-                uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
-                NULL /* actualURL */, connectHTTP);
+        if (mSegmentPrefetched) {
+            // The whole segment is already here, hand it over as a single
+            // block and finish on the next iteration.
+            bytesRead = havePrefetchedData ? (ssize_t)buffer->size() : 0;
+            havePrefetchedData = false;
+        } else {
+            bytesRead = mHTTPDownloader->fetchBlock(
+                    uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
+                    NULL /* actualURL */, connectHTTP);
+        }
         int64_t delayUs = ALooper::GetNowUs() - startUs;
 
         if (bytesRead == ERROR_NOT_CONNECTED) {
@@ -1357,8 +1377,9 @@ void PlaylistFetcher::onDownloadNext() {
 
         // add sample for bandwidth estimation, excluding samples from subtitles (as
         // its too small), or during startup/resumeUntil (when we could have more than
-        // one connection open which affects bandwidth)
-        if (!mStartup && mStopParams == NULL && bytesRead > 0
+        // one connection open which affects bandwidth). Prefetched segments were
+        // measured by mPrefetcher.
+        if (!mSegmentPrefetched && !mStartup && mStopParams == NULL && bytesRead > 0
                 && (mStreamTypeMask
                         & (LiveSession::STREAMTYPE_AUDIO
                         | LiveSession::STREAMTYPE_VIDEO))) {
@@ -1513,6 +1534,8 @@ void PlaylistFetcher::onDownloadNext() {
 
     ++mSeqNumber;
 
+    prefetchSegments();
+
     // if adapting, pause after found the next starting point
     if (mSeekMode != LiveSession::kSeekModeExactPosition && startUp != mStartup) {
         CHECK(mStartTimeUsNotify != NULL);
@@ -1526,6 +1549,46 @@ void PlaylistFetcher::onDownloadNext() {
     }
 }
 
+void PlaylistFetcher::prefetchSegments() {
+    // Like bandwidth sampling, only prefetch in steady state: during startup
+    // and resumeUntil the fetcher may still seek or stop at any segment.
+    if (mStartup || mStopParams != NULL || mPlaylist == NULL
+            || !(mStreamTypeMask
+                    & (LiveSession::STREAMTYPE_AUDIO | LiveSession::STREAMTYPE_VIDEO))) {
+        return;
+    }
+
+    int32_t firstSeqNumberInPlaylist, lastSeqNumberInPlaylist;
+    mPlaylist->getSeqNumberRange(
+            &firstSeqNumberInPlaylist, &lastSeqNumberInPlaylist);
+
+    // Queue upcoming segments until the prefetcher is full.
+    for (int32_t seqNumber = mSeqNumber;
+            seqNumber <= lastSeqNumberInPlaylist; ++seqNumber) {
+        if (seqNumber < firstSeqNumberInPlaylist) {
+            continue;
+        }
+
+        AString uri;
+        sp<AMessage> itemMeta;
+        if (!mPlaylist->itemAt(
+                seqNumber - firstSeqNumberInPlaylist, &uri, &itemMeta)) {
+            break;
+        }
+
+        int64_t rangeOffset, rangeLength;
+        if (!itemMeta->findInt64("range-offset", &rangeOffset)
+                || !itemMeta->findInt64("range-length", &rangeLength)) {
+            rangeOffset = 0;
+            rangeLength = -1;
+        }
+
+        if (!mPrefetcher->prefetch(uri, rangeOffset, rangeLength)) {
+            break;
+        }
+    }
+}
+
 /*
  * returns true if we need to adjust mSeqNumber
  */
@@ -32,6 +32,7 @@ class DataSource;
 struct HTTPBase;
 struct LiveDataSource;
 struct M3UParser;
+struct SegmentPrefetcher;
 class String8;
 
 struct PlaylistFetcher : public AHandler {
@@ -118,6 +119,7 @@ private:
     sp<AMessage> mStartTimeUsNotify;
 
     sp<HTTPDownloader> mHTTPDownloader;
+    sp<SegmentPrefetcher> mPrefetcher;
     sp<LiveSession> mSession;
     AString mURI;
 
@@ -186,6 +188,10 @@ private:
 
     sp<DownloadState> mDownloadState;
 
+    // True if the segment being parsed was downloaded by mPrefetcher, in
+    // which case its buffer already holds the whole segment.
+    bool mSegmentPrefetched;
+
     bool mHasMetadata;
 
     // Set first to true if decrypting the first segment of a playlist segment. When
@@ -222,6 +228,7 @@ private:
     void onStop(const sp<AMessage> &msg);
     void onMonitorQueue();
     void onDownloadNext();
+    void prefetchSegments();
     void initSeqNumberForLiveStream(
             int32_t &firstSeqNumberInPlaylist,
             int32_t &lastSeqNumberInPlaylist);
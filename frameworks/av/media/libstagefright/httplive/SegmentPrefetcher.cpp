@@ -0,0 +1,266 @@
+/*
+ * Copyright 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SegmentPrefetcher"
+#include <utils/Log.h>
+
+#include "SegmentPrefetcher.h"
+#include "HTTPDownloader.h"
+#include "LiveSession.h"
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/MediaErrors.h>
+
+namespace android {
+
+SegmentPrefetcher::SegmentPrefetcher(const sp<LiveSession> &session)
+    : mSession(session),
+      mStarted(false),
+      mExiting(false),
+      mNumActiveDownloads(0),
+      mLastReportTimeUs(0) {
+    for (size_t i = 0; i < kMaxConcurrentDownloads; ++i) {
+        mWorkers[i].mOwner = this;
+        mWorkers[i].mIndex = i;
+        mWorkers[i].mDownloader = session->getHTTPDownloader();
+    }
+}
+
+SegmentPrefetcher::~SegmentPrefetcher() {
+    {
+        Mutex::Autolock autoLock(mLock);
+        mExiting = true;
+        mWorkCondition.broadcast();
+    }
+
+    cancel();
+
+    if (mStarted) {
+        for (size_t i = 0; i < kMaxConcurrentDownloads; ++i) {
+            void *dummy;
+            pthread_join(mWorkers[i].mThread, &dummy);
+        }
+    }
+}
+
+sp<SegmentPrefetcher::Segment> SegmentPrefetcher::findSegment_l(
+        const AString &uri, int64_t rangeOffset, int64_t rangeLength) const {
+    for (List<sp<Segment> >::const_iterator it = mSegments.begin();
+            it != mSegments.end(); ++it) {
+        const sp<Segment> &segment = *it;
+        if (segment->mURI == uri
+                && segment->mRangeOffset == rangeOffset
+                && segment->mRangeLength == rangeLength) {
+            return segment;
+        }
+    }
+    return NULL;
+}
+
+void SegmentPrefetcher::removeSegment_l(const sp<Segment> &segment) {
+    for (List<sp<Segment> >::iterator it = mSegments.begin();
+            it != mSegments.end(); ++it) {
+        if (*it == segment) {
+            mSegments.erase(it);
+            return;
+        }
+    }
+}
+
+bool SegmentPrefetcher::prefetch(
+        const AString &uri, int64_t rangeOffset, int64_t rangeLength) {
+    Mutex::Autolock autoLock(mLock);
+
+    if (findSegment_l(uri, rangeOffset, rangeLength) != NULL) {
+        return true;
+    }
+
+    if (mExiting || mSegments.size() >= kMaxPrefetchedSegments) {
+        return false;
+    }
+
+    if (!mStarted) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+        size_t numStarted = 0;
+        for (; numStarted < kMaxConcurrentDownloads; ++numStarted) {
+            if (pthread_create(&mWorkers[numStarted].mThread, &attr,
+                    ThreadWrapper, &mWorkers[numStarted]) != 0) {
+                break;
+            }
+        }
+
+        pthread_attr_destroy(&attr);
+
+        if (numStarted < kMaxConcurrentDownloads) {
+            ALOGE("failed to start prefetch threads");
+            mExiting = true;
+            mWorkCondition.broadcast();
+            for (size_t i = 0; i < numStarted; ++i) {
+                mLock.unlock();
+                void *dummy;
+                pthread_join(mWorkers[i].mThread, &dummy);
+                mLock.lock();
+            }
+            return false;
+        }
+        mStarted = true;
+    }
+
+    ALOGV("prefetching '%s' @%lld", uri.c_str(), (long long)rangeOffset);
+
+    sp<Segment> segment = new Segment;
+    segment->mURI = uri;
+    segment->mRangeOffset = rangeOffset;
+    segment->mRangeLength = rangeLength;
+    segment->mState = QUEUED;
+    segment->mCancelled = false;
+    segment->mWorkerIndex = 0;
+    segment->mStatus = OK;
+    mSegments.push_back(segment);
+
+    mWorkCondition.signal();
+    return true;
+}
+
+status_t SegmentPrefetcher::take(
+        const AString &uri, int64_t rangeOffset, int64_t rangeLength,
+        sp<ABuffer> *buffer) {
+    Mutex::Autolock autoLock(mLock);
+
+    sp<Segment> segment = findSegment_l(uri, rangeOffset, rangeLength);
+    if (segment == NULL) {
+        return NAME_NOT_FOUND;
+    }
+
+    if (segment->mState == QUEUED) {
+        // Nothing was downloaded yet, the caller is better off fetching it
+        // right away than waiting for a worker.
+        removeSegment_l(segment);
+        return NAME_NOT_FOUND;
+    }
+
+    // The segment stays listed while we wait, so that cancel() can still
+    // abort its download and wake us up.
+    while (segment->mState != DONE && !segment->mCancelled) {
+        mDoneCondition.wait(mLock);
+    }
+
+    if (segment->mCancelled) {
+        return ERROR_NOT_CONNECTED;
+    }
+
+    removeSegment_l(segment);
+
+    if (segment->mStatus == OK) {
+        *buffer = segment->mBuffer;
+    }
+    return segment->mStatus;
+}
+
+void SegmentPrefetcher::cancel() {
+    Mutex::Autolock autoLock(mLock);
+
+    for (List<sp<Segment> >::iterator it = mSegments.begin();
+            it != mSegments.end(); ++it) {
+        const sp<Segment> &segment = *it;
+        segment->mCancelled = true;
+        if (segment->mState == DOWNLOADING) {
+            mWorkers[segment->mWorkerIndex].mDownloader->disconnect();
+        }
+    }
+    mSegments.clear();
+
+    mDoneCondition.broadcast();
+}
+
+// static
+void *SegmentPrefetcher::ThreadWrapper(void *me) {
+    Worker *worker = static_cast<Worker *>(me);
+    worker->mOwner->threadLoop(worker);
+    return NULL;
+}
+
+void SegmentPrefetcher::threadLoop(Worker *worker) {
+    Mutex::Autolock autoLock(mLock);
+
+    for (;;) {
+        sp<Segment> segment;
+        while (!mExiting) {
+            for (List<sp<Segment> >::iterator it = mSegments.begin();
+                    it != mSegments.end(); ++it) {
+                if ((*it)->mState == QUEUED) {
+                    segment = *it;
+                    break;
+                }
+            }
+            if (segment != NULL) {
+                break;
+            }
+            mWorkCondition.wait(mLock);
+        }
+
+        if (mExiting) {
+            break;
+        }
+
+        segment->mState = DOWNLOADING;
+        segment->mWorkerIndex = worker->mIndex;
+        if (mNumActiveDownloads++ == 0) {
+            mLastReportTimeUs = ALooper::GetNowUs();
+        }
+
+        // Reconnect while holding the lock, so that a cancel() issued from
+        // here on is guaranteed to abort the download.
+        worker->mDownloader->reconnect();
+
+        mLock.unlock();
+        sp<ABuffer> buffer;
+        ssize_t bytesRead = worker->mDownloader->fetchBlock(
+                segment->mURI.c_str(), &buffer,
+                segment->mRangeOffset, segment->mRangeLength,
+                0 /* block_size */, NULL /* actualURL */, true /* reconnect */);
+        mLock.lock();
+
+        int64_t nowUs = ALooper::GetNowUs();
+        int64_t delayUs = nowUs - mLastReportTimeUs;
+        mLastReportTimeUs = nowUs;
+        --mNumActiveDownloads;
+
+        segment->mStatus = bytesRead < 0 ? (status_t)bytesRead : OK;
+        segment->mBuffer = buffer;
+        segment->mState = DONE;
+        mDoneCondition.broadcast();
+
+        if (bytesRead > 0 && !segment->mCancelled) {
+            sp<LiveSession> session = mSession.promote();
+            if (session != NULL) {
+                mLock.unlock();
+                session->addBandwidthMeasurement(bytesRead, delayUs);
+                mLock.lock();
+            }
+        } else if (bytesRead < 0 && !segment->mCancelled) {
+            ALOGW("failed to prefetch '%s': %zd", segment->mURI.c_str(), bytesRead);
+        }
+    }
+}
+
+}  // namespace android
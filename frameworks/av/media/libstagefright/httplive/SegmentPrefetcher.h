@@ -0,0 +1,118 @@
+/*
+ * Copyright 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SEGMENT_PREFETCHER_H_
+
+#define SEGMENT_PREFETCHER_H_
+
+#include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/AString.h>
+#include <pthread.h>
+#include <utils/Condition.h>
+#include <utils/List.h>
+#include <utils/Mutex.h>
+#include <utils/RefBase.h>
+
+namespace android {
+
+struct ABuffer;
+struct HTTPDownloader;
+struct LiveSession;
+
+// Downloads upcoming media segments of a playlist in the background, so that
+// the next segment is already on its way while the current one is parsed.
+// Each worker owns an HTTPDownloader that is reused across segments, which
+// lets the HTTP stack keep its connection alive between requests.
+struct SegmentPrefetcher : public RefBase {
+    explicit SegmentPrefetcher(const sp<LiveSession> &session);
+
+    // Starts downloading the given segment unless it is already requested.
+    // Returns false if kMaxPrefetchedSegments segments are outstanding and
+    // the segment could not be added.
+    bool prefetch(const AString &uri, int64_t rangeOffset, int64_t rangeLength);
+
+    // Removes the given segment from the prefetcher, blocking while it is
+    // still downloading. Returns NAME_NOT_FOUND if the download has not
+    // started, otherwise the result of the download.
+    status_t take(
+            const AString &uri, int64_t rangeOffset, int64_t rangeLength,
+            sp<ABuffer> *buffer);
+
+    // Drops all outstanding segments and aborts downloads in progress.
+    void cancel();
+
+protected:
+    virtual ~SegmentPrefetcher();
+
+private:
+    enum {
+        kMaxConcurrentDownloads = 2,
+        kMaxPrefetchedSegments  = 2,
+    };
+
+    enum State {
+        QUEUED,
+        DOWNLOADING,
+        DONE,
+    };
+
+    struct Segment : public RefBase {
+        AString mURI;
+        int64_t mRangeOffset;
+        int64_t mRangeLength;
+        State mState;
+        bool mCancelled;
+        size_t mWorkerIndex;
+        status_t mStatus;
+        sp<ABuffer> mBuffer;
+    };
+
+    struct Worker {
+        SegmentPrefetcher *mOwner;
+        size_t mIndex;
+        pthread_t mThread;
+        sp<HTTPDownloader> mDownloader;
+    };
+
+    wp<LiveSession> mSession;
+
+    Mutex mLock;
+    Condition mWorkCondition;
+    Condition mDoneCondition;
+    List<sp<Segment> > mSegments;
+    Worker mWorkers[kMaxConcurrentDownloads];
+    bool mStarted;
+    bool mExiting;
+
+    // Throughput is reported for the time any download was in progress,
+    // so concurrent downloads add up to the bandwidth of the link rather
+    // than each measuring a fraction of it.
+    size_t mNumActiveDownloads;
+    int64_t mLastReportTimeUs;
+
+    static void *ThreadWrapper(void *me);
+    void threadLoop(Worker *worker);
+
+    sp<Segment> findSegment_l(
+            const AString &uri, int64_t rangeOffset, int64_t rangeLength) const;
+    void removeSegment_l(const sp<Segment> &segment);
+
+    DISALLOW_EVIL_CONSTRUCTORS(SegmentPrefetcher);
+};
+
+}  // namespace android
+
+#endif  // SEGMENT_PREFETCHER_H_
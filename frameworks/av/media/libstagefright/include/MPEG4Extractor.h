@@ -88,6 +88,7 @@ private:
     off64_t mMoofOffset;
     bool mMoofFound;
     bool mMdatFound;
+    bool mMoovCached;   // the whole moov box was fetched into an MPEG4DataSource
 
     Vector<PsshInfo> mPssh;
 
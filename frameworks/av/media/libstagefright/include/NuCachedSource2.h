@@ -21,6 +21,7 @@
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/foundation/AHandlerReflector.h>
 #include <media/stagefright/DataSource.h>
+#include <utils/List.h>
 
 namespace android {
 
@@ -89,6 +90,20 @@ private:
         // Read data after a 15 sec timeout whether we're actively
         // fetching or not.
         kDefaultKeepAliveIntervalUs     = 15000000,
+
+        // A single fetch reads as many pages as the measured throughput
+        // delivers in about kTargetFetchDurationUs, so that pending reads
+        // are not held up for long behind it.
+        kMaxPagesPerFetch               = 16,
+        kTargetFetchDurationUs          = 100000,
+
+        // On a seek outside the cached range, up to kMaxNumRetainedRegions
+        // previous ranges are kept, each trimmed to about
+        // kMaxRetainedRegionBytes starting kRetainedRegionLeadBytes before
+        // the last read position.
+        kMaxNumRetainedRegions          = 2,
+        kMaxRetainedRegionBytes         = 2 * 1024 * 1024,
+        kRetainedRegionLeadBytes        = 256 * 1024,
     };
 
     enum {
@@ -111,6 +126,16 @@ private:
 
     PageCache *mCache;
     off64_t mCacheOffset;
+
+    struct CachedRegion {
+        off64_t mOffset;
+        PageCache *mCache;
+    };
+    // Ranges cached before earlier seeks, most recently used first.
+    List<CachedRegion> mRetainedRegions;
+
+    size_t mPagesPerFetch;
+    int64_t mFetchBytesPerSec;  // smoothed, 0 until the first fetch
     status_t mFinalStatus;
     off64_t mLastAccessPos;
     sp<AMessage> mAsyncResult;
@@ -135,6 +160,9 @@ private:
     void fetchInternal();
     ssize_t readInternal(off64_t offset, void *data, size_t size);
     status_t seekInternal_l(off64_t offset);
+    void retainActiveRegion_l();
+    bool switchToRetainedRegion_l(off64_t offset);
+    void updateFetchSize_l(size_t bytesRead, int64_t durationUs);
 
     size_t approxDataRemaining_l(status_t *finalStatus) const;
 
@@ -144,6 +144,22 @@ private:
     // Approximate size of all tables combined.
     uint64_t mTotalSize;
 
+    // The sample size and chunk offset tables are not loaded, their entries are read on
+    // demand. Reads go through the kNumTableBlocks most recently used blocks of
+    // kTableBlockSize bytes, so walking a table costs one DataSource read per block
+    // rather than one per entry.
+    static const size_t kTableBlockSize = 4096;
+    static const size_t kNumTableBlocks = 8;
+
+    struct TableBlock {
+        off64_t mOffset;    // source offset of mData, or -1 if unused
+        ssize_t mSize;      // valid bytes in mData
+        uint32_t mLastUse;
+        uint8_t mData[kTableBlockSize];
+    };
+    TableBlock *mTableBlocks;   // allocated on first use
+    uint32_t mTableBlockUseCount;
+
     friend struct SampleIterator;
 
     // normally we don't round
@@ -155,6 +171,9 @@ private:
     }
 
     status_t getSampleSize_l(uint32_t sample_index, size_t *sample_size);
+
+    // Same contract as DataSource::readAt(), served from the table blocks.
+    ssize_t readTableData_l(off64_t offset, void *data, size_t size);
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
 
     static int CompareIncreasingTime(const void *, const void *);
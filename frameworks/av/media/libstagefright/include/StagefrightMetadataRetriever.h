@@ -22,6 +22,7 @@
 #include <media/MediaMetadataRetrieverInterface.h>
 
 #include <utils/KeyedVector.h>
+#include <utils/Vector.h>
 
 namespace android {
 
@@ -44,6 +45,29 @@ struct StagefrightMetadataRetriever : public MediaMetadataRetrieverInterface {
     virtual MediaAlbumArt *extractAlbumArt();
     virtual const char *extractMetadata(int keyCode);
 
+    enum {
+        // Only decode the sync frame at or before each requested time, even
+        // if the seek option asks for the closest frame.
+        kExtractSyncFrameOnly = 1,
+    };
+
+    // Extracts a frame at each of |timesUs| from the current data source,
+    // decoding all of them with a single codec instance. |option| is the
+    // seek mode as for getFrameAtTime() and |flags| a combination of
+    // kExtract* values. If |maxDimension| is positive, frames are downscaled
+    // so that neither side exceeds it. |frames| receives one entry per time,
+    // NULL where extraction failed; the caller owns the returned frames.
+    status_t getFramesAtTimes(
+            const Vector<int64_t> &timesUs, int option, uint32_t flags,
+            int32_t maxDimension, Vector<VideoFrame *> *frames);
+
+    // Extracts the thumbnail frame of each file in |paths|, sharing decoder
+    // instances between files with an identical codec configuration.
+    // Arguments and results are as for getFramesAtTimes().
+    static status_t ExtractThumbnails(
+            const Vector<String8> &paths, int option, uint32_t flags,
+            int32_t maxDimension, Vector<VideoFrame *> *frames);
+
 private:
     sp<DataSource> mSource;
     sp<IMediaExtractor> mExtractor;
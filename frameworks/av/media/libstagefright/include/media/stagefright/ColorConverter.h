@@ -59,6 +59,8 @@ private:
         size_t mCropLeft, mCropTop, mCropRight, mCropBottom;
     };
 
+    struct Stripe;
+
     OMX_COLOR_FORMATTYPE mSrcFormat, mDstFormat;
     uint8_t *mClip;
 
@@ -70,9 +72,19 @@ private:
     status_t convertYUV420Planar(
             const BitmapParams &src, const BitmapParams &dst);
 
-    status_t convertYUV420PlanarUseLibYUV(
+    // Converts any format accepted by IsLibYUVSourceFormat() to RGB565 or
+    // RGBA8888, splitting large frames into stripes of rows that are
+    // converted on separate threads.
+    status_t convertUseLibYUV(
             const BitmapParams &src, const BitmapParams &dst);
 
+    void convertRowsUseLibYUV(
+            const BitmapParams &src, const BitmapParams &dst,
+            size_t firstRow, size_t numRows);
+
+    static bool IsLibYUVSourceFormat(OMX_COLOR_FORMATTYPE format);
+    static void *StripeThreadWrapper(void *me);
+
     status_t convertQCOMYUV420SemiPlanar(
             const BitmapParams &src, const BitmapParams &dst);
 
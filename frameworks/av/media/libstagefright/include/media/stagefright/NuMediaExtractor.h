@@ -22,6 +22,7 @@
 #include <media/IMediaExtractor.h>
 #include <utils/Errors.h>
 #include <utils/KeyedVector.h>
+#include <utils/List.h>
 #include <utils/RefBase.h>
 #include <utils/String8.h>
 #include <utils/threads.h>
@@ -94,6 +95,8 @@ private:
 
     enum {
         kMaxTrackCount = 16384,
+        // Samples requested per readMultiple() call on remote sources.
+        kMaxReadAheadSamples = 16,
     };
 
     struct TrackInfo {
@@ -102,6 +105,8 @@ private:
         status_t mFinalResult;
         MediaBuffer *mSample;
         int64_t mSampleTimeUs;
+        // Samples following mSample that were returned by the same readMultiple() call.
+        List<MediaBuffer *> mReadAheadSamples;
 
         uint32_t mTrackFlags;  // bitmask of "TrackFlags"
     };
@@ -123,6 +128,8 @@ private:
                 MediaSource::ReadOptions::SEEK_CLOSEST_SYNC);
 
     void releaseTrackSamples();
+    status_t readTrackSample(TrackInfo *info, MediaSource::ReadOptions *options);
+    static void releaseReadAheadSamples(TrackInfo *info);
 
     bool getTotalBitrate(int64_t *bitRate) const;
     status_t updateDurationAndBitrate();
@@ -18,6 +18,8 @@
 
 #define A_HANDLER_H_
 
+#include <string.h>
+
 #include <media/stagefright/foundation/ALooper.h>
 #include <utils/KeyedVector.h>
 #include <utils/RefBase.h>
@@ -30,7 +32,9 @@ struct AHandler : public RefBase {
     AHandler()
         : mID(0),
           mVerboseStats(false),
-          mMessageCounter(0) {
+          mMessageCounter(0),
+          mMaxLatencyUs(0) {
+        memset(mLatencyHistogram, 0, sizeof(mLatencyHistogram));
     }
 
     ALooper::handler_id id() const {
@@ -69,7 +73,18 @@ private:
     uint32_t mMessageCounter;
     KeyedVector<uint32_t, uint32_t> mMessages;
 
-    void deliverMessage(const sp<AMessage> &msg);
+    // Dispatch latency is the time from when a message was due until it was
+    // delivered. Bucket i counts latencies below kLatencyBucketLimitUs[i];
+    // the last bucket counts everything above.
+    enum {
+        kNumLatencyBuckets = 8,
+    };
+    static const int64_t kLatencyBucketLimitUs[kNumLatencyBuckets - 1];
+    uint32_t mLatencyHistogram[kNumLatencyBuckets];
+    int64_t mMaxLatencyUs;
+
+    void deliverMessage(const sp<AMessage> &msg, int64_t latencyUs);
+    void clearStats();
 
     DISALLOW_EVIL_CONSTRUCTORS(AHandler);
 };
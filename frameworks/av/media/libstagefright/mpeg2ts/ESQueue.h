@@ -130,6 +130,11 @@ private:
 
     sp<ABuffer> dequeueScrambledAccessUnit();
 
+    // drop the first "size" bytes of mBuffer. Access units are returned as
+    // slices of mBuffer, so the dropped bytes are never overwritten while
+    // one of them is still alive.
+    void consumeBuffer(size_t size);
+
     DISALLOW_EVIL_CONSTRUCTORS(ElementaryStreamQueue);
 };
 
@@ -107,14 +107,18 @@ struct BufferMeta {
           mCopyFromOmx(portIndex == kPortIndexOutput && copy),
           mCopyToOmx(portIndex == kPortIndexInput && copy),
           mPortIndex(portIndex),
-          mBackup(backup) {
+          mBackup(backup),
+          mNumCopies(0),
+          mCopiedBytes(0) {
     }
 
     explicit BufferMeta(OMX_U32 portIndex)
         : mCopyFromOmx(false),
           mCopyToOmx(false),
           mPortIndex(portIndex),
-          mBackup(NULL) {
+          mBackup(NULL),
+          mNumCopies(0),
+          mCopiedBytes(0) {
     }
 
     explicit BufferMeta(const sp<GraphicBuffer> &graphicBuffer, OMX_U32 portIndex)
@@ -122,7 +126,9 @@ struct BufferMeta {
           mCopyFromOmx(false),
           mCopyToOmx(false),
           mPortIndex(portIndex),
-          mBackup(NULL) {
+          mBackup(NULL),
+          mNumCopies(0),
+          mCopiedBytes(0) {
     }
 
     OMX_U8 *getPointer() {
@@ -140,6 +146,8 @@ struct BufferMeta {
         sp<ABuffer> codec = getBuffer(header, true /* limit */);
 
         memcpy(getPointer() + header->nOffset, codec->data(), codec->size());
+        ++mNumCopies;
+        mCopiedBytes += codec->size();
     }
 
     void CopyToOMX(const OMX_BUFFERHEADERTYPE *header) {
@@ -150,6 +158,22 @@ struct BufferMeta {
         memcpy(header->pBuffer + header->nOffset,
                 getPointer() + header->nOffset,
                 header->nFilledLen);
+        ++mNumCopies;
+        mCopiedBytes += header->nFilledLen;
+    }
+
+    // whether data is copied between the client memory and the codec buffer
+    bool isCopying() const {
+        return mCopyFromOmx || mCopyToOmx;
+    }
+
+    // number of copies made so far, and their total size
+    size_t getNumCopies() const {
+        return mNumCopies;
+    }
+
+    uint64_t getCopiedBytes() const {
+        return mCopiedBytes;
     }
 
     // return the codec buffer
@@ -191,6 +215,8 @@ private:
     bool mCopyToOmx;
     OMX_U32 mPortIndex;
     OMX_U8 *mBackup;
+    size_t mNumCopies;
+    uint64_t mCopiedBytes;
 
     BufferMeta(const BufferMeta &);
     BufferMeta &operator=(const BufferMeta &);
@@ -1130,6 +1156,9 @@ status_t OMXNodeInstance::useBuffer_l(
             CLOG_ERROR(allocateBuffer, err,
                     SIMPLE_BUFFER(portIndex, (size_t)allottedSize,
                             paramsPointer));
+        } else if (buffer_meta->isCopying()) {
+            CLOG_CONFIG(useBuffer, "%s:%u requires allocated buffers, data will be copied",
+                    portString(portIndex), portIndex);
         }
     } else {
         OMX_U8 *data = NULL;
@@ -1541,6 +1570,12 @@ status_t OMXNodeInstance::freeBuffer(
     }
     BufferMeta *buffer_meta = static_cast<BufferMeta *>(header->pAppPrivate);
 
+    if (buffer_meta->getNumCopies() > 0) {
+        CLOG_CONFIG(freeBuffer, "%s:%u %#x was copied %zu times (%llu bytes)",
+                portString(portIndex), portIndex, buffer, buffer_meta->getNumCopies(),
+                (unsigned long long)buffer_meta->getCopiedBytes());
+    }
+
     OMX_ERRORTYPE err = OMX_FreeBuffer(mHandle, portIndex, header);
     CLOG_IF_ERROR(freeBuffer, err, "%s:%u %#x", portString(portIndex), portIndex, buffer);
 
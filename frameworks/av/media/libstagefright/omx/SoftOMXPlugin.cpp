@@ -69,6 +69,63 @@ static const size_t kNumComponents =
 SoftOMXPlugin::SoftOMXPlugin() {
 }
 
+SoftOMXPlugin::~SoftOMXPlugin() {
+    for (size_t i = 0; i < mLibraries.size(); ++i) {
+        dlclose(mLibraries.valueAt(i).mHandle);
+    }
+}
+
+bool SoftOMXPlugin::getLibrary(const char *libName, Library *library) {
+    Mutex::Autolock autoLock(mLock);
+
+    ssize_t index = mLibraries.indexOfKey(String8(libName));
+    if (index >= 0) {
+        *library = mLibraries.valueAt(index);
+        return true;
+    }
+
+    // RTLD_NODELETE means we keep the shared library around forever.
+    // this eliminates thrashing during sequences like loading soundpools.
+    // It also leaves the rest of the logic around the dlopen()/dlclose()
+    // calls in this file unchanged.
+    //
+    // Implications of the change:
+    // -- the codec process (where this happens) will have a slightly larger
+    //    long-term memory footprint as it accumulates the loaded shared libraries.
+    //    This is expected to be a small amount of memory.
+    // -- plugin codecs can no longer (and never should have) depend on a
+    //    free reset of any static data as the library would have crossed
+    //    a dlclose/dlopen cycle.
+    //
+
+    void *libHandle = dlopen(libName, RTLD_NOW|RTLD_NODELETE);
+
+    if (libHandle == NULL) {
+        ALOGE("unable to dlopen %s: %s", libName, dlerror());
+
+        return false;
+    }
+
+    CreateSoftOMXComponentFunc createSoftOMXComponent =
+        (CreateSoftOMXComponentFunc)dlsym(
+                libHandle,
+                "_Z22createSoftOMXComponentPKcPK16OMX_CALLBACKTYPE"
+                "PvPP17OMX_COMPONENTTYPE");
+
+    if (createSoftOMXComponent == NULL) {
+        dlclose(libHandle);
+        libHandle = NULL;
+
+        return false;
+    }
+
+    library->mHandle = libHandle;
+    library->mCreate = createSoftOMXComponent;
+    mLibraries.add(String8(libName), *library);
+
+    return true;
+}
+
 OMX_ERRORTYPE SoftOMXPlugin::makeComponentInstance(
         const char *name,
         const OMX_CALLBACKTYPE *callbacks,
@@ -85,65 +142,25 @@ OMX_ERRORTYPE SoftOMXPlugin::makeComponentInstance(
         libName.append(kComponents[i].mLibNameSuffix);
         libName.append(".so");
 
-        // RTLD_NODELETE means we keep the shared library around forever.
-        // this eliminates thrashing during sequences like loading soundpools.
-        // It also leaves the rest of the logic around the dlopen()/dlclose()
-        // calls in this file unchanged.
-        //
-        // Implications of the change:
-        // -- the codec process (where this happens) will have a slightly larger
-        //    long-term memory footprint as it accumulates the loaded shared libraries.
-        //    This is expected to be a small amount of memory.
-        // -- plugin codecs can no longer (and never should have) depend on a
-        //    free reset of any static data as the library would have crossed
-        //    a dlclose/dlopen cycle.
-        //
-
-        void *libHandle = dlopen(libName.c_str(), RTLD_NOW|RTLD_NODELETE);
-
-        if (libHandle == NULL) {
-            ALOGE("unable to dlopen %s: %s", libName.c_str(), dlerror());
-
-            return OMX_ErrorComponentNotFound;
-        }
-
-        typedef SoftOMXComponent *(*CreateSoftOMXComponentFunc)(
-                const char *, const OMX_CALLBACKTYPE *,
-                OMX_PTR, OMX_COMPONENTTYPE **);
-
-        CreateSoftOMXComponentFunc createSoftOMXComponent =
-            (CreateSoftOMXComponentFunc)dlsym(
-                    libHandle,
-                    "_Z22createSoftOMXComponentPKcPK16OMX_CALLBACKTYPE"
-                    "PvPP17OMX_COMPONENTTYPE");
-
-        if (createSoftOMXComponent == NULL) {
-            dlclose(libHandle);
-            libHandle = NULL;
-
+        Library library;
+        if (!getLibrary(libName.c_str(), &library)) {
             return OMX_ErrorComponentNotFound;
         }
 
         sp<SoftOMXComponent> codec =
-            (*createSoftOMXComponent)(name, callbacks, appData, component);
+            (*library.mCreate)(name, callbacks, appData, component);
 
         if (codec == NULL) {
-            dlclose(libHandle);
-            libHandle = NULL;
-
             return OMX_ErrorInsufficientResources;
         }
 
         OMX_ERRORTYPE err = codec->initCheck();
         if (err != OMX_ErrorNone) {
-            dlclose(libHandle);
-            libHandle = NULL;
-
             return err;
         }
 
         codec->incStrong(this);
-        codec->setLibHandle(libHandle);
+        codec->setLibHandle(library.mHandle);
 
         return OMX_ErrorNone;
     }
@@ -159,15 +176,11 @@ OMX_ERRORTYPE SoftOMXPlugin::destroyComponentInstance(
 
     me->prepareForDestruction();
 
-    void *libHandle = me->libHandle();
-
+    // The library stays loaded; its handle belongs to mLibraries.
     CHECK_EQ(me->getStrongCount(), 1);
     me->decStrong(this);
     me = NULL;
 
-    dlclose(libHandle);
-    libHandle = NULL;
-
     return OMX_ErrorNone;
 }
 
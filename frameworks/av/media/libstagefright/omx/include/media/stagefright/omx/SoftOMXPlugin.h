@@ -20,11 +20,17 @@
 
 #include <media/stagefright/foundation/ABase.h>
 #include <OMXPluginBase.h>
+#include <utils/KeyedVector.h>
+#include <utils/Mutex.h>
+#include <utils/String8.h>
 
 namespace android {
 
+struct SoftOMXComponent;
+
 struct SoftOMXPlugin : public OMXPluginBase {
     SoftOMXPlugin();
+    virtual ~SoftOMXPlugin();
 
     virtual OMX_ERRORTYPE makeComponentInstance(
             const char *name,
@@ -45,6 +51,23 @@ struct SoftOMXPlugin : public OMXPluginBase {
             Vector<String8> *roles);
 
 private:
+    typedef SoftOMXComponent *(*CreateSoftOMXComponentFunc)(
+            const char *, const OMX_CALLBACKTYPE *,
+            OMX_PTR, OMX_COMPONENTTYPE **);
+
+    struct Library {
+        void *mHandle;
+        CreateSoftOMXComponentFunc mCreate;
+    };
+
+    // Codec libraries loaded so far, keyed by library name. They stay loaded
+    // until the plugin goes away, so that creating another instance of a
+    // codec doesn't go through dlopen() and dlsym() again.
+    Mutex mLock;
+    KeyedVector<String8, Library> mLibraries;
+
+    bool getLibrary(const char *libName, Library *library);
+
     DISALLOW_EVIL_CONSTRUCTORS(SoftOMXPlugin);
 };
 
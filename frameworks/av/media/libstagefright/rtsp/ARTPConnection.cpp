@@ -31,7 +31,9 @@
 #include <media/stagefright/foundation/hexdump.h>
 
 #include <arpa/inet.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
+#include <unistd.h>
 
 namespace android {
 
@@ -50,7 +52,7 @@ static uint64_t u64at(const uint8_t *data) {
 }
 
 // static
-const int64_t ARTPConnection::kSelectTimeoutUs = 1000ll;
+const int64_t ARTPConnection::kPollTimeoutUs = 1000ll;
 
 struct ARTPConnection::StreamInfo {
     int mRTPSocket;
@@ -69,11 +71,14 @@ struct ARTPConnection::StreamInfo {
 
 ARTPConnection::ARTPConnection(uint32_t flags)
     : mFlags(flags),
+      mEpollFd(epoll_create1(EPOLL_CLOEXEC)),
       mPollEventPending(false),
       mLastReceiverReportTimeUs(-1) {
+    CHECK_GE(mEpollFd, 0);
 }
 
 ARTPConnection::~ARTPConnection() {
+    close(mEpollFd);
 }
 
 void ARTPConnection::addStream(
@@ -206,6 +211,14 @@ void ARTPConnection::onAddStream(const sp<AMessage> &msg) {
     memset(&info->mRemoteRTCPAddr, 0, sizeof(info->mRemoteRTCPAddr));
 
     if (!injected) {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = info->mRTPSocket;
+        CHECK_EQ(epoll_ctl(mEpollFd, EPOLL_CTL_ADD, info->mRTPSocket, &event), 0);
+        event.data.fd = info->mRTCPSocket;
+        CHECK_EQ(epoll_ctl(mEpollFd, EPOLL_CTL_ADD, info->mRTCPSocket, &event), 0);
+
         postPollEvent();
     }
 }
@@ -225,7 +238,19 @@ void ARTPConnection::onRemoveStream(const sp<AMessage> &msg) {
         return;
     }
 
-    mStreams.erase(it);
+    eraseStream(it);
+}
+
+List<ARTPConnection::StreamInfo>::iterator ARTPConnection::eraseStream(
+        List<StreamInfo>::iterator it) {
+    if (!it->mIsInjected) {
+        // The owner may already have closed the sockets, which drops them
+        // from the epoll set on its own.
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, it->mRTPSocket, NULL);
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, it->mRTCPSocket, NULL);
+    }
+
+    return mStreams.erase(it);
 }
 
 void ARTPConnection::postPollEvent() {
@@ -246,62 +271,50 @@ void ARTPConnection::onPollStreams() {
         return;
     }
 
-    struct timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = kSelectTimeoutUs;
-
-    fd_set rs;
-    FD_ZERO(&rs);
-
-    int maxSocket = -1;
+    bool polling = false;
     for (List<StreamInfo>::iterator it = mStreams.begin();
          it != mStreams.end(); ++it) {
-        if ((*it).mIsInjected) {
-            continue;
-        }
-
-        FD_SET(it->mRTPSocket, &rs);
-        FD_SET(it->mRTCPSocket, &rs);
-
-        if (it->mRTPSocket > maxSocket) {
-            maxSocket = it->mRTPSocket;
-        }
-        if (it->mRTCPSocket > maxSocket) {
-            maxSocket = it->mRTCPSocket;
+        if (!(*it).mIsInjected) {
+            polling = true;
+            break;
         }
     }
 
-    if (maxSocket == -1) {
+    if (!polling) {
         return;
     }
 
-    int res = select(maxSocket + 1, &rs, NULL, NULL, &tv);
+    // Sockets that don't fit in here are reported again by the next poll.
+    struct epoll_event events[16];
+    int res;
+    do {
+        res = epoll_wait(
+                mEpollFd, events, sizeof(events) / sizeof(events[0]),
+                (int)(kPollTimeoutUs / 1000ll));
+    } while (res < 0 && errno == EINTR);
+
+    for (int i = 0; i < res; ++i) {
+        int fd = events[i].data.fd;
 
-    if (res > 0) {
         List<StreamInfo>::iterator it = mStreams.begin();
-        while (it != mStreams.end()) {
-            if ((*it).mIsInjected) {
-                ++it;
-                continue;
-            }
+        while (it != mStreams.end()
+               && (it->mIsInjected
+                   || (it->mRTPSocket != fd && it->mRTCPSocket != fd))) {
+            ++it;
+        }
 
-            status_t err = OK;
-            if (FD_ISSET(it->mRTPSocket, &rs)) {
-                err = receive(&*it, true);
-            }
-            if (err == OK && FD_ISSET(it->mRTCPSocket, &rs)) {
-                err = receive(&*it, false);
-            }
+        if (it == mStreams.end()) {
+            // The stream went away with an earlier event of this batch.
+            continue;
+        }
 
-            if (err == -ECONNRESET) {
-                // socket failure, this stream is dead, Jim.
+        status_t err = receive(&*it, fd == it->mRTPSocket);
 
-                ALOGW("failed to receive RTP/RTCP datagram.");
-                it = mStreams.erase(it);
-                continue;
-            }
+        if (err == -ECONNRESET) {
+            // socket failure, this stream is dead, Jim.
 
-            ++it;
+            ALOGW("failed to receive RTP/RTCP datagram.");
+            eraseStream(it);
         }
     }
 
@@ -352,7 +365,7 @@ void ARTPConnection::onPollStreams() {
                     ALOGW("failed to send RTCP receiver report (%s).",
                          n == 0 ? "connection gone" : strerror(errno));
 
-                    it = mStreams.erase(it);
+                    it = eraseStream(it);
                     continue;
                 }
 
@@ -375,39 +388,73 @@ status_t ARTPConnection::receive(StreamInfo *s, bool receiveRTP) {
 
     CHECK(!s->mIsInjected);
 
-    sp<ABuffer> buffer = new ABuffer(65536);
+    if (mReceiveBuffers[0] == NULL) {
+        for (size_t i = 0; i < kMaxReceiveBatch; ++i) {
+            mReceiveBuffers[i] = new ABuffer(65536);
+        }
+    }
 
-    socklen_t remoteAddrLen =
-        (!receiveRTP && s->mNumRTCPPacketsReceived == 0)
-            ? sizeof(s->mRemoteRTCPAddr) : 0;
+    // Only the first RTCP packet tells us where to send receiver reports,
+    // and a batch may bring several, so every datagram gets its own address.
+    struct sockaddr_in remoteAddrs[kMaxReceiveBatch];
+    struct iovec iovs[kMaxReceiveBatch];
+    struct mmsghdr msgs[kMaxReceiveBatch];
+    memset(msgs, 0, sizeof(msgs));
+
+    bool wantRemoteAddr = !receiveRTP && s->mNumRTCPPacketsReceived == 0;
+    for (size_t i = 0; i < kMaxReceiveBatch; ++i) {
+        iovs[i].iov_base = mReceiveBuffers[i]->data();
+        iovs[i].iov_len = mReceiveBuffers[i]->capacity();
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        if (wantRemoteAddr) {
+            msgs[i].msg_hdr.msg_name = &remoteAddrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(remoteAddrs[i]);
+        }
+    }
 
-    ssize_t nbytes;
+    // Whatever doesn't fit in this batch wakes up the next poll right away.
+    int count;
     do {
-        nbytes = recvfrom(
+        count = recvmmsg(
             receiveRTP ? s->mRTPSocket : s->mRTCPSocket,
-            buffer->data(),
-            buffer->capacity(),
-            0,
-            remoteAddrLen > 0 ? (struct sockaddr *)&s->mRemoteRTCPAddr : NULL,
-            remoteAddrLen > 0 ? &remoteAddrLen : NULL);
-    } while (nbytes < 0 && errno == EINTR);
-
-    if (nbytes <= 0) {
+            msgs, kMaxReceiveBatch, MSG_DONTWAIT, NULL);
+    } while (count < 0 && errno == EINTR);
+
+    if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return OK;
+    }
+
+    if (count <= 0) {
         return -ECONNRESET;
     }
 
-    buffer->setRange(0, nbytes);
+    ALOGV("received %d %s datagrams", count, receiveRTP ? "RTP" : "RTCP");
 
-    // ALOGI("received %d bytes.", buffer->size());
+    for (int i = 0; i < count; ++i) {
+        size_t nbytes = msgs[i].msg_len;
+        if (nbytes == 0) {
+            return -ECONNRESET;
+        }
 
-    status_t err;
-    if (receiveRTP) {
-        err = parseRTP(s, buffer);
-    } else {
-        err = parseRTCP(s, buffer);
+        if (!receiveRTP && s->mNumRTCPPacketsReceived == 0) {
+            memcpy(&s->mRemoteRTCPAddr, &remoteAddrs[i], sizeof(s->mRemoteRTCPAddr));
+        }
+
+        // The packet outlives this call in the assemblers, so hand them a
+        // buffer of its own size rather than the scratch space.
+        sp<ABuffer> buffer = new ABuffer(nbytes);
+        memcpy(buffer->data(), mReceiveBuffers[i]->data(), nbytes);
+
+        // Malformed packets are dropped and don't affect the rest of the batch.
+        if (receiveRTP) {
+            parseRTP(s, buffer);
+        } else {
+            parseRTCP(s, buffer);
+        }
     }
 
-    return err;
+    return OK;
 }
 
 status_t ARTPConnection::parseRTP(StreamInfo *s, const sp<ABuffer> &buffer) {
@@ -62,16 +62,25 @@ private:
         kWhatInjectPacket,
     };
 
-    static const int64_t kSelectTimeoutUs;
+    static const int64_t kPollTimeoutUs;
+
+    // Up to this many datagrams are read from a socket with each recvmmsg().
+    enum { kMaxReceiveBatch = 8 };
 
     uint32_t mFlags;
 
     struct StreamInfo;
     List<StreamInfo> mStreams;
 
+    // Watches the sockets of all streams that aren't injected.
+    int mEpollFd;
+
     bool mPollEventPending;
     int64_t mLastReceiverReportTimeUs;
 
+    // Scratch space recvmmsg() reads into, allocated on first use.
+    sp<ABuffer> mReceiveBuffers[kMaxReceiveBatch];
+
     void onAddStream(const sp<AMessage> &msg);
     void onRemoveStream(const sp<AMessage> &msg);
     void onPollStreams();
@@ -80,6 +89,8 @@ private:
 
     status_t receive(StreamInfo *info, bool receiveRTP);
 
+    List<StreamInfo>::iterator eraseStream(List<StreamInfo>::iterator it);
+
     status_t parseRTP(StreamInfo *info, const sp<ABuffer> &buffer);
     status_t parseRTCP(StreamInfo *info, const sp<ABuffer> &buffer);
     status_t parseSR(StreamInfo *info, const uint8_t *data, size_t size);
@@ -19,6 +19,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <sys/syscall.h>
 
 #include "AsyncIO.h"
 
@@ -180,3 +181,19 @@ int aio_cancel(int, struct aiocb *) {
     return -1;
 }
 
+int io_setup(unsigned nr_events, aio_context_t *ctx_idp) {
+    return syscall(__NR_io_setup, nr_events, ctx_idp);
+}
+
+int io_destroy(aio_context_t ctx_id) {
+    return syscall(__NR_io_destroy, ctx_id);
+}
+
+int io_submit(aio_context_t ctx_id, long nr, struct iocb **iocbpp) {
+    return syscall(__NR_io_submit, ctx_id, nr, iocbpp);
+}
+
+int io_getevents(aio_context_t ctx_id, long min_nr, long max_nr,
+        struct io_event *events, struct timespec *timeout) {
+    return syscall(__NR_io_getevents, ctx_id, min_nr, max_nr, events, timeout);
+}
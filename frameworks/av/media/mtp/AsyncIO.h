@@ -79,5 +79,13 @@ void aio_pool_end();
 // freed automatically when the work is complete.
 int aio_pool_write(struct aiocb *);
 
+// Wrappers for the native Linux AIO syscalls. Unlike the functions above these
+// do not need a thread per request, so many requests can be kept in flight.
+int io_setup(unsigned nr_events, aio_context_t *ctx_idp);
+int io_destroy(aio_context_t ctx_id);
+int io_submit(aio_context_t ctx_id, long nr, struct iocb **iocbpp);
+int io_getevents(aio_context_t ctx_id, long min_nr, long max_nr,
+        struct io_event *events, struct timespec *timeout);
+
 #endif // ASYNCIO_H
 
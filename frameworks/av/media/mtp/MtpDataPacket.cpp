@@ -439,6 +439,14 @@ void MtpDataPacket::putString(const uint16_t* string) {
         putUInt16(0);
 }
 
+void MtpDataPacket::putData(const void* data, size_t length) {
+    allocate(mOffset + length);
+    memcpy(mBuffer + mOffset, data, length);
+    mOffset += length;
+    if (mPacketSize < mOffset)
+        mPacketSize = mOffset;
+}
+
 #ifdef MTP_DEVICE
 int MtpDataPacket::read(IMtpHandle *h) {
     int ret = h->read(mBuffer, MTP_BUFFER_SIZE);
@@ -93,6 +93,8 @@ public:
     void                putString(const uint16_t* string);
     inline void         putEmptyString() { putUInt8(0); }
     inline void         putEmptyArray() { putUInt32(0); }
+    // appends already encoded data
+    void                putData(const void* data, size_t length);
 
 #ifdef MTP_DEVICE
     // fill our buffer with data from the given usb handle
@@ -122,6 +124,7 @@ public:
 #endif
 
     inline bool         hasData() const { return mPacketSize > MTP_CONTAINER_HEADER_SIZE; }
+    inline size_t       getDataSize() const { return mPacketSize - MTP_CONTAINER_HEADER_SIZE; }
     inline uint32_t     getContainerLength() const { return MtpPacket::getUInt32(MTP_CONTAINER_LENGTH_OFFSET); }
     void*               getData(int* outLength) const;
 };
@@ -53,7 +53,14 @@ constexpr int MAX_PACKET_SIZE_HS = 512;
 constexpr int MAX_PACKET_SIZE_SS = 1024;
 
 // Must be divisible by all max packet size values
-constexpr int MAX_FILE_CHUNK_SIZE = 3145728;
+constexpr int MAX_FILE_CHUNK_SIZE = 1048576;
+
+// File sized buffers cycled through by sendFile / receiveFile. Each one can
+// have a file read or write in flight while the others are sent over USB.
+constexpr int NUM_IO_BUFS = 4;
+
+// Maximum number of USB requests of mMaxRead / mMaxWrite bytes in flight.
+constexpr int NUM_USB_REQUESTS = 16;
 
 // Safe values since some devices cannot handle large DMAs
 // To get good performance, override these with
@@ -293,9 +300,21 @@ namespace android {
 
 MtpFfsHandle::MtpFfsHandle() :
     mMaxWrite(USB_FFS_MAX_WRITE),
-    mMaxRead(USB_FFS_MAX_READ) {}
+    mMaxRead(USB_FFS_MAX_READ),
+    mCtx(0),
+    mIobuf(NUM_IO_BUFS),
+    mUsbRequests(NUM_USB_REQUESTS) {
+    if (io_setup(NUM_IO_BUFS + NUM_USB_REQUESTS, &mCtx) == -1) {
+        PLOG(ERROR) << "unable to set up aio context, using blocking io";
+        mCtx = 0;
+    }
+}
 
-MtpFfsHandle::~MtpFfsHandle() {}
+MtpFfsHandle::~MtpFfsHandle() {
+    if (mCtx != 0) {
+        io_destroy(mCtx);
+    }
+}
 
 void MtpFfsHandle::closeEndpoints() {
     mIntr.reset();
@@ -424,6 +443,134 @@ int MtpFfsHandle::spliceReadHandle(int fd, int pipe_out, int len) {
     return ret;
 }
 
+// Queues |req| on the aio context. If native aio is not available for |fd|
+// the transfer is done synchronously and |req| is complete on return.
+// |stream| is set for endpoints, which have no file position.
+void MtpFfsHandle::submitRequest(io_request *req, int fd, int opcode, char *buf, size_t len,
+        uint64_t offset, bool stream) {
+    memset(&req->cb, 0, sizeof(req->cb));
+    req->cb.aio_data = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(req));
+    req->cb.aio_lio_opcode = opcode;
+    req->cb.aio_fildes = fd;
+    req->cb.aio_buf = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(buf));
+    req->cb.aio_nbytes = len;
+    req->cb.aio_offset = offset;
+    req->pending = true;
+    req->done = false;
+
+    struct iocb *cbs[] = {&req->cb};
+    if (mCtx != 0 && io_submit(mCtx, 1, cbs) == 1) {
+        return;
+    }
+
+    ssize_t n;
+    if (opcode == IOCB_CMD_PREAD) {
+        n = stream ? TEMP_FAILURE_RETRY(::read(fd, buf, len))
+                : TEMP_FAILURE_RETRY(pread(fd, buf, len, offset));
+    } else {
+        n = stream ? TEMP_FAILURE_RETRY(::write(fd, buf, len))
+                : TEMP_FAILURE_RETRY(pwrite(fd, buf, len, offset));
+    }
+    req->res = n < 0 ? -errno : n;
+    req->done = true;
+}
+
+// Blocks until all |count| requests have completed. Completions of other
+// requests reaped along the way are recorded in those requests.
+void MtpFfsHandle::waitRequests(io_request *reqs, size_t count) {
+    struct io_event events[NUM_IO_BUFS + NUM_USB_REQUESTS];
+    for (size_t i = 0; i < count; i++) {
+        while (!reqs[i].done) {
+            int n = TEMP_FAILURE_RETRY(io_getevents(mCtx, 1,
+                    sizeof(events) / sizeof(events[0]), events, nullptr));
+            if (n < 0) {
+                PLOG(ERROR) << "io_getevents failed";
+                reqs[i].res = -errno;
+                reqs[i].done = true;
+                break;
+            }
+            for (int j = 0; j < n; j++) {
+                io_request *req = reinterpret_cast<io_request*>(
+                        static_cast<uintptr_t>(events[j].data));
+                req->res = events[j].res;
+                req->done = true;
+            }
+        }
+    }
+}
+
+// Collects the result of a file request. Returns the number of bytes
+// transferred, 0 if nothing was pending, or -1 on error or a short transfer.
+int MtpFfsHandle::waitFileRequest(io_request *req) {
+    if (!req->pending) {
+        return 0;
+    }
+    waitRequests(req, 1);
+    req->pending = false;
+    if (req->res < 0) {
+        errno = -req->res;
+        return -1;
+    }
+    if (static_cast<size_t>(req->res) < req->cb.aio_nbytes) {
+        errno = EIO;
+        return -1;
+    }
+    return req->res;
+}
+
+// Waits for every outstanding file request so the buffers can be reused.
+int MtpFfsHandle::waitAllFileRequests() {
+    int ret = 0;
+    for (io_buffer &buf : mIobuf) {
+        if (waitFileRequest(&buf.file) == -1) {
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+// Transfers |len| bytes between |buf| and the endpoint |fd|, keeping up to
+// NUM_USB_REQUESTS requests of |maxLen| bytes in flight. Returns the number of
+// bytes transferred, which is less than |len| if a read ended early, or -1.
+int MtpFfsHandle::transferHandle(int fd, int opcode, char *buf, int len, int maxLen) {
+    LOG(VERBOSE) << "MTP about to transfer fd = " << fd << ", len=" << len;
+    int ret = 0;
+    while (len > 0) {
+        size_t count = 0;
+        for (; count < mUsbRequests.size() && len > 0; count++) {
+            int req_len = std::min(maxLen, len);
+            submitRequest(&mUsbRequests[count], fd, opcode, buf, req_len, 0, true);
+            buf += req_len;
+            len -= req_len;
+        }
+        waitRequests(mUsbRequests.data(), count);
+
+        bool done_early = false;
+        for (size_t i = 0; i < count; i++) {
+            io_request &req = mUsbRequests[i];
+            req.pending = false;
+            if (req.res < 0) {
+                errno = -req.res;
+                PLOG(ERROR) << "transfer ERROR: fd = " << fd;
+                return -1;
+            }
+            ret += req.res;
+            if (static_cast<size_t>(req.res) < req.cb.aio_nbytes) {
+                if (opcode == IOCB_CMD_PWRITE) {
+                    errno = EIO;
+                    PLOG(ERROR) << "less written than expected";
+                    return -1;
+                }
+                done_early = true;
+            }
+        }
+        if (done_early) {
+            break;
+        }
+    }
+    return ret;
+}
+
 int MtpFfsHandle::read(void* data, int len) {
     return readHandle(mBulkOut, data, len);
 }
@@ -453,12 +600,11 @@ int MtpFfsHandle::start() {
         return -1;
     }
 
-    mBuffer1.resize(MAX_FILE_CHUNK_SIZE);
-    mBuffer2.resize(MAX_FILE_CHUNK_SIZE);
-    posix_madvise(mBuffer1.data(), MAX_FILE_CHUNK_SIZE,
-            POSIX_MADV_SEQUENTIAL | POSIX_MADV_WILLNEED);
-    posix_madvise(mBuffer2.data(), MAX_FILE_CHUNK_SIZE,
-            POSIX_MADV_SEQUENTIAL | POSIX_MADV_WILLNEED);
+    for (io_buffer &buf : mIobuf) {
+        buf.data.resize(MAX_FILE_CHUNK_SIZE);
+        posix_madvise(buf.data.data(), MAX_FILE_CHUNK_SIZE,
+                POSIX_MADV_SEQUENTIAL | POSIX_MADV_WILLNEED);
+    }
 
     // Get device specific r/w size
     mMaxWrite = android::base::GetIntProperty("sys.usb.ffs.max_write", USB_FFS_MAX_WRITE);
@@ -531,82 +677,67 @@ int MtpFfsHandle::receiveFile(mtp_file_range mfr, bool zero_packet) {
         packet_size = mBulkOut_desc.wMaxPacketSize;
     }
 
-    char *data = mBuffer1.data();
-    char *data2 = mBuffer2.data();
+    // Wait for the queued file writes before failing so that no request
+    // still refers to the buffers.
+    auto fail = [this]() {
+        int saved_errno = errno;
+        waitAllFileRequests();
+        errno = saved_errno;
+        return -1;
+    };
 
-    struct aiocb aio;
-    aio.aio_fildes = mfr.fd;
-    aio.aio_buf = nullptr;
-    struct aiocb *aiol[] = {&aio};
     int ret = -1;
     size_t length;
-    bool read = false;
-    bool write = false;
+    size_t i = 0;
 
     posix_fadvise(mfr.fd, 0, 0, POSIX_FADV_SEQUENTIAL | POSIX_FADV_NOREUSE);
 
-    // Break down the file into pieces that fit in buffers
-    while (file_length > 0 || write) {
-        if (file_length > 0) {
-            length = std::min(static_cast<uint32_t>(MAX_FILE_CHUNK_SIZE), file_length);
+    // Break down the file into pieces that fit in buffers. The write of each
+    // buffer stays in flight while the following buffers are filled from USB.
+    while (file_length > 0) {
+        io_buffer &buf = mIobuf[i];
+        char *data = buf.data.data();
 
-            // Read data from USB, handle errors after waiting for write thread.
-            ret = readHandle(mBulkOut, data, length);
-
-            if (file_length != MAX_MTP_FILE_SIZE && ret < static_cast<int>(length)) {
-                ret = -1;
-                errno = EIO;
-            }
-            read = true;
+        // The buffer may still be written out from the previous round.
+        if (waitFileRequest(&buf.file) == -1) {
+            return fail();
         }
 
-        if (write) {
-            // get the return status of the last write request
-            aio_suspend(aiol, 1, nullptr);
-
-            int written = aio_return(&aio);
-            if (written == -1) {
-                errno = aio_error(&aio);
-                return -1;
-            }
-            if (static_cast<size_t>(written) < aio.aio_nbytes) {
+        length = std::min(static_cast<uint32_t>(MAX_FILE_CHUNK_SIZE), file_length);
+        if (file_length == MAX_MTP_FILE_SIZE) {
+            // The end is only known from the short packet, so don't queue
+            // requests that could pick up data of the next transfer.
+            ret = readHandle(mBulkOut, data, length);
+        } else {
+            ret = transferHandle(mBulkOut, IOCB_CMD_PREAD, data, length, mMaxRead);
+            if (ret != -1 && ret < static_cast<int>(length)) {
+                ret = -1;
                 errno = EIO;
-                return -1;
             }
-            write = false;
         }
-
-        // If there was an error reading above
         if (ret == -1) {
-            return -1;
+            return fail();
         }
 
-        if (read) {
-            if (file_length == MAX_MTP_FILE_SIZE) {
-                // For larger files, receive until a short packet is received.
-                if (static_cast<size_t>(ret) < length) {
-                    file_length = 0;
-                }
-            } else {
-                // Receive an empty packet if size is a multiple of the endpoint size.
-                file_length -= ret;
+        if (file_length == MAX_MTP_FILE_SIZE) {
+            // For larger files, receive until a short packet is received.
+            if (static_cast<size_t>(ret) < length) {
+                file_length = 0;
             }
-            // Enqueue a new write request
-            aio.aio_buf = data;
-            aio.aio_sink = mfr.fd;
-            aio.aio_offset = offset;
-            aio.aio_nbytes = ret;
-            aio_write(&aio);
-
-            offset += ret;
-            std::swap(data, data2);
-
-            write = true;
-            read = false;
+        } else {
+            // Receive an empty packet if size is a multiple of the endpoint size.
+            file_length -= ret;
         }
+
+        submitRequest(&buf.file, mfr.fd, IOCB_CMD_PWRITE, data, ret, offset, false);
+        offset += ret;
+        i = (i + 1) % mIobuf.size();
+    }
+    if (waitAllFileRequests() == -1) {
+        return -1;
     }
     if (ret % packet_size == 0 || zero_packet) {
-        if (TEMP_FAILURE_RETRY(::read(mBulkOut, data, packet_size)) != 0) {
+        if (TEMP_FAILURE_RETRY(::read(mBulkOut, mIobuf[0].data.data(), packet_size)) != 0) {
             return -1;
         }
     }
@@ -634,18 +765,22 @@ int MtpFfsHandle::sendFile(mtp_file_range mfr) {
     int init_read_len = std::min(
             static_cast<uint64_t>(packet_size - sizeof(mtp_data_header)), file_length);
 
-    char *data = mBuffer1.data();
-    char *data2 = mBuffer2.data();
+    char *data = mIobuf[0].data.data();
 
     posix_fadvise(mfr.fd, 0, 0, POSIX_FADV_SEQUENTIAL | POSIX_FADV_NOREUSE);
 
-    struct aiocb aio;
-    aio.aio_fildes = mfr.fd;
-    struct aiocb *aiol[] = {&aio};
-    int ret, length;
-    int error = 0;
-    bool read = false;
-    bool write = false;
+    // Wait for the queued file reads before failing so that no request
+    // still refers to the buffers.
+    auto fail = [this]() {
+        int saved_errno = errno;
+        waitAllFileRequests();
+        errno = saved_errno;
+        return -1;
+    };
+
+    int ret;
+    uint64_t length;
+    size_t i = 0;
 
     // Send the header data
     mtp_data_header *header = reinterpret_cast<mtp_data_header*>(data);
@@ -664,48 +799,39 @@ int MtpFfsHandle::sendFile(mtp_file_range mfr) {
     offset += init_read_len;
     ret = init_read_len + sizeof(mtp_data_header);
 
-    // Break down the file into pieces that fit in buffers
-    while(file_length > 0) {
-        if (read) {
-            // Wait for the previous read to finish
-            aio_suspend(aiol, 1, nullptr);
-            ret = aio_return(&aio);
-            if (ret == -1) {
-                errno = aio_error(&aio);
-                return -1;
-            }
-            if (static_cast<size_t>(ret) < aio.aio_nbytes) {
-                errno = EIO;
-                return -1;
-            }
-
-            file_length -= ret;
-            offset += ret;
-            std::swap(data, data2);
-            read = false;
-            write = true;
+    // Queue reads of the first pieces of the file into every buffer. Each buffer
+    // is refilled with the next unread piece once it has been sent.
+    uint64_t read_length = file_length;
+    for (io_buffer &buf : mIobuf) {
+        if (read_length == 0) {
+            break;
         }
+        length = std::min(static_cast<uint64_t>(MAX_FILE_CHUNK_SIZE), read_length);
+        submitRequest(&buf.file, mfr.fd, IOCB_CMD_PREAD, buf.data.data(), length, offset, false);
+        offset += length;
+        read_length -= length;
+    }
 
-        if (error == -1) {
-            return -1;
-        }
+    while (file_length > 0) {
+        io_buffer &buf = mIobuf[i];
 
-        if (file_length > 0) {
-            length = std::min(static_cast<uint64_t>(MAX_FILE_CHUNK_SIZE), file_length);
-            // Queue up another read
-            aio.aio_buf = data;
-            aio.aio_offset = offset;
-            aio.aio_nbytes = length;
-            aio_read(&aio);
-            read = true;
+        ret = waitFileRequest(&buf.file);
+        if (ret == -1) {
+            return fail();
         }
-
-        if (write) {
-            if (writeHandle(mBulkIn, data2, ret) == -1) {
-                error = -1;
-            }
-            write = false;
+        if (transferHandle(mBulkIn, IOCB_CMD_PWRITE, buf.data.data(), ret, mMaxWrite) == -1) {
+            return fail();
+        }
+        file_length -= ret;
+
+        if (read_length > 0) {
+            length = std::min(static_cast<uint64_t>(MAX_FILE_CHUNK_SIZE), read_length);
+            submitRequest(&buf.file, mfr.fd, IOCB_CMD_PREAD, buf.data.data(), length, offset,
+                    false);
+            offset += length;
+            read_length -= length;
         }
+        i = (i + 1) % mIobuf.size();
     }
 
     if (ret % packet_size == 0) {
@@ -18,6 +18,8 @@
 #define _MTP_FFS_HANDLE_H
 
 #include <android-base/unique_fd.h>
+#include <linux/aio_abi.h>
+#include <vector>
 #include <IMtpHandle.h>
 
 namespace android {
@@ -27,6 +29,20 @@ class MtpFfsHandleTest;
 class MtpFfsHandle : public IMtpHandle {
     friend class android::MtpFfsHandleTest;
 private:
+    // A single native aio request on a file or an endpoint.
+    struct io_request {
+        struct iocb cb;
+        bool pending;   // submitted, result not yet collected
+        bool done;      // completion has been reaped
+        int64_t res;    // bytes transferred, or -errno
+    };
+
+    // A file sized chunk buffer and the file read or write using it.
+    struct io_buffer {
+        std::vector<char> data;
+        io_request file;
+    };
+
     int writeHandle(int fd, const void *data, int len);
     int readHandle(int fd, void *data, int len);
     int spliceReadHandle(int fd, int fd_out, int len);
@@ -34,6 +50,13 @@ private:
     void closeConfig();
     void closeEndpoints();
 
+    void submitRequest(io_request *req, int fd, int opcode, char *buf, size_t len,
+            uint64_t offset, bool stream);
+    void waitRequests(io_request *reqs, size_t count);
+    int waitFileRequest(io_request *req);
+    int waitAllFileRequests();
+    int transferHandle(int fd, int opcode, char *buf, int len, int maxLen);
+
     bool mPtp;
 
     std::timed_mutex mLock;
@@ -48,8 +71,9 @@ private:
     int mMaxWrite;
     int mMaxRead;
 
-    std::vector<char> mBuffer1;
-    std::vector<char> mBuffer2;
+    aio_context_t mCtx;
+    std::vector<io_buffer> mIobuf;
+    std::vector<io_request> mUsbRequests;
 
 public:
     int read(void *data, int len);
@@ -115,7 +115,8 @@ MtpServer::MtpServer(MtpDatabase* database, bool ptp,
         mSendObjectHandle(kInvalidObjectHandle),
         mSendObjectFormat(0),
         mSendObjectFileSize(0),
-        mSendObjectModifiedTime(0)
+        mSendObjectModifiedTime(0),
+        mObjectsAdded(false)
 {
 }
 
@@ -269,11 +270,19 @@ void MtpServer::run() {
 
 void MtpServer::sendObjectAdded(MtpObjectHandle handle) {
     ALOGV("sendObjectAdded %d\n", handle);
+    {
+        std::lock_guard<std::mutex> lock(mObjectEventLock);
+        mObjectsAdded = true;
+    }
     sendEvent(MTP_EVENT_OBJECT_ADDED, handle);
 }
 
 void MtpServer::sendObjectRemoved(MtpObjectHandle handle) {
     ALOGV("sendObjectRemoved %d\n", handle);
+    {
+        std::lock_guard<std::mutex> lock(mObjectEventLock);
+        mRemovedObjects.push_back(handle);
+    }
     sendEvent(MTP_EVENT_OBJECT_REMOVED, handle);
 }
 
@@ -332,12 +341,67 @@ void MtpServer::removeEditObject(MtpObjectHandle handle) {
 
 void MtpServer::commitEdit(ObjectEdit* edit) {
     mDatabase->endSendObject((const char *)edit->mPath, edit->mHandle, edit->mFormat, true);
+    objectChanged(edit->mHandle);
+}
+
+// Returns the storage whose object index contains |handle|, if any.
+MtpStorage* MtpServer::getObjectStorage(MtpObjectHandle handle) {
+    for (size_t i = 0; i < mStorages.size(); i++) {
+        if (mStorages[i]->hasObject(handle))
+            return mStorages[i];
+    }
+    return nullptr;
+}
+
+bool MtpServer::getObjectChildren(MtpStorage* storage, MtpObjectHandle parent,
+        MtpObjectHandleList& outHandles) {
+    if (storage->getObjectList(0, parent, outHandles))
+        return true;
+    MtpObjectHandleList* handles =
+            mDatabase->getObjectList(storage->getStorageID(), 0, parent);
+    if (!handles)
+        return false;
+    storage->setObjectList(0, parent, *handles);
+    outHandles = *handles;
+    delete handles;
+    return true;
+}
+
+void MtpServer::objectChanged(MtpObjectHandle handle) {
+    for (size_t i = 0; i < mStorages.size(); i++)
+        mStorages[i]->objectChanged(handle);
+}
+
+void MtpServer::objectRemoved(MtpObjectHandle handle) {
+    for (size_t i = 0; i < mStorages.size(); i++)
+        mStorages[i]->objectRemoved(handle);
+}
+
+void MtpServer::applyObjectEvents() {
+    bool objectsAdded;
+    std::vector<MtpObjectHandle> removedObjects;
+    {
+        std::lock_guard<std::mutex> lock(mObjectEventLock);
+        objectsAdded = mObjectsAdded;
+        mObjectsAdded = false;
+        removedObjects.swap(mRemovedObjects);
+    }
+    // the parent of an object added by the database is not known, so
+    // the handle lists of all storages have to be refetched
+    if (objectsAdded) {
+        for (size_t i = 0; i < mStorages.size(); i++)
+            mStorages[i]->invalidateObjectLists();
+    }
+    for (MtpObjectHandle handle : removedObjects)
+        objectRemoved(handle);
 }
 
 
 bool MtpServer::handleRequest() {
     Mutex::Autolock autoLock(mMutex);
 
+    applyObjectEvents();
+
     MtpOperationCode operation = mRequest.getOperationCode();
     MtpResponseCode response;
 
@@ -516,6 +580,8 @@ MtpResponseCode MtpServer::doOpenSession() {
     mSessionID = mRequest.getParameter(1);
     mSessionOpen = true;
 
+    for (size_t i = 0; i < mStorages.size(); i++)
+        mStorages[i]->clearObjectIndex();
     mDatabase->sessionStarted();
 
     return MTP_RESPONSE_OK;
@@ -527,6 +593,8 @@ MtpResponseCode MtpServer::doCloseSession() {
     mSessionID = 0;
     mSessionOpen = false;
     mDatabase->sessionEnded();
+    for (size_t i = 0; i < mStorages.size(); i++)
+        mStorages[i]->clearObjectIndex();
     return MTP_RESPONSE_OK;
 }
 
@@ -593,7 +661,16 @@ MtpResponseCode MtpServer::doGetObjectHandles() {
     if (!hasStorage(storageID))
         return MTP_RESPONSE_INVALID_STORAGE_ID;
 
+    MtpStorage* storage = (storageID == 0xFFFFFFFF ? nullptr : getStorage(storageID));
+    MtpObjectHandleList cached;
+    if (storage && storage->getObjectList(format, parent, cached)) {
+        mData.putAUInt32(&cached);
+        return MTP_RESPONSE_OK;
+    }
+
     MtpObjectHandleList* handles = mDatabase->getObjectList(storageID, format, parent);
+    if (storage && handles)
+        storage->setObjectList(format, parent, *handles);
     mData.putAUInt32(handles);
     delete handles;
     return MTP_RESPONSE_OK;
@@ -611,6 +688,13 @@ MtpResponseCode MtpServer::doGetNumObjects() {
     if (!hasStorage(storageID))
         return MTP_RESPONSE_INVALID_STORAGE_ID;
 
+    MtpStorage* storage = (storageID == 0xFFFFFFFF ? nullptr : getStorage(storageID));
+    MtpObjectHandleList cached;
+    if (storage && storage->getObjectList(format, parent, cached)) {
+        mResponse.setParameter(1, cached.size());
+        return MTP_RESPONSE_OK;
+    }
+
     int count = mDatabase->getNumObjects(storageID, format, parent);
     if (count >= 0) {
         mResponse.setParameter(1, count);
@@ -681,7 +765,10 @@ MtpResponseCode MtpServer::doSetObjectPropValue() {
     ALOGV("SetObjectPropValue %d %s\n", handle,
             MtpDebug::getObjectPropCodeName(property));
 
-    return mDatabase->setObjectPropertyValue(handle, property, mData);
+    MtpResponseCode result = mDatabase->setObjectPropertyValue(handle, property, mData);
+    if (result == MTP_RESPONSE_OK)
+        objectChanged(handle);
+    return result;
 }
 
 MtpResponseCode MtpServer::doGetDevicePropValue() {
@@ -730,7 +817,30 @@ MtpResponseCode MtpServer::doGetObjectPropList() {
             handle, MtpDebug::getFormatCodeName(format),
             MtpDebug::getObjectPropCodeName(property), groupCode, depth);
 
-    return mDatabase->getObjectPropertyList(handle, format, property, groupCode, depth, mData);
+    // Lists of all properties of an object or of its children are served
+    // from the object index when possible.
+    MtpStorage* storage = nullptr;
+    MtpObjectHandleList handles;
+    if (format == 0 && property == 0xFFFFFFFF && groupCode == 0
+            && handle != 0 && handle != 0xFFFFFFFF) {
+        storage = getObjectStorage(handle);
+        if (storage && depth == 0) {
+            handles.push(handle);
+        } else if (storage && depth == 1) {
+            if (!getObjectChildren(storage, handle, handles))
+                storage = nullptr;
+        } else {
+            storage = nullptr;
+        }
+    }
+    if (storage && storage->getObjectPropLists(handles, mData))
+        return MTP_RESPONSE_OK;
+
+    MtpResponseCode result = mDatabase->getObjectPropertyList(handle, format, property,
+            groupCode, depth, mData);
+    if (storage && result == MTP_RESPONSE_OK)
+        storage->setObjectPropLists(mData.getData(), mData.getDataSize());
+    return result;
 }
 
 MtpResponseCode MtpServer::doGetObjectInfo() {
@@ -985,6 +1095,7 @@ MtpResponseCode MtpServer::doSendObjectInfo() {
     if (handle == kInvalidObjectHandle) {
         return MTP_RESPONSE_GENERAL_ERROR;
     }
+    storage->objectAdded(handle, format, parent);
 
   if (format == MTP_FORMAT_ASSOCIATION) {
         mode_t mask = umask(0);
@@ -1103,6 +1214,10 @@ done:
 
     mDatabase->endSendObject(mSendObjectFilePath, mSendObjectHandle, mSendObjectFormat,
             result == MTP_RESPONSE_OK);
+    if (result == MTP_RESPONSE_OK)
+        objectChanged(mSendObjectHandle);
+    else
+        objectRemoved(mSendObjectHandle);
     mSendObjectHandle = kInvalidObjectHandle;
     mSendObjectFormat = 0;
     mSendObjectModifiedTime = 0;
@@ -1193,6 +1308,13 @@ MtpResponseCode MtpServer::doDeleteObject() {
         // Don't delete the actual files unless the database deletion is allowed
         if (result == MTP_RESPONSE_OK) {
             deletePath((const char *)filePath);
+            // the handles of a deleted directory's contents are not known here
+            if (format == MTP_FORMAT_ASSOCIATION) {
+                for (size_t i = 0; i < mStorages.size(); i++)
+                    mStorages[i]->clearObjectIndex();
+            } else {
+                objectRemoved(handle);
+            }
         }
     }
 
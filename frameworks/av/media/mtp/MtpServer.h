@@ -29,6 +29,7 @@
 #include <queue>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 namespace android {
 
@@ -103,6 +104,12 @@ private:
     };
     Vector<ObjectEdit*>  mObjectEditList;
 
+    // objects added or removed outside of MTP operations, applied to the
+    // storage object indexes before the next request is handled
+    std::mutex          mObjectEventLock;
+    bool                mObjectsAdded;
+    std::vector<MtpObjectHandle> mRemovedObjects;
+
 public:
                         MtpServer(MtpDatabase* database, bool ptp,
                                     int fileGroup, int filePerm, int directoryPerm,
@@ -136,6 +143,13 @@ private:
     void                removeEditObject(MtpObjectHandle handle);
     void                commitEdit(ObjectEdit* edit);
 
+    MtpStorage*         getObjectStorage(MtpObjectHandle handle);
+    bool                getObjectChildren(MtpStorage* storage, MtpObjectHandle parent,
+                                MtpObjectHandleList& outHandles);
+    void                objectChanged(MtpObjectHandle handle);
+    void                objectRemoved(MtpObjectHandle handle);
+    void                applyObjectEvents();
+
     bool                handleRequest();
 
     MtpResponseCode     doGetDeviceInfo();
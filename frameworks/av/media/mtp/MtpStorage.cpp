@@ -18,6 +18,7 @@
 
 #include "MtpDebug.h"
 #include "MtpDatabase.h"
+#include "MtpDataPacket.h"
 #include "MtpStorage.h"
 
 #include <sys/types.h>
@@ -30,8 +31,63 @@
 #include <stdio.h>
 #include <limits.h>
 
+#include <algorithm>
+
 namespace android {
 
+static uint16_t readUInt16(const uint8_t* data) {
+    return (uint16_t)data[0] | ((uint16_t)data[1] << 8);
+}
+
+static uint32_t readUInt32(const uint8_t* data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) |
+            ((uint32_t)data[3] << 24);
+}
+
+// Size of a single value of scalar |type|, or 0 if unknown.
+static size_t getScalarSize(uint16_t type) {
+    switch (type) {
+        case MTP_TYPE_INT8:
+        case MTP_TYPE_UINT8:
+            return 1;
+        case MTP_TYPE_INT16:
+        case MTP_TYPE_UINT16:
+            return 2;
+        case MTP_TYPE_INT32:
+        case MTP_TYPE_UINT32:
+            return 4;
+        case MTP_TYPE_INT64:
+        case MTP_TYPE_UINT64:
+            return 8;
+        case MTP_TYPE_INT128:
+        case MTP_TYPE_UINT128:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+// Computes the encoded size of the value of |type| at |data|.
+static bool getValueSize(uint16_t type, const uint8_t* data, size_t length, size_t& outSize) {
+    if (type == MTP_TYPE_STR) {
+        // character count (including the terminator) then UTF-16 characters
+        if (length < 1)
+            return false;
+        outSize = 1 + data[0] * 2;
+    } else if (type & 0x4000) {
+        // arrays are a 32 bit element count followed by the elements
+        size_t elementSize = getScalarSize(type & ~0x4000);
+        if (elementSize == 0 || length < 4)
+            return false;
+        outSize = 4 + (size_t)readUInt32(data) * elementSize;
+    } else {
+        outSize = getScalarSize(type);
+        if (outSize == 0)
+            return false;
+    }
+    return outSize <= length;
+}
+
 MtpStorage::MtpStorage(MtpStorageID id, const char* filePath,
         const char* description, uint64_t reserveSpace,
         bool removable, uint64_t maxFileSize)
@@ -83,4 +139,126 @@ const char* MtpStorage::getDescription() const {
     return (const char *)mDescription;
 }
 
+bool MtpStorage::getObjectList(MtpObjectFormat format, MtpObjectHandle parent,
+        MtpObjectHandleList& outHandles) {
+    std::lock_guard<std::mutex> lock(mIndexLock);
+    auto it = mObjectLists.find(std::make_pair(format, parent));
+    if (it == mObjectLists.end())
+        return false;
+    outHandles.clear();
+    outHandles.appendArray(it->second.data(), it->second.size());
+    return true;
+}
+
+void MtpStorage::setObjectList(MtpObjectFormat format, MtpObjectHandle parent,
+        const MtpObjectHandleList& handles) {
+    std::lock_guard<std::mutex> lock(mIndexLock);
+    std::vector<MtpObjectHandle>& list = mObjectLists[std::make_pair(format, parent)];
+    list.assign(handles.array(), handles.array() + handles.size());
+    mObjects.insert(list.begin(), list.end());
+}
+
+bool MtpStorage::hasObject(MtpObjectHandle handle) {
+    std::lock_guard<std::mutex> lock(mIndexLock);
+    return mObjects.count(handle) > 0;
+}
+
+bool MtpStorage::getObjectPropLists(const MtpObjectHandleList& handles, MtpDataPacket& packet) {
+    std::lock_guard<std::mutex> lock(mIndexLock);
+    uint32_t count = 0;
+    for (size_t i = 0; i < handles.size(); i++) {
+        auto it = mObjectPropLists.find(handles[i]);
+        if (it == mObjectPropLists.end())
+            return false;
+        count += it->second.mCount;
+    }
+    packet.putUInt32(count);
+    for (size_t i = 0; i < handles.size(); i++) {
+        const ObjectPropList& list = mObjectPropLists[handles[i]];
+        packet.putData(list.mData.data(), list.mData.size());
+    }
+    return true;
+}
+
+void MtpStorage::setObjectPropLists(const uint8_t* data, size_t length) {
+    // A 32 bit element count, then elements of object handle (32 bits),
+    // property code (16 bits), data type (16 bits) and value.
+    if (length < 4)
+        return;
+    uint32_t count = readUInt32(data);
+    size_t offset = 4;
+    std::unordered_map<MtpObjectHandle, ObjectPropList> lists;
+    for (uint32_t i = 0; i < count; i++) {
+        if (length - offset < 8)
+            return;
+        MtpObjectHandle handle = readUInt32(data + offset);
+        uint16_t type = readUInt16(data + offset + 6);
+        size_t valueSize;
+        if (!getValueSize(type, data + offset + 8, length - offset - 8, valueSize)) {
+            ALOGW("not caching property list with unknown type %04X", type);
+            return;
+        }
+        size_t elementSize = 8 + valueSize;
+        ObjectPropList& list = lists[handle];
+        list.mCount++;
+        list.mData.insert(list.mData.end(), data + offset, data + offset + elementSize);
+        offset += elementSize;
+    }
+
+    std::lock_guard<std::mutex> lock(mIndexLock);
+    for (auto& entry : lists) {
+        if (mObjects.count(entry.first))
+            mObjectPropLists[entry.first] = std::move(entry.second);
+    }
+}
+
+void MtpStorage::objectAdded(MtpObjectHandle handle, MtpObjectFormat format,
+        MtpObjectHandle parent) {
+    std::lock_guard<std::mutex> lock(mIndexLock);
+    for (auto& entry : mObjectLists) {
+        MtpObjectFormat listFormat = entry.first.first;
+        MtpObjectHandle listParent = entry.first.second;
+        if (listFormat != 0 && listFormat != format)
+            continue;
+        // a parent of 0 lists all objects, MTP_PARENT_ROOT those in the root
+        if (listParent != 0 && listParent != parent
+                && !(listParent == MTP_PARENT_ROOT && parent == 0))
+            continue;
+        std::vector<MtpObjectHandle>& list = entry.second;
+        if (std::find(list.begin(), list.end(), handle) == list.end())
+            list.push_back(handle);
+    }
+    mObjects.insert(handle);
+    mObjectPropLists.erase(handle);
+}
+
+void MtpStorage::objectChanged(MtpObjectHandle handle) {
+    std::lock_guard<std::mutex> lock(mIndexLock);
+    mObjectPropLists.erase(handle);
+}
+
+void MtpStorage::objectRemoved(MtpObjectHandle handle) {
+    std::lock_guard<std::mutex> lock(mIndexLock);
+    if (!mObjects.erase(handle))
+        return;
+    for (auto& entry : mObjectLists) {
+        std::vector<MtpObjectHandle>& list = entry.second;
+        list.erase(std::remove(list.begin(), list.end(), handle), list.end());
+    }
+    mObjectLists.erase(std::make_pair((MtpObjectFormat)0, handle));
+    mObjectPropLists.erase(handle);
+}
+
+void MtpStorage::invalidateObjectLists() {
+    std::lock_guard<std::mutex> lock(mIndexLock);
+    mObjectLists.clear();
+}
+
+void MtpStorage::clearObjectIndex() {
+    std::lock_guard<std::mutex> lock(mIndexLock);
+    mObjectLists.clear();
+    mObjects.clear();
+    mObjectPropLists.clear();
+}
+
 }  // namespace android
@@ -20,9 +20,16 @@
 #include "MtpTypes.h"
 #include "mtp.h"
 
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 namespace android {
 
 class MtpDatabase;
+class MtpDataPacket;
 
 class MtpStorage {
 
@@ -36,6 +43,20 @@ private:
     uint64_t                mReserveSpace;
     bool                    mRemovable;
 
+    struct ObjectPropList {
+        uint32_t                mCount;
+        std::vector<uint8_t>    mData;      // property elements, without the count
+    };
+
+    // Object index: database results for the objects on this storage, so that
+    // repeated enumeration by the host does not cross into the database for
+    // every object. Kept up to date by MtpServer as objects change.
+    std::mutex              mIndexLock;
+    std::map<std::pair<MtpObjectFormat, MtpObjectHandle>,
+            std::vector<MtpObjectHandle>> mObjectLists;
+    std::unordered_set<MtpObjectHandle> mObjects;
+    std::unordered_map<MtpObjectHandle, ObjectPropList> mObjectPropLists;
+
 public:
                             MtpStorage(MtpStorageID id, const char* filePath,
                                     const char* description, uint64_t reserveSpace,
@@ -52,6 +73,32 @@ public:
     inline const char*      getPath() const { return (const char *)mFilePath; }
     inline bool             isRemovable() const { return mRemovable; }
     inline uint64_t         getMaxFileSize() const { return mMaxFileSize; }
+
+    // Returns false if the handle list for |format| and |parent| is not cached.
+    bool                    getObjectList(MtpObjectFormat format, MtpObjectHandle parent,
+                                    MtpObjectHandleList& outHandles);
+    void                    setObjectList(MtpObjectFormat format, MtpObjectHandle parent,
+                                    const MtpObjectHandleList& handles);
+    // true if the object appears in one of the cached handle lists
+    bool                    hasObject(MtpObjectHandle handle);
+
+    // Writes the complete property lists of |handles| as a single
+    // GetObjectPropList response. Returns false, writing nothing, unless all
+    // of them are cached.
+    bool                    getObjectPropLists(const MtpObjectHandleList& handles,
+                                    MtpDataPacket& packet);
+    // Caches the per object property lists of a GetObjectPropList response
+    // for all properties, for the objects on this storage.
+    void                    setObjectPropLists(const uint8_t* data, size_t length);
+
+    // |parent| is 0 for objects in the root
+    void                    objectAdded(MtpObjectHandle handle, MtpObjectFormat format,
+                                    MtpObjectHandle parent);
+    void                    objectChanged(MtpObjectHandle handle);
+    void                    objectRemoved(MtpObjectHandle handle);
+    // Drops the cached handle lists when objects were added elsewhere.
+    void                    invalidateObjectLists();
+    void                    clearObjectIndex();
 };
 
 }; // namespace android
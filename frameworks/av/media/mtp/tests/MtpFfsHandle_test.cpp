@@ -29,7 +29,7 @@
 
 namespace android {
 
-constexpr int MAX_FILE_CHUNK_SIZE = 3 * 1024 * 1024;
+constexpr int MAX_FILE_CHUNK_SIZE = 1024 * 1024;
 
 constexpr int TEST_PACKET_SIZE = 512;
 constexpr int SMALL_MULT = 30;
@@ -80,8 +80,9 @@ protected:
         intr.reset(fd[0]);
         ffs_handle->mIntr.reset(fd[1]);
 
-        ffs_handle->mBuffer1.resize(MAX_FILE_CHUNK_SIZE);
-        ffs_handle->mBuffer2.resize(MAX_FILE_CHUNK_SIZE);
+        for (auto &buf : ffs_handle->mIobuf) {
+            buf.data.resize(MAX_FILE_CHUNK_SIZE);
+        }
     }
 
     ~MtpFfsHandleTest() {}
@@ -400,6 +400,7 @@ void FastMixer::onWork()
             FastTrackDump *ftDump = &dumpState->mTracks[i];
             FastTrackUnderruns underruns = ftDump->mUnderruns;
             if (framesReady < frameCount) {
+                LOG_UNDERRUN(i, frameCount - framesReady);
                 if (framesReady == 0) {
                     underruns.mBitFields.mEmpty++;
                     underruns.mBitFields.mMostRecent = UNDERRUN_EMPTY;
@@ -424,7 +425,9 @@ void FastMixer::onWork()
 
         if (anyEnabledTracks) {
             // process() is CPU-bound
+            const int64_t mixStartNs = get_monotonic_ns();
             mMixer->process();
+            LOG_MIX_DURATION(get_monotonic_ns() - mixStartNs);
             mMixerBufferState = MIXED;
         } else if (mMixerBufferState != ZEROED) {
             mMixerBufferState = UNDEFINED;
@@ -459,7 +462,9 @@ void FastMixer::onWork()
         //       but this code should be modified to handle both non-blocking and blocking sinks
         dumpState->mWriteSequence++;
         ATRACE_BEGIN("write");
+        const int64_t writeStartNs = get_monotonic_ns();
         ssize_t framesWritten = mOutputSink->write(buffer, frameCount);
+        LOG_HAL_WRITE(get_monotonic_ns() - writeStartNs);
         ATRACE_END();
         dumpState->mWriteSequence++;
         if (framesWritten >= 0) {
@@ -264,6 +264,9 @@ bool FastThread::threadLoop()
                 }
                 mSleepNs = -1;
                 if (mIsWarm) {
+                    if (mPeriodNs > 0 && (sec > 0 || nsec > mPeriodNs)) {
+                        LOG_WAKEUP_LATENCY(sec * 1000000000LL + nsec - mPeriodNs);
+                    }
                     if (sec > 0 || nsec > mUnderrunNs) {
                         ATRACE_NAME("underrun");
                         // FIXME only log occasionally
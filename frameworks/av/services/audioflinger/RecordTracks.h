@@ -90,6 +90,11 @@ private:
 
             // used by the record thread to convert frames to proper destination format
             RecordBufferConverter              *mRecordBufferConverter;
+
+            // when set, replaces mResamplerBufferProvider and mRecordBufferConverter
+            sp<SharedConversion>                mSharedConversion;
+            int32_t                             mSharedFront;   // next frame to read from
+                                                                // mSharedConversion
             audio_input_flags_t                mFlags;
 };
 
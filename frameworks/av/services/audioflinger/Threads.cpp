@@ -32,6 +32,7 @@
 #include "Configuration.h"
 #include <math.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <linux/futex.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
@@ -138,6 +139,8 @@ static const nsecs_t kConfigEventTimeoutNs = seconds(2);
 static const uint32_t kMinThreadSleepTimeUs = 5000;
 // maximum divider applied to the active sleep time in the mixer thread loop
 static const uint32_t kMaxThreadSleepTimeShift = 2;
+// maximum idle sleep time for a deep buffer mixer thread that defers its wakeups
+static const uint32_t kMaxAdaptiveIdleSleepTimeUs = 500000;
 
 // minimum normal sink buffer size, expressed in milliseconds rather than frames
 // FIXME This should be based on experimentally observed scheduling jitter
@@ -205,6 +208,18 @@ static const int kFastTrackMultiplierMax = 2;
 // The actual value to use, which can be specified per-device via property af.fast_track_multiplier.
 static int sFastTrackMultiplier = kFastTrackMultiplier;
 
+// Track capacity of the normal AudioMixer of a MixerThread, if not specified by property.
+// The mixer's track table is allocated up front, so this only costs memory per thread.
+static const uint32_t kDefaultMixerTracks = 128;
+
+// The actual value to use, which can be specified per-device via ro.audio.max_mixer_tracks.
+static uint32_t sMixerTracks = kDefaultMixerTracks;
+
+// Extra threads used by a MixerThread's AudioMixer to pre-process tracks in parallel.
+// Off by default; can be set per-device via property af.mixer.workers.
+static const uint32_t kMaxMixerWorkers = 4;
+static uint32_t sMixerWorkers = 0;
+
 // See Thread::readOnlyHeap().
 // Initially this heap is used to allocate client buffers for "fast" AudioRecord.
 // Eventually it will be the single buffer that FastCapture writes into via HAL read(),
@@ -236,6 +251,33 @@ static void sFastTrackMultiplierInit()
     }
 }
 
+static pthread_once_t sMixerConfigOnce = PTHREAD_ONCE_INIT;
+
+static void sMixerConfigInit()
+{
+    char value[PROPERTY_VALUE_MAX];
+    if (property_get("ro.audio.max_mixer_tracks", value, NULL) > 0) {
+        char *endptr;
+        unsigned long ul = strtoul(value, &endptr, 0);
+        if (*endptr == '\0' && 1 <= ul && ul <= AudioMixer::MAX_NUM_TRACKS) {
+            sMixerTracks = (uint32_t) ul;
+        }
+    }
+    if (property_get("af.mixer.workers", value, NULL) > 0) {
+        char *endptr;
+        unsigned long ul = strtoul(value, &endptr, 0);
+        if (*endptr == '\0' && ul <= kMaxMixerWorkers) {
+            sMixerWorkers = (uint32_t) ul;
+        }
+    }
+    // workers only help if they can run beside the mixer thread
+    const long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    if (cpus > 0 && sMixerWorkers >= (uint32_t) cpus) {
+        sMixerWorkers = (uint32_t) cpus - 1;
+    }
+    ALOGI("sMixerTracks = %u sMixerWorkers = %u", sMixerTracks, sMixerWorkers);
+}
+
 // ----------------------------------------------------------------------------
 
 #ifdef ADD_BATTERY_DATA
@@ -1681,6 +1723,8 @@ AudioFlinger::PlaybackThread::PlaybackThread(const sp<AudioFlinger>& audioFlinge
         mMixerStatus(MIXER_IDLE),
         mMixerStatusIgnoringFastTracks(MIXER_IDLE),
         mStandbyDelayNs(AudioFlinger::mStandbyTimeInNsecs),
+        mDeferWakeups(false),
+        mAdaptiveIdleSleepTimeUs(0),
         mBytesRemaining(0),
         mCurrentWriteLength(0),
         mUseAsyncWrite(false),
@@ -2471,6 +2515,9 @@ void AudioFlinger::PlaybackThread::readOutputParameters_l()
 
     // Check if we want to throttle the processing to no more than 2x normal rate
     mThreadThrottle = property_get_bool("af.thread.throttle", true /* default_value */);
+    // Deep buffer mixers serve no low latency clients, so they can sleep longer when idle
+    mAdaptiveWakeup = mType == MIXER && (mOutput->flags & AUDIO_OUTPUT_FLAG_DEEP_BUFFER)
+            && property_get_bool("af.thread.adaptive_wakeup", true /* default_value */);
     mThreadThrottleTimeMs = 0;
     mThreadThrottleEndMs = 0;
     mHalfBufferMs = mNormalFrameCount * 1000 / (2 * mSampleRate);
@@ -3014,6 +3061,8 @@ bool AudioFlinger::PlaybackThread::threadLoop()
 
     if (mType == MIXER) {
         sleepTimeShift = 0;
+        mDeferWakeups = false;
+        mAdaptiveIdleSleepTimeUs = 0;
     }
 
     CpuStats cpuStats;
@@ -3063,7 +3112,11 @@ bool AudioFlinger::PlaybackThread::threadLoop()
             // and associate with the sink frames written out.  We need
             // this to convert the sink timestamp to the track timestamp.
             bool kernelLocationUpdate = false;
-            if (mNormalSink != 0) {
+            // While wakeups are deferred nothing has been written and no track maps its
+            // position to the sink, so skip the HAL query until playback resumes.
+            const bool skipTimestamp = mDeferWakeups && mActiveTracks.size() == 0
+                    && mFramesWritten == lastFramesWritten;
+            if (mNormalSink != 0 && !skipTimestamp) {
                 // Note: The DuplicatingThread may not have a mNormalSink.
                 // We always fetch the timestamp here because often the downstream
                 // sink will block while writing.
@@ -3234,7 +3287,9 @@ bool AudioFlinger::PlaybackThread::threadLoop()
                 }
 #endif // MTK_AUDIO_DEBUG
                 // threadLoop_mix() sets mCurrentWriteLength
+                const nsecs_t mixStartNs = systemTime();
                 threadLoop_mix();
+                LOG_MIX_DURATION(systemTime() - mixStartNs);
             } else if ((mMixerStatus != MIXER_DRAIN_TRACK)
                         && (mMixerStatus != MIXER_DRAIN_ALL)) {
 #if defined(MTK_AUDIO_DEBUG)
@@ -3343,6 +3398,7 @@ bool AudioFlinger::PlaybackThread::threadLoop()
                     ret = threadLoop_write();
                     lastWriteFinished = systemTime();
                     delta = lastWriteFinished - mLastWriteTime;
+                    LOG_HAL_WRITE(delta);
                     if (ret < 0) {
                         mBytesRemaining = 0;
                     } else {
@@ -3700,7 +3756,11 @@ AudioFlinger::MixerThread::MixerThread(const sp<AudioFlinger>& audioFlinger, Aud
             "mFrameCount=%zu, mNormalFrameCount=%zu",
             mSampleRate, mChannelMask, mChannelCount, mFormat, mFrameSize, mFrameCount,
             mNormalFrameCount);
-    mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+    pthread_once(&sMixerConfigOnce, sMixerConfigInit);
+    mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate, sMixerTracks);
+    mAudioMixer->setWorkerCount(sMixerWorkers);
+    // design resampler filters now rather than when the first track at each rate starts
+    AudioMixer::prebuildResamplerFilters(mSampleRate);
 
     if (type == DUPLICATING) {
         // The Duplicating thread uses the AudioMixer and delivers data to OutputTracks
@@ -4071,6 +4131,7 @@ void AudioFlinger::MixerThread::threadLoop_mix()
         sleepTimeShift--;
     }
     mSleepTimeUs = 0;
+    mAdaptiveIdleSleepTimeUs = 0;
     mStandbyTimeNs = systemTime() + mStandbyDelayNs;
     //TODO: delay standby when effects have a tail
 
@@ -4078,6 +4139,15 @@ void AudioFlinger::MixerThread::threadLoop_mix()
 
 void AudioFlinger::MixerThread::threadLoop_sleepTime()
 {
+    if (mDeferWakeups && mMixerStatus == MIXER_IDLE) {
+        // Nothing to play and no effect tail to flush: let the HAL run dry instead of
+        // feeding it silence, and wake up less often until standby. Starting a track
+        // signals mWaitWorkCV, so this does not delay playback.
+        mSleepTimeUs = adaptiveIdleSleepTimeUs();
+        return;
+    }
+    mAdaptiveIdleSleepTimeUs = 0;
+
     // If no tracks are ready, sleep once for the duration of an output
     // buffer size, then write 0s to the output
     if (mSleepTimeUs == 0) {
@@ -4362,8 +4432,8 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
             char traceName[16];
             strcpy(traceName, "nRdy");
             int name = track->name();
-            if (AudioMixer::TRACK0 <= name &&
-                    name < (int) (AudioMixer::TRACK0 + AudioMixer::MAX_NUM_TRACKS)) {
+            // only two digits fit in the trace name
+            if (AudioMixer::TRACK0 <= name && name < AudioMixer::TRACK0 + 100) {
                 name -= AudioMixer::TRACK0;
                 traceName[4] = (name / 10) + '0';
                 traceName[5] = (name % 10) + '0';
@@ -4746,6 +4816,8 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
     if (fastTracks > 0) {
         mixerStatus = MIXER_TRACKS_READY;
     }
+    mDeferWakeups = mAdaptiveWakeup && mixerStatus == MIXER_IDLE
+            && mActiveTracks.size() == 0 && mEffectChains.isEmpty();
     return mixerStatus;
 }
 
@@ -4891,7 +4963,9 @@ bool AudioFlinger::MixerThread::checkForNewParameter_l(const String8& keyValuePa
         if (status == NO_ERROR && reconfig) {
             readOutputParameters_l();
             delete mAudioMixer;
-            mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+            mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate, sMixerTracks);
+            mAudioMixer->setWorkerCount(sMixerWorkers);
+            AudioMixer::prebuildResamplerFilters(mSampleRate);
             for (size_t i = 0; i < mTracks.size() ; i++) {
                 int name = getTrackName_l(mTracks[i]->mChannelMask,
                         mTracks[i]->mFormat, mTracks[i]->mSessionId, mTracks[i]->uid());
@@ -4912,7 +4986,8 @@ void AudioFlinger::MixerThread::dumpInternals(int fd, const Vector<String16>& ar
 {
     PlaybackThread::dumpInternals(fd, args);
     dprintf(fd, "  Thread throttle time (msecs): %u\n", mThreadThrottleTimeMs);
-    dprintf(fd, "  AudioMixer tracks: 0x%08x\n", mAudioMixer->trackNames());
+    dprintf(fd, "  AudioMixer tracks: %u of %u\n",
+            mAudioMixer->trackCount(), mAudioMixer->maxNumTracks());
     dprintf(fd, "  Master mono: %s\n", mMasterMono ? "on" : "off");
 
     if (hasFastMixer()) {
@@ -4963,6 +5038,24 @@ uint32_t AudioFlinger::MixerThread::suspendSleepTimeUs() const
     return (uint32_t)(((mNormalFrameCount * 1000) / mSampleRate) * 1000);
 }
 
+// Doubles the idle sleep on each consecutive idle cycle, up to kMaxAdaptiveIdleSleepTimeUs,
+// but never sleeps past the standby deadline so that standby is entered on time.
+uint32_t AudioFlinger::MixerThread::adaptiveIdleSleepTimeUs()
+{
+    if (mAdaptiveIdleSleepTimeUs == 0) {
+        mAdaptiveIdleSleepTimeUs = mIdleSleepTimeUs;
+    } else {
+        mAdaptiveIdleSleepTimeUs = min(mAdaptiveIdleSleepTimeUs * 2, kMaxAdaptiveIdleSleepTimeUs);
+    }
+    uint32_t sleepTimeUs = mAdaptiveIdleSleepTimeUs;
+    const nsecs_t untilStandbyUs = (mStandbyTimeNs - systemTime()) / 1000;
+    if (untilStandbyUs < (nsecs_t) sleepTimeUs) {
+        sleepTimeUs = untilStandbyUs > kMinThreadSleepTimeUs ?
+                (uint32_t) untilStandbyUs : kMinThreadSleepTimeUs;
+    }
+    return sleepTimeUs;
+}
+
 void AudioFlinger::MixerThread::cacheParameters_l()
 {
     PlaybackThread::cacheParameters_l();
@@ -6350,6 +6443,7 @@ reacquire_wakelock:
                         ALOG_ASSERT(fastTrackToRemove == 0);
                         fastTrackToRemove = activeTrack;
                     }
+                    activeTrack->mSharedConversion.clear();
                     removeTrack_l(activeTrack);
                     mActiveTracks.remove(activeTrack);
                     size--;
@@ -6360,6 +6454,7 @@ reacquire_wakelock:
                 switch (activeTrackState) {
 
                 case TrackBase::PAUSING:
+                    activeTrack->mSharedConversion.clear();
                     mActiveTracks.remove(activeTrack);
                     doBroadcast = true;
                     size--;
@@ -6375,6 +6470,7 @@ reacquire_wakelock:
                     doBroadcast = true;
                     mStandby = false;
                     activeTrack->mState = TrackBase::ACTIVE;
+                    attachSharedConversion_l(activeTrack);
                     allStopped = false;
                     break;
 
@@ -6586,6 +6682,12 @@ reacquire_wakelock:
             // TODO: This code probably should be moved to RecordTrack.
             // TODO: Update the activeTrack buffer converter in case of reconfigure.
 
+            // tracks sharing a conversion copy its output, which is converted once per loop
+            SharedConversion *sharedConversion = activeTrack->mSharedConversion.get();
+            if (sharedConversion != NULL) {
+                sharedConversion->process();
+            }
+
             enum {
                 OVERRUN_UNKNOWN,
                 OVERRUN_TRUE,
@@ -6604,7 +6706,11 @@ reacquire_wakelock:
                 // if the record track isn't draining fast enough.
                 bool hasOverrun;
                 size_t framesIn;
-                activeTrack->mResamplerBufferProvider->sync(&framesIn, &hasOverrun);
+                if (sharedConversion != NULL) {
+                    sharedConversion->sync(activeTrack.get(), &framesIn, &hasOverrun);
+                } else {
+                    activeTrack->mResamplerBufferProvider->sync(&framesIn, &hasOverrun);
+                }
                 if (hasOverrun) {
                     overrun = OVERRUN_TRUE;
                 }
@@ -6612,16 +6718,24 @@ reacquire_wakelock:
                     break;
                 }
 
-                // Don't allow framesOut to be larger than what is possible with resampling
-                // from framesIn.
-                // This isn't strictly necessary but helps limit buffer resizing in
-                // RecordBufferConverter.  TODO: remove when no longer needed.
-                framesOut = min(framesOut,
-                        destinationFramesPossible(
-                                framesIn, mSampleRate, activeTrack->mSampleRate));
-                // process frames from the RecordThread buffer provider to the RecordTrack buffer
-                framesOut = activeTrack->mRecordBufferConverter->convert(
-                        activeTrack->mSink.raw, activeTrack->mResamplerBufferProvider, framesOut);
+                if (sharedConversion != NULL) {
+                    // framesIn are already converted
+                    framesOut = sharedConversion->read(
+                            activeTrack.get(), activeTrack->mSink.raw, framesOut);
+                } else {
+                    // Don't allow framesOut to be larger than what is possible with resampling
+                    // from framesIn.
+                    // This isn't strictly necessary but helps limit buffer resizing in
+                    // RecordBufferConverter.  TODO: remove when no longer needed.
+                    framesOut = min(framesOut,
+                            destinationFramesPossible(
+                                    framesIn, mSampleRate, activeTrack->mSampleRate));
+                    // process frames from the RecordThread buffer provider to the RecordTrack
+                    // buffer
+                    framesOut = activeTrack->mRecordBufferConverter->convert(
+                            activeTrack->mSink.raw, activeTrack->mResamplerBufferProvider,
+                            framesOut);
+                }
 
                 if (framesOut > 0 && (overrun == OVERRUN_UNKNOWN)) {
                     overrun = OVERRUN_FALSE;
@@ -6702,6 +6816,7 @@ unlock:
         for (size_t i = 0; i < mTracks.size(); i++) {
             sp<RecordTrack> track = mTracks[i];
             track->invalidate();
+            track->mSharedConversion.clear();
         }
         mActiveTracks.clear();
         mStartStopCond.broadcast();
@@ -7169,9 +7284,16 @@ void AudioFlinger::RecordThread::dumpTracks(int fd, const Vector<String16>& args
 }
 
 
+AudioFlinger::RecordThread::ResamplerBufferProvider::ResamplerBufferProvider(
+        RecordTrack* recordTrack) :
+    mThread(recordTrack->mThread),
+    mRsmpInUnrel(0), mRsmpInFront(0)
+{
+}
+
 void AudioFlinger::RecordThread::ResamplerBufferProvider::reset()
 {
-    sp<ThreadBase> threadBase = mRecordTrack->mThread.promote();
+    sp<ThreadBase> threadBase = mThread.promote();
     RecordThread *recordThread = (RecordThread *) threadBase.get();
     mRsmpInFront = recordThread->mRsmpInRear;
     mRsmpInUnrel = 0;
@@ -7180,7 +7302,7 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::reset()
 void AudioFlinger::RecordThread::ResamplerBufferProvider::sync(
         size_t *framesAvailable, bool *hasOverrun)
 {
-    sp<ThreadBase> threadBase = mRecordTrack->mThread.promote();
+    sp<ThreadBase> threadBase = mThread.promote();
     RecordThread *recordThread = (RecordThread *) threadBase.get();
     const int32_t rear = recordThread->mRsmpInRear;
     const int32_t front = mRsmpInFront;
@@ -7213,7 +7335,7 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::sync(
 status_t AudioFlinger::RecordThread::ResamplerBufferProvider::getNextBuffer(
         AudioBufferProvider::Buffer* buffer)
 {
-    sp<ThreadBase> threadBase = mRecordTrack->mThread.promote();
+    sp<ThreadBase> threadBase = mThread.promote();
     if (threadBase == 0) {
         buffer->frameCount = 0;
         buffer->raw = NULL;
@@ -7266,6 +7388,148 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::releaseBuffer(
     buffer->frameCount = 0;
 }
 
+AudioFlinger::RecordThread::SharedConversion::SharedConversion(
+        RecordThread *recordThread, RecordTrack *leader) :
+    mRecordThread(recordThread),
+    mFormat(leader->mFormat),
+    mChannelMask(leader->mChannelMask),
+    mSampleRate(leader->mSampleRate),
+    mFrameSize(leader->mFrameSize),
+    mConverter(leader->mRecordBufferConverter),
+    mInput(new ResamplerBufferProvider(*leader->mResamplerBufferProvider)),
+    mBuffer(NULL),
+    mRear(0)
+{
+    // the leader gets a fresh converter, which it only uses again if restarted alone
+    leader->mRecordBufferConverter = new RecordBufferConverter(
+            recordThread->mChannelMask, recordThread->mFormat, recordThread->mSampleRate,
+            mChannelMask, mFormat, mSampleRate);
+
+    // keep as much converted data as the RecordThread keeps input data
+    mFramesP2 = roundup(destinationFramesPossible(
+            recordThread->mRsmpInFrames, recordThread->mSampleRate, mSampleRate));
+    (void)posix_memalign(&mBuffer, 32, mFramesP2 * mFrameSize);
+    // if posix_memalign fails, will segv here.
+    memset(mBuffer, 0, mFramesP2 * mFrameSize);
+}
+
+AudioFlinger::RecordThread::SharedConversion::~SharedConversion()
+{
+    free(mBuffer);
+    delete mInput;
+    delete mConverter;
+}
+
+bool AudioFlinger::RecordThread::SharedConversion::matches(const RecordTrack *recordTrack) const
+{
+    return recordTrack->mFormat == mFormat
+            && recordTrack->mChannelMask == mChannelMask
+            && recordTrack->mSampleRate == mSampleRate;
+}
+
+void AudioFlinger::RecordThread::SharedConversion::attach(RecordTrack *recordTrack)
+{
+    recordTrack->mSharedConversion = this;
+    recordTrack->mSharedFront = mRear;
+}
+
+void AudioFlinger::RecordThread::SharedConversion::process()
+{
+    size_t framesIn;
+    mInput->sync(&framesIn);
+    while (framesIn > 0) {
+        // the ring buffer may wrap, so convert into its first contiguous part
+        const size_t rear = mRear & (mFramesP2 - 1);
+        size_t framesOut = min(mFramesP2 - rear, destinationFramesPossible(
+                framesIn, mRecordThread->mSampleRate, mSampleRate));
+        if (framesOut == 0) {
+            break;
+        }
+        framesOut = mConverter->convert(
+                (uint8_t *)mBuffer + rear * mFrameSize, mInput, framesOut);
+        if (framesOut == 0) {
+            break;
+        }
+        mRear += framesOut;
+        mInput->sync(&framesIn);
+    }
+}
+
+void AudioFlinger::RecordThread::SharedConversion::sync(
+        RecordTrack *recordTrack, size_t *framesAvailable, bool *hasOverrun)
+{
+    const ssize_t filled = mRear - recordTrack->mSharedFront;
+
+    size_t framesIn;
+    bool overrun = false;
+    if (filled < 0) {
+        // should not happen, but treat like a massive overrun and re-sync
+        framesIn = 0;
+        recordTrack->mSharedFront = mRear;
+        overrun = true;
+    } else if ((size_t) filled <= mFramesP2) {
+        framesIn = (size_t) filled;
+    } else {
+        // the track is not keeping up with the others, give it the latest data
+        framesIn = mFramesP2;
+        recordTrack->mSharedFront = mRear - framesIn;
+        overrun = true;
+    }
+    if (framesAvailable != NULL) {
+        *framesAvailable = framesIn;
+    }
+    if (hasOverrun != NULL) {
+        *hasOverrun = overrun;
+    }
+}
+
+size_t AudioFlinger::RecordThread::SharedConversion::read(
+        RecordTrack *recordTrack, void *dst, size_t frames)
+{
+    size_t framesIn;
+    sync(recordTrack, &framesIn);
+    if (frames > framesIn) {
+        frames = framesIn;
+    }
+    const size_t front = recordTrack->mSharedFront & (mFramesP2 - 1);
+    const size_t part1 = min(frames, mFramesP2 - front);
+    memcpy(dst, (uint8_t *)mBuffer + front * mFrameSize, part1 * mFrameSize);
+    if (frames > part1) {
+        memcpy((uint8_t *)dst + part1 * mFrameSize, mBuffer, (frames - part1) * mFrameSize);
+    }
+    recordTrack->mSharedFront += frames;
+    return frames;
+}
+
+void AudioFlinger::RecordThread::attachSharedConversion_l(const sp<RecordTrack>& recordTrack)
+{
+    if (recordTrack->isFastTrack()) {
+        return;
+    }
+    for (size_t i = 0; i < mActiveTracks.size(); i++) {
+        const sp<RecordTrack> &other = mActiveTracks[i];
+        if (other == recordTrack || other->isFastTrack()
+                || other->mState != TrackBase::ACTIVE) {
+            continue;
+        }
+        if (other->mSharedConversion != 0) {
+            if (other->mSharedConversion->matches(recordTrack.get())) {
+                other->mSharedConversion->attach(recordTrack.get());
+                return;
+            }
+        } else if (other->mFormat == recordTrack->mFormat
+                && other->mChannelMask == recordTrack->mChannelMask
+                && other->mSampleRate == recordTrack->mSampleRate) {
+            sp<SharedConversion> sharedConversion = new SharedConversion(this, other.get());
+            sharedConversion->attach(other.get());
+            sharedConversion->attach(recordTrack.get());
+            ALOGV("RecordThread: sharing conversion of track %p with track %p",
+                    other.get(), recordTrack.get());
+            return;
+        }
+    }
+}
+
 void AudioFlinger::RecordThread::checkBtNrec()
 {
     Mutex::Autolock _l(mLock);
@@ -786,6 +786,7 @@ protected:
     size_t                          mNormalFrameCount;  // normal mixer and effects
 
     bool                            mThreadThrottle;     // throttle the thread processing
+    bool                            mAdaptiveWakeup;     // stretch idle sleeps (deep buffer)
     uint32_t                        mThreadThrottleTimeMs; // throttle time for MIXER threads
     uint32_t                        mThreadThrottleEndMs;  // notify once per throttling
     uint32_t                        mHalfBufferMs;       // half the buffer size in milliseconds
@@ -952,6 +953,13 @@ private:
     // same as AudioFlinger::mStandbyTimeInNsecs except for DIRECT which uses a shorter value
     nsecs_t                         mStandbyDelayNs;
 
+    // MIXER only
+    // set by prepareTracks_l() when the thread is idle and nothing needs low latency,
+    // in which case threadLoop_sleepTime() skips silence writes and lengthens its sleeps
+    bool                            mDeferWakeups;
+    // last idle sleep returned by adaptiveIdleSleepTimeUs(), 0 when not deferring
+    uint32_t                        mAdaptiveIdleSleepTimeUs;
+
     // MIXER only
     nsecs_t                         maxPeriod;
 
@@ -1045,6 +1053,7 @@ protected:
     virtual     uint32_t    idleSleepTimeUs() const;
     virtual     uint32_t    suspendSleepTimeUs() const;
     virtual     void        cacheParameters_l();
+                uint32_t    adaptiveIdleSleepTimeUs();
 
     virtual void acquireWakeLock_l() {
         PlaybackThread::acquireWakeLock_l();
@@ -1287,9 +1296,7 @@ public:
     class ResamplerBufferProvider : public AudioBufferProvider
     {
     public:
-        explicit ResamplerBufferProvider(RecordTrack* recordTrack) :
-            mRecordTrack(recordTrack),
-            mRsmpInUnrel(0), mRsmpInFront(0) { }
+        explicit ResamplerBufferProvider(RecordTrack* recordTrack);
         virtual ~ResamplerBufferProvider() { }
 
         // called to set the ResamplerBufferProvider to head of the RecordThread data buffer,
@@ -1313,7 +1320,8 @@ public:
         virtual status_t    getNextBuffer(AudioBufferProvider::Buffer* buffer);
         virtual void        releaseBuffer(AudioBufferProvider::Buffer* buffer);
     private:
-        RecordTrack * const mRecordTrack;
+        const wp<ThreadBase> mThread;       // copied from the RecordTrack, so that a copy
+                                            // of this provider may outlive the track
         size_t              mRsmpInUnrel;   // unreleased frames remaining from
                                             // most recent getNextBuffer
                                             // for debug only
@@ -1321,6 +1329,50 @@ public:
                                             // rolling counter that is never cleared
     };
 
+    /* The SharedConversion converts the RecordThread data once for all the RecordTracks
+     * that capture with the same format, channel mask and sample rate. The converted frames
+     * are kept in a ring buffer which each attached RecordTrack reads with its own cursor,
+     * so a second capture of the same stream costs a copy instead of a conversion.
+     * It is created and used by the RecordThread loop only.
+     */
+    class SharedConversion : public RefBase
+    {
+    public:
+        // Takes over the converter and input position of leader, so that the data
+        // it receives continues without a discontinuity.
+        SharedConversion(RecordThread *recordThread, RecordTrack *leader);
+        virtual ~SharedConversion();
+
+        bool        matches(const RecordTrack *recordTrack) const;
+
+        // Attaches recordTrack, starting at the most recent converted frame.
+        void        attach(RecordTrack *recordTrack);
+
+        // Converts the RecordThread data that this stage has not consumed yet.
+        void        process();
+
+        // Same as ResamplerBufferProvider::sync(), for the cursor of recordTrack.
+        void        sync(RecordTrack *recordTrack, size_t *framesAvailable = NULL,
+                         bool *hasOverrun = NULL);
+
+        // Copies up to frames converted frames to dst and advances the cursor of
+        // recordTrack. Returns the number of frames copied.
+        size_t      read(RecordTrack *recordTrack, void *dst, size_t frames);
+
+    private:
+        RecordThread * const        mRecordThread;
+        const audio_format_t        mFormat;
+        const audio_channel_mask_t  mChannelMask;
+        const uint32_t              mSampleRate;
+        const size_t                mFrameSize;
+        RecordBufferConverter      *mConverter;
+        ResamplerBufferProvider    *mInput;
+        void                       *mBuffer;    // size = mFramesP2 * mFrameSize
+        size_t                      mFramesP2;  // converted frames kept, a power of 2
+        int32_t                     mRear;      // last converted frame + 1
+                                                // rolling counter that is never cleared
+    };
+
 #include "RecordTracks.h"
 
             RecordThread(const sp<AudioFlinger>& audioFlinger,
@@ -1435,6 +1487,10 @@ private:
 
             void    checkBtNrec_l();
 
+            // Shares the conversion of recordTrack with an active track of the same
+            // configuration, if there is one.
+            void    attachSharedConversion_l(const sp<RecordTrack>& recordTrack);
+
             AudioStreamIn                       *mInput;
             SortedVector < sp<RecordTrack> >    mTracks;
             // mActiveTracks has dual roles:  it indicates the current active track(s), and
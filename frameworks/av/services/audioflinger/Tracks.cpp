@@ -1671,6 +1671,7 @@ AudioFlinger::RecordThread::RecordTrack::RecordTrack(
         mFramesToDrop(0),
         mResamplerBufferProvider(NULL), // initialize in case of early constructor exit
         mRecordBufferConverter(NULL),
+        mSharedFront(0),
         mFlags(flags)
 {
     if (mCblk == NULL) {
@@ -94,6 +94,22 @@ constexpr uint64_t hash(const char (&file)[n], uint32_t line) {
 #define LOG_AUDIO_STATE() do { NBLog::Writer *x = tlNBLogWriter; if (x != nullptr) \
         x->logEventHistTs(NBLog::EVENT_AUDIO_STATE, hash(__FILE__, __LINE__)); } while(0)
 
+// Record a typed underrun event for a track
+#define LOG_UNDERRUN(trackIndex, framesMissing) do { NBLog::Writer *x = tlNBLogWriter; \
+        if (x != nullptr) x->logUnderrun((trackIndex), (framesMissing)); } while(0)
+
+// Record the time spent mixing one buffer, in nanoseconds
+#define LOG_MIX_DURATION(ns) do { NBLog::Writer *x = tlNBLogWriter; if (x != nullptr) \
+        x->logDuration(NBLog::EVENT_MIX_DURATION, (ns)); } while(0)
+
+// Record the time spent in one sink write, in nanoseconds
+#define LOG_HAL_WRITE(ns) do { NBLog::Writer *x = tlNBLogWriter; if (x != nullptr) \
+        x->logDuration(NBLog::EVENT_HAL_WRITE, (ns)); } while(0)
+
+// Record how late a periodic wakeup was, in nanoseconds
+#define LOG_WAKEUP_LATENCY(ns) do { NBLog::Writer *x = tlNBLogWriter; if (x != nullptr) \
+        x->logDuration(NBLog::EVENT_WAKEUP_LATENCY, (ns)); } while(0)
+
 namespace android {
 extern "C" {
 extern thread_local NBLog::Writer *tlNBLogWriter;
@@ -1101,13 +1101,22 @@ non_direct_output:
 
     // for non direct outputs, only PCM is supported
     if (audio_is_linear_pcm(format)) {
-        // get which output is suitable for the specified stream. The actual
-        // routing change will happen when startOutput() will be called
-        SortedVector<audio_io_handle_t> outputs = getOutputsForDevice(device, mOutputs);
-
         // at this stage we should ignore the DIRECT flag as no direct output could be found earlier
         flags = (audio_output_flags_t)(flags & ~AUDIO_OUTPUT_FLAG_DIRECT);
-        output = selectOutput(outputs, flags, format);
+
+        const MixedOutputKey key = { device, flags, format };
+        ssize_t index = mMixedOutputCache.indexOfKey(key);
+        if (index >= 0) {
+            output = mMixedOutputCache.valueAt(index);
+        } else {
+            // get which output is suitable for the specified stream. The actual
+            // routing change will happen when startOutput() will be called
+            SortedVector<audio_io_handle_t> outputs = getOutputsForDevice(device, mOutputs);
+            output = selectOutput(outputs, flags, format);
+            if (output != AUDIO_IO_HANDLE_NONE) {
+                mMixedOutputCache.add(key, output);
+            }
+        }
     }
     ALOGW_IF((output == 0), "getOutput() could not find output for stream %d, samplingRate %d,"
             "format %d, channels %x, flags %x", stream, samplingRate, format, channelMask, flags);
@@ -4077,6 +4086,7 @@ void AudioPolicyManager::addOutput(audio_io_handle_t output, const sp<SwAudioOut
 {
     outputDesc->setIoHandle(output);
     mOutputs.add(output, outputDesc);
+    mMixedOutputCache.clear();
     updateMono(output); // update mono status when adding to output list
     selectOutputForMusicEffects();
     nextAudioPortGeneration();
@@ -4085,6 +4095,7 @@ void AudioPolicyManager::addOutput(audio_io_handle_t output, const sp<SwAudioOut
 void AudioPolicyManager::removeOutput(audio_io_handle_t output)
 {
     mOutputs.removeItem(output);
+    mMixedOutputCache.clear();
     selectOutputForMusicEffects();
 }
 
@@ -5015,6 +5026,8 @@ void AudioPolicyManager::updateDevicesAndOutputs()
     for (int i = 0; i < NUM_STRATEGIES; i++) {
         mDeviceForStrategy[i] = getDeviceForStrategy((routing_strategy)i, false /*fromCache*/);
     }
+    // phone state and connected devices also steer the mixed output selection
+    mMixedOutputCache.clear();
     mPreviousOutputs = mOutputs;
 }
 
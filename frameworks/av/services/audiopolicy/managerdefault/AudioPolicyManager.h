@@ -556,6 +556,25 @@ protected:
 
         bool    mLimitRingtoneVolume;        // limit ringtone volume to music volume if headset connected
         audio_devices_t mDeviceForStrategy[NUM_STRATEGIES];
+
+        // mixed output chosen by getOutputForDevice() for a given device, output flags and
+        // format. Cleared when an output is opened or closed and by updateDevicesAndOutputs().
+        struct MixedOutputKey {
+            audio_devices_t      device;
+            audio_output_flags_t flags;
+            audio_format_t       format;
+
+            bool operator<(const MixedOutputKey& other) const {
+                if (device != other.device) {
+                    return device < other.device;
+                }
+                if (flags != other.flags) {
+                    return flags < other.flags;
+                }
+                return format < other.format;
+            }
+        };
+        KeyedVector<MixedOutputKey, audio_io_handle_t> mMixedOutputCache;
         float   mLastVoiceVolume;            // last voice volume value sent to audio HAL
 
         EffectDescriptorCollection mEffects;  // list of registered audio effects
@@ -19,6 +19,7 @@
 //#define LOG_NDEBUG 0
 
 #include <netinet/in.h>
+#include <unistd.h>
 
 #include <binder/MemoryBase.h>
 #include <binder/MemoryHeapBase.h>
@@ -42,9 +43,9 @@ JpegProcessor::JpegProcessor(
         mDevice(client->getCameraDevice()),
         mSequencer(sequencer),
         mId(client->getCameraId()),
-        mCaptureDone(false),
-        mCaptureSuccess(false),
-        mCaptureStreamId(NO_STREAM) {
+        mCaptureStreamId(NO_STREAM),
+        mCaptureHeapSlotSize(0),
+        mNextCaptureHeapSlot(0) {
 }
 
 JpegProcessor::~JpegProcessor() {
@@ -55,11 +56,8 @@ JpegProcessor::~JpegProcessor() {
 void JpegProcessor::onFrameAvailable(const BufferItem& /*item*/) {
     Mutex::Autolock l(mInputMutex);
     ALOGV("%s", __FUNCTION__);
-    if (!mCaptureDone) {
-        mCaptureDone = true;
-        mCaptureSuccess = true;
-        mCaptureDoneSignal.signal();
-    }
+    mPendingCaptures.push_back(true);
+    mCaptureDoneSignal.signal();
 }
 
 void JpegProcessor::onBufferAcquired(const BufferInfo& /*bufferInfo*/) {
@@ -76,8 +74,7 @@ void JpegProcessor::onBufferReleased(const BufferInfo& bufferInfo) {
         // b/29524651
         ALOGV("%s: JPEG buffer lost", __FUNCTION__);
         Mutex::Autolock l(mInputMutex);
-        mCaptureDone = true;
-        mCaptureSuccess = false;
+        mPendingCaptures.push_back(false);
         mCaptureDoneSignal.signal();
     }
 }
@@ -117,19 +114,25 @@ status_t JpegProcessor::updateStream(const Parameters &params) {
     // Since ashmem heaps are rounded up to page size, don't reallocate if
     // the capture heap isn't exactly the same size as the required JPEG buffer
     const size_t HEAP_SLACK_FACTOR = 2;
+    const size_t pageSize = getpagesize();
+    size_t slotSize = (static_cast<size_t>(maxJpegSize) + pageSize - 1) & ~(pageSize - 1);
     if (mCaptureHeap == 0 ||
-            (mCaptureHeap->getSize() < static_cast<size_t>(maxJpegSize)) ||
-            (mCaptureHeap->getSize() >
+            (mCaptureHeapSlotSize < static_cast<size_t>(maxJpegSize)) ||
+            (mCaptureHeapSlotSize >
                     static_cast<size_t>(maxJpegSize) * HEAP_SLACK_FACTOR) ) {
         // Create memory for API consumption
         mCaptureHeap.clear();
-        mCaptureHeap =
-                new MemoryHeapBase(maxJpegSize, 0, "Camera2Client::CaptureHeap");
+        mCaptureHeap = new MemoryHeapBase(slotSize * kCaptureHeapSlots, 0,
+                "Camera2Client::CaptureHeap");
         if (mCaptureHeap->getSize() == 0) {
             ALOGE("%s: Camera %d: Unable to allocate memory for capture",
                     __FUNCTION__, mId);
+            mCaptureHeap.clear();
+            mCaptureHeapSlotSize = 0;
             return NO_MEMORY;
         }
+        mCaptureHeapSlotSize = slotSize;
+        mNextCaptureHeapSlot = 0;
     }
     ALOGV("%s: Camera %d: JPEG capture heap now %zu bytes; requested %zd bytes",
             __FUNCTION__, mId, mCaptureHeap->getSize(), maxJpegSize);
@@ -202,6 +205,8 @@ status_t JpegProcessor::deleteStream() {
         device->deleteStream(mCaptureStreamId);
 
         mCaptureHeap.clear();
+        mCaptureHeapSlotSize = 0;
+        mPendingCaptures.clear();
         mCaptureWindow.clear();
         mCaptureConsumer.clear();
 
@@ -225,14 +230,14 @@ bool JpegProcessor::threadLoop() {
     {
         Mutex::Autolock l(mInputMutex);
 
-        while (!mCaptureDone) {
+        while (mPendingCaptures.isEmpty()) {
             res = mCaptureDoneSignal.waitRelative(mInputMutex,
                     kWaitDuration);
             if (res == TIMED_OUT) return true;
         }
 
-        captureSuccess = mCaptureSuccess;
-        mCaptureDone = false;
+        captureSuccess = mPendingCaptures[0];
+        mPendingCaptures.removeAt(0);
     }
 
     res = processNewCapture(captureSuccess);
@@ -282,7 +287,7 @@ status_t JpegProcessor::processNewCapture(bool captureSuccess) {
         if (jpegSize == 0) { // failed to find size, default to whole buffer
             jpegSize = imgBuffer.width;
         }
-        size_t heapSize = mCaptureHeap->getSize();
+        size_t heapSize = mCaptureHeapSlotSize;
         if (jpegSize > heapSize) {
             ALOGW("%s: JPEG image is larger than expected, truncating "
                     "(got %zu, expected at most %zu bytes)",
@@ -291,8 +296,10 @@ status_t JpegProcessor::processNewCapture(bool captureSuccess) {
         }
 
         // TODO: Optimize this to avoid memcopy
-        captureBuffer = new MemoryBase(mCaptureHeap, 0, jpegSize);
-        void* captureMemory = mCaptureHeap->getBase();
+        size_t offset = mNextCaptureHeapSlot * mCaptureHeapSlotSize;
+        mNextCaptureHeapSlot = (mNextCaptureHeapSlot + 1) % kCaptureHeapSlots;
+        captureBuffer = new MemoryBase(mCaptureHeap, offset, jpegSize);
+        void* captureMemory = static_cast<uint8_t*>(mCaptureHeap->getBase()) + offset;
         memcpy(captureMemory, imgBuffer.data, jpegSize);
 
         mCaptureConsumer->unlockBuffer(imgBuffer);
@@ -66,8 +66,9 @@ class JpegProcessor:
     int mId;
 
     mutable Mutex mInputMutex;
-    bool mCaptureDone;
-    bool mCaptureSuccess;
+    // Result of every capture not yet handed to the sequencer, oldest first. A
+    // burst can deliver several captures before the processing thread wakes up.
+    Vector<bool> mPendingCaptures;
     Condition mCaptureDoneSignal;
 
     enum {
@@ -78,6 +79,12 @@ class JpegProcessor:
     sp<CpuConsumer>    mCaptureConsumer;
     sp<Surface>        mCaptureWindow;
     sp<MemoryHeapBase> mCaptureHeap;
+    // The capture heap is split into kCaptureHeapSlots slots used in turn, so
+    // a capture doesn't overwrite the previous one while the client may still
+    // be reading it.
+    static const size_t kCaptureHeapSlots = 2;
+    size_t mCaptureHeapSlotSize;
+    size_t mNextCaptureHeapSlot;
 
     virtual bool threadLoop();
 
@@ -29,7 +29,8 @@ namespace android {
 
 namespace camera3 {
 
-Camera3BufferManager::Camera3BufferManager() {
+Camera3BufferManager::Camera3BufferManager() :
+        mBufferPool(Camera3BufferPool::getInstance()) {
 }
 
 Camera3BufferManager::~Camera3BufferManager() {
@@ -220,11 +221,15 @@ status_t Camera3BufferManager::checkAndFreeBufferOnOtherStreamsLocked(
         {
             mLock.unlock();
             sp<GraphicBuffer> buffer;
-            stream->detachBuffer(&buffer, /*fenceFd*/ nullptr);
-            mLock.lock();
+            int fenceFd = -1;
+            stream->detachBuffer(&buffer, &fenceFd);
             if (buffer.get() != nullptr) {
                 bufferFreed = true;
+                mBufferPool->releaseBuffer(buffer, fenceFd);
+            } else if (fenceFd >= 0) {
+                close(fenceFd);
             }
+            mLock.lock();
         }
         if (bufferFreed) {
             size_t& otherAttachedBufferCount =
@@ -273,21 +278,27 @@ status_t Camera3BufferManager::getBufferForStream(int streamId, int streamSetId,
         const StreamInfo& info = streamSet.streamInfoMap.valueFor(streamId);
         GraphicBufferEntry buffer;
         buffer.fenceFd = -1;
-        buffer.graphicBuffer = new GraphicBuffer(
-                info.width, info.height, PixelFormat(info.format), info.combinedUsage,
-                std::string("Camera3BufferManager pid [") +
-                        std::to_string(getpid()) + "]");
-        status_t res = buffer.graphicBuffer->initCheck();
-
-        ALOGV("%s: allocating a new graphic buffer (%dx%d, format 0x%x) %p with handle %p",
-                __FUNCTION__, info.width, info.height, info.format,
-                buffer.graphicBuffer.get(), buffer.graphicBuffer->handle);
-        if (res < 0) {
-            ALOGE("%s: graphic buffer allocation failed: (error %d %s) ",
-                    __FUNCTION__, res, strerror(-res));
-            return res;
+        // Reuse a compatible buffer released by another stream or session if there is one.
+        buffer.graphicBuffer = mBufferPool->acquireBuffer(info.width, info.height, info.format,
+                info.combinedUsage, &buffer.fenceFd);
+        status_t res;
+        if (buffer.graphicBuffer == nullptr) {
+            buffer.graphicBuffer = new GraphicBuffer(
+                    info.width, info.height, PixelFormat(info.format), info.combinedUsage,
+                    std::string("Camera3BufferManager pid [") +
+                            std::to_string(getpid()) + "]");
+            res = buffer.graphicBuffer->initCheck();
+
+            ALOGV("%s: allocating a new graphic buffer (%dx%d, format 0x%x) %p with handle %p",
+                    __FUNCTION__, info.width, info.height, info.format,
+                    buffer.graphicBuffer.get(), buffer.graphicBuffer->handle);
+            if (res < 0) {
+                ALOGE("%s: graphic buffer allocation failed: (error %d %s) ",
+                        __FUNCTION__, res, strerror(-res));
+                return res;
+            }
+            ALOGV("%s: allocation done", __FUNCTION__);
         }
-        ALOGV("%s: allocation done", __FUNCTION__);
 
         // Increase the hand-out and attached buffer counts for tracking purposes.
         bufferCount++;
@@ -432,6 +443,10 @@ status_t Camera3BufferManager::onBuffersRemoved(int streamId, int streamSetId, s
     return OK;
 }
 
+void Camera3BufferManager::recycleBuffer(const sp<GraphicBuffer>& buffer, int fenceFd) {
+    mBufferPool->releaseBuffer(buffer, fenceFd);
+}
+
 void Camera3BufferManager::dump(int fd, const Vector<String16>& args) const {
     Mutex::Autolock l(mLock);
 
@@ -463,6 +478,7 @@ void Camera3BufferManager::dump(int fd, const Vector<String16>& args) const {
         }
     }
     write(fd, lines.string(), lines.size());
+    mBufferPool->dump(fd);
 }
 
 bool Camera3BufferManager::checkIfStreamRegisteredLocked(int streamId, int streamSetId) const {
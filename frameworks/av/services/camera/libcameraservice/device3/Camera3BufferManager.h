@@ -23,6 +23,7 @@
 #include <utils/RefBase.h>
 #include <utils/KeyedVector.h>
 #include "Camera3OutputStream.h"
+#include "Camera3BufferPool.h"
 
 namespace android {
 
@@ -173,6 +174,14 @@ public:
      */
     void notifyBufferRemoved(int streamId, int streamSetId);
 
+    /**
+     * This method hands a buffer detached from a stream back to the buffer manager, when the
+     * stream no longer needs it. The buffer is kept in the process-wide buffer pool, so it can be
+     * reused by compatible streams of this or later sessions. The buffer manager takes ownership
+     * of fenceFd.
+     */
+    void recycleBuffer(const sp<GraphicBuffer>& buffer, int fenceFd);
+
     /**
      * Dump the buffer manager statistics.
      */
@@ -290,6 +299,11 @@ private:
     KeyedVector<StreamSetId, StreamSet> mStreamSetMap;
     KeyedVector<StreamId, wp<Camera3OutputStream>> mStreamMap;
 
+    /**
+     * Free buffers shared with the buffer managers of all camera devices.
+     */
+    sp<Camera3BufferPool> mBufferPool;
+
     // TODO: There is no easy way to query the Gralloc version in this code yet, we have different
     // code paths for different Gralloc versions, hardcode something here for now.
     const uint32_t mGrallocVersion = GRALLOC_DEVICE_API_VERSION_0_1;
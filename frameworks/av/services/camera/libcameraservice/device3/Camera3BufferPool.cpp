@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3-BufferPool"
+#define ATRACE_TAG ATRACE_TAG_CAMERA
+
+#include <inttypes.h>
+
+#include <cutils/properties.h>
+#include <ui/PixelFormat.h>
+#include <utils/Log.h>
+#include <utils/String8.h>
+#include <utils/Trace.h>
+#include "Camera3BufferPool.h"
+
+namespace android {
+
+namespace camera3 {
+
+// Default memory budget of the free buffers, in KB.
+static const int32_t kDefaultMaxKb = 64 * 1024;
+// Default time after which an unused buffer is freed, in ms.
+static const int32_t kDefaultIdleMs = 10000;
+
+sp<Camera3BufferPool> Camera3BufferPool::getInstance() {
+    static Mutex sLock;
+    static sp<Camera3BufferPool> sInstance;
+
+    Mutex::Autolock l(sLock);
+    if (sInstance == nullptr) {
+        sInstance = new Camera3BufferPool();
+        status_t res = sInstance->run("C3BufferPool");
+        if (res != OK) {
+            ALOGE("%s: Unable to start buffer pool thread: %s (%d)",
+                    __FUNCTION__, strerror(-res), res);
+        }
+    }
+    return sInstance;
+}
+
+Camera3BufferPool::Camera3BufferPool() :
+        Thread(/*canCallJava*/false),
+        mFreeBytes(0),
+        mMaxBytes(static_cast<size_t>(
+                property_get_int32("camera.bufferpool.max_kb", kDefaultMaxKb)) * 1024),
+        mIdleTimeout(milliseconds_to_nanoseconds(
+                property_get_int32("camera.bufferpool.idle_ms", kDefaultIdleMs))),
+        mPeakFreeBytes(0),
+        mHitCount(0),
+        mMissCount(0),
+        mTrimCount(0) {
+}
+
+Camera3BufferPool::~Camera3BufferPool() {
+    Mutex::Autolock l(mLock);
+    trimLocked(0);
+}
+
+sp<GraphicBuffer> Camera3BufferPool::acquireBuffer(uint32_t width, uint32_t height,
+        uint32_t format, uint32_t usage, int* fenceFd) {
+    ATRACE_CALL();
+    Mutex::Autolock l(mLock);
+
+    for (auto it = mFreeBuffers.begin(); it != mFreeBuffers.end(); it++) {
+        const sp<GraphicBuffer>& gb = it->buffer;
+        if (gb->getWidth() == width && gb->getHeight() == height &&
+                static_cast<uint32_t>(gb->getPixelFormat()) == format &&
+                static_cast<uint32_t>(gb->getUsage()) == usage) {
+            sp<GraphicBuffer> buffer = gb;
+            *fenceFd = it->fenceFd;
+            mFreeBytes -= it->size;
+            mFreeBuffers.erase(it);
+            mHitCount++;
+            ALOGV("%s: reusing buffer %p (%dx%d, format 0x%x, usage 0x%x)", __FUNCTION__,
+                    buffer.get(), width, height, format, usage);
+            return buffer;
+        }
+    }
+
+    mMissCount++;
+    return nullptr;
+}
+
+void Camera3BufferPool::releaseBuffer(const sp<GraphicBuffer>& buffer, int fenceFd) {
+    ATRACE_CALL();
+    if (buffer == nullptr) {
+        if (fenceFd >= 0) {
+            close(fenceFd);
+        }
+        return;
+    }
+
+    Entry entry;
+    entry.buffer = buffer;
+    entry.fenceFd = fenceFd;
+    entry.size = estimateBufferSize(buffer);
+    entry.releaseTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    Mutex::Autolock l(mLock);
+    if (entry.size > mMaxBytes) {
+        ALOGV("%s: buffer %p (%zu bytes) exceeds the pool budget", __FUNCTION__,
+                buffer.get(), entry.size);
+        if (fenceFd >= 0) {
+            close(fenceFd);
+        }
+        return;
+    }
+
+    trimLocked(mMaxBytes - entry.size);
+    mFreeBuffers.push_front(entry);
+    mFreeBytes += entry.size;
+    if (mFreeBytes > mPeakFreeBytes) {
+        mPeakFreeBytes = mFreeBytes;
+    }
+    mReleaseSignal.signal();
+}
+
+void Camera3BufferPool::trim(size_t maxBytes) {
+    Mutex::Autolock l(mLock);
+    trimLocked(maxBytes);
+}
+
+void Camera3BufferPool::trimLocked(size_t maxBytes) {
+    while (mFreeBytes > maxBytes && !mFreeBuffers.empty()) {
+        freeEntryLocked(std::prev(mFreeBuffers.end()));
+    }
+}
+
+void Camera3BufferPool::freeEntryLocked(std::list<Entry>::iterator it) {
+    ALOGV("%s: freeing buffer %p (%zu bytes)", __FUNCTION__, it->buffer.get(), it->size);
+    if (it->fenceFd >= 0) {
+        close(it->fenceFd);
+    }
+    mFreeBytes -= it->size;
+    mTrimCount++;
+    mFreeBuffers.erase(it);
+}
+
+bool Camera3BufferPool::threadLoop() {
+    Mutex::Autolock l(mLock);
+
+    if (mFreeBuffers.empty()) {
+        mReleaseSignal.wait(mLock);
+        return true;
+    }
+
+    // The oldest buffers are at the end of the list.
+    nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    while (!mFreeBuffers.empty() && now - mFreeBuffers.back().releaseTime >= mIdleTimeout) {
+        freeEntryLocked(std::prev(mFreeBuffers.end()));
+    }
+    if (!mFreeBuffers.empty()) {
+        mReleaseSignal.waitRelative(mLock,
+                mFreeBuffers.back().releaseTime + mIdleTimeout - now);
+    }
+    return true;
+}
+
+size_t Camera3BufferPool::estimateBufferSize(const sp<GraphicBuffer>& buffer) {
+    size_t stride = buffer->getStride() > 0 ? buffer->getStride() : buffer->getWidth();
+    size_t pixels = stride * buffer->getHeight();
+    switch (buffer->getPixelFormat()) {
+        case HAL_PIXEL_FORMAT_BLOB:
+            // Width is the buffer size in bytes.
+            return buffer->getWidth() * buffer->getHeight();
+        case HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED:
+        case HAL_PIXEL_FORMAT_YCbCr_420_888:
+        case HAL_PIXEL_FORMAT_YCrCb_420_SP:
+        case HAL_PIXEL_FORMAT_YV12:
+            return pixels * 3 / 2;
+        case HAL_PIXEL_FORMAT_RAW10:
+        case HAL_PIXEL_FORMAT_RAW12:
+        case HAL_PIXEL_FORMAT_RAW16:
+        case HAL_PIXEL_FORMAT_RAW_OPAQUE:
+        case HAL_PIXEL_FORMAT_Y16:
+            return pixels * 2;
+        default: {
+            ssize_t bpp = bytesPerPixel(buffer->getPixelFormat());
+            return pixels * (bpp > 0 ? bpp : 4);
+        }
+    }
+}
+
+void Camera3BufferPool::dump(int fd) const {
+    Mutex::Autolock l(mLock);
+
+    String8 lines;
+    lines.appendFormat("      Shared buffer pool: %zu free buffers, %zu KB (peak %zu KB, "
+            "budget %zu KB)\n", mFreeBuffers.size(), mFreeBytes / 1024, mPeakFreeBytes / 1024,
+            mMaxBytes / 1024);
+    lines.appendFormat("        Reused: %" PRIu64 ", allocated: %" PRIu64 ", freed: %" PRIu64
+            "\n", mHitCount, mMissCount, mTrimCount);
+    for (const auto& entry : mFreeBuffers) {
+        lines.appendFormat("        %ux%u format 0x%x usage 0x%x, %zu KB\n",
+                entry.buffer->getWidth(), entry.buffer->getHeight(),
+                entry.buffer->getPixelFormat(), entry.buffer->getUsage(), entry.size / 1024);
+    }
+    write(fd, lines.string(), lines.size());
+}
+
+} // namespace camera3
+} // namespace android
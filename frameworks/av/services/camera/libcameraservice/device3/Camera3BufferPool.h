@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA3_BUFFER_POOL_H
+#define ANDROID_SERVERS_CAMERA3_BUFFER_POOL_H
+
+#include <list>
+#include <ui/GraphicBuffer.h>
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+#include <utils/Thread.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+namespace camera3 {
+
+/**
+ * A process-wide pool of free gralloc buffers shared by all camera devices.
+ *
+ * Buffer managers hand buffers they no longer need to this pool instead of freeing them, and
+ * look for a compatible buffer (same size, format and usage) here before allocating a new one.
+ * This lets streams of a later session, or other streams of the same session, reuse buffers
+ * without going through gralloc, which dominates stream configuration time.
+ *
+ * The pool is bounded by a memory budget (camera.bufferpool.max_kb), evicting the oldest buffers
+ * first, and buffers that stay unused for longer than camera.bufferpool.idle_ms are freed by the
+ * pool thread.
+ */
+class Camera3BufferPool: public Thread {
+public:
+    static sp<Camera3BufferPool> getInstance();
+
+    virtual ~Camera3BufferPool();
+
+    /**
+     * Take a free buffer matching the given properties out of the pool.
+     *
+     * Returns null if no compatible buffer is available. Otherwise fenceFd is set to the release
+     * fence of the buffer (or -1), which the caller takes ownership of.
+     */
+    sp<GraphicBuffer> acquireBuffer(uint32_t width, uint32_t height, uint32_t format,
+            uint32_t usage, int* fenceFd);
+
+    /**
+     * Hand a buffer no longer used by any stream to the pool. The pool takes ownership of
+     * fenceFd. The buffer is dropped if it doesn't fit in the memory budget.
+     */
+    void releaseBuffer(const sp<GraphicBuffer>& buffer, int fenceFd);
+
+    /**
+     * Free pooled buffers, oldest first, until at most maxBytes are held.
+     */
+    void trim(size_t maxBytes);
+
+    /**
+     * Dump the pool content and statistics.
+     */
+    void dump(int fd) const;
+
+private:
+    Camera3BufferPool();
+
+    virtual bool threadLoop() override;
+
+    struct Entry {
+        sp<GraphicBuffer> buffer;
+        int fenceFd;
+        size_t size;
+        nsecs_t releaseTime;
+    };
+
+    static size_t estimateBufferSize(const sp<GraphicBuffer>& buffer);
+
+    void trimLocked(size_t maxBytes);
+    void freeEntryLocked(std::list<Entry>::iterator it);
+
+    mutable Mutex mLock;
+    Condition mReleaseSignal;
+
+    // Free buffers, most recently released first.
+    std::list<Entry> mFreeBuffers;
+    size_t mFreeBytes;
+
+    const size_t mMaxBytes;
+    const nsecs_t mIdleTimeout;
+
+    // Statistics
+    size_t mPeakFreeBytes;
+    uint64_t mHitCount;
+    uint64_t mMissCount;
+    uint64_t mTrimCount;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA3_BUFFER_POOL_H
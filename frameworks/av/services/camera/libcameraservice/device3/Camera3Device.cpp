@@ -39,6 +39,9 @@
 
 #include <inttypes.h>
 
+#include <thread>
+#include <vector>
+
 #include <utils/Log.h>
 #include <utils/Trace.h>
 #include <utils/Timers.h>
@@ -3599,6 +3602,8 @@ Camera3Device::RequestThread::RequestThread(wp<Camera3Device> parent,
         mReconfigured(false),
         mDoPause(false),
         mPaused(true),
+        mPrevTriggers(0),
+        mPrevMaxExpectedDuration(kDefaultExpectedDuration),
         mFrameNumber(0),
         mLatestRequestId(NAME_NOT_FOUND),
         mCurrentAfTriggerId(0),
@@ -4155,7 +4160,24 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
             captureRequest->mSettings.sort();
             halRequest->settings = captureRequest->mSettings.getAndLock();
             mPrevRequest = captureRequest;
-            ALOGVV("%s: Request settings are NEW", __FUNCTION__);
+
+            // Requests built from the same template, such as the requests of a high speed
+            // batch, usually carry identical settings; let the HAL reuse the last ones
+            // instead of transferring and parsing them again. Triggers are one-shot, so
+            // requests with triggers are always sent in full.
+            const camera_metadata_t* prevSettings = mPrevSettings.getAndLock();
+            bool unchanged = !triggersMixedIn && prevSettings != NULL &&
+                    isSameSettings(halRequest->settings, prevSettings);
+            mPrevSettings.unlock(prevSettings);
+            if (unchanged) {
+                captureRequest->mSettings.unlock(halRequest->settings);
+                halRequest->settings = NULL;
+                ALOGVV("%s: Request settings are UNCHANGED", __FUNCTION__);
+            } else {
+                mPrevSettings = captureRequest->mSettings;
+                mPrevMaxExpectedDuration = calculateMaxExpectedDuration(halRequest->settings);
+                ALOGVV("%s: Request settings are NEW", __FUNCTION__);
+            }
 
             IF_ALOGV() {
                 camera_metadata_ro_entry_t e = camera_metadata_ro_entry_t();
@@ -4208,20 +4230,17 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
                     outputStream->cancelPrepare();
                 }
             }
+        }
 
-            res = outputStream->getBuffer(&outputBuffers->editItemAt(j),
-                    captureRequest->mOutputSurfaces[j]);
-            if (res != OK) {
-                // Can't get output buffer from gralloc queue - this could be due to
-                // abandoned queue or other consumer misbehavior, so not a fatal
-                // error
-                ALOGE("RequestThread: Can't get output buffer, skipping request:"
-                        " %s (%d)", strerror(-res), res);
-
-                return TIMED_OUT;
-            }
-            halRequest->num_output_buffers++;
+        res = getOutputBuffers(captureRequest, halRequest, outputBuffers);
+        if (res != OK) {
+            // Can't get output buffer from gralloc queue - this could be due to
+            // abandoned queue or other consumer misbehavior, so not a fatal
+            // error
+            ALOGE("RequestThread: Can't get output buffer, skipping request:"
+                    " %s (%d)", strerror(-res), res);
 
+            return TIMED_OUT;
         }
         totalNumBuffers += halRequest->num_output_buffers;
 
@@ -4244,7 +4263,7 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
                 totalNumBuffers, captureRequest->mResultExtras,
                 /*hasInput*/halRequest->input_buffer != NULL,
                 hasCallback,
-                calculateMaxExpectedDuration(halRequest->settings));
+                mPrevMaxExpectedDuration);
         ALOGVV("%s: registered in flight requestId = %" PRId32 ", frameNumber = %" PRId64
                ", burstId = %" PRId32 ".",
                 __FUNCTION__,
@@ -4260,6 +4279,91 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
     return OK;
 }
 
+status_t Camera3Device::RequestThread::getOutputBuffers(const sp<CaptureRequest>& captureRequest,
+        camera3_capture_request_t* halRequest, Vector<camera3_stream_buffer_t>* outputBuffers) {
+    ATRACE_CALL();
+    size_t numOutputs = captureRequest->mOutputStreams.size();
+    std::vector<status_t> results(numOutputs, OK);
+
+    camera3_stream_buffer_t* buffers = outputBuffers->editArray();
+    halRequest->output_buffers = buffers;
+
+    // Look up the surface IDs up front; the map must not be modified concurrently.
+    std::vector<const std::vector<size_t>*> surfaceIds(numOutputs);
+    for (size_t j = 0; j < numOutputs; j++) {
+        surfaceIds[j] = &captureRequest->mOutputSurfaces[j];
+    }
+
+    // Each stream has its own lock and buffer queue, so a slow dequeue from one consumer
+    // doesn't need to delay the dequeue from the others.
+    std::vector<std::thread> workers;
+    for (size_t j = 1; j < numOutputs; j++) {
+        workers.emplace_back([&captureRequest, buffers, &results, &surfaceIds, j]() {
+            results[j] = captureRequest->mOutputStreams[j]->getBuffer(
+                    &buffers[j], *surfaceIds[j]);
+        });
+    }
+    if (numOutputs > 0) {
+        results[0] = captureRequest->mOutputStreams[0]->getBuffer(
+                &buffers[0], *surfaceIds[0]);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    status_t res = OK;
+    for (size_t j = 0; j < numOutputs; j++) {
+        if (results[j] != OK) {
+            res = results[j];
+            break;
+        }
+    }
+    if (res == OK) {
+        halRequest->num_output_buffers = numOutputs;
+        return OK;
+    }
+
+    // Return the buffers that were acquired; cleanUpFailedRequests only knows about a
+    // contiguous prefix of acquired buffers.
+    for (size_t j = 0; j < numOutputs; j++) {
+        if (results[j] != OK) {
+            continue;
+        }
+        camera3_stream_buffer_t& buffer = buffers[j];
+        if (0 <= buffer.acquire_fence) {
+            close(buffer.acquire_fence);
+            buffer.acquire_fence = -1;
+        }
+        buffer.status = CAMERA3_BUFFER_STATUS_ERROR;
+        captureRequest->mOutputStreams.editItemAt(j)->returnBuffer(buffer, 0);
+    }
+    halRequest->num_output_buffers = 0;
+    return res;
+}
+
+bool Camera3Device::RequestThread::isSameSettings(const camera_metadata_t* settings,
+        const camera_metadata_t* prevSettings) {
+    size_t entryCount = get_camera_metadata_entry_count(settings);
+    if (entryCount != get_camera_metadata_entry_count(prevSettings) ||
+            get_camera_metadata_data_count(settings) !=
+            get_camera_metadata_data_count(prevSettings)) {
+        return false;
+    }
+    // Both buffers are sorted, so equal settings have their entries in the same order.
+    for (size_t i = 0; i < entryCount; i++) {
+        camera_metadata_ro_entry_t a, b;
+        if (get_camera_metadata_ro_entry(settings, i, &a) != OK ||
+                get_camera_metadata_ro_entry(prevSettings, i, &b) != OK) {
+            return false;
+        }
+        if (a.tag != b.tag || a.type != b.type || a.count != b.count ||
+                memcmp(a.data.u8, b.data.u8, camera_metadata_type_size[a.type] * a.count) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
 CameraMetadata Camera3Device::RequestThread::getLatestRequest() const {
     Mutex::Autolock al(mLatestRequestMutex);
 
@@ -4485,6 +4589,7 @@ sp<Camera3Device::CaptureRequest>
     // request if so. Can't use 'NULL request == repeat' across configure calls.
     if (mReconfigured) {
         mPrevRequest.clear();
+        mPrevSettings.clear();
         mReconfigured = false;
     }
 
@@ -750,6 +750,17 @@ class Camera3Device :
         // request batch.
         status_t prepareHalRequests();
 
+        // Whether two sorted settings buffers hold the same entries and values.
+        static bool isSameSettings(const camera_metadata_t* settings,
+                const camera_metadata_t* prevSettings);
+
+        // Acquire output buffers for all output streams of a request, dequeuing from different
+        // streams concurrently. Returns OK only if every buffer was acquired; otherwise all
+        // acquired buffers are returned in the ERROR state.
+        status_t getOutputBuffers(const sp<CaptureRequest>& captureRequest,
+                camera3_capture_request_t* halRequest,
+                Vector<camera3_stream_buffer_t>* outputBuffers);
+
         // Return buffers, etc, for requests in mNextRequests that couldn't be fully constructed and
         // send request errors if sendRequestError is true. The buffers will be returned in the
         // ERROR state to mark them as not having valid data. mNextRequests will be cleared.
@@ -813,6 +824,10 @@ class Camera3Device :
 
         sp<CaptureRequest> mPrevRequest;
         int32_t            mPrevTriggers;
+        // Copy of the last settings sent to the HAL. Requests with identical settings are
+        // sent with NULL settings so the HAL reuses the previous ones.
+        CameraMetadata     mPrevSettings;
+        nsecs_t            mPrevMaxExpectedDuration;
 
         uint32_t           mFrameNumber;
 
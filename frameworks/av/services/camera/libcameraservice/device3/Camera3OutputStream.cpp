@@ -586,6 +586,23 @@ status_t Camera3OutputStream::disconnectLocked() {
 
     ALOGV("%s: disconnecting stream %d from native window", __FUNCTION__, getId());
 
+    // Hand the free buffers of this stream back to the buffer manager so that later streams can
+    // reuse them instead of having them freed along with the buffer queue.
+    if (mUseBufferManager) {
+        sp<GraphicBuffer> buffer;
+        sp<Fence> fence;
+        while (mConsumer->detachNextBuffer(&buffer, &fence) == OK && buffer != nullptr) {
+            int fenceFd = (fence != nullptr && fence->isValid()) ? fence->dup() : -1;
+            mBufferManager->recycleBuffer(buffer, fenceFd);
+            buffer.clear();
+            fence.clear();
+        }
+        std::vector<sp<GraphicBuffer>> removedBuffers;
+        if (mConsumer->getAndFlushRemovedBuffers(&removedBuffers) == OK) {
+            onBuffersRemovedLocked(removedBuffers);
+        }
+    }
+
     res = native_window_api_disconnect(mConsumer.get(),
                                        NATIVE_WINDOW_API_CAMERA);
     /**
@@ -716,11 +733,15 @@ void Camera3OutputStream::BufferReleasedListener::onBufferReleased() {
 
     if (shouldFreeBuffer) {
         sp<GraphicBuffer> buffer;
-        // Detach and free a buffer (when buffer goes out of scope)
-        stream->detachBufferLocked(&buffer, /*fenceFd*/ nullptr);
+        int fenceFd = -1;
+        // Detach the buffer and hand it back to the buffer manager for reuse
+        stream->detachBufferLocked(&buffer, &fenceFd);
         if (buffer.get() != nullptr) {
             stream->mBufferManager->notifyBufferRemoved(
                     stream->getId(), stream->getStreamSetId());
+            stream->mBufferManager->recycleBuffer(buffer, fenceFd);
+        } else if (fenceFd >= 0) {
+            close(fenceFd);
         }
     }
 }
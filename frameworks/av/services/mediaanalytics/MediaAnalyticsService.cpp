@@ -160,6 +160,8 @@ MediaAnalyticsService::MediaAnalyticsService()
     // clear our queues
     mOpen = new List<MediaAnalyticsItem *>();
     mFinalized = new List<MediaAnalyticsItem *>();
+    mPending = new List<MediaAnalyticsItem *>();
+    mExiting = false;
 
     mSummarizerSets = new List<MediaAnalyticsService::SummarizerSet *>();
     newSummarizerSet();
@@ -171,11 +173,29 @@ MediaAnalyticsService::MediaAnalyticsService()
     mLastSessionID = 0;
     // recover any persistency we set up
     // etc
+
+    mSummarizerThread = new SummarizerThread(this);
+    mSummarizerThread->run("MediaAnalyticsSummarizer");
 }
 
 MediaAnalyticsService::~MediaAnalyticsService() {
         ALOGD("MediaAnalyticsService destroyed");
 
+    {
+        Mutex::Autolock _l(mLock_pending);
+        mExiting = true;
+        mPendingCond.signal();
+    }
+    mSummarizerThread->requestExitAndWait();
+    mSummarizerThread.clear();
+    while (mPending->size() > 0) {
+        MediaAnalyticsItem * oitem = *(mPending->begin());
+        mPending->erase(mPending->begin());
+        delete oitem;
+    }
+    delete mPending;
+    mPending = NULL;
+
     // clean out mOpen and mFinalized
     delete mOpen;
     mOpen = NULL;
@@ -270,13 +290,11 @@ MediaAnalyticsItem::SessionID_t MediaAnalyticsService::submit(MediaAnalyticsItem
                 oitem = NULL;
             } else {
                 oitem->setFinalized(true);
-                summarize(oitem);
-                saveItem(mFinalized, oitem, 0);
+                queueFinalized(oitem);
             }
             // new record could itself be marked finalized...
             if (finalizing) {
-                summarize(item);
-                saveItem(mFinalized, item, 0);
+                queueFinalized(item);
                 mItemsFinalized++;
             } else {
                 saveItem(mOpen, item, 1);
@@ -286,8 +304,7 @@ MediaAnalyticsItem::SessionID_t MediaAnalyticsService::submit(MediaAnalyticsItem
             // combine the records, send it to finalized if appropriate
             oitem->merge(item);
             if (finalizing) {
-                summarize(oitem);
-                saveItem(mFinalized, oitem, 0);
+                queueFinalized(oitem);
                 mItemsFinalized++;
             }
             id = oitem->getSessionID();
@@ -305,8 +322,7 @@ MediaAnalyticsItem::SessionID_t MediaAnalyticsService::submit(MediaAnalyticsItem
                 delete item;
                 item = NULL;
             } else {
-                summarize(item);
-                saveItem(mFinalized, item, 0);
+                queueFinalized(item);
                 mItemsFinalized++;
             }
         } else {
@@ -464,6 +480,8 @@ void MediaAnalyticsService::dumpSummaries(String8 &result, nsecs_t ts_since, con
     snprintf(buffer, SIZE, "\nSummarized Metrics:\n");
     result.append(buffer);
 
+    Mutex::Autolock _l(mLock_summaries);
+
     // have each of the distillers dump records
     if (mSummarizerSets != NULL) {
         List<SummarizerSet *>::iterator itSet = mSummarizerSets->begin();
@@ -681,8 +699,53 @@ bool MediaAnalyticsService::rateLimited(MediaAnalyticsItem *) {
     return false;
 }
 
+// hand a finalized record to the summarizer thread, which saves it
+// into mFinalized once summarized. we take ownership of 'item'.
+void MediaAnalyticsService::queueFinalized(MediaAnalyticsItem *item) {
+
+    Mutex::Autolock _l(mLock_pending);
+
+    mPending->push_back(item);
+
+    // if the summarizer falls behind, the oldest records go first
+    if (mMaxRecords > 0) {
+        while (mPending->size() > (size_t) mMaxRecords) {
+            MediaAnalyticsItem * oitem = *(mPending->begin());
+            mPending->erase(mPending->begin());
+            delete oitem;
+            mItemsDiscarded++;
+        }
+    }
+    mPendingCond.signal();
+}
+
+// summarizer thread body; false once the service is going away
+bool MediaAnalyticsService::processFinalized() {
+
+    MediaAnalyticsItem *item;
+    {
+        Mutex::Autolock _l(mLock_pending);
+        while (mPending->empty() && !mExiting) {
+            mPendingCond.wait(mLock_pending);
+        }
+        if (mExiting) {
+            return false;
+        }
+        item = *(mPending->begin());
+        mPending->erase(mPending->begin());
+    }
+
+    {
+        Mutex::Autolock _l(mLock_summaries);
+        summarize(item);
+    }
+    saveItem(mFinalized, item, 0);
+    return true;
+}
+
 // insert into the appropriate summarizer.
 // we make our own copy to save/summarize
+// caller has locked mLock_summaries...
 void MediaAnalyticsService::summarize(MediaAnalyticsItem *item) {
 
     ALOGV("MediaAnalyticsService::summarize()");
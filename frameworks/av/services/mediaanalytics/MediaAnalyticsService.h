@@ -85,6 +85,26 @@ class MediaAnalyticsService : public BnMediaAnalyticsService
 
     // summarizers
     void summarize(MediaAnalyticsItem *item);
+
+    // finalized records are summarized and moved into mFinalized on
+    // mSummarizerThread, so that submit() never runs the summarizers.
+    void queueFinalized(MediaAnalyticsItem *item);
+    bool processFinalized();
+    class SummarizerThread : public Thread {
+        MediaAnalyticsService *mService;
+      public:
+        explicit SummarizerThread(MediaAnalyticsService *service)
+            : Thread(false), mService(service) {}
+        virtual bool threadLoop() { return mService->processFinalized(); }
+    };
+    sp<SummarizerThread> mSummarizerThread;
+    // waiting for the summarizer (oldest at front), bounded like the queues
+    mutable Mutex           mLock_pending;
+    Condition               mPendingCond;
+    List<MediaAnalyticsItem *> *mPending;
+    bool mExiting;
+    // guards the summarizer sets, which dump() and the summarizer share
+    mutable Mutex           mLock_summaries;
     class SummarizerSet {
         nsecs_t mStarted;
         List<MetricsSummarizer *> *mSummarizers;
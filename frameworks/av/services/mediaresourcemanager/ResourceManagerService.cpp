@@ -145,12 +145,20 @@ status_t ResourceManagerService::dump(int fd, const Vector<String16>& /* args */
     PidResourceInfosMap mapCopy;
     bool supportsMultipleSecureCodecs;
     bool supportsSecureWithNonSecureCodec;
+    int64_t reclaimCount;
+    int64_t reclaimSuccessCount;
+    nsecs_t reclaimTotalTimeNs;
+    nsecs_t reclaimMaxTimeNs;
     String8 serviceLog;
     {
         Mutex::Autolock lock(mLock);
         mapCopy = mMap;  // Shadow copy, real copy will happen on write.
         supportsMultipleSecureCodecs = mSupportsMultipleSecureCodecs;
         supportsSecureWithNonSecureCodec = mSupportsSecureWithNonSecureCodec;
+        reclaimCount = mReclaimCount;
+        reclaimSuccessCount = mReclaimSuccessCount;
+        reclaimTotalTimeNs = mReclaimTotalTimeNs;
+        reclaimMaxTimeNs = mReclaimMaxTimeNs;
         serviceLog = mServiceLog->toString("    " /* linePrefix */);
     }
 
@@ -165,6 +173,15 @@ status_t ResourceManagerService::dump(int fd, const Vector<String16>& /* args */
             supportsSecureWithNonSecureCodec);
     result.append(buffer);
 
+    result.append("  Reclaims:\n");
+    snprintf(buffer, SIZE, "    Count: %lld (%lld succeeded)\n",
+            (long long)reclaimCount, (long long)reclaimSuccessCount);
+    result.append(buffer);
+    snprintf(buffer, SIZE, "    Time: avg %.2f ms, max %.2f ms\n",
+            reclaimCount > 0 ? reclaimTotalTimeNs / (reclaimCount * 1E6) : 0.0,
+            reclaimMaxTimeNs / 1E6);
+    result.append(buffer);
+
     result.append("  Processes:\n");
     for (size_t i = 0; i < mapCopy.size(); ++i) {
         snprintf(buffer, SIZE, "    Pid: %d\n", mapCopy.keyAt(i));
@@ -201,7 +218,11 @@ ResourceManagerService::ResourceManagerService(sp<ProcessInfoInterface> processI
     : mProcessInfo(processInfo),
       mServiceLog(new ServiceLog()),
       mSupportsMultipleSecureCodecs(true),
-      mSupportsSecureWithNonSecureCodec(true) {}
+      mSupportsSecureWithNonSecureCodec(true),
+      mReclaimCount(0),
+      mReclaimSuccessCount(0),
+      mReclaimTotalTimeNs(0),
+      mReclaimMaxTimeNs(0) {}
 
 ResourceManagerService::~ResourceManagerService() {}
 
@@ -294,6 +315,24 @@ void ResourceManagerService::getClientForResource_l(
 
 bool ResourceManagerService::reclaimResource(
         int callingPid, const Vector<MediaResource> &resources) {
+    nsecs_t startTime = systemTime();
+    bool reclaimed = reclaimResourceInternal(callingPid, resources);
+    nsecs_t duration = systemTime() - startTime;
+
+    Mutex::Autolock lock(mLock);
+    ++mReclaimCount;
+    if (reclaimed) {
+        ++mReclaimSuccessCount;
+    }
+    mReclaimTotalTimeNs += duration;
+    if (duration > mReclaimMaxTimeNs) {
+        mReclaimMaxTimeNs = duration;
+    }
+    return reclaimed;
+}
+
+bool ResourceManagerService::reclaimResourceInternal(
+        int callingPid, const Vector<MediaResource> &resources) {
     String8 log = String8::format("reclaimResource(callingPid %d, resources %s)",
             callingPid, getString(resources).string());
     mServiceLog->add(log);
@@ -301,6 +340,7 @@ bool ResourceManagerService::reclaimResource(
     Vector<sp<IResourceManagerClient>> clients;
     {
         Mutex::Autolock lock(mLock);
+        mPriorityCache.clear();
         if (!mProcessInfo->isValidPid(callingPid)) {
             ALOGE("Rejected reclaimResource call with invalid callingPid.");
             return false;
@@ -438,7 +478,7 @@ bool ResourceManagerService::getLowestPriorityBiggestClient_l(
     int lowestPriorityPid;
     int lowestPriority;
     int callingPriority;
-    if (!mProcessInfo->getPriority(callingPid, &callingPriority)) {
+    if (!getPriority_l(callingPid, &callingPriority)) {
         ALOGE("getLowestPriorityBiggestClient_l: can't get process priority for pid %d",
                 callingPid);
         return false;
@@ -473,7 +513,7 @@ bool ResourceManagerService::getLowestPriorityPid_l(
         }
         int tempPid = mMap.keyAt(i);
         int tempPriority;
-        if (!mProcessInfo->getPriority(tempPid, &tempPriority)) {
+        if (!getPriority_l(tempPid, &tempPriority)) {
             ALOGV("getLowestPriorityPid_l: can't get priority of pid %d, skipped", tempPid);
             // TODO: remove this pid from mMap?
             continue;
@@ -493,18 +533,31 @@ bool ResourceManagerService::getLowestPriorityPid_l(
 
 bool ResourceManagerService::isCallingPriorityHigher_l(int callingPid, int pid) {
     int callingPidPriority;
-    if (!mProcessInfo->getPriority(callingPid, &callingPidPriority)) {
+    if (!getPriority_l(callingPid, &callingPidPriority)) {
         return false;
     }
 
     int priority;
-    if (!mProcessInfo->getPriority(pid, &priority)) {
+    if (!getPriority_l(pid, &priority)) {
         return false;
     }
 
     return (callingPidPriority < priority);
 }
 
+bool ResourceManagerService::getPriority_l(int pid, int *priority) {
+    ssize_t index = mPriorityCache.indexOfKey(pid);
+    if (index >= 0) {
+        *priority = mPriorityCache.valueAt(index);
+        return true;
+    }
+    if (!mProcessInfo->getPriority(pid, priority)) {
+        return false;
+    }
+    mPriorityCache.add(pid, *priority);
+    return true;
+}
+
 bool ResourceManagerService::getBiggestClient_l(
         int pid, MediaResource::Type type, sp<IResourceManagerClient> *client) {
     ssize_t index = mMap.indexOfKey(pid);
@@ -517,7 +570,7 @@ bool ResourceManagerService::getBiggestClient_l(
     uint64_t largestValue = 0;
     const ResourceInfos &infos = mMap.valueAt(index);
     for (size_t i = 0; i < infos.size(); ++i) {
-        Vector<MediaResource> resources = infos[i].resources;
+        const Vector<MediaResource> &resources = infos[i].resources;
         for (size_t j = 0; j < resources.size(); ++j) {
             if (resources[j].mType == type) {
                 if (resources[j].mValue > largestValue) {
@@ -24,6 +24,7 @@
 #include <utils/KeyedVector.h>
 #include <utils/String8.h>
 #include <utils/threads.h>
+#include <utils/Timers.h>
 #include <utils/Vector.h>
 
 #include <media/IResourceManagerService.h>
@@ -101,6 +102,12 @@ private:
 
     bool isCallingPriorityHigher_l(int callingPid, int pid);
 
+    // Gets the priority of pid, asking mProcessInfo only the first time pid is looked up since
+    // mPriorityCache was last cleared. Returns false if the priority can't be found.
+    bool getPriority_l(int pid, int *priority);
+
+    bool reclaimResourceInternal(int callingPid, const Vector<MediaResource> &resources);
+
     // A helper function basically calls getLowestPriorityBiggestClient_l and add the result client
     // to the given Vector.
     void getClientForResource_l(
@@ -112,6 +119,14 @@ private:
     PidResourceInfosMap mMap;
     bool mSupportsMultipleSecureCodecs;
     bool mSupportsSecureWithNonSecureCodec;
+    // Process priorities don't change much during one reclaim, but looking them up is a binder
+    // call to the activity manager made with mLock held. Cleared by each reclaimResource call.
+    KeyedVector<int, int> mPriorityCache;
+    // Reclaim statistics for dump.
+    int64_t mReclaimCount;
+    int64_t mReclaimSuccessCount;
+    nsecs_t mReclaimTotalTimeNs;
+    nsecs_t mReclaimMaxTimeNs;
 };
 
 // ----------------------------------------------------------------------------
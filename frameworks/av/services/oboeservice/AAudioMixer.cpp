@@ -29,6 +29,25 @@
 #define AAUDIO_MIXER_ATRACE_ENABLED    1
 #endif
 
+// Select the vector kernel at compile time, the same way libaudioprocessing does.
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#ifndef USE_NEON
+#define USE_NEON (true)
+#endif
+#else
+#define USE_NEON (false)
+#endif
+#if USE_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(__SSE__)  // Part of the x86 ABI for both 32 & 64-bit.
+#define USE_SSE (true)
+#include <xmmintrin.h>
+#else
+#define USE_SSE (false)
+#endif
+
 using android::WrappingBuffer;
 using android::FifoBuffer;
 using android::fifo_frames_t;
@@ -102,8 +121,36 @@ bool AAudioMixer::mix(int trackIndex, FifoBuffer *fifo, float volume) {
 
 void AAudioMixer::mixPart(float *destination, float *source, int32_t numFrames, float volume) {
     int32_t numSamples = numFrames * mSamplesPerFrame;
-    // TODO maybe optimize using SIMD
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
+    int32_t sampleIndex = 0;
+    // Neither buffer is guaranteed to be aligned: the FIFO may wrap at any frame,
+    // and the destination advances by whole frames. So use unaligned loads and stores.
+#if USE_NEON
+    const float32x4_t vol = vdupq_n_f32(volume);
+    for (; sampleIndex + 8 <= numSamples; sampleIndex += 8) {
+        float32x4_t out0 = vld1q_f32(destination);
+        float32x4_t out1 = vld1q_f32(destination + 4);
+        out0 = vmlaq_f32(out0, vld1q_f32(source), vol);
+        out1 = vmlaq_f32(out1, vld1q_f32(source + 4), vol);
+        vst1q_f32(destination, out0);
+        vst1q_f32(destination + 4, out1);
+        destination += 8;
+        source += 8;
+    }
+#elif USE_SSE
+    const __m128 vol = _mm_set1_ps(volume);
+    for (; sampleIndex + 8 <= numSamples; sampleIndex += 8) {
+        __m128 out0 = _mm_loadu_ps(destination);
+        __m128 out1 = _mm_loadu_ps(destination + 4);
+        out0 = _mm_add_ps(out0, _mm_mul_ps(_mm_loadu_ps(source), vol));
+        out1 = _mm_add_ps(out1, _mm_mul_ps(_mm_loadu_ps(source + 4), vol));
+        _mm_storeu_ps(destination, out0);
+        _mm_storeu_ps(destination + 4, out1);
+        destination += 8;
+        source += 8;
+    }
+#endif
+    // remainder, or the whole buffer without a vector unit
+    for (; sampleIndex < numSamples; sampleIndex++) {
         *destination++ += *source++ * volume;
     }
 }
@@ -57,4 +57,4 @@ LOCAL_SHARED_LIBRARIES :=  \
 
 include $(BUILD_SHARED_LIBRARY)
 
-
+include $(call all-makefiles-under,$(LOCAL_PATH))
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the cost of mixing one burst of client data on the shared MMAP endpoint.
+
+#include <stdlib.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "AAudioMixer.h"
+
+using android::FifoBuffer;
+
+static const int32_t kSamplesPerFrame = 2;
+
+static void fillRandom(float *buffer, int32_t numSamples) {
+    srandom(12345);
+    for (int32_t i = 0; i < numSamples; i++) {
+        buffer[i] = (float) random() / RAND_MAX * 2.0f - 1.0f;
+    }
+}
+
+// The loop AAudioMixer::mixPart() used before it was vectorized.
+static void mixPartScalar(float *destination, const float *source, int32_t numSamples,
+                          float volume) {
+    for (int32_t sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
+        *destination++ += *source++ * volume;
+    }
+}
+
+static void BM_AAudioMixer_mixPartScalar(benchmark::State& state) {
+    const int32_t framesPerBurst = state.range(0);
+    const int32_t numSamples = framesPerBurst * kSamplesPerFrame;
+    std::vector<float> source(numSamples);
+    std::vector<float> destination(numSamples);
+    fillRandom(source.data(), numSamples);
+    while (state.KeepRunning()) {
+        mixPartScalar(destination.data(), source.data(), numSamples, 0.5f);
+        benchmark::DoNotOptimize(destination.data());
+    }
+    state.SetItemsProcessed(state.iterations() * framesPerBurst);
+}
+BENCHMARK(BM_AAudioMixer_mixPartScalar)->Arg(48)->Arg(96)->Arg(192)->Arg(480)->Arg(1024);
+
+static void BM_AAudioMixer_mixPart(benchmark::State& state) {
+    const int32_t framesPerBurst = state.range(0);
+    const int32_t numSamples = framesPerBurst * kSamplesPerFrame;
+    AAudioMixer mixer;
+    mixer.allocate(kSamplesPerFrame, framesPerBurst);
+    std::vector<float> source(numSamples);
+    fillRandom(source.data(), numSamples);
+    mixer.clear();
+    while (state.KeepRunning()) {
+        mixer.mixPart(mixer.getOutputBuffer(), source.data(), framesPerBurst, 0.5f);
+        benchmark::DoNotOptimize(mixer.getOutputBuffer());
+    }
+    state.SetItemsProcessed(state.iterations() * framesPerBurst);
+}
+BENCHMARK(BM_AAudioMixer_mixPart)->Arg(48)->Arg(96)->Arg(192)->Arg(480)->Arg(1024);
+
+// A whole endpoint burst: clear, then mix one full FIFO per client.
+static void BM_AAudioMixer_mixBurst(benchmark::State& state) {
+    const int32_t framesPerBurst = state.range(0);
+    const int32_t numClients = state.range(1);
+    const int32_t numSamples = framesPerBurst * kSamplesPerFrame;
+    AAudioMixer mixer;
+    mixer.allocate(kSamplesPerFrame, framesPerBurst);
+    std::vector<float> source(numSamples);
+    fillRandom(source.data(), numSamples);
+    std::vector<FifoBuffer *> fifos;
+    for (int32_t i = 0; i < numClients; i++) {
+        fifos.push_back(new FifoBuffer(kSamplesPerFrame * sizeof(float), 2 * framesPerBurst));
+    }
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        for (FifoBuffer *fifo : fifos) {
+            fifo->write(source.data(), framesPerBurst);
+        }
+        state.ResumeTiming();
+        mixer.clear();
+        for (int32_t i = 0; i < numClients; i++) {
+            mixer.mix(i, fifos[i], 1.0f);
+        }
+        benchmark::DoNotOptimize(mixer.getOutputBuffer());
+    }
+    for (FifoBuffer *fifo : fifos) {
+        delete fifo;
+    }
+    state.SetItemsProcessed(state.iterations() * framesPerBurst * numClients);
+}
+BENCHMARK(BM_AAudioMixer_mixBurst)->Args({96, 1})->Args({96, 4})->Args({192, 8})
+        ->Args({480, 8});
+
+BENCHMARK_MAIN();
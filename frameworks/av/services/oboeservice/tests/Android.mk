@@ -0,0 +1,16 @@
+LOCAL_PATH := $(call my-dir)
+
+# Burst mixing cost of the shared MMAP endpoint mixer
+include $(CLEAR_VARS)
+LOCAL_C_INCLUDES := \
+    $(call include-path-for, audio-utils) \
+    frameworks/av/media/libaaudio/include \
+    frameworks/av/media/libaaudio/src \
+    frameworks/av/services/oboeservice
+LOCAL_SRC_FILES:= \
+    ../AAudioMixer.cpp \
+    AAudioMixer_benchmark.cpp
+LOCAL_SHARED_LIBRARIES := libaaudio libcutils liblog libutils
+LOCAL_CFLAGS += -Wall -Werror
+LOCAL_MODULE := AAudioMixer_benchmark
+include $(BUILD_NATIVE_BENCHMARK)
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Offline analysis of the typed NBLog events found in "adb shell dumpsys media.log" output.
+// The dump prints each typed event on its own line, see NBLog::Reader::handleTyped():
+//     [sec.ms] <author>: event=<name> t_us=<time> <field>=<value> ...
+// Other lines are ignored, so a whole bugreport can be fed in.
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct Event {
+    std::string name;
+    uint64_t tUs;
+    uint64_t value;     // duration in microseconds, or frames missing for underruns
+    uint64_t track;     // underruns only
+};
+
+// A series of events of one type from one author, in log order
+typedef std::map<std::pair<std::string, std::string>, std::vector<Event>> Series;
+
+static bool parseField(const char *line, const char *key, uint64_t *value) {
+    const char *p = strstr(line, key);
+    if (p == NULL) {
+        return false;
+    }
+    char *end;
+    *value = strtoull(p + strlen(key), &end, 10);
+    return end != p + strlen(key);
+}
+
+// Returns false for lines that are not typed events.
+static bool parseLine(const char *line, std::string *author, Event *event) {
+    const char *ev = strstr(line, "event=");
+    if (ev == NULL) {
+        return false;
+    }
+    const char *nameEnd = strchr(ev, ' ');
+    if (nameEnd == NULL) {
+        return false;
+    }
+    event->name.assign(ev + strlen("event="), nameEnd - ev - strlen("event="));
+    if (!parseField(nameEnd, " t_us=", &event->tUs)) {
+        return false;
+    }
+    event->track = 0;
+    if (event->name == "underrun") {
+        if (!parseField(nameEnd, " track=", &event->track)
+                || !parseField(nameEnd, " frames=", &event->value)) {
+            return false;
+        }
+    } else if (!parseField(nameEnd, " us=", &event->value)) {
+        return false;
+    }
+    // author is between the "] " ending the timestamp and the ": " before "event="
+    author->clear();
+    const char *bracket = strchr(line, ']');
+    if (bracket != NULL && bracket + 2 < ev) {
+        const char *begin = bracket + 2;
+        const char *end = ev;
+        while (end > begin && (end[-1] == ' ' || end[-1] == ':')) {
+            --end;
+        }
+        author->assign(begin, end - begin);
+    }
+    if (author->empty()) {
+        *author = "(unknown)";
+    }
+    return true;
+}
+
+static double percentile(const std::vector<uint64_t> &sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t) (p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static void printStats(const std::vector<uint64_t> &values, const char *unit) {
+    std::vector<uint64_t> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0, sumSq = 0;
+    for (uint64_t v : sorted) {
+        sum += v;
+        sumSq += (double) v * v;
+    }
+    const double mean = sum / sorted.size();
+    const double stddev = sqrt(std::max(0.0, sumSq / sorted.size() - mean * mean));
+    printf("    count %zu  min %" PRIu64 "  mean %.1f  stddev %.1f  p50 %.0f  p90 %.0f"
+            "  p99 %.0f  max %" PRIu64 " %s\n",
+            sorted.size(), sorted.front(), mean, stddev, percentile(sorted, 0.50),
+            percentile(sorted, 0.90), percentile(sorted, 0.99), sorted.back(), unit);
+}
+
+// Power-of-two buckets: bucket b holds values in [2^(b-1), 2^b), bucket 0 holds 0.
+static void printHistogram(const std::vector<uint64_t> &values, const char *unit) {
+    std::vector<size_t> counts;
+    for (uint64_t v : values) {
+        size_t bucket = 0;
+        while (v != 0) {
+            v >>= 1;
+            bucket++;
+        }
+        if (counts.size() <= bucket) {
+            counts.resize(bucket + 1);
+        }
+        counts[bucket]++;
+    }
+    const size_t maxCount = *std::max_element(counts.begin(), counts.end());
+    static const int kWidth = 50;
+    for (size_t b = 0; b < counts.size(); b++) {
+        if (counts[b] == 0) {
+            continue;
+        }
+        const uint64_t low = b == 0 ? 0 : 1ull << (b - 1);
+        const uint64_t high = b == 0 ? 1 : 1ull << b;
+        const int width = (int) ((counts[b] * kWidth + maxCount - 1) / maxCount);
+        printf("    [%8" PRIu64 ", %8" PRIu64 ") %s %8zu %.*s\n", low, high, unit, counts[b],
+                width, "##################################################");
+    }
+}
+
+static void reportDurations(const std::string &author, const std::string &name,
+        const std::vector<Event> &events) {
+    std::vector<uint64_t> values;
+    for (const Event &e : events) {
+        values.push_back(e.value);
+    }
+    printf("%s %s duration\n", author.c_str(), name.c_str());
+    printStats(values, "us");
+    printHistogram(values, "us");
+
+    // jitter: spread of the interval between consecutive events of this type
+    std::vector<uint64_t> intervals;
+    for (size_t i = 1; i < events.size(); i++) {
+        if (events[i].tUs >= events[i - 1].tUs) {
+            intervals.push_back(events[i].tUs - events[i - 1].tUs);
+        }
+    }
+    if (!intervals.empty()) {
+        printf("%s %s interval (jitter)\n", author.c_str(), name.c_str());
+        printStats(intervals, "us");
+    }
+    printf("\n");
+}
+
+static void reportUnderruns(const std::string &author, const std::vector<Event> &events) {
+    std::map<uint64_t, std::pair<size_t, uint64_t>> perTrack;  // count, frames missing
+    for (const Event &e : events) {
+        perTrack[e.track].first++;
+        perTrack[e.track].second += e.value;
+    }
+    const double spanS = events.size() > 1
+            ? (events.back().tUs - events.front().tUs) * 1e-6 : 0.;
+    printf("%s underruns: %zu over %.3f s\n", author.c_str(), events.size(), spanS);
+    for (const auto &track : perTrack) {
+        printf("    track %" PRIu64 ": %zu underruns, %" PRIu64 " frames missing\n",
+                track.first, track.second.first, track.second.second);
+    }
+    printf("\n");
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-h] [file ...]\n"
+            "    Reads \"dumpsys media.log\" output from the files, or stdin if none,\n"
+            "    and reports histograms and jitter of the typed NBLog events.\n", name);
+}
+
+static void readEvents(FILE *f, Series *series) {
+    char line[1024];
+    std::string author;
+    Event event;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (parseLine(line, &author, &event)) {
+            (*series)[std::make_pair(author, event.name)].push_back(event);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    int ch;
+    while ((ch = getopt(argc, argv, "h")) != -1) {
+        switch (ch) {
+        case 'h':
+        default:
+            usage(argv[0]);
+            return ch == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    Series series;
+    if (optind == argc) {
+        readEvents(stdin, &series);
+    }
+    for (int i = optind; i < argc; i++) {
+        FILE *f = fopen(argv[i], "r");
+        if (f == NULL) {
+            fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[i]);
+            return EXIT_FAILURE;
+        }
+        readEvents(f, &series);
+        fclose(f);
+    }
+    if (series.empty()) {
+        fprintf(stderr, "%s: no typed NBLog events found\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (auto &s : series) {
+        std::vector<Event> &events = s.second;
+        // merged dumps are time ordered per dump, but several dumps may overlap
+        std::stable_sort(events.begin(), events.end(),
+                [](const Event &a, const Event &b) { return a.tUs < b.tUs; });
+        if (s.first.second == "underrun") {
+            reportUnderruns(s.first.first, events);
+        } else {
+            reportDurations(s.first.first, s.first.second, events);
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -29,6 +29,8 @@
 #include <signal.h>
 #include <time.h>
 
+#include <deque>
+
 #include <cutils/properties.h>
 
 #include <androidfw/AssetManager.h>
@@ -187,19 +189,28 @@ status_t BootAnimation::initTexture(Texture* texture, AssetManager& assets,
     return NO_ERROR;
 }
 
-status_t BootAnimation::initTexture(FileMap* map, int* width, int* height)
+static void decodeImage(FileMap* map, SkBitmap* bitmap)
 {
-    SkBitmap bitmap;
     sk_sp<SkData> data = SkData::MakeWithoutCopy(map->getDataPtr(),
             map->getDataLength());
     sk_sp<SkImage> image = SkImage::MakeFromEncoded(data);
-    image->asLegacyBitmap(&bitmap, SkImage::kRO_LegacyBitmapMode);
+    image->asLegacyBitmap(bitmap, SkImage::kRO_LegacyBitmapMode);
 
     // FileMap memory is never released until application exit.
-    // Release it now as the texture is already loaded and the memory used for
+    // Release it now as the image is already decoded and the memory used for
     // the packed resource can be released.
     delete map;
+}
+
+status_t BootAnimation::initTexture(FileMap* map, int* width, int* height)
+{
+    SkBitmap bitmap;
+    decodeImage(map, &bitmap);
+    return initTexture(bitmap, width, height);
+}
 
+status_t BootAnimation::initTexture(const SkBitmap& bitmap, int* width, int* height)
+{
     const int w = bitmap.width();
     const int h = bitmap.height();
     const void* p = bitmap.getPixels();
@@ -352,6 +363,13 @@ bool BootAnimation::android()
 {
     ALOGD("%sAnimationShownTiming start time: %" PRId64 "ms", mShuttingDown ? "Shutdown" : "Boot",
             elapsedRealtime());
+
+    sp<FrameDecoder> decoder = new FrameDecoder(animation);
+    if (decoder->run("BootAnimation::FrameDecoder", PRIORITY_DISPLAY) != NO_ERROR) {
+        ALOGW("Could not start frame decoder, decoding frames as they are played");
+        decoder = nullptr;
+    }
+
     initTexture(&mAndroid[0], mAssets, "images/android-logo-mask.png");
     initTexture(&mAndroid[1], mAssets, "images/android-logo-shine.png");
 
@@ -859,6 +877,125 @@ bool BootAnimation::movie()
     return false;
 }
 
+// ---------------------------------------------------------------------------
+
+// Decodes the frames of an animation on its own thread, in the order they are first played, so
+// that playback only has to upload them. Looping parts keep their textures after the first
+// play, so every frame is decoded once. Decoding stays a few frames ahead, within a memory
+// budget.
+class BootAnimation::FrameDecoder : public Thread {
+public:
+    explicit FrameDecoder(const Animation& animation);
+
+    // Gets the decoded image of frame, waiting for it if needed. Frames must be requested in
+    // play order; decoded frames that playback skipped are dropped. Returns false if frame
+    // isn't decoded by this thread.
+    bool getFrame(const Animation::Frame& frame, SkBitmap* outBitmap);
+
+    // Stops decoding and waits for the thread to exit.
+    void stop();
+
+private:
+    static constexpr size_t MAX_DECODED_FRAMES = 4;
+    static constexpr size_t MAX_DECODED_BYTES = 64 * 1024 * 1024;
+
+    struct DecodedFrame {
+        const Animation::Frame* frame;
+        SkBitmap bitmap;
+    };
+
+    virtual bool threadLoop();
+    bool isFullLocked() const;
+
+    Vector<const Animation::Frame*> mFrames;
+    Mutex mLock;
+    Condition mDecodedCondition;
+    Condition mConsumedCondition;
+    std::deque<DecodedFrame> mDecoded;
+    size_t mDecodedBytes = 0;
+    // Index in mFrames of the next frame to decode.
+    size_t mNext = 0;
+    bool mStopped = false;
+};
+
+BootAnimation::FrameDecoder::FrameDecoder(const Animation& animation) : Thread(false) {
+    for (const Animation::Part& part : animation.parts) {
+        // Nested animations are played, and decoded, separately.
+        if (part.animation != NULL) {
+            continue;
+        }
+        for (size_t j = 0; j < part.frames.size(); j++) {
+            mFrames.add(&part.frames[j]);
+        }
+    }
+}
+
+bool BootAnimation::FrameDecoder::isFullLocked() const {
+    // Always allow one frame, however large.
+    return !mDecoded.empty() && (mDecoded.size() >= MAX_DECODED_FRAMES
+            || mDecodedBytes >= MAX_DECODED_BYTES);
+}
+
+bool BootAnimation::FrameDecoder::threadLoop() {
+    const Animation::Frame* frame;
+    {
+        Mutex::Autolock _l(mLock);
+        while (!mStopped && isFullLocked()) {
+            mConsumedCondition.wait(mLock);
+        }
+        if (mStopped || mNext == mFrames.size()) {
+            return false;
+        }
+        frame = mFrames[mNext];
+    }
+
+    DecodedFrame decoded;
+    decoded.frame = frame;
+    decodeImage(frame->map, &decoded.bitmap);
+
+    Mutex::Autolock _l(mLock);
+    mDecodedBytes += decoded.bitmap.rowBytes() * decoded.bitmap.height();
+    mDecoded.push_back(decoded);
+    mNext++;
+    mDecodedCondition.broadcast();
+    return true;
+}
+
+bool BootAnimation::FrameDecoder::getFrame(const Animation::Frame& frame, SkBitmap* outBitmap) {
+    Mutex::Autolock _l(mLock);
+    while (true) {
+        while (mDecoded.empty() && !mStopped && mNext < mFrames.size()) {
+            mDecodedCondition.wait(mLock);
+        }
+        if (mDecoded.empty()) {
+            return false;
+        }
+
+        DecodedFrame& front = mDecoded.front();
+        const bool found = front.frame == &frame;
+        if (found) {
+            *outBitmap = front.bitmap;
+        }
+        mDecodedBytes -= front.bitmap.rowBytes() * front.bitmap.height();
+        mDecoded.pop_front();
+        mConsumedCondition.signal();
+        if (found) {
+            return true;
+        }
+    }
+}
+
+void BootAnimation::FrameDecoder::stop() {
+    {
+        Mutex::Autolock _l(mLock);
+        mStopped = true;
+        mConsumedCondition.signal();
+    }
+    requestExitAndWait();
+}
+
+// ---------------------------------------------------------------------------
+
 bool BootAnimation::playAnimation(const Animation& animation)
 {
     const size_t pcount = animation.parts.size();
@@ -868,6 +1005,13 @@ bool BootAnimation::playAnimation(const Animation& animation)
 
     ALOGD("%sAnimationShownTiming start time: %" PRId64 "ms", mShuttingDown ? "Shutdown" : "Boot",
             elapsedRealtime());
+
+    sp<FrameDecoder> decoder = new FrameDecoder(animation);
+    if (decoder->run("BootAnimation::FrameDecoder", PRIORITY_DISPLAY) != NO_ERROR) {
+        ALOGW("Could not start frame decoder, decoding frames as they are played");
+        decoder = nullptr;
+    }
+
     for (size_t i=0 ; i<pcount ; i++) {
         const Animation::Part& part(animation.parts[i]);
         const size_t fcount = part.frames.size();
@@ -908,7 +1052,12 @@ bool BootAnimation::playAnimation(const Animation& animation)
                         glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
                     }
                     int w, h;
-                    initTexture(frame.map, &w, &h);
+                    SkBitmap bitmap;
+                    if (decoder != nullptr && decoder->getFrame(frame, &bitmap)) {
+                        initTexture(bitmap, &w, &h);
+                    } else {
+                        initTexture(frame.map, &w, &h);
+                    }
                 }
 
                 const int xc = animationX + frame.trimX;
@@ -963,6 +1112,10 @@ bool BootAnimation::playAnimation(const Animation& animation)
 
     }
 
+    if (decoder != nullptr) {
+        decoder->stop();
+    }
+
     // Free textures created for looping parts now that the animation is done.
     for (const Animation::Part& part : animation.parts) {
         if (part.count != 1) {
@@ -141,8 +141,12 @@ private:
         BootAnimation* mBootAnimation;
     };
 
+    // Decodes the frames of an animation ahead of playback; defined in BootAnimation.cpp.
+    class FrameDecoder;
+
     status_t initTexture(Texture* texture, AssetManager& asset, const char* name);
     status_t initTexture(FileMap* map, int* width, int* height);
+    status_t initTexture(const SkBitmap& bitmap, int* width, int* height);
     status_t initFont(Font* font, const char* fallback);
     bool android();
     bool movie();
@@ -1,6 +1,10 @@
 #include "idmap.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <vector>
 #include <androidfw/AssetManager.h>
 #include <androidfw/ResourceTypes.h>
 #include <androidfw/ZipFileRO.h>
@@ -72,7 +76,10 @@ fail:
         return 0;
     }
 
-    bool is_idmap_stale_fd(const char *target_apk_path, const char *overlay_apk_path, int idmap_fd)
+    // target_crc is the CRC of the target's resources.arsc, or NULL to read it from
+    // target_apk_path.
+    bool is_idmap_stale_fd(const char *target_apk_path, const char *overlay_apk_path, int idmap_fd,
+            const uint32_t *target_crc = NULL)
     {
         static const size_t N = ResTable::IDMAP_HEADER_SIZE_BYTES;
         struct stat st;
@@ -119,7 +126,9 @@ fail:
         }
 
         uint32_t actual_target_crc, actual_overlay_crc;
-        if (get_zip_entry_crc(target_apk_path, AssetManager::RESOURCES_FILENAME,
+        if (target_crc != NULL) {
+            actual_target_crc = *target_crc;
+        } else if (get_zip_entry_crc(target_apk_path, AssetManager::RESOURCES_FILENAME,
 				&actual_target_crc) == -1) {
             return true;
         }
@@ -132,7 +141,7 @@ fail:
     }
 
     bool is_idmap_stale_path(const char *target_apk_path, const char *overlay_apk_path,
-            const char *idmap_path)
+            const char *idmap_path, const uint32_t *target_crc = NULL)
     {
         struct stat st;
         if (stat(idmap_path, &st) == -1) {
@@ -144,7 +153,8 @@ fail:
         if (idmap_fd == -1) {
             return false;
         }
-        bool is_stale = is_idmap_stale_fd(target_apk_path, overlay_apk_path, idmap_fd);
+        bool is_stale = is_idmap_stale_fd(target_apk_path, overlay_apk_path, idmap_fd,
+                target_crc);
         close(idmap_fd);
         return is_stale;
     }
@@ -193,6 +203,94 @@ fail:
         free(data);
         return 0;
     }
+
+    // The resource table of an APK. A stored resources.arsc is mapped in place rather than
+    // copied; a compressed one is inflated into a private buffer.
+    class ApkResTable {
+    public:
+        ApkResTable() : crc(0) {}
+
+        bool load(const char *apk_path)
+        {
+            std::unique_ptr<ZipFileRO> zip(ZipFileRO::open(apk_path));
+            if (zip.get() == NULL) {
+                ALOGW("%s: failed to open zip %s\n", __FUNCTION__, apk_path);
+                return false;
+            }
+            ZipEntryRO entry = zip->findEntryByName(AssetManager::RESOURCES_FILENAME);
+            if (entry == NULL) {
+                ALOGW("failed to find resources.arsc in %s\n", apk_path);
+                return false;
+            }
+            uint16_t method;
+            uint32_t uncomp_len;
+            bool ok = zip->getEntryInfo(entry, &method, &uncomp_len, NULL, NULL, NULL, &crc);
+            const void *data = NULL;
+            if (ok && method == ZipFileRO::kCompressStored) {
+                map.reset(zip->createEntryFileMap(entry));
+                if (map.get() != NULL) {
+                    data = map->getDataPtr();
+                }
+            } else if (ok) {
+                buf.reset(new char[uncomp_len]);
+                if (zip->uncompressEntry(entry, buf.get(), uncomp_len)) {
+                    data = buf.get();
+                }
+            }
+            zip->releaseEntry(entry);
+            if (data == NULL) {
+                ALOGW("failed to read resources.arsc in %s\n", apk_path);
+                return false;
+            }
+            if (table.add(data, uncomp_len) != NO_ERROR) {
+                ALOGW("failed to add %s to resource table", apk_path);
+                return false;
+            }
+            return true;
+        }
+
+        // CRC of resources.arsc, as recorded in idmap headers.
+        uint32_t crc;
+
+        // Declared before table, which points into them and so must be destroyed first.
+        std::unique_ptr<FileMap> map;
+        std::unique_ptr<char[]> buf;
+
+        ResTable table;
+
+    private:
+        ApkResTable(const ApkResTable&);
+        ApkResTable& operator=(const ApkResTable&);
+    };
+
+    int create_idmap_path_with_target(const ApkResTable& target, const char *target_apk_path,
+            const char *overlay_apk_path, const char *idmap_path)
+    {
+        ApkResTable overlay;
+        if (!overlay.load(overlay_apk_path)) {
+            return -1;
+        }
+
+        uint32_t *data = NULL;
+        size_t size;
+        if (target.table.createIdmap(overlay.table, target.crc, overlay.crc, target_apk_path,
+                    overlay_apk_path, (void**)&data, &size) != NO_ERROR) {
+            return -1;
+        }
+
+        int fd = open_idmap(idmap_path);
+        if (fd == -1) {
+            free(data);
+            return -1;
+        }
+        int r = write_idmap(fd, data, size);
+        close(fd);
+        free(data);
+        if (r != 0) {
+            unlink(idmap_path);
+        }
+        return r;
+    }
 }
 
 int idmap_create_path(const char *target_apk_path, const char *overlay_apk_path,
@@ -227,3 +325,75 @@ int idmap_verify_fd(const char *target_apk_path, const char *overlay_apk_path, i
     return !is_idmap_stale_fd(target_apk_path, overlay_apk_path, fd) ?
             EXIT_SUCCESS : EXIT_FAILURE;
 }
+
+int idmap_create_paths(const char *target_apk_path,
+        const android::Vector<android::String8>& overlay_apk_paths,
+        const android::Vector<android::String8>& idmap_paths, android::Vector<bool> *results)
+{
+    const size_t N = overlay_apk_paths.size();
+    results->clear();
+    results->insertAt(false, 0, N);
+
+    // Written by the workers, one element each, so not a bit-packed vector<bool>.
+    std::vector<uint8_t> created(N, 0);
+
+    uint32_t target_crc;
+    if (get_zip_entry_crc(target_apk_path, AssetManager::RESOURCES_FILENAME,
+                &target_crc) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    // The CRCs in the idmap headers tell which overlays changed since their idmap was written.
+    std::vector<size_t> stale;
+    for (size_t i = 0; i < N; ++i) {
+        if (is_idmap_stale_path(target_apk_path, overlay_apk_paths[i].string(),
+                    idmap_paths[i].string(), &target_crc)) {
+            stale.push_back(i);
+        } else {
+            created[i] = 1;
+            results->editItemAt(i) = true;
+        }
+    }
+    if (stale.empty()) {
+        return EXIT_SUCCESS;
+    }
+
+    // The target table is parsed once and only read from then on, so the workers share it.
+    ApkResTable target;
+    if (!target.load(target_apk_path)) {
+        return EXIT_FAILURE;
+    }
+    if (target.crc != target_crc) {
+        ALOGW("%s changed while creating idmaps\n", target_apk_path);
+        return EXIT_FAILURE;
+    }
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t j = next++; j < stale.size(); j = next++) {
+            const size_t i = stale[j];
+            created[i] = create_idmap_path_with_target(target, target_apk_path,
+                    overlay_apk_paths[i].string(), idmap_paths[i].string()) == 0;
+        }
+    };
+
+    const size_t thread_count =
+            std::min<size_t>(stale.size(), std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < thread_count; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    int ret = EXIT_SUCCESS;
+    for (size_t i = 0; i < N; ++i) {
+        results->editItemAt(i) = created[i] != 0;
+        if (!created[i]) {
+            ret = EXIT_FAILURE;
+        }
+    }
+    return ret;
+}
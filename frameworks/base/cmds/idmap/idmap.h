@@ -5,6 +5,7 @@
 #define LOG_TAG "idmap"
 
 #include <utils/Log.h>
+#include <utils/String8.h>
 #include <utils/Vector.h>
 
 #include <errno.h>
@@ -27,6 +28,13 @@ int idmap_create_fd(const char *target_apk_path, const char *overlay_apk_path, i
 
 int idmap_verify_fd(const char *target_apk_path, const char *overlay_apk_path, int fd);
 
+// Creates idmap_paths[i] for overlay_apk_paths[i] against the same target. Up-to-date idmaps are
+// left alone; the others are generated concurrently, sharing one parsed copy of the target's
+// resource table. On return, (*results)[i] tells whether idmap_paths[i] is valid.
+int idmap_create_paths(const char *target_apk_path,
+        const android::Vector<android::String8>& overlay_apk_paths,
+        const android::Vector<android::String8>& idmap_paths, android::Vector<bool> *results);
+
 // Regarding target_package_name: the idmap_scan implementation should
 // be able to extract this from the manifest in target_apk_path,
 // simplifying the external API.
@@ -236,7 +236,11 @@ int idmap_scan(const char *target_package_name, const char *target_apk_path,
     String8 filename = String8(idmap_dir);
     filename.appendPath("overlays.list");
 
-    SortedVector<Overlay> overlayVector;
+    // Collect the overlays first, so that their idmaps can be created in one batch against a
+    // single parsed copy of the target.
+    Vector<Overlay> overlays;
+    Vector<String8> overlay_apk_paths;
+    Vector<String8> idmap_paths;
     const size_t N = overlay_dirs->size();
     for (size_t i = 0; i < N; ++i) {
         const char *overlay_dir = overlay_dirs->itemAt(i);
@@ -266,19 +270,28 @@ int idmap_scan(const char *target_package_name, const char *target_apk_path,
             idmap_path.appendPath(flatten_path(overlay_apk_path + 1));
             idmap_path.append("@idmap");
 
-            if (idmap_create_path(target_apk_path, overlay_apk_path, idmap_path.string()) != 0) {
-                ALOGE("error: failed to create idmap for target=%s overlay=%s idmap=%s\n",
-                        target_apk_path, overlay_apk_path, idmap_path.string());
-                continue;
-            }
-
-            Overlay overlay(String8(overlay_apk_path), idmap_path, priority);
-            overlayVector.add(overlay);
+            overlays.add(Overlay(String8(overlay_apk_path), idmap_path, priority));
+            overlay_apk_paths.add(String8(overlay_apk_path));
+            idmap_paths.add(idmap_path);
         }
 
         closedir(dir);
     }
 
+    Vector<bool> created;
+    idmap_create_paths(target_apk_path, overlay_apk_paths, idmap_paths, &created);
+
+    SortedVector<Overlay> overlayVector;
+    for (size_t i = 0; i < overlays.size(); ++i) {
+        const Overlay& overlay = overlays[i];
+        if (!created[i]) {
+            ALOGE("error: failed to create idmap for target=%s overlay=%s idmap=%s\n",
+                    target_apk_path, overlay.apk_path.string(), overlay.idmap_path.string());
+            continue;
+        }
+        overlayVector.add(overlay);
+    }
+
     if (!writePackagesList(filename.string(), overlayVector)) {
         return EXIT_FAILURE;
     }
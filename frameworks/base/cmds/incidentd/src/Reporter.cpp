@@ -32,11 +32,20 @@
 #include <fcntl.h>
 #include <errno.h>
 
+#include <algorithm>
+#include <thread>
+
 /**
  * The directory where the incident reports are stored.
  */
 static const String8 INCIDENT_DIRECTORY("/data/incidents");
 
+/**
+ * How many sections are collected at the same time. Each one can buffer up to
+ * 4 MB (see FdBuffer), so this also bounds the memory used by a report.
+ */
+static const int MAX_CONCURRENT_SECTIONS = 3;
+
 static status_t
 write_all(int fd, uint8_t const* buf, size_t size)
 {
@@ -208,38 +217,8 @@ Reporter::runReport()
         }
     }
 
-    // For each of the report fields, see if we need it, and if so, execute the command
-    // and report to those that care that we're doing it.
-    for (const Section** section=SECTION_LIST; *section; section++) {
-        const int id = (*section)->id;
-        ALOGD("Taking incident report section %d '%s'", id, (*section)->name.string());
-
-        if (this->args.containsSection(id)) {
-            // Notify listener of starting
-            for (ReportRequestSet::iterator it=batch.begin(); it!=batch.end(); it++) {
-                if ((*it)->listener != NULL && (*it)->args.containsSection(id)) {
-                    (*it)->listener->onReportSectionStatus(id,
-                            IIncidentReportStatusListener::STATUS_STARTING);
-                }
-            }
-
-            // Execute - go get the data and write it into the file descriptors.
-            err = (*section)->Execute(&batch);
-            if (err != NO_ERROR) {
-                ALOGW("Incident section %s (%d) failed. Stopping report.",
-                        (*section)->name.string(), id);
-                goto done;
-            }
-
-            // Notify listener of starting
-            for (ReportRequestSet::iterator it=batch.begin(); it!=batch.end(); it++) {
-                if ((*it)->listener != NULL && (*it)->args.containsSection(id)) {
-                    (*it)->listener->onReportSectionStatus(id,
-                            IIncidentReportStatusListener::STATUS_FINISHED);
-                }
-            }
-        }
-    }
+    // Go get the data for each of the report fields and write it into the file descriptors.
+    err = run_sections();
 
 done:
     // Close the file.
@@ -303,6 +282,85 @@ Reporter::create_file(int* fd)
     return NO_ERROR;
 }
 
+/**
+ * Execute the sections that were asked for, a few at a time, and report to those
+ * that care that we're doing it. The sections may end up in the report in any
+ * order, which protobuf doesn't mind. If a section fails, the ones that haven't
+ * started yet are skipped and its error is returned.
+ */
+status_t
+Reporter::run_sections()
+{
+    vector<const Section*> sections;
+    for (const Section** section=SECTION_LIST; *section; section++) {
+        if (this->args.containsSection((*section)->id)) {
+            sections.push_back(*section);
+        }
+    }
+
+    mutex lock;
+    size_t next = 0;
+    status_t err = NO_ERROR;
+
+    auto worker = [&]() {
+        while (true) {
+            const Section* section;
+            {
+                unique_lock<mutex> l(lock);
+                if (next >= sections.size() || err != NO_ERROR) {
+                    return;
+                }
+                section = sections[next++];
+            }
+            const int id = section->id;
+            ALOGD("Taking incident report section %d '%s'", id, section->name.string());
+
+            // Notify listener of starting
+            for (ReportRequestSet::iterator it=batch.begin(); it!=batch.end(); it++) {
+                if ((*it)->listener != NULL && (*it)->args.containsSection(id)) {
+                    (*it)->listener->onReportSectionStatus(id,
+                            IIncidentReportStatusListener::STATUS_STARTING);
+                }
+            }
+
+            // Execute - go get the data and write it into the file descriptors.
+            int64_t startTime = uptimeMillis();
+            status_t sectionErr = section->Execute(&batch);
+            if (sectionErr != NO_ERROR) {
+                ALOGW("Incident section %s (%d) failed. Stopping report.",
+                        section->name.string(), id);
+                unique_lock<mutex> l(lock);
+                if (err == NO_ERROR) {
+                    err = sectionErr;
+                }
+                return;
+            }
+            ALOGD("Incident section %d took %d ms", id, (int)(uptimeMillis() - startTime));
+
+            // Notify listener of finishing
+            for (ReportRequestSet::iterator it=batch.begin(); it!=batch.end(); it++) {
+                if ((*it)->listener != NULL && (*it)->args.containsSection(id)) {
+                    (*it)->listener->onReportSectionStatus(id,
+                            IIncidentReportStatusListener::STATUS_FINISHED);
+                }
+            }
+        }
+    };
+
+    // This thread takes sections too, so start one less.
+    vector<thread> threads;
+    const size_t threadCount = min(sections.size(), (size_t)MAX_CONCURRENT_SECTIONS);
+    for (size_t i=1; i<threadCount; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (size_t i=0; i<threads.size(); i++) {
+        threads[i].join();
+    }
+
+    return err;
+}
+
 // ================================================================================
 Reporter::run_report_status_t
 Reporter::upload_backlog()
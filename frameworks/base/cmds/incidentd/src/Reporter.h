@@ -20,6 +20,7 @@
 #include <android/os/IIncidentReportStatusListener.h>
 #include <android/os/IncidentReportArgs.h>
 
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -57,6 +58,10 @@ public:
     // to it returns an error.
     status_t write(uint8_t const* buf, size_t size);
 
+    // Sections run concurrently, so each one holds this lock while it writes
+    // its header and data, keeping them together in the output.
+    mutex& sectionLock() { return mSectionLock; }
+
     typedef vector<sp<ReportRequest>>::iterator iterator;
 
     iterator begin() { return mRequests.begin(); }
@@ -66,6 +71,7 @@ private:
     vector<sp<ReportRequest>> mRequests;
     int mWritableCount;
     int mMainFd;
+    mutex mSectionLock;
 };
 
 // ================================================================================
@@ -95,6 +101,7 @@ private:
     time_t mStartTime;
 
     status_t create_file(int* fd);
+    status_t run_sections();
 };
 
 
@@ -193,6 +193,7 @@ WorkerThreadSection::Execute(ReportRequestSet* requests) const
     // Write the data that was collected
     ALOGD("section '%s' wrote %zd bytes in %d ms", name.string(), buffer.size(),
             (int)buffer.durationMs());
+    unique_lock<mutex> lock(requests->sectionLock());
     WriteHeader(requests, buffer.size());
     err = buffer.write(requests);
     if (err != NO_ERROR) {
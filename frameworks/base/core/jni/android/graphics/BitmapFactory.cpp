@@ -19,10 +19,12 @@
 #include <androidfw/ResourceTypes.h>
 #include <cutils/compiler.h>
 #include <memory>
+#include <mutex>
 #include <netinet/in.h>
 #include <stdio.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <vector>
 
 jfieldID gOptions_justBoundsFieldID;
 jfieldID gOptions_sampleSizeFieldID;
@@ -193,6 +195,98 @@ private:
     const unsigned int mSize;
 };
 
+// Pixel memory for decoded images that only live until they are scaled or uploaded to a
+// hardware bitmap. Buffers are bucketed by power-of-two size and kept for the next decode,
+// which saves allocating, faulting in and freeing several megabytes per image.
+class StagingPixelPool {
+public:
+    // Returns a buffer of at least size bytes. context identifies the buffer for release().
+    static void* acquire(size_t size, void** context) {
+        const int bucket = bucketForSize(size);
+        if (bucket < 0) {
+            *context = reinterpret_cast<void*>(intptr_t(-1));
+            return malloc(size);
+        }
+
+        *context = reinterpret_cast<void*>(intptr_t(bucket));
+        {
+            std::lock_guard<std::mutex> lock(sLock);
+            std::vector<void*>& buffers = sBuckets[bucket];
+            if (!buffers.empty()) {
+                void* addr = buffers.back();
+                buffers.pop_back();
+                sIdleBytes -= bucketSize(bucket);
+                return addr;
+            }
+        }
+        return malloc(bucketSize(bucket));
+    }
+
+    // A FreeFunc for the android::Bitmap wrapping a buffer from acquire().
+    static void release(void* addr, void* context) {
+        const int bucket = static_cast<int>(reinterpret_cast<intptr_t>(context));
+        if (bucket >= 0) {
+            std::lock_guard<std::mutex> lock(sLock);
+            if (sIdleBytes + bucketSize(bucket) <= kMaxIdleBytes) {
+                sBuckets[bucket].push_back(addr);
+                sIdleBytes += bucketSize(bucket);
+                return;
+            }
+        }
+        free(addr);
+    }
+
+private:
+    // Smaller decodes are cheap enough to allocate, larger ones too rare to keep around.
+    static const int kMinBucketShift = 16;
+    static const int kMaxBucketShift = 26;
+    static const size_t kMaxIdleBytes = 32 * 1024 * 1024;
+
+    static size_t bucketSize(int bucket) {
+        return size_t(1) << (bucket + kMinBucketShift);
+    }
+
+    static int bucketForSize(size_t size) {
+        for (int shift = kMinBucketShift; shift <= kMaxBucketShift; shift++) {
+            if (size <= (size_t(1) << shift)) {
+                return shift - kMinBucketShift;
+            }
+        }
+        return -1;
+    }
+
+    static std::mutex sLock;
+    static std::vector<void*> sBuckets[kMaxBucketShift - kMinBucketShift + 1];
+    static size_t sIdleBytes;
+};
+
+std::mutex StagingPixelPool::sLock;
+std::vector<void*> StagingPixelPool::sBuckets[kMaxBucketShift - kMinBucketShift + 1];
+size_t StagingPixelPool::sIdleBytes = 0;
+
+// Allocates pixels from the StagingPixelPool. The memory is not zero-initialized.
+class StagingPixelAllocator : public SkBitmap::Allocator {
+public:
+    virtual bool allocPixelRef(SkBitmap* bitmap) {
+        const SkImageInfo& info = bitmap->info();
+        const int64_t size64 = info.getSafeSize64(bitmap->rowBytes());
+        if (!sk_64_isS32(size64)) {
+            ALOGW("bitmap is too large");
+            return false;
+        }
+
+        void* context;
+        void* addr = StagingPixelPool::acquire(sk_64_asS32(size64), &context);
+        if (!addr) {
+            return false;
+        }
+        sk_sp<android::Bitmap> pixels(new android::Bitmap(addr, context,
+                StagingPixelPool::release, info, bitmap->rowBytes()));
+        bitmap->setPixelRef(std::move(pixels), 0, 0);
+        return true;
+    }
+};
+
 // Necessary for decodes when the native decoder cannot scale to appropriately match the sampleSize
 // (for example, RAW). If the sampleSize divides evenly into the dimension, we require that the
 // scale matches exactly. If sampleSize does not divide evenly, we allow the decoder to choose how
@@ -361,7 +455,7 @@ static jobject doDecode(JNIEnv* env, SkStreamRewindable* stream, jobject padding
     HeapAllocator defaultAllocator;
     RecyclingPixelAllocator recyclingAllocator(reuseBitmap, existingBufferSize);
     ScaleCheckingAllocator scaleCheckingAllocator(scale, existingBufferSize);
-    SkBitmap::HeapAllocator heapAllocator;
+    StagingPixelAllocator stagingAllocator;
     SkBitmap::Allocator* decodeAllocator;
     if (javaBitmap != nullptr && willScale) {
         // This will allocate pixels using a HeapAllocator, since there will be an extra
@@ -371,10 +465,10 @@ static jobject doDecode(JNIEnv* env, SkStreamRewindable* stream, jobject padding
     } else if (javaBitmap != nullptr) {
         decodeAllocator = &recyclingAllocator;
     } else if (willScale || isHardware) {
-        // This will allocate pixels using a HeapAllocator,
+        // The decoded pixels are temporary, so they come from the staging pool:
         // for scale case: there will be an extra scaling step.
         // for hardware case: there will be extra swizzling & upload to gralloc step.
-        decodeAllocator = &heapAllocator;
+        decodeAllocator = &stagingAllocator;
     } else {
         decodeAllocator = &defaultAllocator;
     }
@@ -476,6 +570,9 @@ static jobject doDecode(JNIEnv* env, SkStreamRewindable* stream, jobject padding
         SkBitmap::Allocator* outputAllocator;
         if (javaBitmap != nullptr) {
             outputAllocator = &recyclingAllocator;
+        } else if (isHardware) {
+            // The scaled pixels are only kept until they are uploaded.
+            outputAllocator = &stagingAllocator;
         } else {
             outputAllocator = &defaultAllocator;
         }
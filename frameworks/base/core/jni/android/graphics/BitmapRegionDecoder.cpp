@@ -39,20 +39,122 @@
 #include <jni.h>
 #include <sys/stat.h>
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 using namespace android;
 
+/*
+ * The native side of a BitmapRegionDecoder. Each decodeRegion call borrows an
+ * SkBitmapRegionDecoder for its duration, so calls made from several threads decode
+ * independent tiles in parallel instead of queuing on a single decoder. All the decoders
+ * read the same encoded bytes through duplicates of the source stream, and idle ones are
+ * kept for the next call.
+ */
+class RegionDecoderPool {
+public:
+    static RegionDecoderPool* create(std::unique_ptr<SkStreamRewindable> stream) {
+        // The original stream is only used to make duplicates. If it can't be duplicated,
+        // the one decoder reads it directly and decodes are serialized.
+        std::unique_ptr<SkStreamRewindable> decoderStream(stream->duplicate());
+        if (!decoderStream) {
+            decoderStream = std::move(stream);
+        }
+        std::unique_ptr<SkBitmapRegionDecoder> brd(
+                SkBitmapRegionDecoder::Create(decoderStream.release(),
+                                              SkBitmapRegionDecoder::kAndroidCodec_Strategy));
+        if (!brd) {
+            return nullptr;
+        }
+        return new RegionDecoderPool(std::move(stream), std::move(brd));
+    }
+
+    int width() const { return mWidth; }
+    int height() const { return mHeight; }
+
+    // Returns an idle decoder, creates one, or waits for one to be released.
+    std::unique_ptr<SkBitmapRegionDecoder> acquire() {
+        std::unique_lock<std::mutex> lock(mLock);
+        while (mIdle.empty()) {
+            if (!mCanGrow) {
+                mReleased.wait(lock);
+                continue;
+            }
+
+            // Parsing the image header is the slow part, so don't hold the lock for it.
+            // Duplicating a stream that is not otherwise read is safe from any thread.
+            lock.unlock();
+            std::unique_ptr<SkBitmapRegionDecoder> brd;
+            std::unique_ptr<SkStreamRewindable> stream(mStream->duplicate());
+            if (stream) {
+                brd.reset(SkBitmapRegionDecoder::Create(stream.release(),
+                        SkBitmapRegionDecoder::kAndroidCodec_Strategy));
+            }
+            if (brd) {
+                return brd;
+            }
+            lock.lock();
+            ALOGW("Failed to create another region decoder, decodes will be serialized.");
+            mCanGrow = false;
+        }
+        std::unique_ptr<SkBitmapRegionDecoder> brd = std::move(mIdle.back());
+        mIdle.pop_back();
+        return brd;
+    }
+
+    void release(std::unique_ptr<SkBitmapRegionDecoder> brd) {
+        std::lock_guard<std::mutex> lock(mLock);
+        // Extra decoders are dropped, there is always at least one idle left to wait for.
+        if (mIdle.size() < kMaxIdleDecoders) {
+            mIdle.push_back(std::move(brd));
+            mReleased.notify_one();
+        }
+    }
+
+private:
+    static const size_t kMaxIdleDecoders = 4;
+
+    RegionDecoderPool(std::unique_ptr<SkStreamRewindable> stream,
+            std::unique_ptr<SkBitmapRegionDecoder> brd)
+            : mStream(std::move(stream)), mCanGrow(mStream != nullptr),
+              mWidth(brd->width()), mHeight(brd->height()) {
+        mIdle.push_back(std::move(brd));
+    }
+
+    std::mutex mLock;
+    std::condition_variable mReleased;
+    // Kept until the pool is deleted, since other threads may be duplicating it.
+    const std::unique_ptr<SkStreamRewindable> mStream;
+    bool mCanGrow;
+    std::vector<std::unique_ptr<SkBitmapRegionDecoder>> mIdle;
+    const int mWidth;
+    const int mHeight;
+};
+
+// Borrows a decoder from a RegionDecoderPool for the current scope.
+class AutoRegionDecoder {
+public:
+    explicit AutoRegionDecoder(RegionDecoderPool* pool)
+            : mPool(pool), mDecoder(pool->acquire()) {}
+    ~AutoRegionDecoder() { mPool->release(std::move(mDecoder)); }
+
+    SkBitmapRegionDecoder* operator->() const { return mDecoder.get(); }
+
+private:
+    RegionDecoderPool* mPool;
+    std::unique_ptr<SkBitmapRegionDecoder> mDecoder;
+};
+
 static jobject createBitmapRegionDecoder(JNIEnv* env, std::unique_ptr<SkStreamRewindable> stream) {
-  std::unique_ptr<SkBitmapRegionDecoder> brd(
-            SkBitmapRegionDecoder::Create(stream.release(),
-                                          SkBitmapRegionDecoder::kAndroidCodec_Strategy));
-    if (!brd) {
+    RegionDecoderPool* pool = RegionDecoderPool::create(std::move(stream));
+    if (!pool) {
         doThrowIOE(env, "Image format not supported");
         return nullObjectReturn("CreateBitmapRegionDecoder returned null");
     }
 
-    return GraphicsJNI::createBitmapRegionDecoder(env, brd.release());
+    return GraphicsJNI::createBitmapRegionDecoder(env, pool);
 }
 
 static jobject nativeNewInstanceFromByteArray(JNIEnv* env, jobject, jbyteArray byteArray,
@@ -155,7 +257,8 @@ static jobject nativeDecodeRegion(JNIEnv* env, jobject, jlong brdHandle, jint in
         env->SetObjectField(options, gOptions_outColorSpaceFieldID, 0);
     }
 
-    SkBitmapRegionDecoder* brd = reinterpret_cast<SkBitmapRegionDecoder*>(brdHandle);
+    // Concurrent calls on the same handle each get their own decoder.
+    AutoRegionDecoder brd(reinterpret_cast<RegionDecoderPool*>(brdHandle));
 
     SkColorType decodeColorType = brd->computeOutputColorType(colorType);
     sk_sp<SkColorSpace> decodeColorSpace = brd->computeOutputColorSpace(
@@ -234,20 +337,17 @@ static jobject nativeDecodeRegion(JNIEnv* env, jobject, jlong brdHandle, jint in
 }
 
 static jint nativeGetHeight(JNIEnv* env, jobject, jlong brdHandle) {
-    SkBitmapRegionDecoder* brd =
-            reinterpret_cast<SkBitmapRegionDecoder*>(brdHandle);
+    RegionDecoderPool* brd = reinterpret_cast<RegionDecoderPool*>(brdHandle);
     return static_cast<jint>(brd->height());
 }
 
 static jint nativeGetWidth(JNIEnv* env, jobject, jlong brdHandle) {
-    SkBitmapRegionDecoder* brd =
-            reinterpret_cast<SkBitmapRegionDecoder*>(brdHandle);
+    RegionDecoderPool* brd = reinterpret_cast<RegionDecoderPool*>(brdHandle);
     return static_cast<jint>(brd->width());
 }
 
 static void nativeClean(JNIEnv* env, jobject, jlong brdHandle) {
-    SkBitmapRegionDecoder* brd =
-            reinterpret_cast<SkBitmapRegionDecoder*>(brdHandle);
+    RegionDecoderPool* brd = reinterpret_cast<RegionDecoderPool*>(brdHandle);
     delete brd;
 }
 
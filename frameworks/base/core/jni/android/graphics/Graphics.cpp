@@ -410,13 +410,13 @@ SkRegion* GraphicsJNI::getNativeRegion(JNIEnv* env, jobject region)
 
 ///////////////////////////////////////////////////////////////////////////////////////////
 
-jobject GraphicsJNI::createBitmapRegionDecoder(JNIEnv* env, SkBitmapRegionDecoder* bitmap)
+jobject GraphicsJNI::createBitmapRegionDecoder(JNIEnv* env, RegionDecoderPool* decoder)
 {
-    SkASSERT(bitmap != NULL);
+    SkASSERT(decoder != NULL);
 
     jobject obj = env->NewObject(gBitmapRegionDecoder_class,
             gBitmapRegionDecoder_constructorMethodID,
-            reinterpret_cast<jlong>(bitmap));
+            reinterpret_cast<jlong>(decoder));
     hasException(env); // For the side effect of logging.
     return obj;
 }
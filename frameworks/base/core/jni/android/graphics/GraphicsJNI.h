@@ -15,7 +15,7 @@
 #include <hwui/Canvas.h>
 #include <hwui/Bitmap.h>
 
-class SkBitmapRegionDecoder;
+class RegionDecoderPool;
 class SkCanvas;
 
 namespace android {
@@ -88,7 +88,7 @@ public:
 
     static jobject createRegion(JNIEnv* env, SkRegion* region);
 
-    static jobject createBitmapRegionDecoder(JNIEnv* env, SkBitmapRegionDecoder* bitmap);
+    static jobject createBitmapRegionDecoder(JNIEnv* env, RegionDecoderPool* decoder);
 
     static android::Bitmap* mapAshmemBitmap(JNIEnv* env, SkBitmap* bitmap,
             int fd, void* addr, size_t size, bool readOnly);
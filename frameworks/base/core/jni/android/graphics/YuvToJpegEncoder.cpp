@@ -8,6 +8,88 @@
 
 #include <jni.h>
 
+#include <algorithm>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define YUV_TO_JPEG_USE_NEON 1
+#endif
+
+// Rows in a JPEG MCU for both supported formats, whose luma is sampled 2x2.
+static const int kMcuSize = 16;
+
+// Striping adds a restart marker per MCU row and a thread start per stripe, so
+// stripes are only used when each gets at least this many MCU rows.
+static const int kMinStripeMcuRows = 8;
+
+// Collects the JPEG of one stripe.
+class StripeWStream : public SkWStream {
+public:
+    bool write(const void* buffer, size_t size) override {
+        const uint8_t* bytes = static_cast<const uint8_t*>(buffer);
+        fData.insert(fData.end(), bytes, bytes + size);
+        return true;
+    }
+
+    size_t bytesWritten() const override {
+        return fData.size();
+    }
+
+    std::vector<uint8_t> fData;
+};
+
+// Positions of the parts of a baseline JPEG produced by libjpeg.
+struct JpegLayout {
+    size_t sofOffset;       // SOFn marker.
+    size_t entropyOffset;   // First byte after the SOS segment.
+    size_t entropyEnd;      // The EOI marker.
+};
+
+static bool parseJpegLayout(const std::vector<uint8_t>& jpeg, JpegLayout* layout) {
+    const size_t size = jpeg.size();
+    if (size < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8 ||
+            jpeg[size - 2] != 0xFF || jpeg[size - 1] != 0xD9) {
+        return false;
+    }
+
+    layout->sofOffset = 0;
+    size_t pos = 2;
+    while (pos + 4 <= size && jpeg[pos] == 0xFF) {
+        const uint8_t marker = jpeg[pos + 1];
+        const size_t length = (jpeg[pos + 2] << 8) | jpeg[pos + 3];
+        if (marker >= 0xC0 && marker <= 0xC2) {
+            layout->sofOffset = pos;
+        } else if (marker == 0xDA) {
+            layout->entropyOffset = pos + 2 + length;
+            layout->entropyEnd = size - 2;
+            return layout->sofOffset != 0 && layout->entropyOffset <= layout->entropyEnd;
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
+
+// Copies entropy-coded data, adding shift to the number of each RSTn marker.
+// Byte stuffing guarantees that 0xFF followed by 0xD0-0xD7 is always a marker.
+static bool writeRenumberedEntropyData(SkWStream* stream, const uint8_t* data, size_t size,
+        int shift) {
+    size_t start = 0;
+    for (size_t i = 0; i + 1 < size; i++) {
+        if (data[i] == 0xFF && data[i + 1] >= 0xD0 && data[i + 1] <= 0xD7) {
+            const uint8_t marker[2] = { 0xFF, uint8_t(0xD0 + (data[i + 1] - 0xD0 + shift) % 8) };
+            if (!stream->write(data + start, i - start) || !stream->write(marker, 2)) {
+                return false;
+            }
+            start = i + 2;
+            i++;
+        }
+    }
+    return stream->write(data + start, size - start);
+}
+
 YuvToJpegEncoder* YuvToJpegEncoder::create(int format, int* strides) {
     // Only ImageFormat.NV21 and ImageFormat.YUY2 are supported
     // for now.
@@ -25,6 +107,18 @@ YuvToJpegEncoder::YuvToJpegEncoder(int* strides) : fStrides(strides) {
 
 bool YuvToJpegEncoder::encode(SkWStream* stream, void* inYuv, int width,
         int height, int* offsets, int jpegQuality) {
+    const int mcuRows = (height + kMcuSize - 1) / kMcuSize;
+    const int stripeCount = std::min<int>(std::thread::hardware_concurrency(),
+            mcuRows / kMinStripeMcuRows);
+    if (stripeCount > 1) {
+        return encodeStriped(stream, (uint8_t*) inYuv, width, height, offsets, jpegQuality,
+                stripeCount);
+    }
+    return encodeStripe(stream, (uint8_t*) inYuv, width, height, offsets, jpegQuality, 0);
+}
+
+bool YuvToJpegEncoder::encodeStripe(SkWStream* stream, uint8_t* yuv, int width,
+        int height, int* offsets, int jpegQuality, unsigned int restartInterval) {
     jpeg_compress_struct    cinfo;
     skjpeg_error_mgr        sk_err;
     skjpeg_destination_mgr  sk_wstream(stream);
@@ -39,16 +133,78 @@ bool YuvToJpegEncoder::encode(SkWStream* stream, void* inYuv, int width,
     cinfo.dest = &sk_wstream;
 
     setJpegCompressStruct(&cinfo, width, height, jpegQuality);
+    cinfo.restart_interval = restartInterval;
 
     jpeg_start_compress(&cinfo, TRUE);
 
-    compress(&cinfo, (uint8_t*) inYuv, offsets);
+    compress(&cinfo, yuv, offsets);
 
     jpeg_finish_compress(&cinfo);
 
     return true;
 }
 
+bool YuvToJpegEncoder::encodeStriped(SkWStream* stream, uint8_t* yuv, int width,
+        int height, int* offsets, int jpegQuality, int stripeCount) {
+    // Every stripe is a whole number of MCU rows and ends on a restart interval of one
+    // MCU row, so the entropy-coded data of the stripes can be joined with restart
+    // markers in between, exactly as a single encoder would have written them.
+    const int mcuRows = (height + kMcuSize - 1) / kMcuSize;
+    const int stripeMcuRows = (mcuRows + stripeCount - 1) / stripeCount;
+    const unsigned int mcusPerRow = (width + kMcuSize - 1) / kMcuSize;
+    stripeCount = (mcuRows + stripeMcuRows - 1) / stripeMcuRows;
+
+    std::vector<StripeWStream> stripes(stripeCount);
+    std::vector<char> succeeded(stripeCount, 0);
+    auto encodeStripeAt = [&](int index) {
+        const int firstRow = index * stripeMcuRows * kMcuSize;
+        const int rows = std::min(stripeMcuRows * kMcuSize, height - firstRow);
+        int stripeOffsets[2];
+        offsetRows(offsets, firstRow, stripeOffsets);
+        succeeded[index] = encodeStripe(&stripes[index], yuv, width, rows, stripeOffsets,
+                jpegQuality, mcusPerRow);
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < stripeCount; i++) {
+        threads.emplace_back(encodeStripeAt, i);
+    }
+    encodeStripeAt(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<JpegLayout> layouts(stripeCount);
+    for (int i = 0; i < stripeCount; i++) {
+        if (!succeeded[i] || !parseJpegLayout(stripes[i].fData, &layouts[i])) {
+            return false;
+        }
+    }
+
+    // The headers of the first stripe, with the height of the whole image.
+    std::vector<uint8_t>& first = stripes[0].fData;
+    first[layouts[0].sofOffset + 5] = uint8_t(height >> 8);
+    first[layouts[0].sofOffset + 6] = uint8_t(height);
+    if (!stream->write(first.data(), layouts[0].entropyEnd)) {
+        return false;
+    }
+
+    for (int i = 1; i < stripeCount; i++) {
+        const int stripeFirstMcuRow = i * stripeMcuRows;
+        const uint8_t marker[2] = { 0xFF, uint8_t(0xD0 + (stripeFirstMcuRow - 1) % 8) };
+        const std::vector<uint8_t>& data = stripes[i].fData;
+        if (!stream->write(marker, 2) ||
+                !writeRenumberedEntropyData(stream, data.data() + layouts[i].entropyOffset,
+                        layouts[i].entropyEnd - layouts[i].entropyOffset,
+                        stripeFirstMcuRow % 8)) {
+            return false;
+        }
+    }
+
+    static const uint8_t kEndOfImage[2] = { 0xFF, 0xD9 };
+    return stream->write(kEndOfImage, 2);
+}
+
 void YuvToJpegEncoder::setJpegCompressStruct(jpeg_compress_struct* cinfo,
         int width, int height, int quality) {
     cinfo->image_width = width;
@@ -121,7 +277,17 @@ void Yuv420SpToJpegEncoder::deinterleave(uint8_t* vuPlanar, uint8_t* uRows,
     for (int row = 0; row < numRows; ++row) {
         int offset = ((rowIndex >> 1) + row) * fStrides[1];
         uint8_t* vu = vuPlanar + offset;
-        for (int i = 0; i < (width >> 1); ++i) {
+        int i = 0;
+#ifdef YUV_TO_JPEG_USE_NEON
+        for (; i + 16 <= (width >> 1); i += 16) {
+            int index = row * (width >> 1) + i;
+            uint8x16x2_t vuPixels = vld2q_u8(vu);
+            vst1q_u8(uRows + index, vuPixels.val[1]);
+            vst1q_u8(vRows + index, vuPixels.val[0]);
+            vu += 32;
+        }
+#endif
+        for (; i < (width >> 1); ++i) {
             int index = row * (width >> 1) + i;
             uRows[index] = vu[1];
             vRows[index] = vu[0];
@@ -130,6 +296,12 @@ void Yuv420SpToJpegEncoder::deinterleave(uint8_t* vuPlanar, uint8_t* uRows,
     }
 }
 
+void Yuv420SpToJpegEncoder::offsetRows(const int* offsets, int firstRow, int* outOffsets) {
+    outOffsets[0] = offsets[0] + firstRow * fStrides[0];
+    // The VU plane is vertically subsampled.
+    outOffsets[1] = offsets[1] + (firstRow >> 1) * fStrides[1];
+}
+
 void Yuv420SpToJpegEncoder::configSamplingFactors(jpeg_compress_struct* cinfo) {
     // cb and cr are horizontally downsampled and vertically downsampled as well.
     cinfo->comp_info[0].h_samp_factor = 2;
@@ -195,7 +367,23 @@ void Yuv422IToJpegEncoder::deinterleave(uint8_t* yuv, uint8_t* yRows, uint8_t* u
     if (numRows > 16) numRows = 16;
     for (int row = 0; row < numRows; ++row) {
         uint8_t* yuvSeg = yuv + (rowIndex + row) * fStrides[0];
-        for (int i = 0; i < (width >> 1); ++i) {
+        int i = 0;
+#ifdef YUV_TO_JPEG_USE_NEON
+        for (; i + 16 <= (width >> 1); i += 16) {
+            int indexY = row * width + (i << 1);
+            int indexU = row * (width >> 1) + i;
+            // Y0 U Y1 V
+            uint8x16x4_t yuyvPixels = vld4q_u8(yuvSeg);
+            uint8x16x2_t yPixels;
+            yPixels.val[0] = yuyvPixels.val[0];
+            yPixels.val[1] = yuyvPixels.val[2];
+            vst2q_u8(yRows + indexY, yPixels);
+            vst1q_u8(uRows + indexU, yuyvPixels.val[1]);
+            vst1q_u8(vRows + indexU, yuyvPixels.val[3]);
+            yuvSeg += 64;
+        }
+#endif
+        for (; i < (width >> 1); ++i) {
             int indexY = row * width + (i << 1);
             int indexU = row * (width >> 1) + i;
             yRows[indexY] = yuvSeg[0];
@@ -207,6 +395,10 @@ void Yuv422IToJpegEncoder::deinterleave(uint8_t* yuv, uint8_t* yRows, uint8_t* u
     }
 }
 
+void Yuv422IToJpegEncoder::offsetRows(const int* offsets, int firstRow, int* outOffsets) {
+    outOffsets[0] = offsets[0] + firstRow * fStrides[0];
+}
+
 void Yuv422IToJpegEncoder::configSamplingFactors(jpeg_compress_struct* cinfo) {
     // cb and cr are horizontally downsampled and vertically downsampled as well.
     cinfo->comp_info[0].h_samp_factor = 2;
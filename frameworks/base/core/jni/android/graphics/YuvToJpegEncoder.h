@@ -43,6 +43,24 @@ protected:
     virtual void configSamplingFactors(jpeg_compress_struct* cinfo) = 0;
     virtual void compress(jpeg_compress_struct* cinfo,
             uint8_t* yuv, int* offsets) = 0;
+
+    /** Computes the plane offsets of the image that starts at row firstRow of the image
+     *  described by offsets. firstRow is a multiple of 16.
+     */
+    virtual void offsetRows(const int* offsets, int firstRow, int* outOffsets) = 0;
+
+private:
+    /** Encodes the image as a single JPEG, with a restart marker every
+     *  restartInterval MCUs if it is not zero.
+     */
+    bool encodeStripe(SkWStream* stream, uint8_t* yuv, int width, int height,
+            int* offsets, int jpegQuality, unsigned int restartInterval);
+
+    /** Encodes horizontal stripes of the image on several threads and joins
+     *  them into one JPEG with restart markers.
+     */
+    bool encodeStriped(SkWStream* stream, uint8_t* yuv, int width, int height,
+            int* offsets, int jpegQuality, int stripeCount);
 };
 
 class Yuv420SpToJpegEncoder : public YuvToJpegEncoder {
@@ -57,6 +75,7 @@ private:
     void deinterleave(uint8_t* vuPlanar, uint8_t* uRows, uint8_t* vRows,
             int rowIndex, int width, int height);
     void compress(jpeg_compress_struct* cinfo, uint8_t* yuv, int* offsets);
+    void offsetRows(const int* offsets, int firstRow, int* outOffsets);
 };
 
 class Yuv422IToJpegEncoder : public YuvToJpegEncoder {
@@ -69,6 +88,7 @@ private:
     void compress(jpeg_compress_struct* cinfo, uint8_t* yuv, int* offsets);
     void deinterleave(uint8_t* yuv, uint8_t* yRows, uint8_t* uRows,
             uint8_t* vRows, int rowIndex, int width, int height);
+    void offsetRows(const int* offsets, int firstRow, int* outOffsets);
 };
 
 #endif  // _ANDROID_GRAPHICS_YUV_TO_JPEG_ENCODER_H_
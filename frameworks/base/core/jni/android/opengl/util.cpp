@@ -922,8 +922,9 @@ static void etc1_encodeImage(JNIEnv *env, jclass clazz,
         } else if (outB.remaining() < encodedImageSize) {
             doThrowIAE(env, "out's remaining data < encoded image size");
         } else {
-            etc1_encode_image((etc1_byte*) inB.getData(), width, height, pixelSize, stride,
-                              (etc1_byte*) outB.getData());
+            // Same output as etc1_encode_image, using every CPU.
+            etc1_encode_image_with_options((etc1_byte*) inB.getData(), width, height,
+                    pixelSize, stride, (etc1_byte*) outB.getData(), ETC1_QUALITY_HIGH, 0);
         }
     }
 }
@@ -305,6 +305,10 @@ bool NativeContext::hasCaptureTime() const {
 /**
  * Wrapper class for a Java OutputStream.
  *
+ * Writes are collected in a native buffer and handed to the stream in BYTE_ARRAY_LENGTH chunks,
+ * since TiffWriter writes most entries a few bytes at a time. close() must be called to write out
+ * what is left in the buffer.
+ *
  * This class is not intended to be used across JNI calls.
  */
 class JniOutputStream : public Output, public LightRefBase<JniOutputStream> {
@@ -320,15 +324,21 @@ public:
     status_t close();
 private:
     enum {
-        BYTE_ARRAY_LENGTH = 4096
+        BYTE_ARRAY_LENGTH = 65536
     };
+
+    // Hands the buffered bytes to the Java stream.
+    status_t flush();
+
     jobject mOutputStream;
     JNIEnv* mEnv;
     jbyteArray mByteArray;
+    std::vector<uint8_t> mBuffer;
+    size_t mBuffered;
 };
 
 JniOutputStream::JniOutputStream(JNIEnv* env, jobject outStream) : mOutputStream(outStream),
-        mEnv(env) {
+        mEnv(env), mBuffer(BYTE_ARRAY_LENGTH), mBuffered(0) {
     mByteArray = env->NewByteArray(BYTE_ARRAY_LENGTH);
     if (mByteArray == nullptr) {
         jniThrowException(env, "java/lang/OutOfMemoryError", "Could not allocate byte array.");
@@ -346,18 +356,12 @@ status_t JniOutputStream::open() {
 
 status_t JniOutputStream::write(const uint8_t* buf, size_t offset, size_t count) {
     while(count > 0) {
-        size_t len = BYTE_ARRAY_LENGTH;
+        size_t len = BYTE_ARRAY_LENGTH - mBuffered;
         len = (count > len) ? len : count;
-        mEnv->SetByteArrayRegion(mByteArray, 0, len, reinterpret_cast<const jbyte*>(buf + offset));
-
-        if (mEnv->ExceptionCheck()) {
-            return BAD_VALUE;
-        }
+        memcpy(mBuffer.data() + mBuffered, buf + offset, len);
+        mBuffered += len;
 
-        mEnv->CallVoidMethod(mOutputStream, gOutputStreamClassInfo.mWriteMethod, mByteArray,
-                0, len);
-
-        if (mEnv->ExceptionCheck()) {
+        if (mBuffered == BYTE_ARRAY_LENGTH && flush() != OK) {
             return BAD_VALUE;
         }
 
@@ -367,11 +371,33 @@ status_t JniOutputStream::write(const uint8_t* buf, size_t offset, size_t count)
     return OK;
 }
 
-status_t JniOutputStream::close() {
-    // Do nothing
+status_t JniOutputStream::flush() {
+    if (mBuffered == 0) {
+        return OK;
+    }
+
+    mEnv->SetByteArrayRegion(mByteArray, 0, mBuffered,
+            reinterpret_cast<const jbyte*>(mBuffer.data()));
+
+    if (mEnv->ExceptionCheck()) {
+        return BAD_VALUE;
+    }
+
+    mEnv->CallVoidMethod(mOutputStream, gOutputStreamClassInfo.mWriteMethod, mByteArray,
+            0, mBuffered);
+
+    if (mEnv->ExceptionCheck()) {
+        return BAD_VALUE;
+    }
+
+    mBuffered = 0;
     return OK;
 }
 
+status_t JniOutputStream::close() {
+    return flush();
+}
+
 // End of JniOutputStream
 // ----------------------------------------------------------------------------
 
@@ -395,7 +421,7 @@ public:
     virtual ~JniInputStream();
 private:
     enum {
-        BYTE_ARRAY_LENGTH = 4096
+        BYTE_ARRAY_LENGTH = 65536
     };
     jobject mInStream;
     JNIEnv* mEnv;
@@ -482,7 +508,7 @@ public:
     virtual ~JniInputByteBuffer();
 private:
     enum {
-        BYTE_ARRAY_LENGTH = 4096
+        BYTE_ARRAY_LENGTH = 65536
     };
     jobject mInBuf;
     JNIEnv* mEnv;
@@ -2215,7 +2241,8 @@ static void DngCreator_nativeWriteImage(JNIEnv* env, jobject thiz, jobject outSt
         sources.add(&stripSource);
 
         status_t ret = OK;
-        if ((ret = writer->write(out.get(), sources.editArray(), sources.size())) != OK) {
+        if ((ret = writer->write(out.get(), sources.editArray(), sources.size())) != OK ||
+                (ret = out->close()) != OK) {
             ALOGE("%s: write failed with error %d.", __FUNCTION__, ret);
             if (!env->ExceptionCheck()) {
                 jniThrowExceptionFmt(env, "java/io/IOException",
@@ -2232,7 +2259,8 @@ static void DngCreator_nativeWriteImage(JNIEnv* env, jobject thiz, jobject outSt
         sources.add(&stripSource);
 
         status_t ret = OK;
-        if ((ret = writer->write(out.get(), sources.editArray(), sources.size())) != OK) {
+        if ((ret = writer->write(out.get(), sources.editArray(), sources.size())) != OK ||
+                (ret = out->close()) != OK) {
             ALOGE("%s: write failed with error %d.", __FUNCTION__, ret);
             if (!env->ExceptionCheck()) {
                 jniThrowExceptionFmt(env, "java/io/IOException",
@@ -2306,7 +2334,8 @@ static void DngCreator_nativeWriteInputStream(JNIEnv* env, jobject thiz, jobject
     sources.add(&stripSource);
 
     status_t ret = OK;
-    if ((ret = writer->write(out.get(), sources.editArray(), sources.size())) != OK) {
+    if ((ret = writer->write(out.get(), sources.editArray(), sources.size())) != OK ||
+            (ret = out->close()) != OK) {
         ALOGE("%s: write failed with error %d.", __FUNCTION__, ret);
         if (!env->ExceptionCheck()) {
             jniThrowExceptionFmt(env, "java/io/IOException",
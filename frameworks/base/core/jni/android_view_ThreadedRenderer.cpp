@@ -48,7 +48,9 @@
 #include <FrameMetricsObserver.h>
 #include <IContextFactory.h>
 #include <PropertyValuesAnimatorSet.h>
+#include <ProgramProfile.h>
 #include <RenderNode.h>
+#include <pipeline/skia/ShaderCache.h>
 #include <renderthread/CanvasContext.h>
 #include <renderthread/RenderProxy.h>
 #include <renderthread/RenderTask.h>
@@ -967,6 +969,13 @@ static void android_view_ThreadedRenderer_setupShadersDiskCache(JNIEnv* env, job
         jstring diskCachePath) {
     const char* cacheArray = env->GetStringUTFChars(diskCachePath, NULL);
     android::egl_set_cache_filename(cacheArray);
+    // Skia's shaders and the program profile go to their own files, next to the EGL one
+    std::string cacheDir(cacheArray);
+    cacheDir.erase(cacheDir.rfind('/') + 1);
+    std::string skiaCachePath = cacheDir + "com.android.skia.shaders_cache";
+    uirenderer::skiapipeline::ShaderCache::get().setFilename(skiaCachePath.c_str());
+    std::string programProfilePath = cacheDir + "com.android.hwui.program_profile";
+    uirenderer::ProgramProfile::get().setFilename(programProfilePath.c_str());
     env->ReleaseStringUTFChars(diskCachePath, cacheArray);
 }
 
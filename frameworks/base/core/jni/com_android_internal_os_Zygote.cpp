@@ -403,10 +403,10 @@ static bool NeedsNoRandomizeWorkaround() {
 
 // Utility to close down the Zygote socket file descriptors while
 // the child is still running as root with Zygote's privileges.  Each
-// descriptor (if any) is closed via dup2(), replacing it with a valid
-// (open) descriptor to /dev/null.
+// descriptor (if any) is closed via dup2(), replacing it with devnull,
+// a valid (open) descriptor to /dev/null.
 
-static void DetachDescriptors(JNIEnv* env, jintArray fdsToClose) {
+static void DetachDescriptors(JNIEnv* env, jintArray fdsToClose, int devnull) {
   if (!fdsToClose) {
     return;
   }
@@ -416,20 +416,12 @@ static void DetachDescriptors(JNIEnv* env, jintArray fdsToClose) {
       RuntimeAbort(env, __LINE__, "Bad fd array");
   }
   jsize i;
-  int devnull;
   for (i = 0; i < count; i++) {
-    devnull = open("/dev/null", O_RDWR);
-    if (devnull < 0) {
-      ALOGE("Failed to open /dev/null: %s", strerror(errno));
-      RuntimeAbort(env, __LINE__, "Failed to open /dev/null");
-      continue;
-    }
-    ALOGV("Switching descriptor %d to /dev/null: %s", ar[i], strerror(errno));
+    ALOGV("Switching descriptor %d to /dev/null", ar[i]);
     if (dup2(devnull, ar[i]) < 0) {
       ALOGE("Failed dup2() on descriptor %d: %s", ar[i], strerror(errno));
       RuntimeAbort(env, __LINE__, "Failed dup2()");
     }
-    close(devnull);
   }
 }
 
@@ -522,19 +514,29 @@ static pid_t ForkAndSpecializeCommon(JNIEnv* env, uid_t uid, gid_t gid, jintArra
     RuntimeAbort(env, __LINE__, "Unable to restat file descriptor table.");
   }
 
+  // The child detaches every zygote socket by pointing it at /dev/null. Open it
+  // once here, after the table has been checked so that it isn't part of it,
+  // rather than once per descriptor in the child while the caller waits.
+  int devnull = open("/dev/null", O_RDWR | O_CLOEXEC);
+  if (devnull < 0) {
+    ALOGE("Failed to open /dev/null: %s", strerror(errno));
+    RuntimeAbort(env, __LINE__, "Failed to open /dev/null");
+  }
+
   pid_t pid = fork();
 
   if (pid == 0) {
     PreApplicationInit();
 
     // Clean up any descriptors which must be closed immediately
-    DetachDescriptors(env, fdsToClose);
+    DetachDescriptors(env, fdsToClose, devnull);
 
     // Re-open all remaining open file descriptors so that they aren't shared
     // with the zygote across a fork.
-    if (!gOpenFdTable->ReopenOrDetach()) {
+    if (!gOpenFdTable->ReopenOrDetach(devnull)) {
       RuntimeAbort(env, __LINE__, "Unable to reopen whitelisted descriptors.");
     }
+    close(devnull);
 
     if (sigprocmask(SIG_UNBLOCK, &sigchld, nullptr) == -1) {
       ALOGE("sigprocmask(SIG_SETMASK, { SIGCHLD }) failed: %s", strerror(errno));
@@ -667,7 +669,11 @@ static pid_t ForkAndSpecializeCommon(JNIEnv* env, uid_t uid, gid_t gid, jintArra
     if (env->ExceptionCheck()) {
       RuntimeAbort(env, __LINE__, "Error calling post fork hooks.");
     }
-  } else if (pid > 0) {
+  } else {
+    close(devnull);
+  }
+
+  if (pid > 0) {
     // the parent process
 
     // We blocked SIGCHLD prior to a fork, we unblock it here.
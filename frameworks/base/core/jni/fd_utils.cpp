@@ -223,9 +223,9 @@ bool FileDescriptorInfo::Restat() const {
   return f_stat.st_ino == stat.st_ino && f_stat.st_dev == stat.st_dev;
 }
 
-bool FileDescriptorInfo::ReopenOrDetach() const {
+bool FileDescriptorInfo::ReopenOrDetach(int dev_null_fd) const {
   if (is_sock) {
-    return DetachSocket();
+    return DetachSocket(dev_null_fd);
   }
 
   // NOTE: This might happen if the file was unlinked after being opened.
@@ -332,23 +332,12 @@ bool FileDescriptorInfo::GetSocketName(const int fd, std::string* result) {
   return true;
 }
 
-bool FileDescriptorInfo::DetachSocket() const {
-  const int dev_null_fd = open("/dev/null", O_RDWR);
-  if (dev_null_fd < 0) {
-    PLOG(ERROR) << "Failed to open /dev/null";
-    return false;
-  }
-
+bool FileDescriptorInfo::DetachSocket(int dev_null_fd) const {
   if (dup2(dev_null_fd, fd) == -1) {
     PLOG(ERROR) << "Failed dup2 on socket descriptor " << fd;
     return false;
   }
 
-  if (close(dev_null_fd) == -1) {
-    PLOG(ERROR) << "Failed close(" << dev_null_fd << ")";
-    return false;
-  }
-
   return true;
 }
 
@@ -426,11 +415,11 @@ bool FileDescriptorTable::Restat(const std::vector<int>& fds_to_ignore) {
 // Reopens all file descriptors that are contained in the table. Returns true
 // if all descriptors were successfully re-opened or detached, and false if an
 // error occurred.
-bool FileDescriptorTable::ReopenOrDetach() {
+bool FileDescriptorTable::ReopenOrDetach(int dev_null_fd) {
   std::unordered_map<int, FileDescriptorInfo*>::const_iterator it;
   for (it = open_fd_map_.begin(); it != open_fd_map_.end(); ++it) {
     const FileDescriptorInfo* info = it->second;
-    if (info == NULL || !info->ReopenOrDetach()) {
+    if (info == NULL || !info->ReopenOrDetach(dev_null_fd)) {
       return false;
     }
   }
@@ -78,7 +78,9 @@ class FileDescriptorInfo {
   // refers to the same description.
   bool Restat() const;
 
-  bool ReopenOrDetach() const;
+  // Gives the descriptor its own copy of the file description, or points it
+  // at |dev_null_fd| if it is a socket.
+  bool ReopenOrDetach(int dev_null_fd) const;
 
   const int fd;
   const struct stat stat;
@@ -104,7 +106,7 @@ class FileDescriptorInfo {
   //   address).
   static bool GetSocketName(const int fd, std::string* result);
 
-  bool DetachSocket() const;
+  bool DetachSocket(int dev_null_fd) const;
 
   DISALLOW_COPY_AND_ASSIGN(FileDescriptorInfo);
 };
@@ -120,10 +122,11 @@ class FileDescriptorTable {
 
   bool Restat(const std::vector<int>& fds_to_ignore);
 
-  // Reopens all file descriptors that are contained in the table. Returns true
-  // if all descriptors were successfully re-opened or detached, and false if an
-  // error occurred.
-  bool ReopenOrDetach();
+  // Reopens all file descriptors that are contained in the table. Sockets are
+  // detached by duplicating |dev_null_fd|, an open descriptor to /dev/null, over
+  // them. Returns true if all descriptors were successfully re-opened or
+  // detached, and false if an error occurred.
+  bool ReopenOrDetach(int dev_null_fd);
 
  private:
   FileDescriptorTable(const std::unordered_map<int, FileDescriptorInfo*>& map);
@@ -19,6 +19,8 @@
 #include "androidfw/ApkAssets.h"
 
 #include <algorithm>
+#include <mutex>
+#include <unordered_map>
 
 #include "android-base/logging.h"
 #include "utils/FileMap.h"
@@ -39,6 +41,33 @@ std::unique_ptr<const ApkAssets> ApkAssets::LoadAsSharedLibrary(const std::strin
   return ApkAssets::LoadImpl(path, system, true /*load_as_shared_library*/);
 }
 
+const ApkAssets* ApkAssets::LoadSystemShared(const std::string& path) {
+  ATRACE_CALL();
+  // Intentionally leaked: the cached ApkAssets must outlive every AssetManager2 using them,
+  // including those destroyed by static destructors.
+  static std::mutex* cache_lock = new std::mutex();
+  static auto* cache = new std::unordered_map<std::string, const ApkAssets*>();
+
+  const time_t mod_time = getFileModDate(path.c_str());
+
+  std::lock_guard<std::mutex> lock(*cache_lock);
+  auto iter = cache->find(path);
+  if (iter != cache->end() && iter->second->last_mod_time_ == mod_time) {
+    return iter->second;
+  }
+
+  std::unique_ptr<const ApkAssets> loaded_apk = LoadImpl(path, true /*system*/,
+                                                         false /*load_as_shared_library*/);
+  if (loaded_apk == nullptr) {
+    return nullptr;
+  }
+
+  // A stale entry may still be in use by existing AssetManagers, so it is never freed.
+  const ApkAssets* result = loaded_apk.release();
+  (*cache)[path] = result;
+  return result;
+}
+
 std::unique_ptr<const ApkAssets> ApkAssets::LoadImpl(const std::string& path, bool system,
                                                      bool load_as_shared_library) {
   ATRACE_CALL();
@@ -66,6 +95,7 @@ std::unique_ptr<const ApkAssets> ApkAssets::LoadImpl(const std::string& path, bo
   }
 
   loaded_apk->path_ = path;
+  loaded_apk->last_mod_time_ = getFileModDate(path.c_str());
   loaded_apk->resources_asset_ =
       loaded_apk->Open("resources.arsc", Asset::AccessMode::ACCESS_BUFFER);
   if (loaded_apk->resources_asset_ == nullptr) {
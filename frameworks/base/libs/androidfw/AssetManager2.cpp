@@ -97,6 +97,20 @@ void AssetManager2::BuildDynamicRefTable() {
                                           iter->dynamic_ref_table.mAssignedPackageId);
     }
   }
+
+  RebuildFilterList();
+}
+
+void AssetManager2::RebuildFilterList() {
+  ATRACE_CALL();
+  for (PackageGroup& package_group : package_groups_) {
+    const size_t package_count = package_group.packages_.size();
+    package_group.filtered_configs_.resize(package_count);
+    for (size_t i = 0; i < package_count; i++) {
+      package_group.packages_[i]->FilterConfigurations(configuration_,
+                                                       &package_group.filtered_configs_[i]);
+    }
+  }
 }
 
 void AssetManager2::DumpToLog() const {
@@ -154,6 +168,7 @@ void AssetManager2::SetConfiguration(const ResTable_config& configuration) {
   configuration_ = configuration;
 
   if (diff) {
+    RebuildFilterList();
     InvalidateCaches(static_cast<uint32_t>(diff));
   }
 }
@@ -305,8 +320,18 @@ ApkAssetsCookie AssetManager2::FindEntry(uint32_t resid, uint16_t density_overri
     uint32_t current_flags = 0;
 
     const LoadedPackage* loaded_package = package_group.packages_[i];
-    if (!loaded_package->FindEntry(type_idx, entry_id, *desired_config, &current_entry,
-                                   &current_config, &current_flags)) {
+    if (desired_config == &configuration_) {
+      // Use the configurations that were filtered when configuration_ was set.
+      const std::vector<FilteredConfigGroup>& filtered_configs =
+          package_group.filtered_configs_[i];
+      if (type_idx >= filtered_configs.size() ||
+          !loaded_package->FindEntry(filtered_configs[type_idx], type_idx, entry_id,
+                                     *desired_config, &current_entry, &current_config,
+                                     &current_flags)) {
+        continue;
+      }
+    } else if (!loaded_package->FindEntry(type_idx, entry_id, *desired_config, &current_entry,
+                                          &current_config, &current_flags)) {
       continue;
     }
 
@@ -461,6 +486,15 @@ const ResolvedBag* AssetManager2::GetBag(uint32_t resid) {
     return cached_iter->second.get();
   }
 
+  ApkAssetsCookie shared_cookie = kInvalidCookie;
+  SharedBagCache* shared_cache = GetSharedBagCache(resid, &shared_cookie);
+  if (shared_cache != nullptr) {
+    const ResolvedBag* shared_bag = shared_cache->Find(resid, configuration_, shared_cookie);
+    if (shared_bag != nullptr) {
+      return shared_bag;
+    }
+  }
+
   LoadedArscEntry entry;
   ResTable_config config;
   uint32_t flags = 0u;
@@ -511,9 +545,7 @@ const ResolvedBag* AssetManager2::GetBag(uint32_t resid) {
     }
     new_bag->type_spec_flags = flags;
     new_bag->entry_count = static_cast<uint32_t>(entry_count);
-    ResolvedBag* result = new_bag.get();
-    cached_bags_[resid] = std::move(new_bag);
-    return result;
+    return CacheBag(resid, std::move(new_bag), shared_cache, shared_cookie);
   }
 
   // In case the parent is a dynamic reference, resolve it.
@@ -608,8 +640,44 @@ const ResolvedBag* AssetManager2::GetBag(uint32_t resid) {
   util::unique_cptr<ResolvedBag> final_bag{new_bag};
   final_bag->type_spec_flags = flags;
   final_bag->entry_count = static_cast<uint32_t>(actual_count);
-  ResolvedBag* result = final_bag.get();
-  cached_bags_[resid] = std::move(final_bag);
+  return CacheBag(resid, std::move(final_bag), shared_cache, shared_cookie);
+}
+
+SharedBagCache* AssetManager2::GetSharedBagCache(uint32_t resid,
+                                                 ApkAssetsCookie* out_cookie) const {
+  const uint8_t idx = package_ids_[get_package_id(resid)];
+  if (idx == 0xff) {
+    return nullptr;
+  }
+
+  // Only bags of a system package that no other package overlays are shared, as they
+  // resolve the same way in every AssetManager2 that uses the package.
+  const PackageGroup& package_group = package_groups_[idx];
+  if (package_group.packages_.size() != 1 || !package_group.packages_[0]->IsSystem()) {
+    return nullptr;
+  }
+  *out_cookie = package_group.cookies_[0];
+  return package_group.packages_[0]->GetSharedBagCache();
+}
+
+const ResolvedBag* AssetManager2::CacheBag(uint32_t resid, util::unique_cptr<ResolvedBag> bag,
+                                           SharedBagCache* shared_cache,
+                                           ApkAssetsCookie shared_cookie) {
+  ResolvedBag* result = bag.get();
+
+  // A bag inheriting entries from another package depends on that package too, so it can
+  // only be shared if all of its entries come from the shared package.
+  bool shareable = shared_cache != nullptr;
+  for (uint32_t i = 0; shareable && i < result->entry_count; i++) {
+    shareable = result->entries[i].cookie == shared_cookie;
+  }
+
+  if (shareable) {
+    shared_cache->Insert(resid, configuration_, shared_cookie, result->type_spec_flags,
+                         bag.release());
+  } else {
+    cached_bags_[resid] = std::move(bag);
+  }
   return result;
 }
 
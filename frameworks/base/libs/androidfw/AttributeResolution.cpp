@@ -17,9 +17,12 @@
 #include "androidfw/AttributeResolution.h"
 
 #include <cstdint>
+#include <memory>
 
 #include <log/log.h>
 
+#include "android-base/macros.h"
+
 #include "androidfw/AttributeFinder.h"
 #include "androidfw/ResourceTypes.h"
 
@@ -27,20 +30,47 @@ constexpr bool kDebugStyles = false;
 
 namespace android {
 
-class XmlAttributeFinder
-    : public BackTrackingAttributeFinder<XmlAttributeFinder, size_t> {
+// The resource IDs of the attributes of the current XML tag, read once into a contiguous
+// array. Looking an ID up through the parser goes through its dynamic reference table, which
+// is too expensive to repeat for every comparison the finders make.
+class XmlAttributeIds {
  public:
-  explicit XmlAttributeFinder(const ResXMLParser* parser)
-      : BackTrackingAttributeFinder(
-            0, parser != nullptr ? parser->getAttributeCount() : 0),
-        parser_(parser) {}
-
-  inline uint32_t GetAttribute(size_t index) const {
-    return parser_->getAttributeNameResID(index);
+  explicit XmlAttributeIds(const ResXMLParser* parser)
+      : count_(parser != nullptr ? parser->getAttributeCount() : 0) {
+    uint32_t* ids = inline_ids_;
+    if (count_ > kInlineCount) {
+      heap_ids_.reset(new uint32_t[count_]);
+      ids = heap_ids_.get();
+    }
+    for (size_t i = 0; i < count_; i++) {
+      ids[i] = parser->getAttributeNameResID(i);
+    }
+    ids_ = ids;
   }
 
+  inline const uint32_t* begin() const { return ids_; }
+  inline const uint32_t* end() const { return ids_ + count_; }
+  inline size_t size() const { return count_; }
+
  private:
-  const ResXMLParser* parser_;
+  DISALLOW_COPY_AND_ASSIGN(XmlAttributeIds);
+
+  // Covers the attribute count of nearly every XML tag without a heap allocation.
+  static constexpr size_t kInlineCount = 32;
+
+  const size_t count_;
+  const uint32_t* ids_;
+  uint32_t inline_ids_[kInlineCount];
+  std::unique_ptr<uint32_t[]> heap_ids_;
+};
+
+class XmlAttributeFinder
+    : public BackTrackingAttributeFinder<XmlAttributeFinder, const uint32_t*> {
+ public:
+  explicit XmlAttributeFinder(const XmlAttributeIds& ids)
+      : BackTrackingAttributeFinder(ids.begin(), ids.end()) {}
+
+  inline uint32_t GetAttribute(const uint32_t* id) const { return *id; }
 };
 
 class BagAttributeFinder
@@ -276,9 +306,8 @@ void ApplyStyle(ResTable::Theme* theme, ResXMLParser* xml_parser, uint32_t def_s
 
   // Retrieve the XML attributes, if requested.
   static const ssize_t kXmlBlock = 0x10000000;
-  XmlAttributeFinder xml_attr_finder(xml_parser);
-  const size_t xml_attr_end =
-      xml_parser != nullptr ? xml_parser->getAttributeCount() : 0;
+  const XmlAttributeIds xml_attr_ids(xml_parser);
+  XmlAttributeFinder xml_attr_finder(xml_attr_ids);
 
   // Now iterate through all of the attributes that the client has requested,
   // filling in each with whatever data we can find.
@@ -301,10 +330,10 @@ void ApplyStyle(ResTable::Theme* theme, ResXMLParser* xml_parser, uint32_t def_s
     // style, and finally the theme.
 
     // Walk through the xml attributes looking for the requested attribute.
-    const size_t xml_attr_idx = xml_attr_finder.Find(cur_ident);
-    if (xml_attr_idx != xml_attr_end) {
+    const uint32_t* const xml_attr = xml_attr_finder.Find(cur_ident);
+    if (xml_attr != xml_attr_ids.end()) {
       // We found the attribute we were looking for.
-      xml_parser->getAttributeValue(xml_attr_idx, &value);
+      xml_parser->getAttributeValue(xml_attr - xml_attr_ids.begin(), &value);
       if (kDebugStyles) {
         ALOGI("-> From XML: type=0x%x, data=0x%08x", value.dataType, value.data);
       }
@@ -420,9 +449,10 @@ bool RetrieveAttributes(const ResTable* res, ResXMLParser* xml_parser,
   res->lock();
 
   // Retrieve the XML attributes, if requested.
-  const size_t xml_attr_count = xml_parser->getAttributeCount();
+  const XmlAttributeIds xml_attr_ids(xml_parser);
+  const size_t xml_attr_count = xml_attr_ids.size();
+  const uint32_t* const xml_attrs = xml_attr_ids.begin();
   size_t ix = 0;
-  uint32_t cur_xml_attr = xml_parser->getAttributeNameResID(ix);
 
   static const ssize_t kXmlBlock = 0x10000000;
 
@@ -439,15 +469,13 @@ bool RetrieveAttributes(const ResTable* res, ResXMLParser* xml_parser,
 
     // Try to find a value for this attribute...
     // Skip through XML attributes until the end or the next possible match.
-    while (ix < xml_attr_count && cur_ident > cur_xml_attr) {
+    while (ix < xml_attr_count && cur_ident > xml_attrs[ix]) {
       ix++;
-      cur_xml_attr = xml_parser->getAttributeNameResID(ix);
     }
     // Retrieve the current XML attribute if it matches, and step to next.
-    if (ix < xml_attr_count && cur_ident == cur_xml_attr) {
+    if (ix < xml_attr_count && cur_ident == xml_attrs[ix]) {
       xml_parser->getAttributeValue(ix, &value);
       ix++;
-      cur_xml_attr = xml_parser->getAttributeNameResID(ix);
     }
 
     uint32_t resid = 0;
@@ -34,6 +34,7 @@ CursorWindow::CursorWindow(const String8& name, int ashmemFd,
         void* data, size_t size, bool readOnly) :
         mName(name), mAshmemFd(ashmemFd), mData(data), mSize(size), mReadOnly(readOnly) {
     mHeader = static_cast<Header*>(mData);
+    resetRowSlotChunkCache();
 }
 
 CursorWindow::~CursorWindow() {
@@ -146,6 +147,7 @@ status_t CursorWindow::clear() {
 
     RowSlotChunk* firstChunk = static_cast<RowSlotChunk*>(offsetToPtr(mHeader->firstChunkOffset));
     firstChunk->nextChunkOffset = 0;
+    resetRowSlotChunkCache();
     return OK;
 }
 
@@ -225,24 +227,57 @@ uint32_t CursorWindow::alloc(size_t size, bool aligned) {
     return offset;
 }
 
-CursorWindow::RowSlot* CursorWindow::getRowSlot(uint32_t row) {
+void CursorWindow::resetRowSlotChunkCache() {
+    mCachedChunkOffset = 0;
+    mCachedChunkFirstRow = 0;
+    mCachedChunkFreeOffset = 0;
+}
+
+CursorWindow::RowSlotChunk* CursorWindow::findRowSlotChunk(uint32_t row, uint32_t* outChunkPos) {
+    if (mReadOnly && mCachedChunkFreeOffset != mHeader->freeOffset) {
+        resetRowSlotChunkCache();
+        mCachedChunkFreeOffset = mHeader->freeOffset;
+    }
+
+    uint32_t chunkOffset = mHeader->firstChunkOffset;
     uint32_t chunkPos = row;
-    RowSlotChunk* chunk = static_cast<RowSlotChunk*>(
-            offsetToPtr(mHeader->firstChunkOffset));
-    while (chunkPos >= ROW_SLOT_CHUNK_NUM_ROWS) {
-        chunk = static_cast<RowSlotChunk*>(offsetToPtr(chunk->nextChunkOffset));
+    if (mCachedChunkOffset && row >= mCachedChunkFirstRow) {
+        chunkOffset = mCachedChunkOffset;
+        chunkPos = row - mCachedChunkFirstRow;
+    }
+
+    RowSlotChunk* chunk = static_cast<RowSlotChunk*>(offsetToPtr(chunkOffset));
+    while (chunk != NULL && chunkPos > ROW_SLOT_CHUNK_NUM_ROWS) {
+        chunkOffset = chunk->nextChunkOffset;
+        chunk = static_cast<RowSlotChunk*>(offsetToPtr(chunkOffset));
         chunkPos -= ROW_SLOT_CHUNK_NUM_ROWS;
     }
+    if (chunk != NULL) {
+        mCachedChunkOffset = chunkOffset;
+        mCachedChunkFirstRow = row - chunkPos;
+    }
+    *outChunkPos = chunkPos;
+    return chunk;
+}
+
+CursorWindow::RowSlot* CursorWindow::getRowSlot(uint32_t row) {
+    uint32_t chunkPos;
+    RowSlotChunk* chunk = findRowSlotChunk(row, &chunkPos);
+    if (chunk != NULL && chunkPos == ROW_SLOT_CHUNK_NUM_ROWS) {
+        chunk = static_cast<RowSlotChunk*>(offsetToPtr(chunk->nextChunkOffset));
+        chunkPos = 0;
+    }
+    if (chunk == NULL) {
+        return NULL;
+    }
     return &chunk->slots[chunkPos];
 }
 
 CursorWindow::RowSlot* CursorWindow::allocRowSlot() {
-    uint32_t chunkPos = mHeader->numRows;
-    RowSlotChunk* chunk = static_cast<RowSlotChunk*>(
-            offsetToPtr(mHeader->firstChunkOffset));
-    while (chunkPos > ROW_SLOT_CHUNK_NUM_ROWS) {
-        chunk = static_cast<RowSlotChunk*>(offsetToPtr(chunk->nextChunkOffset));
-        chunkPos -= ROW_SLOT_CHUNK_NUM_ROWS;
+    uint32_t chunkPos;
+    RowSlotChunk* chunk = findRowSlotChunk(mHeader->numRows, &chunkPos);
+    if (chunk == NULL) {
+        return NULL;
     }
     if (chunkPos == ROW_SLOT_CHUNK_NUM_ROWS) {
         if (!chunk->nextChunkOffset) {
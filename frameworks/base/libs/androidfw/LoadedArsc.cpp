@@ -113,6 +113,21 @@ class TypeSpecPtrBuilder {
 
 }  // namespace
 
+// Returns the offset of the entry at `entry_idx` relative to the start of `type`, or
+// ResTable_type::NO_ENTRY if `type` doesn't define it.
+static uint32_t GetEntryOffset(const ResTable_type* type, uint16_t entry_idx) {
+  if (entry_idx >= dtohl(type->entryCount)) {
+    return ResTable_type::NO_ENTRY;
+  }
+  const uint32_t* entry_offsets = reinterpret_cast<const uint32_t*>(
+      reinterpret_cast<const uint8_t*>(type) + dtohs(type->header.headerSize));
+  const uint32_t offset = dtohl(entry_offsets[entry_idx]);
+  if (offset == ResTable_type::NO_ENTRY) {
+    return ResTable_type::NO_ENTRY;
+  }
+  return offset + dtohl(type->entriesStart);
+}
+
 bool LoadedPackage::FindEntry(uint8_t type_idx, uint16_t entry_idx, const ResTable_config& config,
                               LoadedArscEntry* out_entry, ResTable_config* out_selected_config,
                               uint32_t* out_flags) const {
@@ -142,17 +157,52 @@ bool LoadedPackage::FindEntry(uint8_t type_idx, uint16_t entry_idx, const ResTab
         (best_config == nullptr || type->configuration.isBetterThan(*best_config, &config))) {
       // The configuration matches and is better than the previous selection.
       // Find the entry value if it exists for this configuration.
-      size_t entry_count = dtohl(type->type->entryCount);
-      if (entry_idx < entry_count) {
-        const uint32_t* entry_offsets = reinterpret_cast<const uint32_t*>(
-            reinterpret_cast<const uint8_t*>(type->type) + dtohs(type->type->header.headerSize));
-        const uint32_t offset = dtohl(entry_offsets[entry_idx]);
-        if (offset != ResTable_type::NO_ENTRY) {
-          // There is an entry for this resource, record it.
-          best_config = &type->configuration;
-          best_type = type->type;
-          best_offset = offset + dtohl(type->type->entriesStart);
-        }
+      const uint32_t offset = GetEntryOffset(type->type, entry_idx);
+      if (offset != ResTable_type::NO_ENTRY) {
+        // There is an entry for this resource, record it.
+        best_config = &type->configuration;
+        best_type = type->type;
+        best_offset = offset;
+      }
+    }
+  }
+
+  if (best_type == nullptr) {
+    return false;
+  }
+  return ResolveEntry(ptr.get(), entry_idx, best_type, best_offset, *best_config, out_entry,
+                      out_selected_config, out_flags);
+}
+
+bool LoadedPackage::FindEntry(const FilteredConfigGroup& filtered_group, uint8_t type_idx,
+                              uint16_t entry_idx, const ResTable_config& config,
+                              LoadedArscEntry* out_entry, ResTable_config* out_selected_config,
+                              uint32_t* out_flags) const {
+  ATRACE_CALL();
+
+  const TypeSpecPtr& ptr = type_specs_[type_idx - type_id_offset_];
+  if (ptr == nullptr) {
+    return false;
+  }
+
+  if (entry_idx >= dtohl(ptr->type_spec->entryCount)) {
+    return false;
+  }
+
+  const ResTable_config* best_config = nullptr;
+  const ResTable_type* best_type = nullptr;
+  uint32_t best_offset = 0;
+
+  // All the configurations in the group are already known to match `config`.
+  const size_t filtered_count = filtered_group.types.size();
+  for (size_t i = 0; i < filtered_count; i++) {
+    const ResTable_config& this_config = filtered_group.configurations[i];
+    if (best_config == nullptr || this_config.isBetterThan(*best_config, &config)) {
+      const uint32_t offset = GetEntryOffset(filtered_group.types[i], entry_idx);
+      if (offset != ResTable_type::NO_ENTRY) {
+        best_config = &this_config;
+        best_type = filtered_group.types[i];
+        best_offset = offset;
       }
     }
   }
@@ -160,19 +210,99 @@ bool LoadedPackage::FindEntry(uint8_t type_idx, uint16_t entry_idx, const ResTab
   if (best_type == nullptr) {
     return false;
   }
+  return ResolveEntry(ptr.get(), entry_idx, best_type, best_offset, *best_config, out_entry,
+                      out_selected_config, out_flags);
+}
 
-  const uint32_t* flags = reinterpret_cast<const uint32_t*>(ptr->type_spec + 1);
+bool LoadedPackage::ResolveEntry(const TypeSpec* type_spec, uint16_t entry_idx,
+                                 const ResTable_type* type, uint32_t offset,
+                                 const ResTable_config& config, LoadedArscEntry* out_entry,
+                                 ResTable_config* out_selected_config, uint32_t* out_flags) const {
+  const uint32_t* flags = reinterpret_cast<const uint32_t*>(type_spec->type_spec + 1);
   *out_flags = dtohl(flags[entry_idx]);
-  *out_selected_config = *best_config;
+  *out_selected_config = config;
 
-  const ResTable_entry* best_entry = reinterpret_cast<const ResTable_entry*>(
-      reinterpret_cast<const uint8_t*>(best_type) + best_offset);
-  out_entry->entry = best_entry;
-  out_entry->type_string_ref = StringPoolRef(&type_string_pool_, best_type->id - 1);
-  out_entry->entry_string_ref = StringPoolRef(&key_string_pool_, dtohl(best_entry->key.index));
+  const ResTable_entry* entry =
+      reinterpret_cast<const ResTable_entry*>(reinterpret_cast<const uint8_t*>(type) + offset);
+  out_entry->entry = entry;
+  out_entry->type_string_ref = StringPoolRef(&type_string_pool_, type->id - 1);
+  out_entry->entry_string_ref = StringPoolRef(&key_string_pool_, dtohl(entry->key.index));
   return true;
 }
 
+void LoadedPackage::FilterConfigurations(const ResTable_config& config,
+                                         std::vector<FilteredConfigGroup>* out_groups) const {
+  ATRACE_CALL();
+  out_groups->clear();
+
+  const size_t type_count = type_specs_.size();
+  for (size_t i = 0; i < type_count; i++) {
+    const TypeSpec* type_spec = type_specs_[i].get();
+    if (type_spec == nullptr) {
+      continue;
+    }
+
+    // Index the groups the same way callers index types, including the type ID offset.
+    const size_t type_idx = i + type_id_offset_;
+    if (type_idx >= out_groups->size()) {
+      out_groups->resize(type_idx + 1);
+    }
+
+    FilteredConfigGroup& group = (*out_groups)[type_idx];
+    for (size_t j = 0; j < type_spec->type_count; j++) {
+      const Type* type = &type_spec->types[j];
+      if (type->configuration.match(config)) {
+        group.configurations.push_back(type->configuration);
+        group.types.push_back(type->type);
+      }
+    }
+  }
+}
+
+SharedBagCache::SharedBagCache() {
+  for (std::atomic<Node*>& bucket : buckets_) {
+    bucket.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+SharedBagCache::~SharedBagCache() {
+  for (std::atomic<Node*>& bucket : buckets_) {
+    Node* node = bucket.load(std::memory_order_relaxed);
+    while (node != nullptr) {
+      Node* next = node->next;
+      ::free(node->bag);
+      delete node;
+      node = next;
+    }
+  }
+}
+
+const ResolvedBag* SharedBagCache::Find(uint32_t resid, const ResTable_config& config,
+                                        int32_t cookie) const {
+  const Node* node = buckets_[resid % kBucketCount].load(std::memory_order_acquire);
+  for (; node != nullptr; node = node->next) {
+    if (node->resid == resid && node->cookie == cookie &&
+        (static_cast<uint32_t>(node->configuration.diff(config)) & node->type_spec_flags) == 0) {
+      return node->bag;
+    }
+  }
+  return nullptr;
+}
+
+void SharedBagCache::Insert(uint32_t resid, const ResTable_config& config, int32_t cookie,
+                            uint32_t type_spec_flags, ResolvedBag* bag) {
+  Node* node = new Node{resid, cookie, type_spec_flags, config, bag, nullptr};
+
+  // Nodes are only ever pushed at the head of a bucket, so a reader walking the bucket always
+  // sees a consistent list. Two threads may race to insert the same bag; the duplicate is
+  // harmless.
+  std::atomic<Node*>& bucket = buckets_[resid % kBucketCount];
+  node->next = bucket.load(std::memory_order_relaxed);
+  while (!bucket.compare_exchange_weak(node->next, node, std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+  }
+}
+
 // The destructor gets generated into arbitrary translation units
 // if left implicit, which causes the compiler to complain about
 // forward declarations and incomplete types.
@@ -25,6 +25,7 @@
 #include <assert.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
 
 /*
  * TEMP_FAILURE_RETRY is defined by some, but not all, versions of
@@ -64,6 +65,12 @@ StreamingZipInflater::StreamingZipInflater(int fd, off64_t compDataStart,
     mOutBufSize = StreamingZipInflater::OUTPUT_CHUNK_SIZE;
     mOutBuf = new uint8_t[mOutBufSize];
 
+#if defined(__linux__)
+    // The compressed data is consumed front to back; let the kernel start reading it in
+    // while we inflate the first chunks.
+    posix_fadvise(mFd, mInFileStart, mInTotalSize, POSIX_FADV_WILLNEED);
+#endif
+
     initInflateState();
 }
 
@@ -79,6 +86,9 @@ StreamingZipInflater::StreamingZipInflater(FileMap* dataMap, size_t uncompSize)
     mInBuf = (uint8_t*) dataMap->getDataPtr();
     mInBufSize = mInTotalSize;
 
+    // Page in the compressed data ahead of inflation instead of faulting on each page.
+    dataMap->advise(FileMap::WILLNEED);
+
     mOutBufSize = StreamingZipInflater::OUTPUT_CHUNK_SIZE;
     mOutBuf = new uint8_t[mOutBufSize];
 
@@ -132,6 +142,9 @@ void StreamingZipInflater::initInflateState() {
  *       and readjust the z_stream input pointers
  *    b. point the output to the start of the output buffer and decode what we can
  *    c. deliver whatever output data we can
+ *
+ * Once the output buffer is drained, requests of at least a full output chunk are decoded
+ * straight into the caller's buffer rather than going through mOutBuf.
  */
 ssize_t StreamingZipInflater::read(void* outBuf, size_t count) {
     uint8_t* dest = (uint8_t*) outBuf;
@@ -167,8 +180,12 @@ ssize_t StreamingZipInflater::read(void* outBuf, size_t count) {
             }
             // we know we've drained whatever is in the out buffer now, so just
             // start from scratch there, reading all the input we have at present.
-            mInflateState.next_out = (Bytef*) mOutBuf;
-            mInflateState.avail_out = mOutBufSize;
+            // Large requests skip the copy and are decoded in place.
+            const bool direct = (outBuf != NULL) && (toRead >= mOutBufSize);
+            uint8_t* const target = direct ? dest : mOutBuf;
+            const size_t targetSize = direct ? toRead : mOutBufSize;
+            mInflateState.next_out = (Bytef*) target;
+            mInflateState.avail_out = targetSize;
 
             /*
             ALOGV("Inflating to outbuf: avail_in=%u avail_out=%u next_in=%p next_out=%p",
@@ -196,8 +213,18 @@ ssize_t StreamingZipInflater::read(void* outBuf, size_t count) {
                 }
 
                 // Note how much data we got, and off we go
-                mOutDeliverable = 0;
-                mOutLastDecoded = mOutBufSize - mInflateState.avail_out;
+                const size_t decoded = targetSize - mInflateState.avail_out;
+                if (direct) {
+                    // Already delivered; mOutBuf stays empty.
+                    mOutDeliverable = mOutLastDecoded = 0;
+                    mOutCurPosition += decoded;
+                    dest += decoded;
+                    bytesRead += decoded;
+                    toRead -= decoded;
+                } else {
+                    mOutDeliverable = 0;
+                    mOutLastDecoded = decoded;
+                }
             }
         }
     }
@@ -36,6 +36,14 @@ class ApkAssets {
   static std::unique_ptr<const ApkAssets> LoadAsSharedLibrary(const std::string& path,
                                                               bool system = false);
 
+  // Returns the system ApkAssets at `path`, loading them the first time they are requested.
+  // The returned ApkAssets are owned by the process-wide cache, live until the process exits
+  // and are shared by every caller. When the zygote loads the framework resources through this
+  // method before forking, child processes inherit the already parsed table in shared pages
+  // instead of parsing their own copy into private memory. If the file was modified since it
+  // was cached, it is loaded again.
+  static const ApkAssets* LoadSystemShared(const std::string& path);
+
   std::unique_ptr<Asset> Open(const std::string& path,
                               Asset::AccessMode mode = Asset::AccessMode::ACCESS_RANDOM) const;
 
@@ -63,6 +71,7 @@ class ApkAssets {
 
   ZipArchivePtr zip_handle_;
   std::string path_;
+  time_t last_mod_time_ = -1;
   std::unique_ptr<Asset> resources_asset_;
   std::unique_ptr<const LoadedArsc> loaded_arsc_;
 };
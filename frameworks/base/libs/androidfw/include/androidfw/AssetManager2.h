@@ -257,6 +257,20 @@ class AssetManager2 : public ::AAssetManager {
   // bitmask `diff`.
   void InvalidateCaches(uint32_t diff);
 
+  // Returns the cache shared across AssetManager2 instances that holds the bags with ID
+  // `resid`, or nullptr if those bags can't be shared. `out_cookie` is set to the cookie of the
+  // package owning the cache.
+  SharedBagCache* GetSharedBagCache(uint32_t resid, ApkAssetsCookie* out_cookie) const;
+
+  // Stores a newly resolved bag in the shared bag cache when possible, or in cached_bags_.
+  // Returns the cached bag.
+  const ResolvedBag* CacheBag(uint32_t resid, util::unique_cptr<ResolvedBag> bag,
+                              SharedBagCache* shared_cache, ApkAssetsCookie shared_cookie);
+
+  // Recomputes, for each package and type, the configurations that match configuration_.
+  // Should be called whenever the package groups or the configuration change.
+  void RebuildFilterList();
+
   // The ordered list of ApkAssets to search. These are not owned by the AssetManager, and must
   // have a longer lifetime.
   std::vector<const ApkAssets*> apk_assets_;
@@ -265,6 +279,10 @@ class AssetManager2 : public ::AAssetManager {
     std::vector<const LoadedPackage*> packages_;
     std::vector<ApkAssetsCookie> cookies_;
     DynamicRefTable dynamic_ref_table;
+
+    // For each package in packages_, the configurations of each type that match
+    // configuration_, indexed by type index. See RebuildFilterList().
+    std::vector<std::vector<FilteredConfigGroup>> filtered_configs_;
   };
 
   // DynamicRefTables for shared library package resolution.
@@ -282,7 +300,8 @@ class AssetManager2 : public ::AAssetManager {
   ResTable_config configuration_;
 
   // Cached set of bags. These are cached because they can inherit keys from parent bags,
-  // which involves some calculation.
+  // which involves some calculation. Bags of system packages are kept in the package's
+  // SharedBagCache instead, so that they are resolved once per process.
   std::unordered_map<uint32_t, util::unique_cptr<ResolvedBag>> cached_bags_;
 };
 
@@ -168,6 +168,14 @@ private:
     bool mReadOnly;
     Header* mHeader;
 
+    // The last row slot chunk visited and the index of its first row, so that walking rows
+    // in order doesn't follow the chunk list from the start each time. This is local to the
+    // process: for a read-only window the cache is dropped whenever the owner may have
+    // changed the window, as told by its free offset.
+    uint32_t mCachedChunkOffset;
+    uint32_t mCachedChunkFirstRow;
+    uint32_t mCachedChunkFreeOffset;
+
     inline void* offsetToPtr(uint32_t offset, uint32_t bufferSize = 0) {
         if (offset >= mSize) {
             ALOGE("Offset %" PRIu32 " out of bounds, max value %zu", offset, mSize);
@@ -195,6 +203,13 @@ private:
     RowSlot* getRowSlot(uint32_t row);
     RowSlot* allocRowSlot();
 
+    /**
+     * Returns the chunk holding the given row, which may be the row just past the last
+     * complete chunk, and sets outChunkPos to the row's position in that chunk.
+     */
+    RowSlotChunk* findRowSlotChunk(uint32_t row, uint32_t* outChunkPos);
+    void resetRowSlotChunkCache();
+
     status_t putBlobOrString(uint32_t row, uint32_t column,
             const void* value, size_t size, int32_t type);
 };
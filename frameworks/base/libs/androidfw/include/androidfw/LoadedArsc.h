@@ -17,6 +17,8 @@
 #ifndef LOADEDARSC_H_
 #define LOADEDARSC_H_
 
+#include <array>
+#include <atomic>
 #include <memory>
 #include <set>
 #include <vector>
@@ -58,6 +60,52 @@ struct LoadedArscEntry {
   StringPoolRef entry_string_ref;
 };
 
+// The configurations of a type that match a given configuration, along with the
+// ResTable_type chunks that define entries for them. Both vectors are index-aligned.
+// See LoadedPackage::FilterConfigurations().
+struct FilteredConfigGroup {
+  std::vector<ResTable_config> configurations;
+  std::vector<const ResTable_type*> types;
+};
+
+struct ResolvedBag;
+
+// Resolved bags of a package, shared by every AssetManager2 that uses the package. A bag is
+// recorded along with the configuration it was resolved for, and is reused for any
+// configuration that only differs in axes the bag doesn't vary with. Entries are never removed
+// while the package is alive, so lookups and insertions are lock-free and may happen
+// concurrently from any thread.
+class SharedBagCache {
+ public:
+  SharedBagCache();
+  ~SharedBagCache();
+
+  // Returns the bag with ID `resid` resolved for a configuration compatible with `config`,
+  // whose entries all come from `cookie`, or nullptr if there is none.
+  const ResolvedBag* Find(uint32_t resid, const ResTable_config& config, int32_t cookie) const;
+
+  // Records `bag`, which was resolved for `config` and whose entries all come from `cookie`.
+  // Takes ownership of `bag`, which must have been allocated with malloc().
+  void Insert(uint32_t resid, const ResTable_config& config, int32_t cookie,
+              uint32_t type_spec_flags, ResolvedBag* bag);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SharedBagCache);
+
+  struct Node {
+    uint32_t resid;
+    int32_t cookie;
+    uint32_t type_spec_flags;
+    ResTable_config configuration;
+    ResolvedBag* bag;
+    Node* next;
+  };
+
+  static constexpr size_t kBucketCount = 256;
+
+  std::array<std::atomic<Node*>, kBucketCount> buckets_;
+};
+
 struct TypeSpec;
 class LoadedArsc;
 
@@ -69,6 +117,18 @@ class LoadedPackage {
                  LoadedArscEntry* out_entry, ResTable_config* out_selected_config,
                  uint32_t* out_flags) const;
 
+  // Same as FindEntry() above, but only considers the configurations in `filtered_group`, which
+  // must have been built by FilterConfigurations() for `config`. This skips matching every
+  // configuration of the type against `config` on each lookup.
+  bool FindEntry(const FilteredConfigGroup& filtered_group, uint8_t type_idx, uint16_t entry_idx,
+                 const ResTable_config& config, LoadedArscEntry* out_entry,
+                 ResTable_config* out_selected_config, uint32_t* out_flags) const;
+
+  // Populates `out_groups`, indexed by type index, with the configurations of each type that
+  // match `config`. Types not defined in this package have an empty group.
+  void FilterConfigurations(const ResTable_config& config,
+                            std::vector<FilteredConfigGroup>* out_groups) const;
+
   // Returns the string pool where type names are stored.
   inline const ResStringPool* GetTypeStringPool() const { return &type_string_pool_; }
 
@@ -108,11 +168,19 @@ class LoadedPackage {
   // for patching the correct package ID to the resource ID.
   uint32_t FindEntryByName(const std::u16string& type_name, const std::u16string& entry_name) const;
 
+  // Returns the cache of resolved bags of this package shared across AssetManager2 instances.
+  inline SharedBagCache* GetSharedBagCache() const { return &shared_bag_cache_; }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(LoadedPackage);
 
   static std::unique_ptr<LoadedPackage> Load(const Chunk& chunk);
 
+  // Fills in the out parameters of FindEntry() for the entry at `offset` in `type`.
+  bool ResolveEntry(const TypeSpec* type_spec, uint16_t entry_idx, const ResTable_type* type,
+                    uint32_t offset, const ResTable_config& config, LoadedArscEntry* out_entry,
+                    ResTable_config* out_selected_config, uint32_t* out_flags) const;
+
   LoadedPackage() = default;
 
   ResStringPool type_string_pool_;
@@ -125,6 +193,8 @@ class LoadedPackage {
 
   ByteBucketArray<util::unique_cptr<TypeSpec>> type_specs_;
   std::vector<DynamicPackageEntry> dynamic_package_map_;
+
+  mutable SharedBagCache shared_bag_cache_;
 };
 
 // Read-only view into a resource table. This class validates all data
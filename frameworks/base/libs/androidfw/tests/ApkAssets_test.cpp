@@ -54,6 +54,18 @@ TEST(ApkAssetsTest, LoadApkAsSharedLibrary) {
   EXPECT_TRUE(loaded_arsc->GetPackages()[0]->IsDynamic());
 }
 
+TEST(ApkAssetsTest, LoadSystemSharedReturnsSameApkAssets) {
+  const std::string path = GetTestDataPath() + "/system/system.apk";
+  const ApkAssets* loaded_apk = ApkAssets::LoadSystemShared(path);
+  ASSERT_NE(nullptr, loaded_apk);
+
+  const LoadedArsc* loaded_arsc = loaded_apk->GetLoadedArsc();
+  ASSERT_NE(nullptr, loaded_arsc);
+  EXPECT_TRUE(loaded_arsc->IsSystem());
+
+  EXPECT_EQ(loaded_apk, ApkAssets::LoadSystemShared(path));
+}
+
 TEST(ApkAssetsTest, CreateAndDestroyAssetKeepsApkAssetsOpen) {
   std::unique_ptr<const ApkAssets> loaded_apk =
       ApkAssets::Load(GetTestDataPath() + "/basic/basic.apk");
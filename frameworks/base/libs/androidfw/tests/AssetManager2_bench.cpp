@@ -69,6 +69,16 @@ static void BM_AssetManagerLoadFrameworkAssets(benchmark::State& state) {
 }
 BENCHMARK(BM_AssetManagerLoadFrameworkAssets);
 
+static void BM_AssetManagerLoadFrameworkAssetsShared(benchmark::State& state) {
+  std::string path = kFrameworkPath;
+  while (state.KeepRunning()) {
+    const ApkAssets* apk = ApkAssets::LoadSystemShared(path);
+    AssetManager2 assets;
+    assets.SetApkAssets({apk});
+  }
+}
+BENCHMARK(BM_AssetManagerLoadFrameworkAssetsShared);
+
 static void BM_AssetManagerLoadFrameworkAssetsOld(benchmark::State& state) {
   String8 path(kFrameworkPath);
   while (state.KeepRunning()) {
@@ -84,7 +94,7 @@ BENCHMARK(BM_AssetManagerLoadFrameworkAssetsOld);
 
 static void GetResourceBenchmark(const std::vector<std::string>& paths,
                                  const ResTable_config* config, uint32_t resid,
-                                 benchmark::State& state) {
+                                 benchmark::State& state, uint16_t density_override = 0u) {
   std::vector<std::unique_ptr<const ApkAssets>> apk_assets;
   std::vector<const ApkAssets*> apk_assets_ptrs;
   for (const std::string& path : paths) {
@@ -108,7 +118,7 @@ static void GetResourceBenchmark(const std::vector<std::string>& paths,
   uint32_t flags;
 
   while (state.KeepRunning()) {
-    assetmanager.GetResource(resid, false /* may_be_bag */, 0u /* density_override */, &value,
+    assetmanager.GetResource(resid, false /* may_be_bag */, density_override, &value,
                              &selected_config, &flags);
   }
 }
@@ -151,6 +161,18 @@ static void BM_AssetManagerGetResourceFrameworkLocale(benchmark::State& state) {
 }
 BENCHMARK(BM_AssetManagerGetResourceFrameworkLocale);
 
+// A density override bypasses the configurations filtered by SetConfiguration(), so this
+// measures the cost of matching every configuration of the type on each lookup.
+static void BM_AssetManagerGetResourceFrameworkLocaleUnfiltered(benchmark::State& state) {
+  ResTable_config config;
+  memset(&config, 0, sizeof(config));
+  memcpy(config.language, "fr", 2);
+  config.density = ResTable_config::DENSITY_XHIGH;
+  GetResourceBenchmark({kFrameworkPath}, &config, kStringOkId, state,
+                       ResTable_config::DENSITY_XXHIGH);
+}
+BENCHMARK(BM_AssetManagerGetResourceFrameworkLocaleUnfiltered);
+
 static void BM_AssetManagerGetResourceFrameworkLocaleOld(benchmark::State& state) {
   ResTable_config config;
   memset(&config, 0, sizeof(config));
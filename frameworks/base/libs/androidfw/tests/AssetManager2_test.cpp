@@ -137,6 +137,48 @@ TEST_F(AssetManager2Test, FindsResourceFromMultipleApkAssets) {
   EXPECT_EQ(Res_value::TYPE_STRING, value.dataType);
 }
 
+TEST_F(AssetManager2Test, FindsResourceAfterConfigurationChange) {
+  ResTable_config desired_config;
+  memset(&desired_config, 0, sizeof(desired_config));
+  desired_config.language[0] = 'd';
+  desired_config.language[1] = 'e';
+
+  AssetManager2 assetmanager;
+  assetmanager.SetApkAssets({basic_assets_.get(), basic_de_fr_assets_.get()});
+  assetmanager.SetConfiguration(desired_config);
+
+  Res_value value;
+  ResTable_config selected_config;
+  uint32_t flags;
+
+  ApkAssetsCookie cookie =
+      assetmanager.GetResource(basic::R::string::test1, false /*may_be_bag*/,
+                               0 /*density_override*/, &value, &selected_config, &flags);
+  ASSERT_NE(kInvalidCookie, cookie);
+  EXPECT_EQ('d', selected_config.language[0]);
+  EXPECT_EQ('e', selected_config.language[1]);
+
+  desired_config.language[0] = 'f';
+  desired_config.language[1] = 'r';
+  assetmanager.SetConfiguration(desired_config);
+
+  cookie = assetmanager.GetResource(basic::R::string::test1, false /*may_be_bag*/,
+                                    0 /*density_override*/, &value, &selected_config, &flags);
+  ASSERT_NE(kInvalidCookie, cookie);
+  EXPECT_EQ('f', selected_config.language[0]);
+  EXPECT_EQ('r', selected_config.language[1]);
+
+  // Back to the default configuration.
+  memset(&desired_config, 0, sizeof(desired_config));
+  assetmanager.SetConfiguration(desired_config);
+
+  cookie = assetmanager.GetResource(basic::R::string::test1, false /*may_be_bag*/,
+                                    0 /*density_override*/, &value, &selected_config, &flags);
+  ASSERT_NE(kInvalidCookie, cookie);
+  EXPECT_EQ(0, selected_config.language[0]);
+  EXPECT_EQ(0, selected_config.language[1]);
+}
+
 TEST_F(AssetManager2Test, FindsResourceFromSharedLibrary) {
   AssetManager2 assetmanager;
 
@@ -223,6 +265,31 @@ TEST_F(AssetManager2Test, FindsBagResourceFromSingleApkAssets) {
   EXPECT_EQ(0, bag->entries[2].cookie);
 }
 
+TEST_F(AssetManager2Test, SharesSystemBagsAcrossInstances) {
+  AssetManager2 assetmanager_one;
+  assetmanager_one.SetApkAssets({system_assets_.get()});
+
+  AssetManager2 assetmanager_two;
+  assetmanager_two.SetApkAssets({system_assets_.get()});
+
+  const ResolvedBag* bag = assetmanager_one.GetBag(R::style::Theme_One);
+  ASSERT_NE(nullptr, bag);
+  EXPECT_EQ(bag, assetmanager_two.GetBag(R::style::Theme_One));
+
+  // The entries of a bag refer to the cookie of the system package, so the bag can't be shared
+  // with an AssetManager2 where the package has another cookie.
+  AssetManager2 assetmanager_three;
+  assetmanager_three.SetApkAssets({basic_assets_.get(), system_assets_.get()});
+
+  const ResolvedBag* other_bag = assetmanager_three.GetBag(R::style::Theme_One);
+  ASSERT_NE(nullptr, other_bag);
+  EXPECT_NE(bag, other_bag);
+  ASSERT_EQ(bag->entry_count, other_bag->entry_count);
+  for (uint32_t i = 0; i < other_bag->entry_count; i++) {
+    EXPECT_EQ(1, other_bag->entries[i].cookie);
+  }
+}
+
 TEST_F(AssetManager2Test, FindsBagResourceFromMultipleApkAssets) {}
 
 TEST_F(AssetManager2Test, FindsBagResourceFromSharedLibrary) {
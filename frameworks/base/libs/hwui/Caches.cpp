@@ -73,6 +73,7 @@ bool Caches::init() {
     mInitialized = true;
 
     mPixelBufferState = new PixelBufferState();
+    mPixelBufferRing = new PixelBufferRing(*mPixelBufferState);
     mTextureState = new TextureState();
     mTextureState->constructTexture(*this);
 
@@ -115,6 +116,8 @@ void Caches::terminate() {
 
     clearGarbage();
 
+    delete mPixelBufferRing;
+    mPixelBufferRing = nullptr;
     delete mPixelBufferState;
     mPixelBufferState = nullptr;
     delete mTextureState;
@@ -24,6 +24,7 @@
 #include "ProgramCache.h"
 #include "PathCache.h"
 #include "RenderBufferCache.h"
+#include "renderstate/PixelBufferRing.h"
 #include "renderstate/PixelBufferState.h"
 #include "renderstate/TextureState.h"
 #include "ResourceCache.h"
@@ -177,6 +178,7 @@ public:
     const Extensions& extensions() const { return mExtensions; }
     Program& program() { return *mProgram; }
     PixelBufferState& pixelBufferState() { return *mPixelBufferState; }
+    PixelBufferRing& pixelBufferRing() { return *mPixelBufferRing; }
     TextureState& textureState() { return *mTextureState; }
 
 private:
@@ -200,6 +202,7 @@ private:
 
     // TODO: move below to RenderState
     PixelBufferState* mPixelBufferState = nullptr;
+    PixelBufferRing* mPixelBufferRing = nullptr;
     TextureState* mTextureState = nullptr;
     Program* mProgram = nullptr; // note: object owned by ProgramCache
 
@@ -118,6 +118,12 @@ public:
     virtual bool isEmpty() const { return ops.empty(); }
     virtual bool hasFunctor() const { return !functors.empty(); }
     virtual bool hasVectorDrawables() const { return !vectorDrawables.empty(); }
+    // Bitmaps are pinned, and functors, VectorDrawables and projection are re-evaluated by
+    // every prepareListAndChildren(), even when nothing was re-recorded
+    virtual bool needsPrepareEachFrame() const {
+        return hasFunctor() || hasVectorDrawables() || !bitmapResources.empty()
+                || projectionReceiveIndex >= 0;
+    }
     virtual bool isSkiaDL() const { return false; }
     virtual bool reuseDisplayList(RenderNode* node, renderthread::CanvasContext* context) {
         return false;
@@ -37,13 +37,15 @@ const std::string FrameInfoNames[] = {
     "FrameCompleted",
     "DequeueBufferDuration",
     "QueueBufferDuration",
+    "GpuDuration",
+    "FrameNumber",
 };
 
 static_assert((sizeof(FrameInfoNames)/sizeof(FrameInfoNames[0]))
         == static_cast<int>(FrameInfoIndex::NumIndexes),
         "size mismatch: FrameInfoNames doesn't match the enum!");
 
-static_assert(static_cast<int>(FrameInfoIndex::NumIndexes) == 16,
+static_assert(static_cast<int>(FrameInfoIndex::NumIndexes) == 18,
         "Must update value in FrameMetrics.java#FRAME_STATS_COUNT (and here)");
 
 void FrameInfo::importUiThreadInfo(int64_t* info) {
@@ -51,6 +51,16 @@ enum class FrameInfoIndex {
     DequeueBufferDuration,
     QueueBufferDuration,
 
+    // GPU time of the most recent frame whose timer query had completed when this frame was
+    // swapped, which is usually one or two frames older. 0 if none completed or if the GPU
+    // can't be timed.
+    GpuDuration,
+
+    // BufferQueue frame number of the buffer this frame was queued as, 0 if it wasn't swapped.
+    // This is the number Surface::getFrameTimestamps() and SurfaceFlinger's frame event history
+    // use, so it ties this frame to its latch and present times.
+    FrameNumber,
+
     // Must be the last value!
     // Also must be kept in sync with FrameMetrics.java#FRAME_STATS_COUNT
     NumIndexes
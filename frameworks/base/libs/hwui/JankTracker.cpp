@@ -132,6 +132,12 @@ void JankTracker::finishFrame(const FrameInfo& frame) {
     mData->reportFrame(totalDuration);
     (*mGlobalData)->reportFrame(totalDuration);
 
+    // GPU timings arrive a few frames late, so they are reported on their own
+    if (frame[FrameInfoIndex::GpuDuration] > 0) {
+        mData->reportGPUFrame(frame[FrameInfoIndex::GpuDuration]);
+        (*mGlobalData)->reportGPUFrame(frame[FrameInfoIndex::GpuDuration]);
+    }
+
     // Keep the fast path as fast as possible.
     if (CC_LIKELY(totalDuration < mFrameInterval)) {
         return;
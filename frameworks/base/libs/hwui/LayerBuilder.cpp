@@ -23,6 +23,8 @@
 
 #include <utils/TypeHelpers.h>
 
+#include <algorithm>
+
 namespace android {
 namespace uirenderer {
 
@@ -32,15 +34,22 @@ public:
             : mBatchId(batchId)
             , mMerging(merging) {
         mBounds = op->computedState.clippedBounds;
-        mOps.push_back(op);
+        addOp(op);
     }
 
     bool intersects(const Rect& rect) const {
         if (!rect.intersects(mBounds)) return false;
 
-        for (const BakedOpState* op : mOps) {
-            if (rect.intersects(op->computedState.clippedBounds)) {
-                return true;
+        // Consecutive ops tend to be close to each other (e.g. the items of a list), so only
+        // test the ops of the chunks whose bounds are hit, rather than every op of the batch
+        for (size_t chunk = 0; chunk < mChunkBounds.size(); chunk++) {
+            if (!rect.intersects(mChunkBounds[chunk])) continue;
+
+            const size_t end = std::min(mOps.size(), (chunk + 1) * kOpsPerChunk);
+            for (size_t i = chunk * kOpsPerChunk; i < end; i++) {
+                if (rect.intersects(mOps[i]->computedState.clippedBounds)) {
+                    return true;
+                }
             }
         }
         return false;
@@ -56,10 +65,26 @@ public:
                 this, mBatchId, mMerging, (int) mOps.size(), RECT_ARGS(mBounds));
     }
 protected:
+    void addOp(BakedOpState* op) {
+        const Rect& opBounds = op->computedState.clippedBounds;
+        if (mOps.size() % kOpsPerChunk == 0) {
+            mChunkBounds.push_back(opBounds);
+        } else {
+            mChunkBounds.back().unionWith(opBounds);
+        }
+        mOps.push_back(op);
+    }
+
     batchid_t mBatchId;
     Rect mBounds;
     std::vector<BakedOpState*> mOps;
     bool mMerging;
+
+private:
+    static const size_t kOpsPerChunk = 16;
+
+    // Union of the bounds of each run of kOpsPerChunk ops in mOps
+    std::vector<Rect> mChunkBounds;
 };
 
 class OpBatch : public BatchBase {
@@ -70,7 +95,7 @@ public:
 
     void batchOp(BakedOpState* op) {
         mBounds.unionWith(op->computedState.clippedBounds);
-        mOps.push_back(op);
+        addOp(op);
     }
 };
 
@@ -182,7 +207,7 @@ public:
 
     void mergeOp(BakedOpState* op) {
         mBounds.unionWith(op->computedState.clippedBounds);
-        mOps.push_back(op);
+        addOp(op);
 
         // Because a new op must have passed canMergeWith(), we know it's passed the clipping compat
         // check, and doesn't extend past a side of the clip that's in use by the merged batch.
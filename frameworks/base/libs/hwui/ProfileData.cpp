@@ -97,6 +97,10 @@ void ProfileData::mergeWith(const ProfileData& other) {
         mFrameCounts[i] >>= divider;
         mFrameCounts[i] += other.mFrameCounts[i];
     }
+    for (size_t i = 0; i < other.mGPUFrameCounts.size(); i++) {
+        mGPUFrameCounts[i] >>= divider;
+        mGPUFrameCounts[i] += other.mGPUFrameCounts[i];
+    }
     mJankFrameCount >>= divider;
     mJankFrameCount += other.mJankFrameCount;
     mTotalFrameCount >>= divider;
@@ -123,6 +127,14 @@ void ProfileData::dump(int fd) const {
     histogramForEach([fd](HistogramEntry entry) {
         dprintf(fd, " %ums=%u", entry.renderTimeMs, entry.frameCount);
     });
+    dprintf(fd, "\n50th gpu percentile: %ums", findGPUPercentile(50));
+    dprintf(fd, "\n90th gpu percentile: %ums", findGPUPercentile(90));
+    dprintf(fd, "\n95th gpu percentile: %ums", findGPUPercentile(95));
+    dprintf(fd, "\n99th gpu percentile: %ums", findGPUPercentile(99));
+    dprintf(fd, "\nGPU HISTOGRAM:");
+    histogramGPUForEach([fd](HistogramEntry entry) {
+        dprintf(fd, " %ums=%u", entry.renderTimeMs, entry.frameCount);
+    });
 }
 
 uint32_t ProfileData::findPercentile(int percentile) const {
@@ -143,10 +155,27 @@ uint32_t ProfileData::findPercentile(int percentile) const {
     return 0;
 }
 
+uint32_t ProfileData::findGPUPercentile(int percentile) const {
+    uint32_t totalGPUFrameCount = 0;
+    for (uint32_t count : mGPUFrameCounts) {
+        totalGPUFrameCount += count;
+    }
+    int pos = percentile * totalGPUFrameCount / 100;
+    int remaining = totalGPUFrameCount - pos;
+    for (int i = mGPUFrameCounts.size() - 1; i >= 0; i--) {
+        remaining -= mGPUFrameCounts[i];
+        if (remaining <= 0) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
 void ProfileData::reset() {
     mJankTypeCounts.fill(0);
     mFrameCounts.fill(0);
     mSlowFrameCounts.fill(0);
+    mGPUFrameCounts.fill(0);
     mTotalFrameCount = 0;
     mJankFrameCount = 0;
     mStatStartTime = systemTime(CLOCK_MONOTONIC);
@@ -164,6 +193,19 @@ void ProfileData::reportFrame(int64_t duration) {
     }
 }
 
+void ProfileData::reportGPUFrame(int64_t duration) {
+    uint32_t index = static_cast<uint32_t>(ns2ms(duration));
+    index = std::min(index, static_cast<uint32_t>(mGPUFrameCounts.size() - 1));
+    mGPUFrameCounts[index]++;
+}
+
+void ProfileData::histogramGPUForEach(
+        const std::function<void(HistogramEntry)>& callback) const {
+    for (size_t i = 0; i < mGPUFrameCounts.size(); i++) {
+        callback(HistogramEntry{static_cast<uint32_t>(i + 1), mGPUFrameCounts[i]});
+    }
+}
+
 void ProfileData::histogramForEach(const std::function<void(HistogramEntry)>& callback) const {
     for (size_t i = 0; i < mFrameCounts.size(); i++) {
         callback(HistogramEntry{frameTimeForFrameCountIndex(i), mFrameCounts[i]});
@@ -53,10 +53,12 @@ public:
     void mergeWith(const ProfileData& other);
     void dump(int fd) const;
     uint32_t findPercentile(int percentile) const;
+    uint32_t findGPUPercentile(int percentile) const;
 
     void reportFrame(int64_t duration);
     void reportJank() { mJankFrameCount++; }
     void reportJankType(JankType type) { mJankTypeCounts[static_cast<int>(type)]++; }
+    void reportGPUFrame(int64_t duration);
 
     uint32_t totalFrameCount() const { return mTotalFrameCount; }
     uint32_t jankFrameCount() const { return mJankFrameCount; }
@@ -74,6 +76,8 @@ public:
                 + std::tuple_size<decltype(ProfileData::mSlowFrameCounts)>::value;
     }
 
+    void histogramGPUForEach(const std::function<void(HistogramEntry)>& callback) const;
+
     // Visible for testing
     static uint32_t frameTimeForFrameCountIndex(uint32_t index);
     static uint32_t frameTimeForSlowFrameCountIndex(uint32_t index);
@@ -87,6 +91,9 @@ private:
     std::array<uint32_t, 57> mFrameCounts;
     // Holds a histogram of frame times in 50ms increments from 150ms to 5s
     std::array<uint16_t, 97> mSlowFrameCounts;
+    // Holds a histogram of GPU frame times in 1ms increments, the last bucket counting every
+    // frame of 25ms or more
+    std::array<uint32_t, 25> mGPUFrameCounts;
 
     uint32_t mTotalFrameCount;
     uint32_t mJankFrameCount;
@@ -99,6 +106,7 @@ public:
     std::array<uint32_t, NUM_BUCKETS>& editJankTypeCounts() { return mJankTypeCounts; }
     std::array<uint32_t, 57>& editFrameCounts() { return mFrameCounts; }
     std::array<uint16_t, 97>& editSlowFrameCounts() { return mSlowFrameCounts; }
+    std::array<uint32_t, 25>& editGPUFrameCounts() { return mGPUFrameCounts; }
     uint32_t& editTotalFrameCount() { return mTotalFrameCount; }
     uint32_t& editJankFrameCount() { return mJankFrameCount; }
     nsecs_t& editStatStartTime() { return mStatStartTime; }
@@ -301,6 +301,56 @@ struct ProgramDescription {
         return key;
     }
 
+    /**
+     * Sets up this description from a key computed by key(). Fields that are not part of the
+     * key, because they don't change the generated program, keep their default values.
+     */
+    void setFromKey(programid key) {
+        reset();
+        hasTexture = key & PROGRAM_KEY_TEXTURE;
+        hasAlpha8Texture = key & PROGRAM_KEY_A8_TEXTURE;
+        hasBitmap = key & PROGRAM_KEY_BITMAP;
+        if (hasBitmap) {
+            useShaderBasedWrap = key & PROGRAM_KEY_BITMAP_NPOT;
+            if (useShaderBasedWrap) {
+                bitmapWrapS = getWrapForEnum(
+                        (key & PROGRAM_KEY_BITMAP_WRAPS_MASK) >> PROGRAM_BITMAP_WRAPS_SHIFT);
+                bitmapWrapT = getWrapForEnum(
+                        (key & PROGRAM_KEY_BITMAP_WRAPT_MASK) >> PROGRAM_BITMAP_WRAPT_SHIFT);
+            }
+            isShaderBitmapExternal = key & PROGRAM_KEY_BITMAP_EXTERNAL;
+        }
+        hasGradient = key & PROGRAM_KEY_GRADIENT;
+        gradientType = Gradient((key >> PROGRAM_GRADIENT_TYPE_SHIFT) & 0x3);
+        isBitmapFirst = key & PROGRAM_KEY_BITMAP_FIRST;
+        if (hasBitmap && hasGradient) {
+            shadersMode = SkBlendMode((key >> PROGRAM_XFERMODE_SHADER_SHIFT) & PROGRAM_MAX_XFERMODE);
+        }
+        if (key & PROGRAM_KEY_COLOR_MATRIX) {
+            colorOp = ColorFilterMode::Matrix;
+        } else if (key & PROGRAM_KEY_COLOR_BLEND) {
+            colorOp = ColorFilterMode::Blend;
+            colorMode = SkBlendMode((key >> PROGRAM_XFERMODE_COLOR_OP_SHIFT) & PROGRAM_MAX_XFERMODE);
+        }
+        framebufferMode = SkBlendMode(
+                (key >> PROGRAM_XFERMODE_FRAMEBUFFER_SHIFT) & PROGRAM_MAX_XFERMODE);
+        swapSrcDst = (key >> PROGRAM_KEY_SWAP_SRC_DST_SHIFT) & 0x1;
+        modulate = (key >> PROGRAM_MODULATE_SHIFT) & 0x1;
+        hasVertexAlpha = (key >> PROGRAM_HAS_VERTEX_ALPHA_SHIFT) & 0x1;
+        useShadowAlphaInterp = (key >> PROGRAM_USE_SHADOW_ALPHA_INTERP_SHIFT) & 0x1;
+        hasExternalTexture = (key >> PROGRAM_HAS_EXTERNAL_TEXTURE_SHIFT) & 0x1;
+        hasTextureTransform = (key >> PROGRAM_HAS_TEXTURE_TRANSFORM_SHIFT) & 0x1;
+        isSimpleGradient = (key >> PROGRAM_IS_SIMPLE_GRADIENT) & 0x1;
+        hasColors = (key >> PROGRAM_HAS_COLORS) & 0x1;
+        hasDebugHighlight = (key >> PROGRAM_HAS_DEBUG_HIGHLIGHT) & 0x1;
+        hasRoundRectClip = (key >> PROGRAM_HAS_ROUND_RECT_CLIP) & 0x1;
+        hasGammaCorrection = (key >> PROGRAM_HAS_GAMMA_CORRECTION) & 0x1;
+        hasLinearTexture = (key >> PROGRAM_HAS_LINEAR_TEXTURE) & 0x1;
+        hasColorSpaceConversion = (key >> PROGRAM_HAS_COLOR_SPACE_CONVERSION) & 0x1;
+        transferFunction = TransferFunctionType((key >> PROGRAM_TRANSFER_FUNCTION) & 0x3);
+        hasTranslucentConversion = (key >> PROGRAM_HAS_TRANSLUCENT_CONVERSION) & 0x1;
+    }
+
     /**
      * Logs the specified message followed by the key identifying this program.
      */
@@ -325,6 +375,16 @@ private:
         return 0;
     }
 
+    static inline GLenum getWrapForEnum(programid wrap) {
+        switch (wrap) {
+            case 1:
+                return GL_REPEAT;
+            case 2:
+                return GL_MIRRORED_REPEAT;
+        }
+        return GL_CLAMP_TO_EDGE;
+    }
+
 }; // struct ProgramDescription
 
 /**
@@ -18,6 +18,7 @@
 
 #include "Caches.h"
 #include "ProgramCache.h"
+#include "ProgramProfile.h"
 #include "Properties.h"
 
 namespace android {
@@ -521,6 +522,8 @@ ProgramCache::~ProgramCache() {
 void ProgramCache::clear() {
     PROGRAM_LOGD("Clearing program cache");
     mCache.clear();
+    std::lock_guard<std::mutex> lock(mPrecachedLock);
+    mPrecached.clear();
 }
 
 Program* ProgramCache::get(const ProgramDescription& description) {
@@ -534,15 +537,42 @@ Program* ProgramCache::get(const ProgramDescription& description) {
     auto iter = mCache.find(key);
     Program* program = nullptr;
     if (iter == mCache.end()) {
+        std::unique_lock<std::mutex> lock(mPrecachedLock);
+        auto precached = mPrecached.find(key);
+        if (precached != mPrecached.end()) {
+            program = precached->second.get();
+            mCache[key] = std::move(precached->second);
+            mPrecached.erase(precached);
+            return program;
+        }
+        lock.unlock();
+
         description.log("Could not find program");
         program = generateProgram(description, key);
         mCache[key] = std::unique_ptr<Program>(program);
+        if (Properties::programWarmup) {
+            ProgramProfile::get().record(key);
+        }
     } else {
         program = iter->second.get();
     }
     return program;
 }
 
+void ProgramCache::precache(programid key) {
+    {
+        std::lock_guard<std::mutex> lock(mPrecachedLock);
+        if (mPrecached.find(key) != mPrecached.end()) return;
+    }
+
+    ProgramDescription description;
+    description.setFromKey(key);
+    std::unique_ptr<Program> program(generateProgram(description, key));
+
+    std::lock_guard<std::mutex> lock(mPrecachedLock);
+    mPrecached[key] = std::move(program);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Program generation
 ///////////////////////////////////////////////////////////////////////////////
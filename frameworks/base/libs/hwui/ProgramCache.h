@@ -21,6 +21,7 @@
 #include <utils/Log.h>
 #include <utils/String8.h>
 #include <map>
+#include <mutex>
 
 #include <GLES2/gl2.h>
 
@@ -47,6 +48,13 @@ public:
 
     void clear();
 
+    /**
+     * Compiles the program for the given key ahead of its first use. Meant to be called with
+     * a context sharing objects with the one the cache is used on; the program is only handed
+     * to get() once linked, so this may run on another thread.
+     */
+    void precache(programid key);
+
 private:
     Program* generateProgram(const ProgramDescription& description, programid key);
     String8 generateVertexShader(const ProgramDescription& description);
@@ -58,6 +66,10 @@ private:
 
     std::map<programid, std::unique_ptr<Program>> mCache;
 
+    // Programs compiled by precache(), moved into mCache on their first use
+    std::map<programid, std::unique_ptr<Program>> mPrecached;
+    std::mutex mPrecachedLock;
+
     const bool mHasES3;
     const bool mHasLinearBlending;
 }; // class ProgramCache
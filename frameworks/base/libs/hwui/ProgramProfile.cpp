@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ProgramProfile.h"
+
+#include <algorithm>
+#include <cutils/properties.h>
+#include <errno.h>
+#include <log/log.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+
+namespace android {
+namespace uirenderer {
+
+// Seconds to wait after a new key before saving, so that the keys of a frame are written at once
+static const unsigned int kDeferredSaveDelay = 4;
+// Upper bound on the keys loaded, well above what apps use, in case of a corrupted file
+static const uint32_t kMaxKeyCount = 1024;
+
+static const uint32_t kProfileMagic = 0x50575548; // "HUWP"
+
+struct ProfileHeader {
+    uint32_t magic;
+    uint32_t keyCount;
+    char buildFingerprint[PROPERTY_VALUE_MAX];
+};
+
+static void getBuildFingerprint(char* fingerprint) {
+    memset(fingerprint, 0, PROPERTY_VALUE_MAX);
+    property_get("ro.build.fingerprint", fingerprint, "");
+}
+
+ProgramProfile& ProgramProfile::get() {
+    static ProgramProfile sProfile;
+    return sProfile;
+}
+
+void ProgramProfile::setFilename(const char* filename) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mFilename = filename;
+}
+
+std::vector<programid> ProgramProfile::load() {
+    std::lock_guard<std::mutex> lock(mLock);
+    loadLocked();
+    return std::vector<programid>(mKeys.begin(), mKeys.end());
+}
+
+void ProgramProfile::record(programid key) {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mFilename.empty()) return;
+    loadLocked();
+    if (!mKeys.insert(key).second || mSavePending) return;
+
+    mSavePending = true;
+    std::thread deferredSaveThread([this]() {
+        sleep(kDeferredSaveDelay);
+        std::lock_guard<std::mutex> lock(mLock);
+        saveLocked();
+        mSavePending = false;
+    });
+    deferredSaveThread.detach();
+}
+
+void ProgramProfile::loadLocked() {
+    if (mLoaded || mFilename.empty()) return;
+    mLoaded = true;
+
+    FILE* file = fopen(mFilename.c_str(), "rb");
+    if (!file) return;
+
+    ProfileHeader header;
+    char fingerprint[PROPERTY_VALUE_MAX];
+    getBuildFingerprint(fingerprint);
+    if (fread(&header, sizeof(header), 1, file) != 1
+            || header.magic != kProfileMagic
+            || header.keyCount > kMaxKeyCount
+            || memcmp(header.buildFingerprint, fingerprint, PROPERTY_VALUE_MAX)) {
+        ALOGD("Ignoring program profile %s", mFilename.c_str());
+        fclose(file);
+        return;
+    }
+    std::vector<programid> keys(header.keyCount);
+    if (fread(keys.data(), sizeof(programid), keys.size(), file) == keys.size()) {
+        mKeys.insert(keys.begin(), keys.end());
+    }
+    fclose(file);
+}
+
+void ProgramProfile::saveLocked() {
+    if (mFilename.empty()) return;
+
+    // Write to a temporary file first so that a reader never sees a partial profile
+    std::string tempFilename = mFilename + ".tmp";
+    FILE* file = fopen(tempFilename.c_str(), "wb");
+    if (!file) {
+        ALOGW("Failed to write program profile %s: %s", tempFilename.c_str(), strerror(errno));
+        return;
+    }
+
+    ProfileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = kProfileMagic;
+    header.keyCount = std::min(static_cast<uint32_t>(mKeys.size()), kMaxKeyCount);
+    getBuildFingerprint(header.buildFingerprint);
+    std::vector<programid> keys(mKeys.begin(), mKeys.end());
+    keys.resize(header.keyCount);
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(keys.data(), sizeof(programid), keys.size(), file) == keys.size();
+    success = fclose(file) == 0 && success;
+    if (!success || rename(tempFilename.c_str(), mFilename.c_str())) {
+        ALOGW("Failed to write program profile %s", mFilename.c_str());
+        unlink(tempFilename.c_str());
+    }
+}
+
+}; // namespace uirenderer
+}; // namespace android
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "Program.h"
+
+#include <cutils/compiler.h>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace android {
+namespace uirenderer {
+
+/**
+ * Remembers the keys of the programs an app used, from one run to the next, so that the
+ * programs can be compiled before the first frames that need them.
+ *
+ * The profile is kept in a per-app file, written a few seconds after a new program has been
+ * recorded. A profile written by another build is ignored, since the keys may not describe the
+ * same programs anymore.
+ */
+class ProgramProfile {
+public:
+    /**
+     * Returns the singleton ProgramProfile. This object is never destroyed.
+     */
+    ANDROID_API static ProgramProfile& get();
+
+    /**
+     * Sets the file the profile is loaded from and saved to. Nothing is recorded until it is set.
+     */
+    ANDROID_API void setFilename(const char* filename);
+
+    /**
+     * Returns the keys recorded by previous runs, and starts recording from them.
+     */
+    std::vector<programid> load();
+
+    /**
+     * Adds a key to the profile, and schedules the profile to be saved if it is new.
+     */
+    void record(programid key);
+
+private:
+    ProgramProfile() {}
+
+    void loadLocked();
+    void saveLocked();
+
+    std::string mFilename;
+    std::set<programid> mKeys;
+    bool mLoaded = false;
+    bool mSavePending = false;
+    std::mutex mLock;
+};
+
+}; // namespace uirenderer
+}; // namespace android
@@ -35,6 +35,11 @@ bool Properties::showDirtyRegions = false;
 bool Properties::skipEmptyFrames = true;
 bool Properties::useBufferAge = true;
 bool Properties::enablePartialUpdates = true;
+bool Properties::programWarmup = false;
+bool Properties::dropLateFrames = false;
+bool Properties::prefetchGlyphs = false;
+bool Properties::skipCleanSubtrees = true;
+bool Properties::validateCleanSubtrees = false;
 
 float Properties::textGamma = DEFAULT_TEXT_GAMMA;
 
@@ -146,6 +151,11 @@ bool Properties::load() {
     skipEmptyFrames = property_get_bool(PROPERTY_SKIP_EMPTY_DAMAGE, true);
     useBufferAge = property_get_bool(PROPERTY_USE_BUFFER_AGE, true);
     enablePartialUpdates = property_get_bool(PROPERTY_ENABLE_PARTIAL_UPDATES, true);
+    programWarmup = property_get_bool(PROPERTY_PROGRAM_WARMUP, false);
+    dropLateFrames = property_get_bool(PROPERTY_DROP_LATE_FRAMES, false);
+    prefetchGlyphs = property_get_bool(PROPERTY_PREFETCH_GLYPHS, false);
+    skipCleanSubtrees = property_get_bool(PROPERTY_SKIP_CLEAN_SUBTREES, true);
+    validateCleanSubtrees = property_get_bool(PROPERTY_VALIDATE_CLEAN_SUBTREES, false);
 
     textGamma = property_get_float(PROPERTY_TEXT_GAMMA, DEFAULT_TEXT_GAMMA);
 
@@ -150,6 +150,40 @@ enum DebugLevel {
  */
 #define PROPERTY_ENABLE_PARTIAL_UPDATES "debug.hwui.use_partial_updates"
 
+/**
+ * Setting this to "true" records the programs used by each app, and compiles them on a
+ * background context when the next run of the app creates its EGL context.
+ * Only used by the OpenGL pipeline. Default is "false"
+ */
+#define PROPERTY_PROGRAM_WARMUP "debug.hwui.program_warmup"
+
+/**
+ * Setting this to "true" lets the RenderThread drop a frame when the recent draw times say it
+ * would complete more than a frame interval after its vsync, so that the next vsync's frame
+ * starts with a drained buffer queue. Default is "false"
+ */
+#define PROPERTY_DROP_LATE_FRAMES "debug.hwui.drop_late_frames"
+
+/**
+ * Setting this to "true" rasterizes the glyphs of recorded text on background workers, so
+ * that the RenderThread only has to upload them. Only used by the OpenGL pipeline.
+ * Default is "false"
+ */
+#define PROPERTY_PREFETCH_GLYPHS "debug.hwui.prefetch_glyphs"
+
+/**
+ * Setting this to "false" makes prepareTree visit every RenderNode, instead of skipping the
+ * subtrees that have nothing to sync, animate or damage since they were last prepared.
+ * Default is "true"
+ */
+#define PROPERTY_SKIP_CLEAN_SUBTREES "debug.hwui.skip_clean_subtrees"
+
+/**
+ * Setting this to "true" makes prepareTree still visit the subtrees it would skip, and abort
+ * if one of them turns out to have produced damage. Default is "false"
+ */
+#define PROPERTY_VALIDATE_CLEAN_SUBTREES "debug.hwui.validate_clean_subtrees"
+
 #define PROPERTY_FILTER_TEST_OVERHEAD "debug.hwui.filter_test_overhead"
 
 /**
@@ -278,6 +312,11 @@ public:
     static bool skipEmptyFrames;
     static bool useBufferAge;
     static bool enablePartialUpdates;
+    static bool programWarmup;
+    static bool dropLateFrames;
+    static bool prefetchGlyphs;
+    static bool skipCleanSubtrees;
+    static bool validateCleanSubtrees;
 
     static float textGamma;
 
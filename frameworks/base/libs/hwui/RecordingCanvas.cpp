@@ -17,9 +17,11 @@
 #include "RecordingCanvas.h"
 
 #include "DeferredLayerUpdater.h"
+#include "Properties.h"
 #include "RecordedOp.h"
 #include "RenderNode.h"
 #include "VectorDrawable.h"
+#include "font/GlyphPrefetcher.h"
 #include "hwui/MinikinUtils.h"
 
 namespace android {
@@ -548,6 +550,12 @@ void RecordingCanvas::drawGlyphs(ReadGlyphFunc glyphFunc, int glyphCount, const
     float* positions = (float*)alloc().alloc<float>(2 * glyphCount * sizeof(float));
     glyphFunc(glyphs, positions);
 
+    if (Properties::prefetchGlyphs) {
+        // Shaping is done, start rasterizing while the rest of the frame is recorded
+        GlyphPrefetcher::get().prefetch(paint, glyphs, glyphCount,
+                *(mState.currentSnapshot()->transform));
+    }
+
     // TODO: either must account for text shadow in bounds, or record separate ops for text shadows
     addOp(alloc().create_trivial<TextOp>(
             Rect(boundsLeft, boundsTop, boundsRight, boundsBottom),
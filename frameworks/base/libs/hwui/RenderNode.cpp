@@ -53,6 +53,8 @@ private:
     TreeInfo* mTreeInfo;
 };
 
+std::atomic<uint32_t> RenderNode::sStagingGeneration(1);
+
 RenderNode::RenderNode()
         : mDirtyPropertyFields(0)
         , mNeedsDisplayListSync(false)
@@ -72,6 +74,7 @@ RenderNode::~RenderNode() {
 void RenderNode::setStagingDisplayList(DisplayList* displayList) {
     mValid = (displayList != nullptr);
     mNeedsDisplayListSync = true;
+    sStagingGeneration++;
     delete mStagingDisplayList;
     mStagingDisplayList = displayList;
 }
@@ -196,15 +199,18 @@ void RenderNode::prepareTree(TreeInfo& info) {
     // will need to be drawn in a layer.
     bool functorsNeedLayer = Properties::debugOverdraw && !Properties::isSkiaEnabled();
 
+    info.stagingGeneration = sStagingGeneration.load();
     prepareTreeImpl(observer, info, functorsNeedLayer);
 }
 
 void RenderNode::addAnimator(const sp<BaseRenderNodeAnimator>& animator) {
     mAnimatorManager.addAnimator(animator);
+    sStagingGeneration++;
 }
 
 void RenderNode::removeAnimator(const sp<BaseRenderNodeAnimator>& animator) {
     mAnimatorManager.removeAnimator(animator);
+    sStagingGeneration++;
 }
 
 void RenderNode::damageSelf(TreeInfo& info) {
@@ -279,6 +285,45 @@ void RenderNode::pushLayerUpdate(TreeInfo& info) {
     info.canvasContext.markLayerInUse(this);
 }
 
+/**
+ * A subtree can be skipped if nothing was staged anywhere since it was last synced, and none
+ * of its nodes has work that prepareTree() must redo every frame: animators, layers, functors,
+ * position listeners, images to pin, VectorDrawables or projection.
+ */
+bool RenderNode::isSubtreeClean(const TreeInfo& info, bool functorsNeedLayer) const {
+    return Properties::skipCleanSubtrees
+            && mSubtreeClean
+            && mPreparedGeneration == info.stagingGeneration
+            && mPreparedFunctorsNeedLayer == functorsNeedLayer;
+}
+
+bool RenderNode::needsPrepareEachFrame() {
+    return mDirtyPropertyFields
+            || mNeedsDisplayListSync
+            || mAnimatorManager.hasAnimators()
+            || mPositionListener.get()
+            || hasLayer()
+            || properties().effectiveLayerType() == LayerType::RenderLayer
+            || properties().getProjectBackwards()
+            || (mDisplayList && mDisplayList->needsPrepareEachFrame());
+}
+
+void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer) {
+    if (!isSubtreeClean(info, functorsNeedLayer)) {
+        prepareSubtree(observer, info, functorsNeedLayer);
+        return;
+    }
+    if (CC_UNLIKELY(Properties::validateCleanSubtrees)) {
+        SkRect before;
+        SkRect after;
+        info.damageAccumulator->peekAtDirty(&before);
+        prepareSubtree(observer, info, functorsNeedLayer);
+        info.damageAccumulator->peekAtDirty(&after);
+        LOG_ALWAYS_FATAL_IF(before != after || !mSubtreeClean,
+                "Skippable subtree %s (%p) was not clean", getName(), this);
+    }
+}
+
 /**
  * Traverse down the the draw tree to prepare for a frame.
  *
@@ -287,7 +332,7 @@ void RenderNode::pushLayerUpdate(TreeInfo& info) {
  * While traversing down the tree, functorsNeedLayer flag is set to true if anything that uses the
  * stencil buffer may be needed. Views that use a functor to draw will be forced onto a layer.
  */
-void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer) {
+void RenderNode::prepareSubtree(TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer) {
     info.damageAccumulator->pushTransform(this);
 
     if (info.mode == TreeInfo::MODE_FULL) {
@@ -316,11 +361,14 @@ void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool fu
         pushStagingDisplayListChanges(observer, info);
     }
 
+    bool childrenClean = true;
     if (mDisplayList) {
         info.out.hasFunctors |= mDisplayList->hasFunctor();
         bool isDirty = mDisplayList->prepareListAndChildren(observer, info, childFunctorsNeedLayer,
-                [](RenderNode* child, TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer) {
+                [&childrenClean](RenderNode* child, TreeObserver& observer, TreeInfo& info,
+                        bool functorsNeedLayer) {
             child->prepareTreeImpl(observer, info, functorsNeedLayer);
+            childrenClean &= child->mSubtreeClean;
         });
         if (isDirty) {
             damageSelf(info);
@@ -329,6 +377,13 @@ void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool fu
     pushLayerUpdate(info);
 
     info.damageAccumulator->popTransform();
+
+    mSubtreeClean = childrenClean && !needsPrepareEachFrame();
+    mPreparedFunctorsNeedLayer = functorsNeedLayer;
+    // Only a MODE_FULL traversal consumes what the UI thread staged
+    if (info.mode == TreeInfo::MODE_FULL) {
+        mPreparedGeneration = info.stagingGeneration;
+    }
 }
 
 void RenderNode::syncProperties() {
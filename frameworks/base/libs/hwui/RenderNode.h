@@ -36,6 +36,7 @@
 #include "pipeline/skia/SkiaLayer.h"
 #include "utils/FatVector.h"
 
+#include <atomic>
 #include <vector>
 
 class SkBitmap;
@@ -147,6 +148,7 @@ public:
 
     void setPropertyFieldsDirty(uint32_t fields) {
         mDirtyPropertyFields |= fields;
+        sStagingGeneration++;
     }
 
     const RenderProperties& properties() const {
@@ -230,6 +232,7 @@ public:
     // RenderNode takes ownership of the pointer
     ANDROID_API void setPositionListener(PositionListener* listener) {
         mPositionListener = listener;
+        sStagingGeneration++;
     }
 
     // This is only modified in MODE_FULL, so it can be safely accessed
@@ -259,6 +262,9 @@ private:
     void syncDisplayList(TreeObserver& observer, TreeInfo* info);
 
     void prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer);
+    void prepareSubtree(TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer);
+    bool isSubtreeClean(const TreeInfo& info, bool functorsNeedLayer) const;
+    bool needsPrepareEachFrame();
     void pushStagingPropertiesChanges(TreeInfo& info);
     void pushStagingDisplayListChanges(TreeObserver& observer, TreeInfo& info);
     void prepareLayer(TreeInfo& info, uint32_t dirtyMask);
@@ -309,6 +315,18 @@ private:
 
     sp<PositionListener> mPositionListener;
 
+    // Bumped by every staging change to any RenderNode. RenderNodes don't know their parents,
+    // so a change anywhere in the tree keeps every subtree from being skipped by the next
+    // prepareTree().
+    static std::atomic<uint32_t> sStagingGeneration;
+
+    // Owned by RT. Staging generation of the last MODE_FULL prepareTree() that visited this
+    // node, and whether nothing in the subtree needed work at its last visit. A clean subtree
+    // prepared at the current generation is skipped, as it can neither sync nor damage.
+    uint32_t mPreparedGeneration = 0;
+    bool mSubtreeClean = false;
+    bool mPreparedFunctorsNeedLayer = false;
+
 // METHODS & FIELDS ONLY USED BY THE SKIA RENDERER
 public:
     /**
@@ -116,6 +116,56 @@ hash_t TessellationCache::ShadowDescription::hash() const {
     return JenkinsHashWhiten(hash);
 }
 
+TessellationCache::ShadowContentDescription::ShadowContentDescription()
+        : opaque(false)
+        , lightCenter{0, 0, 0}
+        , lightRadius(0) {
+}
+
+TessellationCache::ShadowContentDescription::ShadowContentDescription(
+        const Matrix4* drawTransform, const Rect& localClip, bool opaque,
+        const SkPath* casterPerimeter, const Matrix4* transformXY, const Matrix4* transformZ,
+        const Vector3& lightCenter, float lightRadius)
+        : drawTransform(*drawTransform)
+        , localClip(localClip)
+        , opaque(opaque)
+        , casterPerimeter(*casterPerimeter)
+        , transformXY(*transformXY)
+        , transformZ(*transformZ)
+        , lightCenter(lightCenter)
+        , lightRadius(lightRadius) {
+}
+
+bool TessellationCache::ShadowContentDescription::operator==(
+        const TessellationCache::ShadowContentDescription& rhs) const {
+    return opaque == rhs.opaque
+            && lightRadius == rhs.lightRadius
+            && lightCenter.x == rhs.lightCenter.x
+            && lightCenter.y == rhs.lightCenter.y
+            && lightCenter.z == rhs.lightCenter.z
+            && localClip == rhs.localClip
+            && memcmp(drawTransform.data, rhs.drawTransform.data, sizeof(drawTransform.data)) == 0
+            && memcmp(transformXY.data, rhs.transformXY.data, sizeof(transformXY.data)) == 0
+            && memcmp(transformZ.data, rhs.transformZ.data, sizeof(transformZ.data)) == 0
+            && casterPerimeter == rhs.casterPerimeter;
+}
+
+hash_t TessellationCache::ShadowContentDescription::hash() const {
+    // the path's bounds and point count stand in for its contents, compared in operator==
+    SkRect pathBounds = casterPerimeter.getBounds();
+    int pathPoints = casterPerimeter.countPoints();
+    uint32_t hash = JenkinsHashMixBytes(0, (uint8_t*) &pathBounds, sizeof(pathBounds));
+    hash = JenkinsHashMix(hash, pathPoints);
+    hash = JenkinsHashMix(hash, opaque);
+    hash = JenkinsHashMixBytes(hash, (uint8_t*) &localClip, sizeof(localClip));
+    hash = JenkinsHashMixBytes(hash, (uint8_t*) drawTransform.data, sizeof(drawTransform.data));
+    hash = JenkinsHashMixBytes(hash, (uint8_t*) transformXY.data, sizeof(transformXY.data));
+    hash = JenkinsHashMixBytes(hash, (uint8_t*) transformZ.data, sizeof(transformZ.data));
+    hash = JenkinsHashMixBytes(hash, (uint8_t*) &lightCenter, sizeof(lightCenter));
+    hash = JenkinsHashMixBytes(hash, (uint8_t*) &lightRadius, sizeof(lightRadius));
+    return JenkinsHashWhiten(hash);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // General purpose tessellation task processing
 ///////////////////////////////////////////////////////////////////////////////
@@ -269,8 +319,11 @@ void tessellateShadows(
 
 class ShadowProcessor : public TaskProcessor<TessellationCache::vertexBuffer_pair_t> {
 public:
+    // Shadows are the most expensive tessellations and the frame waits on
+    // them, so they go ahead of the other precaching tasks
     explicit ShadowProcessor(Caches& caches)
-            : TaskProcessor<TessellationCache::vertexBuffer_pair_t>(&caches.tasks) {}
+            : TaskProcessor<TessellationCache::vertexBuffer_pair_t>(&caches.tasks,
+                    TaskManager::Priority::High) {}
     ~ShadowProcessor() {}
 
     virtual void onProcess(const sp<Task<TessellationCache::vertexBuffer_pair_t> >& task) override {
@@ -289,12 +342,17 @@ public:
 // Cache constructor/destructor
 ///////////////////////////////////////////////////////////////////////////////
 
+// Shadows of the most recent casters, kept across frames
+#define MAX_RETAINED_SHADOWS 64
+
 TessellationCache::TessellationCache()
         : mMaxSize(Properties::tessellationCacheSize)
         , mCache(LruCache<Description, Buffer*>::kUnlimitedCapacity)
-        , mShadowCache(LruCache<ShadowDescription, Task<vertexBuffer_pair_t*>*>::kUnlimitedCapacity) {
+        , mShadowCache(LruCache<ShadowDescription, Task<vertexBuffer_pair_t*>*>::kUnlimitedCapacity)
+        , mRetainedShadowCache(MAX_RETAINED_SHADOWS) {
     mCache.setOnEntryRemovedListener(&mBufferRemovedListener);
     mShadowCache.setOnEntryRemovedListener(&mBufferPairRemovedListener);
+    mRetainedShadowCache.setOnEntryRemovedListener(&mRetainedBufferPairRemovedListener);
     mDebugEnabled = Properties::debugLevel & kDebugCaches;
 }
 
@@ -336,6 +394,7 @@ void TessellationCache::trim() {
 void TessellationCache::clear() {
     mCache.clear();
     mShadowCache.clear();
+    mRetainedShadowCache.clear();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -358,6 +417,18 @@ void TessellationCache::precacheShadows(const Matrix4* drawTransform, const Rect
     ShadowDescription key(casterPerimeter, drawTransform);
 
     if (mShadowCache.get(key)) return;
+
+    // A caster that hasn't moved relative to the light since a previous frame casts the same
+    // shadow, so its buffers don't need to be tessellated again.
+    ShadowContentDescription content(drawTransform, localClip, opaque, casterPerimeter,
+            transformXY, transformZ, lightCenter, lightRadius);
+    Task<vertexBuffer_pair_t>* retainedTask = mRetainedShadowCache.get(content);
+    if (retainedTask) {
+        retainedTask->incStrong(nullptr);
+        mShadowCache.put(key, retainedTask);
+        return;
+    }
+
     sp<ShadowTask> task = new ShadowTask(drawTransform, localClip, opaque,
             casterPerimeter, transformXY, transformZ, lightCenter, lightRadius);
     if (mShadowProcessor == nullptr) {
@@ -366,6 +437,8 @@ void TessellationCache::precacheShadows(const Matrix4* drawTransform, const Rect
     mShadowProcessor->add(task);
     task->incStrong(nullptr); // not using sp<>s, so manually ref while in the cache
     mShadowCache.put(key, task.get());
+    task->incStrong(nullptr);
+    mRetainedShadowCache.put(content, task.get());
 }
 
 sp<TessellationCache::ShadowTask> TessellationCache::getShadowTask(
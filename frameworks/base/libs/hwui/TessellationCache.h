@@ -87,6 +87,27 @@ public:
         ShadowDescription(const SkPath* nodeKey, const Matrix4* drawTransform);
     };
 
+    /* ShadowDescription keys on a path pointer, which may be frame allocated, so it can only
+     * be trusted within a frame. This holds a copy of every input of the tessellation instead,
+     * so that a later frame drawing the exact same shadow can reuse the vertex buffers.
+     */
+    struct ShadowContentDescription {
+        HASHABLE_TYPE(ShadowContentDescription);
+        Matrix4 drawTransform;
+        Rect localClip;
+        bool opaque;
+        SkPath casterPerimeter;
+        Matrix4 transformXY;
+        Matrix4 transformZ;
+        Vector3 lightCenter;
+        float lightRadius;
+
+        ShadowContentDescription();
+        ShadowContentDescription(const Matrix4* drawTransform, const Rect& localClip,
+                bool opaque, const SkPath* casterPerimeter, const Matrix4* transformXY,
+                const Matrix4* transformZ, const Vector3& lightCenter, float lightRadius);
+    };
+
     class ShadowTask : public Task<vertexBuffer_pair_t> {
     public:
         ShadowTask(const Matrix4* drawTransform, const Rect& localClip, bool opaque,
@@ -214,6 +235,17 @@ private:
     };
     BufferPairRemovedListener mBufferPairRemovedListener;
 
+    // holds a strong ref to the most recent shadow tasks, across frames
+    LruCache<ShadowContentDescription, Task<vertexBuffer_pair_t>*> mRetainedShadowCache;
+    class RetainedBufferPairRemovedListener
+            : public OnEntryRemoved<ShadowContentDescription, Task<vertexBuffer_pair_t>*> {
+        void operator()(ShadowContentDescription& description,
+                Task<vertexBuffer_pair_t>*& bufferPairTask) override {
+            bufferPairTask->decStrong(nullptr);
+        }
+    };
+    RetainedBufferPairRemovedListener mRetainedBufferPairRemovedListener;
+
 }; // class TessellationCache
 
 void tessellateShadows(
@@ -162,10 +162,21 @@ static void uploadToTexture(bool resize, GLint internalFormat, GLenum format, GL
             glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
         }
 
+        // Stage large uploads through a pixel unpack buffer so the driver
+        // can perform the transfer asynchronously
+        Caches& caches = Caches::getInstance();
+        const bool staged = caches.gpuPixelBuffersEnabled
+                && caches.pixelBufferRing().beginUpload(data, stride * bpp * height);
+        const GLvoid* pixels = staged ? nullptr : data;
+
         if (resize) {
-            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, data);
+            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, pixels);
         } else {
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, data);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, pixels);
+        }
+
+        if (staged) {
+            caches.pixelBufferRing().endUpload();
         }
 
         if (useStride) {
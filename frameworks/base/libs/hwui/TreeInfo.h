@@ -93,6 +93,9 @@ public:
 
     bool updateWindowPositions = false;
 
+    // RenderNode staging generation read at the start of the traversal
+    uint32_t stagingGeneration = 0;
+
     struct Out {
         bool hasFunctors = false;
         // This is only updated if evaluateAnimations is true
@@ -104,25 +104,27 @@ static void applyTrim(SkPath* outPath, const SkPath& inPath, float trimPathStart
 }
 
 const SkPath& FullPath::getUpdatedPath(bool useStagingData, SkPath* tempStagingPath) {
-    if (!useStagingData && !mSkPathDirty && !mProperties.mTrimDirty) {
-        return mTrimmedSkPath;
-    }
-    Path::getUpdatedPath(useStagingData, tempStagingPath);
     SkPath *outPath;
     if (useStagingData) {
+        Path::getUpdatedPath(useStagingData, tempStagingPath);
         SkPath inPath = *tempStagingPath;
         applyTrim(tempStagingPath, inPath, mStagingProperties.getTrimPathStart(),
                 mStagingProperties.getTrimPathEnd(), mStagingProperties.getTrimPathOffset());
         outPath = tempStagingPath;
     } else {
-        if (mProperties.getTrimPathStart() != 0.0f || mProperties.getTrimPathEnd() != 1.0f) {
+        bool trimmed = mProperties.getTrimPathStart() != 0.0f
+                || mProperties.getTrimPathEnd() != 1.0f;
+        // Measuring the path for the trim is expensive, so the trimmed path is only rebuilt
+        // when the path data or the trim values changed.
+        if (mSkPathDirty || mProperties.mTrimDirty) {
+            Path::getUpdatedPath(useStagingData, tempStagingPath);
+            if (trimmed) {
+                applyTrim(&mTrimmedSkPath, mSkPath, mProperties.getTrimPathStart(),
+                        mProperties.getTrimPathEnd(), mProperties.getTrimPathOffset());
+            }
             mProperties.mTrimDirty = false;
-            applyTrim(&mTrimmedSkPath, mSkPath, mProperties.getTrimPathStart(),
-                    mProperties.getTrimPathEnd(), mProperties.getTrimPathOffset());
-            outPath = &mTrimmedSkPath;
-        } else {
-            outPath = &mSkPath;
         }
+        outPath = trimmed ? &mTrimmedSkPath : &mSkPath;
     }
     const FullPathProperties& properties = useStagingData ? mStagingProperties : mProperties;
     bool setFillPath = properties.getFillGradient() != nullptr
@@ -143,8 +143,8 @@ public:
     public:
         explicit PathProperties(Node* node) : Properties(node) {}
         void syncProperties(const PathProperties& prop) {
-            mData = prop.mData;
-            onPropertyChanged();
+            // Syncing runs every frame the VD is drawn; only a data change needs a new SkPath.
+            setData(prop.mData);
         }
         void setData(const Data& data) {
             // Updates the path data. Note that we don't generate a new Skia path right away
@@ -227,8 +227,11 @@ public:
             SkSafeUnref(strokeGradient);
         }
         void syncProperties(const FullPathProperties& prop) {
+            // Color or alpha changes reuse the trimmed path
+            mTrimDirty |= mPrimitiveFields.trimPathStart != prop.mPrimitiveFields.trimPathStart
+                    || mPrimitiveFields.trimPathEnd != prop.mPrimitiveFields.trimPathEnd
+                    || mPrimitiveFields.trimPathOffset != prop.mPrimitiveFields.trimPathOffset;
             mPrimitiveFields = prop.mPrimitiveFields;
-            mTrimDirty = true;
             UPDATE_SKPROP(fillGradient, prop.fillGradient);
             UPDATE_SKPROP(strokeGradient, prop.strokeGradient);
             onPropertyChanged();
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "GlyphPrefetcher.h"
+
+#include <utils/Trace.h>
+
+#include <SkGlyph.h>
+#include <SkGlyphCache.h>
+#include <SkSurfaceProps.h>
+
+#include <vector>
+
+#include "../Matrix.h"
+#include "../thread/Task.h"
+#include "../thread/TaskManager.h"
+#include "../thread/TaskProcessor.h"
+
+namespace android {
+namespace uirenderer {
+
+class GlyphPrefetchTask : public Task<bool> {
+public:
+    GlyphPrefetchTask(const SkPaint& paint, const glyph_t* glyphs, int glyphCount,
+            const SkMatrix& rasterMatrix)
+            : paint(paint)
+            , glyphs(glyphs, glyphs + glyphCount)
+            , rasterMatrix(rasterMatrix) {}
+
+    SkPaint paint;
+    std::vector<glyph_t> glyphs;
+    SkMatrix rasterMatrix;
+};
+
+class GlyphPrefetcher::PrefetchProcessor : public TaskProcessor<bool> {
+public:
+    explicit PrefetchProcessor(TaskManager* manager) : TaskProcessor<bool>(manager) {}
+    ~PrefetchProcessor() {}
+
+    virtual void onProcess(const sp<Task<bool> >& task) override {
+        GlyphPrefetchTask* t = static_cast<GlyphPrefetchTask*>(task.get());
+        ATRACE_NAME("glyph prefetch");
+
+        // Same lookup as Font::getCachedGlyph, so that the images land in the glyph cache
+        // the RenderThread will read them from
+        SkSurfaceProps surfaceProps(0, kUnknown_SkPixelGeometry);
+        SkAutoGlyphCacheNoGamma autoCache(t->paint, &surfaceProps, &t->rasterMatrix);
+        SkGlyphCache* cache = autoCache.getCache();
+        for (glyph_t glyph : t->glyphs) {
+            if (IS_END_OF_STRING(glyph)) break;
+            const SkGlyph& skiaGlyph = GET_METRICS(cache, glyph);
+            if (!skiaGlyph.fImage) {
+                cache->findImage(skiaGlyph);
+            }
+        }
+        t->setResult(true);
+    }
+};
+
+GlyphPrefetcher& GlyphPrefetcher::get() {
+    static GlyphPrefetcher* sPrefetcher = new GlyphPrefetcher();
+    return *sPrefetcher;
+}
+
+GlyphPrefetcher::GlyphPrefetcher()
+        : mTaskManager(new TaskManager())
+        , mProcessor(new PrefetchProcessor(mTaskManager.get())) {}
+
+void GlyphPrefetcher::prefetch(const SkPaint& paint, const glyph_t* glyphs, int glyphCount,
+        const Matrix4& transform) {
+    if (glyphCount <= 0 || !mTaskManager->canRunTasks()) return;
+
+    // Same raster matrix as FrameBuilder::deferTextOp picks for the FontRenderer
+    SkMatrix rasterMatrix;
+    if (transform.isPureTranslate() || transform.isPerspective()) {
+        rasterMatrix.reset();
+    } else {
+        float sx, sy;
+        transform.decomposeScale(sx, sy);
+        rasterMatrix.setScale(roundf(std::max(1.0f, sx)), roundf(std::max(1.0f, sy)));
+    }
+    mProcessor->add(new GlyphPrefetchTask(paint, glyphs, glyphCount, rasterMatrix));
+}
+
+}; // namespace uirenderer
+}; // namespace android
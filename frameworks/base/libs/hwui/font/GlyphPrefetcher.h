@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANDROID_HWUI_GLYPH_PREFETCHER_H
+#define ANDROID_HWUI_GLYPH_PREFETCHER_H
+
+#include <SkPaint.h>
+#include <utils/StrongPointer.h>
+
+#include <memory>
+
+#include "FontUtil.h"
+
+namespace android {
+namespace uirenderer {
+
+class Matrix4;
+class TaskManager;
+
+/**
+ * Rasterizes glyphs into Skia's glyph cache on background workers, ahead of the
+ * FontRenderer upload that happens when the RenderThread defers the text.
+ *
+ * FontRenderer pulls glyph images through the same SkGlyphCache lookup, so by the time the
+ * RenderThread needs a prefetched glyph it only has to copy it into its cache texture. Glyphs
+ * that aren't ready yet are rasterized by the RenderThread as before, so a frame only ever
+ * waits on the glyphs it draws.
+ */
+class GlyphPrefetcher {
+public:
+    /**
+     * Returns the process-wide GlyphPrefetcher. This object is never destroyed.
+     */
+    static GlyphPrefetcher& get();
+
+    /**
+     * Queues the given glyphs for rasterization, as they'll be drawn with the given paint and
+     * transform. May be called from any thread, typically right after text shaping.
+     */
+    void prefetch(const SkPaint& paint, const glyph_t* glyphs, int glyphCount,
+            const Matrix4& transform);
+
+private:
+    GlyphPrefetcher();
+
+    class PrefetchProcessor;
+
+    std::unique_ptr<TaskManager> mTaskManager;
+    sp<PrefetchProcessor> mProcessor;
+};
+
+}; // namespace uirenderer
+}; // namespace android
+
+#endif // ANDROID_HWUI_GLYPH_PREFETCHER_H
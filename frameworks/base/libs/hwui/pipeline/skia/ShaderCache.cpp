@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ShaderCache.h"
+
+#include <cutils/properties.h>
+#include <FileBlobCache.h>
+#include <log/log.h>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+
+namespace android {
+namespace uirenderer {
+namespace skiapipeline {
+
+// Cache size limits. A compiled program is typically a few KB.
+static const size_t kMaxKeySize = 1024;
+static const size_t kMaxValueSize = 64 * 1024;
+static const size_t kMaxTotalSize = 512 * 1024;
+
+// Key of the entry holding the fingerprint of the build that wrote the cache
+static const char kFingerprintKey[] = "hwui.shader_cache.build_fingerprint";
+
+static void storeFingerprint(FileBlobCache* blobCache) {
+    char fingerprint[PROPERTY_VALUE_MAX];
+    int fingerprintLength = property_get("ro.build.fingerprint", fingerprint, "");
+    if (fingerprintLength > 0) {
+        blobCache->set(kFingerprintKey, sizeof(kFingerprintKey), fingerprint, fingerprintLength);
+    }
+}
+
+ShaderCache& ShaderCache::get() {
+    static ShaderCache sCache;
+    return sCache;
+}
+
+void ShaderCache::setFilename(const char* filename) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFilename = filename;
+}
+
+FileBlobCache* ShaderCache::getBlobCacheLocked() {
+    if (mBlobCache) {
+        return mBlobCache.get();
+    }
+    mBlobCache.reset(new FileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize, mFilename));
+
+    char fingerprint[PROPERTY_VALUE_MAX];
+    int fingerprintLength = property_get("ro.build.fingerprint", fingerprint, "");
+    char savedFingerprint[PROPERTY_VALUE_MAX];
+    size_t savedLength = mBlobCache->get(kFingerprintKey, sizeof(kFingerprintKey),
+            savedFingerprint, sizeof(savedFingerprint));
+    if (savedLength != static_cast<size_t>(fingerprintLength)
+            || memcmp(savedFingerprint, fingerprint, savedLength)) {
+        // Either a new cache, or one written by another build (or one that lost the fingerprint
+        // entry to an eviction): start over from an empty cache.
+        if (savedLength > 0) {
+            ALOGI("Discarding shader cache %s written by another build", mFilename.c_str());
+        }
+        mBlobCache.reset();
+        if (!mFilename.empty()) {
+            unlink(mFilename.c_str());
+        }
+        mBlobCache.reset(new FileBlobCache(kMaxKeySize, kMaxValueSize, kMaxTotalSize,
+                mFilename));
+        storeFingerprint(mBlobCache.get());
+    }
+    return mBlobCache.get();
+}
+
+sk_sp<SkData> ShaderCache::load(const SkData& key) {
+    size_t keySize = key.size();
+    if (keySize == 0 || keySize > kMaxKeySize) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    FileBlobCache* blobCache = getBlobCacheLocked();
+    size_t valueSize = blobCache->get(key.data(), keySize, nullptr, 0);
+    if (valueSize == 0) {
+        return nullptr;
+    }
+    sk_sp<SkData> value = SkData::MakeUninitialized(valueSize);
+    if (blobCache->get(key.data(), keySize, value->writable_data(), valueSize) != valueSize) {
+        return nullptr;
+    }
+    return value;
+}
+
+void ShaderCache::store(const SkData& key, const SkData& data) {
+    size_t keySize = key.size();
+    size_t valueSize = data.size();
+    if (keySize == 0 || valueSize == 0 || keySize > kMaxKeySize || valueSize > kMaxValueSize) {
+        ALOGW("ShaderCache::store: sizes %zu and %zu are not allowed", keySize, valueSize);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    getBlobCacheLocked()->set(key.data(), keySize, data.data(), valueSize);
+
+    if (!mSavePending && !mFilename.empty()) {
+        mSavePending = true;
+        std::thread deferredSaveThread([this]() {
+            sleep(mDeferredSaveDelay);
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mBlobCache) {
+                // The fingerprint may have been evicted by the shaders stored since it was set
+                storeFingerprint(mBlobCache.get());
+                mBlobCache->writeToFile();
+            }
+            mSavePending = false;
+        });
+        deferredSaveThread.detach();
+    }
+}
+
+} /* namespace skiapipeline */
+} /* namespace uirenderer */
+} /* namespace android */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cutils/compiler.h>
+#include <GrContextOptions.h>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace android {
+
+class FileBlobCache;
+
+namespace uirenderer {
+namespace skiapipeline {
+
+/**
+ * Keeps the shaders Skia compiles across runs of the app, so that they don't have to be built
+ * again during the first frames of the next cold start.
+ *
+ * The cache is a BlobCache saved in a per-app file, a few seconds after a new shader has been
+ * stored. The build the cache was written by is stored along with the shaders, and the whole
+ * cache is dropped when it was written by another build, since the shaders may no longer match
+ * what Skia or the driver generate.
+ */
+class ShaderCache : public GrContextOptions::PersistentCache {
+public:
+    /**
+     * Returns the singleton ShaderCache. This object is never destroyed.
+     */
+    ANDROID_API static ShaderCache& get();
+
+    /**
+     * Sets the file the cache is loaded from and saved to. Only has an effect if called before
+     * the cache is first used, and the cache stays in memory only if it is never called.
+     */
+    ANDROID_API void setFilename(const char* filename);
+
+    /**
+     * Returns the shader stored for the key, or nullptr if there is none.
+     */
+    sk_sp<SkData> load(const SkData& key) override;
+
+    /**
+     * Stores a shader, and schedules the cache to be saved to disk.
+     */
+    void store(const SkData& key, const SkData& data) override;
+
+private:
+    ShaderCache() {}
+    ~ShaderCache() {}
+
+    /**
+     * Returns the cache, loading it from disk on first use.
+     */
+    FileBlobCache* getBlobCacheLocked();
+
+    std::unique_ptr<FileBlobCache> mBlobCache;
+    std::string mFilename;
+
+    // Whether a save of the cache has been scheduled and not run yet
+    bool mSavePending = false;
+
+    // Seconds to wait after a store before saving the cache, so that shaders compiled together
+    // are written at once
+    unsigned int mDeferredSaveDelay = 4;
+
+    // Protects all the members, loads and stores can come from any thread using a GrContext
+    std::mutex mMutex;
+
+    friend class ShaderCacheTestUtils;
+};
+
+} /* namespace skiapipeline */
+} /* namespace uirenderer */
+} /* namespace android */
@@ -84,6 +84,15 @@ public:
      */
     bool hasVectorDrawables() const override { return !mVectorDrawables.empty(); }
 
+    /**
+     * Returns true if prepareListAndChildren() has work to do even when nothing in this
+     * list changed: mutable images to pin, functors, VectorDrawables or projection.
+     */
+    bool needsPrepareEachFrame() const override {
+        return hasFunctor() || hasVectorDrawables() || !mMutableImages.empty()
+                || containsProjectionReceiver();
+    }
+
     /**
      * Attempts to reset and reuse this DisplayList.
      *
@@ -113,6 +113,7 @@ bool SkiaOpenGLPipeline::swapBuffers(const Frame& frame, bool drew,
     // Even if we decided to cancel the frame, from the perspective of jank
     // metrics the frame was swapped at this point
     currentFrameInfo->markSwapBuffers();
+    currentFrameInfo->set(FrameInfoIndex::GpuDuration) = mEglManager.takeGpuDuration();
 
     *requireSwap = drew || mEglManager.damageRequiresSwap();
 
@@ -105,9 +105,10 @@ bool SkiaVulkanPipeline::swapBuffers(const Frame& frame, bool drew,
     // Even if we decided to cancel the frame, from the perspective of jank
     // metrics the frame was swapped at this point
     currentFrameInfo->markSwapBuffers();
+    currentFrameInfo->set(FrameInfoIndex::GpuDuration) = mVkManager.takeGpuDuration();
 
     if (*requireSwap) {
-        mVkManager.swapBuffers(mVkSurface);
+        mVkManager.swapBuffers(mVkSurface, screenDirty);
     }
 
     return *requireSwap;
@@ -42,8 +42,9 @@ void VectorDrawableAtlas::prepareForDraw(GrContext* context) {
             mConsecutiveFailures = 0;
             mFreeRects.clear();
         } else {
-            if (isFragmented()) {
-                // Invoke repack outside renderFrame to avoid jank.
+            if (mRepacking || isFragmented()) {
+                // Invoke repack outside renderFrame to avoid jank. An ongoing repack gets one
+                // more step for each frame that draws VDs.
                 renderthread::RenderProxy::repackVectorDrawableAtlas();
             }
         }
@@ -62,8 +63,10 @@ void VectorDrawableAtlas::repackIfNeeded(GrContext* context) {
     // We repackage when atlas failed to allocate space MAX_CONSECUTIVE_FAILURES consecutive
     // times and the atlas allocated pixels are at least MAX_UNUSED_RATIO times higher than pixels
     // used by atlas VDs.
-    if (isFragmented() && mSurface) {
-        repack(context);
+    if (mRepacking) {
+        repackStep(context);
+    } else if (isFragmented() && mSurface && startRepack(context)) {
+        repackStep(context);
     }
 }
 
@@ -73,28 +76,31 @@ bool VectorDrawableAtlas::compareCacheEntry(const CacheEntry& first, const Cache
     return first.VDrect.width()*first.VDrect.height() < second.VDrect.width()*second.VDrect.height();
 }
 
-void VectorDrawableAtlas::repack(GrContext* context) {
+bool VectorDrawableAtlas::startRepack(GrContext* context) {
     ATRACE_CALL();
     sk_sp<SkSurface> newSurface;
-    SkCanvas* canvas = nullptr;
     if (StorageMode::allowSharedSurface == mStorageMode) {
         newSurface = createSurface(mWidth, mHeight, context);
         if (!newSurface) {
-            return;
+            return false;
         }
-        canvas = newSurface->getCanvas();
-        canvas->clear(SK_ColorTRANSPARENT);
+        newSurface->getCanvas()->clear(SK_ColorTRANSPARENT);
         mRectanizer = std::make_unique<GrRectanizerPow2>(mWidth, mHeight);
     } else {
         if (!mSurface) {
-            return; //nothing to repack
+            return false; //nothing to repack
         }
         mRectanizer.reset();
     }
     mFreeRects.clear();
-    SkImage* sourceImageAtlas = nullptr;
-    if (mSurface) {
-        sourceImageAtlas = mSurface->makeImageSnapshot().get();
+
+    // Rectangles in the current atlas are treated as standalone surfaces sharing the old atlas,
+    // until they are moved. Space freed in the old atlas is not reused.
+    mRepackSource = mSurface;
+    for (CacheEntry& entry : mRects) {
+        if (!entry.surface) {
+            entry.surface = mRepackSource;
+        }
     }
 
     // Sort the list by VD size, which allows for the smallest VDs to get first in the atlas.
@@ -103,51 +109,71 @@ void VectorDrawableAtlas::repack(GrContext* context) {
         mRects.sort(compareCacheEntry);
     }
 
-    for (CacheEntry& entry : mRects) {
+    mSurface = newSurface;
+    mPixelUsedByVDs = 0;
+    mPixelAllocated = 0;
+    mConsecutiveFailures = 0;
+    mRepackCursor = mRects.begin();
+    mRepacking = true;
+    return true;
+}
+
+#define MAX_REPACKED_ENTRIES_PER_STEP 32
+
+void VectorDrawableAtlas::repackStep(GrContext* context) {
+    ATRACE_CALL();
+    SkCanvas* canvas = mSurface ? mSurface->getCanvas() : nullptr;
+    sk_sp<SkImage> sourceImageAtlas;
+    if (mRepackSource) {
+        sourceImageAtlas = mRepackSource->makeImageSnapshot();
+    }
+
+    for (int moved = 0; mRepackCursor != mRects.end() && moved < MAX_REPACKED_ENTRIES_PER_STEP;
+            mRepackCursor++) {
+        CacheEntry& entry = *mRepackCursor;
+        if (!entry.surface) {
+            continue; //allocated in the new atlas after the repack started
+        }
         SkRect currentVDRect = entry.VDrect;
-        SkImage* sourceImage; //copy either from the atlas or from a standalone surface
-        if (entry.surface) {
-            if (!fitInAtlas(currentVDRect.width(), currentVDRect.height())) {
-                continue; //don't even try to repack huge VD
-            }
-            sourceImage = entry.surface->makeImageSnapshot().get();
-        } else {
-            sourceImage = sourceImageAtlas;
+        const bool inOldAtlas = mRepackSource && entry.surface == mRepackSource;
+        if (!inOldAtlas && !fitInAtlas(currentVDRect.width(), currentVDRect.height())) {
+            continue; //don't even try to repack huge VD
         }
+        moved++;
+        //copy either from the old atlas or from a standalone surface
+        sk_sp<SkImage> sourceImage = inOldAtlas ? sourceImageAtlas
+                : entry.surface->makeImageSnapshot();
         size_t VDRectArea = currentVDRect.width()*currentVDRect.height();
         SkIPoint16 pos;
         if (canvas && mRectanizer->addRect(currentVDRect.width(), currentVDRect.height(), &pos)) {
             SkRect newRect = SkRect::MakeXYWH(pos.fX, pos.fY, currentVDRect.width(),
                     currentVDRect.height());
-            canvas->drawImageRect(sourceImage, currentVDRect, newRect, nullptr);
+            canvas->drawImageRect(sourceImage.get(), currentVDRect, newRect, nullptr);
             entry.VDrect = newRect;
             entry.rect = newRect;
+            entry.surface = nullptr;
+            mPixelUsedByVDs += VDRectArea;
+            mPixelAllocated += VDRectArea;
+        } else if (inOldAtlas) {
+            // Repack failed for this item. Store it in its own standalone surface, so that the
+            // old atlas can be released.
+            SkRect newRect = SkRect::MakeWH(currentVDRect.width(), currentVDRect.height());
+            entry.surface = createSurface(newRect.width(), newRect.height(), context);
             if (entry.surface) {
-                // A rectangle moved from a standalone surface to the atlas.
-                entry.surface = nullptr;
-                mPixelUsedByVDs += VDRectArea;
-            }
-        } else {
-            // Repack failed for this item. If it is not already, store it in a standalone
-            // surface.
-            if (!entry.surface) {
-                // A rectangle moved from an atlas to a standalone surface.
-                mPixelUsedByVDs -= VDRectArea;
-                SkRect newRect = SkRect::MakeWH(currentVDRect.width(),
-                        currentVDRect.height());
-                entry.surface = createSurface(newRect.width(), newRect.height(), context);
                 auto tempCanvas = entry.surface->getCanvas();
                 tempCanvas->clear(SK_ColorTRANSPARENT);
-                tempCanvas->drawImageRect(sourceImageAtlas, currentVDRect, newRect, nullptr);
-                entry.VDrect = newRect;
-                entry.rect = newRect;
+                tempCanvas->drawImageRect(sourceImage.get(), currentVDRect, newRect, nullptr);
             }
+            entry.VDrect = newRect;
+            entry.rect = newRect;
         }
     }
-    mPixelAllocated = mPixelUsedByVDs;
     context->flush();
-    mSurface = newSurface;
-    mConsecutiveFailures = 0;
+
+    if (mRepackCursor == mRects.end()) {
+        mRepackSource.reset();
+        mRepacking = false;
+    }
 }
 
 AtlasEntry VectorDrawableAtlas::requestNewEntry(int width, int height, GrContext* context) {
@@ -241,6 +267,9 @@ void VectorDrawableAtlas::releaseEntry(AtlasKey atlasKey) {
             mConsecutiveFailures = 0;
         }
         auto eraseIt = entry->eraseIt;
+        if (mRepacking && eraseIt == mRepackCursor) {
+            mRepackCursor++;
+        }
         mRects.erase(eraseIt);
     }
 }
@@ -261,6 +290,8 @@ void VectorDrawableAtlas::setStorageMode(StorageMode mode) {
         mSurface.reset();
         mRectanizer.reset();
         mFreeRects.clear();
+        mRepackSource.reset();
+        mRepacking = false;
     }
 }
 
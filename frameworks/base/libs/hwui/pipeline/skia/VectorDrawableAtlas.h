@@ -76,6 +76,8 @@ public:
     /**
      * Repack the atlas if needed, by moving used rectangles into a new atlas surface.
      * The goal of repacking is to fix a fragmented atlas.
+     * A repack moves a bounded number of rectangles per call, so that it is spread across frames.
+     * Until it is complete, the rectangles not yet moved are read from the previous atlas surface.
      */
     void repackIfNeeded(GrContext* context);
 
@@ -84,6 +86,11 @@ public:
      */
     bool isFragmented();
 
+    /**
+     * Returns true if a repack has started and not all the rectangles have been moved yet.
+     */
+    bool isRepacking() { return mRepacking; }
+
     /**
      * "requestNewEntry" is called by VectorDrawable to allocate a new rectangle area from the atlas
      * or create a standalone surface if atlas is full.
@@ -182,13 +189,27 @@ private:
      */
     StorageMode mStorageMode;
 
+    /**
+     * Atlas surface replaced by an ongoing repack. Rectangles that have not been moved yet keep
+     * a reference to it in "CacheEntry::surface", like standalone surfaces.
+     */
+    sk_sp<SkSurface> mRepackSource;
+
+    /**
+     * Next rectangle in "mRects" to be moved by the ongoing repack.
+     */
+    std::list<CacheEntry>::iterator mRepackCursor;
+
+    bool mRepacking = false;
+
     sk_sp<SkSurface> createSurface(int width, int height, GrContext* context);
 
     inline bool fitInAtlas(int width, int height) {
         return 2*width < mWidth && 2*height < mHeight;
     }
 
-    void repack(GrContext* context);
+    bool startRepack(GrContext* context);
+    void repackStep(GrContext* context);
 
     static bool compareCacheEntry(const CacheEntry& first, const CacheEntry& second);
 };
@@ -148,7 +148,7 @@ OffscreenBuffer* OffscreenBufferPool::get(RenderState& renderState,
     OffscreenBuffer* layer = nullptr;
 
     Entry entry(width, height, wideColorGamut);
-    auto iter = mPool.find(entry);
+    auto iter = findFitting(entry);
 
     if (iter != mPool.end()) {
         entry = *iter;
@@ -169,8 +169,9 @@ OffscreenBuffer* OffscreenBufferPool::get(RenderState& renderState,
 OffscreenBuffer* OffscreenBufferPool::resize(OffscreenBuffer* layer,
         const uint32_t width, const uint32_t height) {
     RenderState& renderState = layer->renderState;
-    if (layer->texture.width() == OffscreenBuffer::computeIdealDimension(width)
-            && layer->texture.height() == OffscreenBuffer::computeIdealDimension(height)) {
+    if (fitsWithSlack(layer->texture.width(), OffscreenBuffer::computeIdealDimension(width))
+            && fitsWithSlack(layer->texture.height(),
+                    OffscreenBuffer::computeIdealDimension(height))) {
         // resize in place
         layer->viewportWidth = width;
         layer->viewportHeight = height;
@@ -184,6 +185,19 @@ OffscreenBuffer* OffscreenBufferPool::resize(OffscreenBuffer* layer,
     return get(renderState, width, height, wideColorGamut);
 }
 
+std::multiset<OffscreenBufferPool::Entry>::iterator OffscreenBufferPool::findFitting(
+        const Entry& request) {
+    // Entries are sorted by width, then height, so the first one that fits is the smallest
+    for (auto iter = mPool.lower_bound(request);
+            iter != mPool.end() && iter->width <= request.width + LAYER_SIZE; iter++) {
+        if (fitsWithSlack(iter->height, request.height)
+                && iter->wideColorGamut == request.wideColorGamut) {
+            return iter;
+        }
+    }
+    return mPool.end();
+}
+
 void OffscreenBufferPool::dump() {
     for (auto entry : mPool) {
         ALOGD("  Layer size %dx%d", entry.width, entry.height);
@@ -194,18 +208,23 @@ void OffscreenBufferPool::putOrDelete(OffscreenBuffer* layer) {
     const uint32_t size = layer->getSizeInBytes();
     // Don't even try to cache a layer that's bigger than the cache
     if (size < mMaxSize) {
-        // TODO: Use an LRU
         while (mSize + size > mMaxSize) {
-            OffscreenBuffer* victim = mPool.begin()->layer;
-            mSize -= victim->getSizeInBytes();
-            delete victim;
-            mPool.erase(mPool.begin());
+            auto victim = mPool.begin();
+            for (auto iter = mPool.begin(); iter != mPool.end(); iter++) {
+                if (iter->generation < victim->generation) {
+                    victim = iter;
+                }
+            }
+            mSize -= victim->layer->getSizeInBytes();
+            delete victim->layer;
+            mPool.erase(victim);
         }
 
         // clear region, since it's no longer valid
         layer->region.clear();
 
         Entry entry(layer);
+        entry.generation = mGeneration++;
 
         mPool.insert(entry);
         mSize += size;
@@ -154,12 +154,26 @@ private:
         uint32_t width = 0;
         uint32_t height = 0;
         bool wideColorGamut = false;
+        // Order in which entries were put in the pool, oldest evicted first
+        uint32_t generation = 0;
     }; // struct Entry
 
+    /**
+     * A buffer can be used for a layer whose ideal dimension is up to one LAYER_SIZE bucket
+     * smaller, so that layers resizing by a few pixels a frame, as in expand / collapse
+     * animations, don't allocate a new texture every time they cross a bucket boundary.
+     */
+    static bool fitsWithSlack(uint32_t allocated, uint32_t ideal) {
+        return allocated >= ideal && allocated <= ideal + LAYER_SIZE;
+    }
+
+    std::multiset<Entry>::iterator findFitting(const Entry& request);
+
     std::multiset<Entry> mPool;
 
     uint32_t mSize = 0;
     uint32_t mMaxSize;
+    uint32_t mGeneration = 0;
 }; // class OffscreenBufferCache
 
 }; // namespace uirenderer
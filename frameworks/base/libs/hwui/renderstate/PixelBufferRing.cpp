@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "renderstate/PixelBufferRing.h"
+
+#include "renderstate/PixelBufferState.h"
+#include "utils/TraceUtils.h"
+
+#include <string.h>
+
+namespace android {
+namespace uirenderer {
+
+PixelBufferRing::PixelBufferRing(PixelBufferState& pixelBufferState)
+        : mPixelBufferState(pixelBufferState) {
+}
+
+PixelBufferRing::~PixelBufferRing() {
+    mPixelBufferState.unbind();
+    for (Buffer& buffer : mBuffers) {
+        if (buffer.fence) {
+            glDeleteSync(buffer.fence);
+        }
+        if (buffer.id) {
+            glDeleteBuffers(1, &buffer.id);
+        }
+    }
+}
+
+bool PixelBufferRing::beginUpload(const void* data, size_t size) {
+    if (size < kMinUploadSize || size > kMaxUploadSize) {
+        return false;
+    }
+
+    ATRACE_NAME("PixelBufferRing::beginUpload");
+    Buffer& buffer = mBuffers[mCurrent];
+    if (!buffer.id) {
+        glGenBuffers(1, &buffer.id);
+    }
+    mPixelBufferState.bind(buffer.id);
+
+    GLbitfield access = GL_MAP_WRITE_BIT;
+    if (buffer.size < size) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        buffer.size = size;
+    } else if (buffer.fence
+            && glClientWaitSync(buffer.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        // The GPU is still reading the previous upload, let the driver hand
+        // out fresh storage instead of stalling on the map
+        access |= GL_MAP_INVALIDATE_BUFFER_BIT;
+    }
+    if (buffer.fence) {
+        glDeleteSync(buffer.fence);
+        buffer.fence = nullptr;
+    }
+
+    void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, access);
+    if (!dst) {
+        mPixelBufferState.unbind();
+        return false;
+    }
+    memcpy(dst, data, size);
+    if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE) {
+        // The buffer contents were lost, fall back to a client memory upload
+        mPixelBufferState.unbind();
+        return false;
+    }
+    return true;
+}
+
+void PixelBufferRing::endUpload() {
+    Buffer& buffer = mBuffers[mCurrent];
+    buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    mPixelBufferState.unbind();
+    mCurrent = (mCurrent + 1) % kBufferCount;
+}
+
+} /* namespace uirenderer */
+} /* namespace android */
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef RENDERSTATE_PIXELBUFFERRING_H
+#define RENDERSTATE_PIXELBUFFERRING_H
+
+#include <GLES3/gl3.h>
+
+#include <cstddef>
+
+namespace android {
+namespace uirenderer {
+
+class PixelBufferState;
+
+/**
+ * Small ring of pixel unpack buffers used to stage texture uploads.
+ *
+ * Copying pixels into a PBO and sourcing glTex(Sub)Image2D from it lets the
+ * driver perform the actual transfer (and any tiling/swizzling) asynchronously
+ * instead of blocking the RenderThread inside the upload call. Each buffer is
+ * fenced after use; a buffer whose previous upload is still in flight is
+ * orphaned rather than waited on.
+ */
+class PixelBufferRing {
+    friend class Caches; // TODO: move to RenderState
+public:
+    // Uploads smaller than this are cheaper to do directly than to stage
+    static const size_t kMinUploadSize = 256 * 1024;
+    // Caps the memory held by each buffer of the ring
+    static const size_t kMaxUploadSize = 8 * 1024 * 1024;
+
+    /**
+     * Copies size bytes from data into the next buffer of the ring and leaves
+     * it bound to GL_PIXEL_UNPACK_BUFFER. Returns false if the upload should be
+     * done directly from client memory instead, in which case nothing is bound.
+     * A successful call must be followed by endUpload() once the texture
+     * upload sourcing the buffer has been issued.
+     */
+    bool beginUpload(const void* data, size_t size);
+    void endUpload();
+
+private:
+    explicit PixelBufferRing(PixelBufferState& pixelBufferState);
+    ~PixelBufferRing();
+
+    static const int kBufferCount = 3;
+
+    struct Buffer {
+        GLuint id = 0;
+        size_t size = 0;
+        GLsync fence = nullptr;
+    };
+
+    PixelBufferState& mPixelBufferState;
+    Buffer mBuffers[kBufferCount];
+    int mCurrent = 0;
+};
+
+} /* namespace uirenderer */
+} /* namespace android */
+
+#endif // RENDERSTATE_PIXELBUFFERRING_H
@@ -314,6 +314,24 @@ bool CanvasContext::isSwapChainStuffed() {
     return true;
 }
 
+bool CanvasContext::isPastFrameDeadline() {
+    // How late after its vsync a frame may complete. The buffer queue absorbs one interval,
+    // any more and the following frames inherit the delay
+    static const int DEADLINE_FRAME_INTERVALS = 2;
+
+    if (!Properties::dropLateFrames || !mEstimatedDrawDuration) return false;
+
+    nsecs_t deadline = mCurrentFrameInfo->get(FrameInfoIndex::Vsync)
+            + mRenderThread.timeLord().frameIntervalNanos() * DEADLINE_FRAME_INTERVALS;
+    nsecs_t expectedCompletion = mCurrentFrameInfo->get(FrameInfoIndex::SyncStart)
+            + mEstimatedDrawDuration;
+    if (expectedCompletion <= deadline) {
+        return false;
+    }
+    ATRACE_NAME("frame past deadline");
+    return true;
+}
+
 void CanvasContext::prepareTree(TreeInfo& info, int64_t* uiFrameInfo,
         int64_t syncQueued, RenderNode* target) {
     mRenderThread.removeFrameCallback(this);
@@ -371,7 +389,7 @@ void CanvasContext::prepareTree(TreeInfo& info, int64_t* uiFrameInfo,
             // or the last drop was too recent
             info.out.canDrawThisFrame = true;
         } else {
-            info.out.canDrawThisFrame = !isSwapChainStuffed();
+            info.out.canDrawThisFrame = !isSwapChainStuffed() && !isPastFrameDeadline();
             if (!info.out.canDrawThisFrame) {
                 // dropping frame
                 mLastDropVsync = mRenderThread.timeLord().latestVsync();
@@ -425,6 +443,8 @@ void CanvasContext::draw() {
 
     waitOnFences();
 
+    // Must be read before the swap, which moves the surface on to the next frame number
+    const int64_t frameNumber = getFrameNumber();
     bool requireSwap = false;
     bool didSwap = mRenderPipeline->swapBuffers(frame, drew, windowDirty, mCurrentFrameInfo,
             &requireSwap);
@@ -460,16 +480,26 @@ void CanvasContext::draw() {
                 = swap.dequeueDuration;
         mCurrentFrameInfo->set(FrameInfoIndex::QueueBufferDuration)
                 = swap.queueDuration;
+        mCurrentFrameInfo->set(FrameInfoIndex::FrameNumber) = didSwap ? frameNumber : 0;
         mHaveNewSurface = false;
         mFrameNumber = -1;
     } else {
         mCurrentFrameInfo->set(FrameInfoIndex::DequeueBufferDuration) = 0;
         mCurrentFrameInfo->set(FrameInfoIndex::QueueBufferDuration) = 0;
+        mCurrentFrameInfo->set(FrameInfoIndex::FrameNumber) = 0;
     }
 
     // TODO: Use a fence for real completion?
     mCurrentFrameInfo->markFrameCompleted();
 
+    nsecs_t drawDuration = mCurrentFrameInfo->duration(
+            FrameInfoIndex::SyncStart, FrameInfoIndex::FrameCompleted);
+    if (mEstimatedDrawDuration) {
+        mEstimatedDrawDuration = ((7 * mEstimatedDrawDuration) + drawDuration) / 8;
+    } else {
+        mEstimatedDrawDuration = drawDuration;
+    }
+
 #if LOG_FRAMETIME_MMA
     float thisFrame = mCurrentFrameInfo->duration(
             FrameInfoIndex::IssueDrawCommandsStart,
@@ -210,6 +210,7 @@ private:
     void freePrefetchedLayers();
 
     bool isSwapChainStuffed();
+    bool isPastFrameDeadline();
 
     SkRect computeDirtyRect(const Frame& frame, SkRect* dirty);
 
@@ -238,6 +239,8 @@ private:
 
     // last vsync for a dropped frame due to stuffed queue
     nsecs_t mLastDropVsync = 0;
+    // moving average of the time from sync start to frame completion of the drawn frames
+    nsecs_t mEstimatedDrawDuration = 0;
 
     bool mOpaque;
     bool mWideColorGamut = false;
@@ -25,6 +25,7 @@
 #include "Caches.h"
 #include "DeviceInfo.h"
 #include "Frame.h"
+#include "ProgramProfile.h"
 #include "Properties.h"
 #include "RenderThread.h"
 #include "renderstate/RenderState.h"
@@ -89,7 +90,8 @@ EglManager::EglManager(RenderThread& thread)
         , mEglConfigWideGamut(nullptr)
         , mEglContext(EGL_NO_CONTEXT)
         , mPBufferSurface(EGL_NO_SURFACE)
-        , mCurrentSurface(EGL_NO_SURFACE) {
+        , mCurrentSurface(EGL_NO_SURFACE)
+        , mWarmupCancelled(false) {
 }
 
 void EglManager::initialize() {
@@ -127,6 +129,8 @@ void EglManager::initialize() {
     makeCurrent(mPBufferSurface);
     DeviceInfo::initialize();
     mRenderThread.renderState().onGLContextCreated();
+    initGpuTimer();
+    startProgramWarmup();
 
     if (Properties::getRenderPipelineType() == RenderPipelineType::SkiaGL) {
 #ifdef HWUI_GLES_WRAP_ENABLED
@@ -242,6 +246,120 @@ void EglManager::createContext() {
         "Failed to create context, error = %s", eglErrorString());
 }
 
+void EglManager::startProgramWarmup() {
+    if (Properties::getRenderPipelineType() != RenderPipelineType::OpenGL
+            || !Properties::programWarmup) {
+        return;
+    }
+
+    std::vector<programid> keys = ProgramProfile::get().load();
+    if (keys.empty()) return;
+
+    EGLint contextAttribs[] = {
+            EGL_CONTEXT_CLIENT_VERSION, GLES_VERSION,
+            EGL_NONE
+    };
+    EGLContext context = eglCreateContext(mEglDisplay,
+            EglExtensions.noConfigContext ? ((EGLConfig) nullptr) : mEglConfig,
+            mEglContext, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        ALOGW("Failed to create program warm-up context, error = %s", eglErrorString());
+        return;
+    }
+    EGLint surfaceAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    EGLSurface surface = eglCreatePbufferSurface(mEglDisplay, mEglConfig, surfaceAttribs);
+
+    EGLDisplay display = mEglDisplay;
+    ProgramCache& programCache = Caches::getInstance().programCache;
+    mWarmupCancelled = false;
+    mWarmupThread = std::thread([this, display, context, surface, keys, &programCache]() {
+        ATRACE_NAME("Program warm-up");
+        if (eglMakeCurrent(display, surface, surface, context)) {
+            for (programid key : keys) {
+                if (mWarmupCancelled) break;
+                programCache.precache(key);
+            }
+            // Programs must be fully linked before the main context can use them
+            glFinish();
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        } else {
+            ALOGW("Failed to make program warm-up context current, error = %s",
+                    eglErrorString());
+        }
+        eglDestroySurface(display, surface);
+        eglDestroyContext(display, context);
+        eglReleaseThread();
+    });
+}
+
+void EglManager::stopProgramWarmup() {
+    if (mWarmupThread.joinable()) {
+        mWarmupCancelled = true;
+        mWarmupThread.join();
+    }
+}
+
+void EglManager::initGpuTimer() {
+    auto extensions = StringUtils::split(
+            reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS)));
+    mHasGpuTimer = extensions.has("GL_EXT_disjoint_timer_query");
+    if (mHasGpuTimer) {
+        glGenQueriesEXT(kGpuTimerQueryCount, mGpuTimerQueries);
+    }
+    mGpuTimerFirstPending = 0;
+    mGpuTimerPendingCount = 0;
+    mGpuTimerActive = false;
+    mLastGpuDuration = 0;
+}
+
+void EglManager::beginGpuTimer() {
+    if (!mHasGpuTimer) return;
+    // A frame that wasn't swapped still did its GPU work, so it is timed as well
+    endGpuTimer();
+    pollGpuTimer();
+    if (mGpuTimerPendingCount == kGpuTimerQueryCount) {
+        // The GPU is too far behind, skip timing this frame rather than stall on a result
+        return;
+    }
+    int index = (mGpuTimerFirstPending + mGpuTimerPendingCount) % kGpuTimerQueryCount;
+    glBeginQueryEXT(GL_TIME_ELAPSED_EXT, mGpuTimerQueries[index]);
+    mGpuTimerActive = true;
+}
+
+void EglManager::endGpuTimer() {
+    if (!mGpuTimerActive) return;
+    glEndQueryEXT(GL_TIME_ELAPSED_EXT);
+    mGpuTimerPendingCount++;
+    mGpuTimerActive = false;
+}
+
+void EglManager::pollGpuTimer() {
+    while (mGpuTimerPendingCount > 0) {
+        GLuint query = mGpuTimerQueries[mGpuTimerFirstPending];
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuivEXT(query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        if (!available) break;
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64vEXT(query, GL_QUERY_RESULT_EXT, &elapsed);
+        // A disjoint operation, such as a frequency change, makes the results meaningless
+        GLint disjoint = GL_FALSE;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        if (!disjoint) {
+            mLastGpuDuration = static_cast<nsecs_t>(elapsed);
+        }
+        mGpuTimerFirstPending = (mGpuTimerFirstPending + 1) % kGpuTimerQueryCount;
+        mGpuTimerPendingCount--;
+    }
+}
+
+nsecs_t EglManager::takeGpuDuration() {
+    pollGpuTimer();
+    nsecs_t duration = mLastGpuDuration;
+    mLastGpuDuration = 0;
+    return duration;
+}
+
 void EglManager::createPBufferSurface() {
     LOG_ALWAYS_FATAL_IF(mEglDisplay == EGL_NO_DISPLAY,
             "usePBufferSurface() called on uninitialized GlobalContext!");
@@ -329,6 +447,12 @@ void EglManager::destroySurface(EGLSurface surface) {
 void EglManager::destroy() {
     if (mEglDisplay == EGL_NO_DISPLAY) return;
 
+    stopProgramWarmup();
+    if (mHasGpuTimer) {
+        endGpuTimer();
+        glDeleteQueriesEXT(kGpuTimerQueryCount, mGpuTimerQueries);
+        mHasGpuTimer = false;
+    }
     mRenderThread.setGrContext(nullptr);
     mRenderThread.renderState().onGLContextDestroyed();
     eglDestroyContext(mEglDisplay, mEglContext);
@@ -391,6 +515,7 @@ Frame EglManager::beginFrame(EGLSurface surface) {
     eglQuerySurface(mEglDisplay, surface, EGL_HEIGHT, &frame.mHeight);
     frame.mBufferAge = queryBufferAge(surface);
     eglBeginFrame(mEglDisplay, surface);
+    beginGpuTimer();
     return frame;
 }
 
@@ -418,6 +543,8 @@ bool EglManager::swapBuffers(const Frame& frame, const SkRect& screenDirty) {
         fence();
     }
 
+    endGpuTimer();
+
     EGLint rects[4];
     frame.map(screenDirty, rects);
     eglSwapBuffersWithDamageKHR(mEglDisplay, frame.mSurface, rects,
@@ -18,10 +18,14 @@
 
 #include <cutils/compiler.h>
 #include <EGL/egl.h>
+#include <GLES2/gl2.h>
 #include <SkRect.h>
 #include <ui/GraphicBuffer.h>
 #include <utils/StrongPointer.h>
 
+#include <atomic>
+#include <thread>
+
 namespace android {
 namespace uirenderer {
 namespace renderthread {
@@ -55,6 +59,10 @@ public:
     bool damageRequiresSwap();
     bool swapBuffers(const Frame& frame, const SkRect& screenDirty);
 
+    // Returns the GPU time of the most recent frame whose timing became available since the
+    // last call, or 0 if there is none.
+    nsecs_t takeGpuDuration();
+
     // Returns true iff the surface is now preserving buffers.
     bool setPreserveBuffer(EGLSurface surface, bool preserve);
 
@@ -70,6 +78,12 @@ private:
     void createPBufferSurface();
     void loadConfigs();
     void createContext();
+    void startProgramWarmup();
+    void initGpuTimer();
+    void beginGpuTimer();
+    void endGpuTimer();
+    void pollGpuTimer();
+    void stopProgramWarmup();
     EGLint queryBufferAge(EGLSurface surface);
 
     RenderThread& mRenderThread;
@@ -82,6 +96,19 @@ private:
 
     EGLSurface mCurrentSurface;
 
+    // Timer queries of the frames in flight, see GL_EXT_disjoint_timer_query
+    static const int kGpuTimerQueryCount = 4;
+    bool mHasGpuTimer = false;
+    GLuint mGpuTimerQueries[kGpuTimerQueryCount];
+    int mGpuTimerFirstPending = 0;
+    int mGpuTimerPendingCount = 0;
+    bool mGpuTimerActive = false;
+    nsecs_t mLastGpuDuration = 0;
+
+    // Compiles the programs of the previous runs on a context shared with mEglContext
+    std::thread mWarmupThread;
+    std::atomic<bool> mWarmupCancelled;
+
     enum class SwapBehavior {
         Discard,
         Preserved,
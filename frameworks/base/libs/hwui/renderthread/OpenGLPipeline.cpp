@@ -107,6 +107,7 @@ bool OpenGLPipeline::swapBuffers(const Frame& frame, bool drew, const SkRect& sc
     // Even if we decided to cancel the frame, from the perspective of jank
     // metrics the frame was swapped at this point
     currentFrameInfo->markSwapBuffers();
+    currentFrameInfo->set(FrameInfoIndex::GpuDuration) = mEglManager.takeGpuDuration();
 
     *requireSwap = drew || mEglManager.damageRequiresSwap();
 
@@ -25,6 +25,7 @@
 #include <GrBackendSurface.h>
 #include <GrContext.h>
 #include <GrTypes.h>
+#include <system/window.h>
 #include <vk/GrVkTypes.h>
 
 namespace android {
@@ -90,6 +91,17 @@ void VulkanManager::initialize() {
     GET_DEV_PROC(DestroyFence);
     GET_DEV_PROC(WaitForFences);
     GET_DEV_PROC(ResetFences);
+    GET_PROC(GetPhysicalDeviceProperties);
+    GET_DEV_PROC(CreateQueryPool);
+    GET_DEV_PROC(DestroyQueryPool);
+    GET_DEV_PROC(CmdResetQueryPool);
+    GET_DEV_PROC(CmdWriteTimestamp);
+    GET_DEV_PROC(GetQueryPoolResults);
+
+    VkPhysicalDeviceProperties physicalDeviceProperties;
+    mGetPhysicalDeviceProperties(mBackendContext->fPhysicalDevice, &physicalDeviceProperties);
+    mTimestampPeriod = physicalDeviceProperties.limits.timestampComputeAndGraphics
+            ? physicalDeviceProperties.limits.timestampPeriod : 0;
 
     // create the command pool for the command buffers
     if (VK_NULL_HANDLE == mCommandPool) {
@@ -142,9 +154,33 @@ VulkanSurface::BackbufferInfo* VulkanManager::getAvailableBackbuffer(VulkanSurfa
 }
 
 
+void VulkanManager::readTimestamps(VulkanSurface* surface,
+        VulkanSurface::BackbufferInfo* backbuffer) {
+    if (!backbuffer->mTimestampsWritten) return;
+    backbuffer->mTimestampsWritten = false;
+
+    // The backbuffer's fences have signaled, so both timestamps are available
+    uint64_t timestamps[2];
+    uint32_t firstQuery = 2 * (backbuffer - surface->mBackbuffers);
+    VkResult res = mGetQueryPoolResults(mBackendContext->fDevice, surface->mTimestampQueryPool,
+            firstQuery, 2, sizeof(timestamps), timestamps, sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT);
+    if (res == VK_SUCCESS && timestamps[1] > timestamps[0]) {
+        mLastGpuDuration = static_cast<nsecs_t>((timestamps[1] - timestamps[0])
+                * mTimestampPeriod);
+    }
+}
+
+nsecs_t VulkanManager::takeGpuDuration() {
+    nsecs_t duration = mLastGpuDuration;
+    mLastGpuDuration = 0;
+    return duration;
+}
+
 SkSurface* VulkanManager::getBackbufferSurface(VulkanSurface* surface) {
     VulkanSurface::BackbufferInfo* backbuffer = getAvailableBackbuffer(surface);
     SkASSERT(backbuffer);
+    readTimestamps(surface, backbuffer);
 
     VkResult res;
 
@@ -213,6 +249,15 @@ SkSurface* VulkanManager::getBackbufferSurface(VulkanSurface* surface) {
     mCmdPipelineBarrier(backbuffer->mTransitionCmdBuffers[0], srcStageMask, dstStageMask, 0,
             0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 
+    if (surface->mTimestampQueryPool != VK_NULL_HANDLE) {
+        // The frame's GPU time starts once the image is acquired and transitioned
+        uint32_t firstQuery = 2 * surface->mCurrentBackbufferIndex;
+        mCmdResetQueryPool(backbuffer->mTransitionCmdBuffers[0], surface->mTimestampQueryPool,
+                firstQuery, 2);
+        mCmdWriteTimestamp(backbuffer->mTransitionCmdBuffers[0],
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, surface->mTimestampQueryPool, firstQuery);
+    }
+
     mEndCommandBuffer(backbuffer->mTransitionCmdBuffers[0]);
 
     VkPipelineStageFlags waitDstStageFlags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
@@ -259,6 +304,11 @@ void VulkanManager::destroyBuffers(VulkanSurface* surface) {
         }
     }
 
+    if (surface->mTimestampQueryPool != VK_NULL_HANDLE) {
+        mDestroyQueryPool(mBackendContext->fDevice, surface->mTimestampQueryPool, nullptr);
+        surface->mTimestampQueryPool = VK_NULL_HANDLE;
+    }
+
     delete[] surface->mBackbuffers;
     surface->mBackbuffers = nullptr;
     delete[] surface->mImageInfos;
@@ -356,6 +406,18 @@ void VulkanManager::createBuffers(VulkanSurface* surface, VkFormat format, VkExt
         SkASSERT(VK_SUCCESS == res);
     }
     surface->mCurrentBackbufferIndex = surface->mImageCount;
+
+    if (mTimestampPeriod > 0) {
+        VkQueryPoolCreateInfo queryPoolInfo;
+        memset(&queryPoolInfo, 0, sizeof(VkQueryPoolCreateInfo));
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = 2 * (surface->mImageCount + 1);
+        if (mCreateQueryPool(mBackendContext->fDevice, &queryPoolInfo, nullptr,
+                &surface->mTimestampQueryPool) != VK_SUCCESS) {
+            surface->mTimestampQueryPool = VK_NULL_HANDLE;
+        }
+    }
 }
 
 bool VulkanManager::createSwapchain(VulkanSurface* surface) {
@@ -516,6 +578,7 @@ VulkanSurface* VulkanManager::createSurface(ANativeWindow* window) {
     }
 
     VulkanSurface* surface = new VulkanSurface();
+    surface->mNativeWindow = window;
 
     VkAndroidSurfaceCreateInfoKHR surfaceCreateInfo;
     memset(&surfaceCreateInfo, 0, sizeof(VkAndroidSurfaceCreateInfoKHR));
@@ -594,7 +657,21 @@ static VkAccessFlags layoutToSrcAccessMask(const VkImageLayout layout) {
     return flags;
 }
 
-void VulkanManager::swapBuffers(VulkanSurface* surface) {
+void VulkanManager::setSurfaceDamage(VulkanSurface* surface, const SkRect& dirtyRect,
+        int height) {
+    SkIRect dirty;
+    dirtyRect.roundOut(&dirty);
+    // The native window expects the bottom-left origin used by eglSwapBuffersWithDamageKHR,
+    // with top above bottom
+    android_native_rect_t rect;
+    rect.left = dirty.left();
+    rect.right = dirty.right();
+    rect.top = height - dirty.top();
+    rect.bottom = height - dirty.bottom();
+    native_window_set_surface_damage(surface->mNativeWindow, &rect, 1);
+}
+
+void VulkanManager::swapBuffers(VulkanSurface* surface, const SkRect& dirtyRect) {
     if (CC_UNLIKELY(Properties::waitForGpuCompletion)) {
         ATRACE_NAME("Finishing GPU work");
         mDeviceWaitIdle(mBackendContext->fDevice);
@@ -638,6 +715,13 @@ void VulkanManager::swapBuffers(VulkanSurface* surface) {
     mBeginCommandBuffer(backbuffer->mTransitionCmdBuffers[1], &info);
     mCmdPipelineBarrier(backbuffer->mTransitionCmdBuffers[1], srcStageMask, dstStageMask, 0,
             0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+    if (surface->mTimestampQueryPool != VK_NULL_HANDLE) {
+        // ... and ends once all of its rendering is done
+        mCmdWriteTimestamp(backbuffer->mTransitionCmdBuffers[1],
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, surface->mTimestampQueryPool,
+                2 * surface->mCurrentBackbufferIndex + 1);
+        backbuffer->mTimestampsWritten = true;
+    }
     mEndCommandBuffer(backbuffer->mTransitionCmdBuffers[1]);
 
     surface->mImageInfos[backbuffer->mImageIndex].mImageLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
@@ -673,6 +757,15 @@ void VulkanManager::swapBuffers(VulkanSurface* surface) {
         NULL // pResults
     };
 
+    // The image was only fully repainted if it had no usable content. Otherwise let the
+    // compositor know which part of it changed, as eglSwapBuffersWithDamageKHR does for GL.
+    // This is what VK_KHR_incremental_present would do, but Skia doesn't enable that extension
+    // on the device it creates, so the damage goes to the window directly. The window consumes
+    // it on the queueBuffer() done by the present below.
+    if (mSwapBehavior == SwapBehavior::BufferAge && !dirtyRect.isEmpty()) {
+        setSurfaceDamage(surface, dirtyRect, skSurface->height());
+    }
+
     mQueuePresentKHR(mPresentQueue, &presentInfo);
 
     surface->mBackbuffer.reset();
@@ -18,6 +18,7 @@
 #define VULKANMANAGER_H
 
 #include <SkSurface.h>
+#include <utils/Timers.h>
 #include <vk/GrVkBackendContext.h>
 
 #include <vulkan/vulkan.h>
@@ -44,6 +45,8 @@ private:
         // We use these fences to make sure the above Command buffers have finished their work
         // before attempting to reuse them or destroy them.
         VkFence         mUsageFences[2];
+        // Whether the timestamps of this backbuffer's queries were written by its last frame
+        bool            mTimestampsWritten = false;
     };
 
     struct ImageInfo {
@@ -55,6 +58,7 @@ private:
 
     sk_sp<SkSurface> mBackbuffer;
 
+    ANativeWindow* mNativeWindow = nullptr;
     VkSurfaceKHR mVkSurface = VK_NULL_HANDLE;
     VkSwapchainKHR mSwapchain = VK_NULL_HANDLE;
 
@@ -65,6 +69,9 @@ private:
     VkImage* mImages;
     ImageInfo* mImageInfos;
     uint16_t mCurrentTime = 0;
+
+    // Start and end timestamps of the frames, two queries per backbuffer
+    VkQueryPool mTimestampQueryPool = VK_NULL_HANDLE;
 };
 
 // This class contains the shared global Vulkan objects, such as VkInstance, VkDevice and VkQueue,
@@ -101,8 +108,13 @@ public:
     // by the client for drawing.
     SkSurface* getBackbufferSurface(VulkanSurface* surface);
 
-    // Presents the current VkImage.
-    void swapBuffers(VulkanSurface* surface);
+    // Returns the GPU time of the most recent frame whose timestamps became available since the
+    // last call, or 0 if there is none.
+    nsecs_t takeGpuDuration();
+
+    // Presents the current VkImage. When buffer age is in use, only dirtyRect (in top-left origin
+    // surface coordinates) is reported as damaged to the compositor.
+    void swapBuffers(VulkanSurface* surface, const SkRect& dirtyRect);
 
 private:
     friend class RenderThread;
@@ -117,6 +129,10 @@ private:
 
     VulkanSurface::BackbufferInfo* getAvailableBackbuffer(VulkanSurface* surface);
 
+    void readTimestamps(VulkanSurface* surface, VulkanSurface::BackbufferInfo* backbuffer);
+
+    void setSurfaceDamage(VulkanSurface* surface, const SkRect& dirtyRect, int height);
+
     // simple wrapper class that exists only to initialize a pointer to NULL
     template <typename FNPTR_TYPE> class VkPtr {
     public:
@@ -164,6 +180,13 @@ private:
     VkPtr<PFN_vkWaitForFences> mWaitForFences;
     VkPtr<PFN_vkResetFences> mResetFences;
 
+    VkPtr<PFN_vkGetPhysicalDeviceProperties> mGetPhysicalDeviceProperties;
+    VkPtr<PFN_vkCreateQueryPool> mCreateQueryPool;
+    VkPtr<PFN_vkDestroyQueryPool> mDestroyQueryPool;
+    VkPtr<PFN_vkCmdResetQueryPool> mCmdResetQueryPool;
+    VkPtr<PFN_vkCmdWriteTimestamp> mCmdWriteTimestamp;
+    VkPtr<PFN_vkGetQueryPoolResults> mGetQueryPoolResults;
+
     RenderThread& mRenderThread;
 
     sk_sp<const GrVkBackendContext> mBackendContext;
@@ -176,6 +199,10 @@ private:
         BufferAge,
     };
     SwapBehavior mSwapBehavior = SwapBehavior::Discard;
+
+    // Nanoseconds per timestamp tick, 0 if the graphics queue can't be timed
+    float mTimestampPeriod = 0;
+    nsecs_t mLastGpuDuration = 0;
 };
 
 } /* namespace renderthread */
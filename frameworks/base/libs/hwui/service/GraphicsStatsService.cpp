@@ -23,6 +23,8 @@
 #include <log/log.h>
 
 #include <inttypes.h>
+#include <list>
+#include <mutex>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -109,6 +111,91 @@ private:
     io::CopyingOutputStreamAdaptor mImpl;
 };
 
+// Keeps the protos last written by saveBuffer(), so that saving the next buffer of a package
+// merges it into the stats in memory rather than parsing the whole file again. An entry is only
+// used while the file still has the inode, size and modification time it had when written.
+class StatsCache {
+public:
+    // Moves the cached stats of path into output. Returns false if there are none or the file
+    // changed since they were written.
+    bool take(const std::string& path, service::GraphicsStatsProto* output) {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = findLocked(path);
+        if (it == mEntries.end()) {
+            return false;
+        }
+        output->Swap(&it->proto);
+        mEntries.erase(it);
+        return true;
+    }
+
+    // Copies the cached stats of path into output, with the same checks as take().
+    bool copy(const std::string& path, service::GraphicsStatsProto* output) {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = findLocked(path);
+        if (it == mEntries.end()) {
+            return false;
+        }
+        output->CopyFrom(it->proto);
+        return true;
+    }
+
+    // Remembers proto as the content of the file at path, which was opened as fd.
+    void put(const std::string& path, int fd, service::GraphicsStatsProto* proto) {
+        Entry entry;
+        if (fstat(fd, &entry.fileStat)) {
+            return;
+        }
+        entry.path = path;
+        entry.proto.Swap(proto);
+
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (it->path == path) {
+                mEntries.erase(it);
+                break;
+            }
+        }
+        mEntries.push_front(std::move(entry));
+        if (mEntries.size() > kMaxEntries) {
+            mEntries.pop_back();
+        }
+    }
+
+private:
+    // One per package that saved a buffer recently.
+    static constexpr size_t kMaxEntries = 32;
+
+    struct Entry {
+        std::string path;
+        struct stat fileStat;
+        service::GraphicsStatsProto proto;
+    };
+
+    std::list<Entry>::iterator findLocked(const std::string& path) {
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (it->path != path) {
+                continue;
+            }
+            struct stat sb;
+            if (stat(path.c_str(), &sb) || sb.st_ino != it->fileStat.st_ino
+                    || sb.st_dev != it->fileStat.st_dev || sb.st_size != it->fileStat.st_size
+                    || sb.st_mtim.tv_sec != it->fileStat.st_mtim.tv_sec
+                    || sb.st_mtim.tv_nsec != it->fileStat.st_mtim.tv_nsec) {
+                mEntries.erase(it);
+                return mEntries.end();
+            }
+            return it;
+        }
+        return mEntries.end();
+    }
+
+    std::mutex mLock;
+    std::list<Entry> mEntries;
+};
+
+static StatsCache sStatsCache;
+
 bool GraphicsStatsService::parseFromFile(const std::string& path, service::GraphicsStatsProto* output) {
 
     FileDescriptor fd{open(path.c_str(), O_RDONLY)};
@@ -133,7 +220,7 @@ bool GraphicsStatsService::parseFromFile(const std::string& path, service::Graph
         return false;
     }
     void* addr = mmap(nullptr, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
-    if (!addr) {
+    if (addr == MAP_FAILED) {
         int err = errno;
         // The file not existing is normal for addToDump(), so only log if
         // we get an unexpected error
@@ -145,6 +232,7 @@ bool GraphicsStatsService::parseFromFile(const std::string& path, service::Graph
     uint32_t file_version = *reinterpret_cast<uint32_t*>(addr);
     if (file_version != sCurrentFileVersion) {
         ALOGW("file_version mismatch! expected %d got %d", sCurrentFileVersion, file_version);
+        munmap(addr, sb.st_size);
         return false;
     }
 
@@ -156,6 +244,7 @@ bool GraphicsStatsService::parseFromFile(const std::string& path, service::Graph
         ALOGW("Parse failed on '%s' error='%s'",
                 path.c_str(), output->InitializationErrorString().c_str());
     }
+    munmap(addr, sb.st_size);
     return success;
 }
 
@@ -251,7 +340,7 @@ void dumpAsTextToFd(service::GraphicsStatsProto* proto, int fd) {
 void GraphicsStatsService::saveBuffer(const std::string& path, const std::string& package,
         int versionCode, int64_t startTime, int64_t endTime, const ProfileData* data) {
     service::GraphicsStatsProto statsProto;
-    if (!parseFromFile(path, &statsProto)) {
+    if (!sStatsCache.take(path, &statsProto) && !parseFromFile(path, &statsProto)) {
         statsProto.Clear();
     }
     mergeProfileDataIntoProto(&statsProto, package, versionCode, startTime, endTime, data);
@@ -286,6 +375,9 @@ void GraphicsStatsService::saveBuffer(const std::string& path, const std::string
         } else if (!success) {
             ALOGW("Serialize failed on '%s' unknown error", path.c_str());
         }
+        if (success) {
+            sStatsCache.put(path, outFd, &statsProto);
+        }
     }
     close(outFd);
 }
@@ -309,7 +401,8 @@ GraphicsStatsService::Dump* GraphicsStatsService::createDump(int outFd, DumpType
 void GraphicsStatsService::addToDump(Dump* dump, const std::string& path, const std::string& package,
         int versionCode, int64_t startTime, int64_t endTime, const ProfileData* data) {
     service::GraphicsStatsProto statsProto;
-    if (!path.empty() && !parseFromFile(path, &statsProto)) {
+    if (!path.empty() && !sStatsCache.copy(path, &statsProto)
+            && !parseFromFile(path, &statsProto)) {
         statsProto.Clear();
     }
     if (data) {
@@ -330,7 +423,7 @@ void GraphicsStatsService::addToDump(Dump* dump, const std::string& path, const
 
 void GraphicsStatsService::addToDump(Dump* dump, const std::string& path) {
     service::GraphicsStatsProto statsProto;
-    if (!parseFromFile(path, &statsProto)) {
+    if (!sStatsCache.copy(path, &statsProto) && !parseFromFile(path, &statsProto)) {
         return;
     }
     if (dump->type() == DumpType::Protobuf) {
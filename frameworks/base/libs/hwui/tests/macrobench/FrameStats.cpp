@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameStats.h"
+
+#include "GpuMemoryTracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/stat.h>
+
+namespace android {
+namespace uirenderer {
+namespace test {
+
+static const char* METRIC_NAMES[] = {
+        "total",
+        "sync",
+        "draw",
+        "swap",
+        "dequeue_buffer",
+        "queue_buffer",
+        "gpu",
+        "gpu_memory",
+};
+
+static_assert(static_cast<int>(FrameMetric::Count) == (sizeof(METRIC_NAMES) / sizeof(METRIC_NAMES[0])),
+        "Number of metric names doesn't match the number of metrics!");
+
+static constexpr double SIGNIFICANCE_LEVEL = 0.01;
+
+int64_t FrameSample::metric(FrameMetric metric) const {
+    auto get = [this](FrameInfoIndex index) {
+        return info[static_cast<int>(index)];
+    };
+    auto duration = [&get](FrameInfoIndex start, FrameInfoIndex end) {
+        int64_t startTime = get(start);
+        return startTime > 0 ? std::max<int64_t>(get(end) - startTime, 0) : 0;
+    };
+    switch (metric) {
+    case FrameMetric::Total:
+        return duration(FrameInfoIndex::IntendedVsync, FrameInfoIndex::FrameCompleted);
+    case FrameMetric::Sync:
+        return duration(FrameInfoIndex::SyncStart, FrameInfoIndex::IssueDrawCommandsStart);
+    case FrameMetric::Draw:
+        return duration(FrameInfoIndex::IssueDrawCommandsStart, FrameInfoIndex::SwapBuffers);
+    case FrameMetric::Swap:
+        return duration(FrameInfoIndex::SwapBuffers, FrameInfoIndex::FrameCompleted);
+    case FrameMetric::DequeueBuffer:
+        return get(FrameInfoIndex::DequeueBufferDuration);
+    case FrameMetric::QueueBuffer:
+        return get(FrameInfoIndex::QueueBufferDuration);
+    case FrameMetric::Gpu:
+        return get(FrameInfoIndex::GpuDuration);
+    case FrameMetric::GpuMemory:
+        return gpuMemory;
+    default:
+        return 0;
+    }
+}
+
+void FrameStatsRecorder::notify(const int64_t* buffer) {
+    FrameSample sample;
+    memcpy(sample.info, buffer, sizeof(sample.info));
+    sample.gpuMemory = 0;
+    for (int type = 0; type < static_cast<int>(GpuObjectType::TypeCount); type++) {
+        sample.gpuMemory += GpuMemoryTracker::getTotalSize(static_cast<GpuObjectType>(type));
+    }
+    mSamples.push_back(sample);
+}
+
+const char* FrameStats::metricName(FrameMetric metric) {
+    return METRIC_NAMES[static_cast<int>(metric)];
+}
+
+void FrameStats::writeSamples(FILE* file, const std::string& scene,
+        const std::vector<FrameSample>& samples) {
+    struct stat st;
+    if (fstat(fileno(file), &st) == 0 && st.st_size == 0) {
+        fprintf(file, "scene,frame");
+        for (int m = 0; m < static_cast<int>(FrameMetric::Count); m++) {
+            fprintf(file, ",%s", metricName(static_cast<FrameMetric>(m)));
+        }
+        fprintf(file, "\n");
+    }
+    for (size_t i = 0; i < samples.size(); i++) {
+        fprintf(file, "%s,%zu", scene.c_str(), i);
+        for (int m = 0; m < static_cast<int>(FrameMetric::Count); m++) {
+            fprintf(file, ",%" PRId64, samples[i].metric(static_cast<FrameMetric>(m)));
+        }
+        fprintf(file, "\n");
+    }
+    fflush(file);
+}
+
+bool FrameStats::readBaseline(const char* path, SceneSamples* outSamples) {
+    FILE* file = fopen(path, "re");
+    if (!file) {
+        fprintf(stderr, "Failed to open baseline '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+    char line[1024];
+    int lineNumber = 0;
+    bool success = true;
+    while (fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        if (!strncmp(line, "scene,", 6)) {
+            // header, possibly repeated if several files were concatenated
+            continue;
+        }
+        char* savePtr = nullptr;
+        const char* scene = strtok_r(line, ",", &savePtr);
+        const char* frame = strtok_r(nullptr, ",", &savePtr);
+        const char* total = strtok_r(nullptr, ",\n", &savePtr);
+        if (!scene || !frame || !total) {
+            fprintf(stderr, "Malformed baseline '%s' at line %d\n", path, lineNumber);
+            success = false;
+            break;
+        }
+        (*outSamples)[scene].push_back(strtod(total, nullptr));
+    }
+    fclose(file);
+    return success;
+}
+
+double FrameStats::percentile(std::vector<double> values, int p) {
+    if (values.empty()) return 0;
+    size_t index = static_cast<size_t>(std::round((values.size() - 1) * p / 100.0));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void FrameStats::printPercentiles(FILE* out, const std::string& scene,
+        const std::vector<FrameSample>& samples) {
+    static const int PERCENTILES[] = { 50, 90, 95, 99 };
+
+    fprintf(out, "%s (%zu frames)\n", scene.c_str(), samples.size());
+    fprintf(out, "  %-16s %10s %10s %10s %10s\n", "metric", "50th", "90th", "95th", "99th");
+    std::vector<double> values(samples.size());
+    for (int m = 0; m < static_cast<int>(FrameMetric::Count); m++) {
+        FrameMetric metric = static_cast<FrameMetric>(m);
+        // Durations are reported in ms, memory in kB
+        const double divisor = metric == FrameMetric::GpuMemory ? 1024.0 : 1000000.0;
+        for (size_t i = 0; i < samples.size(); i++) {
+            values[i] = samples[i].metric(metric) / divisor;
+        }
+        fprintf(out, "  %-16s", metricName(metric));
+        for (int p : PERCENTILES) {
+            fprintf(out, " %10.2f", percentile(values, p));
+        }
+        fprintf(out, "\n");
+    }
+}
+
+double FrameStats::mannWhitneyPValue(const std::vector<double>& a, const std::vector<double>& b) {
+    const double n1 = a.size();
+    const double n2 = b.size();
+    if (!n1 || !n2) return 1;
+
+    std::vector<std::pair<double, bool>> values;
+    values.reserve(a.size() + b.size());
+    for (double v : a) values.emplace_back(v, true);
+    for (double v : b) values.emplace_back(v, false);
+    std::sort(values.begin(), values.end());
+
+    // Ranks are 1-based and ties share the average of their ranks
+    double rankSumA = 0;
+    double tieCorrection = 0;
+    for (size_t i = 0; i < values.size();) {
+        size_t j = i;
+        while (j < values.size() && values[j].first == values[i].first) j++;
+        const double rank = (i + 1 + j) / 2.0;
+        for (size_t k = i; k < j; k++) {
+            if (values[k].second) rankSumA += rank;
+        }
+        const double ties = j - i;
+        tieCorrection += ties * ties * ties - ties;
+        i = j;
+    }
+
+    const double n = n1 + n2;
+    const double u = rankSumA - n1 * (n1 + 1) / 2;
+    const double mean = n1 * n2 / 2;
+    const double variance = n1 * n2 / 12 * ((n + 1) - tieCorrection / (n * (n - 1)));
+    if (variance <= 0) return 1;
+    const double z = (u - mean) / std::sqrt(variance);
+    return std::erfc(std::fabs(z) / std::sqrt(2.0));
+}
+
+BaselineComparison FrameStats::compare(const std::vector<double>& baseline,
+        const std::vector<double>& current, double thresholdPercent) {
+    BaselineComparison result;
+    result.baselineMedian = percentile(baseline, 50);
+    result.currentMedian = percentile(current, 50);
+    result.pValue = mannWhitneyPValue(baseline, current);
+    result.regressed = result.pValue < SIGNIFICANCE_LEVEL
+            && result.currentMedian > result.baselineMedian * (1 + thresholdPercent / 100);
+    return result;
+}
+
+} /* namespace test */
+} /* namespace uirenderer */
+} /* namespace android */
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "FrameInfo.h"
+#include "FrameMetricsObserver.h"
+
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+namespace uirenderer {
+namespace test {
+
+enum class FrameMetric {
+    Total = 0,
+    Sync,
+    Draw,
+    Swap,
+    DequeueBuffer,
+    QueueBuffer,
+    Gpu,
+    GpuMemory,
+
+    Count,
+};
+
+struct FrameSample {
+    int64_t info[static_cast<int>(FrameInfoIndex::NumIndexes)];
+    // Total size of the GPU objects tracked by GpuMemoryTracker once the frame completed
+    int64_t gpuMemory;
+
+    int64_t metric(FrameMetric metric) const;
+};
+
+/**
+ * Captures the FrameInfo of every frame drawn while it is registered as a
+ * frame metrics observer. notify() is called on the RenderThread, so the
+ * samples must only be read after the RenderProxy has been fenced.
+ */
+class FrameStatsRecorder : public FrameMetricsObserver {
+public:
+    virtual void notify(const int64_t* buffer) override;
+
+    const std::vector<FrameSample>& samples() const { return mSamples; }
+    void clear() { mSamples.clear(); }
+
+private:
+    std::vector<FrameSample> mSamples;
+};
+
+/**
+ * Frame time samples, in nanoseconds, keyed by scene name
+ */
+typedef std::unordered_map<std::string, std::vector<double>> SceneSamples;
+
+struct BaselineComparison {
+    double baselineMedian;
+    double currentMedian;
+    // Two-sided p-value of the Mann-Whitney U test between both distributions
+    double pValue;
+    bool regressed;
+};
+
+class FrameStats {
+public:
+    static const char* metricName(FrameMetric metric);
+
+    /**
+     * Appends one CSV row per sample. The header is only written when the
+     * file is empty so that repeated runs can share a single file.
+     */
+    static void writeSamples(FILE* file, const std::string& scene,
+            const std::vector<FrameSample>& samples);
+
+    /**
+     * Loads the FrameMetric::Total column of a file produced by writeSamples.
+     */
+    static bool readBaseline(const char* path, SceneSamples* outSamples);
+
+    static void printPercentiles(FILE* out, const std::string& scene,
+            const std::vector<FrameSample>& samples);
+
+    /**
+     * Flags a regression when the current frame times are significantly
+     * (p < 0.01) slower than the baseline and the median grew by more than
+     * thresholdPercent.
+     */
+    static BaselineComparison compare(const std::vector<double>& baseline,
+            const std::vector<double>& current, double thresholdPercent);
+
+    static double percentile(std::vector<double> values, int p);
+    static double mannWhitneyPValue(const std::vector<double>& a, const std::vector<double>& b);
+};
+
+} /* namespace test */
+} /* namespace uirenderer */
+} /* namespace android */
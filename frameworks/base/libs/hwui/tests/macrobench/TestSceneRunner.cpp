@@ -15,6 +15,7 @@
  */
 
 #include "AnimationContext.h"
+#include "FrameStats.h"
 #include "RenderNode.h"
 #include "tests/common/TestContext.h"
 #include "tests/common/TestScene.h"
@@ -111,7 +112,7 @@ void outputBenchmarkReport(const TestScene::Info& info, const TestScene::Options
 }
 
 void run(const TestScene::Info& info, const TestScene::Options& opts,
-        benchmark::BenchmarkReporter* reporter) {
+        benchmark::BenchmarkReporter* reporter, FrameStatsRecorder* recorder) {
     // Switch to the real display
     gDisplay = getBuiltInDisplay();
 
@@ -155,6 +156,9 @@ void run(const TestScene::Info& info, const TestScene::Options& opts,
     }
 
     proxy->resetProfileInfo();
+    if (recorder) {
+        proxy->addFrameMetricsObserver(recorder);
+    }
     proxy->fence();
 
     ModifiedMovingAverage<double> avgMs(opts.reportFrametimeWeight);
@@ -181,6 +185,11 @@ void run(const TestScene::Info& info, const TestScene::Options& opts,
     proxy->fence();
     nsecs_t end = systemTime(CLOCK_MONOTONIC);
 
+    if (recorder) {
+        proxy->removeFrameMetricsObserver(recorder);
+        proxy->fence();
+    }
+
     if (reporter) {
         outputBenchmarkReport(info, opts, reporter, proxy.get(),
                 (end - start) / (double) s2ns(1));
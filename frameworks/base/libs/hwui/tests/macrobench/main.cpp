@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include "FrameStats.h"
 #include "tests/common/LeakChecker.h"
 #include "tests/common/TestScene.h"
 
@@ -44,9 +45,12 @@ static int gRepeatCount = 1;
 static std::vector<TestScene::Info> gRunTests;
 static TestScene::Options gOpts;
 std::unique_ptr<benchmark::BenchmarkReporter> gBenchmarkReporter;
+static FILE* gFrameStatsFile = nullptr;
+static const char* gBaselinePath = nullptr;
+static double gRegressionThreshold = 5;
 
 void run(const TestScene::Info& info, const TestScene::Options& opts,
-        benchmark::BenchmarkReporter* reporter);
+        benchmark::BenchmarkReporter* reporter, FrameStatsRecorder* recorder);
 
 static void printHelp() {
     printf(R"(
@@ -68,6 +72,14 @@ OPTIONS:
   --onscreen           Render tests on device screen. By default tests
                        are offscreen rendered
   --benchmark_format   Set output format. Possible values are tabular, json, csv
+  --frame-stats=file   Append the per-frame FrameInfo breakdown and GPU memory
+                       of every test to file as CSV, and print percentiles
+                       of each metric to stderr
+  --baseline=file      Compare the frame times against a file produced by
+                       --frame-stats and exit with an error if any test
+                       regressed significantly
+  --regression-threshold=percent Minimum growth of the median frame time
+                       to report as a regression. Default is 5
 )");
 }
 
@@ -157,6 +169,9 @@ enum {
     BenchmarkFormat,
     Onscreen,
     Offscreen,
+    FrameStats,
+    Baseline,
+    RegressionThreshold,
 };
 }
 
@@ -171,6 +186,9 @@ static const struct option LONG_OPTIONS[] = {
     { "benchmark_format", required_argument, nullptr, LongOpts::BenchmarkFormat },
     { "onscreen", no_argument, nullptr, LongOpts::Onscreen },
     { "offscreen", no_argument, nullptr, LongOpts::Offscreen },
+    { "frame-stats", required_argument, nullptr, LongOpts::FrameStats },
+    { "baseline", required_argument, nullptr, LongOpts::Baseline },
+    { "regression-threshold", required_argument, nullptr, LongOpts::RegressionThreshold },
     { 0, 0, 0, 0 }
 };
 
@@ -262,6 +280,27 @@ void parseOptions(int argc, char* argv[]) {
             gOpts.renderOffscreen = true;
             break;
 
+        case LongOpts::FrameStats:
+            gFrameStatsFile = fopen(optarg, "ae");
+            if (!gFrameStatsFile) {
+                fprintf(stderr, "Failed to open frame stats file '%s': %s\n",
+                        optarg, strerror(errno));
+                error = true;
+            }
+            break;
+
+        case LongOpts::Baseline:
+            gBaselinePath = optarg;
+            break;
+
+        case LongOpts::RegressionThreshold:
+            gRegressionThreshold = atof(optarg);
+            if (gRegressionThreshold < 0) {
+                fprintf(stderr, "Invalid regression threshold '%s'\n", optarg);
+                error = true;
+            }
+            break;
+
         case 'h':
             printHelp();
             exit(EXIT_SUCCESS);
@@ -327,9 +366,32 @@ int main(int argc, char* argv[]) {
         gBenchmarkReporter->ReportContext(context);
     }
 
+    SceneSamples baseline;
+    if (gBaselinePath && !FrameStats::readBaseline(gBaselinePath, &baseline)) {
+        return EXIT_FAILURE;
+    }
+
+    sp<FrameStatsRecorder> recorder;
+    if (gFrameStatsFile || gBaselinePath) {
+        recorder = new FrameStatsRecorder();
+    }
+    SceneSamples current;
+
     for (int i = 0; i < gRepeatCount; i++) {
         for (auto&& test : gRunTests) {
-            run(test, gOpts, gBenchmarkReporter.get());
+            run(test, gOpts, gBenchmarkReporter.get(), recorder.get());
+            if (!recorder.get()) continue;
+
+            // stdout belongs to the benchmark reporter, keep it parseable
+            FrameStats::printPercentiles(stderr, test.name, recorder->samples());
+            if (gFrameStatsFile) {
+                FrameStats::writeSamples(gFrameStatsFile, test.name, recorder->samples());
+            }
+            std::vector<double>& frameTimes = current[test.name];
+            for (auto& sample : recorder->samples()) {
+                frameTimes.push_back(sample.metric(FrameMetric::Total));
+            }
+            recorder->clear();
         }
     }
 
@@ -337,6 +399,32 @@ int main(int argc, char* argv[]) {
         gBenchmarkReporter->Finalize();
     }
 
+    int result = EXIT_SUCCESS;
+    if (gBaselinePath) {
+        fprintf(stderr, "\n%-24s %14s %14s %8s %10s\n",
+                "test", "baseline 50th", "current 50th", "change", "p-value");
+        for (auto& entry : current) {
+            auto pos = baseline.find(entry.first);
+            if (pos == baseline.end()) {
+                fprintf(stderr, "%-24s missing from baseline\n", entry.first.c_str());
+                continue;
+            }
+            BaselineComparison comparison = FrameStats::compare(pos->second, entry.second,
+                    gRegressionThreshold);
+            fprintf(stderr, "%-24s %12.2fms %12.2fms %+7.1f%% %10.4f%s\n", entry.first.c_str(),
+                    comparison.baselineMedian / 1000000.0, comparison.currentMedian / 1000000.0,
+                    (comparison.currentMedian / comparison.baselineMedian - 1) * 100,
+                    comparison.pValue, comparison.regressed ? "  REGRESSED" : "");
+            if (comparison.regressed) {
+                result = EXIT_FAILURE;
+            }
+        }
+    }
+
+    if (gFrameStatsFile) {
+        fclose(gFrameStatsFile);
+    }
+
     LeakChecker::checkForLeaks();
-    return 0;
+    return result;
 }
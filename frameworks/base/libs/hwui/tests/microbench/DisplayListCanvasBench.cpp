@@ -114,6 +114,25 @@ void BM_DisplayListCanvas_record_simpleBitmapView(benchmark::State& benchState)
 }
 BENCHMARK(BM_DisplayListCanvas_record_simpleBitmapView);
 
+/**
+ * Records enough ops to span several allocator pages, as a long list or a complex view would.
+ */
+void BM_DisplayListCanvas_record_manyRects(benchmark::State& benchState) {
+    std::unique_ptr<Canvas> canvas(Canvas::create_recording_canvas(100, 100));
+    delete canvas->finishRecording();
+
+    SkPaint rectPaint;
+    while (benchState.KeepRunning()) {
+        canvas->resetRecording(100, 100);
+        for (int i = 0; i < 500; i++) {
+            canvas->drawRect(0, i, 100, i + 1, rectPaint);
+        }
+        benchmark::DoNotOptimize(canvas.get());
+        delete canvas->finishRecording();
+    }
+}
+BENCHMARK(BM_DisplayListCanvas_record_manyRects);
+
 class NullClient: public CanvasStateClient {
     void onViewportInitialized() override {}
     void onSnapshotRestored(const Snapshot& removed, const Snapshot& restored) {}
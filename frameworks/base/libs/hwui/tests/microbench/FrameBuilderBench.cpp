@@ -71,6 +71,39 @@ void BM_FrameBuilder_defer(benchmark::State& state) {
 }
 BENCHMARK(BM_FrameBuilder_defer);
 
+static sp<RenderNode> createLongListNode() {
+    auto node = TestUtils::createNode<RecordingCanvas>(0, 0, 200, 2000,
+            [](RenderProperties& props, RecordingCanvas& canvas) {
+        sk_sp<Bitmap> bitmap(TestUtils::createBitmap(10, 10));
+        SkPaint paint;
+
+        // Many list items, each a bitmap over a rect, so every op has to be tested against the
+        // ops of the large batches deferred before it.
+        canvas.save(SaveFlags::MatrixClip);
+        for (int i = 0; i < 500; i++) {
+            canvas.translate(0, 4);
+            canvas.drawRect(0, 0, 200, 4, paint);
+            canvas.drawBitmap(*bitmap, 5, 0, nullptr);
+        }
+        canvas.restore();
+    });
+    TestUtils::syncHierarchyPropertiesAndDisplayList(node);
+    return node;
+}
+
+void BM_FrameBuilder_deferLongList(benchmark::State& state) {
+    TestUtils::runOnRenderThread([&state](RenderThread& thread) {
+        auto node = createLongListNode();
+        while (state.KeepRunning()) {
+            FrameBuilder frameBuilder(SkRect::MakeWH(200, 2000), 200, 2000,
+                    sLightGeometry, Caches::getInstance());
+            frameBuilder.deferRenderNode(*node);
+            benchmark::DoNotOptimize(&frameBuilder);
+        }
+    });
+}
+BENCHMARK(BM_FrameBuilder_deferLongList);
+
 void BM_FrameBuilder_deferAndRender(benchmark::State& state) {
     TestUtils::runOnRenderThread([&state](RenderThread& thread) {
         auto node = createTestNode();
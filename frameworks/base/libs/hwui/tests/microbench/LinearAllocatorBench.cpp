@@ -46,3 +46,20 @@ static void BM_LinearStdAllocator_vector(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_LinearStdAllocator_vector);
+
+/**
+ * Simulates re-recording a display list: many small ops, and a few large arrays such as the
+ * glyphs of a TextOp, all released together before the next recording.
+ */
+static void BM_LinearAllocator_rerecord(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        LinearAllocator la;
+        for (int i = 0; i < 200; i++) {
+            benchmark::DoNotOptimize(la.alloc<char>(64));
+            if (i % 50 == 0) {
+                benchmark::DoNotOptimize(la.create_trivial_array<uint16_t>(1024));
+            }
+        }
+    }
+}
+BENCHMARK(BM_LinearAllocator_rerecord);
@@ -109,3 +109,24 @@ void BM_TessellateShadows_roundrect_translucent(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_TessellateShadows_roundrect_translucent);
+
+void BM_ShadowContentDescription_lookup(benchmark::State& state) {
+    ShadowTestData shadowData;
+    createShadowTestData(&shadowData);
+    SkPath path;
+    path.addRoundRect(SkRect::MakeWH(100, 100), 5, 5);
+    // equal contents in separate storage, like a frame allocated copy of the outline
+    SkPath samePath;
+    samePath.addRoundRect(SkRect::MakeWH(100, 100), 5, 5);
+
+    TessellationCache::ShadowContentDescription retained(&shadowData.drawTransform,
+            shadowData.localClip, true, &path, &shadowData.casterTransformXY,
+            &shadowData.casterTransformZ, shadowData.lightCenter, shadowData.lightRadius);
+    while (state.KeepRunning()) {
+        TessellationCache::ShadowContentDescription lookup(&shadowData.drawTransform,
+                shadowData.localClip, true, &samePath, &shadowData.casterTransformXY,
+                &shadowData.casterTransformZ, shadowData.lightCenter, shadowData.lightRadius);
+        benchmark::DoNotOptimize(lookup.hash() == retained.hash() && lookup == retained);
+    }
+}
+BENCHMARK(BM_ShadowContentDescription_lookup);
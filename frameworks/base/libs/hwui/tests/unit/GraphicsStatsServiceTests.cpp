@@ -161,3 +161,28 @@ TEST(GraphicsStats, merge) {
         EXPECT_EQ(expectedBucket, loadedProto.histogram().Get(i).render_millis());
     }
 }
+
+TEST(GraphicsStats, saveAfterFileRemoved) {
+    std::string path = findRootPath() + "/test_saveAfterFileRemoved";
+    std::string packageName = "com.test.saveAfterFileRemoved";
+    MockProfileData mockData;
+    mockData.editJankFrameCount() = 20;
+    mockData.editTotalFrameCount() = 100;
+    GraphicsStatsService::saveBuffer(path, packageName, 5, 3000, 7000, &mockData);
+    // Stats kept from the first save must not come back once the file is gone
+    unlink(path.c_str());
+    mockData.editJankFrameCount() = 50;
+    mockData.editTotalFrameCount() = 500;
+    GraphicsStatsService::saveBuffer(path, packageName, 5, 7050, 10000, &mockData);
+
+    service::GraphicsStatsProto loadedProto;
+    EXPECT_TRUE(GraphicsStatsService::parseFromFile(path, &loadedProto));
+    // Clean up the file
+    unlink(path.c_str());
+
+    EXPECT_EQ(7050, loadedProto.stats_start());
+    EXPECT_EQ(10000, loadedProto.stats_end());
+    ASSERT_TRUE(loadedProto.has_summary());
+    EXPECT_EQ(50, loadedProto.summary().janky_frames());
+    EXPECT_EQ(500, loadedProto.summary().total_frames());
+}
@@ -86,6 +86,23 @@ TEST(LinearAllocator, rewind) {
     EXPECT_EQ(1, destroyed);
 }
 
+TEST(LinearAllocator, reusePages) {
+    void* small;
+    void* large;
+    {
+        LinearAllocator la;
+        small = la.alloc<char>(64);
+        large = la.alloc<char>(3000);
+    }
+    LinearAllocator la;
+    // Pages freed on this thread are handed out again, in the same size class
+    EXPECT_EQ(small, la.alloc<char>(64));
+    EXPECT_EQ(large, la.alloc<char>(3000));
+    EXPECT_EQ(2u, la.reusedPageCount());
+    // The dedicated page was rounded up to 4kb
+    EXPECT_LE(4096u - 3000u, la.wastedSize());
+}
+
 TEST(LinearStdAllocator, simpleAllocate) {
     LinearAllocator la;
     LinearStdAllocator<void*> stdAllocator(la);
@@ -177,6 +177,31 @@ RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, resize) {
     pool.putOrDelete(layer2);
 }
 
+RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, reuseWithSlack) {
+    OffscreenBufferPool pool;
+
+    auto layer = pool.get(renderThread.renderState(), 192u, 192u);
+
+    // shrinking by one bucket keeps the texture
+    ASSERT_EQ(layer, pool.resize(layer, 120u, 130u));
+    EXPECT_EQ(120u, layer->viewportWidth);
+    EXPECT_EQ(130u, layer->viewportHeight);
+    EXPECT_EQ(192u, layer->texture.width());
+    EXPECT_EQ(192u, layer->texture.height());
+
+    pool.putOrDelete(layer);
+    auto layer2 = pool.get(renderThread.renderState(), 130u, 100u);
+    EXPECT_EQ(layer, layer2) << "layer one bucket too tall should be recycled";
+    pool.putOrDelete(layer2);
+
+    auto layer3 = pool.get(renderThread.renderState(), 60u, 60u);
+    EXPECT_NE(layer, layer3) << "layer two buckets too big should not be recycled";
+    EXPECT_EQ(1u, pool.getCount());
+
+    pool.putOrDelete(layer3);
+    pool.clear();
+}
+
 RENDERTHREAD_OPENGL_PIPELINE_TEST(OffscreenBufferPool, resizeWideColorGamut) {
     OffscreenBufferPool pool;
 
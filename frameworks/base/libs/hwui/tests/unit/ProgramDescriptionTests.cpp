@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "Program.h"
+
+using namespace android;
+using namespace android::uirenderer;
+
+static void expectRoundTrip(const ProgramDescription& description) {
+    ProgramDescription decoded;
+    decoded.setFromKey(description.key());
+    EXPECT_EQ(description.key(), decoded.key());
+}
+
+TEST(ProgramDescription, setFromKey_default) {
+    ProgramDescription description;
+    expectRoundTrip(description);
+}
+
+TEST(ProgramDescription, setFromKey_bitmap) {
+    ProgramDescription description;
+    description.hasBitmap = true;
+    description.useShaderBasedWrap = true;
+    description.bitmapWrapS = GL_REPEAT;
+    description.bitmapWrapT = GL_MIRRORED_REPEAT;
+    description.hasGradient = true;
+    description.gradientType = ProgramDescription::kGradientSweep;
+    description.shadersMode = SkBlendMode::kMultiply;
+    description.isBitmapFirst = true;
+    description.modulate = true;
+    expectRoundTrip(description);
+}
+
+TEST(ProgramDescription, setFromKey_colorFilter) {
+    ProgramDescription description;
+    description.hasTexture = true;
+    description.hasAlpha8Texture = true;
+    description.colorOp = ProgramDescription::ColorFilterMode::Blend;
+    description.colorMode = SkBlendMode::kScreen;
+    description.framebufferMode = SkBlendMode::kDarken;
+    description.swapSrcDst = true;
+    description.hasRoundRectClip = true;
+    description.hasColorSpaceConversion = true;
+    description.transferFunction = TransferFunctionType::Full;
+    description.hasTranslucentConversion = true;
+    expectRoundTrip(description);
+}
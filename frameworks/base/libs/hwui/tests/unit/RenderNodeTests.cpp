@@ -335,3 +335,44 @@ RENDERTHREAD_TEST(RenderNode, prepareTree_HwLayer_AVD_enqueueDamage) {
     EXPECT_EQ(uirenderer::Rect(0, 0, 200, 400), info.layerUpdateQueue->entries().at(0).damage);
     canvasContext->destroy();
 }
+
+RENDERTHREAD_TEST(RenderNode, prepareTree_cleanSubtreeStillSeesStagedChanges) {
+    auto child = TestUtils::createNode(0, 0, 100, 100,
+            [](RenderProperties& props, Canvas& canvas) {
+        canvas.drawColor(Color::Red_500, SkBlendMode::kSrcOver);
+    });
+    auto rootNode = TestUtils::createNode(0, 0, 200, 400,
+            [&child](RenderProperties& props, Canvas& canvas) {
+        canvas.drawRenderNode(child.get());
+    });
+    ContextFactory contextFactory;
+    std::unique_ptr<CanvasContext> canvasContext(CanvasContext::create(
+            renderThread, false, rootNode.get(), &contextFactory));
+    DamageAccumulator damageAccumulator;
+    LayerUpdateQueue layerUpdateQueue;
+    SkRect dirty;
+
+    auto prepare = [&](TreeInfo::TraversalMode mode) {
+        TreeInfo info(mode, *canvasContext.get());
+        info.damageAccumulator = &damageAccumulator;
+        info.layerUpdateQueue = &layerUpdateQueue;
+        rootNode->prepareTree(info);
+        damageAccumulator.finish(&dirty);
+    };
+
+    prepare(TreeInfo::MODE_FULL);
+
+    // Nothing changed, so neither traversal should produce damage
+    prepare(TreeInfo::MODE_FULL);
+    EXPECT_TRUE(dirty.isEmpty());
+    prepare(TreeInfo::MODE_RT_ONLY);
+    EXPECT_TRUE(dirty.isEmpty());
+
+    // A change staged on the child must not be hidden by its clean parent
+    child->mutateStagingProperties().setTranslationX(10);
+    child->setPropertyFieldsDirty(RenderNode::TRANSLATION_X);
+    prepare(TreeInfo::MODE_FULL);
+    EXPECT_EQ(SkRect::MakeLTRB(0, 0, 110, 100), dirty);
+
+    canvasContext->destroy();
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "pipeline/skia/ShaderCache.h"
+
+#include <FileBlobCache.h>
+#include <SkData.h>
+#include <unistd.h>
+
+using namespace android;
+using namespace android::uirenderer::skiapipeline;
+
+namespace android {
+namespace uirenderer {
+namespace skiapipeline {
+
+class ShaderCacheTestUtils {
+public:
+    /**
+     * Writes the cache to disk now, rather than after the deferred save delay.
+     */
+    static void saveToDisk(ShaderCache& cache) {
+        std::lock_guard<std::mutex> lock(cache.mMutex);
+        if (cache.mBlobCache) {
+            cache.mBlobCache->writeToFile();
+        }
+    }
+
+    /**
+     * Drops the cache from memory, the way it is in a new process starting with the file left
+     * by a previous run.
+     */
+    static void reload(ShaderCache& cache) {
+        std::lock_guard<std::mutex> lock(cache.mMutex);
+        cache.mBlobCache.reset();
+    }
+};
+
+} /* namespace skiapipeline */
+} /* namespace uirenderer */
+} /* namespace android */
+
+static const char* kCacheFile = "/data/local/tmp/hwui_shader_cache_test";
+
+static sk_sp<SkData> makeData(const char* str) {
+    return SkData::MakeWithCopy(str, strlen(str) + 1);
+}
+
+TEST(ShaderCache, persistsAcrossReloads) {
+    ShaderCache& cache = ShaderCache::get();
+    unlink(kCacheFile);
+    ShaderCacheTestUtils::reload(cache);
+    cache.setFilename(kCacheFile);
+
+    sk_sp<SkData> key = makeData("program key");
+    sk_sp<SkData> value = makeData("program binary");
+    EXPECT_EQ(nullptr, cache.load(*key));
+    cache.store(*key, *value);
+    sk_sp<SkData> loaded = cache.load(*key);
+    ASSERT_NE(nullptr, loaded);
+    EXPECT_TRUE(loaded->equals(value.get()));
+
+    ShaderCacheTestUtils::saveToDisk(cache);
+    ShaderCacheTestUtils::reload(cache);
+    loaded = cache.load(*key);
+    ASSERT_NE(nullptr, loaded);
+    EXPECT_TRUE(loaded->equals(value.get()));
+
+    unlink(kCacheFile);
+}
+
+TEST(ShaderCache, rejectsOversizedValues) {
+    ShaderCache& cache = ShaderCache::get();
+    ShaderCacheTestUtils::reload(cache);
+
+    sk_sp<SkData> key = makeData("too large");
+    sk_sp<SkData> value = SkData::MakeUninitialized(1024 * 1024);
+    cache.store(*key, *value);
+    EXPECT_EQ(nullptr, cache.load(*key));
+}
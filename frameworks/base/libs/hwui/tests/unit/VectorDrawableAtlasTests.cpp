@@ -151,9 +151,10 @@ RENDERTHREAD_SKIA_PIPELINE_TEST(VectorDrawableAtlas, repack) {
 
     //allocate 4x4 rects, which will fragment the atlas badly, because each entry occupies a 10x10
     //area
+    AtlasEntry smallRects[4*MAX_RECTS];
     for (uint32_t i = 0; i < 4*MAX_RECTS; i++) {
-        AtlasEntry entry = atlas.requestNewEntry(4, 4, renderThread.getGrContext());
-        ASSERT_TRUE(entry.key != INVALID_ATLAS_KEY);
+        smallRects[i] = atlas.requestNewEntry(4, 4, renderThread.getGrContext());
+        ASSERT_TRUE(smallRects[i].key != INVALID_ATLAS_KEY);
     }
 
     ASSERT_TRUE(atlas.isFragmented());
@@ -161,4 +162,21 @@ RENDERTHREAD_SKIA_PIPELINE_TEST(VectorDrawableAtlas, repack) {
     atlas.repackIfNeeded(renderThread.getGrContext());
 
     ASSERT_FALSE(atlas.isFragmented());
+
+    //the repack is spread over several steps, entries stay valid in between
+    ASSERT_TRUE(atlas.isRepacking());
+    atlas.releaseEntry(smallRects[0].key);
+    smallRects[0].key = INVALID_ATLAS_KEY;
+    while (atlas.isRepacking()) {
+        for (uint32_t i = 1; i < 4*MAX_RECTS; i++) {
+            ASSERT_TRUE(atlas.getEntry(smallRects[i].key).surface.get() != nullptr);
+        }
+        atlas.repackIfNeeded(renderThread.getGrContext());
+    }
+
+    //all 4x4 rects fit in the repacked atlas
+    sk_sp<SkSurface> repackedSurface = atlas.getEntry(smallRects[1].key).surface;
+    for (uint32_t i = 1; i < 4*MAX_RECTS; i++) {
+        ASSERT_EQ(repackedSurface.get(), atlas.getEntry(smallRects[i].key).surface.get());
+    }
 }
\ No newline at end of file
@@ -402,5 +402,34 @@ TEST(VectorDrawable, drawPathWithoutIncrementingShaderRefCount) {
     EXPECT_TRUE(shader->unique());
 }
 
+TEST(VectorDrawable, trimmedPathReusedAcrossColorChanges) {
+    VectorDrawable::FullPath path("M0 0 L10 0 L10 10 L0 10 Z", 25);
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(10, 10, false);
+    SkCanvas canvas(bitmap);
+
+    // Only the top and right edges are kept, which fill the upper right triangle
+    path.mutateStagingProperties()->setFillColor(SK_ColorRED);
+    path.mutateStagingProperties()->setTrimPathEnd(0.5f);
+    path.syncProperties();
+    canvas.clear(SK_ColorTRANSPARENT);
+    path.draw(&canvas, false);
+    EXPECT_EQ(SK_ColorRED, bitmap.getColor(8, 2));
+    EXPECT_EQ(SK_ColorTRANSPARENT, bitmap.getColor(2, 8));
+
+    path.mutateStagingProperties()->setFillColor(SK_ColorBLUE);
+    path.syncProperties();
+    canvas.clear(SK_ColorTRANSPARENT);
+    path.draw(&canvas, false);
+    EXPECT_EQ(SK_ColorBLUE, bitmap.getColor(8, 2));
+    EXPECT_EQ(SK_ColorTRANSPARENT, bitmap.getColor(2, 8));
+
+    path.mutateStagingProperties()->setTrimPathEnd(1.0f);
+    path.syncProperties();
+    canvas.clear(SK_ColorTRANSPARENT);
+    path.draw(&canvas, false);
+    EXPECT_EQ(SK_ColorBLUE, bitmap.getColor(2, 8));
+}
+
 }; // namespace uirenderer
 }; // namespace android
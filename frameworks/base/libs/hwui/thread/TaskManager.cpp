@@ -39,7 +39,7 @@ TaskManager::TaskManager() {
     for (int i = 0; i < workerCount; i++) {
         String8 name;
         name.appendFormat("hwuiTask%d", i + 1);
-        mThreads.push_back(new WorkerThread(name));
+        mThreads.push_back(new WorkerThread(this, name));
     }
 }
 
@@ -59,7 +59,8 @@ void TaskManager::stop() {
     }
 }
 
-bool TaskManager::addTaskBase(const sp<TaskBase>& task, const sp<TaskProcessorBase>& processor) {
+bool TaskManager::addTaskBase(const sp<TaskBase>& task, const sp<TaskProcessorBase>& processor,
+        Priority priority) {
     if (mThreads.size() > 0) {
         TaskWrapper wrapper(task, processor);
 
@@ -73,7 +74,33 @@ bool TaskManager::addTaskBase(const sp<TaskBase>& task, const sp<TaskProcessorBa
             }
         }
 
-        return thread->addTask(wrapper);
+        if (!thread->addTask(wrapper, priority)) {
+            return false;
+        }
+
+        // The chosen thread may be stuck on a long task, let an idle one
+        // steal the new task instead of waiting for it
+        for (size_t i = 0; i < mThreads.size(); i++) {
+            if (mThreads[i] != thread && mThreads[i]->wakeIfIdle()) {
+                break;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+bool TaskManager::takeTask(WorkerThread* worker, TaskWrapper* outTask) {
+    for (int p = 0; p < kPriorityCount; p++) {
+        Priority priority = static_cast<Priority>(p);
+        if (worker->popTask(priority, outTask)) {
+            return true;
+        }
+        for (size_t i = 0; i < mThreads.size(); i++) {
+            if (mThreads[i].get() != worker && mThreads[i]->stealTask(priority, outTask)) {
+                return true;
+            }
+        }
     }
     return false;
 }
@@ -88,22 +115,21 @@ status_t TaskManager::WorkerThread::readyToRun() {
 }
 
 bool TaskManager::WorkerThread::threadLoop() {
-    mSignal.wait();
-    std::vector<TaskWrapper> tasks;
-    {
-        Mutex::Autolock l(mLock);
-        tasks.swap(mTasks);
-    }
-
-    for (size_t i = 0; i < tasks.size(); i++) {
-        const TaskWrapper& task = tasks[i];
-        task.mProcessor->process(task.mTask);
+    // Flag the thread as idle before looking for work, so that a task added
+    // after the search wakes it up
+    mIdle = true;
+    TaskWrapper task;
+    if (!mManager->takeTask(this, &task)) {
+        mSignal.wait();
+        return true;
     }
+    mIdle = false;
 
+    task.mProcessor->process(task.mTask);
     return true;
 }
 
-bool TaskManager::WorkerThread::addTask(const TaskWrapper& task) {
+bool TaskManager::WorkerThread::addTask(const TaskWrapper& task, Priority priority) {
     if (!isRunning()) {
         run(mName.string(), PRIORITY_DEFAULT);
     } else if (exitPending()) {
@@ -112,7 +138,7 @@ bool TaskManager::WorkerThread::addTask(const TaskWrapper& task) {
 
     {
         Mutex::Autolock l(mLock);
-        mTasks.push_back(task);
+        mTasks[static_cast<int>(priority)].push_back(task);
     }
     mSignal.signal();
 
@@ -121,7 +147,45 @@ bool TaskManager::WorkerThread::addTask(const TaskWrapper& task) {
 
 size_t TaskManager::WorkerThread::getTaskCount() const {
     Mutex::Autolock l(mLock);
-    return mTasks.size();
+    size_t count = 0;
+    for (int p = 0; p < kPriorityCount; p++) {
+        count += mTasks[p].size();
+    }
+    return count;
+}
+
+bool TaskManager::WorkerThread::wakeIfIdle() {
+    if (!isRunning()) {
+        run(mName.string(), PRIORITY_DEFAULT);
+        return true;
+    }
+    if (!mIdle) {
+        return false;
+    }
+    mSignal.signal();
+    return true;
+}
+
+bool TaskManager::WorkerThread::popTask(Priority priority, TaskWrapper* outTask) {
+    Mutex::Autolock l(mLock);
+    std::deque<TaskWrapper>& tasks = mTasks[static_cast<int>(priority)];
+    if (tasks.empty()) {
+        return false;
+    }
+    *outTask = tasks.front();
+    tasks.pop_front();
+    return true;
+}
+
+bool TaskManager::WorkerThread::stealTask(Priority priority, TaskWrapper* outTask) {
+    Mutex::Autolock l(mLock);
+    std::deque<TaskWrapper>& tasks = mTasks[static_cast<int>(priority)];
+    if (tasks.empty()) {
+        return false;
+    }
+    *outTask = tasks.back();
+    tasks.pop_back();
+    return true;
 }
 
 void TaskManager::WorkerThread::exit() {
@@ -23,6 +23,8 @@
 
 #include "Signal.h"
 
+#include <atomic>
+#include <deque>
 #include <vector>
 
 namespace android {
@@ -38,6 +40,18 @@ class TaskProcessorBase;
 
 class TaskManager {
 public:
+    /**
+     * Order in which queued tasks are picked up. A worker runs all the high
+     * priority tasks it can find, including those queued on other workers,
+     * before any normal priority one.
+     */
+    enum class Priority {
+        // Work the current frame is likely to block on first, such as shadows
+        High,
+        // Precaching
+        Normal,
+    };
+
     TaskManager();
     ~TaskManager();
 
@@ -59,11 +73,13 @@ private:
     friend class TaskProcessor;
 
     template<typename T>
-    bool addTask(const sp<Task<T> >& task, const sp<TaskProcessor<T> >& processor) {
-        return addTaskBase(sp<TaskBase>(task), sp<TaskProcessorBase>(processor));
+    bool addTask(const sp<Task<T> >& task, const sp<TaskProcessor<T> >& processor,
+            Priority priority) {
+        return addTaskBase(sp<TaskBase>(task), sp<TaskProcessorBase>(processor), priority);
     }
 
-    bool addTaskBase(const sp<TaskBase>& task, const sp<TaskProcessorBase>& processor);
+    bool addTaskBase(const sp<TaskBase>& task, const sp<TaskProcessorBase>& processor,
+            Priority priority);
 
     struct TaskWrapper {
         TaskWrapper(): mTask(), mProcessor() { }
@@ -76,29 +92,53 @@ private:
         sp<TaskProcessorBase> mProcessor;
     };
 
+    static constexpr int kPriorityCount = static_cast<int>(Priority::Normal) + 1;
+
     class WorkerThread: public Thread {
     public:
-        explicit WorkerThread(const String8& name): mSignal(Condition::WAKE_UP_ONE), mName(name) { }
+        WorkerThread(TaskManager* manager, const String8& name)
+                : mManager(manager), mSignal(Condition::WAKE_UP_ONE), mName(name) { }
 
-        bool addTask(const TaskWrapper& task);
+        bool addTask(const TaskWrapper& task, Priority priority);
         size_t getTaskCount() const;
         void exit();
 
+        /**
+         * Wakes the thread up, starting it if needed, so it can steal from
+         * the other workers. Returns false if it is busy.
+         */
+        bool wakeIfIdle();
+
+        // The thread takes its own tasks from the front of its queues, other
+        // workers steal them from the back.
+        bool popTask(Priority priority, TaskWrapper* outTask);
+        bool stealTask(Priority priority, TaskWrapper* outTask);
+
     private:
         virtual status_t readyToRun() override;
         virtual bool threadLoop() override;
 
-        // Lock for the list of tasks
+        TaskManager* const mManager;
+
+        // Lock for the queues of tasks
         mutable Mutex mLock;
-        std::vector<TaskWrapper> mTasks;
+        std::deque<TaskWrapper> mTasks[kPriorityCount];
 
         // Signal used to wake up the thread when a new
-        // task is available in the list
+        // task is available in one of the queues
         mutable Signal mSignal;
+        // Set while the thread looks for a task or waits for one
+        std::atomic<bool> mIdle { false };
 
         const String8 mName;
     };
 
+    /**
+     * Finds the next task for the worker. Each priority is tried in turn,
+     * first on the worker's own queues, then on the other workers' queues.
+     */
+    bool takeTask(WorkerThread* worker, TaskWrapper* outTask);
+
     std::vector<sp<WorkerThread> > mThreads;
 };
 
@@ -36,7 +36,9 @@ public:
 template<typename T>
 class TaskProcessor: public TaskProcessorBase {
 public:
-    explicit TaskProcessor(TaskManager* manager): mManager(manager) { }
+    explicit TaskProcessor(TaskManager* manager,
+            TaskManager::Priority priority = TaskManager::Priority::Normal)
+            : mManager(manager), mPriority(priority) { }
     virtual ~TaskProcessor() { }
 
     void add(const sp<Task<T> >& task) {
@@ -59,13 +61,14 @@ private:
     }
 
     TaskManager* mManager;
+    const TaskManager::Priority mPriority;
 };
 
 template<typename T>
 bool TaskProcessor<T>::addImpl(const sp<Task<T> >& task) {
     if (mManager) {
         sp<TaskProcessor<T> > self(this);
-        return mManager->addTask(task, self);
+        return mManager->addTask(task, self, mPriority);
     }
     return false;
 }
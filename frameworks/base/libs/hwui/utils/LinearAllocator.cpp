@@ -42,6 +42,12 @@
 // Must be smaller than INITIAL_PAGE_SIZE
 #define MAX_WASTE_RATIO (0.5f)
 
+// Pages of up to MAX_PAGE_SIZE come in power of two size classes, starting at INITIAL_PAGE_SIZE.
+// Freed pages are kept by the thread that freed them and handed out again to the next
+// LinearAllocator on that thread, up to MAX_POOLED_SIZE bytes per thread
+#define PAGE_SIZE_CLASS_COUNT 9 // 512b .. 128kb
+#define MAX_POOLED_SIZE ((size_t)524288) // 512kb
+
 #if ALIGN_DOUBLE
 #define ALIGN_SZ (sizeof(double))
 #else
@@ -88,9 +94,11 @@ class LinearAllocator::Page {
 public:
     Page* next() { return mNextPage; }
     void setNext(Page* next) { mNextPage = next; }
+    int sizeClass() { return mSizeClass; }
 
-    Page()
+    explicit Page(int sizeClass)
         : mNextPage(0)
+        , mSizeClass(sizeClass)
     {}
 
     void* operator new(size_t /*size*/, void* buf) { return buf; }
@@ -106,8 +114,76 @@ public:
 private:
     Page(const Page& /*other*/) {}
     Page* mNextPage;
+    int mSizeClass;
+};
+
+// Returns the size class holding pages of at least the given size, or -1 if the size is
+// larger than any size class
+static int sizeClassFor(size_t pageSize) {
+    for (int i = 0; i < PAGE_SIZE_CLASS_COUNT; i++) {
+        if (pageSize <= (INITIAL_PAGE_SIZE << i)) return i;
+    }
+    return -1;
+}
+
+static size_t allocationSizeFor(size_t pageSize) {
+    return ALIGN(pageSize + sizeof(LinearAllocator::Page));
+}
+
+/**
+ * Per-thread free lists of pages, one per size class.
+ */
+class PagePool {
+public:
+    ~PagePool();
+
+    void* acquire(int sizeClass);
+    bool release(void* buf, int sizeClass);
+
+private:
+    struct FreePage {
+        FreePage* next;
+    };
+
+    FreePage* mFreePages[PAGE_SIZE_CLASS_COUNT] = {};
+    size_t mPooledSize = 0;
 };
 
+static thread_local PagePool sPagePool;
+// Trivially destructible, so it can still be read by allocators destroyed after sPagePool
+// during thread exit
+static thread_local bool sPagePoolDestroyed = false;
+
+PagePool::~PagePool() {
+    for (int i = 0; i < PAGE_SIZE_CLASS_COUNT; i++) {
+        while (mFreePages[i]) {
+            FreePage* page = mFreePages[i];
+            mFreePages[i] = page->next;
+            free(page);
+        }
+    }
+    sPagePoolDestroyed = true;
+}
+
+void* PagePool::acquire(int sizeClass) {
+    FreePage* page = mFreePages[sizeClass];
+    if (page) {
+        mFreePages[sizeClass] = page->next;
+        mPooledSize -= allocationSizeFor(INITIAL_PAGE_SIZE << sizeClass);
+    }
+    return page;
+}
+
+bool PagePool::release(void* buf, int sizeClass) {
+    size_t size = allocationSizeFor(INITIAL_PAGE_SIZE << sizeClass);
+    if (mPooledSize + size > MAX_POOLED_SIZE) return false;
+    FreePage* page = reinterpret_cast<FreePage*>(buf);
+    page->next = mFreePages[sizeClass];
+    mFreePages[sizeClass] = page;
+    mPooledSize += size;
+    return true;
+}
+
 LinearAllocator::LinearAllocator()
     : mPageSize(INITIAL_PAGE_SIZE)
     , mMaxAllocSize(INITIAL_PAGE_SIZE * MAX_WASTE_RATIO)
@@ -117,7 +193,8 @@ LinearAllocator::LinearAllocator()
     , mTotalAllocated(0)
     , mWastedSpace(0)
     , mPageCount(0)
-    , mDedicatedPageCount(0) {}
+    , mDedicatedPageCount(0)
+    , mReusedPageCount(0) {}
 
 LinearAllocator::~LinearAllocator(void) {
     while (mDtorList) {
@@ -128,8 +205,11 @@ LinearAllocator::~LinearAllocator(void) {
     Page* p = mPages;
     while (p) {
         Page* next = p->next();
+        int sizeClass = p->sizeClass();
         p->~Page();
-        free(p);
+        if (sizeClass < 0 || sPagePoolDestroyed || !sPagePool.release(p, sizeClass)) {
+            free(p);
+        }
         RM_ALLOCATION();
         p = next;
     }
@@ -171,8 +251,12 @@ void* LinearAllocator::allocImpl(size_t size) {
     size = ALIGN(size);
     if (size > mMaxAllocSize && !fitsInCurrentPage(size)) {
         ALOGV("Exceeded max size %zu > %zu", size, mMaxAllocSize);
-        // Allocation is too large, create a dedicated page for the allocation
-        Page* page = newPage(size);
+        // Allocation is too large, create a dedicated page for the allocation. It is rounded up
+        // to its size class so that the page can be pooled once freed
+        int sizeClass = sizeClassFor(size);
+        size_t pageSize = sizeClass < 0 ? size : (INITIAL_PAGE_SIZE << sizeClass);
+        mWastedSpace += pageSize - size;
+        Page* page = newPage(pageSize);
         mDedicatedPageCount++;
         page->setNext(mPages);
         mPages = page;
@@ -233,12 +317,25 @@ void LinearAllocator::rewindIfLastAlloc(void* ptr, size_t allocSize) {
 }
 
 LinearAllocator::Page* LinearAllocator::newPage(size_t pageSize) {
-    pageSize = ALIGN(pageSize + sizeof(LinearAllocator::Page));
+    int sizeClass = sizeClassFor(pageSize);
+    if (sizeClass >= 0 && pageSize != (INITIAL_PAGE_SIZE << sizeClass)) {
+        // Only pages that fill their size class can be handed out again
+        sizeClass = -1;
+    }
+    pageSize = allocationSizeFor(pageSize);
     ADD_ALLOCATION();
     mTotalAllocated += pageSize;
     mPageCount++;
-    void* buf = malloc(pageSize);
-    return new (buf) Page();
+    void* buf = nullptr;
+    if (sizeClass >= 0 && !sPagePoolDestroyed) {
+        buf = sPagePool.acquire(sizeClass);
+    }
+    if (buf) {
+        mReusedPageCount++;
+    } else {
+        buf = malloc(pageSize);
+    }
+    return new (buf) Page(sizeClass);
 }
 
 static const char* toSize(size_t value, float& result) {
@@ -262,7 +359,8 @@ void LinearAllocator::dumpMemoryStats(const char* prefix) {
     prettySuffix = toSize(mWastedSpace, prettySize);
     ALOGD("%sWasted space: %.2f%s (%.1f%%)", prefix, prettySize, prettySuffix,
           (float) mWastedSpace / (float) mTotalAllocated * 100.0f);
-    ALOGD("%sPages %zu (dedicated %zu)", prefix, mPageCount, mDedicatedPageCount);
+    ALOGD("%sPages %zu (dedicated %zu, reused %zu)", prefix, mPageCount, mDedicatedPageCount,
+          mReusedPageCount);
 }
 
 }; // namespace uirenderer
@@ -116,10 +116,23 @@ public:
      */
     size_t usedSize() const { return mTotalAllocated - mWastedSpace; }
 
+    /**
+     * The number of bytes allocated in pages but not handed out, either at the end of the current
+     * page or lost to size class rounding
+     */
+    size_t wastedSize() const { return mWastedSpace; }
+
+    /**
+     * The number of pages taken from the pool of pages freed by previous LinearAllocators on the
+     * same thread, rather than from malloc
+     */
+    size_t reusedPageCount() const { return mReusedPageCount; }
+
+    class Page;
+
 private:
     LinearAllocator(const LinearAllocator& other);
 
-    class Page;
     typedef void (*Destructor)(void* addr);
     struct DestructorNode {
         Destructor dtor;
@@ -149,6 +162,7 @@ private:
     size_t mWastedSpace;
     size_t mPageCount;
     size_t mDedicatedPageCount;
+    size_t mReusedPageCount;
 };
 
 template <class T>
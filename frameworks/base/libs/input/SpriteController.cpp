@@ -36,18 +36,34 @@
 
 namespace android {
 
+// The number of events to be read at once for DisplayEventReceiver.
+static const int EVENT_BUFFER_SIZE = 16;
+
 // --- SpriteController ---
 
 SpriteController::SpriteController(const sp<Looper>& looper, int32_t overlayLayer) :
         mLooper(looper), mOverlayLayer(overlayLayer) {
     mHandler = new WeakMessageHandler(this);
+    mCallback = new WeakLooperCallback(this);
+
+    mDisplayEventReceiverValid = mDisplayEventReceiver.initCheck() == NO_ERROR;
+    if (mDisplayEventReceiverValid) {
+        mLooper->addFd(mDisplayEventReceiver.getFd(), Looper::POLL_CALLBACK,
+                       Looper::EVENT_INPUT, mCallback, nullptr);
+    } else {
+        ALOGE("Failed to initialize DisplayEventReceiver, sprite updates won't be coalesced.");
+    }
 
     mLocked.transactionNestingCount = 0;
     mLocked.deferredSpriteUpdate = false;
+    mLocked.updateThrottled = false;
 }
 
 SpriteController::~SpriteController() {
     mLooper->removeMessages(mHandler);
+    if (mDisplayEventReceiverValid) {
+        mLooper->removeFd(mDisplayEventReceiver.getFd());
+    }
 
     if (mSurfaceComposerClient != NULL) {
         mSurfaceComposerClient->dispose();
@@ -74,7 +90,7 @@ void SpriteController::closeTransaction() {
     mLocked.transactionNestingCount -= 1;
     if (mLocked.transactionNestingCount == 0 && mLocked.deferredSpriteUpdate) {
         mLocked.deferredSpriteUpdate = false;
-        mLooper->sendMessage(mHandler, Message(MSG_UPDATE_SPRITES));
+        scheduleUpdateSpritesLocked();
     }
 }
 
@@ -85,11 +101,18 @@ void SpriteController::invalidateSpriteLocked(const sp<SpriteImpl>& sprite) {
         if (mLocked.transactionNestingCount != 0) {
             mLocked.deferredSpriteUpdate = true;
         } else {
-            mLooper->sendMessage(mHandler, Message(MSG_UPDATE_SPRITES));
+            scheduleUpdateSpritesLocked();
         }
     }
 }
 
+void SpriteController::scheduleUpdateSpritesLocked() {
+    // When throttled, the vsync handler picks up the invalidated sprites.
+    if (!mLocked.updateThrottled) {
+        mLooper->sendMessage(mHandler, Message(MSG_UPDATE_SPRITES));
+    }
+}
+
 void SpriteController::disposeSurfaceLocked(const sp<SurfaceControl>& surfaceControl) {
     bool wasEmpty = mLocked.disposedSurfaces.isEmpty();
     mLocked.disposedSurfaces.push(surfaceControl);
@@ -109,6 +132,52 @@ void SpriteController::handleMessage(const Message& message) {
     }
 }
 
+int SpriteController::handleEvent(int /* fd */, int events, void* /* data */) {
+    if (events & (Looper::EVENT_ERROR | Looper::EVENT_HANGUP)) {
+        ALOGE("Display event receiver pipe was closed or an error occurred.  "
+              "events=0x%x", events);
+        AutoMutex _l(mLock);
+        mDisplayEventReceiverValid = false;
+        if (mLocked.updateThrottled) {
+            mLocked.updateThrottled = false;
+            mLooper->sendMessage(mHandler, Message(MSG_UPDATE_SPRITES));
+        }
+        return 0; // remove the callback
+    }
+
+    if (!(events & Looper::EVENT_INPUT)) {
+        ALOGW("Received spurious callback for unhandled poll event.  "
+              "events=0x%x", events);
+        return 1; // keep the callback
+    }
+
+    bool gotVsync = false;
+    ssize_t n;
+    DisplayEventReceiver::Event buf[EVENT_BUFFER_SIZE];
+    while ((n = mDisplayEventReceiver.getEvents(buf, EVENT_BUFFER_SIZE)) > 0) {
+        for (size_t i = 0; i < static_cast<size_t>(n); ++i) {
+            if (buf[i].header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
+                gotVsync = true;
+            }
+        }
+    }
+    if (gotVsync) {
+        bool update;
+        { // acquire lock
+            AutoMutex _l(mLock);
+
+            mLocked.updateThrottled = false;
+            update = !mLocked.invalidatedSprites.isEmpty()
+                    && mLocked.transactionNestingCount == 0;
+        } // release lock
+
+        if (update) {
+            doUpdateSprites();
+        }
+    }
+    return 1;  // keep the callback
+}
+
 void SpriteController::doUpdateSprites() {
     // Collect information about sprite updates.
     // Each sprite update record includes a reference to its associated sprite so we can
@@ -121,6 +190,13 @@ void SpriteController::doUpdateSprites() {
         AutoMutex _l(mLock);
 
         numSprites = mLocked.invalidatedSprites.size();
+
+        // Hold back whatever comes in before the next frame.
+        if (numSprites != 0 && mDisplayEventReceiverValid && !mLocked.updateThrottled) {
+            mLocked.updateThrottled = true;
+            mDisplayEventReceiver.requestNextVsync();
+        }
+
         for (size_t i = 0; i < numSprites; i++) {
             const sp<SpriteImpl>& sprite = mLocked.invalidatedSprites.itemAt(i);
 
@@ -20,6 +20,7 @@
 #include <utils/RefBase.h>
 #include <utils/Looper.h>
 
+#include <gui/DisplayEventReceiver.h>
 #include <gui/SurfaceComposerClient.h>
 
 #include <SkBitmap.h>
@@ -135,10 +136,12 @@ public:
  * by other components.
  *
  * All sprite position updates and rendering is performed asynchronously.
+ * Updates that arrive less than a frame after the previous one are held until the next
+ * vsync, so a fast moving pointer costs at most one surface transaction per frame.
  *
  * Clients are responsible for animating sprites by periodically updating their properties.
  */
-class SpriteController : public MessageHandler {
+class SpriteController : public MessageHandler, public LooperCallback {
 protected:
     virtual ~SpriteController();
 
@@ -270,20 +273,28 @@ private:
     sp<Looper> mLooper;
     const int32_t mOverlayLayer;
     sp<WeakMessageHandler> mHandler;
+    sp<LooperCallback> mCallback;
 
     sp<SurfaceComposerClient> mSurfaceComposerClient;
 
+    DisplayEventReceiver mDisplayEventReceiver;
+    bool mDisplayEventReceiverValid;
+
     struct Locked {
         Vector<sp<SpriteImpl> > invalidatedSprites;
         Vector<sp<SurfaceControl> > disposedSurfaces;
         uint32_t transactionNestingCount;
         bool deferredSpriteUpdate;
+        // Sprites were updated since the last vsync, so further updates wait for the next one.
+        bool updateThrottled;
     } mLocked; // guarded by mLock
 
     void invalidateSpriteLocked(const sp<SpriteImpl>& sprite);
+    void scheduleUpdateSpritesLocked();
     void disposeSurfaceLocked(const sp<SurfaceControl>& surfaceControl);
 
     void handleMessage(const Message& message);
+    int handleEvent(int fd, int events, void* data);
     void doUpdateSprites();
     void doDisposeSurfaces();
 
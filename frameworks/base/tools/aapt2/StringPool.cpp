@@ -17,12 +17,14 @@
 #include "StringPool.h"
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <string>
 
 #include "android-base/logging.h"
 #include "androidfw/ResourceTypes.h"
 #include "androidfw/StringPiece.h"
+#include "utils/Unicode.h"
 
 #include "util/BigBuffer.h"
 #include "util/Util.h"
@@ -31,6 +33,12 @@ using android::StringPiece;
 
 namespace aapt {
 
+// The sizes of the blocks entries are allocated in. Small pools, like the ones
+// of XML files, stay small, and big ones only allocate once every few thousand
+// strings.
+constexpr static const size_t kMinEntryBlockCapacity = 16u;
+constexpr static const size_t kMaxEntryBlockCapacity = 4096u;
+
 StringPool::Ref::Ref() : entry_(nullptr) {}
 
 StringPool::Ref::Ref(const StringPool::Ref& rhs) : entry_(rhs.entry_) {
@@ -162,6 +170,26 @@ StringPool::Ref StringPool::MakeRef(const StringPiece& str,
   return MakeRefImpl(str, context, true);
 }
 
+StringPool::Entry* StringPool::NewEntry(const StringPiece& str, const Context& context) {
+  if (entry_blocks_.empty() || entry_block_used_ == entry_block_capacity_) {
+    entry_block_capacity_ =
+        entry_blocks_.empty()
+            ? kMinEntryBlockCapacity
+            : std::min(entry_block_capacity_ * 2, kMaxEntryBlockCapacity);
+    entry_blocks_.emplace_back(new Entry[entry_block_capacity_]);
+    entry_block_used_ = 0;
+  }
+
+  Entry* entry = &entry_blocks_.back()[entry_block_used_++];
+  entry->value.assign(str.data(), str.size());
+  entry->context = context;
+  entry->index = strings_.size();
+  entry->ref_ = 0;
+  strings_.push_back(entry);
+  indexed_strings_.insert(std::make_pair(StringPiece(entry->value), entry));
+  return entry;
+}
+
 StringPool::Ref StringPool::MakeRefImpl(const StringPiece& str,
                                         const Context& context, bool unique) {
   if (unique) {
@@ -170,15 +198,7 @@ StringPool::Ref StringPool::MakeRefImpl(const StringPiece& str,
       return Ref(iter->second);
     }
   }
-
-  Entry* entry = new Entry();
-  entry->value = str.to_string();
-  entry->context = context;
-  entry->index = strings_.size();
-  entry->ref_ = 0;
-  strings_.emplace_back(entry);
-  indexed_strings_.insert(std::make_pair(StringPiece(entry->value), entry));
-  return Ref(entry);
+  return Ref(NewEntry(str, context));
 }
 
 StringPool::StyleRef StringPool::MakeRef(const StyleString& str) {
@@ -187,13 +207,7 @@ StringPool::StyleRef StringPool::MakeRef(const StyleString& str) {
 
 StringPool::StyleRef StringPool::MakeRef(const StyleString& str,
                                          const Context& context) {
-  Entry* entry = new Entry();
-  entry->value = str.str;
-  entry->context = context;
-  entry->index = strings_.size();
-  entry->ref_ = 0;
-  strings_.emplace_back(entry);
-  indexed_strings_.insert(std::make_pair(StringPiece(entry->value), entry));
+  Entry* entry = NewEntry(str.str, context);
 
   StyleEntry* style_entry = new StyleEntry();
   style_entry->str = Ref(entry);
@@ -207,13 +221,7 @@ StringPool::StyleRef StringPool::MakeRef(const StyleString& str,
 }
 
 StringPool::StyleRef StringPool::MakeRef(const StyleRef& ref) {
-  Entry* entry = new Entry();
-  entry->value = *ref.entry_->str;
-  entry->context = ref.entry_->str.entry_->context;
-  entry->index = strings_.size();
-  entry->ref_ = 0;
-  strings_.emplace_back(entry);
-  indexed_strings_.insert(std::make_pair(StringPiece(entry->value), entry));
+  Entry* entry = NewEntry(*ref.entry_->str, ref.entry_->str.entry_->context);
 
   StyleEntry* style_entry = new StyleEntry();
   style_entry->str = Ref(entry);
@@ -230,41 +238,69 @@ void StringPool::Merge(StringPool&& pool) {
   indexed_strings_.insert(pool.indexed_strings_.begin(),
                           pool.indexed_strings_.end());
   pool.indexed_strings_.clear();
-  std::move(pool.strings_.begin(), pool.strings_.end(),
-            std::back_inserter(strings_));
+  strings_.insert(strings_.end(), pool.strings_.begin(), pool.strings_.end());
   pool.strings_.clear();
   std::move(pool.styles_.begin(), pool.styles_.end(),
             std::back_inserter(styles_));
   pool.styles_.clear();
 
-  // Assign the indices.
-  const size_t len = strings_.size();
-  for (size_t index = 0; index < len; index++) {
-    strings_[index]->index = index;
+  // Take ownership of the entries. The last block of this pool may not be
+  // full, but new entries go into a new block after the merged ones.
+  if (!pool.entry_blocks_.empty()) {
+    std::move(pool.entry_blocks_.begin(), pool.entry_blocks_.end(),
+              std::back_inserter(entry_blocks_));
+    pool.entry_blocks_.clear();
+    entry_block_capacity_ = std::max(entry_block_capacity_, pool.entry_block_capacity_);
+    entry_block_used_ = entry_block_capacity_;
   }
+
+  ReassignIndices();
 }
 
 void StringPool::HintWillAdd(size_t stringCount, size_t styleCount) {
   strings_.reserve(strings_.size() + stringCount);
   styles_.reserve(styles_.size() + styleCount);
+  indexed_strings_.reserve(indexed_strings_.size() + stringCount);
+}
+
+void StringPool::ReassignIndices() {
+  const size_t len = strings_.size();
+  for (size_t index = 0; index < len; index++) {
+    strings_[index]->index = index;
+  }
+}
+
+void StringPool::SortStyles() {
+  std::sort(styles_.begin(), styles_.end(),
+            [](const std::unique_ptr<StyleEntry>& lhs,
+               const std::unique_ptr<StyleEntry>& rhs) -> bool {
+              return lhs->str.index() < rhs->str.index();
+            });
 }
 
 void StringPool::Prune() {
   const auto iter_end = indexed_strings_.end();
   auto index_iter = indexed_strings_.begin();
+  bool removed_indexed_string = false;
   while (index_iter != iter_end) {
     if (index_iter->second->ref_ <= 0) {
       index_iter = indexed_strings_.erase(index_iter);
+      removed_indexed_string = true;
     } else {
       ++index_iter;
     }
   }
 
+  // The removed strings give their memory back, but keep their slot in the
+  // entry blocks.
   auto end_iter2 =
-      std::remove_if(strings_.begin(), strings_.end(),
-                     [](const std::unique_ptr<Entry>& entry) -> bool {
-                       return entry->ref_ <= 0;
-                     });
+      std::remove_if(strings_.begin(), strings_.end(), [](Entry* entry) -> bool {
+        if (entry->ref_ <= 0) {
+          std::string().swap(entry->value);
+          return true;
+        }
+        return false;
+      });
 
   auto end_iter3 =
       std::remove_if(styles_.begin(), styles_.end(),
@@ -272,37 +308,74 @@ void StringPool::Prune() {
                        return entry->ref_ <= 0;
                      });
 
-  // Remove the entries at the end or else we'll be accessing
-  // a deleted string from the StyleEntry.
   strings_.erase(end_iter2, strings_.end());
   styles_.erase(end_iter3, styles_.end());
 
-  // Reassign the indices.
-  const size_t len = strings_.size();
-  for (size_t index = 0; index < len; index++) {
-    strings_[index]->index = index;
+  // An entry that was removed from the index may have had a live duplicate.
+  if (removed_indexed_string) {
+    for (Entry* entry : strings_) {
+      indexed_strings_.insert(std::make_pair(StringPiece(entry->value), entry));
+    }
   }
+
+  ReassignIndices();
 }
 
 void StringPool::Sort(
     const std::function<bool(const Entry&, const Entry&)>& cmp) {
-  std::sort(
-      strings_.begin(), strings_.end(),
-      [&cmp](const std::unique_ptr<Entry>& a,
-             const std::unique_ptr<Entry>& b) -> bool { return cmp(*a, *b); });
+  std::sort(strings_.begin(), strings_.end(),
+            [&cmp](const Entry* a, const Entry* b) -> bool { return cmp(*a, *b); });
+  ReassignIndices();
+  SortStyles();
+}
 
-  // Assign the indices.
-  const size_t len = strings_.size();
-  for (size_t index = 0; index < len; index++) {
-    strings_[index]->index = index;
+void StringPool::Sort() {
+  // Rank the distinct configurations, so that sorting compares integers
+  // instead of ResTable_configs.
+  std::map<ConfigDescription, uint32_t> config_ranks;
+  for (const Entry* entry : strings_) {
+    config_ranks.insert(std::make_pair(entry->context.config, 0u));
   }
 
-  // Reorder the styles.
-  std::sort(styles_.begin(), styles_.end(),
-            [](const std::unique_ptr<StyleEntry>& lhs,
-               const std::unique_ptr<StyleEntry>& rhs) -> bool {
-              return lhs->str.index() < rhs->str.index();
-            });
+  uint32_t rank = 0;
+  for (auto& config_rank : config_ranks) {
+    config_rank.second = rank++;
+  }
+
+  struct SortKey {
+    uint32_t priority;
+    uint32_t config_rank;
+    Entry* entry;
+  };
+
+  std::vector<SortKey> keys;
+  keys.reserve(strings_.size());
+  const ConfigDescription* last_config = nullptr;
+  uint32_t last_rank = 0;
+  for (Entry* entry : strings_) {
+    // Strings of the same configuration are usually added together.
+    if (last_config == nullptr || *last_config != entry->context.config) {
+      last_config = &entry->context.config;
+      last_rank = config_ranks[entry->context.config];
+    }
+    keys.push_back(SortKey{entry->context.priority, last_rank, entry});
+  }
+
+  std::sort(keys.begin(), keys.end(), [](const SortKey& a, const SortKey& b) -> bool {
+    if (a.priority != b.priority) {
+      return a.priority < b.priority;
+    }
+    if (a.config_rank != b.config_rank) {
+      return a.config_rank < b.config_rank;
+    }
+    return a.entry->value < b.entry->value;
+  });
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    strings_[i] = keys[i].entry;
+  }
+  ReassignIndices();
+  SortStyles();
 }
 
 template <typename T>
@@ -350,50 +423,55 @@ bool StringPool::Flatten(BigBuffer* out, const StringPool& pool, bool utf8) {
   const size_t before_strings_index = out->size();
   header->stringsStart = before_strings_index - start_index;
 
-  for (const auto& entry : pool) {
-    *indices = out->size() - before_strings_index;
-    indices++;
-
+  // Measure every string first, so that they can be encoded in place into a
+  // single block, without temporary copies.
+  std::vector<size_t> utf16_lengths;
+  utf16_lengths.reserve(pool.size());
+  size_t strings_size = 0;
+  for (const Entry* entry : pool) {
+    const ssize_t utf16_length = utf8_to_utf16_length(
+        reinterpret_cast<const uint8_t*>(entry->value.data()), entry->value.size());
     if (utf8) {
-      const std::string& encoded = entry->value;
-      const ssize_t utf16_length = utf8_to_utf16_length(
-          reinterpret_cast<const uint8_t*>(entry->value.data()),
-          entry->value.size());
       CHECK(utf16_length >= 0);
+      utf16_lengths.push_back(utf16_length);
+      strings_size += EncodedLengthUnits<char>(utf16_length) +
+                      EncodedLengthUnits<char>(entry->value.size()) + entry->value.size() + 1;
+    } else {
+      // Invalid UTF-8 is written as an empty string.
+      utf16_lengths.push_back(utf16_length > 0 ? utf16_length : 0);
+      strings_size += (EncodedLengthUnits<char16_t>(utf16_lengths.back()) +
+                       utf16_lengths.back() + 1) * sizeof(char16_t);
+    }
+  }
 
-      const size_t total_size = EncodedLengthUnits<char>(utf16_length) +
-                                EncodedLengthUnits<char>(encoded.length()) +
-                                encoded.size() + 1;
+  // The block is zeroed on allocation, which takes care of the null terminators.
+  uint8_t* strings_data = strings_size != 0 ? out->NextBlock<uint8_t>(strings_size) : nullptr;
+  size_t offset = 0;
+  for (size_t i = 0; i < pool.size(); i++) {
+    const std::string& value = pool.strings_[i]->value;
+    const size_t utf16_length = utf16_lengths[i];
+    *indices++ = offset;
 
-      char* data = out->NextBlock<char>(total_size);
+    if (utf8) {
+      char* data = reinterpret_cast<char*>(strings_data + offset);
 
       // First encode the UTF16 string length.
       data = EncodeLength(data, utf16_length);
 
       // Now encode the size of the real UTF8 string.
-      data = EncodeLength(data, encoded.length());
-      strncpy(data, encoded.data(), encoded.size());
-
+      data = EncodeLength(data, value.size());
+      memcpy(data, value.data(), value.size());
+      offset = reinterpret_cast<uint8_t*>(data + value.size() + 1) - strings_data;
     } else {
-      const std::u16string encoded = util::Utf8ToUtf16(entry->value);
-      const ssize_t utf16_length = encoded.size();
-
-      // Total number of 16-bit words to write.
-      const size_t total_size =
-          EncodedLengthUnits<char16_t>(utf16_length) + encoded.size() + 1;
-
-      char16_t* data = out->NextBlock<char16_t>(total_size);
+      char16_t* data = reinterpret_cast<char16_t*>(strings_data + offset);
 
       // Encode the actual UTF16 string length.
       data = EncodeLength(data, utf16_length);
-      const size_t byte_length = encoded.size() * sizeof(char16_t);
-
-      // NOTE: For some reason, strncpy16(data, entry->value.data(),
-      // entry->value.size()) truncates the string.
-      memcpy(data, encoded.data(), byte_length);
-
-      // The null-terminating character is already here due to the block of data
-      // being set to 0s on allocation.
+      if (utf16_length != 0) {
+        utf8_to_utf16(reinterpret_cast<const uint8_t*>(value.data()), value.size(), data,
+                      utf16_length + 1);
+      }
+      offset = reinterpret_cast<uint8_t*>(data + utf16_length + 1) - strings_data;
     }
   }
 
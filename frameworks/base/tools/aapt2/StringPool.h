@@ -143,7 +143,7 @@ class StringPool {
     int ref_;
   };
 
-  using const_iterator = std::vector<std::unique_ptr<Entry>>::const_iterator;
+  using const_iterator = std::vector<Entry*>::const_iterator;
 
   static bool FlattenUtf8(BigBuffer* out, const StringPool& pool);
   static bool FlattenUtf16(BigBuffer* out, const StringPool& pool);
@@ -204,6 +204,14 @@ class StringPool {
    */
   void Sort(const std::function<bool(const Entry&, const Entry&)>& cmp);
 
+  /**
+   * Sorts the strings by priority, then configuration, then value. This is
+   * the order used by resource tables, and is cheaper than passing the
+   * equivalent comparison function, since configurations are only compared
+   * once per distinct configuration.
+   */
+  void Sort();
+
   /**
    * Removes any strings that have no references.
    */
@@ -219,9 +227,28 @@ class StringPool {
 
   Ref MakeRefImpl(const android::StringPiece& str, const Context& context, bool unique);
 
-  std::vector<std::unique_ptr<Entry>> strings_;
+  // Returns a new entry with the given value and context, at the end of the pool.
+  Entry* NewEntry(const android::StringPiece& str, const Context& context);
+
+  // Sets the index of each entry to its position in strings_.
+  void ReassignIndices();
+
+  // Sorts styles_ by the index of their string.
+  void SortStyles();
+
+  // Entries are allocated in blocks of growing size, so that large pools don't
+  // pay for one allocation per string. The blocks only go away with the pool:
+  // pruned entries just release their value.
+  std::vector<std::unique_ptr<Entry[]>> entry_blocks_;
+  size_t entry_block_capacity_ = 0;
+  size_t entry_block_used_ = 0;
+
+  std::vector<Entry*> strings_;
   std::vector<std::unique_ptr<StyleEntry>> styles_;
-  std::unordered_multimap<android::StringPiece, Entry*> indexed_strings_;
+
+  // Finds an entry by value. When several entries have the same value (styled
+  // strings are never deduplicated), this holds the first one added.
+  std::unordered_map<android::StringPiece, Entry*> indexed_strings_;
 };
 
 //
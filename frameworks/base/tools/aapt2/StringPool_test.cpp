@@ -17,6 +17,7 @@
 #include "StringPool.h"
 
 #include <string>
+#include <vector>
 
 #include "androidfw/StringPiece.h"
 
@@ -140,6 +141,61 @@ TEST(StringPoolTest, SortAndStillDedupe) {
   EXPECT_EQ(ref6.index(), ref3.index());
 }
 
+TEST(StringPoolTest, SortByPriorityConfigAndValue) {
+  StringPool pool;
+
+  const ConfigDescription land = test::ParseConfigOrDie("land");
+  StringPool::Ref ref = pool.MakeRef("z", StringPool::Context(land));
+  StringPool::Ref ref2 = pool.MakeRef("b", StringPool::Context(land));
+  StringPool::Ref ref3 = pool.MakeRef("y");
+  StringPool::Ref ref4 = pool.MakeRef("a", StringPool::Context(StringPool::Context::kHighPriority));
+
+  pool.Sort();
+
+  EXPECT_EQ(0u, ref4.index());
+  EXPECT_EQ(1u, ref3.index());
+  EXPECT_EQ(2u, ref2.index());
+  EXPECT_EQ(3u, ref.index());
+}
+
+TEST(StringPoolTest, KeepReferencesAcrossManyStringsAndMerge) {
+  StringPool pool;
+  StringPool other_pool;
+
+  std::vector<StringPool::Ref> refs;
+  std::vector<StringPool::Ref> other_refs;
+  for (int i = 0; i < 1000; i++) {
+    refs.push_back(pool.MakeRef("string" + std::to_string(i)));
+    other_refs.push_back(other_pool.MakeRef("other" + std::to_string(i)));
+  }
+
+  pool.Merge(std::move(other_pool));
+  StringPool::Ref ref = pool.MakeRef("new");
+
+  ASSERT_EQ(2001u, pool.size());
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ("string" + std::to_string(i), *refs[i]);
+    EXPECT_EQ(static_cast<size_t>(i), refs[i].index());
+    EXPECT_EQ("other" + std::to_string(i), *other_refs[i]);
+    EXPECT_EQ(static_cast<size_t>(1000 + i), other_refs[i].index());
+  }
+  EXPECT_EQ(2000u, ref.index());
+  EXPECT_EQ(refs[10].index(), pool.MakeRef("string10").index());
+}
+
+TEST(StringPoolTest, DedupeAgainstLiveDuplicateAfterPrune) {
+  StringPool pool;
+
+  { StringPool::Ref ref = pool.MakeRef("android"); }
+  StyleString str{{"android"}};
+  StringPool::StyleRef style_ref = pool.MakeRef(str);
+  pool.Prune();
+
+  StringPool::Ref ref = pool.MakeRef("android");
+  EXPECT_EQ(style_ref.index(), ref.index());
+  EXPECT_EQ(1u, pool.size());
+}
+
 TEST(StringPoolTest, AddStyles) {
   StringPool pool;
 
@@ -16,8 +16,12 @@
 
 #include <dirent.h>
 
+#include <algorithm>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include "android-base/errors.h"
 #include "android-base/file.h"
@@ -30,6 +34,7 @@
 #include "Flags.h"
 #include "ResourceParser.h"
 #include "ResourceTable.h"
+#include "ResourceUtils.h"
 #include "compile/IdAssigner.h"
 #include "compile/InlineXmlFormatParser.h"
 #include "compile/Png.h"
@@ -117,6 +122,7 @@ struct CompileOptions {
   bool no_png_crunch = false;
   bool legacy_mode = false;
   bool verbose = false;
+  size_t jobs = 1;
 };
 
 static std::string BuildIntermediateFilename(const ResourcePathData& data) {
@@ -653,6 +659,126 @@ class CompileContext : public IAaptContext {
   bool verbose_ = false;
 };
 
+/**
+ * Compiles a single input file and writes the result to writer.
+ */
+static bool CompileInput(IAaptContext* context, const CompileOptions& options,
+                         ResourcePathData* path_data, IArchiveWriter* writer) {
+  if (options.verbose) {
+    context->GetDiagnostics()->Note(DiagMessage(path_data->source) << "processing");
+  }
+
+  if (!IsValidFile(context, path_data->source.path)) {
+    return false;
+  }
+
+  if (path_data->resource_dir == "values") {
+    // Overwrite the extension.
+    path_data->extension = "arsc";
+
+    const std::string output_filename = BuildIntermediateFilename(*path_data);
+    return CompileTable(context, options, *path_data, writer, output_filename);
+  }
+
+  const std::string output_filename = BuildIntermediateFilename(*path_data);
+  if (const ResourceType* type = ParseResourceType(path_data->resource_dir)) {
+    if (*type != ResourceType::kRaw) {
+      if (path_data->extension == "xml") {
+        return CompileXml(context, options, *path_data, writer, output_filename);
+      } else if (!options.no_png_crunch &&
+                 (path_data->extension == "png" || path_data->extension == "9.png")) {
+        return CompilePng(context, options, *path_data, writer, output_filename);
+      }
+    }
+    return CompileFile(context, options, *path_data, writer, output_filename);
+  }
+
+  context->GetDiagnostics()->Error(DiagMessage() << "invalid file path '" << path_data->source
+                                                 << "'");
+  return false;
+}
+
+/**
+ * Compiles the input files on options.jobs threads. Each file is compiled with its own context,
+ * diagnostics and archive buffer; the results are written to archive_writer and the diagnostics
+ * printed in input order, so the output doesn't depend on scheduling.
+ */
+static bool CompileInParallel(CompileContext* context, const CompileOptions& options,
+                              std::vector<ResourcePathData>* input_data,
+                              IArchiveWriter* archive_writer) {
+  struct CompileResult {
+    BufferedDiagnostics diagnostics;
+    BufferedArchiveWriter writer;
+    bool success = false;
+  };
+
+  // Bounds how far the workers may get ahead of the file being written, which bounds the memory
+  // held by compiled files waiting for their turn.
+  const size_t max_pending = options.jobs * 4;
+
+  std::mutex lock;
+  std::condition_variable cond;
+  std::vector<std::unique_ptr<CompileResult>> results(input_data->size());
+  size_t next_input = 0;
+  size_t next_output = 0;
+
+  auto worker = [&]() {
+    while (true) {
+      size_t index;
+      {
+        std::unique_lock<std::mutex> l(lock);
+        cond.wait(l, [&]() {
+          return next_input >= input_data->size() || next_input < next_output + max_pending;
+        });
+        if (next_input >= input_data->size()) {
+          return;
+        }
+        index = next_input++;
+      }
+
+      std::unique_ptr<CompileResult> result = util::make_unique<CompileResult>();
+      CompileContext job_context(&result->diagnostics);
+      job_context.SetVerbose(context->IsVerbose());
+      result->success =
+          CompileInput(&job_context, options, &(*input_data)[index], &result->writer);
+
+      {
+        std::lock_guard<std::mutex> l(lock);
+        results[index] = std::move(result);
+      }
+      cond.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  const size_t worker_count = std::min(options.jobs, input_data->size());
+  for (size_t i = 0; i < worker_count; i++) {
+    workers.emplace_back(worker);
+  }
+
+  bool error = false;
+  for (size_t i = 0; i < input_data->size(); i++) {
+    std::unique_ptr<CompileResult> result;
+    {
+      std::unique_lock<std::mutex> l(lock);
+      cond.wait(l, [&]() { return results[i] != nullptr; });
+      result = std::move(results[i]);
+      next_output = i + 1;
+    }
+    cond.notify_all();
+
+    result->diagnostics.Flush(context->GetDiagnostics());
+    if (!result->success || !result->writer.Flush(archive_writer, context->GetDiagnostics())) {
+      error = true;
+    }
+  }
+
+  for (std::thread& t : workers) {
+    t.join();
+  }
+  return !error;
+}
+
 /**
  * Entry point for compilation phase. Parses arguments and dispatches to the
  * correct steps.
@@ -662,6 +788,7 @@ int Compile(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
   CompileOptions options;
 
   bool verbose = false;
+  Maybe<std::string> jobs;
   Flags flags =
       Flags()
           .RequiredFlag("-o", "Output path", &options.output_path)
@@ -673,11 +800,22 @@ int Compile(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
           .OptionalSwitch("--no-crunch", "Disables PNG processing", &options.no_png_crunch)
           .OptionalSwitch("--legacy", "Treat errors that used to be valid in AAPT as warnings",
                           &options.legacy_mode)
+          .OptionalFlag("-j", "Number of files to compile in parallel (defaults to 1)", &jobs)
           .OptionalSwitch("-v", "Enables verbose logging", &verbose);
   if (!flags.Parse("aapt2 compile", args, &std::cerr)) {
     return 1;
   }
 
+  if (jobs) {
+    const Maybe<uint32_t> maybe_jobs = ResourceUtils::ParseInt(jobs.value());
+    if (!maybe_jobs || maybe_jobs.value() == 0) {
+      context.GetDiagnostics()->Error(DiagMessage() << "invalid number of jobs '" << jobs.value()
+                                                    << "'");
+      return 1;
+    }
+    options.jobs = maybe_jobs.value();
+  }
+
   context.SetVerbose(verbose);
 
   std::unique_ptr<IArchiveWriter> archive_writer;
@@ -695,6 +833,12 @@ int Compile(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
       return 1;
     }
 
+    // Directory entries come in no particular order; sort them so the archive is reproducible.
+    std::sort(input_data.begin(), input_data.end(),
+              [](const ResourcePathData& a, const ResourcePathData& b) -> bool {
+                return a.source.path < b.source.path;
+              });
+
     archive_writer = CreateZipFileArchiveWriter(context.GetDiagnostics(), options.output_path);
 
   } else {
@@ -719,51 +863,11 @@ int Compile(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
   }
 
   bool error = false;
-  for (ResourcePathData& path_data : input_data) {
-    if (options.verbose) {
-      context.GetDiagnostics()->Note(DiagMessage(path_data.source) << "processing");
-    }
-
-    if (!IsValidFile(&context, path_data.source.path)) {
-      error = true;
-      continue;
-    }
-
-    if (path_data.resource_dir == "values") {
-      // Overwrite the extension.
-      path_data.extension = "arsc";
-
-      const std::string output_filename = BuildIntermediateFilename(path_data);
-      if (!CompileTable(&context, options, path_data, archive_writer.get(), output_filename)) {
-        error = true;
-      }
-
-    } else {
-      const std::string output_filename = BuildIntermediateFilename(path_data);
-      if (const ResourceType* type = ParseResourceType(path_data.resource_dir)) {
-        if (*type != ResourceType::kRaw) {
-          if (path_data.extension == "xml") {
-            if (!CompileXml(&context, options, path_data, archive_writer.get(), output_filename)) {
-              error = true;
-            }
-          } else if (!options.no_png_crunch &&
-                     (path_data.extension == "png" || path_data.extension == "9.png")) {
-            if (!CompilePng(&context, options, path_data, archive_writer.get(), output_filename)) {
-              error = true;
-            }
-          } else {
-            if (!CompileFile(&context, options, path_data, archive_writer.get(), output_filename)) {
-              error = true;
-            }
-          }
-        } else {
-          if (!CompileFile(&context, options, path_data, archive_writer.get(), output_filename)) {
-            error = true;
-          }
-        }
-      } else {
-        context.GetDiagnostics()->Error(DiagMessage() << "invalid file path '" << path_data.source
-                                                      << "'");
+  if (options.jobs > 1 && input_data.size() > 1) {
+    error = !CompileInParallel(&context, options, &input_data, archive_writer.get());
+  } else {
+    for (ResourcePathData& path_data : input_data) {
+      if (!CompileInput(&context, options, &path_data, archive_writer.get())) {
         error = true;
       }
     }
@@ -46,9 +46,16 @@ bool DumpCompiledFile(const pb::CompiledFile& pb_file, const void* data, size_t
   return true;
 }
 
-bool TryDumpFile(IAaptContext* context, const std::string& file_path) {
-  std::unique_ptr<ResourceTable> table;
+// Prints a table. APK tables are read and printed one package at a time, so that the whole table
+// is never held in memory at once.
+static bool PrintPackage(ResourceTable* table) {
+  DebugPrintTableOptions options;
+  options.show_sources = true;
+  Debug::PrintTable(table, options);
+  return true;
+}
 
+bool TryDumpFile(IAaptContext* context, const std::string& file_path) {
   std::string err;
   std::unique_ptr<io::ZipFileCollection> zip = io::ZipFileCollection::Create(file_path, &err);
   if (zip) {
@@ -67,83 +74,72 @@ bool TryDumpFile(IAaptContext* context, const std::string& file_path) {
         return false;
       }
 
-      table = DeserializeTableFromPb(pb_table, Source(file_path), context->GetDiagnostics());
-      if (!table) {
-        return false;
-      }
+      // The serialized table is no longer needed once it has been parsed.
+      data = {};
+      return DeserializeTableFromPbByPackage(pb_table, Source(file_path),
+                                             context->GetDiagnostics(), PrintPackage);
     }
 
-    if (!table) {
-      file = zip->FindFile("resources.arsc");
-      if (file) {
-        std::unique_ptr<io::IData> data = file->OpenAsData();
-        if (!data) {
-          context->GetDiagnostics()->Error(DiagMessage(file_path)
-                                           << "failed to open resources.arsc");
-          return false;
-        }
-
-        table = util::make_unique<ResourceTable>();
-        BinaryResourceParser parser(context, table.get(), Source(file_path), data->data(),
-                                    data->size());
-        if (!parser.Parse()) {
-          return false;
-        }
+    file = zip->FindFile("resources.arsc");
+    if (file) {
+      std::unique_ptr<io::IData> data = file->OpenAsData();
+      if (!data) {
+        context->GetDiagnostics()->Error(DiagMessage(file_path)
+                                         << "failed to open resources.arsc");
+        return false;
       }
+
+      ResourceTable table;
+      BinaryResourceParser parser(context, &table, Source(file_path), data->data(),
+                                  data->size());
+      return parser.ParseByPackage(PrintPackage);
     }
   }
 
-  if (!table) {
-    Maybe<android::FileMap> file = file::MmapPath(file_path, &err);
-    if (!file) {
-      context->GetDiagnostics()->Error(DiagMessage(file_path) << err);
-      return false;
-    }
+  Maybe<android::FileMap> file = file::MmapPath(file_path, &err);
+  if (!file) {
+    context->GetDiagnostics()->Error(DiagMessage(file_path) << err);
+    return false;
+  }
 
-    android::FileMap* file_map = &file.value();
+  android::FileMap* file_map = &file.value();
 
-    // Try as a compiled table.
-    pb::ResourceTable pb_table;
-    if (pb_table.ParseFromArray(file_map->getDataPtr(), file_map->getDataLength())) {
-      table = DeserializeTableFromPb(pb_table, Source(file_path), context->GetDiagnostics());
+  // Try as a compiled table.
+  pb::ResourceTable pb_table;
+  if (pb_table.ParseFromArray(file_map->getDataPtr(), file_map->getDataLength())) {
+    std::unique_ptr<ResourceTable> table =
+        DeserializeTableFromPb(pb_table, Source(file_path), context->GetDiagnostics());
+    if (table) {
+      return PrintPackage(table.get());
     }
+  }
 
-    if (!table) {
-      // Try as a compiled file.
-      CompiledFileInputStream input(file_map->getDataPtr(), file_map->getDataLength());
+  // Try as a compiled file.
+  CompiledFileInputStream input(file_map->getDataPtr(), file_map->getDataLength());
 
-      uint32_t num_files = 0;
-      if (!input.ReadLittleEndian32(&num_files)) {
-        return false;
-      }
+  uint32_t num_files = 0;
+  if (!input.ReadLittleEndian32(&num_files)) {
+    return false;
+  }
 
-      for (uint32_t i = 0; i < num_files; i++) {
-        pb::CompiledFile compiled_file;
-        if (!input.ReadCompiledFile(&compiled_file)) {
-          context->GetDiagnostics()->Warn(DiagMessage() << "failed to read compiled file");
-          return false;
-        }
-
-        uint64_t offset, len;
-        if (!input.ReadDataMetaData(&offset, &len)) {
-          context->GetDiagnostics()->Warn(DiagMessage() << "failed to read meta data");
-          return false;
-        }
-
-        const void* data = static_cast<const uint8_t*>(file_map->getDataPtr()) + offset;
-        if (!DumpCompiledFile(compiled_file, data, len, Source(file_path), context)) {
-          return false;
-        }
-      }
+  for (uint32_t i = 0; i < num_files; i++) {
+    pb::CompiledFile compiled_file;
+    if (!input.ReadCompiledFile(&compiled_file)) {
+      context->GetDiagnostics()->Warn(DiagMessage() << "failed to read compiled file");
+      return false;
     }
-  }
 
-  if (table) {
-    DebugPrintTableOptions options;
-    options.show_sources = true;
-    Debug::PrintTable(table.get(), options);
-  }
+    uint64_t offset, len;
+    if (!input.ReadDataMetaData(&offset, &len)) {
+      context->GetDiagnostics()->Warn(DiagMessage() << "failed to read meta data");
+      return false;
+    }
 
+    const void* data = static_cast<const uint8_t*>(file_map->getDataPtr()) + offset;
+    if (!DumpCompiledFile(compiled_file, data, len, Source(file_path), context)) {
+      return false;
+    }
+  }
   return true;
 }
 
@@ -16,8 +16,11 @@
 
 #include <sys/stat.h>
 
+#include <atomic>
 #include <fstream>
+#include <mutex>
 #include <queue>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -46,6 +49,7 @@
 #include "java/JavaClassGenerator.h"
 #include "java/ManifestClassGenerator.h"
 #include "java/ProguardRules.h"
+#include "link/LinkCache.h"
 #include "link/Linkers.h"
 #include "link/ManifestFixer.h"
 #include "link/ReferenceLinker.h"
@@ -95,6 +99,12 @@ struct LinkOptions {
   bool do_not_compress_anything = false;
   std::unordered_set<std::string> extensions_to_not_compress;
 
+  // Number of threads used to link and flatten XML files.
+  size_t jobs = 1;
+
+  // Directory in which linked XML files are cached between runs.
+  Maybe<std::string> link_cache_dir;
+
   // Static lib options.
   bool no_static_lib_packages = false;
 
@@ -248,8 +258,11 @@ class FeatureSplitSymbolTableDelegate : public DefaultSymbolTableDelegate {
   IAaptContext* context_;
 };
 
+// Flattens xml_res and writes it to path in the archive. If out_data is set, it receives a copy
+// of the flattened file.
 static bool FlattenXml(IAaptContext* context, xml::XmlResource* xml_res, const StringPiece& path,
-                       bool keep_raw_values, IArchiveWriter* writer) {
+                       bool keep_raw_values, IArchiveWriter* writer,
+                       std::string* out_data = nullptr) {
   BigBuffer buffer(1024);
   XmlFlattenerOptions options = {};
   options.keep_raw_values = keep_raw_values;
@@ -258,6 +271,10 @@ static bool FlattenXml(IAaptContext* context, xml::XmlResource* xml_res, const S
     return false;
   }
 
+  if (out_data) {
+    *out_data = buffer.to_string();
+  }
+
   if (context->IsVerbose()) {
     context->GetDiagnostics()->Note(DiagMessage(path) << "writing to archive (keep_raw_values="
                                                       << (keep_raw_values ? "true" : "false")
@@ -296,6 +313,96 @@ static std::unique_ptr<xml::XmlResource> LoadXml(const std::string& path, IDiagn
   return xml::Inflate(&fin, diag, Source(path));
 }
 
+// Forwards lookups to a SymbolTable shared between threads, holding a lock. Symbols are copied,
+// since the shared table may evict them from its cache once the lock is released.
+class LockedSymbolSource : public ISymbolSource {
+ public:
+  LockedSymbolSource(SymbolTable* symbols, std::mutex* lock) : symbols_(symbols), lock_(lock) {
+  }
+
+  std::unique_ptr<SymbolTable::Symbol> FindByName(const ResourceName& name) override {
+    std::lock_guard<std::mutex> lock(*lock_);
+    return Copy(symbols_->FindByName(name));
+  }
+
+  std::unique_ptr<SymbolTable::Symbol> FindById(ResourceId id) override {
+    std::lock_guard<std::mutex> lock(*lock_);
+    return Copy(symbols_->FindById(id));
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(LockedSymbolSource);
+
+  static std::unique_ptr<SymbolTable::Symbol> Copy(const SymbolTable::Symbol* symbol) {
+    if (symbol == nullptr) {
+      return {};
+    }
+    return util::make_unique<SymbolTable::Symbol>(*symbol);
+  }
+
+  SymbolTable* symbols_;
+  std::mutex* lock_;
+};
+
+// The context of a thread linking XML files. It has its own symbol table, backed by the external
+// symbols of the wrapped context, and its own diagnostics.
+class XmlLinkContext : public IAaptContext {
+ public:
+  XmlLinkContext(IAaptContext* context, std::mutex* symbols_lock)
+      : context_(context),
+        diagnostics_(context->GetDiagnostics()),
+        // Names are mangled by the external symbol table, not by this one.
+        name_mangler_(NameManglerPolicy{context->GetNameMangler()->GetTargetPackageName()}),
+        symbols_(&name_mangler_) {
+    symbols_.AppendSource(
+        util::make_unique<LockedSymbolSource>(context->GetExternalSymbols(), symbols_lock));
+  }
+
+  PackageType GetPackageType() override {
+    return context_->GetPackageType();
+  }
+
+  SymbolTable* GetExternalSymbols() override {
+    return &symbols_;
+  }
+
+  IDiagnostics* GetDiagnostics() override {
+    return diagnostics_;
+  }
+
+  void SetDiagnostics(IDiagnostics* diagnostics) {
+    diagnostics_ = diagnostics;
+  }
+
+  const std::string& GetCompilationPackage() override {
+    return context_->GetCompilationPackage();
+  }
+
+  uint8_t GetPackageId() override {
+    return context_->GetPackageId();
+  }
+
+  NameMangler* GetNameMangler() override {
+    return context_->GetNameMangler();
+  }
+
+  bool IsVerbose() override {
+    return context_->IsVerbose();
+  }
+
+  int GetMinSdkVersion() override {
+    return context_->GetMinSdkVersion();
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(XmlLinkContext);
+
+  IAaptContext* context_;
+  IDiagnostics* diagnostics_;
+  NameMangler name_mangler_;
+  SymbolTable symbols_;
+};
+
 struct ResourceFileFlattenerOptions {
   bool no_auto_version = false;
   bool no_version_vectors = false;
@@ -305,6 +412,12 @@ struct ResourceFileFlattenerOptions {
   bool do_not_compress_anything = false;
   bool update_proguard_spec = false;
   std::unordered_set<std::string> extensions_to_not_compress;
+  size_t jobs = 1;
+
+  // When set, linked XML files are looked up in and added to this cache. link_cache_inputs is a
+  // hash of the inputs that are not part of the ResourceTable, like the included APKs.
+  const LinkCache* link_cache = nullptr;
+  std::string link_cache_inputs;
 };
 
 // A sampling of public framework resource IDs.
@@ -352,17 +465,60 @@ class ResourceFileFlattener {
 
     // The destination to write this file to.
     std::string dst_path;
+
+    // The hash of the compiled XML file, when using a link cache.
+    std::string content_hash;
+  };
+
+  // The outcome of linking and flattening one XML file on a worker thread, replayed in order on
+  // the main thread.
+  struct XmlFlattenResult {
+    BufferedDiagnostics diagnostics;
+    BufferedArchiveWriter writer;
+
+    // The file failed to link or flatten. Other files are still processed.
+    bool error = false;
+
+    // The versioned files could not be added to the table. Flattening stops here.
+    bool fatal = false;
   };
 
   uint32_t GetCompressionFlags(const StringPiece& str);
 
-  std::vector<std::unique_ptr<xml::XmlResource>> LinkAndVersionXmlFile(ResourceTable* table,
+  std::vector<std::unique_ptr<xml::XmlResource>> LinkAndVersionXmlFile(IAaptContext* context,
+                                                                       ResourceTable* table,
                                                                        FileOperation* file_op);
 
+  // Links, versions and flattens the XML file of file_op into result.
+  void FlattenXmlFile(IAaptContext* context, ResourceTable* table, FileOperation* file_op,
+                      XmlFlattenResult* result);
+
+  // Returns the key of file_op in the link cache.
+  std::string GetCacheKey(FileOperation* file_op);
+
+  // Writes the files cached for file_op into result, as FlattenXmlFile() would have.
+  void RestoreCachedXmlFile(IAaptContext* context, ResourceTable* table, FileOperation* file_op,
+                            const std::vector<LinkCache::File>& files, XmlFlattenResult* result);
+
+  // Flattens the files of a type using options_.jobs threads. Files of the same entry are
+  // processed in order by the same thread, since auto-versioning depends on the versions
+  // added for the previous configurations. This is also used with a link cache, which only
+  // stores files that were flattened without warnings.
+  bool FlattenInParallel(
+      ResourceTable* table,
+      std::map<std::pair<ConfigDescription, StringPiece>, FileOperation>* config_sorted_files,
+      IArchiveWriter* archive_writer, bool* out_error);
+
   ResourceFileFlattenerOptions options_;
   IAaptContext* context_;
   proguard::KeepSet* keep_set_;
   XmlCompatVersioner::Rules rules_;
+
+  // Guards the ResourceTable, the external symbols and the keep set while flattening in parallel.
+  std::mutex lock_;
+
+  // The part of the link cache keys shared by all files of the table.
+  std::string cache_inputs_;
 };
 
 ResourceFileFlattener::ResourceFileFlattener(const ResourceFileFlattenerOptions& options,
@@ -452,26 +608,29 @@ std::vector<T> make_singleton_vec(T&& val) {
 }
 
 std::vector<std::unique_ptr<xml::XmlResource>> ResourceFileFlattener::LinkAndVersionXmlFile(
-    ResourceTable* table, FileOperation* file_op) {
+    IAaptContext* context, ResourceTable* table, FileOperation* file_op) {
   xml::XmlResource* doc = file_op->xml_to_flatten.get();
   const Source& src = doc->file.source;
 
-  if (context_->IsVerbose()) {
-    context_->GetDiagnostics()->Note(DiagMessage() << "linking " << src.path);
+  if (context->IsVerbose()) {
+    context->GetDiagnostics()->Note(DiagMessage() << "linking " << src.path);
   }
 
   XmlReferenceLinker xml_linker;
-  if (!xml_linker.Consume(context_, doc)) {
+  if (!xml_linker.Consume(context, doc)) {
     return {};
   }
 
-  if (options_.update_proguard_spec && !proguard::CollectProguardRules(src, doc, keep_set_)) {
-    return {};
+  if (options_.update_proguard_spec) {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!proguard::CollectProguardRules(src, doc, keep_set_)) {
+      return {};
+    }
   }
 
   if (options_.no_xml_namespaces) {
     XmlNamespaceRemover namespace_remover;
-    if (!namespace_remover.Consume(context_, doc)) {
+    if (!namespace_remover.Consume(context, doc)) {
       return {};
     }
   }
@@ -494,14 +653,224 @@ std::vector<std::unique_ptr<xml::XmlResource>> ResourceFileFlattener::LinkAndVer
   const ConfigDescription& config = file_op->config;
   ResourceEntry* entry = file_op->entry;
 
+  ApiVersion next_api_version;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    next_api_version = FindNextApiVersionForConfig(entry, config);
+  }
+
   XmlCompatVersioner xml_compat_versioner(&rules_);
-  const util::Range<ApiVersion> api_range{config.sdkVersion,
-                                          FindNextApiVersionForConfig(entry, config)};
-  return xml_compat_versioner.Process(context_, doc, api_range);
+  const util::Range<ApiVersion> api_range{config.sdkVersion, next_api_version};
+  return xml_compat_versioner.Process(context, doc, api_range);
+}
+
+std::string ResourceFileFlattener::GetCacheKey(FileOperation* file_op) {
+  ContentHasher hasher;
+  hasher.Update(cache_inputs_);
+  hasher.Update(file_op->dst_path);
+  hasher.Update(file_op->config.toString().string());
+  hasher.Update(file_op->xml_to_flatten->file.source.path);
+  hasher.Update(file_op->content_hash);
+  {
+    // Auto-versioning depends on the other configurations of the entry.
+    std::lock_guard<std::mutex> lock(lock_);
+    for (auto& config_value : file_op->entry->values) {
+      hasher.Update(config_value->config.toString().string());
+    }
+  }
+  return hasher.Digest();
+}
+
+void ResourceFileFlattener::RestoreCachedXmlFile(IAaptContext* context, ResourceTable* table,
+                                                 FileOperation* file_op,
+                                                 const std::vector<LinkCache::File>& files,
+                                                 XmlFlattenResult* result) {
+  xml::XmlResource* doc = file_op->xml_to_flatten.get();
+  if (context->IsVerbose()) {
+    context->GetDiagnostics()->Note(DiagMessage(doc->file.source) << "using cached link result");
+  }
+
+  // The rules only depend on the names of the elements and attributes, which linking leaves as-is.
+  if (options_.update_proguard_spec) {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!proguard::CollectProguardRules(doc->file.source, doc, keep_set_)) {
+      return;
+    }
+  }
+
+  for (const LinkCache::File& file : files) {
+    if (file.config != file_op->config) {
+      if (context->IsVerbose()) {
+        context->GetDiagnostics()->Note(DiagMessage(doc->file.source)
+                                        << "auto-versioning resource from config '"
+                                        << file_op->config << "' -> '" << file.config << "'");
+      }
+
+      bool added;
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        added = table->AddFileReferenceAllowMangled(doc->file.name, file.config, doc->file.source,
+                                                    file.path, nullptr, context->GetDiagnostics());
+      }
+      if (!added) {
+        result->fatal = true;
+        return;
+      }
+    }
+
+    BigBuffer buffer(file.data.size());
+    memcpy(buffer.NextBlock<char>(file.data.size()), file.data.data(), file.data.size());
+    io::BigBufferInputStream input_stream(&buffer);
+    result->error |= !io::CopyInputStreamToArchive(context, &input_stream, file.path,
+                                                    ArchiveEntry::kCompress, &result->writer);
+  }
+}
+
+void ResourceFileFlattener::FlattenXmlFile(IAaptContext* context, ResourceTable* table,
+                                           FileOperation* file_op, XmlFlattenResult* result) {
+  std::string cache_key;
+  if (options_.link_cache) {
+    cache_key = GetCacheKey(file_op);
+    std::vector<LinkCache::File> cached_files;
+    if (options_.link_cache->Load(cache_key, &cached_files)) {
+      RestoreCachedXmlFile(context, table, file_op, cached_files, result);
+      return;
+    }
+  }
+
+  std::vector<LinkCache::File> files_to_cache;
+  std::vector<std::unique_ptr<xml::XmlResource>> versioned_docs =
+      LinkAndVersionXmlFile(context, table, file_op);
+  for (std::unique_ptr<xml::XmlResource>& doc : versioned_docs) {
+    std::string dst_path = file_op->dst_path;
+    if (doc->file.config != file_op->config) {
+      // Only add the new versioned configurations.
+      if (context->IsVerbose()) {
+        context->GetDiagnostics()->Note(DiagMessage(doc->file.source)
+                                        << "auto-versioning resource from config '"
+                                        << file_op->config << "' -> '" << doc->file.config << "'");
+      }
+
+      dst_path = ResourceUtils::BuildResourceFileName(doc->file, context->GetNameMangler());
+      bool added;
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        added = table->AddFileReferenceAllowMangled(doc->file.name, doc->file.config,
+                                                    doc->file.source, dst_path, nullptr,
+                                                    context->GetDiagnostics());
+      }
+      if (!added) {
+        result->fatal = true;
+        return;
+      }
+    }
+
+    std::string* data = nullptr;
+    if (options_.link_cache) {
+      files_to_cache.push_back(LinkCache::File{dst_path, doc->file.config, {}});
+      data = &files_to_cache.back().data;
+    }
+    result->error |= !FlattenXml(context, doc.get(), dst_path, options_.keep_raw_values,
+                                 &result->writer, data);
+  }
+
+  // Warnings are not cached, so files that have some are linked again to print them.
+  if (options_.link_cache && !files_to_cache.empty() && !result->error &&
+      !result->diagnostics.HadWarnings()) {
+    if (!options_.link_cache->Store(cache_key, files_to_cache) && context->IsVerbose()) {
+      context->GetDiagnostics()->Note(DiagMessage(file_op->xml_to_flatten->file.source)
+                                      << "failed to write link cache entry");
+    }
+  }
+}
+
+bool ResourceFileFlattener::FlattenInParallel(
+    ResourceTable* table,
+    std::map<std::pair<ConfigDescription, StringPiece>, FileOperation>* config_sorted_files,
+    IArchiveWriter* archive_writer, bool* out_error) {
+  // Group the XML files by entry, keeping them in config order.
+  std::vector<std::vector<size_t>> groups;
+  std::unordered_map<ResourceEntry*, size_t> group_index;
+  std::vector<FileOperation*> file_ops;
+  std::vector<std::unique_ptr<XmlFlattenResult>> results;
+  for (auto& map_entry : *config_sorted_files) {
+    FileOperation* file_op = &map_entry.second;
+    file_ops.push_back(file_op);
+    results.emplace_back();
+    if (!file_op->xml_to_flatten) {
+      continue;
+    }
+
+    auto inserted = group_index.insert(std::make_pair(file_op->entry, groups.size()));
+    if (inserted.second) {
+      groups.emplace_back();
+    }
+    groups[inserted.first->second].push_back(file_ops.size() - 1);
+    results.back() = util::make_unique<XmlFlattenResult>();
+  }
+
+  std::atomic<size_t> next_group(0);
+  auto worker = [&]() {
+    XmlLinkContext context(context_, &lock_);
+    for (size_t g = next_group++; g < groups.size(); g = next_group++) {
+      for (size_t i : groups[g]) {
+        XmlFlattenResult* result = results[i].get();
+        context.SetDiagnostics(&result->diagnostics);
+        FlattenXmlFile(&context, table, file_ops[i], result);
+        if (result->fatal) {
+          break;
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  const size_t thread_count = std::min(options_.jobs, groups.size());
+  for (size_t i = 0; i < thread_count; i++) {
+    threads.emplace_back(worker);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // Write the files in the same order as when flattening them one by one.
+  for (size_t i = 0; i < file_ops.size(); i++) {
+    FileOperation* file_op = file_ops[i];
+    XmlFlattenResult* result = results[i].get();
+    if (result == nullptr) {
+      *out_error |= !io::CopyFileToArchive(context_, file_op->file_to_copy, file_op->dst_path,
+                                           GetCompressionFlags(file_op->dst_path), archive_writer);
+      continue;
+    }
+
+    result->diagnostics.Flush(context_->GetDiagnostics());
+    if (result->fatal) {
+      return false;
+    }
+    *out_error |= result->error;
+    *out_error |= !result->writer.Flush(archive_writer, context_->GetDiagnostics());
+  }
+  return true;
 }
 
 bool ResourceFileFlattener::Flatten(ResourceTable* table, IArchiveWriter* archive_writer) {
   bool error = false;
+  if (options_.link_cache) {
+    ContentHasher hasher;
+    hasher.Update(options_.link_cache_inputs);
+    hasher.Update(HashResourceTable(table));
+    hasher.Update(context_->GetCompilationPackage());
+    hasher.Update(context_->GetNameMangler()->GetTargetPackageName());
+    hasher.Update(static_cast<uint32_t>(context_->GetPackageType()));
+    hasher.Update(static_cast<uint32_t>(context_->GetPackageId()));
+    hasher.Update(static_cast<uint32_t>(context_->GetMinSdkVersion()));
+    hasher.Update(static_cast<uint32_t>(options_.keep_raw_values) |
+                  static_cast<uint32_t>(options_.no_auto_version) << 1 |
+                  static_cast<uint32_t>(options_.no_version_vectors) << 2 |
+                  static_cast<uint32_t>(options_.no_version_transitions) << 3 |
+                  static_cast<uint32_t>(options_.no_xml_namespaces) << 4);
+    cache_inputs_ = hasher.Digest();
+  }
   std::map<std::pair<ConfigDescription, StringPiece>, FileOperation> config_sorted_files;
 
   for (auto& pkg : table->packages) {
@@ -544,6 +913,12 @@ bool ResourceFileFlattener::Flatten(ResourceTable* table, IArchiveWriter* archiv
               return false;
             }
 
+            if (options_.link_cache) {
+              ContentHasher hasher;
+              hasher.Update(data->data(), data->size());
+              file_op.content_hash = hasher.Digest();
+            }
+
             file_op.xml_to_flatten = xml::Inflate(data->data(), data->size(),
                                                   context_->GetDiagnostics(), file->GetSource());
 
@@ -566,6 +941,13 @@ bool ResourceFileFlattener::Flatten(ResourceTable* table, IArchiveWriter* archiv
         }
       }
 
+      if (options_.jobs > 1 || options_.link_cache) {
+        if (!FlattenInParallel(table, &config_sorted_files, archive_writer, &error)) {
+          return false;
+        }
+        continue;
+      }
+
       // Now flatten the sorted values.
       for (auto& map_entry : config_sorted_files) {
         const ConfigDescription& config = map_entry.first.first;
@@ -573,7 +955,7 @@ bool ResourceFileFlattener::Flatten(ResourceTable* table, IArchiveWriter* archiv
 
         if (file_op.xml_to_flatten) {
           std::vector<std::unique_ptr<xml::XmlResource>> versioned_docs =
-              LinkAndVersionXmlFile(table, &file_op);
+              LinkAndVersionXmlFile(context_, table, &file_op);
           for (std::unique_ptr<xml::XmlResource>& doc : versioned_docs) {
             std::string dst_path = file_op.dst_path;
             if (doc->file.config != file_op.config) {
@@ -1393,6 +1775,9 @@ class LinkCommand {
     file_flattener_options.no_xml_namespaces = options_.no_xml_namespaces;
     file_flattener_options.update_proguard_spec =
         static_cast<bool>(options_.generate_proguard_rules_path);
+    file_flattener_options.jobs = options_.jobs;
+    file_flattener_options.link_cache = link_cache_.get();
+    file_flattener_options.link_cache_inputs = link_cache_inputs_;
 
     ResourceFileFlattener file_flattener(file_flattener_options, context_, keep_set);
 
@@ -1414,6 +1799,32 @@ class LinkCommand {
     return true;
   }
 
+  // Opens the link cache. The included APKs are hashed here, since linked files depend on the
+  // symbols they define.
+  bool LoadLinkCache() {
+    const std::string& dir = options_.link_cache_dir.value();
+    if (!file::mkdirs(dir)) {
+      context_->GetDiagnostics()->Error(DiagMessage() << "failed to create directory '" << dir
+                                                      << "'");
+      return false;
+    }
+
+    ContentHasher hasher;
+    for (const std::string& path : options_.include_paths) {
+      std::string content;
+      if (!android::base::ReadFileToString(path, &content)) {
+        context_->GetDiagnostics()->Error(DiagMessage(path) << "failed to read include path: "
+                                                            << strerror(errno));
+        return false;
+      }
+      hasher.Update(path);
+      hasher.Update(content);
+    }
+    link_cache_inputs_ = hasher.Digest();
+    link_cache_ = util::make_unique<LinkCache>(dir);
+    return true;
+  }
+
   int Run(const std::vector<std::string>& input_files) {
     // Load the AndroidManifest.xml
     std::unique_ptr<xml::XmlResource> manifest_xml =
@@ -1461,6 +1872,10 @@ class LinkCommand {
       return 1;
     }
 
+    if (options_.link_cache_dir && !LoadLinkCache()) {
+      return 1;
+    }
+
     TableMergerOptions table_merger_options;
     table_merger_options.auto_add_overlay = options_.auto_add_overlay;
     table_merger_ = util::make_unique<TableMerger>(context_, &final_table_, table_merger_options);
@@ -1823,6 +2238,9 @@ class LinkCommand {
 
   // The set of shared libraries being used, mapping their assigned package ID to package name.
   std::map<size_t, std::string> shared_libs_;
+
+  std::unique_ptr<LinkCache> link_cache_;
+  std::string link_cache_inputs_;
 };
 
 int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
@@ -1841,6 +2259,7 @@ int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
   bool static_lib = false;
   Maybe<std::string> stable_id_file_path;
   std::vector<std::string> split_args;
+  Maybe<std::string> jobs;
   Flags flags =
       Flags()
           .RequiredFlag("-o", "Output path.", &options.output_path)
@@ -1966,6 +2385,11 @@ int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
                             "Syntax: path/to/output.apk:<config>[,<config>[...]].\n"
                             "On Windows, use a semicolon ';' separator instead.",
                             &split_args)
+          .OptionalFlag("-j", "Number of threads used to link XML files (defaults to 1).", &jobs)
+          .OptionalFlag("--link-cache",
+                        "Directory in which to cache linked XML files, so that unchanged files\n"
+                        "are not linked again by later invocations.",
+                        &options.link_cache_dir)
           .OptionalSwitch("-v", "Enables verbose logging.", &verbose);
 
   if (!flags.Parse("aapt2 link", args, &std::cerr)) {
@@ -2005,6 +2429,16 @@ int Link(const std::vector<StringPiece>& args, IDiagnostics* diagnostics) {
     context.SetVerbose(verbose);
   }
 
+  if (jobs) {
+    const Maybe<uint32_t> maybe_jobs = ResourceUtils::ParseInt(jobs.value());
+    if (!maybe_jobs || maybe_jobs.value() == 0) {
+      context.GetDiagnostics()->Error(DiagMessage() << "invalid number of jobs '" << jobs.value()
+                                                    << "'");
+      return 1;
+    }
+    options.jobs = maybe_jobs.value();
+  }
+
   if (shared_lib && static_lib) {
     context.GetDiagnostics()->Error(DiagMessage()
                                     << "only one of --shared-lib and --static-lib can be defined");
@@ -17,6 +17,7 @@
 #include "flatten/Archive.h"
 
 #include <cstdio>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <vector>
@@ -26,6 +27,7 @@
 #include "androidfw/StringPiece.h"
 #include "ziparchive/zip_writer.h"
 
+#include "io/BigBufferInputStream.h"
 #include "util/Files.h"
 
 using android::StringPiece;
@@ -140,7 +142,10 @@ class ZipFileWriter : public IArchiveWriter {
       zip_flags |= ZipWriter::kCompress;
     }
 
-    if (flags & ArchiveEntry::kAlign) {
+    // Stored entries are always aligned, so that they can be mapped directly from the APK. This
+    // also covers files that end up stored because they didn't compress well (see WriteFile()),
+    // and makes a separate zipalign pass unnecessary for what aapt2 writes.
+    if ((flags & ArchiveEntry::kAlign) || !(flags & ArchiveEntry::kCompress)) {
       zip_flags |= ZipWriter::kAlign32;
     }
 
@@ -239,6 +244,85 @@ class ZipFileWriter : public IArchiveWriter {
 
 }  // namespace
 
+bool BufferedArchiveWriter::WriteFile(const StringPiece& path, uint32_t flags,
+                                      io::InputStream* in) {
+  if (!StartEntry(path, flags)) {
+    return false;
+  }
+  entries_.back()->whole_file = true;
+
+  const void* data = nullptr;
+  size_t len = 0;
+  while (in->Next(&data, &len)) {
+    if (!Write(data, static_cast<int>(len))) {
+      return false;
+    }
+  }
+  return !in->HadError() && FinishEntry();
+}
+
+bool BufferedArchiveWriter::StartEntry(const StringPiece& path, uint32_t flags) {
+  if (open_) {
+    return false;
+  }
+  entries_.push_back(util::make_unique<Entry>(path, flags));
+  open_ = true;
+  return true;
+}
+
+bool BufferedArchiveWriter::Write(const void* data, int len) {
+  if (!open_) {
+    return false;
+  }
+  if (len > 0) {
+    memcpy(entries_.back()->buffer.NextBlock<uint8_t>(len), data, len);
+  }
+  return true;
+}
+
+bool BufferedArchiveWriter::FinishEntry() {
+  if (!open_) {
+    return false;
+  }
+  open_ = false;
+  return true;
+}
+
+bool BufferedArchiveWriter::Flush(IArchiveWriter* writer, IDiagnostics* diag) {
+  for (const std::unique_ptr<Entry>& entry : entries_) {
+    io::BigBufferInputStream in(&entry->buffer);
+    if (entry->whole_file) {
+      if (!writer->WriteFile(entry->path, entry->flags, &in)) {
+        diag->Error(DiagMessage() << "failed to write " << entry->path
+                                  << " to archive: " << writer->GetError());
+        return false;
+      }
+      continue;
+    }
+
+    if (!writer->StartEntry(entry->path, entry->flags)) {
+      diag->Error(DiagMessage(entry->path) << "failed to open file");
+      return false;
+    }
+
+    const void* data = nullptr;
+    size_t len = 0;
+    while (in.Next(&data, &len)) {
+      if (!writer->Write(data, static_cast<int>(len))) {
+        diag->Error(DiagMessage(entry->path) << "failed to write data");
+        return false;
+      }
+    }
+
+    if (!writer->FinishEntry()) {
+      diag->Error(DiagMessage(entry->path) << "failed to finish writing data");
+      return false;
+    }
+  }
+  entries_.clear();
+  return true;
+}
+
 std::unique_ptr<IArchiveWriter> CreateDirectoryArchiveWriter(IDiagnostics* diag,
                                                              const StringPiece& path) {
   std::unique_ptr<DirectoryWriter> writer = util::make_unique<DirectoryWriter>();
@@ -35,6 +35,9 @@ namespace aapt {
 struct ArchiveEntry {
   enum : uint32_t {
     kCompress = 0x01,
+
+    // Aligns the data of the entry on 4 bytes. Zip archives always do this for entries that are
+    // not compressed.
     kAlign = 0x02,
   };
 
@@ -70,6 +73,49 @@ class IArchiveWriter : public ::google::protobuf::io::CopyingOutputStream {
   virtual std::string GetError() const = 0;
 };
 
+// An archive that keeps the entries written to it in memory, until they are written to another
+// archive with Flush(). This lets files be produced in parallel and still be written to the final
+// archive in a fixed order.
+class BufferedArchiveWriter : public IArchiveWriter {
+ public:
+  BufferedArchiveWriter() = default;
+
+  bool WriteFile(const android::StringPiece& path, uint32_t flags, io::InputStream* in) override;
+  bool StartEntry(const android::StringPiece& path, uint32_t flags) override;
+  bool FinishEntry() override;
+  bool Write(const void* buffer, int size) override;
+
+  bool HadError() const override {
+    return false;
+  }
+
+  std::string GetError() const override {
+    return {};
+  }
+
+  // Writes the buffered entries to writer, in the order they were written here, the same way
+  // they were written here (WriteFile() or StartEntry()/FinishEntry()). Errors are reported to
+  // diag.
+  bool Flush(IArchiveWriter* writer, IDiagnostics* diag);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BufferedArchiveWriter);
+
+  struct Entry {
+    Entry(const android::StringPiece& entry_path, uint32_t entry_flags)
+        : path(entry_path.to_string()), flags(entry_flags), buffer(4096) {
+    }
+
+    std::string path;
+    uint32_t flags;
+    bool whole_file = false;
+    BigBuffer buffer;
+  };
+
+  std::vector<std::unique_ptr<Entry>> entries_;
+  bool open_ = false;
+};
+
 std::unique_ptr<IArchiveWriter> CreateDirectoryArchiveWriter(IDiagnostics* diag,
                                                              const android::StringPiece& path);
 
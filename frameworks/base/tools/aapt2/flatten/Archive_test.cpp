@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flatten/Archive.h"
+
+#include "android-base/test_utils.h"
+#include "ziparchive/zip_archive.h"
+
+#include "io/BigBufferInputStream.h"
+#include "test/Test.h"
+
+namespace aapt {
+
+static bool WriteEntry(IArchiveWriter* writer, const android::StringPiece& path,
+                       const std::string& data, uint32_t flags) {
+  BigBuffer buffer(data.size());
+  memcpy(buffer.NextBlock<char>(data.size()), data.data(), data.size());
+  io::BigBufferInputStream in(&buffer);
+  return writer->WriteFile(path, flags, &in);
+}
+
+TEST(ArchiveTest, StoredEntriesAreAligned) {
+  TemporaryFile file;
+  std::unique_ptr<IDiagnostics> diag = util::make_unique<StdErrDiagnostics>();
+  {
+    std::unique_ptr<IArchiveWriter> writer =
+        CreateZipFileArchiveWriter(diag.get(), file.path);
+    ASSERT_NE(nullptr, writer);
+
+    // Paths of odd lengths to move the data around.
+    ASSERT_TRUE(WriteEntry(writer.get(), "a", "stored", 0u));
+    ASSERT_TRUE(WriteEntry(writer.get(), "bcd", std::string(1000, 'x'), ArchiveEntry::kCompress));
+    ASSERT_TRUE(WriteEntry(writer.get(), "efghi", "stored", 0u));
+
+    // Too small to be worth compressing, so it ends up stored.
+    ASSERT_TRUE(WriteEntry(writer.get(), "jk", "z", ArchiveEntry::kCompress));
+  }
+
+  ZipArchiveHandle handle;
+  ASSERT_EQ(0, OpenArchive(file.path, &handle));
+  for (const char* path : {"a", "efghi", "jk"}) {
+    ZipEntry entry;
+    ASSERT_EQ(0, FindEntry(handle, ZipString(path), &entry));
+    EXPECT_EQ(kCompressStored, entry.method);
+    EXPECT_EQ(0, entry.offset % 4) << path;
+  }
+
+  ZipEntry entry;
+  ASSERT_EQ(0, FindEntry(handle, ZipString("bcd"), &entry));
+  EXPECT_EQ(kCompressDeflated, entry.method);
+  CloseArchive(handle);
+}
+
+}  // namespace aapt
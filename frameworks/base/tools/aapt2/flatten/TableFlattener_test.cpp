@@ -467,4 +467,37 @@ TEST_F(TableFlattenerTest, LongSharedLibraryPackageNameIsIllegal) {
   ASSERT_FALSE(Flatten(context.get(), {}, table.get(), &result));
 }
 
+TEST_F(TableFlattenerTest, ParseFlattenedTableByPackage) {
+  std::unique_ptr<ResourceTable> table =
+      test::ResourceTableBuilder()
+          .SetPackageId("com.app.test", 0x7f)
+          .AddString("com.app.test:string/foo", ResourceId(0x7f010000), "foo")
+          .AddValue("com.app.test:string/bar", ResourceId(0x7f010001),
+                    util::make_unique<Reference>(ResourceId(0x7f010000)))
+          .Build();
+
+  std::string content;
+  ASSERT_TRUE(Flatten(context_.get(), {}, table.get(), &content));
+
+  ResourceTable out_table;
+  BinaryResourceParser parser(context_.get(), &out_table, {}, content.data(), content.size());
+  int calls = 0;
+  ASSERT_TRUE(parser.ParseByPackage([&](ResourceTable* package_table) -> bool {
+    calls++;
+    EXPECT_THAT(test::GetValue<String>(package_table, "com.app.test:string/foo"), NotNull());
+
+    // References are resolved to names before the package is handed out.
+    Reference* ref = test::GetValue<Reference>(package_table, "com.app.test:string/bar");
+    EXPECT_THAT(ref, NotNull());
+    if (ref && ref->name) {
+      EXPECT_EQ(test::ParseNameOrDie("com.app.test:string/foo"), ref->name.value());
+    } else {
+      ADD_FAILURE() << "reference was not resolved to a name";
+    }
+    return true;
+  }));
+  EXPECT_EQ(1, calls);
+  EXPECT_TRUE(out_table.packages.empty());
+}
+
 }  // namespace aapt
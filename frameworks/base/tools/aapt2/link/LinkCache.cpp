@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "link/LinkCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "android-base/file.h"
+#include "android-base/stringprintf.h"
+
+#include "util/Files.h"
+
+using android::StringPiece;
+
+namespace aapt {
+
+// Identifies the format of cache files. Change it when the format or the content of the flattened
+// files changes, so that stale entries are ignored. Configurations are stored as raw
+// ResTable_config structs, so cache files are only meant to be read by the aapt2 that wrote them.
+constexpr static const char kMagic[] = "aapt2lc1";
+constexpr static const size_t kMagicLen = sizeof(kMagic) - 1;
+
+void ContentHasher::Update(const void* data, size_t len) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < len; i++) {
+    // FNV-1a, and a rotating multiplicative hash with a different constant so that the two halves
+    // don't collide together.
+    h1_ = (h1_ ^ bytes[i]) * 0x100000001b3u;
+    h2_ = ((h2_ << 7) | (h2_ >> 57)) ^ bytes[i];
+    h2_ *= 0x9e3779b97f4a7c15u;
+  }
+}
+
+void ContentHasher::Update(const StringPiece& str) {
+  Update(static_cast<uint32_t>(str.size()));
+  Update(str.data(), str.size());
+}
+
+void ContentHasher::Update(uint32_t value) {
+  Update(&value, sizeof(value));
+}
+
+std::string ContentHasher::Digest() const {
+  return android::base::StringPrintf("%016llx%016llx", static_cast<unsigned long long>(h1_),
+                                     static_cast<unsigned long long>(h2_));
+}
+
+std::string HashResourceTable(ResourceTable* table) {
+  ContentHasher hasher;
+  std::ostringstream value_str;
+  for (auto& package : table->packages) {
+    hasher.Update(package->name);
+    hasher.Update(static_cast<uint32_t>(package->id.value_or_default(0)));
+    for (auto& type : package->types) {
+      hasher.Update(static_cast<uint32_t>(type->type));
+      hasher.Update(static_cast<uint32_t>(type->id.value_or_default(0)));
+      hasher.Update(static_cast<uint32_t>(type->symbol_status.state));
+      for (auto& entry : type->entries) {
+        hasher.Update(entry->name);
+        hasher.Update(static_cast<uint32_t>(entry->id.value_or_default(0xffffu)));
+        hasher.Update(static_cast<uint32_t>(entry->symbol_status.state));
+        for (auto& config_value : entry->values) {
+          value_str.str(std::string());
+          value_str << config_value->config << " " << config_value->product << " ";
+          if (config_value->value) {
+            config_value->value->Print(&value_str);
+          }
+          hasher.Update(value_str.str());
+        }
+      }
+    }
+  }
+  return hasher.Digest();
+}
+
+LinkCache::LinkCache(const StringPiece& dir) : dir_(dir.to_string()) {
+}
+
+static bool ReadString(const std::string& content, size_t* offset, std::string* out_str) {
+  uint32_t len;
+  if (content.size() - *offset < sizeof(len)) {
+    return false;
+  }
+  memcpy(&len, content.data() + *offset, sizeof(len));
+  *offset += sizeof(len);
+
+  if (content.size() - *offset < len) {
+    return false;
+  }
+  out_str->assign(content, *offset, len);
+  *offset += len;
+  return true;
+}
+
+static void WriteString(const StringPiece& str, std::ostream* out) {
+  const uint32_t len = static_cast<uint32_t>(str.size());
+  out->write(reinterpret_cast<const char*>(&len), sizeof(len));
+  out->write(str.data(), str.size());
+}
+
+bool LinkCache::Load(const std::string& key, std::vector<File>* out_files) const {
+  std::string path = dir_;
+  file::AppendPath(&path, key);
+
+  std::string content;
+  if (!android::base::ReadFileToString(path, &content)) {
+    return false;
+  }
+
+  if (content.compare(0, kMagicLen, kMagic) != 0) {
+    return false;
+  }
+
+  out_files->clear();
+  size_t offset = kMagicLen;
+  while (offset < content.size()) {
+    File file;
+    std::string config_str;
+    if (!ReadString(content, &offset, &file.path) || !ReadString(content, &offset, &config_str) ||
+        !ReadString(content, &offset, &file.data) || config_str.size() != sizeof(file.config)) {
+      return false;
+    }
+    memcpy(&file.config, config_str.data(), sizeof(file.config));
+    out_files->push_back(std::move(file));
+  }
+  return !out_files->empty();
+}
+
+bool LinkCache::Store(const std::string& key, const std::vector<File>& files) const {
+  std::string path = dir_;
+  file::AppendPath(&path, key);
+  const std::string tmp_path = path + ".tmp";
+
+  {
+    std::ofstream fout(tmp_path, std::ofstream::binary);
+    if (!fout) {
+      return false;
+    }
+
+    fout.write(kMagic, kMagicLen);
+    for (const File& file : files) {
+      WriteString(file.path, &fout);
+      WriteString(StringPiece(reinterpret_cast<const char*>(&file.config), sizeof(file.config)),
+                  &fout);
+      WriteString(file.data, &fout);
+    }
+
+    if (!fout) {
+      fout.close();
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+
+  // Readers see either no entry or a complete one.
+  std::remove(path.c_str());
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace aapt
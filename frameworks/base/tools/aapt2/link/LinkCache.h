@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAPT_LINKER_LINKCACHE_H
+#define AAPT_LINKER_LINKCACHE_H
+
+#include <string>
+#include <vector>
+
+#include "android-base/macros.h"
+#include "androidfw/StringPiece.h"
+
+#include "ConfigDescription.h"
+#include "ResourceTable.h"
+
+namespace aapt {
+
+// Incrementally computes a 128 bit hash of some content, to use as a cache key. This is not a
+// cryptographic hash: it only needs to tell apart the inputs of consecutive builds.
+class ContentHasher {
+ public:
+  ContentHasher() = default;
+
+  void Update(const void* data, size_t len);
+
+  // Hashes the length of str before its content, so that consecutive strings can't be confused.
+  void Update(const android::StringPiece& str);
+
+  void Update(uint32_t value);
+
+  // Returns the hash as 32 hexadecimal characters.
+  std::string Digest() const;
+
+ private:
+  uint64_t h1_ = 0xcbf29ce484222325u;
+  uint64_t h2_ = 0x84222325cbf29ce4u;
+};
+
+// Returns a hash of everything in the table that linking an XML file can depend on: the names,
+// IDs and visibility of the resources, and their values.
+std::string HashResourceTable(ResourceTable* table);
+
+// An on-disk cache of the files produced when linking and flattening a compiled XML file, keyed by
+// a hash of all the inputs of that process. Entries are never invalidated: a changed input yields a
+// different key.
+class LinkCache {
+ public:
+  // A flattened file, written at path for the given configuration. Auto-versioning produces more
+  // than one file for a single input.
+  struct File {
+    std::string path;
+    ConfigDescription config;
+    std::string data;
+  };
+
+  explicit LinkCache(const android::StringPiece& dir);
+
+  // Reads the files stored under key. Returns false if there are none or they can't be read.
+  bool Load(const std::string& key, std::vector<File>* out_files) const;
+
+  // Stores files under key, replacing any previous entry. This can be called from several threads
+  // as long as the keys differ.
+  bool Store(const std::string& key, const std::vector<File>& files) const;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(LinkCache);
+
+  std::string dir_;
+};
+
+}  // namespace aapt
+
+#endif /* AAPT_LINKER_LINKCACHE_H */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "link/LinkCache.h"
+
+#include "android-base/test_utils.h"
+
+#include "test/Test.h"
+
+using ::testing::Eq;
+using ::testing::Ne;
+using ::testing::SizeIs;
+
+namespace aapt {
+
+static std::string Hash(std::initializer_list<android::StringPiece> parts) {
+  ContentHasher hasher;
+  for (const android::StringPiece& part : parts) {
+    hasher.Update(part);
+  }
+  return hasher.Digest();
+}
+
+TEST(LinkCacheTest, HashDependsOnContentAndBoundaries) {
+  EXPECT_THAT(Hash({"foo", "bar"}), Eq(Hash({"foo", "bar"})));
+  EXPECT_THAT(Hash({"foo", "bar"}), Ne(Hash({"foo", "baz"})));
+  EXPECT_THAT(Hash({"foo", "bar"}), Ne(Hash({"foob", "ar"})));
+  EXPECT_THAT(Hash({"foo"}), SizeIs(32u));
+}
+
+TEST(LinkCacheTest, TableHashChangesWithIds) {
+  std::unique_ptr<ResourceTable> table_a = test::ResourceTableBuilder()
+                                               .SetPackageId("android", 0x01)
+                                               .AddSimple("android:id/foo", ResourceId(0x01020000))
+                                               .Build();
+  std::unique_ptr<ResourceTable> table_b = test::ResourceTableBuilder()
+                                               .SetPackageId("android", 0x01)
+                                               .AddSimple("android:id/foo", ResourceId(0x01020000))
+                                               .Build();
+  std::unique_ptr<ResourceTable> table_c = test::ResourceTableBuilder()
+                                               .SetPackageId("android", 0x01)
+                                               .AddSimple("android:id/foo", ResourceId(0x01020001))
+                                               .Build();
+
+  EXPECT_THAT(HashResourceTable(table_a.get()), Eq(HashResourceTable(table_b.get())));
+  EXPECT_THAT(HashResourceTable(table_a.get()), Ne(HashResourceTable(table_c.get())));
+}
+
+TEST(LinkCacheTest, StoreAndLoadFiles) {
+  TemporaryDir dir;
+  LinkCache cache(dir.path);
+
+  std::vector<LinkCache::File> files;
+  EXPECT_FALSE(cache.Load("key", &files));
+
+  files.push_back(LinkCache::File{"res/layout/foo.xml", {}, std::string("\0\1\2", 3)});
+  files.push_back(
+      LinkCache::File{"res/layout-v21/foo.xml", test::ParseConfigOrDie("v21"), "flattened"});
+  ASSERT_TRUE(cache.Store("key", files));
+
+  std::vector<LinkCache::File> loaded_files;
+  ASSERT_TRUE(cache.Load("key", &loaded_files));
+  ASSERT_THAT(loaded_files, SizeIs(2u));
+  EXPECT_THAT(loaded_files[0].path, Eq("res/layout/foo.xml"));
+  EXPECT_THAT(loaded_files[0].config, Eq(ConfigDescription::DefaultConfig()));
+  EXPECT_THAT(loaded_files[0].data, Eq(std::string("\0\1\2", 3)));
+  EXPECT_THAT(loaded_files[1].path, Eq("res/layout-v21/foo.xml"));
+  EXPECT_THAT(loaded_files[1].config, Eq(test::ParseConfigOrDie("v21")));
+  EXPECT_THAT(loaded_files[1].data, Eq("flattened"));
+
+  EXPECT_FALSE(cache.Load("other_key", &loaded_files));
+}
+
+}  // namespace aapt
@@ -17,6 +17,8 @@
 #ifndef AAPT_FLATTEN_TABLEPROTOSERIALIZER_H
 #define AAPT_FLATTEN_TABLEPROTOSERIALIZER_H
 
+#include <functional>
+
 #include "android-base/macros.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
@@ -67,6 +69,13 @@ std::unique_ptr<pb::ResourceTable> SerializeTableToPb(ResourceTable* table);
 std::unique_ptr<ResourceTable> DeserializeTableFromPb(
     const pb::ResourceTable& pbTable, const Source& source, IDiagnostics* diag);
 
+// Deserializes the table one package at a time, invoking `callback` with a table that holds only
+// the package just read. The package is dropped once `callback` returns, so memory use is bounded
+// by the largest package. Stops and returns false if `callback` returns false.
+bool DeserializeTableFromPbByPackage(const pb::ResourceTable& pbTable, const Source& source,
+                                     IDiagnostics* diag,
+                                     const std::function<bool(ResourceTable*)>& callback);
+
 std::unique_ptr<pb::CompiledFile> SerializeCompiledFileToPb(
     const ResourceFile& file);
 std::unique_ptr<ResourceFile> DeserializeCompiledFileFromPb(
@@ -387,19 +387,19 @@ class PackagePbDeserializer {
 
 }  // namespace
 
-std::unique_ptr<ResourceTable> DeserializeTableFromPb(
-    const pb::ResourceTable& pb_table, const Source& source,
-    IDiagnostics* diag) {
+// Deserializes the packages of pb_table into table. If package_callback is set, it is invoked after
+// each package, which is then removed from the table.
+static bool DeserializePackagesFromPb(
+    const pb::ResourceTable& pb_table, const Source& source, IDiagnostics* diag,
+    ResourceTable* table, const std::function<bool(ResourceTable*)>* package_callback) {
   // We import the android namespace because on Windows NO_ERROR is a macro, not
   // an enum, which
   // causes errors when qualifying it with android::
   using namespace android;
 
-  std::unique_ptr<ResourceTable> table = util::make_unique<ResourceTable>();
-
   if (!pb_table.has_string_pool()) {
     diag->Error(DiagMessage(source) << "no string pool found");
-    return {};
+    return false;
   }
 
   ResStringPool value_pool;
@@ -407,7 +407,7 @@ std::unique_ptr<ResourceTable> DeserializeTableFromPb(
                                      pb_table.string_pool().data().size());
   if (result != NO_ERROR) {
     diag->Error(DiagMessage(source) << "invalid string pool");
-    return {};
+    return false;
   }
 
   ResStringPool source_pool;
@@ -416,7 +416,7 @@ std::unique_ptr<ResourceTable> DeserializeTableFromPb(
                                pb_table.source_pool().data().size());
     if (result != NO_ERROR) {
       diag->Error(DiagMessage(source) << "invalid source pool");
-      return {};
+      return false;
     }
   }
 
@@ -426,20 +426,46 @@ std::unique_ptr<ResourceTable> DeserializeTableFromPb(
                                pb_table.symbol_pool().data().size());
     if (result != NO_ERROR) {
       diag->Error(DiagMessage(source) << "invalid symbol pool");
-      return {};
+      return false;
     }
   }
 
   PackagePbDeserializer package_pb_deserializer(&value_pool, &source_pool,
                                                 &symbol_pool, source, diag);
   for (const pb::Package& pb_package : pb_table.packages()) {
-    if (!package_pb_deserializer.DeserializeFromPb(pb_package, table.get())) {
-      return {};
+    if (!package_pb_deserializer.DeserializeFromPb(pb_package, table)) {
+      return false;
     }
+
+    if (package_callback) {
+      if (!(*package_callback)(table)) {
+        return false;
+      }
+      table->packages.clear();
+      table->string_pool.Prune();
+    }
+  }
+  return true;
+}
+
+std::unique_ptr<ResourceTable> DeserializeTableFromPb(
+    const pb::ResourceTable& pb_table, const Source& source,
+    IDiagnostics* diag) {
+  std::unique_ptr<ResourceTable> table = util::make_unique<ResourceTable>();
+  if (!DeserializePackagesFromPb(pb_table, source, diag, table.get(), nullptr)) {
+    return {};
   }
   return table;
 }
 
+bool DeserializeTableFromPbByPackage(const pb::ResourceTable& pb_table, const Source& source,
+                                     IDiagnostics* diag,
+                                     const std::function<bool(ResourceTable*)>& callback) {
+  ResourceTable table;
+  return DeserializePackagesFromPb(pb_table, source, diag, &table, &callback);
+}
+
+
 std::unique_ptr<ResourceFile> DeserializeCompiledFileFromPb(
     const pb::CompiledFile& pb_file, const Source& source, IDiagnostics* diag) {
   std::unique_ptr<ResourceFile> file = util::make_unique<ResourceFile>();
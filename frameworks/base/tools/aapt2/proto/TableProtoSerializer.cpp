@@ -209,16 +209,7 @@ class PbSerializerVisitor : public RawValueVisitor {
 std::unique_ptr<pb::ResourceTable> SerializeTableToPb(ResourceTable* table) {
   // We must do this before writing the resources, since the string pool IDs may
   // change.
-  table->string_pool.Sort(
-      [](const StringPool::Entry& a, const StringPool::Entry& b) -> bool {
-        int diff = a.context.priority - b.context.priority;
-        if (diff < 0) return true;
-        if (diff > 0) return false;
-        diff = a.context.config.compare(b.context.config);
-        if (diff < 0) return true;
-        if (diff > 0) return false;
-        return a.value < b.value;
-      });
+  table->string_pool.Sort();
   table->string_pool.Prune();
 
   auto pb_table = util::make_unique<pb::ResourceTable>();
@@ -20,7 +20,9 @@
 #include "test/Test.h"
 
 using ::google::protobuf::io::StringOutputStream;
+using ::testing::Eq;
 using ::testing::NotNull;
+using ::testing::SizeIs;
 
 namespace aapt {
 
@@ -220,4 +222,39 @@ TEST(TableProtoSerializer, DeserializeCorruptHeaderSafely) {
   EXPECT_FALSE(in_file_stream.ReadDataMetaData(&offset, &len));
 }
 
+TEST(TableProtoSerializer, DeserializeOnePackageAtATime) {
+  std::unique_ptr<IAaptContext> context = test::ContextBuilder().Build();
+  std::unique_ptr<ResourceTable> table =
+      test::ResourceTableBuilder()
+          .SetPackageId("com.app.a", 0x7f)
+          .SetPackageId("com.app.b", 0x80)
+          .AddString("com.app.a:string/text", ResourceId(0x7f010000), "a")
+          .AddString("com.app.b:string/text", ResourceId(0x80010000), "b")
+          .Build();
+
+  std::unique_ptr<pb::ResourceTable> pb_table = SerializeTableToPb(table.get());
+  ASSERT_THAT(pb_table, NotNull());
+
+  std::vector<std::string> package_names;
+  ASSERT_TRUE(DeserializeTableFromPbByPackage(
+      *pb_table, Source{"test"}, context->GetDiagnostics(), [&](ResourceTable* package_table) {
+        EXPECT_THAT(package_table->packages, SizeIs(1u));
+        const std::string& name = package_table->packages.front()->name;
+        String* str = test::GetValue<String>(package_table, name + ":string/text");
+        EXPECT_THAT(str, NotNull());
+        package_names.push_back(name);
+        return true;
+      }));
+  EXPECT_THAT(package_names, Eq(std::vector<std::string>{"com.app.a", "com.app.b"}));
+
+  int calls = 0;
+  EXPECT_FALSE(DeserializeTableFromPbByPackage(*pb_table, Source{"test"},
+                                               context->GetDiagnostics(),
+                                               [&](ResourceTable*) -> bool {
+                                                 calls++;
+                                                 return false;
+                                               }));
+  EXPECT_THAT(calls, Eq(1));
+}
+
 }  // namespace aapt
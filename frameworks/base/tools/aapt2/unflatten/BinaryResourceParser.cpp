@@ -121,6 +121,14 @@ bool BinaryResourceParser::Parse() {
   return true;
 }
 
+bool BinaryResourceParser::ParseByPackage(
+    const std::function<bool(ResourceTable*)>& callback) {
+  package_callback_ = &callback;
+  const bool result = Parse();
+  package_callback_ = nullptr;
+  return result;
+}
+
 /**
  * Parses the resource table, which contains all the packages, types, and
  * entries.
@@ -287,6 +295,16 @@ bool BinaryResourceParser::ParsePackage(const ResChunk_header* chunk) {
   // symbolic references.
   ReferenceIdToNameVisitor visitor(&id_index_);
   VisitAllValuesInTable(table_, &visitor);
+
+  if (package_callback_) {
+    if (!(*package_callback_)(table_)) {
+      return false;
+    }
+
+    // The ID index is kept, since later packages may reference this one.
+    table_->packages.clear();
+    table_->string_pool.Prune();
+  }
   return true;
 }
 
@@ -17,6 +17,7 @@
 #ifndef AAPT_BINARY_RESOURCE_PARSER_H
 #define AAPT_BINARY_RESOURCE_PARSER_H
 
+#include <functional>
 #include <string>
 
 #include "android-base/macros.h"
@@ -53,6 +54,15 @@ class BinaryResourceParser {
    */
   bool Parse();
 
+  /*
+   * Parses the binary resource table one package at a time. Once a package is
+   * parsed, `callback` is invoked with the table holding only that package,
+   * which is then removed from the table so that memory use is bounded by the
+   * largest package rather than the whole table. Parsing stops if `callback`
+   * returns false.
+   */
+  bool ParseByPackage(const std::function<bool(ResourceTable*)>& callback);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(BinaryResourceParser);
 
@@ -119,6 +129,9 @@ class BinaryResourceParser {
   // A mapping of resource ID to resource name. When we finish parsing
   // we use this to convert all resource IDs to symbolic references.
   std::map<ResourceId, ResourceName> id_index_;
+
+  // Set while in ParseByPackage().
+  const std::function<bool(ResourceTable*)>* package_callback_ = nullptr;
 };
 
 }  // namespace aapt
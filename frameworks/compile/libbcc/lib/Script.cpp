@@ -78,7 +78,14 @@ bool Script::LinkRuntime(const char *core_lib) {
       libclcore_module.getNamedMetadata(bcinfo::MetadataExtractor::kWrapperMetadataName);
   bccAssert(wrapperMDNode != nullptr);
   libclcore_module.eraseNamedMetadata(wrapperMDNode);
-  if (!mSource->merge(*libclcore_source)) {
+
+  // The runtime library is loaded lazily, so only link in what the script
+  // uses. Linking all of it would read and materialize every function body
+  // in the library, only for the internalize and global DCE passes to drop
+  // the unused ones again before code generation. The passes that run after
+  // linking only add calls to functions provided by the driver, which are
+  // resolved when the shared object is loaded.
+  if (!mSource->merge(*libclcore_source, /* pOnlyNeeded */ true)) {
     ALOGE("Failed to link Renderscript library '%s'!", core_lib);
     delete libclcore_source;
     return false;
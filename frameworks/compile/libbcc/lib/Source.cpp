@@ -208,9 +208,12 @@ Source::~Source() {
   delete mMetadata;
 }
 
-bool Source::merge(Source &pSource) {
+bool Source::merge(Source &pSource, bool pOnlyNeeded) {
+  unsigned flags = pOnlyNeeded ? llvm::Linker::Flags::LinkOnlyNeeded
+                               : llvm::Linker::Flags::None;
   // TODO(srhines): Add back logging of actual diagnostics from linking.
-  if (llvm::Linker::linkModules(*mModule, std::unique_ptr<llvm::Module>(&pSource.getModule())) != 0) {
+  if (llvm::Linker::linkModules(*mModule, std::unique_ptr<llvm::Module>(&pSource.getModule()),
+                                flags) != 0) {
     ALOGE("Failed to link source `%s' with `%s'!",
           getIdentifier().c_str(), pSource.getIdentifier().c_str());
     return false;
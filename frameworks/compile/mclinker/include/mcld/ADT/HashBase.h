@@ -106,6 +106,10 @@ class HashTableImpl {
   /// mayRehash - check the load_factor, compute the new size, and then doRehash
   void mayRehash();
 
+  /// reserve - make room for pNumOfEntries entries, so that inserting up to
+  /// that many entries doesn't rehash
+  void reserve(unsigned int pNumOfEntries);
+
   /// doRehash - re-new the hash table, and rehash all elements into the new
   /// buckets
   void doRehash(unsigned int pNewSize);
@@ -26,7 +26,9 @@ inline static unsigned int compute_bucket_count(unsigned int pNumOfBuckets) {
     ++idx;
   } while (idx < buckets_count);
 
-  return (pNumOfBuckets + 131101);  // rare case. increase constantly
+  // rare case. Grow geometrically so that inserting n entries rehashes
+  // O(log n) times.
+  return (pNumOfBuckets * 2 + 1);
 }
 
 //===----------------------------------------------------------------------===//
@@ -201,6 +203,21 @@ void HashTableImpl<HashEntryTy, HashFunctionTy>::mayRehash() {
   doRehash(new_size);
 }
 
+template <typename HashEntryTy, typename HashFunctionTy>
+void HashTableImpl<HashEntryTy, HashFunctionTy>::reserve(
+    unsigned int pNumOfEntries) {
+  // Keep the load factor under the 3/4 that mayRehash() allows.
+  unsigned int min_size = pNumOfEntries + pNumOfEntries / 3 + 1;
+  if (min_size <= m_NumOfBuckets)
+    return;
+
+  if (m_NumOfBuckets == 0) {
+    init(min_size);
+    return;
+  }
+  doRehash(compute_bucket_count(min_size));
+}
+
 template <typename HashEntryTy, typename HashFunctionTy>
 void HashTableImpl<HashEntryTy, HashFunctionTy>::doRehash(
     unsigned int pNewSize) {
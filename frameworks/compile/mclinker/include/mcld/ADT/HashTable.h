@@ -95,6 +95,10 @@ class HashTable : public HashTableImpl<HashEntryTy, HashFunctionTy> {
   //  rehash all elements.
   void rehash(size_type pCount);
 
+  /// reserve - grow the hash table once so that it can hold pCount elements
+  //  without rehashing.
+  void reserve(size_type pCount);
+
   // -----  iterators  ----- //
   iterator begin();
   iterator end();
@@ -176,6 +176,15 @@ void HashTable<HashEntryTy, HashFunctionTy, EntryFactoryTy>::rehash(
   BaseTy::doRehash(pCount);
 }
 
+template <typename HashEntryTy,
+          typename HashFunctionTy,
+          typename EntryFactoryTy>
+void HashTable<HashEntryTy, HashFunctionTy, EntryFactoryTy>::reserve(
+    typename HashTable<HashEntryTy, HashFunctionTy, EntryFactoryTy>::size_type
+        pCount) {
+  BaseTy::reserve(pCount);
+}
+
 template <typename HashEntryTy,
           typename HashFunctionTy,
           typename EntryFactoryTy>
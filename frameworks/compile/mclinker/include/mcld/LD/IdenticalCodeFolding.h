@@ -10,6 +10,7 @@
 #define MCLD_LD_IDENTICALCODEFOLDING_H_
 
 #include <llvm/ADT/MapVector.h>
+#include <llvm/Support/DataTypes.h>
 
 #include <string>
 #include <vector>
@@ -36,21 +37,28 @@ class IdenticalCodeFolding {
  private:
   class FoldingCandidate {
    public:
-    FoldingCandidate() : sect(NULL), reloc_sect(NULL), obj(NULL) {}
+    FoldingCandidate()
+        : sect(NULL), reloc_sect(NULL), obj(NULL), content_hash(0) {}
     FoldingCandidate(LDSection* pCode, LDSection* pReloc, Input* pInput)
-        : sect(pCode), reloc_sect(pReloc), obj(pInput) {}
+        : sect(pCode), reloc_sect(pReloc), obj(pInput), content_hash(0) {}
 
+    /// initConstantContent - compute the content and its hash. Only reads
+    /// the module, so candidates can be initialized concurrently.
     void initConstantContent(
         const TargetLDBackend& pBackend,
         const IdenticalCodeFolding::KeptSections& pKeptSections);
-    std::string getContentWithVariables(
-        const TargetLDBackend& pBackend,
-        const IdenticalCodeFolding::KeptSections& pKeptSections);
+
+    /// getVariables - get the indices of the sections currently kept for the
+    /// targets of the variable relocations.
+    void getVariables(
+        const IdenticalCodeFolding::KeptSections& pKeptSections,
+        std::vector<size_t>& pVariables) const;
 
     LDSection* sect;
     LDSection* reloc_sect;
     Input* obj;
     std::string content;
+    uint32_t content_hash;
     std::vector<Relocation*> variable_relocs;
   };
 
@@ -66,6 +74,8 @@ class IdenticalCodeFolding {
  private:
   void findCandidates(FoldingCandidates& pCandidateList);
 
+  void initCandidates(FoldingCandidates& pCandidateList);
+
   bool matchCandidates(FoldingCandidates& pCandidateList);
 
  private:
@@ -114,6 +114,8 @@ class NamePool {
   const_freeinfo_iterator freeinfo_end() const { return m_FreeInfoSet.end(); }
 
   // -----  capacity  ----- //
+  /// reserve - make room for pN symbols in total, so that inserting a whole
+  /// symbol table grows the pool at most once.
   void reserve(size_type pN);
 
   size_type capacity() const;
@@ -21,6 +21,7 @@ class ExecWriter;
 class FileOutputBuffer;
 class GroupReader;
 class IRBuilder;
+class Input;
 class LinkerConfig;
 class Module;
 class ObjectReader;
@@ -150,6 +151,11 @@ class ObjectLinker {
   /// objects or executables
   void normalSyncRelocationResult(FileOutputBuffer& pOutput);
 
+  /// syncInputRelocationResult - sync the relocation results of one input.
+  /// Inputs are merged into disjoint parts of the output, so different inputs
+  /// can be synced concurrently.
+  void syncInputRelocationResult(Input& pInput, uint8_t* pOutput);
+
   /// partialSyncRelocationResult - sync relocation result when doing partial
   /// link
   void partialSyncRelocationResult(FileOutputBuffer& pOutput);
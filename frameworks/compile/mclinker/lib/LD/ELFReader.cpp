@@ -9,6 +9,7 @@
 #include "mcld/LD/ELFReader.h"
 
 #include "mcld/IRBuilder.h"
+#include "mcld/Module.h"
 #include "mcld/Fragment/FillFragment.h"
 #include "mcld/LD/EhFrame.h"
 #include "mcld/LD/LDContext.h"
@@ -81,6 +82,16 @@ bool ELFReader<32, true>::readSymbols(Input& pInput,
   // skip the first NULL symbol
   pInput.context()->addSymbol(LDSymbol::Null());
 
+  // Global symbols are resolved through the name pool. Grow it once for
+  // all of them rather than while inserting them one by one.
+  size_t num_globals = 0;
+  for (size_t idx = 1; idx < entsize; ++idx) {
+    if ((symtab[idx].st_info >> 4) != llvm::ELF::STB_LOCAL)
+      ++num_globals;
+  }
+  NamePool& name_pool = pBuilder.getModule().getNamePool();
+  name_pool.reserve(name_pool.size() + num_globals);
+
   /// recording symbols added from DynObj to analyze weak alias
   std::vector<AliasInfo> potential_aliases;
   bool is_dyn_obj = (pInput.type() == Input::DynObj);
@@ -581,6 +592,16 @@ bool ELFReader<64, true>::readSymbols(Input& pInput,
   // skip the first NULL symbol
   pInput.context()->addSymbol(LDSymbol::Null());
 
+  // Global symbols are resolved through the name pool. Grow it once for
+  // all of them rather than while inserting them one by one.
+  size_t num_globals = 0;
+  for (size_t idx = 1; idx < entsize; ++idx) {
+    if ((symtab[idx].st_info >> 4) != llvm::ELF::STB_LOCAL)
+      ++num_globals;
+  }
+  NamePool& name_pool = pBuilder.getModule().getNamePool();
+  name_pool.reserve(name_pool.size() + num_globals);
+
   /// recording symbols added from DynObj to analyze weak alias
   std::vector<AliasInfo> potential_aliases;
   bool is_dyn_obj = (pInput.type() == Input::DynObj);
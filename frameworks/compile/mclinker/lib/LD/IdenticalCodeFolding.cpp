@@ -27,9 +27,12 @@
 #include <llvm/Support/Casting.h>
 #include <llvm/Support/Format.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <map>
 #include <set>
+#include <thread>
 
 #include <zlib.h>
 
@@ -57,9 +60,7 @@ void IdenticalCodeFolding::foldIdenticalCode() {
   findCandidates(candidate_list);
 
   // 2. Initialize constant section content
-  for (size_t i = 0; i < candidate_list.size(); ++i) {
-    candidate_list[i].initConstantContent(m_Backend, m_KeptSections);
-  }
+  initCandidates(candidate_list);
 
   // 3. Find identical code until convergence
   bool converged = false;
@@ -177,34 +178,67 @@ void IdenticalCodeFolding::findCandidates(FoldingCandidates& pCandidateList) {
   }  // for each obj
 }
 
+void IdenticalCodeFolding::initCandidates(FoldingCandidates& pCandidateList) {
+  // Reading the sections and formatting their relocations dominates ICF, and
+  // each candidate only reads the module, so spread large inputs over
+  // threads.
+  static const size_t kMinCandidatesPerThread = 256;
+  size_t num_threads =
+      std::min<size_t>(std::thread::hardware_concurrency(),
+                       pCandidateList.size() / kMinCandidatesPerThread);
+  if (num_threads <= 1) {
+    for (size_t i = 0; i < pCandidateList.size(); ++i)
+      pCandidateList[i].initConstantContent(m_Backend, m_KeptSections);
+    return;
+  }
+
+  std::atomic<size_t> next(0);
+  auto worker = [this, &pCandidateList, &next]() {
+    for (size_t i = next++; i < pCandidateList.size(); i = next++)
+      pCandidateList[i].initConstantContent(m_Backend, m_KeptSections);
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
 bool IdenticalCodeFolding::matchCandidates(FoldingCandidates& pCandidateList) {
   typedef std::multimap<uint32_t, size_t> ChecksumMap;
   ChecksumMap checksum_map;
-  std::vector<std::string> contents(pCandidateList.size());
+  std::vector<std::vector<size_t> > variables(pCandidateList.size());
   bool converged = true;
 
   for (size_t index = 0; index < pCandidateList.size(); ++index) {
-    contents[index] = pCandidateList[index].getContentWithVariables(
-        m_Backend, m_KeptSections);
-    uint32_t checksum = ::crc32(0xFFFFFFFF,
-                                (const uint8_t*)contents[index].c_str(),
-                                contents[index].length());
+    // The constant content was hashed once; only hash the kept indices of
+    // the variable relocations, which change as sections are folded.
+    const FoldingCandidate& candidate = pCandidateList[index];
+    candidate.getVariables(m_KeptSections, variables[index]);
+    uint32_t checksum =
+        ::crc32(candidate.content_hash,
+                reinterpret_cast<const uint8_t*>(variables[index].data()),
+                variables[index].size() * sizeof(size_t));
 
-    size_t count = checksum_map.count(checksum);
-    if (count == 0) {
-      checksum_map.insert(std::make_pair(checksum, index));
-    } else {
-      std::pair<ChecksumMap::iterator, ChecksumMap::iterator> ret =
-          checksum_map.equal_range(checksum);
-      for (ChecksumMap::iterator it = ret.first; it != ret.second; ++it) {
-        size_t kept_index = (*it).second;
-        if (contents[index].compare(contents[kept_index]) == 0) {
-          m_KeptSections[pCandidateList[index].sect].second = kept_index;
+    bool matched = false;
+    std::pair<ChecksumMap::iterator, ChecksumMap::iterator> ret =
+        checksum_map.equal_range(checksum);
+    for (ChecksumMap::iterator it = ret.first; it != ret.second; ++it) {
+      size_t kept_index = (*it).second;
+      if (variables[index] == variables[kept_index] &&
+          candidate.content == pCandidateList[kept_index].content) {
+        size_t& kept = m_KeptSections[candidate.sect].second;
+        if (kept != kept_index) {
+          kept = kept_index;
           converged = false;
-          break;
         }
+        matched = true;
+        break;
       }
     }
+    if (!matched)
+      checksum_map.insert(std::make_pair(checksum, index));
   }
 
   return converged;
@@ -273,26 +307,24 @@ void IdenticalCodeFolding::FoldingCandidate::initConstantContent(
       }
     }
   }
+
+  content_hash = ::crc32(0xFFFFFFFF,
+                         reinterpret_cast<const uint8_t*>(content.data()),
+                         content.length());
 }
 
-std::string IdenticalCodeFolding::FoldingCandidate::getContentWithVariables(
-    const TargetLDBackend& pBackend,
-    const IdenticalCodeFolding::KeptSections& pKeptSections) {
-  std::string result(content);
-  // Compute the variable content from relocs.
+void IdenticalCodeFolding::FoldingCandidate::getVariables(
+    const IdenticalCodeFolding::KeptSections& pKeptSections,
+    std::vector<size_t>& pVariables) const {
+  pVariables.clear();
   std::vector<Relocation*>::const_iterator rel, relEnd = variable_relocs.end();
   for (rel = variable_relocs.begin(); rel != relEnd; ++rel) {
     LDSymbol* sym = (*rel)->symInfo()->outSymbol();
     LDSection* def = &sym->fragRef()->frag()->getParent()->getSection();
     // Use the kept section index.
     KeptSections::const_iterator it = pKeptSections.find(def);
-    llvm::format_object<size_t> kept_info("%x", (*it).second.second);
-    char kept_str[8];
-    kept_info.print(kept_str, sizeof(kept_str));
-    result.append(kept_str);
+    pVariables.push_back((*it).second.second);
   }
-
-  return result;
 }
 
 }  // namespace mcld
@@ -119,7 +119,7 @@ llvm::StringRef NamePool::insertString(const llvm::StringRef& pString) {
 }
 
 void NamePool::reserve(NamePool::size_type pSize) {
-  m_Table.rehash(pSize);
+  m_Table.reserve(pSize);
 }
 
 NamePool::size_type NamePool::capacity() const {
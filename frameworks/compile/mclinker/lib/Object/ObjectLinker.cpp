@@ -45,7 +45,11 @@
 #include <llvm/Support/Casting.h>
 #include <llvm/Support/Host.h>
 
+#include <algorithm>
+#include <atomic>
 #include <system_error>
+#include <thread>
+#include <vector>
 
 namespace mcld {
 
@@ -869,40 +873,40 @@ void ObjectLinker::normalSyncRelocationResult(FileOutputBuffer& pOutput) {
   uint8_t* data = pOutput.getBufferStart();
 
   // sync all relocations of all inputs
+  std::vector<Input*> inputs;
+  size_t num_relocs = 0;
   Module::obj_iterator input, inEnd = m_pModule->obj_end();
   for (input = m_pModule->obj_begin(); input != inEnd; ++input) {
     LDContext::sect_iterator rs, rsEnd = (*input)->context()->relocSectEnd();
     for (rs = (*input)->context()->relocSectBegin(); rs != rsEnd; ++rs) {
-      // bypass the reloc section if
-      // 1. its section kind is changed to Ignore. (The target section is a
-      // discarded group section.)
-      // 2. it has no reloc data. (All symbols in the input relocs are in the
-      // discarded group sections)
-      if (LDFileFormat::Ignore == (*rs)->kind() || !(*rs)->hasRelocData())
-        continue;
-      RelocData::iterator reloc, rEnd = (*rs)->getRelocData()->end();
-      for (reloc = (*rs)->getRelocData()->begin(); reloc != rEnd; ++reloc) {
-        Relocation* relocation = llvm::cast<Relocation>(reloc);
-
-        // bypass the reloc if the symbol is in the discarded input section
-        ResolveInfo* info = relocation->symInfo();
-        if (!info->outSymbol()->hasFragRef() &&
-            ResolveInfo::Section == info->type() &&
-            ResolveInfo::Undefined == info->desc())
-          continue;
+      if (LDFileFormat::Ignore != (*rs)->kind() && (*rs)->hasRelocData())
+        num_relocs += (*rs)->getRelocData()->size();
+    }
+    inputs.push_back(*input);
+  }
 
-        // bypass the relocation with NONE type. This is to avoid overwrite the
-        // target result by NONE type relocation if there is a place which has
-        // two relocations to apply to, and one of it is NONE type. The result
-        // we want is the value of the other relocation result. For example,
-        // in .exidx, there are usually an R_ARM_NONE and R_ARM_PREL31 apply to
-        // the same place
-        if (relocation->type() == 0x0)
-          continue;
-        writeRelocationResult(*relocation, data);
-      }  // for all relocations
-    }    // for all relocation section
-  }      // for all inputs
+  // Writing the results is only a few loads and a store per relocation, so
+  // threads are not worth starting for small links.
+  static const size_t kMinRelocsPerThread = 4096;
+  size_t num_threads = std::min<size_t>(std::thread::hardware_concurrency(),
+                                        num_relocs / kMinRelocsPerThread);
+  num_threads = std::min(num_threads, inputs.size());
+  if (num_threads <= 1) {
+    for (Input* in : inputs)
+      syncInputRelocationResult(*in, data);
+  } else {
+    std::atomic<size_t> next(0);
+    auto worker = [this, &inputs, &next, data]() {
+      for (size_t i = next++; i < inputs.size(); i = next++)
+        syncInputRelocationResult(*inputs[i], data);
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i)
+      threads.emplace_back(worker);
+    worker();
+    for (std::thread& thread : threads)
+      thread.join();
+  }
 
   // sync relocations created by relaxation
   BranchIslandFactory* br_factory = m_LDBackend.getBRIslandFactory();
@@ -924,6 +928,41 @@ void ObjectLinker::normalSyncRelocationResult(FileOutputBuffer& pOutput) {
   }
 }
 
+void ObjectLinker::syncInputRelocationResult(Input& pInput,
+                                             uint8_t* pOutput) {
+  LDContext::sect_iterator rs, rsEnd = pInput.context()->relocSectEnd();
+  for (rs = pInput.context()->relocSectBegin(); rs != rsEnd; ++rs) {
+    // bypass the reloc section if
+    // 1. its section kind is changed to Ignore. (The target section is a
+    // discarded group section.)
+    // 2. it has no reloc data. (All symbols in the input relocs are in the
+    // discarded group sections)
+    if (LDFileFormat::Ignore == (*rs)->kind() || !(*rs)->hasRelocData())
+      continue;
+    RelocData::iterator reloc, rEnd = (*rs)->getRelocData()->end();
+    for (reloc = (*rs)->getRelocData()->begin(); reloc != rEnd; ++reloc) {
+      Relocation* relocation = llvm::cast<Relocation>(reloc);
+
+      // bypass the reloc if the symbol is in the discarded input section
+      ResolveInfo* info = relocation->symInfo();
+      if (!info->outSymbol()->hasFragRef() &&
+          ResolveInfo::Section == info->type() &&
+          ResolveInfo::Undefined == info->desc())
+        continue;
+
+      // bypass the relocation with NONE type. This is to avoid overwrite the
+      // target result by NONE type relocation if there is a place which has
+      // two relocations to apply to, and one of it is NONE type. The result
+      // we want is the value of the other relocation result. For example,
+      // in .exidx, there are usually an R_ARM_NONE and R_ARM_PREL31 apply to
+      // the same place
+      if (relocation->type() == 0x0)
+        continue;
+      writeRelocationResult(*relocation, pOutput);
+    }  // for all relocations
+  }    // for all relocation section
+}
+
 void ObjectLinker::partialSyncRelocationResult(FileOutputBuffer& pOutput) {
   uint8_t* data = pOutput.getBufferStart();
 
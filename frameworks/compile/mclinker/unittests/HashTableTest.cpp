@@ -232,6 +232,39 @@ TEST_F(HashTableTest, rehash_test) {
   delete hashTable;
 }
 
+TEST_F(HashTableTest, reserve_test) {
+  typedef HashEntry<int, int, IntCompare> HashEntryType;
+  typedef HashTable<HashEntryType, IntHash, EntryFactory<HashEntryType> >
+      HashTableTy;
+  HashTableTy* hashTable = new HashTableTy(0);
+
+  hashTable->reserve(300000);
+  size_t buckets = hashTable->numOfBuckets();
+  EXPECT_TRUE(buckets * 3 >= 300000 * 4);
+
+  bool exist;
+  HashTableTy::entry_type* entry = 0;
+  for (unsigned int key = 0; key < 300000; ++key) {
+    entry = hashTable->insert(key, exist);
+    entry->setValue(key + 10);
+  }
+  EXPECT_TRUE(buckets == hashTable->numOfBuckets());
+
+  // reserving less than the current size keeps the buckets
+  hashTable->reserve(10);
+  EXPECT_TRUE(buckets == hashTable->numOfBuckets());
+
+  hashTable->reserve(1000000);
+  EXPECT_TRUE(buckets < hashTable->numOfBuckets());
+  HashTableTy::iterator iter;
+  for (int key = 0; key < 300000; ++key) {
+    iter = hashTable->find(key);
+    EXPECT_EQ((key + 10), iter.getEntry()->value());
+  }
+
+  delete hashTable;
+}
+
 TEST_F(HashTableTest, bucket_iterator) {
   typedef HashEntry<int, int, IntCompare> HashEntryType;
   typedef HashTable<HashEntryType, IntHash, EntryFactory<HashEntryType> >
@@ -89,6 +89,23 @@ namespace {
 static const char *kRSTriple32 = "renderscript32-none-linux-gnueabi";
 static const char *kRSTriple64 = "renderscript64-none-linux-gnueabi";
 
+// The dependency file lists the RS headers as well, which are system headers.
+class RSDependencyCollector : public clang::DependencyCollector {
+ public:
+  bool needSystemDependencies() override { return true; }
+};
+
+// Escapes a file name the way clang::DependencyFileGenerator does for make.
+void PrintDepFilename(llvm::raw_ostream &OS, llvm::StringRef Filename) {
+  for (unsigned i = 0, e = Filename.size(); i != e; ++i) {
+    if (Filename[i] == ' ' || Filename[i] == '#')
+      OS << '\\';
+    else if (Filename[i] == '$')
+      OS << '$';
+    OS << Filename[i];
+  }
+}
+
 }  // namespace
 
 namespace slang {
@@ -358,50 +375,70 @@ bool Slang::setDepOutput(const char *OutputFile) {
 int Slang::generateDepFile(bool PhonyTarget) {
   if (mDiagEngine->hasErrorOccurred())
     return 1;
-  if (mDOS.get() == nullptr)
+  if (mDOS.get() == nullptr || mDepCollector == nullptr)
     return 1;
 
-  // Initialize options for generating dependency file
-  clang::DependencyOutputOptions DepOpts;
-  DepOpts.IncludeSystemHeaders = 1;
-  if (PhonyTarget)
-    DepOpts.UsePhonyTargets = 1;
-  DepOpts.OutputFile = mDepOutputFileName;
-  DepOpts.Targets = mAdditionalDepTargets;
-  DepOpts.Targets.push_back(mDepTargetBCFileName);
+  std::vector<std::string> Targets = mAdditionalDepTargets;
+  Targets.push_back(mDepTargetBCFileName);
   for (std::vector<std::string>::const_iterator
            I = mGeneratedFileNames.begin(), E = mGeneratedFileNames.end();
        I != E;
        I++) {
-    DepOpts.Targets.push_back(*I);
+    Targets.push_back(*I);
   }
   mGeneratedFileNames.clear();
 
-  // Per-compilation needed initialization
-  createPreprocessor();
-  clang::DependencyFileGenerator::CreateAndAttachToPreprocessor(*mPP.get(), DepOpts);
-
-  // Inform the diagnostic client we are processing a source file
-  mDiagClient->BeginSourceFile(LangOpts, mPP.get());
-
-  // Go through the source file (no operations necessary)
-  clang::Token Tok;
-  mPP->EnterMainSourceFile();
-  do {
-    mPP->Lex(Tok);
-  } while (Tok.isNot(clang::tok::eof));
-
-  mPP->EndSourceFile();
+  // Write the rule the same way clang::DependencyFileGenerator would have, from
+  // the files seen while compiling.
+  llvm::ArrayRef<std::string> Files = mDepCollector->getDependencies();
+  llvm::raw_ostream &OS = mDOS->os();
+  const unsigned MaxColumns = 75;
+  unsigned Columns = 0;
+
+  for (const std::string &Target : Targets) {
+    unsigned N = Target.size();
+    if (Columns == 0) {
+      Columns += N;
+    } else if (Columns + N + 2 > MaxColumns) {
+      Columns = N + 2;
+      OS << " \\\n  ";
+    } else {
+      Columns += N + 1;
+      OS << ' ';
+    }
+    OS << Target;
+  }
+  OS << ':';
+  Columns += 1;
+
+  for (const std::string &File : Files) {
+    unsigned N = File.size();
+    if (Columns + (N + 1) + 2 > MaxColumns) {
+      OS << " \\\n ";
+      Columns = 2;
+    }
+    OS << ' ';
+    PrintDepFilename(OS, File);
+    Columns += N + 1;
+  }
+  OS << '\n';
+
+  // The first file is the input itself, which doesn't need a phony target.
+  if (PhonyTarget && !Files.empty()) {
+    for (size_t i = 1, e = Files.size(); i != e; i++) {
+      OS << '\n';
+      PrintDepFilename(OS, Files[i]);
+      OS << ":\n";
+    }
+  }
 
-  // Declare success if no error
-  if (!mDiagEngine->hasErrorOccurred())
-    mDOS->keep();
+  mDOS->keep();
 
   // Clean up after compilation
-  mPP.reset();
+  mDepCollector.reset();
   mDOS.reset();
 
-  return mDiagEngine->hasErrorOccurred() ? 1 : 0;
+  return 0;
 }
 
 int Slang::compile(const RSCCOptions &Opts) {
@@ -414,6 +451,13 @@ int Slang::compile(const RSCCOptions &Opts) {
   createPreprocessor();
   createASTContext();
 
+  if (Opts.mEmitDependency) {
+    mDepCollector = std::make_shared<RSDependencyCollector>();
+    mDepCollector->attachToPreprocessor(*mPP);
+  } else {
+    mDepCollector.reset();
+  }
+
   mBackend.reset(createBackend(Opts, CodeGenOpts, &mOS->os(), mOT));
 
   // Inform the diagnostic client we are processing a source file
@@ -53,6 +53,7 @@ namespace clang {
   class ASTContext;
   class Backend;
   class CodeGenOptions;
+  class DependencyCollector;
   class Diagnostic;
   class DiagnosticsEngine;
   class FileManager;
@@ -156,6 +157,10 @@ class Slang : public clang::ModuleLoader {
   // Dependency output stream
   std::unique_ptr<llvm::tool_output_file> mDOS;
 
+  // Files entered by the preprocessor during the last compile(), so that
+  // generateDepFile() doesn't have to preprocess the input again.
+  std::shared_ptr<clang::DependencyCollector> mDepCollector;
+
   std::vector<std::string> mIncludePaths;
 
   // Context for Renderscript
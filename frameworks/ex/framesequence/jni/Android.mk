@@ -32,6 +32,7 @@ LOCAL_SRC_FILES := \
 	FrameSequence.cpp \
 	FrameSequenceJNI.cpp \
 	FrameSequence_gif.cpp \
+	FrameSequence_lookahead.cpp \
 	JNIHelpers.cpp \
 	Registry.cpp \
 	Stream.cpp
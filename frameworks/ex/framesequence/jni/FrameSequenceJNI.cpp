@@ -18,6 +18,7 @@
 #include "JNIHelpers.h"
 #include "utils/log.h"
 #include "FrameSequence.h"
+#include "FrameSequence_lookahead.h"
 
 #include "FrameSequenceJNI.h"
 
@@ -94,6 +95,9 @@ static void nativeDestroyFrameSequence(JNIEnv* env, jobject clazz,
 static jlong nativeCreateState(JNIEnv* env, jobject clazz, jlong frameSequenceLong) {
     FrameSequence* frameSequence = reinterpret_cast<FrameSequence*>(frameSequenceLong);
     FrameSequenceState* state = frameSequence->createState();
+    if (state && frameSequence->getFrameCount() > 1) {
+        state = new FrameSequenceState_lookahead(*frameSequence, state);
+    }
     return reinterpret_cast<jlong>(state);
 }
 
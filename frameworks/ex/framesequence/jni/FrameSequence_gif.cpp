@@ -145,15 +145,40 @@ static bool checkIfCover(const GifImageDesc& target, const GifImageDesc& covered
             && covered.Top + covered.Height <= target.Top + target.Height;
 }
 
-static void copyLine(Color8888* dst, const unsigned char* src, const ColorMapObject* cmap,
-                     int transparent, int width) {
+// Fills a lookup table from every possible pixel value to its color. Pixels that aren't drawn
+// (the transparent index, or past the end of the color map) map to TRANSPARENT, which no color
+// from the map can be since they are all opaque. Returns true if every pixel value is drawn.
+static bool buildPalette(const ColorMapObject* cmap, int transparent, Color8888* palette) {
+    const int colorCount = cmap ? min(cmap->ColorCount, 256) : 0;
+    for (int i = 0; i < colorCount; i++) {
+        palette[i] = gifColorToColor8888(cmap->Colors[i]);
+    }
+    for (int i = colorCount; i < 256; i++) {
+        palette[i] = TRANSPARENT;
+    }
+    if (transparent >= 0 && transparent < 256) {
+        palette[transparent] = TRANSPARENT;
+    }
+    return colorCount == 256 && transparent == NO_TRANSPARENT_COLOR;
+}
+
+static void copyLine(Color8888* dst, const unsigned char* src, const Color8888* palette,
+                     int width) {
     for (; width > 0; width--, src++, dst++) {
-        if (*src != transparent && *src < cmap->ColorCount) {
-            *dst = gifColorToColor8888(cmap->Colors[*src]);
+        Color8888 color = palette[*src];
+        if (color != TRANSPARENT) {
+            *dst = color;
         }
     }
 }
 
+static void copyOpaqueLine(Color8888* dst, const unsigned char* src, const Color8888* palette,
+                           int width) {
+    for (; width > 0; width--, src++, dst++) {
+        *dst = palette[*src];
+    }
+}
+
 static void setLineColor(Color8888* dst, Color8888 color, int width) {
     for (; width > 0; width--, dst++) {
         *dst = color;
@@ -311,13 +336,21 @@ long FrameSequenceState_gif::drawFrame(int frameNr,
                 ALOGW("Warning: potentially corrupt color map");
             }
 
+            // Converting the color map once is much cheaper than converting every pixel.
+            Color8888 palette[256];
+            const bool opaque = buildPalette(cmap, gcb.TransparentColor, palette);
+
             const unsigned char* src = (unsigned char*)frame.RasterBits;
             Color8888* dst = outputPtr + frame.ImageDesc.Left +
                     frame.ImageDesc.Top * outputPixelStride;
             GifWord copyWidth, copyHeight;
             getCopySize(frame.ImageDesc, width, height, copyWidth, copyHeight);
             for (; copyHeight > 0; copyHeight--) {
-                copyLine(dst, src, cmap, gcb.TransparentColor, copyWidth);
+                if (opaque) {
+                    copyOpaqueLine(dst, src, palette, copyWidth);
+                } else {
+                    copyLine(dst, src, palette, copyWidth);
+                }
                 src += frame.ImageDesc.Width;
                 dst += outputPixelStride;
             }
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "FrameSequence_lookahead.h"
+#include "utils/log.h"
+#include "utils/math.h"
+
+#define LOOKAHEAD_DEBUG 0
+
+// Upper bound on the worker threads, shared by all the animations of the process.
+#define MAX_WORKER_THREADS 4
+
+////////////////////////////////////////////////////////////////////////////////
+// Worker pool
+////////////////////////////////////////////////////////////////////////////////
+
+class LookAheadPool {
+public:
+    // Queues frameNr to be drawn into state's canvas.
+    static void enqueue(FrameSequenceState_lookahead* state, int frameNr) {
+        pthread_mutex_lock(&sLock);
+        if (startThreadsLocked()) {
+            state->mQueuedFrame = frameNr;
+            state->mNextQueued = NULL;
+            if (sQueueTail) {
+                sQueueTail->mNextQueued = state;
+            } else {
+                sQueueHead = state;
+            }
+            sQueueTail = state;
+            pthread_cond_signal(&sWorkCond);
+        }
+        pthread_mutex_unlock(&sLock);
+    }
+
+    // Drops the work queued for state, or waits for a worker to finish it. When this returns no
+    // worker touches state until it is queued again.
+    static void settle(FrameSequenceState_lookahead* state) {
+        pthread_mutex_lock(&sLock);
+        if (state->mQueuedFrame >= 0) {
+            FrameSequenceState_lookahead** link = &sQueueHead;
+            FrameSequenceState_lookahead* prev = NULL;
+            while (*link != state) {
+                prev = *link;
+                link = &prev->mNextQueued;
+            }
+            *link = state->mNextQueued;
+            if (sQueueTail == state) {
+                sQueueTail = prev;
+            }
+            state->mQueuedFrame = -1;
+            state->mNextQueued = NULL;
+        }
+        while (state->mRunning) {
+            pthread_cond_wait(&sDoneCond, &sLock);
+        }
+        pthread_mutex_unlock(&sLock);
+    }
+
+private:
+    static bool startThreadsLocked() {
+        if (sThreadsStarted) {
+            return sThreadCount > 0;
+        }
+        sThreadsStarted = true;
+
+        // Keep a core for the UI thread, which copies the frames out.
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int threads = min(max((int) cpus - 1, 1), MAX_WORKER_THREADS);
+
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        for (int i = 0; i < threads; i++) {
+            pthread_t thread;
+            if (pthread_create(&thread, &attr, workerLoop, NULL) != 0) {
+                ALOGW("Couldn't start frame look-ahead thread %d", i);
+                break;
+            }
+            sThreadCount++;
+        }
+        pthread_attr_destroy(&attr);
+        return sThreadCount > 0;
+    }
+
+    static void* workerLoop(void*) {
+        pthread_mutex_lock(&sLock);
+        while (true) {
+            while (!sQueueHead) {
+                pthread_cond_wait(&sWorkCond, &sLock);
+            }
+            FrameSequenceState_lookahead* state = sQueueHead;
+            sQueueHead = state->mNextQueued;
+            if (!sQueueHead) {
+                sQueueTail = NULL;
+            }
+            const int frameNr = state->mQueuedFrame;
+            state->mQueuedFrame = -1;
+            state->mNextQueued = NULL;
+            state->mRunning = true;
+            pthread_mutex_unlock(&sLock);
+
+#if LOOKAHEAD_DEBUG
+            ALOGD("drawing frame %d ahead for %p", frameNr, state);
+#endif
+            state->drawToCanvas(frameNr);
+
+            pthread_mutex_lock(&sLock);
+            state->mRunning = false;
+            pthread_cond_broadcast(&sDoneCond);
+        }
+        return NULL;
+    }
+
+    static pthread_mutex_t sLock;
+    static pthread_cond_t sWorkCond;
+    static pthread_cond_t sDoneCond;
+    static FrameSequenceState_lookahead* sQueueHead;
+    static FrameSequenceState_lookahead* sQueueTail;
+    static bool sThreadsStarted;
+    static int sThreadCount;
+};
+
+pthread_mutex_t LookAheadPool::sLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t LookAheadPool::sWorkCond = PTHREAD_COND_INITIALIZER;
+pthread_cond_t LookAheadPool::sDoneCond = PTHREAD_COND_INITIALIZER;
+FrameSequenceState_lookahead* LookAheadPool::sQueueHead = NULL;
+FrameSequenceState_lookahead* LookAheadPool::sQueueTail = NULL;
+bool LookAheadPool::sThreadsStarted = false;
+int LookAheadPool::sThreadCount = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+// Frame sequence state
+////////////////////////////////////////////////////////////////////////////////
+
+FrameSequenceState_lookahead::FrameSequenceState_lookahead(
+        const FrameSequence& frameSequence, FrameSequenceState* state) :
+        mWidth(frameSequence.getWidth()),
+        mHeight(frameSequence.getHeight()),
+        mFrameCount(frameSequence.getFrameCount()),
+        mState(state),
+        mCanvas(new Color8888[mWidth * mHeight]),
+        mCanvasFrame(-1),
+        mCanvasDelay(-1),
+        mQueuedFrame(-1),
+        mRunning(false),
+        mNextQueued(NULL) {
+}
+
+FrameSequenceState_lookahead::~FrameSequenceState_lookahead() {
+    LookAheadPool::settle(this);
+    delete mState;
+    delete[] mCanvas;
+}
+
+void FrameSequenceState_lookahead::drawToCanvas(int frameNr) {
+    if (mCanvasFrame == frameNr) {
+        return;
+    }
+
+    // Frames only build on earlier ones, so going back to the start means a redraw from scratch.
+    int previousFrameNr = mCanvasFrame < frameNr ? mCanvasFrame : -1;
+    mCanvasDelay = mState->drawFrame(frameNr, mCanvas, mWidth, previousFrameNr);
+    mCanvasFrame = mCanvasDelay >= 0 ? frameNr : -1;
+}
+
+long FrameSequenceState_lookahead::drawFrame(int frameNr,
+        Color8888* outputPtr, int outputPixelStride, int previousFrameNr) {
+    // The canvas keeps the previous frame, so previousFrameNr (the content of the caller's
+    // buffer) isn't needed.
+    LookAheadPool::settle(this);
+
+#if LOOKAHEAD_DEBUG
+    ALOGD("frame %d requested from %p, canvas holds %d", frameNr, this, mCanvasFrame);
+#endif
+    drawToCanvas(frameNr);
+    if (mCanvasFrame != frameNr) {
+        return mCanvasDelay;
+    }
+
+    for (int y = 0; y < mHeight; y++) {
+        memcpy(outputPtr + y * outputPixelStride, mCanvas + y * mWidth,
+                mWidth * sizeof(Color8888));
+    }
+    const long delay = mCanvasDelay;
+
+    LookAheadPool::enqueue(this, (frameNr + 1) % mFrameCount);
+    return delay;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RASTERMILL_FRAMESEQUENCE_LOOKAHEAD_H
+#define RASTERMILL_FRAMESEQUENCE_LOOKAHEAD_H
+
+#include "FrameSequence.h"
+
+/**
+ * Wraps the state of an animated sequence so that frames are produced ahead of time.
+ *
+ * The wrapped state always draws into a private canvas, so that it only has to draw the delta
+ * from the frame before, whatever the caller's buffer holds. Once a frame has been copied out,
+ * the next one is drawn on a process-wide pool of worker threads, and the following drawFrame()
+ * call only has to wait for it and copy it.
+ */
+class FrameSequenceState_lookahead : public FrameSequenceState {
+public:
+    // Takes ownership of state.
+    FrameSequenceState_lookahead(const FrameSequence& frameSequence, FrameSequenceState* state);
+    virtual ~FrameSequenceState_lookahead();
+
+    virtual long drawFrame(int frameNr,
+            Color8888* outputPtr, int outputPixelStride, int previousFrameNr);
+
+private:
+    friend class LookAheadPool;
+
+    // Draws frameNr into the canvas, from the frame it currently holds if possible.
+    void drawToCanvas(int frameNr);
+
+    const int mWidth;
+    const int mHeight;
+    const int mFrameCount;
+    FrameSequenceState* mState;
+
+    // Frame held by mCanvas, and the delay drawFrame() returned for it, or -1.
+    Color8888* mCanvas;
+    int mCanvasFrame;
+    long mCanvasDelay;
+
+    // Frame to draw ahead, or -1. Guarded by the pool lock.
+    int mQueuedFrame;
+    bool mRunning;
+    FrameSequenceState_lookahead* mNextQueued;
+};
+
+#endif // RASTERMILL_FRAMESEQUENCE_LOOKAHEAD_H
@@ -17,6 +17,7 @@
 #ifndef MINIKIN_FONT_COLLECTION_H
 #define MINIKIN_FONT_COLLECTION_H
 
+#include <atomic>
 #include <memory>
 #include <unordered_set>
 #include <vector>
@@ -79,6 +80,11 @@ private:
     const std::shared_ptr<FontFamily>& getFamilyForChar(uint32_t ch, uint32_t vs,
             uint32_t langListId, int variant) const;
 
+    // Scores the candidate families for the character. Called by getFamilyForChar() on cache
+    // misses.
+    const std::shared_ptr<FontFamily>& findFamilyForChar(uint32_t ch, uint32_t vs,
+            uint32_t langListId, int variant) const;
+
     uint32_t calcFamilyScore(uint32_t ch, uint32_t vs, int variant, uint32_t langListId,
             const std::shared_ptr<FontFamily>& fontFamily) const;
 
@@ -117,6 +123,12 @@ private:
 
     // Set of supported axes in this collection.
     std::unordered_set<AxisTag> mSupportedAxes;
+
+    // Direct-mapped cache of the families resolved for characters without variation selector.
+    // Each entry packs the language list ID, the code point, the variant and the index of the
+    // family into mFamilies, so that it can be read and updated without a lock.
+    static const size_t kFamilyCacheSize = 256;
+    mutable std::atomic<uint64_t> mFamilyCache[kFamilyCacheSize];
 };
 
 }  // namespace minikin
@@ -19,8 +19,13 @@
  */
 
 #include "unicode/locid.h"
+#include <list>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #ifndef MINIKIN_HYPHENATOR_H
 #define MINIKIN_HYPHENATOR_H
@@ -123,9 +128,18 @@ public:
     //
     // Example: word is "hyphen", result is the following, corresponding to "hy-phen":
     // [DONT_BREAK, DONT_BREAK, BREAK_AND_INSERT_HYPHEN, DONT_BREAK, DONT_BREAK, DONT_BREAK]
+    //
+    // Results of the pattern lookup are cached per Hyphenator, so words that repeat in a document
+    // only walk the pattern trie once. This method may be called from several threads.
     void hyphenate(std::vector<HyphenationType>* result, const uint16_t* word, size_t len,
             const icu::Locale& locale);
 
+    // Compute the hyphenation of all the words of a text in one call. Each entry of words is a
+    // non-overlapping [start, end) range of code units in text. The result has one entry per code
+    // unit up to the end of the last word, and is DONT_BREAK outside of the words.
+    void hyphenateWords(std::vector<HyphenationType>* result, const uint16_t* text,
+            const std::vector<std::pair<size_t, size_t>>& words, const icu::Locale& locale);
+
     // Returns true if the codepoint is like U+2010 HYPHEN in line breaking and usage: a character
     // immediately after which line breaks are allowed, but words containing it should not be
     // automatically hyphenated.
@@ -139,6 +153,10 @@ public:
     static Hyphenator* loadBinary(const uint8_t* patternData, size_t minPrefix, size_t minSuffix);
 
 private:
+    // hyphenate a single word into result, which must hold len DONT_BREAK entries
+    void hyphenateWord(HyphenationType* result, const uint16_t* word, size_t len,
+            const icu::Locale& locale);
+
     // apply various hyphenation rules including hard and soft hyphens, ignoring patterns
     void hyphenateWithNoPatterns(HyphenationType* result, const uint16_t* word, size_t len,
             const icu::Locale& locale);
@@ -158,9 +176,23 @@ private:
     // different use case. It measures UTF-16 code units.
     static const size_t MAX_HYPHENATED_SIZE = 64;
 
+    // Number of words whose pattern hyphenation is remembered.
+    static const size_t MAX_CACHED_WORDS = 1024;
+
+    bool getCachedBreaks(const std::u16string& key, uint64_t* breaks);
+    void putCachedBreaks(const std::u16string& key, uint64_t breaks);
+
     const uint8_t* patternData;
     size_t minPrefix, minSuffix;
 
+    // LRU cache of pattern hyphenation, most recently used first. The key is the alphabet codes
+    // of the word followed by its hyphenation type; bit i of the value is set when the word can
+    // be hyphenated at code unit offset i.
+    std::mutex cacheLock;
+    std::list<std::pair<std::u16string, uint64_t>> cachedWords;
+    std::unordered_map<std::u16string,
+            std::list<std::pair<std::u16string, uint64_t>>::iterator> cacheIndex;
+
     // accessors for binary data
     const Header* getHeader() const {
         return reinterpret_cast<const Header*>(patternData);
@@ -104,6 +104,7 @@ public:
 
 private:
     friend class LayoutCacheKey;
+    friend class LayoutCache;
 
     // Find a face in the mFaces vector, or create a new entry
     int findFace(const FakedFont& face, LayoutContext* ctx);
@@ -130,6 +131,12 @@ private:
     // Append another layout (for example, cached value) into this one
     void appendLayout(Layout* src, size_t start, float extraAdvance);
 
+    // Releases the hb_font_t objects held by ctx, taking gMinikinLock if there are any.
+    static void clearHbFonts(LayoutContext* ctx);
+
+    // Returns the heap memory used by the glyph, advance and face arrays, for cache accounting.
+    size_t memoryUsage() const;
+
     std::vector<LayoutGlyph> mGlyphs;
     std::vector<float> mAdvances;
 
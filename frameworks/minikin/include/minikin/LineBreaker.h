@@ -202,6 +202,7 @@ class LineBreaker {
             size_t preSpaceCount;  // preceding space count before breaking
             size_t postSpaceCount;  // preceding space count after breaking
             HyphenationType hyphenType;
+            size_t active;  // first candidate considered as the start of a line ending here
         };
 
         float currentLineWidth() const;
@@ -223,6 +224,8 @@ class LineBreaker {
 
         void finishBreaksOptimal();
 
+        size_t reusableOptimalPrefix(float width, float maxShrink) const;
+
         WordBreaker mWordBreaker;
         icu::Locale mLocale;
         std::vector<uint16_t>mTextBuf;
@@ -247,6 +250,15 @@ class LineBreaker {
         std::vector<Candidate> mCandidates;
         float mLinePenalty = 0.0f;
 
+        // Result of the last optimal breaking, kept across finish() so that re-breaking an edited
+        // paragraph can resume the dynamic program after the unchanged prefix.
+        std::vector<Candidate> mPrevCandidates;
+        BreakStrategy mPrevStrategy = kBreakStrategy_Greedy;
+        bool mPrevJustified = false;
+        float mPrevLinePenalty = 0.0f;
+        float mPrevWidth = 0.0f;
+        float mPrevMaxShrink = 0.0f;
+
         // the following are state for greedy breaker (updated while adding style runs)
         size_t mLastBreak;
         size_t mBestBreak;
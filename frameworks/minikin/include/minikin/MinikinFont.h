@@ -31,15 +31,11 @@ namespace minikin {
 class MinikinFont;
 
 // Possibly move into own .h file?
-// Note: if you add a field here, either add it to LayoutCacheKey or to skipCache()
+// Note: if you add a field here, also add it to LayoutCacheKey
 struct MinikinPaint {
     MinikinPaint() : font(nullptr), size(0), scaleX(0), skewX(0), letterSpacing(0), wordSpacing(0),
             paintFlags(0), fakery(), hyphenEdit(), fontFeatureSettings() { }
 
-    bool skipCache() const {
-        return !fontFeatureSettings.empty();
-    }
-
     MinikinFont *font;
     float size;
     float scaleX;
@@ -58,6 +58,9 @@ FontCollection::FontCollection(const vector<std::shared_ptr<FontFamily>>& typefa
 void FontCollection::init(const vector<std::shared_ptr<FontFamily>>& typefaces) {
     android::AutoMutex _l(gMinikinLock);
     mId = sNextId++;
+    for (size_t i = 0; i < kFamilyCacheSize; i++) {
+        mFamilyCache[i].store(0, std::memory_order_relaxed);
+    }
     vector<uint32_t> lastChar;
     size_t nTypefaces = typefaces.size();
 #ifdef VERBOSE_DEBUG
@@ -253,7 +256,37 @@ const std::shared_ptr<FontFamily>& FontCollection::getFamilyForChar(uint32_t ch,
     if (ch >= mMaxChar) {
         return mFamilies[0];
     }
+    if (vs != 0) {
+        return findFamilyForChar(ch, vs, langListId, variant);
+    }
+
+    // Fast path for text the first family covers, typically Latin: rule 1 above applies
+    // regardless of the language and variant.
+    if (mFamilies[0]->getCoverage().get(ch)) {
+        return mFamilies[0];
+    }
 
+    // Variants other than the known ones don't fit in the cache entry.
+    if (variant < 0 || variant > 3) {
+        return findFamilyForChar(ch, vs, langListId, variant);
+    }
+    const uint64_t key = static_cast<uint64_t>(langListId) << 32
+            | static_cast<uint64_t>(ch) << 11 | static_cast<uint64_t>(variant) << 9;
+    std::atomic<uint64_t>& entry =
+            mFamilyCache[(ch ^ (ch >> 8) ^ (langListId * 31)) % kFamilyCacheSize];
+    const uint64_t cached = entry.load(std::memory_order_relaxed);
+    if ((cached & 1) != 0 && (cached & ~static_cast<uint64_t>(0x1FF)) == key) {
+        return mFamilies[(cached >> 1) & 0xFF];
+    }
+
+    const std::shared_ptr<FontFamily>& family = findFamilyForChar(ch, vs, langListId, variant);
+    const uint64_t familyIndex = &family - &mFamilies[0];
+    entry.store(key | familyIndex << 1 | 1, std::memory_order_relaxed);
+    return family;
+}
+
+const std::shared_ptr<FontFamily>& FontCollection::findFamilyForChar(uint32_t ch, uint32_t vs,
+            uint32_t langListId, int variant) const {
     Range range = mRanges[ch >> kLogCharsPerPage];
 
     if (vs != 0) {
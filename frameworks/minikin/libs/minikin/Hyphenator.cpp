@@ -120,13 +120,81 @@ void Hyphenator::hyphenate(vector<HyphenationType>* result, const uint16_t* word
         const icu::Locale& locale) {
     result->clear();
     result->resize(len);
+    hyphenateWord(result->data(), word, len, locale);
+}
+
+void Hyphenator::hyphenateWords(vector<HyphenationType>* result, const uint16_t* text,
+        const vector<std::pair<size_t, size_t>>& words, const icu::Locale& locale) {
+    size_t end = 0;
+    for (const auto& word : words) {
+        end = std::max(end, word.second);
+    }
+    result->clear();
+    result->resize(end);
+    for (const auto& word : words) {
+        if (word.second > word.first) {
+            hyphenateWord(result->data() + word.first, text + word.first,
+                    word.second - word.first, locale);
+        }
+    }
+}
+
+bool Hyphenator::getCachedBreaks(const std::u16string& key, uint64_t* breaks) {
+    std::lock_guard<std::mutex> lock(cacheLock);
+    auto it = cacheIndex.find(key);
+    if (it == cacheIndex.end()) {
+        return false;
+    }
+    cachedWords.splice(cachedWords.begin(), cachedWords, it->second);
+    *breaks = it->second->second;
+    return true;
+}
+
+void Hyphenator::putCachedBreaks(const std::u16string& key, uint64_t breaks) {
+    std::lock_guard<std::mutex> lock(cacheLock);
+    if (cacheIndex.find(key) != cacheIndex.end()) {
+        // Another thread hyphenated the same word in the meantime.
+        return;
+    }
+    cachedWords.emplace_front(key, breaks);
+    cacheIndex[key] = cachedWords.begin();
+    if (cachedWords.size() > MAX_CACHED_WORDS) {
+        cacheIndex.erase(cachedWords.back().first);
+        cachedWords.pop_back();
+    }
+}
+
+void Hyphenator::hyphenateWord(HyphenationType* result, const uint16_t* word, size_t len,
+        const icu::Locale& locale) {
     const size_t paddedLen = len + 2;  // start and stop code each count for 1
     if (patternData != nullptr &&
             len >= minPrefix + minSuffix && paddedLen <= MAX_HYPHENATED_SIZE) {
         uint16_t alpha_codes[MAX_HYPHENATED_SIZE];
         const HyphenationType hyphenValue = alphabetLookup(alpha_codes, word, len);
         if (hyphenValue != HyphenationType::DONT_BREAK) {
-            hyphenateFromCodes(result->data(), alpha_codes, paddedLen, hyphenValue);
+            // Pattern hyphenation only depends on the alphabet codes, so words differing in case
+            // share a cache entry. The hyphenation type is part of the key since it comes from
+            // the script of the word rather than from the codes.
+            static_assert(MAX_HYPHENATED_SIZE <= 64, "Breaks must fit in a 64-bit mask.");
+            std::u16string key(alpha_codes + 1, alpha_codes + 1 + len);
+            key.push_back(static_cast<char16_t>(hyphenValue));
+            uint64_t breaks;
+            if (getCachedBreaks(key, &breaks)) {
+                for (size_t i = 0; i < len; i++) {
+                    if (breaks & (1ull << i)) {
+                        result[i] = hyphenValue;
+                    }
+                }
+                return;
+            }
+            hyphenateFromCodes(result, alpha_codes, paddedLen, hyphenValue);
+            breaks = 0;
+            for (size_t i = 0; i < len; i++) {
+                if (result[i] != HyphenationType::DONT_BREAK) {
+                    breaks |= 1ull << i;
+                }
+            }
+            putCachedBreaks(key, breaks);
             return;
         }
         // TODO: try NFC normalization
@@ -135,7 +203,7 @@ void Hyphenator::hyphenate(vector<HyphenationType>* result, const uint16_t* word
     // Note that we will always get here if the word contains a hyphen or a soft hyphen, because the
     // alphabet is not expected to contain a hyphen or a soft hyphen character, so alphabetLookup
     // would return DONT_BREAK.
-    hyphenateWithNoPatterns(result->data(), word, len, locale);
+    hyphenateWithNoPatterns(result, word, len, locale);
 }
 
 // This function determines whether a character is like U+2010 HYPHEN in
@@ -17,7 +17,9 @@
 #define LOG_TAG "Minikin"
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <inttypes.h>
 #include <iostream>  // for debugging
 #include <math.h>
 #include <string>
@@ -74,7 +76,8 @@ public:
             mStart(start), mCount(count), mId(collection->getId()), mStyle(style),
             mSize(paint.size), mScaleX(paint.scaleX), mSkewX(paint.skewX),
             mLetterSpacing(paint.letterSpacing),
-            mPaintFlags(paint.paintFlags), mHyphenEdit(paint.hyphenEdit), mIsRtl(dir),
+            mPaintFlags(paint.paintFlags), mHyphenEdit(paint.hyphenEdit),
+            mFontFeatureSettings(paint.fontFeatureSettings), mIsRtl(dir),
             mHash(computeHash()) {
     }
     bool operator==(const LayoutCacheKey &other) const;
@@ -92,6 +95,10 @@ public:
         delete[] mChars;
         mChars = NULL;
     }
+    // Memory held by the key outside of the object itself, once the text has been copied.
+    size_t heapSize() const {
+        return mNchars * sizeof(uint16_t) + mFontFeatureSettings.size();
+    }
 
     void doLayout(Layout* layout, LayoutContext* ctx,
             const std::shared_ptr<FontCollection>& collection) const {
@@ -113,6 +120,7 @@ private:
     float mLetterSpacing;
     int32_t mPaintFlags;
     HyphenEdit mHyphenEdit;
+    std::string mFontFeatureSettings;
     bool mIsRtl;
     // Note: any fields added to MinikinPaint must also be reflected here.
     // TODO: language matching (possibly integrate into style)
@@ -121,42 +129,101 @@ private:
     android::hash_t computeHash() const;
 };
 
-class LayoutCache : private android::OnEntryRemoved<LayoutCacheKey, Layout*> {
+// Caches the layout of words. The cache is split in shards selected by the key hash, each with
+// its own lock, so that lookups from threads laying out text concurrently rarely contend, and
+// cache hits never wait for gMinikinLock. Misses are laid out under gMinikinLock, outside of
+// the shard lock. Capacity is bounded by the estimated memory footprint of the entries.
+class LayoutCache {
 public:
-    LayoutCache() : mCache(kMaxEntries) {
-        mCache.setOnEntryRemovedListener(this);
-    }
+    LayoutCache() : mHits(0), mMisses(0) {}
 
     void clear() {
-        mCache.clear();
+        for (Shard& shard : mShards) {
+            android::AutoMutex _l(shard.lock);
+            shard.cache.clear();
+        }
     }
 
-    Layout* get(LayoutCacheKey& key, LayoutContext* ctx,
+    // Returns the layout for key, laying it out if it isn't cached. Must not be called with
+    // gMinikinLock held.
+    std::shared_ptr<Layout> get(LayoutCacheKey& key, LayoutContext* ctx,
             const std::shared_ptr<FontCollection>& collection) {
-        Layout* layout = mCache.get(key);
-        if (layout == NULL) {
-            key.copyText();
-            layout = new Layout();
-            key.doLayout(layout, ctx, collection);
-            mCache.put(key, layout);
+        Shard& shard = mShards[key.hash() % kShardCount];
+        {
+            android::AutoMutex _l(shard.lock);
+            const std::shared_ptr<Layout>& cached = shard.cache.get(key);
+            if (cached != nullptr) {
+                mHits++;
+                return cached;
+            }
+        }
+        mMisses++;
+
+        std::shared_ptr<Layout> layout = std::make_shared<Layout>();
+        {
+            android::AutoMutex _l(gMinikinLock);
+            key.doLayout(layout.get(), ctx, collection);
+        }
+
+        key.copyText();
+        android::AutoMutex _l(shard.lock);
+        // Another thread may have laid out the same word in the meantime; keep its entry.
+        if (!shard.cache.put(key, layout)) {
+            key.freeText();
+            return layout;
+        }
+        shard.bytes += estimateSize(key, *layout);
+        while (shard.bytes > kMaxBytesPerShard && shard.cache.size() > 1) {
+            shard.cache.removeOldest();
         }
         return layout;
     }
 
+    void dumpStats() const {
+        size_t bytes = 0;
+        size_t entries = 0;
+        for (const Shard& shard : mShards) {
+            android::AutoMutex _l(shard.lock);
+            bytes += shard.bytes;
+            entries += shard.cache.size();
+        }
+        ALOGD("Layout cache: %zu entries, %zu bytes, %" PRIu64 " hits, %" PRIu64 " misses",
+                entries, bytes, mHits.load(), mMisses.load());
+    }
+
 private:
-    // callback for OnEntryRemoved
-    void operator()(LayoutCacheKey& key, Layout*& value) {
-        key.freeText();
-        delete value;
+    typedef android::LruCache<LayoutCacheKey, std::shared_ptr<Layout>> LayoutLruCache;
+
+    static size_t estimateSize(const LayoutCacheKey& key, const Layout& layout) {
+        return sizeof(LayoutCacheKey) + sizeof(Layout) + key.heapSize() + layout.memoryUsage();
     }
 
-    android::LruCache<LayoutCacheKey, Layout*> mCache;
+    struct Shard : private android::OnEntryRemoved<LayoutCacheKey, std::shared_ptr<Layout>> {
+        Shard() : cache(LayoutLruCache::kUnlimitedCapacity), bytes(0) {
+            cache.setOnEntryRemovedListener(this);
+        }
+
+        // callback for OnEntryRemoved
+        void operator()(LayoutCacheKey& key, std::shared_ptr<Layout>& value) {
+            bytes -= estimateSize(key, *value);
+            key.freeText();
+            // Threads still using the layout keep it alive through their reference.
+            value.reset();
+        }
+
+        mutable android::Mutex lock;
+        LayoutLruCache cache;
+        size_t bytes;
+    };
 
-    //static const size_t kMaxEntries = LruCache<LayoutCacheKey, Layout*>::kUnlimitedCapacity;
+    static const size_t kShardCount = 16;
 
-    // TODO: eviction based on memory footprint; for now, we just use a constant
-    // number of strings
-    static const size_t kMaxEntries = 5000;
+    // About as much memory as the former limit of 5000 entries used for typical words.
+    static const size_t kMaxBytesPerShard = 2 * 1024 * 1024 / kShardCount;
+
+    Shard mShards[kShardCount];
+    std::atomic<uint64_t> mHits;
+    std::atomic<uint64_t> mMisses;
 };
 
 static unsigned int disabledDecomposeCompatibility(hb_unicode_funcs_t*, hb_codepoint_t,
@@ -191,6 +258,7 @@ bool LayoutCacheKey::operator==(const LayoutCacheKey& other) const {
             && mLetterSpacing == other.mLetterSpacing
             && mPaintFlags == other.mPaintFlags
             && mHyphenEdit == other.mHyphenEdit
+            && mFontFeatureSettings == other.mFontFeatureSettings
             && mIsRtl == other.mIsRtl
             && mNchars == other.mNchars
             && !memcmp(mChars, other.mChars, mNchars * sizeof(uint16_t));
@@ -208,6 +276,11 @@ android::hash_t LayoutCacheKey::computeHash() const {
     hash = android::JenkinsHashMix(hash, hash_type(mPaintFlags));
     hash = android::JenkinsHashMix(hash, hash_type(mHyphenEdit.getHyphen()));
     hash = android::JenkinsHashMix(hash, hash_type(mIsRtl));
+    if (!mFontFeatureSettings.empty()) {
+        hash = android::JenkinsHashMixBytes(hash,
+                reinterpret_cast<const uint8_t*>(mFontFeatureSettings.data()),
+                mFontFeatureSettings.size());
+    }
     hash = android::JenkinsHashMixShorts(hash, mChars, mNchars);
     return android::JenkinsHashWhiten(hash);
 }
@@ -542,8 +615,7 @@ BidiText::BidiText(const uint16_t* buf, size_t start, size_t count, size_t bufSi
 void Layout::doLayout(const uint16_t* buf, size_t start, size_t count, size_t bufSize,
         int bidiFlags, const FontStyle &style, const MinikinPaint &paint,
         const std::shared_ptr<FontCollection>& collection) {
-    android::AutoMutex _l(gMinikinLock);
-
+    // gMinikinLock is only taken to lay out words missing from the cache.
     LayoutContext ctx;
     ctx.style = style;
     ctx.paint = paint;
@@ -555,14 +627,13 @@ void Layout::doLayout(const uint16_t* buf, size_t start, size_t count, size_t bu
         doLayoutRunCached(buf, runInfo.mRunStart, runInfo.mRunLength, bufSize, runInfo.mIsRtl, &ctx,
                 start, collection, this, NULL);
     }
-    ctx.clearHbFonts();
+    clearHbFonts(&ctx);
 }
 
 float Layout::measureText(const uint16_t* buf, size_t start, size_t count, size_t bufSize,
         int bidiFlags, const FontStyle &style, const MinikinPaint &paint,
         const std::shared_ptr<FontCollection>& collection, float* advances) {
-    android::AutoMutex _l(gMinikinLock);
-
+    // gMinikinLock is only taken to lay out words missing from the cache.
     LayoutContext ctx;
     ctx.style = style;
     ctx.paint = paint;
@@ -574,10 +645,18 @@ float Layout::measureText(const uint16_t* buf, size_t start, size_t count, size_
                 runInfo.mIsRtl, &ctx, 0, collection, NULL, advancesForRun);
     }
 
-    ctx.clearHbFonts();
+    clearHbFonts(&ctx);
     return advance;
 }
 
+void Layout::clearHbFonts(LayoutContext* ctx) {
+    // The hb_font_t objects come from the HbFontCache, which is guarded by gMinikinLock.
+    if (!ctx->hbFonts.empty()) {
+        android::AutoMutex _l(gMinikinLock);
+        ctx->clearHbFonts();
+    }
+}
+
 float Layout::doLayoutRunCached(const uint16_t* buf, size_t start, size_t count, size_t bufSize,
         bool isRtl, LayoutContext* ctx, size_t dstStart,
         const std::shared_ptr<FontCollection>& collection, Layout* layout, float* advances) {
@@ -639,27 +718,16 @@ float Layout::doLayoutWord(const uint16_t* buf, size_t start, size_t count, size
 
     float wordSpacing = count == 1 && isWordSpace(buf[start]) ? ctx->paint.wordSpacing : 0;
 
-    float advance;
-    if (ctx->paint.skipCache()) {
-        Layout layoutForWord;
-        key.doLayout(&layoutForWord, ctx, collection);
-        if (layout) {
-            layout->appendLayout(&layoutForWord, bufStart, wordSpacing);
-        }
-        if (advances) {
-            layoutForWord.getAdvances(advances);
-        }
-        advance = layoutForWord.getAdvance();
-    } else {
-        Layout* layoutForWord = cache.get(key, ctx, collection);
-        if (layout) {
-            layout->appendLayout(layoutForWord, bufStart, wordSpacing);
-        }
-        if (advances) {
-            layoutForWord->getAdvances(advances);
-        }
-        advance = layoutForWord->getAdvance();
+    // Measurement (advances only) and layout share the cached word, so measuring text that was
+    // drawn, or hit-testing it for cursor movement, doesn't shape it again.
+    std::shared_ptr<Layout> layoutForWord = cache.get(key, ctx, collection);
+    if (layout) {
+        layout->appendLayout(layoutForWord.get(), bufStart, wordSpacing);
     }
+    if (advances) {
+        layoutForWord->getAdvances(advances);
+    }
+    float advance = layoutForWord->getAdvance();
 
     if (wordSpacing != 0) {
         advance += wordSpacing;
@@ -1087,10 +1155,16 @@ void Layout::getBounds(MinikinRect* bounds) const {
     bounds->set(mBounds);
 }
 
+size_t Layout::memoryUsage() const {
+    return mGlyphs.capacity() * sizeof(LayoutGlyph) + mAdvances.capacity() * sizeof(float)
+            + mFaces.capacity() * sizeof(FakedFont);
+}
+
 void Layout::purgeCaches() {
-    android::AutoMutex _l(gMinikinLock);
     LayoutCache& layoutCache = LayoutEngine::getInstance().layoutCache;
+    layoutCache.dumpStats();
     layoutCache.clear();
+    android::AutoMutex _l(gMinikinLock);
     purgeHbFontCacheLocked();
 }
 
@@ -18,6 +18,7 @@
 
 #define LOG_TAG "Minikin"
 
+#include <algorithm>
 #include <limits>
 
 #include <log/log.h>
@@ -424,15 +425,55 @@ void LineBreaker::finishBreaksOptimal() {
     std::reverse(mFlags.begin(), mFlags.end());
 }
 
+// Returns the index of the first candidate whose score has to be computed. The score of a
+// candidate only depends on the candidates before it, so when the paragraph is broken again with
+// the same parameters after an edit, every candidate before the first changed one keeps the
+// score, prev and active window found by the previous run. The last candidate of either run is
+// scored as the end of the paragraph and is never reused.
+size_t LineBreaker::reusableOptimalPrefix(float width, float maxShrink) const {
+    if (mPrevCandidates.empty() || mPrevStrategy != mStrategy || mPrevJustified != mJustified
+            || mPrevLinePenalty != mLinePenalty || mPrevWidth != width
+            || mPrevMaxShrink != maxShrink) {
+        return 1;
+    }
+    const size_t limit = std::min(mCandidates.size(), mPrevCandidates.size()) - 1;
+    size_t i = 1;
+    for (; i < limit; i++) {
+        const Candidate& cand = mCandidates[i];
+        const Candidate& prevCand = mPrevCandidates[i];
+        if (cand.offset != prevCand.offset || cand.preBreak != prevCand.preBreak
+                || cand.postBreak != prevCand.postBreak || cand.penalty != prevCand.penalty
+                || cand.preSpaceCount != prevCand.preSpaceCount
+                || cand.postSpaceCount != prevCand.postSpaceCount
+                || cand.hyphenType != prevCand.hyphenType) {
+            break;
+        }
+    }
+    return i;
+}
+
 void LineBreaker::computeBreaksOptimal(bool isRectangle) {
     size_t active = 0;
     size_t nCand = mCandidates.size();
     float width = mLineWidths.getLineWidth(0);
     float maxShrink = mJustified ? SHRINKABILITY * getSpaceWidth() : 0.0f;
 
+    // Incremental breaking is only done for constant line widths, which is what editable text
+    // uses; indents and first-line widths would also have to be compared.
+    size_t start = isRectangle ? reusableOptimalPrefix(width, maxShrink) : 1;
+    if (start > 1) {
+        std::copy(mPrevCandidates.begin() + 1, mPrevCandidates.begin() + start,
+                mCandidates.begin() + 1);
+        active = mPrevCandidates[start].active;
+    }
+#if VERBOSE_DEBUG
+    ALOGD("optimal breaking resumes at candidate %zd of %zd", start, nCand);
+#endif
+
     // "i" iterates through candidates for the end of the line.
-    for (size_t i = 1; i < nCand; i++) {
+    for (size_t i = start; i < nCand; i++) {
         bool atEnd = i == nCand - 1;
+        mCandidates[i].active = active;
         float best = SCORE_INFTY;
         size_t bestPrev = 0;
         size_t lineNumberLast = 0;
@@ -506,6 +547,17 @@ void LineBreaker::computeBreaksOptimal(bool isRectangle) {
 #endif
     }
     finishBreaksOptimal();
+
+    if (!isRectangle) {
+        mPrevCandidates.clear();
+        return;
+    }
+    mPrevCandidates = mCandidates;
+    mPrevStrategy = mStrategy;
+    mPrevJustified = mJustified;
+    mPrevLinePenalty = mLinePenalty;
+    mPrevWidth = width;
+    mPrevMaxShrink = maxShrink;
 }
 
 size_t LineBreaker::computeBreaks() {
@@ -533,6 +585,8 @@ void LineBreaker::finish() {
         mHyphBuf.clear();
         mHyphBuf.shrink_to_fit();
         mCandidates.shrink_to_fit();
+        mPrevCandidates.clear();
+        mPrevCandidates.shrink_to_fit();
         mBreaks.shrink_to_fit();
         mWidths.shrink_to_fit();
         mFlags.shrink_to_fit();
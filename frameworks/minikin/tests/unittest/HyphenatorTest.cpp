@@ -330,5 +330,39 @@ TEST_F(HyphenatorTest, startingHyphenMinus) {
     EXPECT_EQ(HyphenationType::DONT_BREAK, result[1]);
 }
 
-}  // namespace minikin
+// Hyphenating a word again, or as part of a batch, gives the same result as the first time.
+TEST_F(HyphenatorTest, cachedAndBatchHyphenation) {
+    std::vector<uint8_t> patternData = readWholeFile(usHyph);
+    Hyphenator* hyphenator = Hyphenator::loadBinary(patternData.data(), 2, 3);
+    const uint16_t text[] = {'h', 'y', 'p', 'h', 'e', 'n', ' ', 'h', 'y', 'p', 'h', 'e', 'n',
+            ' ', 'a', SOFT_HYPHEN, 'b', 'c'};
+    const std::vector<std::pair<size_t, size_t>> words = {{0, 6}, {7, 13}, {14, 18}};
+
+    std::vector<std::vector<HyphenationType>> expected;
+    std::vector<HyphenationType> result;
+    for (const auto& word : words) {
+        hyphenator->hyphenate(&result, text + word.first, word.second - word.first, usLocale);
+        expected.push_back(result);
+    }
+    EXPECT_EQ(HyphenationType::BREAK_AND_INSERT_HYPHEN, expected[0][2]);
+    EXPECT_EQ(expected[0], expected[1]);
+
+    for (size_t i = 0; i < words.size(); i++) {
+        hyphenator->hyphenate(&result, text + words[i].first,
+                words[i].second - words[i].first, usLocale);
+        EXPECT_EQ(expected[i], result);
+    }
+
+    hyphenator->hyphenateWords(&result, text, words, usLocale);
+    ASSERT_EQ(NELEM(text), result.size());
+    EXPECT_EQ(HyphenationType::DONT_BREAK, result[6]);
+    EXPECT_EQ(HyphenationType::DONT_BREAK, result[13]);
+    for (size_t i = 0; i < words.size(); i++) {
+        for (size_t j = words[i].first; j < words[i].second; j++) {
+            EXPECT_EQ(expected[i][j - words[i].first], result[j]);
+        }
+    }
+    delete hyphenator;
+}
 
+}  // namespace minikin
@@ -422,6 +422,29 @@ TEST_F(LayoutTest, hyphenationTest) {
     }
 }
 
+TEST_F(LayoutTest, measureTextWithFontFeatures) {
+    MinikinPaint paint;
+    paint.fontFeatureSettings = "\"liga\" off";
+    const size_t kMaxAdvanceLength = 32;
+    float advances[kMaxAdvanceLength];
+    std::vector<float> expectedValues;
+
+    std::vector<uint16_t> text = utf8ToUtf16("two words");
+    Layout layout;
+    layout.doLayout(text.data(), 0, text.size(), text.size(), kBidi_LTR, FontStyle(), paint,
+            mCollection);
+    EXPECT_EQ(90.0f, layout.getAdvance());
+
+    // Measuring the same text again is served by the words cached by doLayout.
+    for (int i = 0; i < 2; i++) {
+        resetAdvances(advances, kMaxAdvanceLength);
+        EXPECT_EQ(90.0f, Layout::measureText(text.data(), 0, text.size(), text.size(), kBidi_LTR,
+                FontStyle(), paint, mCollection, advances));
+        expectedValues.assign(text.size(), 10.0f);
+        expectAdvances(expectedValues, advances, kMaxAdvanceLength);
+    }
+}
+
 // TODO: Add more test cases, e.g. measure text, letter spacing.
 
 }  // namespace minikin
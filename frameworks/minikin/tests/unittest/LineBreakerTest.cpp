@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "ICUTestBase.h"
@@ -24,6 +27,24 @@ namespace minikin {
 
 typedef ICUTestBase LineBreakerTest;
 
+// Breaks ASCII text where every character is one unit wide, using the high quality strategy.
+static std::vector<int> breakOptimal(LineBreaker* lineBreaker, const std::string& text,
+        float lineWidth) {
+    lineBreaker->resize(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        lineBreaker->buffer()[i] = text[i];
+        lineBreaker->charWidths()[i] = 1.0f;
+    }
+    lineBreaker->setText();
+    lineBreaker->setLineWidths(lineWidth, 0, lineWidth);
+    lineBreaker->setStrategy(kBreakStrategy_HighQuality);
+    lineBreaker->addStyleRun(nullptr, nullptr, FontStyle(), 0, text.size(), false);
+    size_t breakCount = lineBreaker->computeBreaks();
+    std::vector<int> breaks(lineBreaker->getBreaks(), lineBreaker->getBreaks() + breakCount);
+    lineBreaker->finish();
+    return breaks;
+}
+
 TEST_F(LineBreakerTest, setLocales) {
     {
         LineBreaker lineBreaker;
@@ -82,4 +103,29 @@ TEST_F(LineBreakerTest, setLocales) {
     }
 }
 
+TEST_F(LineBreakerTest, optimalBreaksAfterEdit) {
+    const std::string text = "The quick brown fox jumps over the lazy dog and then runs far away "
+            "into the deep dark woods where nobody will ever find it again.";
+    std::vector<Hyphenator*> hyphenators;
+
+    // Breaking edited text must give the same result whether or not the previous run's state for
+    // the unchanged prefix is reused.
+    const std::vector<std::string> edits = {
+        text,
+        text + " The end.",
+        text.substr(0, 80),
+        "An" + text.substr(3),
+        text.substr(0, 40) + "extraordinarily" + text.substr(45),
+    };
+    LineBreaker incremental;
+    incremental.setLocales("en-US", hyphenators);
+    for (const std::string& edit : edits) {
+        for (float width : {20.0f, 20.0f, 33.0f}) {
+            LineBreaker fresh;
+            fresh.setLocales("en-US", hyphenators);
+            EXPECT_EQ(breakOptimal(&fresh, edit, width), breakOptimal(&incremental, edit, width));
+        }
+    }
+}
+
 }  // namespace minikin
@@ -18,22 +18,38 @@
 
 #include "CpuExecutor.h"
 
+#include "MemoryPlanner.h"
 #include "NeuralNetworks.h"
 #include "Operations.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 
 namespace android {
 namespace nn {
 
-// If we don't have a buffer, allocate it.
+// If we don't have a buffer, allocate it.  This is also the case when the
+// space planned in the arena turns out to be too small, which can happen if
+// the request changed the dimensions of the model inputs.
 static bool allocateIfNeeded(RunTimeOperandInfo* info, const Shape& shape) {
     info->type = shape.type;
     info->dimensions = shape.dimensions;
+    uint32_t length = sizeOfData(info->type, info->dimensions);
+    if (info->isInArena && info->length < length) {
+        info->buffer = nullptr;
+        info->isInArena = false;
+    }
     if (info->buffer == nullptr) {
-        uint32_t length = sizeOfData(info->type, info->dimensions);
         info->buffer = new uint8_t[length];
         if (info->buffer == nullptr) {
             return false;
         }
+        info->length = length;
+        info->ownsBuffer = true;
     }
     return true;
 }
@@ -46,27 +62,193 @@ static int32_t getInt32ScalarData(RunTimeOperandInfo& info) {
 // Ignore the .pools entry in model and request.  This will have been taken care of
 // by the caller.
 int CpuExecutor::run(const Model& model, const Request& request,
-                     const std::vector<RunTimePoolInfo>& runTimePoolInfos) {
+                     const std::vector<RunTimePoolInfo>& runTimePoolInfos,
+                     const MemoryPlan* memoryPlan,
+                     const std::vector<OperandQuantization>* quantization) {
     LOG(DEBUG) << "CpuExecutor::run()";
     LOG(DEBUG) << "model: " << toString(model);
     LOG(DEBUG) << "request: " << toString(request);
 
     mModel = &model;
     mRequest = &request; // TODO check if mRequest is needed
-    initializeRunTimeInfo(runTimePoolInfos);
+    mMemoryPlan = memoryPlan;
+    mQuantization = quantization;
+    if (mMemoryPlan != nullptr) {
+        mArena = mMemoryPlan->acquireArena();
+    }
+    int n = ANEURALNETWORKS_BAD_DATA;
+    if (initializeRunTimeInfo(runTimePoolInfos)) {
+        ThreadPool* pool = ThreadPool::get();
+        n = pool->getConcurrency() > 1 && model.operations.size() > 1 ? runInParallel(pool)
+                                                                      : runSerially();
+    }
+    // Free what's left.  This happens for temporaries that no operation
+    // consumes, and for all of them if the run failed.
+    for (auto& info : mOperands) {
+        if (info.ownsBuffer) {
+            delete[] info.buffer;
+            info.buffer = nullptr;
+            info.ownsBuffer = false;
+        }
+    }
+    if (mMemoryPlan != nullptr) {
+        mMemoryPlan->releaseArena(std::move(mArena));
+    }
+    mModel = nullptr;
+    mRequest = nullptr;
+    mMemoryPlan = nullptr;
+    mQuantization = nullptr;
+    if (n != ANEURALNETWORKS_NO_ERROR) {
+        return n;
+    }
+    LOG(DEBUG) << "Completed run normally";
+    return ANEURALNETWORKS_NO_ERROR;
+}
+
+int CpuExecutor::runSerially() {
     // The model has serialized the operation in execution order.
-    for (const auto& operation : model.operations) {
+    for (const auto& operation : mModel->operations) {
         int n = executeOperation(operation);
         if (n != ANEURALNETWORKS_NO_ERROR) {
             return n;
         }
     }
-    mModel = nullptr;
-    mRequest = nullptr;
-    LOG(DEBUG) << "Completed run normally";
     return ANEURALNETWORKS_NO_ERROR;
 }
 
+// Book keeping for one parallel run of the graph.  It is shared with the
+// tasks queued on the thread pool, as those may only get to run after
+// runInParallel() has returned.  Such late tasks find no work and exit
+// without touching the executor.
+struct GraphRunState {
+    CpuExecutor* executor;
+    ThreadPool* pool;
+    std::mutex mutex;
+    std::condition_variable changed;
+    // Operations whose inputs are all available, waiting for a thread.
+    std::vector<uint32_t> ready;
+    // For each operation, the number of its inputs not computed yet.
+    std::vector<uint32_t> pendingInputs;
+    // For each operand, the operations that consume it.  Only filled for
+    // operands that are the output of an operation.
+    std::vector<std::vector<uint32_t>> consumers;
+    // For each operation, the operations that will reuse the arena memory
+    // it uses, and so can only start once it's done.
+    std::vector<std::vector<uint32_t>> memoryDependents;
+    // Number of operations currently being executed.
+    uint32_t running = 0;
+    // Number of operations that have not completed yet.
+    size_t remaining = 0;
+    int result = ANEURALNETWORKS_NO_ERROR;
+
+    // Must be called with mutex held.
+    bool canRunMore() const { return !ready.empty() && result == ANEURALNETWORKS_NO_ERROR; }
+    bool isDone() const { return running == 0 && !canRunMore(); }
+};
+
+int CpuExecutor::runInParallel(ThreadPool* pool) {
+    const auto& operations = mModel->operations;
+    auto state = std::make_shared<GraphRunState>();
+    state->executor = this;
+    state->pool = pool;
+    state->pendingInputs.resize(operations.size(), 0);
+    state->consumers.resize(mModel->operands.size());
+    state->memoryDependents.resize(operations.size());
+    state->remaining = operations.size();
+
+    // An operand only gates an operation if another operation produces it.
+    // Constants and model inputs are available from the start.
+    std::vector<bool> isProduced(mModel->operands.size(), false);
+    for (const auto& operation : operations) {
+        for (uint32_t i : operation.outputs) {
+            isProduced[i] = true;
+        }
+    }
+    for (uint32_t opIndex = 0; opIndex < operations.size(); opIndex++) {
+        for (uint32_t i : operations[opIndex].inputs) {
+            if (isProduced[i]) {
+                state->pendingInputs[opIndex]++;
+                state->consumers[i].push_back(opIndex);
+            }
+        }
+        if (mMemoryPlan != nullptr) {
+            for (uint32_t dependency : mMemoryPlan->getMemoryDependencies(opIndex)) {
+                state->pendingInputs[opIndex]++;
+                state->memoryDependents[dependency].push_back(opIndex);
+            }
+        }
+        if (state->pendingInputs[opIndex] == 0) {
+            state->ready.push_back(opIndex);
+        }
+    }
+    // ready is used as a stack.  Reverse it so that operations that are
+    // ready together start in their serialized order.
+    std::reverse(state->ready.begin(), state->ready.end());
+    // The helpers start running as soon as they are scheduled.
+    const size_t initiallyReady = state->ready.size();
+    for (size_t i = 1; i < initiallyReady; i++) {
+        pool->schedule([state] { drainReadyOperations(state); });
+    }
+
+    // The calling thread takes part in the work, then waits for the
+    // operations still running elsewhere.
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (!state->isDone()) {
+        if (state->canRunMore()) {
+            lock.unlock();
+            drainReadyOperations(state);
+            lock.lock();
+        } else {
+            state->changed.wait(lock);
+        }
+    }
+    if (state->result == ANEURALNETWORKS_NO_ERROR && state->remaining > 0) {
+        LOG(ERROR) << state->remaining << " operations never had all their inputs available";
+        return ANEURALNETWORKS_BAD_DATA;
+    }
+    return state->result;
+}
+
+// Runs ready operations until none are left.  Of the operations made ready by
+// the one that just completed, this thread keeps one for itself, as its inputs
+// are likely still in cache, and hands out the others to the pool.
+void CpuExecutor::drainReadyOperations(const std::shared_ptr<GraphRunState>& state) {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (state->canRunMore()) {
+        const uint32_t opIndex = state->ready.back();
+        state->ready.pop_back();
+        state->running++;
+        lock.unlock();
+        const Operation& operation = state->executor->mModel->operations[opIndex];
+        int n = state->executor->executeOperation(operation);
+        lock.lock();
+        state->running--;
+        state->remaining--;
+        if (n != ANEURALNETWORKS_NO_ERROR) {
+            state->result = n;
+            break;
+        }
+        const size_t firstNewlyReady = state->ready.size();
+        for (uint32_t i : operation.outputs) {
+            for (uint32_t consumer : state->consumers[i]) {
+                if (--state->pendingInputs[consumer] == 0) {
+                    state->ready.push_back(consumer);
+                }
+            }
+        }
+        for (uint32_t dependent : state->memoryDependents[opIndex]) {
+            if (--state->pendingInputs[dependent] == 0) {
+                state->ready.push_back(dependent);
+            }
+        }
+        for (size_t i = firstNewlyReady + 1; i < state->ready.size(); i++) {
+            state->pool->schedule([state] { drainReadyOperations(state); });
+        }
+        state->changed.notify_all();
+    }
+    state->changed.notify_all();
+}
+
 bool CpuExecutor::initializeRunTimeInfo(const std::vector<RunTimePoolInfo>& runTimePoolInfos) {
     LOG(DEBUG) << "CpuExecutor::initializeRunTimeInfo";
     const size_t count = mModel->operands.size();
@@ -78,6 +260,13 @@ bool CpuExecutor::initializeRunTimeInfo(const std::vector<RunTimePoolInfo>& runT
             return false;
         }
         mOperands[i].type = from.type;
+        if (mQuantization != nullptr && i < mQuantization->size()) {
+            mOperands[i].scale = (*mQuantization)[i].scale;
+            mOperands[i].offset = (*mQuantization)[i].offset;
+        } else {
+            mOperands[i].scale = 0.f;
+            mOperands[i].offset = 0;
+        }
     }
 
     nnAssert(mModel->inputIndexes.size() == mRequest->inputs.size());
@@ -110,8 +299,20 @@ bool CpuExecutor::setRunTimeOperandInfo(uint32_t operandIndex,
     if (dimensions.size() > 0) {
         to.dimensions = dimensions;
     }
+    to.length = location.length;
+    to.isInArena = false;
+    to.ownsBuffer = false;
     if (location.poolIndex == static_cast<uint32_t>(LocationValues::LOCATION_AT_RUN_TIME)) {
-        to.buffer = nullptr;
+        const uint32_t offset =
+                mMemoryPlan != nullptr ? mMemoryPlan->getOffset(operandIndex)
+                                       : MemoryPlan::kNotInArena;
+        if (offset != MemoryPlan::kNotInArena) {
+            to.buffer = mArena.get() + offset;
+            to.length = mMemoryPlan->getSize(operandIndex);
+            to.isInArena = true;
+        } else {
+            to.buffer = nullptr;
+        }
         to.numberOfUsesLeft = useCount;
     } else if (location.poolIndex == static_cast<uint32_t>(LocationValues::LOCATION_SAME_BLOCK)) {
         to.buffer = const_cast<uint8_t*>(&mModel->operandValues[location.offset]);
@@ -126,11 +327,12 @@ bool CpuExecutor::setRunTimeOperandInfo(uint32_t operandIndex,
         to.buffer = r.buffer + location.offset;
         to.numberOfUsesLeft = 0;
     }
-    to.length = location.length;
     return true;
 }
 
 void CpuExecutor::freeNoLongerUsedOperands(const std::vector<uint32_t>& inputs) {
+    // Operations sharing an input may complete on different threads.
+    std::lock_guard<std::mutex> lock(mUseCountMutex);
     for (uint32_t i : inputs) {
         auto& info = mOperands[i];
         // Check if it's a static or model input/output.
@@ -142,7 +344,10 @@ void CpuExecutor::freeNoLongerUsedOperands(const std::vector<uint32_t>& inputs)
         info.numberOfUsesLeft--;
         if (info.numberOfUsesLeft == 0) {
             nnAssert(info.buffer != nullptr);
-            delete[] info.buffer;
+            if (info.ownsBuffer) {
+                delete[] info.buffer;
+                info.ownsBuffer = false;
+            }
             info.buffer = nullptr;
         }
     }
@@ -153,6 +358,9 @@ int CpuExecutor::executeOperation(const Operation& operation) {
     const auto& ins = operation.inputs;
     const auto& outs = operation.outputs;
     bool success = false;
+    const bool profiling = Profiler::get()->isEnabled();
+    const auto start = profiling ? std::chrono::steady_clock::now()
+                                 : std::chrono::steady_clock::time_point();
 
     // Function to verify that the number of input and output parameters
     // matches what is expected.
@@ -177,6 +385,16 @@ int CpuExecutor::executeOperation(const Operation& operation) {
             RunTimeOperandInfo& out = mOperands[outs[0]];
             Shape outShape = out.shape();
 
+            if (in1.type == OperandType::TENSOR_SYMMETRICAL_QUANT8) {
+                success = addTensorsFloat32Prepare(in1.shape(), in2.shape(), &outShape) &&
+                        allocateIfNeeded(&out, outShape) &&
+                        addTensorsQuant8(reinterpret_cast<const uint8_t*>(in1.buffer),
+                                         in1.shape(),
+                                         reinterpret_cast<const uint8_t*>(in2.buffer),
+                                         in2.shape(),
+                                         reinterpret_cast<uint8_t*>(out.buffer), outShape);
+                break;
+            }
             success = addTensorsFloat32Prepare(in1.shape(), in2.shape(), &outShape) &&
                     allocateIfNeeded(&out, outShape) &&
                     addTensorsFloat32(reinterpret_cast<const float*>(in1.buffer),
@@ -200,6 +418,24 @@ int CpuExecutor::executeOperation(const Operation& operation) {
             RunTimeOperandInfo& output = mOperands[outs[0]];
             Shape outShape = output.shape();
 
+            if (input.type == OperandType::TENSOR_SYMMETRICAL_QUANT8) {
+                success = depthwiseConvFloat32Prepare(input.shape(), filter.shape(),
+                                                      bias.shape(),
+                                                      padding, stride_width, stride_height,
+                                                      &outShape) &&
+                          allocateIfNeeded(&output, outShape) &&
+                          depthwiseConvQuant8(reinterpret_cast<const uint8_t*>(input.buffer),
+                                              input.shape(),
+                                              reinterpret_cast<const uint8_t*>(filter.buffer),
+                                              filter.shape(),
+                                              reinterpret_cast<const int32_t*>(bias.buffer),
+                                              bias.shape(),
+                                              padding, stride_width, stride_height,
+                                              depth_multiplier, activation,
+                                              reinterpret_cast<uint8_t*>(output.buffer),
+                                              outShape);
+                break;
+            }
             success = depthwiseConvFloat32Prepare(input.shape(), filter.shape(), bias.shape(),
                                                   padding, stride_width, stride_height,
                                                   &outShape) &&
@@ -232,6 +468,20 @@ int CpuExecutor::executeOperation(const Operation& operation) {
             RunTimeOperandInfo& output = mOperands[outs[0]];
             Shape outShape = output.shape();
 
+            if (input.type == OperandType::TENSOR_SYMMETRICAL_QUANT8) {
+                success = convFloat32Prepare(input.shape(), filter.shape(), bias.shape(),
+                                             padding, stride_width, stride_height,
+                                             &outShape) &&
+                          allocateIfNeeded(&output, outShape) &&
+                          convQuant8(reinterpret_cast<const uint8_t*>(input.buffer),
+                                     input.shape(),
+                                     reinterpret_cast<const uint8_t*>(filter.buffer),
+                                     filter.shape(),
+                                     reinterpret_cast<const int32_t*>(bias.buffer), bias.shape(),
+                                     padding, stride_width, stride_height, activation,
+                                     reinterpret_cast<uint8_t*>(output.buffer), outShape);
+                break;
+            }
             success = convFloat32Prepare(input.shape(), filter.shape(), bias.shape(),
                                          padding, stride_width, stride_height,
                                          &outShape) &&
@@ -259,6 +509,20 @@ int CpuExecutor::executeOperation(const Operation& operation) {
             RunTimeOperandInfo& output = mOperands[outs[0]];
             Shape outShape = output.shape();
 
+            if (input.type == OperandType::TENSOR_SYMMETRICAL_QUANT8) {
+                success = genericPoolingFloat32Prepare(input.shape(),
+                                                       padding, stride_width, stride_height,
+                                                       filter_width, filter_height,
+                                                       &outShape) &&
+                          allocateIfNeeded(&output, outShape) &&
+                          averagePoolQuant8(reinterpret_cast<const uint8_t*>(input.buffer),
+                                            input.shape(),
+                                            padding, stride_width, stride_height,
+                                            filter_width, filter_height, activation,
+                                            reinterpret_cast<uint8_t*>(output.buffer),
+                                            outShape);
+                break;
+            }
             success = genericPoolingFloat32Prepare(input.shape(),
                                                    padding, stride_width, stride_height,
                                                    filter_width, filter_height,
@@ -313,6 +577,20 @@ int CpuExecutor::executeOperation(const Operation& operation) {
             RunTimeOperandInfo& output = mOperands[outs[0]];
             Shape outShape = output.shape();
 
+            if (input.type == OperandType::TENSOR_SYMMETRICAL_QUANT8) {
+                success = genericPoolingFloat32Prepare(input.shape(),
+                                                       padding, stride_width, stride_height,
+                                                       filter_width, filter_height,
+                                                       &outShape) &&
+                          allocateIfNeeded(&output, outShape) &&
+                          maxPoolQuant8(reinterpret_cast<const uint8_t*>(input.buffer),
+                                        input.shape(),
+                                        padding, stride_width, stride_height,
+                                        filter_width, filter_height, activation,
+                                        reinterpret_cast<uint8_t*>(output.buffer),
+                                        outShape);
+                break;
+            }
             success = genericPoolingFloat32Prepare(input.shape(),
                                                    padding, stride_width, stride_height,
                                                    filter_width, filter_height,
@@ -332,6 +610,14 @@ int CpuExecutor::executeOperation(const Operation& operation) {
             RunTimeOperandInfo& output = mOperands[outs[0]];
             Shape outShape = output.shape();
 
+            if (input.type == OperandType::TENSOR_SYMMETRICAL_QUANT8) {
+                success = genericActivationFloat32Prepare(input.shape(), &outShape) &&
+                          allocateIfNeeded(&output, outShape) &&
+                          reluQuant8(reinterpret_cast<const uint8_t*>(input.buffer),
+                                     input.shape(),
+                                     reinterpret_cast<uint8_t*>(output.buffer), outShape);
+                break;
+            }
             success = genericActivationFloat32Prepare(input.shape(), &outShape) &&
                       allocateIfNeeded(&output, outShape) &&
                       reluFloat32(reinterpret_cast<const float*>(input.buffer), input.shape(),
@@ -345,6 +631,14 @@ int CpuExecutor::executeOperation(const Operation& operation) {
             RunTimeOperandInfo& output = mOperands[outs[0]];
             Shape outShape = output.shape();
 
+            if (input.type == OperandType::TENSOR_SYMMETRICAL_QUANT8) {
+                success = genericActivationFloat32Prepare(input.shape(), &outShape) &&
+                          allocateIfNeeded(&output, outShape) &&
+                          relu6Quant8(reinterpret_cast<const uint8_t*>(input.buffer),
+                                      input.shape(),
+                                      reinterpret_cast<uint8_t*>(output.buffer), outShape);
+                break;
+            }
             success = genericActivationFloat32Prepare(input.shape(), &outShape) &&
                       allocateIfNeeded(&output, outShape) &&
                       relu6Float32(reinterpret_cast<const float*>(input.buffer), input.shape(),
@@ -371,6 +665,14 @@ int CpuExecutor::executeOperation(const Operation& operation) {
             RunTimeOperandInfo& output = mOperands[outs[0]];
             Shape outShape = output.shape();
 
+            if (input.type == OperandType::TENSOR_SYMMETRICAL_QUANT8) {
+                success = genericActivationFloat32Prepare(input.shape(), &outShape) &&
+                          allocateIfNeeded(&output, outShape) &&
+                          logisticQuant8(reinterpret_cast<const uint8_t*>(input.buffer),
+                                         input.shape(),
+                                         reinterpret_cast<uint8_t*>(output.buffer), outShape);
+                break;
+            }
             success = genericActivationFloat32Prepare(input.shape(), &outShape) &&
                       allocateIfNeeded(&output, outShape) &&
                       logisticFloat32(reinterpret_cast<const float*>(input.buffer), input.shape(),
@@ -385,6 +687,22 @@ int CpuExecutor::executeOperation(const Operation& operation) {
         return ANEURALNETWORKS_OP_FAILED;
     }
 
+    if (profiling) {
+        uint64_t bytesTouched = 0;
+        for (uint32_t i : ins) {
+            bytesTouched += mOperands[i].length;
+        }
+        for (uint32_t i : outs) {
+            bytesTouched += mOperands[i].length;
+        }
+        Profiler::get()->record({.device = "cpu",
+                                 .operationIndex =
+                                         static_cast<int32_t>(&operation - &mModel->operations[0]),
+                                 .operationType = operation.type,
+                                 .durationNs = Profiler::nanosecondsSince(start),
+                                 .bytesTouched = bytesTouched});
+    }
+
     freeNoLongerUsedOperands(ins);
     return ANEURALNETWORKS_NO_ERROR;
 }
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MemoryPlanner"
+
+#include "MemoryPlanner.h"
+
+#include "Utils.h"
+
+#include <algorithm>
+
+namespace android {
+namespace nn {
+
+namespace {
+
+// Alignment of each operand in the arena, so that kernels can use aligned
+// vector loads.
+const uint32_t kArenaAlignment = 16;
+
+// The lifetime of a temporary, as indexes of operations in execution order.
+// Both ends are included: an operation reads its inputs while writing its
+// outputs, so they can't share memory.
+struct Lifetime {
+    uint32_t operand;
+    uint32_t size;
+    uint32_t first;
+    uint32_t last;
+    // Operations that read or write the operand.
+    std::vector<uint32_t> users;
+};
+
+bool overlaps(const Lifetime& a, const Lifetime& b) {
+    return a.first <= b.last && b.first <= a.last;
+}
+
+}  // namespace
+
+void MemoryPlan::initialize(const Model& model) {
+    const size_t operandCount = model.operands.size();
+    const size_t operationCount = model.operations.size();
+    mOffsets.assign(operandCount, kNotInArena);
+    mSizes.assign(operandCount, 0);
+    mArenaSize = 0;
+    mMemoryDependencies.assign(operationCount, {});
+
+    // The model inputs and outputs live in the pools of the request.
+    std::vector<bool> isModelInputOrOutput(operandCount, false);
+    for (uint32_t i : model.inputIndexes) {
+        isModelInputOrOutput[i] = true;
+    }
+    for (uint32_t i : model.outputIndexes) {
+        isModelInputOrOutput[i] = true;
+    }
+
+    std::vector<int32_t> lifetimeIndex(operandCount, -1);
+    std::vector<Lifetime> lifetimes;
+    for (uint32_t opIndex = 0; opIndex < operationCount; opIndex++) {
+        const Operation& operation = model.operations[opIndex];
+        for (uint32_t i : operation.outputs) {
+            const Operand& operand = model.operands[i];
+            if (isModelInputOrOutput[i] ||
+                operand.location.poolIndex !=
+                        static_cast<uint32_t>(LocationValues::LOCATION_AT_RUN_TIME)) {
+                continue;
+            }
+            uint32_t size = sizeOfData(operand.type, operand.dimensions);
+            if (size == 0 || lifetimeIndex[i] != -1) {
+                // The dimensions will only be known at run time.
+                continue;
+            }
+            lifetimeIndex[i] = static_cast<int32_t>(lifetimes.size());
+            lifetimes.push_back({.operand = i,
+                                 .size = size,
+                                 .first = opIndex,
+                                 .last = opIndex,
+                                 .users = {opIndex}});
+        }
+        for (uint32_t i : operation.inputs) {
+            if (lifetimeIndex[i] != -1) {
+                Lifetime& lifetime = lifetimes[lifetimeIndex[i]];
+                lifetime.last = opIndex;
+                lifetime.users.push_back(opIndex);
+            }
+        }
+    }
+
+    // Place the biggest temporaries first, each at the lowest offset that
+    // doesn't collide with a temporary already placed that is alive at the
+    // same time.  This greedy by size placement is close to optimal on the
+    // mostly linear graphs we see in practice.
+    std::vector<uint32_t> order(lifetimes.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&lifetimes](uint32_t a, uint32_t b) {
+        return lifetimes[a].size > lifetimes[b].size;
+    });
+    std::vector<uint32_t> placed;
+    for (uint32_t index : order) {
+        const Lifetime& lifetime = lifetimes[index];
+        const uint32_t alignedSize =
+                (lifetime.size + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+        // The placed temporaries that are alive at the same time, by offset.
+        std::vector<uint32_t> conflicts;
+        for (uint32_t other : placed) {
+            if (overlaps(lifetime, lifetimes[other])) {
+                conflicts.push_back(other);
+            }
+        }
+        std::sort(conflicts.begin(), conflicts.end(), [this, &lifetimes](uint32_t a, uint32_t b) {
+            return mOffsets[lifetimes[a].operand] < mOffsets[lifetimes[b].operand];
+        });
+        uint32_t offset = 0;
+        for (uint32_t other : conflicts) {
+            const uint32_t otherOffset = mOffsets[lifetimes[other].operand];
+            if (otherOffset >= offset + alignedSize) {
+                break;
+            }
+            offset = std::max(offset, otherOffset + mSizes[lifetimes[other].operand]);
+        }
+        mOffsets[lifetime.operand] = offset;
+        mSizes[lifetime.operand] = alignedSize;
+        mArenaSize = std::max(mArenaSize, offset + alignedSize);
+        placed.push_back(index);
+    }
+
+    // When a temporary reuses the memory of an earlier one, it must not be
+    // written before all the users of the earlier one are done.
+    for (const Lifetime& later : lifetimes) {
+        const uint32_t laterOffset = mOffsets[later.operand];
+        const uint32_t laterEnd = laterOffset + mSizes[later.operand];
+        std::vector<uint32_t>& dependencies = mMemoryDependencies[later.first];
+        for (const Lifetime& earlier : lifetimes) {
+            const uint32_t earlierOffset = mOffsets[earlier.operand];
+            const uint32_t earlierEnd = earlierOffset + mSizes[earlier.operand];
+            if (earlier.last >= later.first || earlierEnd <= laterOffset ||
+                laterEnd <= earlierOffset) {
+                continue;
+            }
+            dependencies.insert(dependencies.end(), earlier.users.begin(), earlier.users.end());
+        }
+        std::sort(dependencies.begin(), dependencies.end());
+        dependencies.erase(std::unique(dependencies.begin(), dependencies.end()),
+                           dependencies.end());
+    }
+
+    LOG(DEBUG) << "MemoryPlan: " << lifetimes.size() << " temporaries in an arena of "
+               << mArenaSize << " bytes";
+}
+
+const std::vector<uint32_t>& MemoryPlan::getMemoryDependencies(uint32_t operationIndex) const {
+    static const std::vector<uint32_t> kNone;
+    return operationIndex < mMemoryDependencies.size() ? mMemoryDependencies[operationIndex]
+                                                       : kNone;
+}
+
+std::unique_ptr<uint8_t[]> MemoryPlan::acquireArena() const {
+    {
+        std::lock_guard<std::mutex> lock(mFreeArenasMutex);
+        if (!mFreeArenas.empty()) {
+            std::unique_ptr<uint8_t[]> arena = std::move(mFreeArenas.back());
+            mFreeArenas.pop_back();
+            return arena;
+        }
+    }
+    return std::unique_ptr<uint8_t[]>(new uint8_t[mArenaSize]);
+}
+
+void MemoryPlan::releaseArena(std::unique_ptr<uint8_t[]> arena) const {
+    std::lock_guard<std::mutex> lock(mFreeArenasMutex);
+    mFreeArenas.push_back(std::move(arena));
+}
+
+} // namespace nn
+} // namespace android
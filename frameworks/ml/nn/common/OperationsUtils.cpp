@@ -17,8 +17,14 @@
 #define LOG_TAG "OperationsUtils"
 
 #include "OperationsUtils.h"
+#include "Operations.h"
+#include "ThreadPool.h"
 #include "Utils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace android {
 namespace nn {
 
@@ -62,5 +68,129 @@ uint32_t getSizeOfDimension(const Shape& shape, uint32_t dimensionIdx) {
     return shape.dimensions[dimensionIdx];
 }
 
+bool SameQuantization(const Shape& in1, const Shape& in2) {
+    return in1.scale == in2.scale && in1.offset == in2.offset;
+}
+
+bool QuantizeMultiplierSmallerThanOne(double realMultiplier, int32_t* quantizedMultiplier,
+                                      int32_t* rightShift) {
+    if (realMultiplier < 0. || realMultiplier >= 1.) {
+        LOG(ERROR) << "Multiplier " << realMultiplier << " is not in [0, 1)";
+        return false;
+    }
+    if (realMultiplier == 0.) {
+        *quantizedMultiplier = 0;
+        *rightShift = 0;
+        return true;
+    }
+    *rightShift = 0;
+    while (realMultiplier < .5) {
+        realMultiplier *= 2.;
+        (*rightShift)++;
+    }
+    int64_t q = static_cast<int64_t>(std::round(realMultiplier * (1ll << 31)));
+    // Rounding can bring us up to exactly 2^31.
+    if (q == (1ll << 31)) {
+        q /= 2;
+        (*rightShift)--;
+    }
+    if (*rightShift < 0 || q > std::numeric_limits<int32_t>::max()) {
+        return false;
+    }
+    *quantizedMultiplier = static_cast<int32_t>(q);
+    return true;
+}
+
+bool QuantizeMultiplierGreaterThanOne(double realMultiplier, int32_t* quantizedMultiplier,
+                                      int* leftShift) {
+    if (realMultiplier <= 1.) {
+        LOG(ERROR) << "Multiplier " << realMultiplier << " is not greater than 1";
+        return false;
+    }
+    *leftShift = 0;
+    while (realMultiplier >= 1.) {
+        realMultiplier /= 2.;
+        (*leftShift)++;
+    }
+    int64_t q = static_cast<int64_t>(std::round(realMultiplier * (1ll << 31)));
+    if (q == (1ll << 31)) {
+        q /= 2;
+        (*leftShift)++;
+    }
+    if (q > std::numeric_limits<int32_t>::max()) {
+        return false;
+    }
+    *quantizedMultiplier = static_cast<int32_t>(q);
+    return true;
+}
+
+bool GetQuantizedConvolutionMultipler(const Shape& inputShape, const Shape& filterShape,
+                                      const Shape& outputShape, double* multiplier) {
+    if (inputShape.scale <= 0.f || filterShape.scale <= 0.f || outputShape.scale <= 0.f) {
+        LOG(ERROR) << "Quantized operands need a positive scale";
+        return false;
+    }
+    *multiplier = static_cast<double>(inputShape.scale) * filterShape.scale / outputShape.scale;
+    if (*multiplier >= 1.) {
+        LOG(ERROR) << "Convolution multiplier " << *multiplier << " is not below 1";
+        return false;
+    }
+    return true;
+}
+
+void CalculateActivationRangeUint8(int32_t activation, const Shape& outputShape,
+                                   int32_t* actMin, int32_t* actMax) {
+    const int32_t qmin = std::numeric_limits<uint8_t>::min();
+    const int32_t qmax = std::numeric_limits<uint8_t>::max();
+    auto quantize = [&outputShape](float f) {
+        return outputShape.offset + static_cast<int32_t>(std::round(f / outputShape.scale));
+    };
+    if (activation == kActivationRelu) {
+        *actMin = std::max(qmin, quantize(0.f));
+        *actMax = qmax;
+    } else if (activation == kActivationRelu6) {
+        *actMin = std::max(qmin, quantize(0.f));
+        *actMax = std::min(qmax, quantize(6.f));
+    } else {
+        *actMin = qmin;
+        *actMax = qmax;
+    }
+}
+
+int32_t CalculateInputRadius(int inputIntegerBits, int inputLeftShift) {
+    const double maxInputRescaled = 1.0 * ((1 << inputIntegerBits) - 1) *
+            (1ll << (31 - inputIntegerBits)) / (1ll << inputLeftShift);
+    // Tighten the bound using floor so that an input at the radius doesn't
+    // overflow once rescaled.
+    return static_cast<int32_t>(std::floor(maxInputRescaled));
+}
+
+uint32_t computeNumberOfTiles(uint64_t totalMacs, uint32_t maxTiles) {
+    const uint32_t concurrency = ThreadPool::get()->getConcurrency();
+    if (concurrency <= 1 || totalMacs < 2 * kMinMacsPerTile) {
+        return 1;
+    }
+    // Twice as many tiles as threads, so that a thread that is late to
+    // start, e.g. because it was running another operation, doesn't hold
+    // up the whole operation.
+    uint64_t tiles = std::min<uint64_t>(2 * concurrency, totalMacs / kMinMacsPerTile);
+    return static_cast<uint32_t>(std::max<uint64_t>(1, std::min<uint64_t>(tiles, maxTiles)));
+}
+
+std::vector<RowTile> splitIntoRowTiles(uint32_t batches, uint32_t height, uint32_t numTiles) {
+    std::vector<RowTile> tiles;
+    if (batches == 0 || height == 0) {
+        return tiles;
+    }
+    const uint32_t tilesPerBatch = std::min(height, std::max(1u, numTiles / batches));
+    const uint32_t rowsPerTile = (height + tilesPerBatch - 1) / tilesPerBatch;
+    for (uint32_t b = 0; b < batches; b++) {
+        for (uint32_t row = 0; row < height; row += rowsPerTile) {
+            tiles.push_back({b, row, std::min(rowsPerTile, height - row)});
+        }
+    }
+    return tiles;
+}
+
 } // namespace nn
 } // namespace android
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Profiler"
+
+#include "Profiler.h"
+
+#include <utility>
+
+namespace android {
+namespace nn {
+
+Profiler* Profiler::get() {
+    static Profiler profiler;
+    return &profiler;
+}
+
+void Profiler::record(ProfileEntry entry) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.push_back(std::move(entry));
+}
+
+std::vector<ProfileEntry> Profiler::takeEntries() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<ProfileEntry> entries;
+    entries.swap(mEntries);
+    return entries;
+}
+
+} // namespace nn
+} // namespace android
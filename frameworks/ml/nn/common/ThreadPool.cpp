@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "ThreadPool"
+
+#include "ThreadPool.h"
+
+#include <android-base/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace android {
+namespace nn {
+
+ThreadPool::ThreadPool(uint32_t numThreads) {
+    mWorkers.reserve(numThreads);
+    for (uint32_t i = 0; i < numThreads; i++) {
+        mWorkers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mCondition.notify_all();
+    for (auto& worker : mWorkers) {
+        worker.join();
+    }
+}
+
+ThreadPool* ThreadPool::get() {
+    // The calling thread participates, so one less worker than cores.
+    static ThreadPool* pool = new ThreadPool(
+            std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+void ThreadPool::schedule(std::function<void()> task) {
+    if (mWorkers.empty()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.push_back(std::move(task));
+    }
+    mCondition.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mStopping || !mTasks.empty(); });
+            if (mStopping && mTasks.empty()) {
+                return;
+            }
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+        task();
+    }
+}
+
+namespace {
+
+// State shared between the caller of forEach() and the helpers it scheduled.
+// Helpers that only get to run after all the indexes have been claimed find
+// no work left, so the state must outlive the forEach() call.
+struct ForEachState {
+    ForEachState(uint32_t count, const std::function<void(uint32_t)>& fn)
+        : count(count), fn(fn) {}
+    const uint32_t count;
+    const std::function<void(uint32_t)> fn;
+    std::atomic<uint32_t> next{0};
+    std::mutex mutex;
+    std::condition_variable done;
+    uint32_t completed = 0;
+
+    void runUntilExhausted() {
+        uint32_t ran = 0;
+        for (uint32_t i = next++; i < count; i = next++) {
+            fn(i);
+            ran++;
+        }
+        if (ran > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            completed += ran;
+            if (completed == count) {
+                done.notify_all();
+            }
+        }
+    }
+};
+
+}  // namespace
+
+void ThreadPool::forEach(uint32_t count, const std::function<void(uint32_t)>& fn,
+                         uint32_t maxThreads) {
+    if (count == 0) {
+        return;
+    }
+    uint32_t threads = std::min(count, getConcurrency());
+    if (maxThreads > 0) {
+        threads = std::min(threads, maxThreads);
+    }
+    if (threads <= 1) {
+        for (uint32_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    auto state = std::make_shared<ForEachState>(count, fn);
+    for (uint32_t i = 1; i < threads; i++) {
+        schedule([state] { state->runUntilExhausted(); });
+    }
+    state->runUntilExhausted();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state] { return state->completed == state->count; });
+}
+
+} // namespace nn
+} // namespace android
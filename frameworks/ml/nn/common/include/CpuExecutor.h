@@ -21,11 +21,17 @@
 #include "OperationsUtils.h"
 #include "Utils.h"
 
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace android {
 namespace nn {
 
+class MemoryPlan;
+class ThreadPool;
+struct GraphRunState;
+
 // Information we maintain about each operand during execution that
 // may change during execution.
 struct RunTimeOperandInfo {
@@ -47,10 +53,19 @@ struct RunTimeOperandInfo {
     // we free the buffer.  For non-temporary variables, this count is
     // always 0.
     uint32_t numberOfUsesLeft;
+    // Whether the buffer of this temporary is in the arena of the MemoryPlan.
+    bool isInArena = false;
+    // Whether the buffer was allocated by the executor and must be freed.
+    bool ownsBuffer = false;
+    // How to map the values of a quantized tensor back to real numbers.
+    float scale = 0.f;
+    int32_t offset = 0;
 
     Shape shape() const {
         return Shape{.type = type,
-                     .dimensions = dimensions};
+                     .dimensions = dimensions,
+                     .scale = scale,
+                     .offset = offset};
     }
 };
 
@@ -66,11 +81,27 @@ public:
     // specified in the constructor.
     // The model must outlive the executor.  We prevent it from being modified
     // while this is executing.
+    // Operations that don't depend on each other may run concurrently on
+    // the threads of the shared ThreadPool.
+    // If memoryPlan is provided, it must have been initialized from the same
+    // model.  The temporaries are then placed in one of its arenas rather
+    // than allocated one by one.
+    // The model can't describe the quantization of its operands.  If
+    // quantization is provided, it has one entry per operand of the model;
+    // otherwise quantized operations fail.
     int run(const Model& model, const Request& request,
-            const std::vector<RunTimePoolInfo>& runTimePoolInfos);
+            const std::vector<RunTimePoolInfo>& runTimePoolInfos,
+            const MemoryPlan* memoryPlan = nullptr,
+            const std::vector<OperandQuantization>* quantization = nullptr);
 
 private:
     bool initializeRunTimeInfo(const std::vector<RunTimePoolInfo>& runTimePoolInfos);
+    // Runs the operations one after the other, in the order of the model.
+    int runSerially();
+    // Runs each operation as soon as all its inputs have been computed,
+    // dispatching independent operations to the pool.
+    int runInParallel(ThreadPool* pool);
+    static void drainReadyOperations(const std::shared_ptr<GraphRunState>& state);
     // Runs one operation of the graph.
     int executeOperation(const Operation& entry);
     // Decrement the usage count for the operands listed.  Frees the memory
@@ -90,6 +121,13 @@ private:
     // is being executed.
     const Model* mModel = nullptr;
     const Request* mRequest = nullptr;
+    // The plan for the temporaries and the arena they live in, if any.  Only
+    // valid while run() is being executed.
+    const MemoryPlan* mMemoryPlan = nullptr;
+    std::unique_ptr<uint8_t[]> mArena;
+    // The quantization of the operands, if any.  Only valid while run() is
+    // being executed.
+    const std::vector<OperandQuantization>* mQuantization = nullptr;
 
     // We're copying the list of all the dimensions from the model, as
     // these may be modified when we run the operatins.  Since we're
@@ -98,6 +136,8 @@ private:
     //    std::vector<uint32_t> mDimensions;
     // Runtime information about all the operands.
     std::vector<RunTimeOperandInfo> mOperands;
+    // Protects the numberOfUsesLeft counts of mOperands.
+    std::mutex mUseCountMutex;
 };
 
 } // namespace nn
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_ML_NN_COMMON_MEMORY_PLANNER_H
+#define ANDROID_ML_NN_COMMON_MEMORY_PLANNER_H
+
+#include "HalInterfaces.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace android {
+namespace nn {
+
+// Describes where the temporary operands of a model live during execution.
+//
+// Rather than allocating each temporary when it's computed and freeing it
+// after its last use, all the temporaries are packed in one arena.  Two
+// temporaries whose lifetimes don't overlap in the serialized order of the
+// operations may share the same bytes.  The plan is computed once per model
+// and the arenas are recycled across executions.
+class MemoryPlan {
+public:
+    // Offset of the operands that are not in the arena.
+    static constexpr uint32_t kNotInArena = 0xFFFFFFFF;
+
+    // Computes the plan for the model.  The operations of the model must be
+    // in execution order.  Temporaries whose size is not known until run
+    // time are left out of the arena.
+    void initialize(const Model& model);
+
+    // Returns the offset in the arena of the operand, or kNotInArena.
+    uint32_t getOffset(uint32_t operandIndex) const {
+        return operandIndex < mOffsets.size() ? mOffsets[operandIndex] : kNotInArena;
+    }
+    // Returns the number of bytes reserved for the operand in the arena.
+    uint32_t getSize(uint32_t operandIndex) const {
+        return operandIndex < mSizes.size() ? mSizes[operandIndex] : 0;
+    }
+    uint32_t getArenaSize() const { return mArenaSize; }
+
+    // Operations that must have completed before the operation can start,
+    // because its outputs reuse memory they read or wrote.  These are in
+    // addition to the data dependencies, and only matter when operations run
+    // out of the serialized order.
+    const std::vector<uint32_t>& getMemoryDependencies(uint32_t operationIndex) const;
+
+    // Returns an arena for one execution, reusing a released one if possible.
+    std::unique_ptr<uint8_t[]> acquireArena() const;
+    // Returns an arena to the plan once the execution is done with it.
+    void releaseArena(std::unique_ptr<uint8_t[]> arena) const;
+
+private:
+    std::vector<uint32_t> mOffsets;
+    std::vector<uint32_t> mSizes;
+    uint32_t mArenaSize = 0;
+    std::vector<std::vector<uint32_t>> mMemoryDependencies;
+
+    // Arenas not currently used by an execution.  Executions of the same
+    // model may run concurrently, so each takes its own.
+    mutable std::mutex mFreeArenasMutex;
+    mutable std::vector<std::unique_ptr<uint8_t[]>> mFreeArenas;
+};
+
+} // namespace nn
+} // namespace android
+
+#endif // ANDROID_ML_NN_COMMON_MEMORY_PLANNER_H
@@ -38,6 +38,9 @@ enum ActivationFn {
 
 bool addTensorsFloat32Prepare(const Shape& in1, const Shape& in2, Shape* out1);
 bool addTensorsFloat32(const float* in1, const float* in2, float* out, const Shape& shape);
+bool addTensorsQuant8(const uint8_t* in1, const Shape& shape1,
+                      const uint8_t* in2, const Shape& shape2,
+                      uint8_t* out, const Shape& shapeOut);
 
 bool depthwiseConvFloat32Prepare(const Shape& input,
                                  const Shape& filter,
@@ -51,6 +54,12 @@ bool depthwiseConvFloat32(const float* inputData, const Shape& inputShape,
                           int32_t padding, int32_t stride_width, int32_t stride_height,
                           int32_t depth_multiplier, int32_t activation,
                           float* outputData, const Shape& outputShape);
+bool depthwiseConvQuant8(const uint8_t* inputData, const Shape& inputShape,
+                         const uint8_t* filterData, const Shape& filterShape,
+                         const int32_t* biasData, const Shape& biasShape,
+                         int32_t padding, int32_t stride_width, int32_t stride_height,
+                         int32_t depth_multiplier, int32_t activation,
+                         uint8_t* outputData, const Shape& outputShape);
 
 bool convFloat32Prepare(const Shape& input,
                         const Shape& filter,
@@ -63,6 +72,11 @@ bool convFloat32(const float* inputData, const Shape& inputShape,
                  const float* biasData, const Shape& biasShape,
                  int32_t padding, int32_t stride_width, int32_t stride_height, int32_t activation,
                  float* outputData, const Shape& outputShape);
+bool convQuant8(const uint8_t* inputData, const Shape& inputShape,
+                const uint8_t* filterData, const Shape& filterShape,
+                const int32_t* biasData, const Shape& biasShape,
+                int32_t padding, int32_t stride_width, int32_t stride_height, int32_t activation,
+                uint8_t* outputData, const Shape& outputShape);
 
 bool genericPoolingFloat32Prepare(const Shape& input,
                                   int32_t padding,
@@ -73,6 +87,10 @@ bool averagePoolFloat32(const float* inputData, const Shape& inputShape,
                         int32_t padding, int32_t stride_width, int32_t stride_height,
                         int32_t filter_width, int32_t filter_height, int32_t activation,
                         float* outputData, const Shape& outputShape);
+bool averagePoolQuant8(const uint8_t* inputData, const Shape& inputShape,
+                       int32_t padding, int32_t stride_width, int32_t stride_height,
+                       int32_t filter_width, int32_t filter_height, int32_t activation,
+                       uint8_t* outputData, const Shape& outputShape);
 bool l2PoolFloat32(const float* inputData, const Shape& inputShape,
                    int32_t padding, int32_t stride_width, int32_t stride_height,
                    int32_t filter_width, int32_t filter_height, int32_t activation,
@@ -81,6 +99,10 @@ bool maxPoolFloat32(const float* inputData, const Shape& inputShape,
                     int32_t padding, int32_t stride_width, int32_t stride_height,
                     int32_t filter_width, int32_t filter_height, int32_t activation,
                     float* outputData, const Shape& outputShape);
+bool maxPoolQuant8(const uint8_t* inputData, const Shape& inputShape,
+                   int32_t padding, int32_t stride_width, int32_t stride_height,
+                   int32_t filter_width, int32_t filter_height, int32_t activation,
+                   uint8_t* outputData, const Shape& outputShape);
 
 bool genericActivationFloat32Prepare(const Shape& input, Shape* output);
 bool reluFloat32(const float* inputData, const Shape& inputShape,
@@ -91,6 +113,12 @@ bool tanhFloat32(const float* inputData, const Shape& inputShape,
                  float* outputData, const Shape& outputShape);
 bool logisticFloat32(const float* inputData, const Shape& inputShape,
                      float* outputData, const Shape& outputShape);
+bool reluQuant8(const uint8_t* inputData, const Shape& inputShape,
+                uint8_t* outputData, const Shape& outputShape);
+bool relu6Quant8(const uint8_t* inputData, const Shape& inputShape,
+                 uint8_t* outputData, const Shape& outputShape);
+bool logisticQuant8(const uint8_t* inputData, const Shape& inputShape,
+                    uint8_t* outputData, const Shape& outputShape);
 
 } // namespace nn
 } // namespace android
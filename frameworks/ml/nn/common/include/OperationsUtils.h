@@ -25,10 +25,20 @@
 namespace android {
 namespace nn {
 
-// The type and dimensions of an operand.
+// The quantization of a TENSOR_SYMMETRICAL_QUANT8 operand.  The real value
+// of an entry is (value - offset) * scale.
+struct OperandQuantization {
+    float scale = 0.f;
+    int32_t offset = 0;
+};
+
+// The type and dimensions of an operand.  For quantized tensors, this
+// includes how to map the values back to real numbers.
 struct Shape {
     OperandType type;
     std::vector<uint32_t> dimensions;
+    float scale = 0.f;
+    int32_t offset = 0;
 };
 
 // Verifies that the two shapes are the same.
@@ -45,6 +55,54 @@ uint32_t getNumberOfDimensions(const Shape& shape);
 
 uint32_t getSizeOfDimension(const Shape& shape, uint32_t dimensionIdx);
 
+// Operations are split into tiles that run concurrently on the ThreadPool.
+// To keep the dispatch overhead small, a tile has at least this many
+// multiply-accumulates worth of work.  Smaller operations run on the
+// calling thread only.
+constexpr uint64_t kMinMacsPerTile = 256 * 1024;
+
+// Returns the number of tiles to split an operation of totalMacs
+// multiply-accumulates into.  There are at most maxTiles of them, and a
+// few more than there are threads to balance the load.
+uint32_t computeNumberOfTiles(uint64_t totalMacs, uint32_t maxTiles);
+
+// A range of rows of the output of one batch, processed as one tile.
+struct RowTile {
+    uint32_t batch;
+    uint32_t rowStart;
+    uint32_t rowCount;
+};
+
+// Splits the rows of each batch of an output into tiles, so that there are
+// about numTiles tiles overall.  Tiles never span two batches.
+std::vector<RowTile> splitIntoRowTiles(uint32_t batches, uint32_t height, uint32_t numTiles);
+
+// Verifies that the two shapes have the same quantization.
+bool SameQuantization(const Shape& in1, const Shape& in2);
+
+// Converts a real multiplier in [0, 1) to a fixed-point multiplier and a
+// right shift, as expected by the uint8 kernels.
+bool QuantizeMultiplierSmallerThanOne(double realMultiplier, int32_t* quantizedMultiplier,
+                                      int32_t* rightShift);
+
+// Converts a real multiplier greater than one to a fixed-point multiplier
+// and a left shift.
+bool QuantizeMultiplierGreaterThanOne(double realMultiplier, int32_t* quantizedMultiplier,
+                                      int* leftShift);
+
+// Returns the multiplier that rescales the int32 accumulators of a
+// quantized convolution to the output.  Fails if it isn't below one.
+bool GetQuantizedConvolutionMultipler(const Shape& inputShape, const Shape& filterShape,
+                                      const Shape& outputShape, double* multiplier);
+
+// Returns the range of quantized output values left by the fused activation.
+void CalculateActivationRangeUint8(int32_t activation, const Shape& outputShape,
+                                   int32_t* actMin, int32_t* actMax);
+
+// Returns the largest input magnitude, relative to the zero point, that
+// doesn't saturate a fixed-point function with inputIntegerBits integer bits.
+int32_t CalculateInputRadius(int inputIntegerBits, int inputLeftShift);
+
 inline uint32_t ComputePadding(uint32_t stride, uint32_t in_size, uint32_t filter_size,
                                uint32_t out_size) {
   return ((out_size - 1) * stride + filter_size - in_size) / 2;
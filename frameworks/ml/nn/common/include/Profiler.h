@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_ML_NN_COMMON_PROFILER_H
+#define ANDROID_ML_NN_COMMON_PROFILER_H
+
+#include "HalInterfaces.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace android {
+namespace nn {
+
+// One measurement taken while running a request.  It's either the run of a
+// single operation by the CpuExecutor, or a whole request, in which case
+// operationIndex is kWholeRequest.
+struct ProfileEntry {
+    // "cpu", or the name of the driver the request ran on.
+    std::string device;
+    int32_t operationIndex;
+    // Only meaningful for operations.
+    OperationType operationType;
+    int64_t durationNs;
+    // The size of all the inputs and outputs of the operation or request.
+    uint64_t bytesTouched;
+};
+
+// Collects ProfileEntry records for the whole process.  Profiling is off by
+// default; when off, the only cost to the executors is checking isEnabled().
+class Profiler {
+public:
+    static constexpr int32_t kWholeRequest = -1;
+
+    // Returns the singleton profiler.
+    static Profiler* get();
+
+    void setEnabled(bool enabled) { mEnabled.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+
+    // Adds an entry.  Can be called from any thread.
+    void record(ProfileEntry entry);
+    // Returns the entries recorded so far and forgets them.
+    std::vector<ProfileEntry> takeEntries();
+
+    static int64_t nanosecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                .count();
+    }
+
+private:
+    std::atomic<bool> mEnabled{false};
+    std::mutex mMutex;
+    std::vector<ProfileEntry> mEntries;
+};
+
+} // namespace nn
+} // namespace android
+
+#endif // ANDROID_ML_NN_COMMON_PROFILER_H
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_ML_NN_COMMON_THREAD_POOL_H
+#define ANDROID_ML_NN_COMMON_THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace nn {
+
+// A fixed set of worker threads shared by all the CpuExecutors of the process.
+//
+// The calling thread always takes part in the work it submits through
+// forEach(), so a caller never depends on a free worker to make progress.
+// This makes it safe to call forEach() from code that is itself running on
+// one of the workers, e.g. a kernel tiling its output while the graph
+// scheduler runs independent operations.
+class ThreadPool {
+public:
+    // Creates a pool with numThreads workers.  A pool with zero workers is
+    // valid; all the work then runs on the calling thread.
+    explicit ThreadPool(uint32_t numThreads);
+    ~ThreadPool();
+
+    // Returns the process wide pool, sized to the number of online cores.
+    static ThreadPool* get();
+
+    // The number of threads that can work on a forEach() call, including
+    // the calling thread.
+    uint32_t getConcurrency() const { return static_cast<uint32_t>(mWorkers.size()) + 1; }
+
+    // Calls fn(i) for every i in [0, count), spreading the calls over at most
+    // maxThreads threads (0 means no limit).  Returns once all the calls have
+    // completed.
+    void forEach(uint32_t count, const std::function<void(uint32_t)>& fn,
+                 uint32_t maxThreads = 0);
+
+    // Queues a task to be run by one of the workers.  If the pool has no
+    // workers, the task runs immediately on the calling thread.  A task must
+    // not block waiting for another task, as there may be no worker left to
+    // run it.
+    void schedule(std::function<void()> task);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> mWorkers;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::function<void()>> mTasks;
+    bool mStopping = false;
+};
+
+} // namespace nn
+} // namespace android
+
+#endif // ANDROID_ML_NN_COMMON_THREAD_POOL_H
@@ -65,5 +65,74 @@ bool logisticFloat32(const float* inputData, const Shape& inputShape,
     return true;
 }
 
+bool reluQuant8(const uint8_t* inputData, const Shape& inputShape,
+                uint8_t* outputData, const Shape& outputShape) {
+    if (!SameQuantization(inputShape, outputShape)) {
+        LOG(ERROR) << "Quantized RELU needs the same quantization for its input and output";
+        return false;
+    }
+    if (outputShape.scale <= 0.f) {
+        LOG(ERROR) << "Quantized RELU needs a positive scale";
+        return false;
+    }
+    int32_t actMin, actMax;
+    CalculateActivationRangeUint8(kActivationRelu, outputShape, &actMin, &actMax);
+    int numElements = getNumberOfElements(inputShape);
+    for (int i=0; i<numElements; i++, inputData++, outputData++) {
+        *outputData = std::min(std::max<int32_t>(actMin, *inputData), actMax);
+    }
+    return true;
+}
+
+bool relu6Quant8(const uint8_t* inputData, const Shape& inputShape,
+                 uint8_t* outputData, const Shape& outputShape) {
+    if (!SameQuantization(inputShape, outputShape)) {
+        LOG(ERROR) << "Quantized RELU6 needs the same quantization for its input and output";
+        return false;
+    }
+    if (outputShape.scale <= 0.f) {
+        LOG(ERROR) << "Quantized RELU6 needs a positive scale";
+        return false;
+    }
+    int32_t actMin, actMax;
+    CalculateActivationRangeUint8(kActivationRelu6, outputShape, &actMin, &actMax);
+    int numElements = getNumberOfElements(inputShape);
+    for (int i=0; i<numElements; i++, inputData++, outputData++) {
+        *outputData = std::min(std::max<int32_t>(actMin, *inputData), actMax);
+    }
+    return true;
+}
+
+bool logisticQuant8(const uint8_t* inputData, const Shape& inputShape,
+                    uint8_t* outputData, const Shape& outputShape) {
+    // The output covers [0, 1) with the full uint8 range.
+    if (outputShape.offset != 0 || outputShape.scale != 1.f / 256) {
+        LOG(ERROR) << "Quantized LOGISTIC needs an output scale of 1/256 and offset of 0";
+        return false;
+    }
+    if (inputShape.scale <= 0.f) {
+        LOG(ERROR) << "Quantized LOGISTIC needs a positive input scale";
+        return false;
+    }
+
+    // The fixed-point logistic takes its input with 4 integer bits.
+    const int kInputIntegerBits = 4;
+    const double inputRealMultiplier =
+            inputShape.scale * static_cast<double>(1 << (31 - kInputIntegerBits));
+    int32_t inputMultiplier = 0;
+    int inputLeftShift = 0;
+    if (!QuantizeMultiplierGreaterThanOne(inputRealMultiplier, &inputMultiplier,
+                                          &inputLeftShift)) {
+        return false;
+    }
+    int32_t inputRangeRadius = CalculateInputRadius(kInputIntegerBits, inputLeftShift);
+
+    optimized_ops::Logistic(inputData, convertShapeToDims(inputShape),
+                            inputShape.offset, inputRangeRadius,
+                            inputMultiplier, inputLeftShift,
+                            outputData, convertShapeToDims(outputShape));
+    return true;
+}
+
 }  // namespace nn
 }  // namespace android
@@ -16,6 +16,7 @@
 
 #include "Operations.h"
 #include "OperationsUtils.h"
+#include "ThreadPool.h"
 
 #include "internal/optimized/optimized_ops.h"
 #include "internal/reference/reference_ops.h"
@@ -23,9 +24,18 @@
 namespace android {
 namespace nn {
 
-// If possible we will use this static buffer for the tensor.
-static constexpr int kStaticBufferSize = 1605632;
-static char static_scratch_buffer[kStaticBufferSize];
+// Returns a scratch buffer of at least size elements for the im2col data.
+// Each thread has its own, as convolutions may run concurrently, either
+// from independent operations or from tiles of the same one.  The buffer is
+// kept between calls to avoid allocating on every inference.
+template <typename T>
+static T* getIm2colScratch(size_t size) {
+    static thread_local std::vector<T> scratch;
+    if (scratch.size() < size) {
+        scratch.resize(size);
+    }
+    return scratch.data();
+}
 
 bool convFloat32Prepare(const Shape& input,
                         const Shape& filter,
@@ -66,6 +76,211 @@ bool convFloat32Prepare(const Shape& input,
     return true;
 }
 
+namespace {
+
+// The arguments of a convolution, shared by all its tiles.
+struct ConvParams {
+    const float* inputData;
+    Dims<4> inputDims;
+    const float* filterData;
+    Dims<4> filterDims;
+    const float* biasData;
+    Dims<4> biasDims;
+    int stride;
+    int paddingWidth;
+    int paddingHeight;
+    float* outputData;
+    Dims<4> outputDims;
+};
+
+// Computes the output channels [channelStart, channelStart + channelCount)
+// of the output rows described by tile.  This is the same im2col + GEMM as
+// optimized_ops::Conv, restricted to a block of the output.
+template <FusedActivationFunctionType Ac>
+void convTile(const ConvParams& p, const RowTile& tile, int channelStart, int channelCount) {
+    const int inDepth = ArraySize(p.inputDims, 0);
+    const int filterWidth = ArraySize(p.filterDims, 1);
+    const int filterHeight = ArraySize(p.filterDims, 2);
+    const int outDepth = ArraySize(p.outputDims, 0);
+    const int outWidth = ArraySize(p.outputDims, 1);
+    const int rowStart = tile.rowStart;
+    const int rowCount = tile.rowCount;
+    const int batch = tile.batch;
+    const int depth = inDepth * filterHeight * filterWidth;
+    const int pixels = rowCount * outWidth;
+
+    const float* gemmInputData = nullptr;
+    if (p.stride != 1 || filterWidth != 1 || filterHeight != 1) {
+        // Im2col of the rows of this tile only.  Shifting the padding makes
+        // the first row of the tile line up with row rowStart of the output.
+        Dims<4> batchInputDims = p.inputDims;
+        batchInputDims.sizes[3] = 1;
+        Dims<4> im2colDims;
+        im2colDims.sizes[0] = depth;
+        im2colDims.sizes[1] = outWidth;
+        im2colDims.sizes[2] = rowCount;
+        im2colDims.sizes[3] = 1;
+        im2colDims.strides[0] = 1;
+        for (int i = 1; i < 4; i++) {
+            im2colDims.strides[i] = im2colDims.strides[i - 1] * im2colDims.sizes[i - 1];
+        }
+        float* im2colData = getIm2colScratch<float>(depth * pixels);
+        optimized_ops::Im2col(p.inputData + batch * p.inputDims.strides[3], batchInputDims,
+                              p.stride, p.paddingWidth, p.paddingHeight - rowStart * p.stride,
+                              filterHeight, filterWidth, 0, im2colData, im2colDims);
+        gemmInputData = im2colData;
+    } else {
+        // A 1x1 unstrided convolution reads the same pixels it writes.
+        gemmInputData = p.inputData + Offset(p.inputDims, 0, 0, rowStart, batch);
+    }
+
+    float* outputData = p.outputData + Offset(p.outputDims, 0, 0, rowStart, batch);
+    Eigen::Map<const Eigen::MatrixXf> gemmInputMap(gemmInputData, depth, pixels);
+    Eigen::Map<const Eigen::MatrixXf> filterMap(p.filterData, depth, outDepth);
+    Eigen::Map<Eigen::MatrixXf, 0, Eigen::OuterStride<>> outputMap(
+            outputData + channelStart, channelCount, pixels, Eigen::OuterStride<>(outDepth));
+    outputMap.noalias() =
+            filterMap.middleCols(channelStart, channelCount).transpose() * gemmInputMap;
+
+    if (channelCount == outDepth) {
+        Dims<4> tileDims = p.outputDims;
+        tileDims.sizes[2] = rowCount;
+        tileDims.sizes[3] = 1;
+        tileDims.strides[3] = tileDims.strides[2] * rowCount;
+        optimized_ops::AddBiasAndEvalActivationFunction<Ac>(p.biasData, p.biasDims, outputData,
+                                                            tileDims);
+    } else {
+        const float* bias = p.biasData + channelStart;
+        for (int pixel = 0; pixel < pixels; pixel++) {
+            float* out = outputData + pixel * outDepth + channelStart;
+            for (int c = 0; c < channelCount; c++) {
+                out[c] = ActivationFunction<Ac>(out[c] + bias[c]);
+            }
+        }
+    }
+}
+
+// Runs the convolution as a set of tiles spread over the ThreadPool.  Rows
+// are split first.  When there aren't enough rows to keep all the threads
+// busy, e.g. for the small spatial sizes at the end of a network, the output
+// channels are split in blocks as well.
+template <FusedActivationFunctionType Ac>
+void convTiled(const ConvParams& p, uint32_t numTiles) {
+    const uint32_t batches = ArraySize(p.outputDims, 3);
+    const uint32_t outHeight = ArraySize(p.outputDims, 2);
+    const uint32_t outDepth = ArraySize(p.outputDims, 0);
+    const std::vector<RowTile> rowTiles = splitIntoRowTiles(batches, outHeight, numTiles);
+
+    // Keep blocks a multiple of 8 channels to not break up the vectorized
+    // GEMM kernels.
+    const uint32_t kChannelBlockAlignment = 8;
+    uint32_t channelBlocks = 1;
+    uint32_t channelsPerBlock = outDepth;
+    if (rowTiles.size() < numTiles && outDepth >= 2 * kChannelBlockAlignment) {
+        channelBlocks = std::min<uint32_t>((numTiles + rowTiles.size() - 1) / rowTiles.size(),
+                                           outDepth / kChannelBlockAlignment);
+        channelsPerBlock = (outDepth + channelBlocks - 1) / channelBlocks;
+        channelsPerBlock = (channelsPerBlock + kChannelBlockAlignment - 1) /
+                kChannelBlockAlignment * kChannelBlockAlignment;
+        channelBlocks = (outDepth + channelsPerBlock - 1) / channelsPerBlock;
+    }
+
+    ThreadPool::get()->forEach(rowTiles.size() * channelBlocks, [&](uint32_t i) {
+        const uint32_t channelStart = (i % channelBlocks) * channelsPerBlock;
+        const uint32_t channelCount = std::min(channelsPerBlock, outDepth - channelStart);
+        convTile<Ac>(p, rowTiles[i / channelBlocks], channelStart, channelCount);
+    }, numTiles);
+}
+
+// The arguments of a quantized convolution, shared by all its tiles.
+struct ConvQuant8Params {
+    const uint8_t* inputData;
+    Dims<4> inputDims;
+    int32_t inputOffset;
+    const uint8_t* filterData;
+    Dims<4> filterDims;
+    int32_t filterOffset;
+    const int32_t* biasData;
+    Dims<4> biasDims;
+    int stride;
+    int paddingWidth;
+    int paddingHeight;
+    int32_t outputOffset;
+    int32_t outputMultiplier;
+    int32_t outputShift;
+    int32_t outputActivationMin;
+    int32_t outputActivationMax;
+    uint8_t* outputData;
+    Dims<4> outputDims;
+};
+
+// Returns the gemmlowp context of the calling thread.  The parallelism
+// comes from the tiles, so each context runs its GEMMs on one thread.
+static gemmlowp::GemmContext* getGemmContext() {
+    static thread_local std::unique_ptr<gemmlowp::GemmContext> context;
+    if (context == nullptr) {
+        context.reset(new gemmlowp::GemmContext());
+        context->set_max_num_threads(1);
+    }
+    return context.get();
+}
+
+// Computes the output rows described by tile with optimized_ops::Conv.
+// Like for the float tiles, the im2col only covers the rows of the tile.
+template <FusedActivationFunctionType Ac>
+void convQuant8Tile(const ConvQuant8Params& p, const RowTile& tile) {
+    const int inDepth = ArraySize(p.inputDims, 0);
+    const int filterWidth = ArraySize(p.filterDims, 1);
+    const int filterHeight = ArraySize(p.filterDims, 2);
+    const int outWidth = ArraySize(p.outputDims, 1);
+    const int rowCount = tile.rowCount;
+
+    Dims<4> tileOutputDims = p.outputDims;
+    tileOutputDims.sizes[2] = rowCount;
+    tileOutputDims.sizes[3] = 1;
+    tileOutputDims.strides[3] = tileOutputDims.strides[2] * rowCount;
+    uint8_t* outputData = p.outputData + Offset(p.outputDims, 0, 0, tile.rowStart, tile.batch);
+
+    if (p.stride != 1 || filterWidth != 1 || filterHeight != 1) {
+        Dims<4> batchInputDims = p.inputDims;
+        batchInputDims.sizes[3] = 1;
+        Dims<4> im2colDims;
+        im2colDims.sizes[0] = inDepth * filterHeight * filterWidth;
+        im2colDims.sizes[1] = outWidth;
+        im2colDims.sizes[2] = rowCount;
+        im2colDims.sizes[3] = 1;
+        im2colDims.strides[0] = 1;
+        for (int i = 1; i < 4; i++) {
+            im2colDims.strides[i] = im2colDims.strides[i - 1] * im2colDims.sizes[i - 1];
+        }
+        uint8_t* im2colData = getIm2colScratch<uint8_t>(RequiredBufferSizeForDims(im2colDims));
+        optimized_ops::Conv<Ac>(
+                p.inputData + tile.batch * p.inputDims.strides[3], batchInputDims, p.inputOffset,
+                p.filterData, p.filterDims, p.filterOffset, p.biasData, p.biasDims,
+                p.stride, p.paddingWidth, p.paddingHeight - tile.rowStart * p.stride,
+                p.outputOffset, p.outputMultiplier, p.outputShift,
+                p.outputActivationMin, p.outputActivationMax,
+                outputData, tileOutputDims, im2colData, im2colDims, getGemmContext());
+    } else {
+        // A 1x1 unstrided convolution reads the same pixels it writes.
+        Dims<4> tileInputDims = p.inputDims;
+        tileInputDims.sizes[2] = rowCount;
+        tileInputDims.sizes[3] = 1;
+        tileInputDims.strides[3] = tileInputDims.strides[2] * rowCount;
+        Dims<4> unusedIm2colDims = tileOutputDims;
+        optimized_ops::Conv<Ac>(
+                p.inputData + Offset(p.inputDims, 0, 0, tile.rowStart, tile.batch),
+                tileInputDims, p.inputOffset,
+                p.filterData, p.filterDims, p.filterOffset, p.biasData, p.biasDims,
+                p.stride, p.paddingWidth, p.paddingHeight,
+                p.outputOffset, p.outputMultiplier, p.outputShift,
+                p.outputActivationMin, p.outputActivationMax,
+                outputData, tileOutputDims, nullptr, unusedIm2colDims, getGemmContext());
+    }
+}
+
+}  // namespace
+
 bool convFloat32(const float* inputData, const Shape& inputShape,
                  const float* filterData, const Shape& filterShape,
                  const float* biasData, const Shape& biasShape,
@@ -84,6 +299,41 @@ bool convFloat32(const float* inputData, const Shape& inputShape,
     uint32_t paddingWidth =
             ComputePadding(stride_width, width, filterWidth, outWidth);
 
+    ConvParams params = {
+        .inputData = inputData,
+        .inputDims = convertShapeToDims(inputShape),
+        .filterData = filterData,
+        .filterDims = convertShapeToDims(filterShape),
+        .biasData = biasData,
+        .biasDims = convertShapeToDims(biasShape),
+        .stride = stride_width,
+        .paddingWidth = static_cast<int>(paddingWidth),
+        .paddingHeight = static_cast<int>(paddingHeight),
+        .outputData = outputData,
+        .outputDims = convertShapeToDims(outputShape),
+    };
+    uint64_t macs = static_cast<uint64_t>(getNumberOfElements(outputShape)) *
+            inDepth * filterHeight * filterWidth;
+    uint32_t numTiles = computeNumberOfTiles(macs, getNumberOfElements(outputShape));
+
+    if (numTiles > 1) {
+        #define ANDROID_NN_CONV_TILED(activation)                                  \
+            convTiled<FusedActivationFunctionType::activation>(params, numTiles)
+
+        if (activation == kActivationNone) {
+            ANDROID_NN_CONV_TILED(kNone);
+        }
+        if (activation == kActivationRelu) {
+            ANDROID_NN_CONV_TILED(kRelu);
+        }
+        if (activation == kActivationRelu6) {
+            ANDROID_NN_CONV_TILED(kRelu6);
+        }
+
+        #undef ANDROID_NN_CONV_TILED
+        return true;
+    }
+
     Dims<4> im2colDim;
     im2colDim.sizes[3] = (int)getSizeOfDimension(outputShape, 0);
     im2colDim.sizes[2] = (int)getSizeOfDimension(outputShape, 1);
@@ -95,15 +345,10 @@ bool convFloat32(const float* inputData, const Shape& inputShape,
         im2colDim.strides[i] = im2colDim.strides[i-1] * im2colDim.sizes[i-1];
     }
 
+    // optimized_ops::Conv only wants a buffer if it needs to do the im2col.
     float* im2colData = nullptr;
-    int im2colByteSize = sizeof(float);
-    for (int i=0; i<4; i++) {
-        im2colByteSize *= im2colDim.sizes[i];
-    }
-    if (im2colByteSize <= kStaticBufferSize) {
-        im2colData = reinterpret_cast<float *>(static_scratch_buffer);
-    } else {
-        im2colData = new (std::nothrow) float[im2colByteSize / sizeof(float)];
+    if (stride_width != 1 || filterWidth != 1 || filterHeight != 1) {
+        im2colData = getIm2colScratch<float>(RequiredBufferSizeForDims(im2colDim));
     }
 
     #define ANDROID_NN_CONV(activation)                                        \
@@ -127,9 +372,86 @@ bool convFloat32(const float* inputData, const Shape& inputShape,
 
     #undef ANDROID_NN_CONV
 
-    if (im2colByteSize > kStaticBufferSize) {
-        delete[] im2colData;
+    return true;
+}
+
+bool convQuant8(const uint8_t* inputData, const Shape& inputShape,
+                const uint8_t* filterData, const Shape& filterShape,
+                const int32_t* biasData, const Shape& biasShape,
+                int32_t padding, int32_t stride_width, int32_t stride_height, int32_t activation,
+                uint8_t* outputData, const Shape& outputShape) {
+    uint32_t height       = getSizeOfDimension(inputShape, 1);
+    uint32_t width        = getSizeOfDimension(inputShape, 2);
+    uint32_t filterHeight = getSizeOfDimension(filterShape, 1);
+    uint32_t filterWidth  = getSizeOfDimension(filterShape, 2);
+    uint32_t outHeight    = getSizeOfDimension(outputShape, 1);
+    uint32_t outWidth     = getSizeOfDimension(outputShape, 2);
+    uint32_t inDepth      = getSizeOfDimension(inputShape, 3);
+
+    uint32_t paddingHeight =
+            ComputePadding(stride_height, height, filterHeight, outHeight);
+    uint32_t paddingWidth =
+            ComputePadding(stride_width, width, filterWidth, outWidth);
+
+    // The bias is in int32, with a scale of inputScale * filterScale and no
+    // offset.  The accumulators are rescaled to the output with a
+    // fixed-point multiplier.
+    double realMultiplier = 0.0;
+    int32_t outputMultiplier = 0;
+    int32_t outputShift = 0;
+    if (!GetQuantizedConvolutionMultipler(inputShape, filterShape, outputShape,
+                                          &realMultiplier) ||
+        !QuantizeMultiplierSmallerThanOne(realMultiplier, &outputMultiplier, &outputShift)) {
+        return false;
     }
+    int32_t outputActivationMin = 0;
+    int32_t outputActivationMax = 0;
+    CalculateActivationRangeUint8(activation, outputShape,
+                                  &outputActivationMin, &outputActivationMax);
+
+    ConvQuant8Params params = {
+        .inputData = inputData,
+        .inputDims = convertShapeToDims(inputShape),
+        .inputOffset = -inputShape.offset,
+        .filterData = filterData,
+        .filterDims = convertShapeToDims(filterShape),
+        .filterOffset = -filterShape.offset,
+        .biasData = biasData,
+        .biasDims = convertShapeToDims(biasShape),
+        .stride = stride_width,
+        .paddingWidth = static_cast<int>(paddingWidth),
+        .paddingHeight = static_cast<int>(paddingHeight),
+        .outputOffset = outputShape.offset,
+        .outputMultiplier = outputMultiplier,
+        .outputShift = outputShift,
+        .outputActivationMin = outputActivationMin,
+        .outputActivationMax = outputActivationMax,
+        .outputData = outputData,
+        .outputDims = convertShapeToDims(outputShape),
+    };
+    uint64_t macs = static_cast<uint64_t>(getNumberOfElements(outputShape)) *
+            inDepth * filterHeight * filterWidth;
+    uint32_t numTiles = computeNumberOfTiles(macs, getNumberOfElements(outputShape));
+    const std::vector<RowTile> tiles =
+            splitIntoRowTiles(getSizeOfDimension(outputShape, 0), outHeight, numTiles);
+
+    #define ANDROID_NN_CONV_QUANT8(activation)                                 \
+        convQuant8Tile<FusedActivationFunctionType::activation>(params, tiles[i])
+
+    ThreadPool::get()->forEach(tiles.size(), [&](uint32_t i) {
+        if (activation == kActivationNone) {
+            ANDROID_NN_CONV_QUANT8(kNone);
+        }
+        if (activation == kActivationRelu) {
+            ANDROID_NN_CONV_QUANT8(kRelu);
+        }
+        if (activation == kActivationRelu6) {
+            ANDROID_NN_CONV_QUANT8(kRelu6);
+        }
+    }, numTiles);
+
+    #undef ANDROID_NN_CONV_QUANT8
+
     return true;
 }
 
@@ -16,8 +16,10 @@
 
 #include "Operations.h"
 #include "OperationsUtils.h"
+#include "ThreadPool.h"
 
 #include "internal/optimized/depthwiseconv_float.h"
+#include "internal/optimized/depthwiseconv_uint8.h"
 #include "internal/reference/depthwiseconv_float.h"
 
 namespace android {
@@ -79,28 +81,133 @@ bool depthwiseConvFloat32(const float* inputData, const Shape& inputShape,
     uint32_t paddingWidth =
             ComputePadding(stride_width, width, filterWidth, outWidth);
 
+    const Dims<4> inputDims = convertShapeToDims(inputShape);
+    const Dims<4> outputDims = convertShapeToDims(outputShape);
+    uint64_t macs = static_cast<uint64_t>(getNumberOfElements(outputShape)) *
+            filterHeight * filterWidth;
+    uint32_t numTiles = computeNumberOfTiles(macs, getNumberOfElements(outputShape));
+    const std::vector<RowTile> tiles =
+            splitIntoRowTiles(getSizeOfDimension(outputShape, 0), outHeight, numTiles);
+
+    // Each tile is a batch of one, covering a range of output rows.  The
+    // padding is shifted so that the first row of the tile lines up with
+    // row rowStart of the full output.
     #define ANDROID_NN_DEPTHWISE_CONV(activation)                              \
         optimized_ops::DepthwiseConv<FusedActivationFunctionType::activation>( \
-            inputData, convertShapeToDims(inputShape),                         \
+            inputData + tile.batch * inputDims.strides[3], tileInputDims,      \
             filterData, convertShapeToDims(filterShape),                       \
             biasData, convertShapeToDims(biasShape),                           \
-            stride_width, paddingWidth, paddingHeight, depth_multiplier,       \
-            outputData, convertShapeToDims(outputShape))
-
-    if (activation == kActivationNone) {
-        ANDROID_NN_DEPTHWISE_CONV(kNone);
-    }
-    if (activation == kActivationRelu) {
-        ANDROID_NN_DEPTHWISE_CONV(kRelu);
-    }
-    if (activation == kActivationRelu6) {
-        ANDROID_NN_DEPTHWISE_CONV(kRelu6);
-    }
+            stride_width, paddingWidth,                                        \
+            static_cast<int>(paddingHeight) -                                  \
+                    static_cast<int>(tile.rowStart) * stride_height,           \
+            depth_multiplier,                                                  \
+            outputData + Offset(outputDims, 0, 0, tile.rowStart, tile.batch),  \
+            tileOutputDims)
+
+    ThreadPool::get()->forEach(tiles.size(), [&](uint32_t i) {
+        const RowTile& tile = tiles[i];
+        Dims<4> tileInputDims = inputDims;
+        tileInputDims.sizes[3] = 1;
+        Dims<4> tileOutputDims = outputDims;
+        tileOutputDims.sizes[2] = tile.rowCount;
+        tileOutputDims.sizes[3] = 1;
+        tileOutputDims.strides[3] = tileOutputDims.strides[2] * tile.rowCount;
+
+        if (activation == kActivationNone) {
+            ANDROID_NN_DEPTHWISE_CONV(kNone);
+        }
+        if (activation == kActivationRelu) {
+            ANDROID_NN_DEPTHWISE_CONV(kRelu);
+        }
+        if (activation == kActivationRelu6) {
+            ANDROID_NN_DEPTHWISE_CONV(kRelu6);
+        }
+    }, numTiles);
 
     #undef ANDROID_NN_DEPTHWISE_CONV
 
     return true;
 }
 
+bool depthwiseConvQuant8(const uint8_t* inputData, const Shape& inputShape,
+                         const uint8_t* filterData, const Shape& filterShape,
+                         const int32_t* biasData, const Shape& biasShape,
+                         int32_t padding, int32_t stride_width, int32_t stride_height,
+                         int32_t depth_multiplier, int32_t activation,
+                         uint8_t* outputData, const Shape& outputShape) {
+    uint32_t height       = getSizeOfDimension(inputShape, 1);
+    uint32_t width        = getSizeOfDimension(inputShape, 2);
+    uint32_t filterHeight = getSizeOfDimension(filterShape, 1);
+    uint32_t filterWidth  = getSizeOfDimension(filterShape, 2);
+    uint32_t outHeight    = getSizeOfDimension(outputShape, 1);
+    uint32_t outWidth     = getSizeOfDimension(outputShape, 2);
+
+    uint32_t paddingHeight =
+            ComputePadding(stride_height, height, filterHeight, outHeight);
+    uint32_t paddingWidth =
+            ComputePadding(stride_width, width, filterWidth, outWidth);
+
+    double realMultiplier = 0.0;
+    int32_t outputMultiplier = 0;
+    int32_t outputShift = 0;
+    if (!GetQuantizedConvolutionMultipler(inputShape, filterShape, outputShape,
+                                          &realMultiplier) ||
+        !QuantizeMultiplierSmallerThanOne(realMultiplier, &outputMultiplier, &outputShift)) {
+        return false;
+    }
+    int32_t outputActivationMin = 0;
+    int32_t outputActivationMax = 0;
+    CalculateActivationRangeUint8(activation, outputShape,
+                                  &outputActivationMin, &outputActivationMax);
+
+    const Dims<4> inputDims = convertShapeToDims(inputShape);
+    const Dims<4> outputDims = convertShapeToDims(outputShape);
+    uint64_t macs = static_cast<uint64_t>(getNumberOfElements(outputShape)) *
+            filterHeight * filterWidth;
+    uint32_t numTiles = computeNumberOfTiles(macs, getNumberOfElements(outputShape));
+    const std::vector<RowTile> tiles =
+            splitIntoRowTiles(getSizeOfDimension(outputShape, 0), outHeight, numTiles);
+
+    // Tiled the same way as depthwiseConvFloat32.
+    #define ANDROID_NN_DEPTHWISE_CONV_QUANT8(activation)                       \
+        optimized_ops::DepthwiseConv<FusedActivationFunctionType::activation>( \
+            inputData + tile.batch * inputDims.strides[3], tileInputDims,      \
+            -inputShape.offset,                                                \
+            filterData, convertShapeToDims(filterShape), -filterShape.offset,  \
+            biasData, convertShapeToDims(biasShape),                           \
+            stride_width, paddingWidth,                                        \
+            static_cast<int>(paddingHeight) -                                  \
+                    static_cast<int>(tile.rowStart) * stride_height,           \
+            depth_multiplier,                                                  \
+            outputShape.offset, outputMultiplier, outputShift,                 \
+            outputActivationMin, outputActivationMax,                          \
+            outputData + Offset(outputDims, 0, 0, tile.rowStart, tile.batch),  \
+            tileOutputDims)
+
+    ThreadPool::get()->forEach(tiles.size(), [&](uint32_t i) {
+        const RowTile& tile = tiles[i];
+        Dims<4> tileInputDims = inputDims;
+        tileInputDims.sizes[3] = 1;
+        Dims<4> tileOutputDims = outputDims;
+        tileOutputDims.sizes[2] = tile.rowCount;
+        tileOutputDims.sizes[3] = 1;
+        tileOutputDims.strides[3] = tileOutputDims.strides[2] * tile.rowCount;
+
+        if (activation == kActivationNone) {
+            ANDROID_NN_DEPTHWISE_CONV_QUANT8(kNone);
+        }
+        if (activation == kActivationRelu) {
+            ANDROID_NN_DEPTHWISE_CONV_QUANT8(kRelu);
+        }
+        if (activation == kActivationRelu6) {
+            ANDROID_NN_DEPTHWISE_CONV_QUANT8(kRelu6);
+        }
+    }, numTiles);
+
+    #undef ANDROID_NN_DEPTHWISE_CONV_QUANT8
+
+    return true;
+}
+
 }  // namespace nn
 }  // namespace android
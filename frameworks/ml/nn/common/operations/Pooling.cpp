@@ -90,6 +90,56 @@ bool averagePoolFloat32(const float* inputData, const Shape& inputShape,
     return true;
 }
 
+bool averagePoolQuant8(const uint8_t* inputData, const Shape& inputShape,
+                      int32_t padding, int32_t stride_width, int32_t stride_height,
+                      int32_t filter_width, int32_t filter_height, int32_t activation,
+                      uint8_t* outputData, const Shape& outputShape) {
+    if (!SameQuantization(inputShape, outputShape)) {
+        LOG(ERROR) << "Quantized pooling needs the same quantization for its input and output";
+        return false;
+    }
+    if (outputShape.scale <= 0.f) {
+        LOG(ERROR) << "Quantized pooling needs a positive scale";
+        return false;
+    }
+    uint32_t height       = getSizeOfDimension(inputShape, 1);
+    uint32_t width        = getSizeOfDimension(inputShape, 2);
+    uint32_t outHeight    = getSizeOfDimension(outputShape, 1);
+    uint32_t outWidth     = getSizeOfDimension(outputShape, 2);
+
+    uint32_t paddingHeight =
+            ComputePadding(stride_height, height, filter_height, outHeight);
+    uint32_t paddingWidth =
+            ComputePadding(stride_width, width, filter_width, outWidth);
+
+    int32_t outputActivationMin = 0;
+    int32_t outputActivationMax = 0;
+    CalculateActivationRangeUint8(activation, outputShape,
+                                  &outputActivationMin, &outputActivationMax);
+
+    #define ANDROID_NN_AVERAGE_POOL_QUANT8(activation)                         \
+        optimized_ops::AveragePool<FusedActivationFunctionType::activation>(   \
+            inputData, convertShapeToDims(inputShape),                         \
+            stride_width, paddingWidth, paddingHeight,                         \
+            filter_width, filter_height,                                       \
+            outputActivationMin, outputActivationMax,                          \
+            outputData, convertShapeToDims(outputShape))
+
+    if (activation == kActivationNone) {
+        ANDROID_NN_AVERAGE_POOL_QUANT8(kNone);
+    }
+    if (activation == kActivationRelu) {
+        ANDROID_NN_AVERAGE_POOL_QUANT8(kRelu);
+    }
+    if (activation == kActivationRelu6) {
+        ANDROID_NN_AVERAGE_POOL_QUANT8(kRelu6);
+    }
+
+    #undef ANDROID_NN_AVERAGE_POOL_QUANT8
+
+    return true;
+}
+
 bool l2PoolFloat32(const float* inputData, const Shape& inputShape,
                    int32_t padding, int32_t stride_width, int32_t stride_height,
                    int32_t filter_width, int32_t filter_height, int32_t activation,
@@ -162,6 +212,56 @@ bool maxPoolFloat32(const float* inputData, const Shape& inputShape,
     return true;
 }
 
+bool maxPoolQuant8(const uint8_t* inputData, const Shape& inputShape,
+                  int32_t padding, int32_t stride_width, int32_t stride_height,
+                  int32_t filter_width, int32_t filter_height, int32_t activation,
+                  uint8_t* outputData, const Shape& outputShape) {
+    if (!SameQuantization(inputShape, outputShape)) {
+        LOG(ERROR) << "Quantized pooling needs the same quantization for its input and output";
+        return false;
+    }
+    if (outputShape.scale <= 0.f) {
+        LOG(ERROR) << "Quantized pooling needs a positive scale";
+        return false;
+    }
+    uint32_t height       = getSizeOfDimension(inputShape, 1);
+    uint32_t width        = getSizeOfDimension(inputShape, 2);
+    uint32_t outHeight    = getSizeOfDimension(outputShape, 1);
+    uint32_t outWidth     = getSizeOfDimension(outputShape, 2);
+
+    uint32_t paddingHeight =
+            ComputePadding(stride_height, height, filter_height, outHeight);
+    uint32_t paddingWidth =
+            ComputePadding(stride_width, width, filter_width, outWidth);
+
+    int32_t outputActivationMin = 0;
+    int32_t outputActivationMax = 0;
+    CalculateActivationRangeUint8(activation, outputShape,
+                                  &outputActivationMin, &outputActivationMax);
+
+    #define ANDROID_NN_MAX_POOL_QUANT8(activation)                             \
+        optimized_ops::MaxPool<FusedActivationFunctionType::activation>(       \
+            inputData, convertShapeToDims(inputShape),                         \
+            stride_width, paddingWidth, paddingHeight,                         \
+            filter_width, filter_height,                                       \
+            outputActivationMin, outputActivationMax,                          \
+            outputData, convertShapeToDims(outputShape))
+
+    if (activation == kActivationNone) {
+        ANDROID_NN_MAX_POOL_QUANT8(kNone);
+    }
+    if (activation == kActivationRelu) {
+        ANDROID_NN_MAX_POOL_QUANT8(kRelu);
+    }
+    if (activation == kActivationRelu6) {
+        ANDROID_NN_MAX_POOL_QUANT8(kRelu6);
+    }
+
+    #undef ANDROID_NN_MAX_POOL_QUANT8
+
+    return true;
+}
+
 
 
 }  // namespace nn
@@ -21,6 +21,8 @@
 #include "Operations.h"
 #include "OperationsUtils.h"
 
+#include "internal/optimized/optimized_ops.h"
+
 namespace android {
 namespace nn {
 
@@ -36,5 +38,43 @@ bool addTensorsFloat32(const float* in1, const float* in2, float* out, const Sha
     return true;
 }
 
+bool addTensorsQuant8(const uint8_t* in1, const Shape& shape1,
+                      const uint8_t* in2, const Shape& shape2,
+                      uint8_t* out, const Shape& shapeOut) {
+    if (shape1.scale <= 0.f || shape2.scale <= 0.f || shapeOut.scale <= 0.f) {
+        LOG(ERROR) << "Quantized operands need a positive scale";
+        return false;
+    }
+    // Both inputs are brought to a common scale, with enough headroom for
+    // the sum, before being rescaled to the output.
+    const int32_t leftShift = 20;
+    const double twiceMaxInputScale = 2.0 * std::max(shape1.scale, shape2.scale);
+    const double realInput1Multiplier = shape1.scale / twiceMaxInputScale;
+    const double realInput2Multiplier = shape2.scale / twiceMaxInputScale;
+    const double realOutputMultiplier =
+            twiceMaxInputScale / ((1 << leftShift) * static_cast<double>(shapeOut.scale));
+
+    int32_t input1Multiplier, input1Shift;
+    int32_t input2Multiplier, input2Shift;
+    int32_t outputMultiplier, outputShift;
+    if (!QuantizeMultiplierSmallerThanOne(realInput1Multiplier, &input1Multiplier,
+                                          &input1Shift) ||
+        !QuantizeMultiplierSmallerThanOne(realInput2Multiplier, &input2Multiplier,
+                                          &input2Shift) ||
+        !QuantizeMultiplierSmallerThanOne(realOutputMultiplier, &outputMultiplier,
+                                          &outputShift)) {
+        return false;
+    }
+
+    optimized_ops::Add(leftShift,
+                       in1, convertShapeToDims(shape1), -shape1.offset,
+                       input1Multiplier, input1Shift,
+                       in2, convertShapeToDims(shape2), -shape2.offset,
+                       input2Multiplier, input2Shift,
+                       shapeOut.offset, outputMultiplier, outputShift,
+                       out, convertShapeToDims(shapeOut));
+    return true;
+}
+
 } // namespace nn
 } // namespace android
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define LOG_TAG "ExecutionPlan"
+
+#include "ExecutionPlan.h"
+
+#include "Manager.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace android {
+namespace nn {
+
+void ExecutionPlan::initialize(const Model& model, const std::shared_ptr<Device>& device) {
+    mSteps.clear();
+    mHandoffSizes.clear();
+    if (device == nullptr) {
+        mKind = CPU_ONLY;
+        return;
+    }
+    const std::vector<bool> supported = device->getSupportedOperations(model);
+    const size_t supportedCount = std::count(supported.begin(), supported.end(), true);
+    if (supported.empty() || supportedCount == supported.size()) {
+        mKind = DEVICE_ONLY;
+    } else if (supportedCount == 0) {
+        mKind = CPU_ONLY;
+    } else if (partition(model, device, supported)) {
+        mKind = PARTITIONED;
+        LOG(DEBUG) << "Partitioned the model in " << mSteps.size() << " steps";
+    } else {
+        LOG(DEBUG) << "Can't partition the model, running it on the CPU";
+        mSteps.clear();
+        mHandoffSizes.clear();
+        mKind = CPU_ONLY;
+    }
+}
+
+bool ExecutionPlan::partition(const Model& model, const std::shared_ptr<Device>& device,
+                              const std::vector<bool>& supported) {
+    const uint32_t operandCount = static_cast<uint32_t>(model.operands.size());
+    const uint32_t operationCount = static_cast<uint32_t>(model.operations.size());
+    const uint32_t runTime = static_cast<uint32_t>(LocationValues::LOCATION_AT_RUN_TIME);
+
+    // The operations are in run order, so each step is a run of consecutive
+    // operations that go to the same place.
+    std::vector<uint32_t> stepOfOperation(operationCount);
+    uint32_t stepCount = 0;
+    for (uint32_t i = 0; i < operationCount; i++) {
+        if (i > 0 && supported[i] != supported[i - 1]) {
+            stepCount++;
+        }
+        stepOfOperation[i] = stepCount;
+    }
+    stepCount++;
+
+    // The last step that reads each operand, to know which ones have to be
+    // handed off.
+    std::vector<int32_t> lastReader(operandCount, -1);
+    for (uint32_t i = 0; i < operationCount; i++) {
+        for (uint32_t operandIndex : model.operations[i].inputs) {
+            lastReader[operandIndex] =
+                    std::max(lastReader[operandIndex], static_cast<int32_t>(stepOfOperation[i]));
+        }
+    }
+    std::vector<bool> isModelOutput(operandCount, false);
+    for (uint32_t i : model.outputIndexes) {
+        isModelOutput[i] = true;
+    }
+
+    mHandoffSizes.assign(operandCount, 0);
+    uint32_t first = 0;
+    for (uint32_t step = 0; step < stepCount; step++) {
+        uint32_t last = first;
+        while (last < operationCount && stepOfOperation[last] == step) {
+            last++;
+        }
+
+        std::unique_ptr<ExecutionStep> executionStep(new ExecutionStep());
+        executionStep->device = supported[first] ? device : nullptr;
+        std::vector<Operand> operands;
+        std::vector<Operation> operations;
+        std::vector<uint8_t> operandValues;
+        // The index in operands of each operand of the full model, or -1 if
+        // the step doesn't use it.
+        std::vector<int32_t> subIndex(operandCount, -1);
+        auto addOperand = [&](uint32_t operandIndex) -> uint32_t {
+            if (subIndex[operandIndex] < 0) {
+                Operand operand = model.operands[operandIndex];
+                operand.numberOfConsumers = 0;
+                if (operand.location.poolIndex ==
+                    static_cast<uint32_t>(LocationValues::LOCATION_SAME_BLOCK)) {
+                    const uint32_t length = operand.location.length;
+                    uint32_t offset = static_cast<uint32_t>(operandValues.size());
+                    offset += alignBytesNeeded(offset, length);
+                    operandValues.resize(offset + length);
+                    memcpy(&operandValues[offset], &model.operandValues[operand.location.offset],
+                           length);
+                    operand.location.offset = offset;
+                }
+                subIndex[operandIndex] = static_cast<int32_t>(operands.size());
+                operands.push_back(operand);
+            }
+            return static_cast<uint32_t>(subIndex[operandIndex]);
+        };
+
+        for (uint32_t i = first; i < last; i++) {
+            const Operation& operation = model.operations[i];
+            Operation subOperation = {.type = operation.type};
+            std::vector<uint32_t> inputs;
+            for (uint32_t operandIndex : operation.inputs) {
+                // A run-time operand the step hasn't seen yet isn't produced
+                // by it, so it comes from the request or an earlier step.
+                const bool isNew = subIndex[operandIndex] < 0;
+                const uint32_t sub = addOperand(operandIndex);
+                operands[sub].numberOfConsumers++;
+                inputs.push_back(sub);
+                if (isNew && model.operands[operandIndex].location.poolIndex == runTime) {
+                    executionStep->inputs.push_back(operandIndex);
+                }
+            }
+            std::vector<uint32_t> outputs;
+            for (uint32_t operandIndex : operation.outputs) {
+                outputs.push_back(addOperand(operandIndex));
+                const bool readLater = lastReader[operandIndex] > static_cast<int32_t>(step);
+                if (isModelOutput[operandIndex] || readLater) {
+                    executionStep->outputs.push_back(operandIndex);
+                }
+                if (readLater && !isModelOutput[operandIndex]) {
+                    const Operand& operand = model.operands[operandIndex];
+                    const uint32_t size = sizeOfData(operand.type, operand.dimensions);
+                    if (size == 0) {
+                        LOG(DEBUG) << "The size of operand " << operandIndex << " isn't known";
+                        return false;
+                    }
+                    mHandoffSizes[operandIndex] = size;
+                }
+            }
+            subOperation.inputs = inputs;
+            subOperation.outputs = outputs;
+            operations.push_back(subOperation);
+        }
+
+        std::vector<uint32_t> inputIndexes;
+        for (uint32_t operandIndex : executionStep->inputs) {
+            inputIndexes.push_back(subIndex[operandIndex]);
+        }
+        std::vector<uint32_t> outputIndexes;
+        for (uint32_t operandIndex : executionStep->outputs) {
+            outputIndexes.push_back(subIndex[operandIndex]);
+        }
+        Model& subModel = executionStep->model;
+        subModel.operands = operands;
+        subModel.operations = operations;
+        subModel.inputIndexes = inputIndexes;
+        subModel.outputIndexes = outputIndexes;
+        subModel.operandValues = operandValues;
+
+        if (executionStep->device != nullptr) {
+            executionStep->preparedModel =
+                    executionStep->device->getInterface()->prepareModel(subModel);
+            if (executionStep->preparedModel == nullptr) {
+                LOG(DEBUG) << "The driver can't prepare step " << step;
+                return false;
+            }
+        } else {
+            executionStep->memoryPlan.initialize(subModel);
+        }
+        mSteps.push_back(std::move(executionStep));
+        first = last;
+    }
+    return true;
+}
+
+} // namespace nn
+} // namespace android
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Splits a model between a driver and the CPU.
+
+#ifndef ANDROID_ML_NN_RUNTIME_EXECUTION_PLAN_H
+#define ANDROID_ML_NN_RUNTIME_EXECUTION_PLAN_H
+
+#include "HalInterfaces.h"
+#include "MemoryPlanner.h"
+
+#include <memory>
+#include <vector>
+
+namespace android {
+namespace nn {
+
+class Device;
+
+// A run of consecutive operations of a model that execute on the same
+// device.  It's a complete model of its own.
+struct ExecutionStep {
+    // The driver that runs the step, or nullptr for the CPU.
+    std::shared_ptr<Device> device;
+    Model model;
+    // The operands of the full model that are the inputs and outputs of
+    // model, in the order of its inputIndexes and outputIndexes.
+    std::vector<uint32_t> inputs;
+    std::vector<uint32_t> outputs;
+    // The model prepared by the driver, for steps that run on one.
+    sp<IPreparedModel> preparedModel;
+    // The temporaries, for steps that run on the CPU.
+    MemoryPlan memoryPlan;
+};
+
+// Decides where each operation of a model runs.  When the driver supports
+// all of them the whole model goes to the driver, and when it supports none
+// the model runs on the CPU.  Otherwise, the operations are split into steps
+// that alternate between the driver and the CPU, run one after the other in
+// the order of the model.
+class ExecutionPlan {
+public:
+    enum Kind {
+        CPU_ONLY,
+        DEVICE_ONLY,
+        PARTITIONED,
+    };
+
+    // The operations of model must be sorted in run order.
+    void initialize(const Model& model, const std::shared_ptr<Device>& device);
+
+    Kind getKind() const { return mKind; }
+    // Only set for PARTITIONED plans.
+    const std::vector<std::unique_ptr<ExecutionStep>>& getSteps() const { return mSteps; }
+    // The size of the buffer an operand is handed off through from one step
+    // to the next, or 0 if it's not handed off.
+    uint32_t getHandoffSize(uint32_t operandIndex) const {
+        return operandIndex < mHandoffSizes.size() ? mHandoffSizes[operandIndex] : 0;
+    }
+
+private:
+    // Builds the steps.  Returns false if the model can't be partitioned,
+    // e.g. because the size of a tensor handed off between steps isn't known.
+    bool partition(const Model& model, const std::shared_ptr<Device>& device,
+                   const std::vector<bool>& supported);
+
+    Kind mKind = CPU_ONLY;
+    std::vector<std::unique_ptr<ExecutionStep>> mSteps;
+    std::vector<uint32_t> mHandoffSizes;
+};
+
+} // namespace nn
+} // namespace android
+
+#endif // ANDROID_ML_NN_RUNTIME_EXECUTION_PLAN_H
@@ -42,6 +42,19 @@ void Device::initialize() {
     });
 }
 
+std::vector<bool> Device::getSupportedOperations(const Model& model) {
+    std::vector<bool> supported;
+    mInterface->getSupportedSubgraph(model, [&](const hidl_vec<bool>& canDo) {
+        supported.assign(canDo.begin(), canDo.end());
+    });
+    if (!supported.empty() && supported.size() != model.operations.size()) {
+        LOG(ERROR) << mName << " returned " << supported.size() << " supported flags for "
+                   << model.operations.size() << " operations";
+        supported.clear();
+    }
+    return supported;
+}
+
 DeviceManager* DeviceManager::get() {
     static DeviceManager manager;
     return &manager;
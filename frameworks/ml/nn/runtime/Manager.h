@@ -19,6 +19,8 @@
 
 #include "HalInterfaces.h"
 
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace android {
@@ -30,6 +32,9 @@ public:
     sp<IDevice> getInterface() { return mInterface; }
     const std::string& getName() { return mName; }
     void initialize();
+    // Returns which operations of the model the driver can run, in the
+    // order of model.operations.  Empty if the driver doesn't say.
+    std::vector<bool> getSupportedOperations(const Model& model);
 
 private:
     std::string mName;
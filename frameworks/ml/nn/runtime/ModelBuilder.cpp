@@ -18,9 +18,12 @@
 
 #include "ModelBuilder.h"
 
+#include "Operations.h"
 #include "RequestBuilder.h"
 #include "Utils.h"
 
+#include <algorithm>
+#include <cstring>
 #include <map>
 #include <utility>
 
@@ -46,10 +49,21 @@ int ModelBuilder::addOperand(const ANeuralNetworksOperandType& type) {
                       .offset = 0,
                       .length = 0};
     entry.numberOfConsumers = 0;
+    mOperandQuantization.push_back({.scale = type.scale,
+                                    .offset = static_cast<int32_t>(type.offset)});
 
     return ANEURALNETWORKS_NO_ERROR;
 }
 
+bool ModelBuilder::hasQuantizedOperands() const {
+    for (const Operand& operand : mOperands) {
+        if (operand.type == OperandType::TENSOR_SYMMETRICAL_QUANT8) {
+            return true;
+        }
+    }
+    return false;
+}
+
 int ModelBuilder::setOperandValue(uint32_t index, const void* buffer, size_t length) {
     //    auto roundUp = [](size_t x) { return (x + 0xF) & ~0xF; };
 
@@ -135,10 +149,151 @@ RequestBuilder* ModelBuilder::createRequest() {
 
 void ModelBuilder::finishTheModel() {
     if (!mCompletedModel) {
+        fuseActivations();
         // We sort the operations so that they will be in the appropriate
         // order for a single-threaded, op at a time execution.
         sortIntoRunOrder();
         mCompletedModel = true;
+        // The lifetimes of the temporaries only depend on the model, so
+        // we plan their memory once here rather than on every request.
+        setHidlModel(&mHidlModel);
+        mMemoryPlan.initialize(mHidlModel);
+    }
+}
+
+sp<IPreparedModel> ModelBuilder::getPreparedModel(const sp<IDevice>& driver,
+                                                  const Model& model) const {
+    std::lock_guard<std::mutex> lock(mPreparedModelsMutex);
+    for (const auto& entry : mPreparedModels) {
+        if (entry.first == driver) {
+            return entry.second;
+        }
+    }
+    sp<IPreparedModel> preparedModel = driver->prepareModel(model);
+    if (preparedModel != nullptr) {
+        mPreparedModels.push_back({driver, preparedModel});
+    }
+    return preparedModel;
+}
+
+const ExecutionPlan* ModelBuilder::getExecutionPlan(const std::shared_ptr<Device>& device) const {
+    std::lock_guard<std::mutex> lock(mExecutionPlansMutex);
+    for (const auto& entry : mExecutionPlans) {
+        if (entry.first == device) {
+            return entry.second.get();
+        }
+    }
+    std::unique_ptr<ExecutionPlan> plan(new ExecutionPlan());
+    plan->initialize(mHidlModel, device);
+    mExecutionPlans.push_back({device, std::move(plan)});
+    return mExecutionPlans.back().second.get();
+}
+
+// Returns the index of the input that holds the fused activation of the
+// operation, or -1 if it doesn't have one.
+static int getFusedActivationInput(const Operation& operation) {
+    switch (operation.type) {
+        case OperationType::CONV_FLOAT32:
+        case OperationType::AVERAGE_POOL_FLOAT32:
+        case OperationType::L2_POOL_FLOAT32:
+        case OperationType::MAX_POOL_FLOAT32:
+            return operation.inputs.size() == 7 ? 6 : -1;
+        case OperationType::DEPTHWISE_CONV_FLOAT32:
+            return operation.inputs.size() == 8 ? 7 : -1;
+        default:
+            return -1;
+    }
+}
+
+void ModelBuilder::fuseActivations() {
+    std::vector<int32_t> producer(operandCount(), -1);
+    for (uint32_t operationIndex = 0; operationIndex < operationCount(); operationIndex++) {
+        for (uint32_t i : mOperations[operationIndex].outputs) {
+            producer[i] = operationIndex;
+        }
+    }
+    auto isModelInputOrOutput = [this](uint32_t operandIndex) {
+        return std::find(mInputIndexes.begin(), mInputIndexes.end(), operandIndex) !=
+                       mInputIndexes.end() ||
+               std::find(mOutputIndexes.begin(), mOutputIndexes.end(), operandIndex) !=
+                       mOutputIndexes.end();
+    };
+
+    std::vector<bool> fused(operationCount(), false);
+    for (uint32_t operationIndex = 0; operationIndex < operationCount(); operationIndex++) {
+        const Operation& activation = mOperations[operationIndex];
+        int32_t fusedCode;
+        if (activation.type == OperationType::RELU_FLOAT32) {
+            fusedCode = kActivationRelu;
+        } else if (activation.type == OperationType::RELU6_FLOAT32) {
+            fusedCode = kActivationRelu6;
+        } else {
+            continue;
+        }
+        if (activation.inputs.size() != 1 || activation.outputs.size() != 1) {
+            continue;
+        }
+        // The intermediate tensor must only exist to feed the activation.
+        const uint32_t intermediate = activation.inputs[0];
+        const uint32_t output = activation.outputs[0];
+        if (producer[intermediate] < 0 || mOperands[intermediate].numberOfConsumers != 1 ||
+            isModelInputOrOutput(intermediate) ||
+            mOperands[intermediate].type != mOperands[output].type ||
+            mOperandQuantization[intermediate].scale != mOperandQuantization[output].scale ||
+            mOperandQuantization[intermediate].offset != mOperandQuantization[output].offset) {
+            continue;
+        }
+        Operation& source = mOperations[producer[intermediate]];
+        const int activationInput = getFusedActivationInput(source);
+        if (activationInput < 0 || source.outputs.size() != 1) {
+            continue;
+        }
+        // Only a constant activation that is still none can be replaced.
+        const Operand& current = mOperands[source.inputs[activationInput]];
+        if (current.location.poolIndex !=
+                    static_cast<uint32_t>(LocationValues::LOCATION_SAME_BLOCK) ||
+            current.location.length != sizeof(int32_t)) {
+            continue;
+        }
+        int32_t currentCode;
+        memcpy(&currentCode, &mOperandValues[current.location.offset], sizeof(currentCode));
+        if (currentCode != kActivationNone) {
+            continue;
+        }
+
+        // The activation scalar may be shared with other operations, so
+        // the fused one gets its own.
+        const uint32_t fusedOperand = operandCount();
+        ANeuralNetworksOperandType scalarType = {.type = ANEURALNETWORKS_INT32,
+                                                 .dimensions = {.count = 0, .data = nullptr},
+                                                 .scale = 0.f,
+                                                 .offset = 0.f};
+        if (addOperand(scalarType) != ANEURALNETWORKS_NO_ERROR ||
+            setOperandValue(fusedOperand, &fusedCode, sizeof(fusedCode)) !=
+                    ANEURALNETWORKS_NO_ERROR) {
+            break;
+        }
+        mOperands[source.inputs[activationInput]].numberOfConsumers--;
+        source.inputs[activationInput] = fusedOperand;
+        mOperands[fusedOperand].numberOfConsumers = 1;
+
+        // The source now writes directly to the output of the activation.
+        source.outputs[0] = output;
+        producer[output] = producer[intermediate];
+        producer[intermediate] = -1;
+        mOperands[intermediate].numberOfConsumers = 0;
+        fused[operationIndex] = true;
+    }
+
+    std::vector<Operation> remaining;
+    for (uint32_t operationIndex = 0; operationIndex < operationCount(); operationIndex++) {
+        if (!fused[operationIndex]) {
+            remaining.push_back(mOperations[operationIndex]);
+        }
+    }
+    if (remaining.size() != mOperations.size()) {
+        LOG(DEBUG) << "Fused " << mOperations.size() - remaining.size() << " activations";
+        mOperations = remaining;
     }
 }
 
@@ -20,13 +20,22 @@
 #ifndef ANDROID_ML_NN_RUNTIME_MODEL_BUILDER_H
 #define ANDROID_ML_NN_RUNTIME_MODEL_BUILDER_H
 
+#include "ExecutionPlan.h"
 #include "HalInterfaces.h"
+#include "MemoryPlanner.h"
 #include "NeuralNetworks.h"
+#include "OperationsUtils.h"
 #include "Utils.h"
 
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 namespace android {
 namespace nn {
 
+class Device;
 class RequestBuilder;
 
 class ModelBuilder {
@@ -59,11 +68,35 @@ public:
     uint32_t getInputOperandIndex(uint32_t i) const { return mInputIndexes[i]; }
     uint32_t getOutputOperandIndex(uint32_t i) const { return mOutputIndexes[i]; }
     const Operand& getOperand(uint32_t index) const { return mOperands[index]; }
+    // Where the temporaries go when the model is run on the CPU.  Only valid
+    // once the model has been completed.
+    const MemoryPlan* getMemoryPlan() const { return &mMemoryPlan; }
+    // The HIDL version of the model.  Only valid once the model has been
+    // completed.
+    const Model& getHidlModel() const { return mHidlModel; }
+    // Returns the model prepared by driver, preparing it on the first call
+    // for that driver.  model must be the one returned by getHidlModel().
+    sp<IPreparedModel> getPreparedModel(const sp<IDevice>& driver, const Model& model) const;
+    // Returns how the model is split between device and the CPU, computing
+    // it on the first call for that device.  Only valid once the model has
+    // been completed.
+    const ExecutionPlan* getExecutionPlan(const std::shared_ptr<Device>& device) const;
+    // The quantization of each operand.  The HAL model can't carry it, so it's
+    // passed to the CpuExecutor separately.
+    const std::vector<OperandQuantization>* getOperandQuantization() const {
+        return &mOperandQuantization;
+    }
+    // Whether any operand is a quantized tensor.  Drivers don't get the
+    // quantization, so these models only run on the CPU.
+    bool hasQuantizedOperands() const;
 
 private:
     // Sorts the operations to be in the correct order for single threaded
     // node-at-a-time execution.
     void sortIntoRunOrder();
+    // Folds RELU and RELU6 operations into the fused activation of the
+    // operation that produces their input, when nothing else reads it.
+    void fuseActivations();
     /*
     int32_t getOperandIndex(const ArrayInfo& info, uint32_t listIndex) const {
         nnAssert(listIndex < info.count);
@@ -76,6 +109,8 @@ private:
     std::vector<Operation> mOperations;
     // The description of the operands of the graph.
     std::vector<Operand> mOperands;
+    // The quantization of each operand in mOperands.
+    std::vector<OperandQuantization> mOperandQuantization;
     // Specifies where to find the list of indexes identifying
     // the inputs and outputs of the model.  The offset is into
     // the mOperandIndexes table.
@@ -91,6 +126,21 @@ private:
     // Once the request has been created, we should not allow further
     // modifications to the model.
     mutable bool mCompletedModel = false;
+
+    // Computed when the model is completed.
+    MemoryPlan mMemoryPlan;
+    Model mHidlModel;
+
+    // The models prepared by each of the drivers it ran on.  Preparing can
+    // be expensive, so it's done once rather than for every request.
+    mutable std::mutex mPreparedModelsMutex;
+    mutable std::vector<std::pair<sp<IDevice>, sp<IPreparedModel>>> mPreparedModels;
+
+    // The plans for each of the devices the model ran on.  Computing one
+    // asks the driver what it supports and prepares the parts it runs.
+    mutable std::mutex mExecutionPlansMutex;
+    mutable std::vector<std::pair<std::shared_ptr<Device>, std::unique_ptr<ExecutionPlan>>>
+            mExecutionPlans;
 };
 
 } // namespace nn
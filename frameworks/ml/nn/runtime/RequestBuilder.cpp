@@ -19,9 +19,11 @@
 #include "RequestBuilder.h"
 
 #include "CpuExecutor.h"
+#include "ExecutionPlan.h"
 #include "HalInterfaces.h"
 #include "Manager.h"
 #include "ModelBuilder.h"
+#include "Profiler.h"
 
 namespace android {
 namespace nn {
@@ -109,16 +111,55 @@ int RequestBuilder::startCompute(Event** event) {
     }
     LOG(DEBUG) << "RequestBuilder::startCompute";
 
-    std::shared_ptr<Device> device = DeviceManager::get()->getAvailableDriver();
-    Model model;
-    mModel->setHidlModel(&model);
-
-    return device == nullptr ? startComputeOnCpu(event, model)
-                             : startComputeOnDevice(device->getInterface(), model, event);
+    // The HAL has no way to describe quantized operands yet, so only the CPU
+    // path can run them.
+    std::shared_ptr<Device> device = mModel->hasQuantizedOperands()
+            ? nullptr
+            : DeviceManager::get()->getAvailableDriver();
+    // The model was converted once when it was completed.
+    const Model& model = mModel->getHidlModel();
+    // The parts of the model the driver can't run go to the CPU.
+    const ExecutionPlan* plan = mModel->getExecutionPlan(device);
+
+    const bool profiling = Profiler::get()->isEnabled();
+    const auto start = profiling ? std::chrono::steady_clock::now()
+                                 : std::chrono::steady_clock::time_point();
+    int n;
+    switch (plan->getKind()) {
+        case ExecutionPlan::DEVICE_ONLY:
+            n = startComputeOnDevice(device->getInterface(), model, event);
+            break;
+        case ExecutionPlan::PARTITIONED:
+            n = startComputePartitioned(*plan, event);
+            break;
+        case ExecutionPlan::CPU_ONLY:
+        default:
+            device = nullptr;
+            n = startComputeOnCpu(event, model);
+            break;
+    }
+    if (profiling && n == ANEURALNETWORKS_NO_ERROR) {
+        // The execution is synchronous for now, so this covers the whole
+        // request, including the copies to and from shared memory.
+        uint64_t bytesTouched = 0;
+        for (const auto& info : mInputs) {
+            bytesTouched += info.location.length;
+        }
+        for (const auto& info : mOutputs) {
+            bytesTouched += info.location.length;
+        }
+        Profiler::get()->record({.device = device == nullptr ? "cpu" : device->getName(),
+                                 .operationIndex = Profiler::kWholeRequest,
+                                 .operationType = OperationType(),
+                                 .durationNs = Profiler::nanosecondsSince(start),
+                                 .bytesTouched = bytesTouched});
+    }
+    return n;
 }
 
 // Figures out how to place each of the input or outputs in a buffer. This just does the layout,
-// it does not copy data.  Returns the total size.  Aligns each input a bit.
+// it does not copy data.  Aligns each input a bit.  The pool is only allocated if the one left
+// by a previous execution is too small.
 template <typename T>
 static int allocateToPool(uint32_t poolId, std::vector<InputOutputInfo>* ioInfos,
                           hidl_memory* pool) {
@@ -135,41 +176,40 @@ static int allocateToPool(uint32_t poolId, std::vector<InputOutputInfo>* ioInfos
                       "2^32.";
         return ANEURALNETWORKS_BAD_DATA;
     }
-    // Copy the input data to a shared memory buffer.
-    *pool = allocateSharedMemory(total); // TODO check error
+    if (pool->size() < static_cast<uint64_t>(total)) {
+        *pool = allocateSharedMemory(total); // TODO check error
+    }
     return ANEURALNETWORKS_NO_ERROR;
 }
 
-int RequestBuilder::startComputeOnDevice(sp<IDevice> driver, const Model& model, Event** event) {
-    LOG(DEBUG) << "RequestBuilder::startComputeOnDevice0";
-    // TODO Dangerous!  In async, the model will outlive it here. Safe for now
-    sp<IPreparedModel> preparedModel = driver->prepareModel(model);
-    if (preparedModel == nullptr) {
-        return ANEURALNETWORKS_OP_FAILED;
-    }
-
+// Runs a request on a driver, copying the inputs and outputs through the
+// shared memory in pools.
+static int executeOnDevice(const sp<IPreparedModel>& preparedModel,
+                           std::vector<InputOutputInfo>* inputs,
+                           const std::vector<const void*>& inputBuffers,
+                           std::vector<InputOutputInfo>* outputs,
+                           const std::vector<void*>& outputBuffers, hidl_vec<hidl_memory>* pools) {
     // We have two pools:
     // 0: input data
     // 1: output data
     // TODO: Revise this once we support pools for data
     const int INPUT = 0;
     const int OUTPUT = 1;
-    hidl_vec<hidl_memory> pools;
-    pools.resize(2);
+    pools->resize(2);
 
     // Layout the input and output data.
-    int n = allocateToPool<const void*>(INPUT, &mInputs, &pools[INPUT]);
+    int n = allocateToPool<const void*>(INPUT, inputs, &(*pools)[INPUT]);
     if (n != ANEURALNETWORKS_NO_ERROR) {
         return n;
     }
 
-    n = allocateToPool<void*>(OUTPUT, &mOutputs, &pools[OUTPUT]);
+    n = allocateToPool<void*>(OUTPUT, outputs, &(*pools)[OUTPUT]);
     if (n != ANEURALNETWORKS_NO_ERROR) {
         return n;
     }
 
     // Copy the input data to the shared memory.
-    sp<IMemory> inputMemory = mapMemory(pools[INPUT]);
+    sp<IMemory> inputMemory = mapMemory((*pools)[INPUT]);
     if (inputMemory == nullptr) {
         LOG(ERROR) << "ANeuralNetworksRequest_startCompute Can't create shared memory.";
         return ANEURALNETWORKS_OP_FAILED;
@@ -177,30 +217,30 @@ int RequestBuilder::startComputeOnDevice(sp<IDevice> driver, const Model& model,
 
     inputMemory->update();
     void* data = static_cast<void*>(inputMemory->getPointer());
-    for (size_t i = 0; i < mInputs.size(); i++) {
-        auto& info = mInputs[i];
-        memcpy(reinterpret_cast<uint8_t*>(data) + info.location.offset, mInputBuffers[i],
+    for (size_t i = 0; i < inputs->size(); i++) {
+        auto& info = (*inputs)[i];
+        memcpy(reinterpret_cast<uint8_t*>(data) + info.location.offset, inputBuffers[i],
                info.location.length);
     }
 
     inputMemory->commit();
 
     // Map the output shared memory.
-    sp<IMemory> outputMemory = mapMemory(pools[OUTPUT]);
+    sp<IMemory> outputMemory = mapMemory((*pools)[OUTPUT]);
     if (outputMemory == nullptr) {
         LOG(ERROR) << "ANeuralNetworksRequest_startCompute Can't create shared memory.";
         return ANEURALNETWORKS_OP_FAILED;
     }
 
     Request request;
-    request.inputs = mInputs;
-    request.outputs = mOutputs;
-    request.pools = pools;
+    request.inputs = *inputs;
+    request.outputs = *outputs;
+    request.pools = *pools;
 
     LOG(DEBUG) << "Before preparedModel->execute()";
-    LOG(DEBUG) << "With inputs " << toString(mInputs);
-    LOG(DEBUG) << "With outputs " << toString(mOutputs);
-    LOG(DEBUG) << "With pools " << toString(pools);
+    LOG(DEBUG) << "With inputs " << toString(*inputs);
+    LOG(DEBUG) << "With outputs " << toString(*outputs);
+    LOG(DEBUG) << "With pools " << toString(*pools);
     // Execute the request.
     if (!preparedModel->execute(request)) {
         LOG(DEBUG) << "**Execute failed**";
@@ -210,11 +250,26 @@ int RequestBuilder::startComputeOnDevice(sp<IDevice> driver, const Model& model,
     // Copy the output data from shared memory to the output buffers.
     outputMemory->update();
     data = static_cast<void*>(outputMemory->getPointer());
-    for (size_t i = 0; i < mOutputs.size(); i++) {
-        auto& info = mOutputs[i];
-        memcpy(mOutputBuffers[i], reinterpret_cast<uint8_t*>(data) + info.location.offset,
+    for (size_t i = 0; i < outputs->size(); i++) {
+        auto& info = (*outputs)[i];
+        memcpy(outputBuffers[i], reinterpret_cast<uint8_t*>(data) + info.location.offset,
                info.location.length);
     }
+    return ANEURALNETWORKS_NO_ERROR;
+}
+
+int RequestBuilder::startComputeOnDevice(sp<IDevice> driver, const Model& model, Event** event) {
+    LOG(DEBUG) << "RequestBuilder::startComputeOnDevice0";
+    // The model is only prepared by the driver on the first execution.
+    sp<IPreparedModel> preparedModel = mModel->getPreparedModel(driver, model);
+    if (preparedModel == nullptr) {
+        return ANEURALNETWORKS_OP_FAILED;
+    }
+    int n = executeOnDevice(preparedModel, &mInputs, mInputBuffers, &mOutputs, mOutputBuffers,
+                            &mPools);
+    if (n != ANEURALNETWORKS_NO_ERROR) {
+        return n;
+    }
     LOG(DEBUG) << "RequestBuilder::startComputeOnDevice completed";
 
     *event = new Event(); // TODO pass ievent
@@ -232,28 +287,99 @@ static void assignOnePerPool(const std::vector<T> buffers, hidl_vec<InputOutputI
     }
 }
 
-int RequestBuilder::startComputeOnCpu(Event** event, const Model& model) {
-    // TODO: use a thread pool
-    Event* e = new Event();
-    *event = e;
-
+// Runs a request on the CPU, reading and writing the buffers in place.
+static int executeOnCpu(const Model& model, const MemoryPlan* memoryPlan,
+                        const std::vector<OperandQuantization>* quantization,
+                        const std::vector<InputOutputInfo>& inputs,
+                        const std::vector<const void*>& inputBuffers,
+                        const std::vector<InputOutputInfo>& outputs,
+                        const std::vector<void*>& outputBuffers) {
     Request request;
-    request.inputs = mInputs;
-    request.outputs = mOutputs;
+    request.inputs = inputs;
+    request.outputs = outputs;
     // Create as many pools as there are input / output.
     // TODO This will need to be revised once we accept pool location
     // for input values.
-    const size_t totalSize = mInputs.size() + mOutputs.size();
+    const size_t totalSize = inputs.size() + outputs.size();
     request.pools.resize(totalSize);
     std::vector<RunTimePoolInfo> runTimePoolInfos;
     runTimePoolInfos.resize(totalSize);
 
     uint32_t poolIndex = 0;
-    assignOnePerPool<const void*>(mInputBuffers, &request.inputs, &runTimePoolInfos, &poolIndex);
-    assignOnePerPool<void*>(mOutputBuffers, &request.outputs, &runTimePoolInfos, &poolIndex);
+    assignOnePerPool<const void*>(inputBuffers, &request.inputs, &runTimePoolInfos, &poolIndex);
+    assignOnePerPool<void*>(outputBuffers, &request.outputs, &runTimePoolInfos, &poolIndex);
 
     CpuExecutor executor;
-    return executor.run(model, request, runTimePoolInfos);
+    return executor.run(model, request, runTimePoolInfos, memoryPlan, quantization);
+}
+
+int RequestBuilder::startComputeOnCpu(Event** event, const Model& model) {
+    // TODO: use a thread pool
+    Event* e = new Event();
+    *event = e;
+    return executeOnCpu(model, mModel->getMemoryPlan(), mModel->getOperandQuantization(), mInputs,
+                        mInputBuffers, mOutputs, mOutputBuffers);
+}
+
+void RequestBuilder::getStepBuffer(const ExecutionPlan& plan, uint32_t operandIndex,
+                                   InputOutputInfo* info, void** buffer) {
+    for (uint32_t i = 0; i < mInputs.size(); i++) {
+        if (mModel->getInputOperandIndex(i) == operandIndex) {
+            *info = mInputs[i];
+            *buffer = const_cast<void*>(mInputBuffers[i]);
+            return;
+        }
+    }
+    // A step can read a model output written by an earlier one.
+    for (uint32_t i = 0; i < mOutputs.size(); i++) {
+        if (mModel->getOutputOperandIndex(i) == operandIndex) {
+            *info = mOutputs[i];
+            *buffer = mOutputBuffers[i];
+            return;
+        }
+    }
+    const uint32_t size = plan.getHandoffSize(operandIndex);
+    std::vector<uint8_t>& handoff = mHandoffBuffers[operandIndex];
+    handoff.resize(size);
+    *info = {};
+    info->location.length = size;
+    *buffer = handoff.data();
+}
+
+int RequestBuilder::startComputePartitioned(const ExecutionPlan& plan, Event** event) {
+    LOG(DEBUG) << "RequestBuilder::startComputePartitioned";
+    const auto& steps = plan.getSteps();
+    mHandoffBuffers.resize(mModel->operandCount());
+    mStepPools.resize(steps.size());
+    for (size_t s = 0; s < steps.size(); s++) {
+        const ExecutionStep& step = *steps[s];
+        std::vector<InputOutputInfo> inputs(step.inputs.size());
+        std::vector<const void*> inputBuffers(step.inputs.size());
+        for (size_t i = 0; i < step.inputs.size(); i++) {
+            void* buffer;
+            getStepBuffer(plan, step.inputs[i], &inputs[i], &buffer);
+            inputBuffers[i] = buffer;
+        }
+        std::vector<InputOutputInfo> outputs(step.outputs.size());
+        std::vector<void*> outputBuffers(step.outputs.size());
+        for (size_t i = 0; i < step.outputs.size(); i++) {
+            getStepBuffer(plan, step.outputs[i], &outputs[i], &outputBuffers[i]);
+        }
+
+        int n = step.device != nullptr
+                ? executeOnDevice(step.preparedModel, &inputs, inputBuffers, &outputs,
+                                  outputBuffers, &mStepPools[s])
+                : executeOnCpu(step.model, &step.memoryPlan, nullptr, inputs, inputBuffers,
+                               outputs, outputBuffers);
+        if (n != ANEURALNETWORKS_NO_ERROR) {
+            LOG(ERROR) << "ANeuralNetworksRequest_startCompute step " << s << " failed";
+            return n;
+        }
+    }
+    LOG(DEBUG) << "RequestBuilder::startComputePartitioned completed";
+
+    *event = new Event(); // TODO pass ievent
+    return ANEURALNETWORKS_NO_ERROR;
 }
 
 } // namespace nn
@@ -25,6 +25,7 @@
 namespace android {
 namespace nn {
 
+class ExecutionPlan;
 class ModelBuilder;
 
 // TODO
@@ -54,6 +55,14 @@ private:
                                    uint32_t length, uint32_t operandIndex);
     int startComputeOnDevice(sp<IDevice> driver, const Model& model, Event** event);
     int startComputeOnCpu(Event** event, const Model& model);
+    // Runs the steps of the plan one after the other, handing the tensors
+    // they share off through host buffers.
+    int startComputePartitioned(const ExecutionPlan& plan, Event** event);
+    // Returns where a step reads or writes an operand of the full model: the
+    // buffer of the request for model inputs and outputs, a handoff buffer
+    // otherwise.
+    void getStepBuffer(const ExecutionPlan& plan, uint32_t operandIndex, InputOutputInfo* info,
+                       void** buffer);
 
     const ModelBuilder* mModel;
     // Whether the application prefers to go fast or use low power for this request.
@@ -68,6 +77,14 @@ private:
     std::vector<InputOutputInfo> mOutputs;
     std::vector<const void*> mInputBuffers;
     std::vector<void*> mOutputBuffers;
+    // The shared memory the inputs and outputs are copied through when
+    // running on a driver.  Kept so that computing the same request again
+    // doesn't have to allocate it again.
+    hidl_vec<hidl_memory> mPools;
+    // The same for the steps of a partitioned model, along with the buffers
+    // of the operands handed off between steps, indexed by operand.
+    std::vector<hidl_vec<hidl_memory>> mStepPools;
+    std::vector<std::vector<uint8_t>> mHandoffBuffers;
 };
 
 } // namespace nn
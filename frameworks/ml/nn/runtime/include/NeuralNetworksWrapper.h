@@ -60,10 +60,14 @@ struct OperandType {
     // uint32_t type;
     std::vector<uint32_t> dimensions;
 
-    OperandType(Type type, const std::vector<uint32_t>& d) : dimensions(d) {
+    OperandType(Type type, const std::vector<uint32_t>& d, float scale = 0.0f,
+                float offset = 0.0f)
+        : dimensions(d) {
         operandType.type = static_cast<uint32_t>(type);
         operandType.dimensions.count = static_cast<uint32_t>(dimensions.size());
         operandType.dimensions.data = dimensions.data();
+        operandType.scale = scale;
+        operandType.offset = offset;
     }
 };
 
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs a few canned models and prints their latency percentiles, as well as
+// where the time went per operation type when they run on the CPU.
+//
+// Usage: NeuralNetworksBenchmark [--cpu] [iterations]
+
+#include "Manager.h"
+#include "NeuralNetworksWrapper.h"
+#include "Profiler.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+// The HIDL types with the same names are visible too, so the wrapper ones
+// are always qualified.
+namespace wrapper = android::nn::wrapper;
+using android::nn::ProfileEntry;
+using android::nn::Profiler;
+
+namespace {
+
+// Padding and activation codes as used by the CpuExecutor.
+const int32_t kPaddingSame = 1;
+const int32_t kActivationRelu = 1;
+
+const uint32_t kHeight = 56;
+const uint32_t kWidth = 56;
+const uint32_t kDepth = 32;
+const uint32_t kLayers = 4;
+
+// Adds a constant INT32 scalar to the model.
+uint32_t addScalar(wrapper::Model* model, int32_t value) {
+    wrapper::OperandType scalarType(wrapper::Type::INT32, {});
+    uint32_t index = model->addOperand(&scalarType);
+    model->setOperandValue(index, &value, sizeof(value));
+    return index;
+}
+
+// Adds a constant tensor filled with small values to the model.
+uint32_t addConstantTensor(wrapper::Model* model, const std::vector<uint32_t>& dimensions) {
+    wrapper::OperandType type(wrapper::Type::TENSOR_FLOAT32, dimensions);
+    uint32_t count = 1;
+    for (uint32_t d : dimensions) {
+        count *= d;
+    }
+    std::vector<float> values(count);
+    for (uint32_t i = 0; i < count; i++) {
+        values[i] = static_cast<float>(i % 7) / 64.f;
+    }
+    uint32_t index = model->addOperand(&type);
+    model->setOperandValue(index, values.data(), values.size() * sizeof(float));
+    return index;
+}
+
+// A stack of 3x3 convolutions.
+void createConvModel(wrapper::Model* model) {
+    wrapper::OperandType tensorType(wrapper::Type::TENSOR_FLOAT32, {1, kHeight, kWidth, kDepth});
+    uint32_t current = model->addOperand(&tensorType);
+    const uint32_t input = current;
+    for (uint32_t layer = 0; layer < kLayers; layer++) {
+        uint32_t filter = addConstantTensor(model, {kDepth, 3, 3, kDepth});
+        uint32_t bias = addConstantTensor(model, {kDepth});
+        uint32_t output = model->addOperand(&tensorType);
+        model->addOperation(ANEURALNETWORKS_CONV,
+                            {current, filter, bias, addScalar(model, kPaddingSame),
+                             addScalar(model, 1), addScalar(model, 1),
+                             addScalar(model, kActivationRelu)},
+                            {output});
+        current = output;
+    }
+    model->setInputsAndOutputs({input}, {current});
+}
+
+// A stack of 3x3 depthwise convolutions.
+void createDepthwiseConvModel(wrapper::Model* model) {
+    wrapper::OperandType tensorType(wrapper::Type::TENSOR_FLOAT32, {1, kHeight, kWidth, kDepth});
+    uint32_t current = model->addOperand(&tensorType);
+    const uint32_t input = current;
+    for (uint32_t layer = 0; layer < kLayers; layer++) {
+        uint32_t filter = addConstantTensor(model, {1, 3, 3, kDepth});
+        uint32_t bias = addConstantTensor(model, {kDepth});
+        uint32_t output = model->addOperand(&tensorType);
+        model->addOperation(ANEURALNETWORKS_DEPTHWISE_CONV,
+                            {current, filter, bias, addScalar(model, kPaddingSame),
+                             addScalar(model, 1), addScalar(model, 1), addScalar(model, 1),
+                             addScalar(model, kActivationRelu)},
+                            {output});
+        current = output;
+    }
+    model->setInputsAndOutputs({input}, {current});
+}
+
+// Alternating 3x3 average and max pools.
+void createPoolingModel(wrapper::Model* model) {
+    wrapper::OperandType tensorType(wrapper::Type::TENSOR_FLOAT32, {1, kHeight, kWidth, kDepth});
+    uint32_t current = model->addOperand(&tensorType);
+    const uint32_t input = current;
+    for (uint32_t layer = 0; layer < kLayers; layer++) {
+        uint32_t output = model->addOperand(&tensorType);
+        model->addOperation(layer % 2 == 0 ? ANEURALNETWORKS_AVERAGE_POOL
+                                           : ANEURALNETWORKS_MAX_POOL,
+                            {current, addScalar(model, kPaddingSame), addScalar(model, 1),
+                             addScalar(model, 1), addScalar(model, 3), addScalar(model, 3),
+                             addScalar(model, kActivationRelu)},
+                            {output});
+        current = output;
+    }
+    model->setInputsAndOutputs({input}, {current});
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+bool runBenchmark(const char* name, void (*create)(wrapper::Model*), int iterations) {
+    wrapper::Model model;
+    create(&model);
+    if (!model.isValid()) {
+        printf("%s: invalid model\n", name);
+        return false;
+    }
+    std::vector<float> input(kHeight * kWidth * kDepth, 0.5f);
+    std::vector<float> output(input.size());
+    const size_t size = input.size() * sizeof(float);
+
+    std::vector<double> latenciesMs;
+    Profiler::get()->takeEntries();
+    for (int i = 0; i < iterations; i++) {
+        wrapper::Request request(&model);
+        if (request.setInput(0, input.data(), size) != wrapper::Result::NO_ERROR ||
+            request.setOutput(0, output.data(), size) != wrapper::Result::NO_ERROR) {
+            printf("%s: can't set the inputs and outputs\n", name);
+            return false;
+        }
+        auto start = std::chrono::steady_clock::now();
+        if (request.compute() != wrapper::Result::NO_ERROR) {
+            printf("%s: compute failed\n", name);
+            return false;
+        }
+        latenciesMs.push_back(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(latenciesMs.begin(), latenciesMs.end());
+    printf("%-16s p50 %8.3f ms  p90 %8.3f ms  p99 %8.3f ms  max %8.3f ms\n", name,
+           percentile(latenciesMs, 0.5), percentile(latenciesMs, 0.9),
+           percentile(latenciesMs, 0.99), latenciesMs.back());
+
+    // Break down the time spent in each type of operation on the CPU, and
+    // in each device overall.
+    struct Total {
+        int64_t durationNs = 0;
+        uint64_t bytesTouched = 0;
+        uint32_t count = 0;
+    };
+    std::map<std::string, Total> totals;
+    for (const ProfileEntry& entry : Profiler::get()->takeEntries()) {
+        std::string key = entry.operationIndex == Profiler::kWholeRequest
+                ? "request on " + entry.device
+                : android::nn::getOperationName(entry.operationType);
+        Total& total = totals[key];
+        total.durationNs += entry.durationNs;
+        total.bytesTouched += entry.bytesTouched;
+        total.count++;
+    }
+    for (const auto& total : totals) {
+        const double meanMs = total.second.durationNs / 1e6 / total.second.count;
+        const double gbPerSecond = total.second.durationNs == 0
+                ? 0.0
+                : static_cast<double>(total.second.bytesTouched) / total.second.durationNs;
+        printf("  %-28s %6u runs  mean %8.3f ms  %6.2f GB/s\n", total.first.c_str(),
+               total.second.count, meanMs, gbPerSecond);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool cpuOnly = false;
+    int iterations = 50;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cpu") == 0) {
+            cpuOnly = true;
+        } else {
+            iterations = std::max(1, atoi(argv[i]));
+        }
+    }
+
+    if (ANeuralNetworksInitialize() != ANEURALNETWORKS_NO_ERROR) {
+        printf("Can't initialize the NN runtime\n");
+        return 1;
+    }
+    android::nn::DeviceManager::get()->setUseCpuOnly(cpuOnly);
+    Profiler::get()->setEnabled(true);
+
+    bool success = runBenchmark("conv", createConvModel, iterations) &&
+            runBenchmark("depthwise_conv", createDepthwiseConvModel, iterations) &&
+            runBenchmark("pooling", createPoolingModel, iterations);
+
+    ANeuralNetworksShutdown();
+    return success ? 0 : 1;
+}
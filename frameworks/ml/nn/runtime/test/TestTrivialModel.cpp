@@ -45,6 +45,9 @@ protected:
     const Matrix3x4 expected3b = {{22.f, 34.f, 46.f, 58.f},
                                   {31.f, 34.f, 37.f, 40.f},
                                   {49.f, 52.f, 55.f, 58.f}};
+    const Matrix3x4 expected4 = {{122.f, 234.f, 346.f, 458.f},
+                                 {531.f, 634.f, 737.f, 840.f},
+                                 {949.f, 1052.f, 1155.f, 1258.f}};
 };
 
 // Create a model that can add two tensors using a one node graph.
@@ -74,6 +77,65 @@ void CreateAddThreeTensorModel(Model* model, const Matrix3x4 bias) {
     ASSERT_TRUE(model->isValid());
 }
 
+// Create a model with two independent branches that join in a final add,
+// computing 2 * a + b + bias.  The branches can run concurrently.
+void CreateBranchedAddModel(Model* model, const Matrix3x4 bias) {
+    OperandType matrixType(Type::TENSOR_FLOAT32, {3, 4});
+    auto a = model->addOperand(&matrixType);
+    auto b = model->addOperand(&matrixType);
+    auto c = model->addOperand(&matrixType);
+    auto d = model->addOperand(&matrixType);
+    auto e = model->addOperand(&matrixType);
+    auto f = model->addOperand(&matrixType);
+    model->setOperandValue(e, bias, sizeof(Matrix3x4));
+    model->addOperation(ANEURALNETWORKS_ADD, {a, b}, {c});
+    model->addOperation(ANEURALNETWORKS_ADD, {a, e}, {d});
+    model->addOperation(ANEURALNETWORKS_ADD, {c, d}, {f});
+    model->setInputsAndOutputs({a, b}, {f});
+    ASSERT_TRUE(model->isValid());
+}
+
+// Create a model that adds two quantized tensors.  The inputs have a scale of
+// 0.5 and the output a scale of 1, so the output is half the sum of the
+// quantized inputs.
+void CreateAddTwoQuant8TensorModel(Model* model) {
+    OperandType inputType(Type::TENSOR_SYMMETRICAL_QUANT8, {3, 4}, 0.5f, 0.f);
+    OperandType outputType(Type::TENSOR_SYMMETRICAL_QUANT8, {3, 4}, 1.f, 0.f);
+    auto a = model->addOperand(&inputType);
+    auto b = model->addOperand(&inputType);
+    auto c = model->addOperand(&outputType);
+    model->addOperation(ANEURALNETWORKS_ADD, {a, b}, {c});
+    model->setInputsAndOutputs({a, b}, {c});
+    ASSERT_TRUE(model->isValid());
+}
+
+// Create a model that runs a 1x1 average pool, i.e. a copy, followed by a
+// RELU.  The RELU can be folded into the pool.
+void CreatePoolReluModel(Model* model) {
+    // Padding and activation codes as used by the CpuExecutor.
+    const int32_t paddingValid = 2;
+    const int32_t activationNone = 0;
+    const int32_t one = 1;
+    OperandType tensorType(Type::TENSOR_FLOAT32, {1, 3, 4, 1});
+    OperandType scalarType(Type::INT32, {});
+    auto input = model->addOperand(&tensorType);
+    auto padding = model->addOperand(&scalarType);
+    auto stride = model->addOperand(&scalarType);
+    auto filter = model->addOperand(&scalarType);
+    auto activation = model->addOperand(&scalarType);
+    auto pooled = model->addOperand(&tensorType);
+    auto output = model->addOperand(&tensorType);
+    model->setOperandValue(padding, &paddingValid, sizeof(paddingValid));
+    model->setOperandValue(stride, &one, sizeof(one));
+    model->setOperandValue(filter, &one, sizeof(one));
+    model->setOperandValue(activation, &activationNone, sizeof(activationNone));
+    model->addOperation(ANEURALNETWORKS_AVERAGE_POOL,
+                        {input, padding, stride, stride, filter, filter, activation}, {pooled});
+    model->addOperation(ANEURALNETWORKS_RELU, {pooled}, {output});
+    model->setInputsAndOutputs({input}, {output});
+    ASSERT_TRUE(model->isValid());
+}
+
 // Check that the values are the same. This works only if dealing with integer
 // value, otherwise we should accept values that are similar if not exact.
 int CompareMatrices(const Matrix3x4 expected, const Matrix3x4 actual) {
@@ -106,6 +168,32 @@ TEST_F(TrivialTest, AddTwo) {
     ASSERT_EQ(CompareMatrices(expected2, actual), 0);
 }
 
+TEST_F(TrivialTest, AddTwoComputeTwice) {
+    Model modelAdd2;
+    CreateAddTwoTensorModel(&modelAdd2);
+
+    // The same request can be computed again with new data in the bound
+    // buffers, reusing what was set up the first time.
+    Matrix3x4 input;
+    memcpy(&input, matrix1, sizeof(Matrix3x4));
+    Matrix3x4 actual;
+    memset(&actual, 0, sizeof(actual));
+    Request request(&modelAdd2);
+    ASSERT_EQ(request.setInput(0, input, sizeof(Matrix3x4)), Result::NO_ERROR);
+    ASSERT_EQ(request.setInput(1, matrix2, sizeof(Matrix3x4)), Result::NO_ERROR);
+    ASSERT_EQ(request.setOutput(0, actual, sizeof(Matrix3x4)), Result::NO_ERROR);
+    ASSERT_EQ(request.compute(), Result::NO_ERROR);
+    ASSERT_EQ(CompareMatrices(expected2, actual), 0);
+
+    const Matrix3x4 expected = {{120.f, 230.f, 340.f, 450.f},
+                                {521.f, 622.f, 723.f, 824.f},
+                                {931.f, 1032.f, 1133.f, 1234.f}};
+    memcpy(&input, matrix3, sizeof(Matrix3x4));
+    memset(&actual, 0, sizeof(actual));
+    ASSERT_EQ(request.compute(), Result::NO_ERROR);
+    ASSERT_EQ(CompareMatrices(expected, actual), 0);
+}
+
 TEST_F(TrivialTest, AddThree) {
     Model modelAdd3;
     CreateAddThreeTensorModel(&modelAdd3, matrix3);
@@ -130,4 +218,57 @@ TEST_F(TrivialTest, AddThree) {
     ASSERT_EQ(CompareMatrices(expected3b, actual), 0);
 }
 
+TEST_F(TrivialTest, AddBranched) {
+    Model modelBranched;
+    CreateBranchedAddModel(&modelBranched, matrix3);
+
+    // Run it a few times, as the branches may complete in any order.
+    for (int i = 0; i < 10; i++) {
+        Matrix3x4 actual;
+        memset(&actual, 0, sizeof(actual));
+        Request request(&modelBranched);
+        ASSERT_EQ(request.setInput(0, matrix1, sizeof(Matrix3x4)), Result::NO_ERROR);
+        ASSERT_EQ(request.setInput(1, matrix2, sizeof(Matrix3x4)), Result::NO_ERROR);
+        ASSERT_EQ(request.setOutput(0, actual, sizeof(Matrix3x4)), Result::NO_ERROR);
+        ASSERT_EQ(request.compute(), Result::NO_ERROR);
+        ASSERT_EQ(CompareMatrices(expected4, actual), 0);
+    }
+}
+
+TEST_F(TrivialTest, AddTwoQuant8) {
+    Model modelAdd2;
+    CreateAddTwoQuant8TensorModel(&modelAdd2);
+
+    const uint8_t input1[3][4] = {{10, 20, 30, 40}, {50, 60, 70, 80}, {90, 100, 110, 120}};
+    const uint8_t input2[3][4] = {{2, 4, 6, 8}, {10, 12, 14, 16}, {18, 20, 22, 24}};
+    const uint8_t expected[3][4] = {{6, 12, 18, 24}, {30, 36, 42, 48}, {54, 60, 66, 72}};
+    uint8_t actual[3][4];
+    memset(&actual, 0, sizeof(actual));
+    Request request(&modelAdd2);
+    ASSERT_EQ(request.setInput(0, input1, sizeof(input1)), Result::NO_ERROR);
+    ASSERT_EQ(request.setInput(1, input2, sizeof(input2)), Result::NO_ERROR);
+    ASSERT_EQ(request.setOutput(0, actual, sizeof(actual)), Result::NO_ERROR);
+    ASSERT_EQ(request.compute(), Result::NO_ERROR);
+    ASSERT_EQ(memcmp(expected, actual, sizeof(actual)), 0);
+}
+
+TEST_F(TrivialTest, PoolRelu) {
+    Model modelPoolRelu;
+    CreatePoolReluModel(&modelPoolRelu);
+
+    const Matrix3x4 input = {{-1.f, 2.f, -3.f, 4.f},
+                             {5.f, -6.f, 7.f, -8.f},
+                             {-9.f, -10.f, 11.f, 12.f}};
+    const Matrix3x4 expected = {{0.f, 2.f, 0.f, 4.f},
+                                {5.f, 0.f, 7.f, 0.f},
+                                {0.f, 0.f, 11.f, 12.f}};
+    Matrix3x4 actual;
+    memset(&actual, 0, sizeof(actual));
+    Request request(&modelPoolRelu);
+    ASSERT_EQ(request.setInput(0, input, sizeof(Matrix3x4)), Result::NO_ERROR);
+    ASSERT_EQ(request.setOutput(0, actual, sizeof(Matrix3x4)), Result::NO_ERROR);
+    ASSERT_EQ(request.compute(), Result::NO_ERROR);
+    ASSERT_EQ(CompareMatrices(expected, actual), 0);
+}
+
 }  // end namespace
@@ -121,6 +121,7 @@ Return<DeviceStatus> SampleDriver::getStatus() {
 SamplePreparedModel::SamplePreparedModel(const Model& model) {
     // Make a copy of the model, as we need to preserve it.
     mModel = model;
+    mMemoryPlan.initialize(mModel);
 }
 
 static bool mapPools(std::vector<RunTimePoolInfo>* poolInfos, const hidl_vec<hidl_memory>& pools) {
@@ -152,7 +153,7 @@ Return<bool> SamplePreparedModel::execute(const Request& request) {
     }
 
     CpuExecutor executor;
-    int n = executor.run(mModel, request, poolInfo);
+    int n = executor.run(mModel, request, poolInfo, &mMemoryPlan);
     LOG(DEBUG) << "executor.run returned " << n;
     return n == ANEURALNETWORKS_NO_ERROR;
 }
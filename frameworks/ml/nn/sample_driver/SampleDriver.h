@@ -18,6 +18,7 @@
 #define ANDROID_ML_NN_SAMPLE_DRIVER_SAMPLE_DRIVER_H
 
 #include "HalInterfaces.h"
+#include "MemoryPlanner.h"
 #include "NeuralNetworks.h"
 
 namespace android {
@@ -44,6 +45,7 @@ public:
 
 private:
     Model mModel;
+    MemoryPlan mMemoryPlan;
 };
 
 } // namespace sample_driver
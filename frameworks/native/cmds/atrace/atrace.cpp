@@ -25,6 +25,7 @@
 #include <fcntl.h>
 #include <getopt.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -35,8 +36,11 @@
 #include <unistd.h>
 #include <zlib.h>
 
+#include <atomic>
 #include <fstream>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include <binder/IBinder.h>
 #include <binder/IServiceManager.h>
@@ -54,6 +58,7 @@
 #include <android-base/macros.h>
 #include <android-base/properties.h>
 #include <android-base/stringprintf.h>
+#include <android-base/strings.h>
 
 using namespace android;
 using pdx::default_transport::ServiceUtility;
@@ -208,6 +213,31 @@ static const TracingCategory k_categories[] = {
     } },
 };
 
+struct FilterPreset {
+    const char* name;
+    const char* longname;
+    struct {
+        const char* path;
+        const char* filter;
+    } filters[MAX_SYS_FILES];
+};
+
+/* Event filters evaluated by the kernel, so that dropped events never reach
+ * the trace buffer. */
+static const FilterPreset k_filterPresets[] = {
+    { "no_idle", "Drop context switches to or from the idle task", {
+        { "events/sched/sched_switch/filter", "prev_pid != 0 && next_pid != 0" },
+    } },
+    { "rt_only", "Only keep scheduling events of real-time tasks", {
+        { "events/sched/sched_switch/filter", "prev_prio < 100 || next_prio < 100" },
+        { "events/sched/sched_wakeup/filter", "prio < 100" },
+        { "events/sched/sched_waking/filter", "prio < 100" },
+    } },
+    { "binder_calls", "Drop binder replies, only keep the calls", {
+        { "events/binder/binder_transaction/filter", "reply == 0" },
+    } },
+};
+
 /* Command line options */
 static int g_traceDurationSeconds = 5;
 static bool g_traceOverwrite = false;
@@ -219,12 +249,15 @@ static const char* g_categoriesFile = NULL;
 static const char* g_kernelTraceFuncs = NULL;
 static const char* g_debugAppCmdLine = "";
 static const char* g_outputFile = nullptr;
+static const char* g_filterPresets = NULL;
 
 /* Global state */
 static bool g_tracePdx = false;
 static bool g_traceAborted = false;
 static bool g_categoryEnables[arraysize(k_categories)] = {};
 static std::string g_traceFolder;
+static std::vector<std::thread> g_rawStreamThreads;
+static std::atomic<bool> g_rawStreamStop(false);
 
 /* Sys file paths */
 static const char* k_traceClockPath =
@@ -272,6 +305,12 @@ static const char* k_tracePath =
 static const char* k_traceStreamPath =
     "trace_pipe";
 
+static const char* k_traceRawStreamPathTemplate =
+    "per_cpu/cpu%d/trace_pipe_raw";
+
+static const char* k_savedCmdlinesPath =
+    "saved_cmdlines";
+
 static const char* k_traceMarkerPath =
     "trace_marker";
 
@@ -776,6 +815,51 @@ static bool setCategoriesEnableFromFile(const char* categories_file)
     return ok;
 }
 
+// Install the kernel event filters of a comma separated list of presets.
+static bool setFilterPresets(const char* presets)
+{
+    if (presets == NULL) {
+        return true;
+    }
+
+    bool ok = true;
+    for (const std::string& name : android::base::Split(presets, ",")) {
+        const FilterPreset* preset = NULL;
+        for (size_t i = 0; i < arraysize(k_filterPresets); i++) {
+            if (name == k_filterPresets[i].name) {
+                preset = &k_filterPresets[i];
+                break;
+            }
+        }
+        if (preset == NULL) {
+            fprintf(stderr, "unknown filter preset \"%s\"\n", name.c_str());
+            ok = false;
+            continue;
+        }
+        for (int i = 0; i < MAX_SYS_FILES; i++) {
+            const char* path = preset->filters[i].path;
+            // Events the kernel doesn't have are simply not filtered.
+            if (path != NULL && fileIsWritable(path)) {
+                ok &= writeStr(path, preset->filters[i].filter);
+            }
+        }
+    }
+    return ok;
+}
+
+// Remove the event filters of all the presets.
+static void clearFilterPresets()
+{
+    for (size_t i = 0; i < arraysize(k_filterPresets); i++) {
+        for (int j = 0; j < MAX_SYS_FILES; j++) {
+            const char* path = k_filterPresets[i].filters[j].path;
+            if (path != NULL && fileIsWritable(path)) {
+                writeStr(path, "0");
+            }
+        }
+    }
+}
+
 // Set all the kernel tracing settings to the desired state for this trace
 // capture.
 static bool setUpTrace()
@@ -791,6 +875,7 @@ static bool setUpTrace()
     ok &= setClock();
     ok &= setPrintTgidEnableIfPresent(true);
     ok &= setKernelTraceFuncs(g_kernelTraceFuncs);
+    ok &= setFilterPresets(g_filterPresets);
 
     // Set up the tags property.
     uint64_t tags = 0;
@@ -875,6 +960,7 @@ static void cleanUpTrace()
     setTraceBufferSizeKB(1);
     setPrintTgidEnableIfPresent(false);
     setKernelTraceFuncs(NULL);
+    clearFilterPresets();
 }
 
 
@@ -915,6 +1001,122 @@ static void streamTrace()
     }
 }
 
+// Move the binary pages of one CPU's ring buffer to outFd as they fill up,
+// without copying them through user space, until finishRawStream() is called.
+static void streamRawCpu(int cpu, int traceFD, int outFd)
+{
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    int pipeFds[2];
+    if (pipe2(pipeFds, O_CLOEXEC) == -1) {
+        fprintf(stderr, "error creating pipe for cpu%d: %s (%d)\n", cpu,
+                strerror(errno), errno);
+        return;
+    }
+
+    bool ok = true;
+    while (ok) {
+        ssize_t spliced = splice(traceFD, NULL, pipeFds[1], NULL, pageSize,
+                SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (spliced > 0) {
+            while (spliced > 0) {
+                ssize_t written = splice(pipeFds[0], NULL, outFd, NULL, spliced,
+                        SPLICE_F_MOVE);
+                if (written <= 0) {
+                    fprintf(stderr, "error writing cpu%d trace: %s (%d)\n", cpu,
+                            strerror(errno), errno);
+                    ok = false;
+                    break;
+                }
+                spliced -= written;
+            }
+            continue;
+        }
+        if (spliced == -1 && errno != EAGAIN && errno != EINTR) {
+            fprintf(stderr, "error reading cpu%d trace: %s (%d)\n", cpu,
+                    strerror(errno), errno);
+            break;
+        }
+        // Tracing is already off once we are told to stop, so an empty
+        // buffer means everything was moved.
+        if (g_rawStreamStop) {
+            break;
+        }
+        struct pollfd pfd = { traceFD, POLLIN, 0 };
+        poll(&pfd, 1, 100);
+    }
+
+    // splice only hands out full pages, the last partially filled one has
+    // to be read.
+    if (ok) {
+        std::unique_ptr<char[]> page(new char[pageSize]);
+        ssize_t rc;
+        while ((rc = TEMP_FAILURE_RETRY(read(traceFD, page.get(), pageSize))) > 0) {
+            if (!android::base::WriteFully(outFd, page.get(), rc)) {
+                fprintf(stderr, "error writing cpu%d trace: %s\n", cpu, strerror(errno));
+                break;
+            }
+        }
+    }
+
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+    close(traceFD);
+    close(outFd);
+}
+
+// Start streaming the binary trace of every CPU to "<outputFile>.cpuN", so
+// that the trace length isn't limited by the size of the ring buffer.
+static bool startRawStream(const char* outputFile)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        std::string path = g_traceFolder +
+                android::base::StringPrintf(k_traceRawStreamPathTemplate, cpu);
+        int traceFD = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (traceFD == -1) {
+            // CPUs that were never online have no buffer.
+            continue;
+        }
+        std::string outPath = android::base::StringPrintf("%s.cpu%d", outputFile, cpu);
+        int outFd = open(outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (outFd == -1) {
+            fprintf(stderr, "error opening %s: %s (%d)\n", outPath.c_str(),
+                    strerror(errno), errno);
+            close(traceFD);
+            return false;
+        }
+        g_rawStreamThreads.emplace_back(streamRawCpu, cpu, traceFD, outFd);
+    }
+    if (g_rawStreamThreads.empty()) {
+        fprintf(stderr, "error: no per-cpu trace_pipe_raw found\n");
+        return false;
+    }
+    return true;
+}
+
+// Wait for the streams to drain the ring buffers, and save the command lines
+// needed to name the pids of the binary trace. Tracing must be stopped.
+static void finishRawStream(const char* outputFile)
+{
+    if (g_rawStreamThreads.empty()) {
+        return;
+    }
+
+    g_rawStreamStop = true;
+    for (std::thread& thread : g_rawStreamThreads) {
+        thread.join();
+    }
+    g_rawStreamThreads.clear();
+
+    std::string cmdlines;
+    if (android::base::ReadFileToString(g_traceFolder + k_savedCmdlinesPath, &cmdlines)) {
+        std::string outPath = android::base::StringPrintf("%s.cmdlines", outputFile);
+        if (!android::base::WriteStringToFile(cmdlines, outPath)) {
+            fprintf(stderr, "error writing %s: %s\n", outPath.c_str(), strerror(errno));
+        }
+    }
+}
+
 // Read the current kernel trace and write it to stdout.
 static void dumpTrace(int outFd)
 {
@@ -1048,6 +1250,14 @@ static void listSupportedCategories()
     }
 }
 
+static void listFilterPresets()
+{
+    for (size_t i = 0; i < arraysize(k_filterPresets); i++) {
+        const FilterPreset& p = k_filterPresets[i];
+        printf("  %12s - %s\n", p.name, p.longname);
+    }
+}
+
 // Print the command usage help to stderr.
 static void showHelp(const char *cmd)
 {
@@ -1072,8 +1282,15 @@ static void showHelp(const char *cmd)
                     "                    Note: this can take significant CPU time, and is best\n"
                     "                    used for measuring things that are not affected by\n"
                     "                    CPU performance, like pagecache usage.\n"
+                    "  --stream_raw    stream the binary per-cpu traces to <filename>.cpuN\n"
+                    "                    while tracing, requires -o. This isn't limited by\n"
+                    "                    the trace buffer size.\n"
+                    "  --filter_preset name,...\n"
+                    "                  filter events in the kernel with the listed presets\n"
                     "  --list_categories\n"
                     "                  list the available tracing categories\n"
+                    "  --list_filter_presets\n"
+                    "                  list the available event filter presets\n"
                     " -o filename      write the trace to the specified file instead\n"
                     "                    of stdout.\n"
             );
@@ -1109,6 +1326,7 @@ int main(int argc, char **argv)
     bool traceStop = true;
     bool traceDump = true;
     bool traceStream = false;
+    bool traceStreamRaw = false;
 
     if (argc == 2 && 0 == strcmp(argv[1], "--help")) {
         showHelp(argv[0]);
@@ -1129,6 +1347,9 @@ int main(int argc, char **argv)
             {"async_dump",      no_argument, 0,  0 },
             {"list_categories", no_argument, 0,  0 },
             {"stream",          no_argument, 0,  0 },
+            {"stream_raw",      no_argument, 0,  0 },
+            {"filter_preset",   required_argument, 0,  0 },
+            {"list_filter_presets", no_argument, 0,  0 },
             {           0,                0, 0,  0 }
         };
 
@@ -1202,9 +1423,17 @@ int main(int argc, char **argv)
                 } else if (!strcmp(long_options[option_index].name, "stream")) {
                     traceStream = true;
                     traceDump = false;
+                } else if (!strcmp(long_options[option_index].name, "stream_raw")) {
+                    traceStreamRaw = true;
+                    traceDump = false;
+                } else if (!strcmp(long_options[option_index].name, "filter_preset")) {
+                    g_filterPresets = optarg;
                 } else if (!strcmp(long_options[option_index].name, "list_categories")) {
                     listSupportedCategories();
                     exit(0);
+                } else if (!strcmp(long_options[option_index].name, "list_filter_presets")) {
+                    listFilterPresets();
+                    exit(0);
                 }
             break;
 
@@ -1216,6 +1445,12 @@ int main(int argc, char **argv)
         }
     }
 
+    if (traceStreamRaw && (g_outputFile == nullptr || async || traceStream)) {
+        fprintf(stderr, "--stream_raw requires -o and can't be used with --stream "
+                "or async tracing\n");
+        exit(-1);
+    }
+
     registerSigHandler();
 
     if (g_initialSleepSecs > 0) {
@@ -1239,6 +1474,10 @@ int main(int argc, char **argv)
         // another.
         ok = clearTrace();
 
+        if (ok && traceStreamRaw) {
+            ok = startRawStream(g_outputFile);
+        }
+
         writeClockSyncMarker();
         if (ok && !async && !traceStream) {
             // Sleep to allow the trace to be captured.
@@ -1261,6 +1500,14 @@ int main(int argc, char **argv)
     if (traceStop)
         stopTrace();
 
+    if (traceStreamRaw) {
+        finishRawStream(g_outputFile);
+        if (ok) {
+            printf(g_traceAborted ? "\ntrace aborted.\n" : " done\n");
+            fflush(stdout);
+        }
+    }
+
     if (ok && traceDump) {
         if (!g_traceAborted) {
             printf(" done\n");
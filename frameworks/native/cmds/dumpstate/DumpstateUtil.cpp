@@ -18,6 +18,8 @@
 
 #include "DumpstateUtil.h"
 
+#include <algorithm>
+
 #include <dirent.h>
 #include <fcntl.h>
 #include <sys/prctl.h>
@@ -42,7 +44,11 @@ namespace {
 
 static constexpr const char* kSuPath = "/system/xbin/su";
 
+// Waits for pid to exit, for at most timeout_seconds. Other threads may be waiting for their own
+// children at the same time and consume the SIGCHLD of this one, so the child is also polled.
 static bool waitpid_with_timeout(pid_t pid, int timeout_seconds, int* status) {
+    static const uint64_t kPollNanos = 100 * 1000 * 1000;
+
     sigset_t child_mask, old_mask;
     sigemptyset(&child_mask);
     sigaddset(&child_mask, SIGCHLD);
@@ -52,38 +58,43 @@ static bool waitpid_with_timeout(pid_t pid, int timeout_seconds, int* status) {
         return false;
     }
 
-    timespec ts;
-    ts.tv_sec = timeout_seconds;
-    ts.tv_nsec = 0;
-    int ret = TEMP_FAILURE_RETRY(sigtimedwait(&child_mask, NULL, &ts));
-    int saved_errno = errno;
-    // Set the signals back the way they were.
-    if (sigprocmask(SIG_SETMASK, &old_mask, NULL) == -1) {
-        printf("*** sigprocmask failed: %s\n", strerror(errno));
-        if (ret == 0) {
-            return false;
+    uint64_t deadline = Nanotime() + timeout_seconds * NANOS_PER_SEC;
+    bool ret = false;
+    int saved_errno = 0;
+    while (true) {
+        pid_t child_pid = waitpid(pid, status, WNOHANG);
+        if (child_pid == pid) {
+            ret = true;
+            break;
         }
-    }
-    if (ret == -1) {
-        errno = saved_errno;
-        if (errno == EAGAIN) {
-            errno = ETIMEDOUT;
-        } else {
+        if (child_pid == -1) {
+            saved_errno = errno;
+            printf("*** waitpid failed: %s\n", strerror(errno));
+            break;
+        }
+
+        uint64_t now = Nanotime();
+        if (now >= deadline) {
+            saved_errno = ETIMEDOUT;
+            break;
+        }
+        uint64_t wait = std::min(deadline - now, kPollNanos);
+        timespec ts;
+        ts.tv_sec = wait / NANOS_PER_SEC;
+        ts.tv_nsec = wait % NANOS_PER_SEC;
+        if (TEMP_FAILURE_RETRY(sigtimedwait(&child_mask, NULL, &ts)) == -1 && errno != EAGAIN) {
+            saved_errno = errno;
             printf("*** sigtimedwait failed: %s\n", strerror(errno));
+            break;
         }
-        return false;
     }
 
-    pid_t child_pid = waitpid(pid, status, WNOHANG);
-    if (child_pid != pid) {
-        if (child_pid != -1) {
-            printf("*** Waiting for pid %d, got pid %d instead\n", pid, child_pid);
-        } else {
-            printf("*** waitpid failed: %s\n", strerror(errno));
-        }
-        return false;
+    // Set the signals back the way they were.
+    if (sigprocmask(SIG_SETMASK, &old_mask, NULL) == -1) {
+        printf("*** sigprocmask failed: %s\n", strerror(errno));
     }
-    return true;
+    errno = saved_errno;
+    return ret;
 }
 }  // unnamed namespace
 
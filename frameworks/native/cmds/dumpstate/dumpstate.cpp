@@ -31,10 +31,15 @@
 #include <sys/time.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <regex>
 #include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <android-base/file.h>
@@ -60,6 +65,7 @@ using android::os::dumpstate::CommandOptions;
 using android::os::dumpstate::DumpFileToFd;
 using android::os::dumpstate::PropertiesHelper;
 using android::os::dumpstate::GetPidByName;
+using android::os::dumpstate::RunCommandToFd;
 
 /* read before root is shed */
 static char cmdline_buf[16384] = "(unknown)";
@@ -1033,9 +1039,131 @@ static void DumpIpAddrAndRules() {
     RunCommand("IP RULES v6", {"ip", "-6", "rule", "show"});
 }
 
+// Runs dumpsys sections that don't depend on the rest of the report on a few worker threads,
+// while the main thread collects everything else. Each section is written to its own temporary
+// file, which Print() copies to the report where the section used to run, so the report keeps
+// its order. Without a bugreport directory for the temporary files, Print() runs the section
+// itself.
+class BackgroundDumpsys {
+  public:
+    ~BackgroundDumpsys() {
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    void Add(const std::string& title, const std::vector<std::string>& dumpsys_args,
+             const CommandOptions& options = Dumpstate::DEFAULT_DUMPSYS) {
+        sections_.push_back(Section{title, dumpsys_args, options, "", false, 0});
+    }
+
+    void Start(size_t thread_count) {
+        if (ds.bugreport_dir_.empty()) {
+            return;
+        }
+        for (size_t i = 0; i < sections_.size(); i++) {
+            sections_[i].path = ds.GetPath("-section" + std::to_string(i) + ".tmp");
+        }
+        thread_count = std::min(thread_count, sections_.size());
+        for (size_t i = 0; i < thread_count; i++) {
+            threads_.emplace_back([this]() {
+                size_t index;
+                while ((index = next_++) < sections_.size()) {
+                    Run(&sections_[index]);
+                }
+            });
+        }
+    }
+
+    void Print(const std::string& title) {
+        auto section = std::find_if(sections_.begin(), sections_.end(),
+                                    [&title](const Section& s) { return s.title == title; });
+        if (section == sections_.end()) {
+            MYLOGE("Unknown background section '%s'\n", title.c_str());
+            return;
+        }
+        if (threads_.empty()) {
+            RunDumpsys(section->title, section->args, section->options);
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            done_.wait(lock, [section]() { return section->done; });
+        }
+        android::base::unique_fd fd(
+            TEMP_FAILURE_RETRY(open(section->path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW)));
+        if (fd < 0) {
+            MYLOGE("Could not open %s: %s\n", section->path.c_str(), strerror(errno));
+        } else {
+            DumpFileFromFdToFd("", section->path, fd, STDOUT_FILENO);
+        }
+        unlink(section->path.c_str());
+        // Same format as DurationReporter, with the time the section took on its worker.
+        printf("------ %.3fs was the duration of '%s' ------\n", section->elapsed_seconds,
+               title.c_str());
+        ds.UpdateProgress(section->options.Timeout());
+    }
+
+  private:
+    struct Section {
+        std::string title;
+        std::vector<std::string> args;
+        CommandOptions options;
+        std::string path;
+        bool done;
+        float elapsed_seconds;
+    };
+
+    void Run(Section* section) {
+        uint64_t start = Nanotime();
+        android::base::unique_fd fd(TEMP_FAILURE_RETRY(
+            open(section->path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW,
+                 S_IRUSR | S_IWUSR)));
+        if (fd < 0) {
+            MYLOGE("Could not open %s: %s\n", section->path.c_str(), strerror(errno));
+        } else {
+            std::vector<std::string> dumpsys = {"/system/bin/dumpsys", "-t",
+                                                std::to_string(section->options.Timeout())};
+            dumpsys.insert(dumpsys.end(), section->args.begin(), section->args.end());
+            RunCommandToFd(fd, section->title, dumpsys, section->options);
+        }
+
+        std::lock_guard<std::mutex> lock(lock_);
+        section->elapsed_seconds = static_cast<float>(Nanotime() - start) / NANOS_PER_SEC;
+        section->done = true;
+        done_.notify_all();
+    }
+
+    std::vector<Section> sections_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_{0};
+    std::mutex lock_;
+    std::condition_variable done_;
+};
+
+// Dumpsys sections are mostly waiting on system_server, which serves them concurrently.
+static const size_t kBackgroundDumpsysThreads = 2;
+
 static void dumpstate() {
     DurationReporter duration_reporter("DUMPSTATE");
 
+    // These sections only read framework state and come last in the report, so collect them
+    // while everything before them runs.
+    BackgroundDumpsys background;
+    background.Add("CHECKIN BATTERYSTATS", {"batterystats", "-c"});
+    background.Add("CHECKIN MEMINFO", {"meminfo", "--checkin"});
+    background.Add("CHECKIN NETSTATS", {"netstats", "--checkin"});
+    background.Add("CHECKIN PROCSTATS", {"procstats", "-c"});
+    background.Add("CHECKIN USAGESTATS", {"usagestats", "-c"});
+    background.Add("CHECKIN PACKAGE", {"package", "--checkin"});
+    background.Add("APP ACTIVITIES", {"activity", "-v", "all"});
+    background.Add("APP SERVICES", {"activity", "service", "all"});
+    background.Add("APP PROVIDERS", {"activity", "provider", "all"});
+    background.Add("DROPBOX SYSTEM SERVER CRASHES", {"dropbox", "-p", "system_server_crash"});
+    background.Add("DROPBOX SYSTEM APP CRASHES", {"dropbox", "-p", "system_app_crash"});
+    background.Start(kBackgroundDumpsysThreads);
+
     dump_dev_files("TRUSTY VERSION", "/sys/bus/platform/drivers/trusty", "trusty_version");
     RunCommand("UPTIME", {"uptime"});
     DumpBlockStatFiles();
@@ -1183,37 +1311,37 @@ static void dumpstate() {
     printf("== Checkins\n");
     printf("========================================================\n");
 
-    RunDumpsys("CHECKIN BATTERYSTATS", {"batterystats", "-c"});
-    RunDumpsys("CHECKIN MEMINFO", {"meminfo", "--checkin"});
-    RunDumpsys("CHECKIN NETSTATS", {"netstats", "--checkin"});
-    RunDumpsys("CHECKIN PROCSTATS", {"procstats", "-c"});
-    RunDumpsys("CHECKIN USAGESTATS", {"usagestats", "-c"});
-    RunDumpsys("CHECKIN PACKAGE", {"package", "--checkin"});
+    background.Print("CHECKIN BATTERYSTATS");
+    background.Print("CHECKIN MEMINFO");
+    background.Print("CHECKIN NETSTATS");
+    background.Print("CHECKIN PROCSTATS");
+    background.Print("CHECKIN USAGESTATS");
+    background.Print("CHECKIN PACKAGE");
 
     printf("========================================================\n");
     printf("== Running Application Activities\n");
     printf("========================================================\n");
 
-    RunDumpsys("APP ACTIVITIES", {"activity", "-v", "all"});
+    background.Print("APP ACTIVITIES");
 
     printf("========================================================\n");
     printf("== Running Application Services\n");
     printf("========================================================\n");
 
-    RunDumpsys("APP SERVICES", {"activity", "service", "all"});
+    background.Print("APP SERVICES");
 
     printf("========================================================\n");
     printf("== Running Application Providers\n");
     printf("========================================================\n");
 
-    RunDumpsys("APP PROVIDERS", {"activity", "provider", "all"});
+    background.Print("APP PROVIDERS");
 
     printf("========================================================\n");
     printf("== Dropbox crashes\n");
     printf("========================================================\n");
 
-    RunDumpsys("DROPBOX SYSTEM SERVER CRASHES", {"dropbox", "-p", "system_server_crash"});
-    RunDumpsys("DROPBOX SYSTEM APP CRASHES", {"dropbox", "-p", "system_app_crash"});
+    background.Print("DROPBOX SYSTEM SERVER CRASHES");
+    background.Print("DROPBOX SYSTEM APP CRASHES");
 
     printf("========================================================\n");
     printf("== Final progress (pid %d): %d/%d (estimated %d)\n", ds.pid_, ds.progress_->Get(),
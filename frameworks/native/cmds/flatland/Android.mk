@@ -25,3 +25,24 @@ LOCAL_SHARED_LIBRARIES := \
     libutils    \
 
 include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:=   \
+    LayerTree.cpp   \
+
+LOCAL_MODULE:= flatland_layers
+
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_MODULE_PATH := $(local_target_dir)
+LOCAL_MULTILIB := both
+LOCAL_MODULE_STEM_32 := flatland_layers
+LOCAL_MODULE_STEM_64 := flatland_layers64
+LOCAL_SHARED_LIBRARIES := \
+    libbinder   \
+    libgui      \
+    libui       \
+    libutils    \
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,431 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// flatland_layers measures the CPU time SurfaceFlinger spends on each stage of
+// a frame while it composites synthetic layer trees. Unlike flatland it does
+// not measure GPU throughput: every layer is a small CPU-filled buffer, and
+// the timings are read back from SurfaceFlinger's stage timing backdoor.
+
+#include <binder/IServiceManager.h>
+#include <binder/Parcel.h>
+#include <binder/ProcessState.h>
+#include <gui/DisplayEventReceiver.h>
+#include <gui/ISurfaceComposer.h>
+#include <gui/Surface.h>
+#include <gui/SurfaceComposerClient.h>
+#include <gui/SurfaceControl.h>
+#include <ui/DisplayInfo.h>
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+using namespace ::android;
+
+#ifndef NELEMS
+#define NELEMS(x) ((int) (sizeof(x) / sizeof((x)[0])))
+#endif
+
+// Must match StageTimingTracker in SurfaceFlinger
+static const uint32_t STAGE_TIMING_TRANSACTION = 1023;
+static const char* const STAGE_NAMES[] = {
+    "transaction",
+    "latch",
+    "pre-composition",
+    "visible-regions",
+    "set-up-hwc",
+    "composition",
+    "post-composition",
+};
+
+static uint32_t g_Frames = 300;
+static uint32_t g_SleepBetweenRunsMs = 0;
+
+enum LayerTransform {
+    kIdentity,
+    kScale,
+    kRotate,
+};
+
+struct LayerTreeDesc {
+    // The name of the test.
+    const char* name;
+
+    // The total number of layers, including the group layers.
+    uint32_t numLayers;
+
+    // The number of layers that get a new buffer and new geometry each frame.
+    uint32_t numUpdating;
+
+    // The number of layers parented to each group layer, 0 for a flat tree.
+    uint32_t groupSize;
+
+    LayerTransform transform;
+
+    // The alpha of the updating layers.
+    float alpha;
+};
+
+static const LayerTreeDesc layerTrees[] = {
+    { "Single updating window",              8,   1, 0, kIdentity, 1.0f },
+    { "Translucent windows",                16,   4, 0, kIdentity, 0.5f },
+    { "Scaling windows",                    16,   4, 0, kScale,    1.0f },
+    { "Rotating windows",                   16,   4, 0, kRotate,   1.0f },
+    { "Many layers, few updating",          64,   2, 0, kIdentity, 1.0f },
+    { "Many layers, all updating",          64,  64, 0, kIdentity, 1.0f },
+    { "Nested groups",                      64,   8, 8, kIdentity, 1.0f },
+    { "Nested translucent rotating groups", 64,  16, 8, kRotate,   0.5f },
+};
+
+class LayerTreeBenchmark {
+public:
+    LayerTreeBenchmark(const LayerTreeDesc& desc) : mDesc(desc), mFrame(0) {}
+
+    bool setUp(const sp<SurfaceComposerClient>& client, const DisplayInfo& info) {
+        const uint32_t columns = uint32_t(ceil(sqrt(double(mDesc.numLayers))));
+        const uint32_t w = info.w / columns;
+        const uint32_t h = info.h / columns;
+
+        SurfaceComposerClient::openGlobalTransaction();
+        for (uint32_t i = 0; i < mDesc.numLayers; i++) {
+            SurfaceControl* parent = nullptr;
+            bool isGroup = false;
+            if (mDesc.groupSize > 0) {
+                isGroup = i % (mDesc.groupSize + 1) == 0;
+                if (!isGroup) {
+                    parent = mLayers[i - i % (mDesc.groupSize + 1)].control.get();
+                }
+            }
+
+            Layer layer;
+            layer.control = client->createSurface(String8::format("LayerTree %u", i),
+                    w, h, PIXEL_FORMAT_RGBA_8888, 0, parent);
+            if (layer.control == nullptr || !layer.control->isValid()) {
+                fprintf(stderr, "SurfaceComposerClient::createSurface failed\n");
+                SurfaceComposerClient::closeGlobalTransaction(true);
+                return false;
+            }
+            layer.surface = layer.control->getSurface();
+            // Children are positioned relative to their group layer
+            layer.x = parent ? 0.0f : float((i % columns) * w);
+            layer.y = parent ? 0.0f : float((i / columns) * h);
+            layer.isGroup = isGroup;
+            layer.updating = false;
+
+            layer.control->setLayer(parent ? int32_t(i % (mDesc.groupSize + 1)) :
+                    int32_t(0x7fff0000 + i));
+            layer.control->setPosition(layer.x, layer.y);
+            layer.control->show();
+            mLayers.push_back(layer);
+        }
+        SurfaceComposerClient::closeGlobalTransaction(true);
+
+        // The top-most leaf layers are the ones that update
+        uint32_t updating = 0;
+        for (auto layer = mLayers.rbegin(); layer != mLayers.rend(); ++layer) {
+            if (updating < mDesc.numUpdating && !layer->isGroup) {
+                layer->updating = true;
+                updating++;
+            }
+        }
+
+        for (Layer& layer : mLayers) {
+            if (!postBuffer(layer)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Updates the geometry and the content of the updating layers
+    bool drawFrame() {
+        mFrame++;
+
+        SurfaceComposerClient::openGlobalTransaction();
+        for (Layer& layer : mLayers) {
+            if (!layer.updating) {
+                continue;
+            }
+            const float t = float(mFrame % 60) / 60.0f;
+            layer.control->setPosition(layer.x + 8.0f * t, layer.y);
+            layer.control->setAlpha(mDesc.alpha);
+            switch (mDesc.transform) {
+                case kIdentity:
+                    break;
+                case kScale: {
+                    const float scale = 0.75f + 0.25f * t;
+                    layer.control->setMatrix(scale, 0.0f, 0.0f, scale);
+                    break;
+                }
+                case kRotate: {
+                    const float angle = float(2.0 * M_PI) * t;
+                    layer.control->setMatrix(cosf(angle), sinf(angle), -sinf(angle),
+                            cosf(angle));
+                    break;
+                }
+            }
+        }
+        SurfaceComposerClient::closeGlobalTransaction();
+
+        for (Layer& layer : mLayers) {
+            if (layer.updating && !postBuffer(layer)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void tearDown() {
+        mLayers.clear();
+    }
+
+private:
+    struct Layer {
+        sp<SurfaceControl> control;
+        sp<Surface> surface;
+        float x;
+        float y;
+        bool isGroup;
+        bool updating;
+    };
+
+    bool postBuffer(Layer& layer) {
+        ANativeWindow_Buffer buffer;
+        status_t err = layer.surface->lock(&buffer, nullptr);
+        if (err != NO_ERROR) {
+            fprintf(stderr, "Surface::lock error: %#x\n", err);
+            return false;
+        }
+        const uint32_t color = 0xff000000 | (mFrame * 0x010203);
+        uint32_t* row = static_cast<uint32_t*>(buffer.bits);
+        for (int32_t y = 0; y < buffer.height; y++) {
+            for (int32_t x = 0; x < buffer.width; x++) {
+                row[x] = color;
+            }
+            row += buffer.stride;
+        }
+        err = layer.surface->unlockAndPost();
+        if (err != NO_ERROR) {
+            fprintf(stderr, "Surface::unlockAndPost error: %#x\n", err);
+            return false;
+        }
+        return true;
+    }
+
+    const LayerTreeDesc& mDesc;
+    std::vector<Layer> mLayers;
+    uint32_t mFrame;
+};
+
+struct StageStats {
+    int64_t count;
+    int64_t min;
+    int64_t mean;
+    int64_t p50;
+    int64_t p90;
+    int64_t p99;
+    int64_t max;
+};
+
+// Enables (1), disables (0) or queries (-1) SurfaceFlinger's stage timing.
+static bool stageTiming(int32_t command, std::vector<StageStats>* stats) {
+    sp<IBinder> sf = defaultServiceManager()->checkService(String16("SurfaceFlinger"));
+    if (sf == nullptr) {
+        fprintf(stderr, "SurfaceFlinger service not found\n");
+        return false;
+    }
+
+    Parcel data, reply;
+    data.writeInterfaceToken(ISurfaceComposer::getInterfaceDescriptor());
+    data.writeInt32(command);
+    status_t err = sf->transact(STAGE_TIMING_TRANSACTION, data, &reply);
+    if (err != NO_ERROR) {
+        fprintf(stderr, "SurfaceFlinger stage timing transaction error: %#x\n", err);
+        return false;
+    }
+
+    if (stats != nullptr) {
+        const int32_t count = reply.readInt32();
+        stats->resize(count > 0 ? size_t(count) : 0);
+        for (StageStats& s : *stats) {
+            s.count = reply.readInt64();
+            s.min = reply.readInt64();
+            s.mean = reply.readInt64();
+            s.p50 = reply.readInt64();
+            s.p90 = reply.readInt64();
+            s.p99 = reply.readInt64();
+            s.max = reply.readInt64();
+        }
+    }
+    return true;
+}
+
+// Waits for the next vsync so that each frame is composited on its own.
+static bool waitForVsync(DisplayEventReceiver& receiver) {
+    struct pollfd fds = { receiver.getFd(), POLLIN, 0 };
+    for (;;) {
+        if (poll(&fds, 1, 1000) <= 0) {
+            fprintf(stderr, "timed out waiting for vsync\n");
+            return false;
+        }
+        DisplayEventReceiver::Event events[8];
+        ssize_t n;
+        bool gotVsync = false;
+        while ((n = receiver.getEvents(events, NELEMS(events))) > 0) {
+            for (ssize_t i = 0; i < n; i++) {
+                gotVsync |= events[i].header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC;
+            }
+        }
+        if (gotVsync) {
+            return true;
+        }
+    }
+}
+
+static void printResults(const LayerTreeDesc& desc, const std::vector<StageStats>& stats) {
+    printf("\n %s: %u layers, %u updating\n", desc.name, desc.numLayers, desc.numUpdating);
+    printf("   %-16s | count | mean (us) |  p50 |  p90 |  p99 |   max\n", "Stage");
+    int64_t totalMean = 0;
+    for (size_t i = 0; i < stats.size(); i++) {
+        const StageStats& s = stats[i];
+        const char* name = i < size_t(NELEMS(STAGE_NAMES)) ? STAGE_NAMES[i] : "unknown";
+        printf("   %-16s | %5" PRId64 " | %9" PRId64 " | %4" PRId64 " | %4" PRId64 " | %4"
+                PRId64 " | %5" PRId64 "\n", name, s.count, s.mean / 1000, s.p50 / 1000,
+                s.p90 / 1000, s.p99 / 1000, s.max / 1000);
+        totalMean += s.mean;
+    }
+    printf("   %-16s |       | %9" PRId64 " |\n", "total", totalMean / 1000);
+    fflush(stdout);
+}
+
+static bool runTest(const sp<SurfaceComposerClient>& client, const DisplayInfo& info,
+        const LayerTreeDesc& desc) {
+    LayerTreeBenchmark b(desc);
+    if (!b.setUp(client, info)) {
+        b.tearDown();
+        return false;
+    }
+
+    DisplayEventReceiver receiver;
+    if (receiver.initCheck() != NO_ERROR) {
+        fprintf(stderr, "DisplayEventReceiver::initCheck failed\n");
+        return false;
+    }
+    receiver.setVsyncRate(1);
+
+    // Let the initial buffers and geometry settle before measuring
+    for (int i = 0; i < 10; i++) {
+        if (!waitForVsync(receiver)) {
+            return false;
+        }
+    }
+
+    bool success = stageTiming(1, nullptr);
+    for (uint32_t frame = 0; success && frame < g_Frames; frame++) {
+        success = b.drawFrame() && waitForVsync(receiver);
+    }
+
+    std::vector<StageStats> stats;
+    success = stageTiming(0, &stats) && success;
+    b.tearDown();
+
+    if (success) {
+        printResults(desc, stats);
+    }
+    return success;
+}
+
+// Print the command usage help to stderr.
+static void showHelp(const char *cmd) {
+    fprintf(stderr, "usage: %s [options]\n", cmd);
+    fprintf(stderr, "options include:\n"
+                    "  -f N            measure N frames per scenario (default %u)\n"
+                    "  -s N            sleep for N ms between scenarios\n"
+                    "  --help          print this helpful message and exit\n",
+            g_Frames);
+}
+
+int main(int argc, char** argv) {
+    for (;;) {
+        int option_index = 0;
+        static struct option long_options[] = {
+            {"help",     no_argument, 0,  0 },
+            {     0,               0, 0,  0 }
+        };
+
+        int ret = getopt_long(argc, argv, "f:s:", long_options, &option_index);
+        if (ret < 0) {
+            break;
+        }
+
+        switch (ret) {
+            case 'f':
+                g_Frames = atoi(optarg);
+            break;
+
+            case 's':
+                g_SleepBetweenRunsMs = atoi(optarg);
+            break;
+
+            case 0:
+                showHelp(argv[0]);
+                exit(0);
+
+            default:
+                showHelp(argv[0]);
+                exit(2);
+        }
+    }
+
+    ProcessState::self()->startThreadPool();
+
+    sp<SurfaceComposerClient> client = new SurfaceComposerClient;
+    status_t err = client->initCheck();
+    if (err != NO_ERROR) {
+        fprintf(stderr, "SurfaceComposerClient::initCheck error: %#x\n", err);
+        return 1;
+    }
+
+    sp<IBinder> dpy = client->getBuiltInDisplay(ISurfaceComposer::eDisplayIdMain);
+    DisplayInfo info;
+    if (dpy == nullptr || client->getDisplayInfo(dpy, &info) != NO_ERROR) {
+        fprintf(stderr, "SurfaceComposer::getDisplayInfo failed\n");
+        return 1;
+    }
+
+    printf(" cmdline:");
+    for (int i = 0; i < argc; i++) {
+        printf(" %s", argv[i]);
+    }
+    printf("\n");
+
+    for (int i = 0; i < NELEMS(layerTrees); i++) {
+        if (!runTest(client, info, layerTrees[i])) {
+            stageTiming(0, nullptr);
+            fprintf(stderr, "exiting due to error.\n");
+            return 1;
+        }
+        if (g_SleepBetweenRunsMs > 0) {
+            usleep(g_SleepBetweenRunsMs * 1000);
+        }
+    }
+    return 0;
+}
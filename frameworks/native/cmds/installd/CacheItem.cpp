@@ -116,6 +116,7 @@ int CacheItem::purge() {
                 break;
             }
         }
+        fts_close(fts);
     } else {
         if (tombstone) {
             if (truncate(path.c_str(), 0) != 0) {
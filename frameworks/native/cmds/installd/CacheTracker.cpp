@@ -54,6 +54,7 @@ void CacheTracker::loadStats() {
     ATRACE_BEGIN("loadStats quota");
     cacheUsed = 0;
     if (loadQuotaStats()) {
+        ATRACE_END();
         return;
     }
     ATRACE_END();
@@ -177,7 +178,8 @@ void CacheTracker::loadItems() {
     ATRACE_END();
 
     ATRACE_BEGIN("sortItems");
-    auto cmp = [](std::shared_ptr<CacheItem> left, std::shared_ptr<CacheItem> right) {
+    auto cmp = [](const std::shared_ptr<CacheItem>& left,
+            const std::shared_ptr<CacheItem>& right) {
         // TODO: sort dotfiles last
         // TODO: sort code_cache last
         if (left->modified != right->modified) {
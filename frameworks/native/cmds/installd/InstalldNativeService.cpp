@@ -18,6 +18,8 @@
 
 #define ATRACE_TAG ATRACE_TAG_PACKAGE_MANAGER
 
+#include <algorithm>
+#include <atomic>
 #include <errno.h>
 #include <inttypes.h>
 #include <fstream>
@@ -34,6 +36,7 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/xattr.h>
+#include <thread>
 #include <unistd.h>
 
 #include <android-base/logging.h>
@@ -57,6 +60,7 @@
 #include "utils.h"
 
 #include "CacheTracker.h"
+#include "SizeTracker.h"
 #include "MatchExtensionGen.h"
 
 #ifndef LOG_TAG
@@ -226,6 +230,14 @@ status_t InstalldNativeService::dump(int fd, const Vector<String16> & /* args */
         }
     }
 
+    {
+        std::lock_guard<std::mutex> lock(mDexoptLock);
+        out << endl << "Running dexopt jobs:" << endl;
+        for (const auto& path : mDexoptPaths) {
+            out << "    " << path << endl;
+        }
+    }
+
     out << endl;
     out.flush();
 
@@ -915,6 +927,39 @@ binder::Status InstalldNativeService::destroyUserData(const std::unique_ptr<std:
     return res;
 }
 
+// Upper bound on the threads measuring cache trees at once; the work is I/O bound.
+static constexpr unsigned int kMaxCacheStatsThreads = 4;
+
+// Loads the stats of all trackers. Without quota support this walks the cache directories of
+// every app, so spread the trackers across a few threads.
+static void loadTrackerStats(
+        const std::unordered_map<uid_t, std::shared_ptr<CacheTracker>>& trackers) {
+    std::vector<std::shared_ptr<CacheTracker>> pending;
+    pending.reserve(trackers.size());
+    for (const auto& it : trackers) {
+        pending.push_back(it.second);
+    }
+
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        size_t index;
+        while ((index = next++) < pending.size()) {
+            pending[index]->loadStats();
+        }
+    };
+    unsigned int threadCount = std::min(std::max(std::thread::hardware_concurrency(), 1u),
+            kMaxCacheStatsThreads);
+    threadCount = std::min<size_t>(threadCount, pending.size());
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < threadCount; i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
 binder::Status InstalldNativeService::freeCache(const std::unique_ptr<std::string>& uuid,
         int64_t targetFreeBytes, int64_t cacheReservedBytes, int32_t flags) {
     ENFORCE_UID(AID_SYSTEM);
@@ -999,8 +1044,8 @@ binder::Status InstalldNativeService::freeCache(const std::unique_ptr<std::strin
         };
         std::priority_queue<std::shared_ptr<CacheTracker>,
                 std::vector<std::shared_ptr<CacheTracker>>, decltype(cmp)> queue(cmp);
+        loadTrackerStats(trackers);
         for (const auto& it : trackers) {
-            it.second->loadStats();
             queue.push(it.second);
             cacheTotal += it.second->cacheUsed;
         }
@@ -1219,6 +1264,12 @@ static void collectQuotaStats(const std::string& device, int32_t userId,
     }
 }
 
+// Sizes of the app data directories measured without quota support, kept until they change.
+static SizeTracker& getSizeTracker() {
+    static SizeTracker tracker;
+    return tracker;
+}
+
 static void collectManualStats(const std::string& path, struct stats* stats) {
     DIR *d;
     int dfd;
@@ -1249,8 +1300,7 @@ static void collectManualStats(const std::string& path, struct stats* stats) {
                 continue;
             } else {
                 // Measure all children nodes
-                size = 0;
-                calculate_tree_size(StringPrintf("%s/%s", path.c_str(), name), &size);
+                size = getSizeTracker().getTreeSize(StringPrintf("%s/%s", path.c_str(), name));
             }
 
             if (!strcmp(name, "cache") || !strcmp(name, "code_cache")) {
@@ -1821,6 +1871,55 @@ binder::Status InstalldNativeService::mergeProfiles(int32_t uid, const std::stri
     return ok();
 }
 
+// Rough peak memory use of a dex2oat process compiling a large app, in KB.
+static constexpr uint64_t kDex2oatMemoryKb = 256 * 1024;
+
+static uint64_t getAvailableMemoryKb() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string name;
+    uint64_t value;
+    std::string unit;
+    while (meminfo >> name >> value >> unit) {
+        if (name == "MemAvailable:") {
+            return value;
+        }
+    }
+    return 0;
+}
+
+// Returns how many dex2oat processes may run at once: one per group of cores dex2oat is told to
+// use, as long as the available memory can hold them, and always at least one.
+static size_t getDexoptJobLimit() {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int32_t threads = property_get_int32("dalvik.vm.dex2oat-threads", 0);
+    if (cpus <= 0 || threads <= 0) {
+        // dex2oat uses every core by default.
+        return 1;
+    }
+    size_t limit = cpus / threads;
+    size_t memoryLimit = getAvailableMemoryKb() / kDex2oatMemoryKb;
+    limit = std::min(limit, memoryLimit);
+    return std::max<size_t>(limit, 1);
+}
+
+void InstalldNativeService::acquireDexoptSlot(const std::string& path) {
+    std::unique_lock<std::mutex> lock(mDexoptLock);
+    // Two jobs for the same file would write the same outputs.
+    while (mDexoptPaths.count(path) != 0
+            || (!mDexoptPaths.empty() && mDexoptPaths.size() >= getDexoptJobLimit())) {
+        mDexoptCondition.wait(lock);
+    }
+    mDexoptPaths.insert(path);
+}
+
+void InstalldNativeService::releaseDexoptSlot(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mDexoptLock);
+        mDexoptPaths.erase(path);
+    }
+    mDexoptCondition.notify_all();
+}
+
 binder::Status InstalldNativeService::dexopt(const std::string& apkPath, int32_t uid,
         const std::unique_ptr<std::string>& packageName, const std::string& instructionSet,
         int32_t dexoptNeeded, const std::unique_ptr<std::string>& outputPath, int32_t dexFlags,
@@ -1832,7 +1931,10 @@ binder::Status InstalldNativeService::dexopt(const std::string& apkPath, int32_t
     if (packageName && *packageName != "*") {
         CHECK_ARGUMENT_PACKAGE_NAME(*packageName);
     }
-    std::lock_guard<std::recursive_mutex> lock(mLock);
+    // dex2oat can run for minutes, so don't hold mLock and block every other call meanwhile.
+    // Calls for different files may compile concurrently; the caller is responsible for not
+    // deleting or moving a file's artifacts while it is being compiled.
+    acquireDexoptSlot(apkPath);
 
     const char* apk_path = apkPath.c_str();
     const char* pkgname = packageName ? packageName->c_str() : "*";
@@ -1845,6 +1947,7 @@ binder::Status InstalldNativeService::dexopt(const std::string& apkPath, int32_t
     int res = android::installd::dexopt(apk_path, uid, pkgname, instruction_set, dexoptNeeded,
             oat_dir, dexFlags, compiler_filter, volume_uuid, class_loader_context, se_info,
             downgrade);
+    releaseDexoptSlot(apkPath);
     return res ? error(res, "Failed to dexopt") : ok();
 }
 
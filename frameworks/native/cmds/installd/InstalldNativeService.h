@@ -21,6 +21,9 @@
 #include <inttypes.h>
 #include <unistd.h>
 
+#include <condition_variable>
+#include <mutex>
+#include <set>
 #include <vector>
 #include <unordered_map>
 
@@ -134,6 +137,15 @@ private:
     /* Map from UID to cache quota size */
     std::unordered_map<uid_t, int64_t> mCacheQuotas;
 
+    /* Dexopt jobs run outside of mLock, bounded by getDexoptJobLimit() */
+    std::mutex mDexoptLock;
+    std::condition_variable mDexoptCondition;
+    /* Paths of the APKs or secondary dex files currently being compiled */
+    std::set<std::string> mDexoptPaths;
+
+    void acquireDexoptSlot(const std::string& path);
+    void releaseDexoptSlot(const std::string& path);
+
     std::string findDataMediaPath(const std::unique_ptr<std::string>& uuid, userid_t userid);
     std::string findQuotaDeviceForUuid(const std::unique_ptr<std::string>& uuid);
 };
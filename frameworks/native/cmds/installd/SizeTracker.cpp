@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SizeTracker.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+
+using android::base::StringPrintf;
+
+namespace android {
+namespace installd {
+
+// Everything that can change the size of a directory's content.
+static constexpr uint32_t kWatchMask = IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM
+        | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+// Stay well below the default fs.inotify.max_user_watches, which is shared with the
+// other root processes.
+static constexpr size_t kMaxWatches = 4096;
+
+SizeTracker::SizeTracker() : mInotifyFd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+    if (mInotifyFd == -1) {
+        PLOG(WARNING) << "Failed to create inotify instance; sizes won't be remembered";
+    }
+}
+
+int64_t SizeTracker::getTreeSize(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mLock);
+    processEventsLocked();
+
+    auto it = mTrees.find(path);
+    if (it != mTrees.end()) {
+        return it->second.size;
+    }
+
+    struct stat s;
+    if (lstat(path.c_str(), &s) != 0) {
+        if (errno != ENOENT) {
+            PLOG(WARNING) << "Failed to stat " << path;
+        }
+        return 0;
+    }
+    Tree tree;
+    tree.size = s.st_blocks * 512;
+    if (!S_ISDIR(s.st_mode)) {
+        return tree.size;
+    }
+
+    bool watched = mInotifyFd != -1;
+    tree.size += measureLocked(path, s.st_dev, &tree.watches, &watched);
+    if (watched) {
+        for (int wd : tree.watches) {
+            mWatchOwners.emplace(wd, path);
+        }
+        int64_t size = tree.size;
+        mTrees.emplace(path, std::move(tree));
+        return size;
+    }
+
+    // Too large to watch, or inotify is unavailable; forget the watches nobody else needs.
+    for (int wd : tree.watches) {
+        if (mWatchOwners.count(wd) == 0) {
+            inotify_rm_watch(mInotifyFd, wd);
+        }
+    }
+    return tree.size;
+}
+
+int64_t SizeTracker::measureLocked(const std::string& path, dev_t dev,
+        std::vector<int>* watches, bool* watched) {
+    // Watch before reading, so that nothing changing during the walk goes unnoticed.
+    if (*watched) {
+        if (mWatchOwners.size() + watches->size() >= kMaxWatches) {
+            *watched = false;
+        } else {
+            int wd = inotify_add_watch(mInotifyFd, path.c_str(), kWatchMask);
+            if (wd == -1) {
+                PLOG(VERBOSE) << "Failed to watch " << path;
+                *watched = false;
+            } else {
+                watches->push_back(wd);
+            }
+        }
+    }
+
+    DIR* d = opendir(path.c_str());
+    if (d == nullptr) {
+        if (errno != ENOENT) {
+            PLOG(WARNING) << "Failed to open " << path;
+        }
+        return 0;
+    }
+    int dfd = dirfd(d);
+    int64_t size = 0;
+    struct dirent* de;
+    while ((de = readdir(d))) {
+        const char* name = de->d_name;
+        if (!strcmp(name, ".") || !strcmp(name, "..")) {
+            continue;
+        }
+        struct stat s;
+        if (fstatat(dfd, name, &s, AT_SYMLINK_NOFOLLOW) != 0) {
+            continue;
+        }
+        size += s.st_blocks * 512;
+        if (S_ISDIR(s.st_mode) && s.st_dev == dev) {
+            size += measureLocked(StringPrintf("%s/%s", path.c_str(), name), dev, watches,
+                    watched);
+        }
+    }
+    closedir(d);
+    return size;
+}
+
+void SizeTracker::processEventsLocked() {
+    if (mInotifyFd == -1) {
+        return;
+    }
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+    while ((len = TEMP_FAILURE_RETRY(read(mInotifyFd, buf, sizeof(buf)))) > 0) {
+        for (char* ptr = buf; ptr < buf + len; ) {
+            const struct inotify_event* event = reinterpret_cast<struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                dropAllLocked();
+                continue;
+            }
+            auto owner = mWatchOwners.find(event->wd);
+            while (owner != mWatchOwners.end()) {
+                dropTreeLocked(std::string(owner->second));
+                owner = mWatchOwners.find(event->wd);
+            }
+        }
+    }
+}
+
+void SizeTracker::dropTreeLocked(const std::string& path) {
+    auto it = mTrees.find(path);
+    if (it == mTrees.end()) {
+        return;
+    }
+    for (int wd : it->second.watches) {
+        auto range = mWatchOwners.equal_range(wd);
+        for (auto owner = range.first; owner != range.second; ++owner) {
+            if (owner->second == path) {
+                mWatchOwners.erase(owner);
+                break;
+            }
+        }
+        if (mWatchOwners.count(wd) == 0) {
+            inotify_rm_watch(mInotifyFd, wd);
+        }
+    }
+    mTrees.erase(it);
+}
+
+void SizeTracker::dropAllLocked() {
+    for (const auto& owner : mWatchOwners) {
+        inotify_rm_watch(mInotifyFd, owner.first);
+    }
+    mWatchOwners.clear();
+    mTrees.clear();
+}
+
+}  // namespace installd
+}  // namespace android
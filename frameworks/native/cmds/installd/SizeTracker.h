@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_INSTALLD_SIZE_TRACKER_H
+#define ANDROID_INSTALLD_SIZE_TRACKER_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <android-base/macros.h>
+#include <android-base/unique_fd.h>
+
+namespace android {
+namespace installd {
+
+/**
+ * Measures directory trees when quotas aren't available, and remembers their
+ * size until something inside them changes. Every directory of a remembered
+ * tree has an inotify watch, so any file created, deleted, moved or written
+ * in it drops the tree, which is walked again on the next request.
+ */
+class SizeTracker {
+public:
+    SizeTracker();
+
+    /**
+     * Returns the size in bytes of everything under path, including path
+     * itself, without crossing mount points. This is the same value as
+     * calculate_tree_size() without gid filters.
+     */
+    int64_t getTreeSize(const std::string& path);
+
+private:
+    struct Tree {
+        int64_t size;
+        std::vector<int> watches;
+    };
+
+    android::base::unique_fd mInotifyFd;
+    std::mutex mLock;
+    std::unordered_map<std::string, Tree> mTrees;
+    /* Trees watching each watch descriptor; trees may share directories */
+    std::unordered_multimap<int, std::string> mWatchOwners;
+
+    void processEventsLocked();
+    void dropTreeLocked(const std::string& path);
+    void dropAllLocked();
+    int64_t measureLocked(const std::string& path, dev_t dev, std::vector<int>* watches,
+            bool* watched);
+
+    DISALLOW_COPY_AND_ASSIGN(SizeTracker);
+};
+
+}  // namespace installd
+}  // namespace android
+
+#endif  // ANDROID_INSTALLD_SIZE_TRACKER_H
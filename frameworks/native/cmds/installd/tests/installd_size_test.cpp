@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <android-base/stringprintf.h>
+#include <gtest/gtest.h>
+
+#include "SizeTracker.h"
+
+using android::base::StringPrintf;
+
+namespace android {
+namespace installd {
+
+static const char* kTestPath = "/data/local/tmp/size_test";
+
+static std::string path(const char* name) {
+    return StringPrintf("%s/%s", kTestPath, name);
+}
+
+static void mkdir(const char* name) {
+    ::mkdir(path(name).c_str(), 0755);
+}
+
+static void write(const char* name, int len) {
+    int fd = ::open(path(name).c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    std::string data(len, 'x');
+    ::write(fd, data.data(), data.size());
+    ::fsync(fd);
+    ::close(fd);
+}
+
+static int64_t blocks(const char* name) {
+    struct stat s;
+    if (lstat(path(name).c_str(), &s) != 0) {
+        return 0;
+    }
+    return s.st_blocks * 512;
+}
+
+class SizeTrackerTest : public testing::Test {
+protected:
+    virtual void SetUp() {
+        system(StringPrintf("rm -rf %s", kTestPath).c_str());
+        ::mkdir(kTestPath, 0755);
+        mkdir("app");
+        mkdir("app/files");
+        write("app/files/a", 8192);
+    }
+
+    virtual void TearDown() {
+        system(StringPrintf("rm -rf %s", kTestPath).c_str());
+    }
+
+    int64_t expected() {
+        return blocks("app") + blocks("app/files") + blocks("app/files/a")
+                + blocks("app/files/b") + blocks("app/files/sub") + blocks("app/files/sub/c");
+    }
+};
+
+TEST_F(SizeTrackerTest, Measure) {
+    SizeTracker tracker;
+    EXPECT_EQ(expected(), tracker.getTreeSize(path("app")));
+    EXPECT_EQ(expected(), tracker.getTreeSize(path("app")));
+    EXPECT_EQ(0, tracker.getTreeSize(path("missing")));
+}
+
+TEST_F(SizeTrackerTest, FileWritten) {
+    SizeTracker tracker;
+    int64_t before = tracker.getTreeSize(path("app"));
+    write("app/files/a", 65536);
+    int64_t after = tracker.getTreeSize(path("app"));
+    EXPECT_GT(after, before);
+    EXPECT_EQ(expected(), after);
+}
+
+TEST_F(SizeTrackerTest, FileCreatedAndDeleted) {
+    SizeTracker tracker;
+    tracker.getTreeSize(path("app"));
+    mkdir("app/files/sub");
+    write("app/files/sub/c", 65536);
+    EXPECT_EQ(expected(), tracker.getTreeSize(path("app")));
+
+    write("app/files/sub/c", 65536);
+    EXPECT_EQ(expected(), tracker.getTreeSize(path("app")));
+
+    unlink(path("app/files/sub/c").c_str());
+    EXPECT_EQ(expected(), tracker.getTreeSize(path("app")));
+}
+
+TEST_F(SizeTrackerTest, FileMoved) {
+    SizeTracker tracker;
+    tracker.getTreeSize(path("app"));
+    rename(path("app/files/a").c_str(), path("other").c_str());
+    EXPECT_EQ(expected(), tracker.getTreeSize(path("app")));
+    rename(path("other").c_str(), path("app/files/b").c_str());
+    EXPECT_EQ(expected(), tracker.getTreeSize(path("app")));
+}
+
+}  // namespace installd
+}  // namespace android
@@ -64,6 +64,17 @@ public:
                                          uint32_t code, const Parcel& data,
                                          Parcel* reply, uint32_t flags);
 
+            // Queues a copy of a oneway transaction on this thread instead of
+            // sending it right away. The queued transactions, to any number of
+            // handles, are sent in the order they were queued, with a single
+            // write to the driver, by flushOnewayTransactions(). They are also
+            // flushed before any other transaction or reply from this thread,
+            // by flushCommands(), and once the queue is full.
+            status_t            queueOnewayTransaction(int32_t handle,
+                                                       uint32_t code, const Parcel& data);
+            // Returns the first error of the flushed transactions, if any
+            status_t            flushOnewayTransactions();
+
             void                incStrongHandle(int32_t handle);
             void                decStrongHandle(int32_t handle);
             void                incWeakHandle(int32_t handle);
@@ -126,6 +137,13 @@ private:
             uid_t               mCallingUid;
             int32_t             mStrictModePolicy;
             int32_t             mLastTransactionBinderFlags;
+
+            struct QueuedTransaction {
+                int32_t handle;
+                uint32_t code;
+                Parcel* data;
+            };
+            Vector<QueuedTransaction> mQueuedTransactions;
 };
 
 }; // namespace android
@@ -28,14 +28,25 @@ namespace android {
 // ----------------------------------------------------------------------------
 
 class SimpleBestFitAllocator;
+class SizeClassCache;
 
 // ----------------------------------------------------------------------------
 
 class MemoryDealer : public RefBase
 {
 public:
+    enum AllocatorPolicy {
+        // Every allocation and deallocation walks the list of blocks
+        BEST_FIT,
+        // Freed blocks are kept on per-size free lists, so that allocating a
+        // size that was allocated and freed before takes constant time. The
+        // cached blocks go back to the best-fit allocator when it runs out.
+        SIZE_CLASSES,
+    };
+
     MemoryDealer(size_t size, const char* name = 0,
             uint32_t flags = 0 /* or bits such as MemoryHeapBase::READ_ONLY */ );
+    MemoryDealer(size_t size, const char* name, uint32_t flags, AllocatorPolicy policy);
 
     virtual sp<IMemory> allocate(size_t size);
     virtual void        deallocate(size_t offset);
@@ -55,6 +66,7 @@ private:
 
     sp<IMemoryHeap>             mHeap;
     SimpleBestFitAllocator*     mAllocator;
+    SizeClassCache*             mSizeClasses;
 };
 
 
@@ -32,6 +32,12 @@ namespace os {
 /*
  * C++ implementation of PersistableBundle, a mapping from String values to
  * various types that can be saved to persistent and later restored.
+ *
+ * Like BaseBundle in Java, a bundle read from a Parcel keeps the serialized
+ * entries and only parses them on first access, and a bundle that has been
+ * read or written keeps them until it is modified, so that writing it again
+ * is a single copy. As a consequence, concurrent use of const methods is not
+ * thread-safe.
  */
 class PersistableBundle : public Parcelable {
 public:
@@ -94,6 +100,8 @@ public:
     std::set<String16> getPersistableBundleKeys() const;
 
     friend bool operator==(const PersistableBundle& lhs, const PersistableBundle& rhs) {
+        lhs.unparcel();
+        rhs.unparcel();
         return (lhs.mBoolMap == rhs.mBoolMap && lhs.mIntMap == rhs.mIntMap &&
                 lhs.mLongMap == rhs.mLongMap && lhs.mDoubleMap == rhs.mDoubleMap &&
                 lhs.mStringMap == rhs.mStringMap && lhs.mBoolVectorMap == rhs.mBoolVectorMap &&
@@ -111,6 +119,10 @@ public:
 private:
     status_t writeToParcelInner(Parcel* parcel) const;
     status_t readFromParcelInner(const Parcel* parcel, size_t length);
+    status_t readEntries(const Parcel* parcel);
+
+    // Populates the maps from mParcelled if that hasn't been done yet
+    void unparcel() const;
 
     std::map<String16, bool> mBoolMap;
     std::map<String16, int32_t> mIntMap;
@@ -123,6 +135,12 @@ private:
     std::map<String16, std::vector<double>> mDoubleVectorMap;
     std::map<String16, std::vector<String16>> mStringVectorMap;
     std::map<String16, PersistableBundle> mPersistableBundleMap;
+
+    // The entries as written by writeToParcelInner(), valid until modified
+    mutable std::vector<uint8_t> mParcelled;
+    mutable bool mParcelledValid = false;
+    // Whether the maps are still to be populated from mParcelled
+    mutable bool mPendingUnparcel = false;
 };
 
 }  // namespace os
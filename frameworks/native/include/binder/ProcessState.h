@@ -68,8 +68,21 @@ public:
             void                spawnPooledThread(bool isMain);
             
             status_t            setThreadPoolMaxThreadCount(size_t maxThreads);
+            // Number of threads, including the main pooled thread, started as
+            // soon as the pool starts instead of when the driver asks for
+            // them. The extra threads don't count towards the maximum above.
+            void                setThreadPoolMinThreadCount(size_t minThreads);
             void                giveThreadPoolName();
 
+            // Appends the thread pool occupancy and starvation statistics
+            void                dumpThreadPoolStats(String8& result);
+
+            // Counts, payload sizes and latency histograms of the transactions
+            // sent and received by this process, per interface and code.
+            // Collection is off by default; enabling it clears the statistics.
+            void                setTransactionStatsEnabled(bool enabled);
+            void                dumpTransactionStats(String8& result);
+
             String8             getDriverName();
 
             ssize_t             getKernelReferences(size_t count, uintptr_t* buf);
@@ -104,6 +117,13 @@ private:
             size_t              mMaxThreads;
             // Time when thread pool was emptied
             int64_t             mStarvationStartTimeMs;
+            // Statistics, also protected by mThreadCountLock
+            size_t              mPooledThreadsCount;
+            size_t              mPeakExecutingThreadsCount;
+            uint64_t            mCommandsCount;
+            uint64_t            mStarvationCount;
+            int64_t             mTotalStarvationTimeMs;
+            int64_t             mMaxStarvationTimeMs;
 
     mutable Mutex               mLock;  // protects everything below.
 
@@ -119,6 +139,7 @@ private:
 
             String8             mRootDir;
             bool                mThreadPoolStarted;
+            size_t              mMinThreads;
     volatile int32_t            mThreadPoolSeq;
 };
     
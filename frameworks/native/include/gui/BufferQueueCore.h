@@ -119,6 +119,10 @@ private:
     // given slot.
     void clearBufferSlotLocked(int slot);
 
+    // recycleBufferSlotLocked offers the buffer of a free slot to the
+    // GraphicBufferPool, then clears the slot like clearBufferSlotLocked.
+    void recycleBufferSlotLocked(int slot);
+
     // freeAllBuffersLocked frees the GraphicBuffer and sync resources for
     // all slots, even if they're currently dequeued, queued, or acquired.
     void freeAllBuffersLocked();
@@ -37,6 +37,8 @@
 
 namespace android {
 
+class VelocityTracker;
+
 /*
  * Intermediate representation used to send input events and related signals.
  *
@@ -142,6 +144,13 @@ protected:
 public:
     InputChannel(const String8& name, int fd);
 
+    /* Creates an input channel that exchanges messages through the pair of rings in
+     * the shared memory region ringFd, and uses the socket fd only to wake up the
+     * receiving end. The server end sends on the first ring, the client end on the
+     * second one. Takes ownership of both fds.
+     */
+    InputChannel(const String8& name, int fd, int ringFd, bool isServer);
+
     /* Creates a pair of input channels.
      *
      * Returns OK on success.
@@ -149,9 +158,26 @@ public:
     static status_t openInputChannelPair(const String8& name,
             sp<InputChannel>& outServerChannel, sp<InputChannel>& outClientChannel);
 
+    /* Creates a pair of input channels that exchange messages through shared memory.
+     *
+     * Sending a message only makes a syscall when the receiver may be waiting for
+     * one, and receiving only makes one when there is no message left, so a burst
+     * of motion samples costs a couple of syscalls rather than two per sample.
+     * The receiving end must keep receiving until WOULD_BLOCK before waiting for
+     * its fd to become readable again.
+     *
+     * Returns OK on success.
+     */
+    static status_t openSharedMemoryInputChannelPair(const String8& name,
+            sp<InputChannel>& outServerChannel, sp<InputChannel>& outClientChannel);
+
     inline String8 getName() const { return mName; }
     inline int getFd() const { return mFd; }
 
+    /* Returns the fd of the shared memory rings, or -1 if the channel only uses its socket. */
+    inline int getRingFd() const { return mRingFd; }
+    inline bool isServer() const { return mIsServer; }
+
     /* Sends a message to the other endpoint.
      *
      * If the channel is full then the message is guaranteed not to have been sent at all.
@@ -181,8 +207,18 @@ public:
     sp<InputChannel> dup() const;
 
 private:
+    struct MessageRing;
+
     String8 mName;
     int mFd;
+    int mRingFd;
+    bool mIsServer;
+    void* mRingRegion;
+    MessageRing* mSendRing;
+    MessageRing* mReceiveRing;
+
+    status_t sendWakeup();
+    status_t drainWakeups();
 };
 
 /*
@@ -340,6 +376,34 @@ public:
      */
     bool hasPendingBatch() const;
 
+    /* Accuracy of the motion predictions made for a device and source. */
+    struct MotionPredictionStats {
+        // Number of predicted pointer positions compared with the actual positions
+        uint64_t count;
+        // Mean and largest distance between the predicted and actual positions
+        float meanError;
+        float maxError;
+    };
+
+    /* Enables motion prediction for touches from the given device, or from any
+     * device if deviceId is -1, and the given source.
+     *
+     * When a batch is resampled without a later sample to interpolate with, the
+     * pointer positions are predicted up to horizon past the frame time using the
+     * named VelocityTracker strategy instead of extrapolated from the last two
+     * samples. A horizon of 0 disables prediction.
+     *
+     * The default, for any touchscreen, comes from the ro.input.prediction_strategy
+     * and ro.input.prediction_ms properties. Prediction requires touch resampling.
+     */
+    void setMotionPrediction(int32_t deviceId, int32_t source, const char* strategy,
+            nsecs_t horizon);
+
+    /* Gets the accuracy of the predictions made with the setting for the given
+     * device and source. Returns false if there is no such setting. */
+    bool getMotionPredictionStats(int32_t deviceId, int32_t source,
+            MotionPredictionStats* outStats) const;
+
 private:
     // True if touch resampling is enabled.
     const bool mResampleTouch;
@@ -413,6 +477,33 @@ private:
     };
     Vector<TouchState> mTouchStates;
 
+    // Motion prediction settings per device and source, with the error telemetry
+    // of the predictions made with them.
+    struct PredictionConfig {
+        int32_t deviceId;
+        int32_t source;
+        String8 strategy;
+        nsecs_t horizon;
+        uint64_t errorCount;
+        double totalError;
+        float maxError;
+    };
+    Vector<PredictionConfig> mPredictionConfigs;
+
+    // Motion predictor per device and source, for touches being predicted. The last
+    // prediction is kept until it can be compared with the actual positions.
+    struct Predictor {
+        int32_t deviceId;
+        int32_t source;
+        VelocityTracker* tracker;
+        size_t configIndex;
+        nsecs_t predictionTime;
+        BitSet32 predictionIdBits;
+        float predictionX[MAX_POINTER_ID + 1];
+        float predictionY[MAX_POINTER_ID + 1];
+    };
+    Vector<Predictor> mPredictors;
+
     // Chain of batched sequence numbers.  When multiple input messages are combined into
     // a batch, we append a record here that associates the last sequence number in the
     // batch with the previous one.  When the finished signal is sent, we traverse the
@@ -436,6 +527,12 @@ private:
     ssize_t findBatch(int32_t deviceId, int32_t source) const;
     ssize_t findTouchState(int32_t deviceId, int32_t source) const;
 
+    ssize_t findPredictionConfig(int32_t deviceId, int32_t source) const;
+    ssize_t findPredictor(int32_t deviceId, int32_t source) const;
+    void updatePredictor(const TouchState& state, const InputMessage* msg);
+    void removePredictor(int32_t deviceId, int32_t source);
+    bool predictTouchState(TouchState& state, nsecs_t sampleTime, MotionEvent* event);
+
     status_t sendUnchainedFinishedSignal(uint32_t seq, bool handled);
 
     static void initializeKeyEvent(KeyEvent* event, const InputMessage* msg);
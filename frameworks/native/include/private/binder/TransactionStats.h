@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PRIVATE_BINDER_TRANSACTION_STATS_H
+#define ANDROID_PRIVATE_BINDER_TRANSACTION_STATS_H
+
+#include <pthread.h>
+
+#include <atomic>
+#include <map>
+#include <utility>
+
+#include <utils/Mutex.h>
+#include <utils/String16.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+class Parcel;
+
+// Per-process counts, payload sizes and latency histograms of the binder
+// transactions sent and received, keyed by interface descriptor and code.
+// Each thread records into its own ThreadStats, whose lock is only ever
+// contended while the statistics are being dumped.
+class TransactionStats
+{
+public:
+    // Latency buckets are powers of two of microseconds: bucket i holds
+    // latencies in [2^(i-1), 2^i) us, the last one everything above.
+    static const size_t kLatencyBuckets = 22;
+
+    struct Entry {
+        Entry();
+        void merge(const Entry& other);
+
+        String16 descriptor;
+        uint64_t count;
+        uint64_t errors;
+        uint64_t totalBytes;
+        size_t maxBytes;
+        uint64_t totalLatencyUs;
+        uint64_t maxLatencyUs;
+        uint32_t histogram[kLatencyBuckets];
+    };
+
+    static TransactionStats& self();
+
+    bool isEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+    // Enabling also clears the statistics collected so far
+    void setEnabled(bool enabled);
+
+    // An outgoing transaction on a handle; the descriptor is read from the
+    // interface token of the data the first time the handle and code are seen.
+    void recordOutgoing(int32_t handle, uint32_t code, const Parcel& data,
+            size_t bytes, status_t error, nsecs_t latency);
+    // An incoming transaction for an object implementing descriptor
+    void recordIncoming(const String16& descriptor, uint32_t code,
+            size_t bytes, status_t error, nsecs_t latency);
+
+    void dump(String8& result);
+
+private:
+    struct ThreadStats {
+        Mutex lock;
+        std::map<std::pair<int32_t, uint32_t>, Entry> outgoing;
+        // Keyed by the descriptor's buffer, which the entry keeps alive
+        std::map<std::pair<const char16_t*, uint32_t>, Entry> incoming;
+    };
+    typedef std::map<std::pair<String16, uint32_t>, Entry> Totals;
+
+    TransactionStats();
+
+    // The calling thread's statistics, registered on first use and folded
+    // into the retired totals when the thread exits
+    ThreadStats* threadStats();
+    static void threadDestructor(void* stats);
+
+    // Folds a thread's statistics, whose lock the caller holds, into totals
+    static void add(Totals& outgoing, Totals& incoming, const ThreadStats& stats);
+    static void dumpTotals(String8& result, const char* title, const Totals& totals);
+
+    std::atomic<bool> mEnabled;
+    pthread_key_t mThreadKey;
+    // Protects everything below
+    Mutex mLock;
+    Vector<ThreadStats*> mThreads;
+    Totals mRetiredOutgoing;
+    Totals mRetiredIncoming;
+};
+
+}; // namespace android
+
+#endif // ANDROID_PRIVATE_BINDER_TRANSACTION_STATS_H
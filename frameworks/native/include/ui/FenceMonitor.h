@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANDROID_FENCE_MONITOR_H
+#define ANDROID_FENCE_MONITOR_H
+
+#include <ui/FenceTime.h>
+#include <utils/Singleton.h>
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+
+// FenceMonitor waits for FenceTimes to signal on its own thread, using a
+// single epoll set for all of their sync fences, and stores each signal time
+// in its FenceTime. Threads that poll the FenceTimes of a monitored timeline,
+// like SurfaceFlinger's main thread, then only read the cached value instead
+// of making a system call per fence.
+//
+// The FenceMonitor only keeps weak references to the FenceTimes. Fences it
+// can't watch, because it's already watching MAX_FENCES or their fd can't be
+// added to the epoll set, are left to be queried as usual.
+class FenceMonitor : public Singleton<FenceMonitor> {
+public:
+    static constexpr size_t MAX_FENCES = 1024;
+
+    // Queues a FenceTime to be watched. This doesn't make a system call
+    // unless the monitor thread has to be woken up.
+    void monitor(const std::shared_ptr<FenceTime>& fence);
+
+private:
+    friend class Singleton<FenceMonitor>;
+
+    FenceMonitor();
+    ~FenceMonitor();
+
+    void threadMain();
+    // Called on the monitor thread
+    void watchPendingFences();
+    void onFenceSignaled(int fd);
+    void removeExpiredFences();
+
+    int mEpollFd;
+    int mEventFd;
+
+    std::mutex mMutex;
+    // protected by mMutex
+    std::vector<std::weak_ptr<FenceTime>> mPending;
+    bool mWakeRequested{false};
+    bool mExit{false};
+
+    // Only used on the monitor thread, by the fd added to mEpollFd
+    std::unordered_map<int, std::weak_ptr<FenceTime>> mWatched;
+
+    std::thread mThread;
+};
+
+}; // namespace android
+
+#endif // ANDROID_FENCE_MONITOR_H
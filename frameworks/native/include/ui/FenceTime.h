@@ -28,12 +28,14 @@
 
 namespace android {
 
+class FenceMonitor;
 class FenceToFenceTimeMap;
 
 // A wrapper around fence that only implements isValid and getSignalTime.
 // It automatically closes the fence in a thread-safe manner once the signal
 // time is known.
 class FenceTime {
+friend class FenceMonitor;
 friend class FenceToFenceTimeMap;
 public:
     // An atomic snapshot of the FenceTime that is flattenable.
@@ -103,6 +105,8 @@ public:
 
     // Attempts to get the timestamp from the Fence if the timestamp isn't
     // already cached. Otherwise, it returns the cached value.
+    // If the FenceMonitor is watching the Fence, the Fence isn't queried and
+    // the signal time stays pending until the FenceMonitor sets it.
     nsecs_t getSignalTime();
 
     // Gets the cached timestamp without attempting to query the Fence.
@@ -123,6 +127,9 @@ private:
     // never return SIGNAL_TIME_INVALID and isValid will always return true.
     FenceTime(const sp<Fence>& fence, bool forceValidForTest);
 
+    // Queries the Fence if the timestamp isn't already cached.
+    nsecs_t querySignalTime();
+
     enum class State {
         VALID,
         INVALID,
@@ -137,6 +144,9 @@ private:
     mutable std::mutex mMutex;
     sp<Fence> mFence{Fence::NO_FENCE};
     std::atomic<nsecs_t> mSignalTime{Fence::SIGNAL_TIME_INVALID};
+
+    // Set while the FenceMonitor is waiting for mFence to signal
+    std::atomic<bool> mMonitored{false};
 };
 
 // A queue of FenceTimes that are expected to signal in FIFO order.
@@ -155,16 +165,22 @@ private:
 //
 // push() and updateSignalTimes() are safe to call simultaneously from
 // different threads.
+//
+// A monitored FenceTimeline hands every pushed FenceTime to the FenceMonitor,
+// so that updateSignalTimes() only reads the cached signal times.
 class FenceTimeline {
 public:
     static constexpr size_t MAX_ENTRIES = 64;
 
+    void setMonitored(bool monitored);
+
     void push(const std::shared_ptr<FenceTime>& fence);
     void updateSignalTimes();
 
 private:
     mutable std::mutex mMutex;
     std::queue<std::weak_ptr<FenceTime>> mQueue;
+    bool mMonitored{false};
 };
 
 // Used by test code to create or get FenceTimes for a given Fence.
@@ -171,6 +171,15 @@ status_t BpBinder::transact(
     return DEAD_OBJECT;
 }
 
+status_t BpBinder::queueOnewayTransaction(uint32_t code, const Parcel& data)
+{
+    if (mAlive) {
+        return IPCThreadState::self()->queueOnewayTransaction(mHandle, code, data);
+    }
+
+    return DEAD_OBJECT;
+}
+
 status_t BpBinder::linkToDeath(
     const sp<DeathRecipient>& recipient, void* cookie, uint32_t flags)
 {
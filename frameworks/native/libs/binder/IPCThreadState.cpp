@@ -29,6 +29,7 @@
 
 #include <private/binder/binder_module.h>
 #include <private/binder/Static.h>
+#include <private/binder/TransactionStats.h>
 
 #include <errno.h>
 #include <inttypes.h>
@@ -277,6 +278,9 @@ static pthread_key_t gTLS = 0;
 static bool gShutdown = false;
 static bool gDisableBackgroundScheduling = false;
 
+// Queued oneway transactions are flushed once there are this many
+static const size_t MAX_QUEUED_ONEWAY_TRANSACTIONS = 64;
+
 IPCThreadState* IPCThreadState::self()
 {
     if (gHaveTLS) {
@@ -408,6 +412,7 @@ void IPCThreadState::flushCommands()
 {
     if (mProcess->mDriverFD <= 0)
         return;
+    flushOnewayTransactions();
     talkWithDriver(false);
 }
 
@@ -440,9 +445,14 @@ status_t IPCThreadState::getAndExecuteCommand()
 
         pthread_mutex_lock(&mProcess->mThreadCountLock);
         mProcess->mExecutingThreadsCount++;
+        mProcess->mCommandsCount++;
+        if (mProcess->mExecutingThreadsCount > mProcess->mPeakExecutingThreadsCount) {
+            mProcess->mPeakExecutingThreadsCount = mProcess->mExecutingThreadsCount;
+        }
         if (mProcess->mExecutingThreadsCount >= mProcess->mMaxThreads &&
                 mProcess->mStarvationStartTimeMs == 0) {
             mProcess->mStarvationStartTimeMs = uptimeMillis();
+            mProcess->mStarvationCount++;
         }
         pthread_mutex_unlock(&mProcess->mThreadCountLock);
 
@@ -453,6 +463,10 @@ status_t IPCThreadState::getAndExecuteCommand()
         if (mProcess->mExecutingThreadsCount < mProcess->mMaxThreads &&
                 mProcess->mStarvationStartTimeMs != 0) {
             int64_t starvationTimeMs = uptimeMillis() - mProcess->mStarvationStartTimeMs;
+            mProcess->mTotalStarvationTimeMs += starvationTimeMs;
+            if (starvationTimeMs > mProcess->mMaxStarvationTimeMs) {
+                mProcess->mMaxStarvationTimeMs = starvationTimeMs;
+            }
             if (starvationTimeMs > 100) {
                 ALOGE("binder thread pool (%zu threads) starved for %" PRId64 " ms",
                       mProcess->mMaxThreads, starvationTimeMs);
@@ -496,8 +510,14 @@ void IPCThreadState::joinThreadPool(bool isMain)
 
     mOut.writeInt32(isMain ? BC_ENTER_LOOPER : BC_REGISTER_LOOPER);
 
+    pthread_mutex_lock(&mProcess->mThreadCountLock);
+    mProcess->mPooledThreadsCount++;
+    pthread_mutex_unlock(&mProcess->mThreadCountLock);
+
     status_t result;
     do {
+        // don't hold on to oneway transactions queued by the last command
+        flushOnewayTransactions();
         processPendingDerefs();
         // now get the next command to be processed, waiting if necessary
         result = getAndExecuteCommand();
@@ -518,6 +538,10 @@ void IPCThreadState::joinThreadPool(bool isMain)
     LOG_THREADPOOL("**** THREAD %p (PID %d) IS LEAVING THE THREAD POOL err=%d\n",
         (void*)pthread_self(), getpid(), result);
 
+    pthread_mutex_lock(&mProcess->mThreadCountLock);
+    mProcess->mPooledThreadsCount--;
+    pthread_mutex_unlock(&mProcess->mThreadCountLock);
+
     mOut.writeInt32(BC_EXIT_LOOPER);
     talkWithDriver(false);
 }
@@ -560,8 +584,16 @@ status_t IPCThreadState::transact(int32_t handle,
                                   uint32_t code, const Parcel& data,
                                   Parcel* reply, uint32_t flags)
 {
+    if (!mQueuedTransactions.isEmpty()) {
+        // queued oneway transactions go first, to keep them in order
+        flushOnewayTransactions();
+    }
+
     status_t err = data.errorCheck();
 
+    TransactionStats& stats = TransactionStats::self();
+    const nsecs_t startTime = stats.isEnabled() ? systemTime(SYSTEM_TIME_MONOTONIC) : 0;
+
     flags |= TF_ACCEPT_FDS;
 
     IF_LOG_TRANSACTIONS() {
@@ -615,9 +647,96 @@ status_t IPCThreadState::transact(int32_t handle,
         err = waitForResponse(NULL, NULL);
     }
 
+    if (startTime != 0) {
+        stats.recordOutgoing(handle, code, data,
+                data.dataSize() + (reply ? reply->dataSize() : 0), err,
+                systemTime(SYSTEM_TIME_MONOTONIC) - startTime);
+    }
+
     return err;
 }
 
+status_t IPCThreadState::queueOnewayTransaction(int32_t handle,
+                                                uint32_t code, const Parcel& data)
+{
+    status_t err = data.errorCheck();
+    if (err != NO_ERROR) {
+        return (mLastError = err);
+    }
+
+    // The parcel's data has to stay around until the transaction is written
+    // to the driver, so the queue keeps its own copy.
+    Parcel* copy = new Parcel;
+    err = copy->appendFrom(&data, 0, data.dataSize());
+    if (err != NO_ERROR) {
+        delete copy;
+        return (mLastError = err);
+    }
+
+    QueuedTransaction transaction = { handle, code, copy };
+    mQueuedTransactions.push(transaction);
+    if (mQueuedTransactions.size() >= MAX_QUEUED_ONEWAY_TRANSACTIONS) {
+        return flushOnewayTransactions();
+    }
+    return NO_ERROR;
+}
+
+status_t IPCThreadState::flushOnewayTransactions()
+{
+    if (mQueuedTransactions.isEmpty()) {
+        return NO_ERROR;
+    }
+
+    // Incoming transactions that run while we wait for the driver may queue
+    // new ones; those go with the next flush.
+    const Vector<QueuedTransaction> queued(mQueuedTransactions);
+    mQueuedTransactions.clear();
+
+    status_t result = NO_ERROR;
+    size_t written = 0;
+    for (size_t i = 0; i < queued.size(); i++) {
+        const QueuedTransaction& t = queued[i];
+        IF_LOG_TRANSACTIONS() {
+            TextOutput::Bundle _b(alog);
+            alog << "BC_TRANSACTION (queued) thr " << (void*)pthread_self() << " / hand "
+                << t.handle << " / code " << TypeCode(t.code) << ": "
+                << indent << *t.data << dedent << endl;
+        }
+        status_t err = writeTransactionData(BC_TRANSACTION, TF_ONE_WAY | TF_ACCEPT_FDS,
+                t.handle, t.code, *t.data, NULL);
+        if (err == NO_ERROR) {
+            written++;
+        } else if (result == NO_ERROR) {
+            result = err;
+        }
+    }
+
+    // The first talkWithDriver() writes all the transactions; the driver then
+    // answers each of them with either BR_TRANSACTION_COMPLETE or an error.
+    for (size_t i = 0; i < written; i++) {
+        status_t err = waitForResponse(NULL, NULL);
+        if (err == NO_ERROR) {
+            continue;
+        }
+        if (result == NO_ERROR) {
+            result = err;
+        }
+        if (err != DEAD_OBJECT && err != FAILED_TRANSACTION) {
+            // The driver itself failed, so the rest of the transactions may
+            // never be written; they point into the parcels freed below.
+            mOut.setDataSize(0);
+            break;
+        }
+    }
+    ALOGW_IF(result != NO_ERROR, "Flushing %zu oneway transactions failed: %d",
+            queued.size(), result);
+
+    for (size_t i = 0; i < queued.size(); i++) {
+        delete queued[i].data;
+    }
+    return result;
+}
+
 void IPCThreadState::incStrongHandle(int32_t handle)
 {
     LOG_REMOTEREFS("IPCThreadState::incStrongHandle(%d)\n", handle);
@@ -707,12 +826,18 @@ IPCThreadState::IPCThreadState()
 
 IPCThreadState::~IPCThreadState()
 {
+    ALOGW_IF(!mQueuedTransactions.isEmpty(),
+            "Dropping %zu queued oneway transactions", mQueuedTransactions.size());
+    for (size_t i = 0; i < mQueuedTransactions.size(); i++) {
+        delete mQueuedTransactions[i].data;
+    }
 }
 
 status_t IPCThreadState::sendReply(const Parcel& reply, uint32_t flags)
 {
     status_t err;
     status_t statusBuffer;
+    flushOnewayTransactions();
     err = writeTransactionData(BC_REPLY, flags, -1, 0, reply, &statusBuffer);
     if (err < NO_ERROR) return err;
 
@@ -886,10 +1011,18 @@ status_t IPCThreadState::talkWithDriver(bool doReceive)
 
     if (err >= NO_ERROR) {
         if (bwr.write_consumed > 0) {
-            if (bwr.write_consumed < mOut.dataSize())
-                mOut.remove(0, bwr.write_consumed);
-            else
+            if (bwr.write_consumed < mOut.dataSize()) {
+                // The driver stops consuming commands after a transaction
+                // that fails, e.g. within a flush of queued oneway
+                // transactions. Keep the rest for the next write.
+                Parcel remaining;
+                remaining.write(mOut.data() + bwr.write_consumed,
+                        mOut.dataSize() - bwr.write_consumed);
+                mOut.setDataSize(0);
+                mOut.write(remaining.data(), remaining.dataSize());
+            } else {
                 mOut.setDataSize(0);
+            }
         }
         if (bwr.read_consumed > 0) {
             mIn.setDataSize(bwr.read_consumed);
@@ -1061,6 +1194,9 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
 
             Parcel reply;
             status_t error;
+            TransactionStats& stats = TransactionStats::self();
+            const nsecs_t startTime = stats.isEnabled() ?
+                    systemTime(SYSTEM_TIME_MONOTONIC) : 0;
             IF_LOG_TRANSACTIONS() {
                 TextOutput::Bundle _b(alog);
                 alog << "BR_TRANSACTION thr " << (void*)pthread_self()
@@ -1077,15 +1213,25 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
                 // safely acquire a strong reference before doing anything else with it.
                 if (reinterpret_cast<RefBase::weakref_type*>(
                         tr.target.ptr)->attemptIncStrong(this)) {
-                    error = reinterpret_cast<BBinder*>(tr.cookie)->transact(tr.code, buffer,
-                            &reply, tr.flags);
-                    reinterpret_cast<BBinder*>(tr.cookie)->decStrong(this);
+                    BBinder* const target = reinterpret_cast<BBinder*>(tr.cookie);
+                    error = target->transact(tr.code, buffer, &reply, tr.flags);
+                    if (startTime != 0) {
+                        stats.recordIncoming(target->getInterfaceDescriptor(), tr.code,
+                                buffer.dataSize() + reply.dataSize(), error,
+                                systemTime(SYSTEM_TIME_MONOTONIC) - startTime);
+                    }
+                    target->decStrong(this);
                 } else {
                     error = UNKNOWN_TRANSACTION;
                 }
 
             } else {
                 error = the_context_object->transact(tr.code, buffer, &reply, tr.flags);
+                if (startTime != 0) {
+                    stats.recordIncoming(the_context_object->getInterfaceDescriptor(),
+                            tr.code, buffer.dataSize() + reply.dataSize(), error,
+                            systemTime(SYSTEM_TIME_MONOTONIC) - startTime);
+                }
             }
 
             //ALOGI("<<<< TRANSACT from pid %d restore pid %d uid %d\n",
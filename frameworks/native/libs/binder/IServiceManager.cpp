@@ -29,8 +29,26 @@
 
 #include <unistd.h>
 
+#include <algorithm>
+
 namespace android {
 
+// Services that are looked up before they are registered are polled with a
+// delay that starts short and backs off, so that a service registering a few
+// milliseconds after its client doesn't cost the client a whole second.
+static const useconds_t kInitialRetryDelayUs = 5000;
+static const useconds_t kMaxServiceRetryDelayUs = 100000;
+static const useconds_t kMaxPermissionRetryDelayUs = 1000000;
+// How long getService() waits for a service that isn't registered yet
+static const int64_t kGetServiceTimeoutMs = 4000;
+
+static useconds_t retryDelay(useconds_t* delayUs, useconds_t maxDelayUs)
+{
+    const useconds_t current = *delayUs;
+    *delayUs = std::min(current * 2, maxDelayUs);
+    return current;
+}
+
 sp<IServiceManager> defaultServiceManager()
 {
     if (gDefaultServiceManager != NULL) return gDefaultServiceManager;
@@ -74,14 +92,15 @@ bool checkPermission(const String16& permission, pid_t pid, uid_t uid)
     gDefaultServiceManagerLock.unlock();
 
     int64_t startTime = 0;
+    useconds_t delayUs = kInitialRetryDelayUs;
 
     while (true) {
         if (pc != NULL) {
             bool res = pc->checkPermission(permission, pid, uid);
             if (res) {
                 if (startTime != 0) {
-                    ALOGI("Check passed after %d seconds for %s from uid=%d pid=%d",
-                            (int)((uptimeMillis()-startTime)/1000),
+                    ALOGI("Check passed after %d ms for %s from uid=%d pid=%d",
+                            (int)(uptimeMillis()-startTime),
                             String8(permission).string(), uid, pid);
                 }
                 return res;
@@ -111,7 +130,7 @@ bool checkPermission(const String16& permission, pid_t pid, uid_t uid)
                 ALOGI("Waiting to check permission %s from uid=%d pid=%d",
                         String8(permission).string(), uid, pid);
             }
-            sleep(1);
+            usleep(retryDelay(&delayUs, kMaxPermissionRetryDelayUs));
         } else {
             pc = interface_cast<IPermissionController>(binder);
             // Install the new permission controller, and try again.
@@ -134,19 +153,26 @@ public:
 
     virtual sp<IBinder> getService(const String16& name) const
     {
-        unsigned n;
-        for (n = 0; n < 5; n++){
-            if (n > 0) {
-                if (!strcmp(ProcessState::self()->getDriverName().c_str(), "/dev/vndbinder")) {
-                    ALOGI("Waiting for vendor service %s...", String8(name).string());
-                    CallStack stack(LOG_TAG);
-                } else {
-                    ALOGI("Waiting for service %s...", String8(name).string());
-                }
-                sleep(1);
+        sp<IBinder> svc = checkService(name);
+        if (svc != NULL) return svc;
+
+        if (!strcmp(ProcessState::self()->getDriverName().c_str(), "/dev/vndbinder")) {
+            ALOGI("Waiting for vendor service %s...", String8(name).string());
+            CallStack stack(LOG_TAG);
+        } else {
+            ALOGI("Waiting for service %s...", String8(name).string());
+        }
+
+        const int64_t startTime = uptimeMillis();
+        useconds_t delayUs = kInitialRetryDelayUs;
+        while (uptimeMillis() - startTime < kGetServiceTimeoutMs) {
+            usleep(retryDelay(&delayUs, kMaxServiceRetryDelayUs));
+            svc = checkService(name);
+            if (svc != NULL) {
+                ALOGI("Service %s available after %d ms", String8(name).string(),
+                        (int)(uptimeMillis() - startTime));
+                return svc;
             }
-            sp<IBinder> svc = checkService(name);
-            if (svc != NULL) return svc;
         }
         return NULL;
     }
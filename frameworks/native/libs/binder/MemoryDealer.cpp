@@ -25,6 +25,7 @@
 #include <utils/String8.h>
 #include <utils/threads.h>
 
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -38,6 +39,9 @@
 #include <sys/mman.h>
 #include <sys/file.h>
 
+#include <unordered_map>
+#include <vector>
+
 namespace android {
 // ----------------------------------------------------------------------------
 
@@ -131,6 +135,8 @@ public:
 
     size_t      allocate(size_t size, uint32_t flags = 0);
     status_t    deallocate(size_t offset);
+    // Frees several blocks with a single acquisition of the lock
+    void        deallocate(const std::vector<size_t>& offsets);
     size_t      size() const;
     void        dump(const char* what) const;
     void        dump(String8& res, const char* what) const;
@@ -163,6 +169,44 @@ private:
 
 // ----------------------------------------------------------------------------
 
+// Sits in front of a SimpleBestFitAllocator and keeps freed blocks on a free
+// list per (aligned) size. Allocations of a size found there take constant time,
+// and deallocations take constant time; only sizes that aren't cached go to
+// the best-fit allocator. Sizes are not rounded up to classes, so a heap sized
+// for N buffers of one size still holds N of them.
+class SizeClassCache
+{
+public:
+    explicit SizeClassCache(SimpleBestFitAllocator* allocator);
+
+    ssize_t     allocate(size_t size);
+    void        deallocate(size_t offset);
+    void        dump(String8& result) const;
+
+private:
+    // Sizes with a free list, beyond which blocks go straight back
+    static const size_t kMaxSizeClasses = 16;
+
+    struct SizeClass {
+        std::vector<size_t> free;
+        uint64_t hits;
+        uint64_t misses;
+    };
+
+    void        releaseCachedLocked();
+
+    SimpleBestFitAllocator* const mAllocator;
+    mutable Mutex mLock;
+    // aligned size -> its free list
+    std::unordered_map<size_t, SizeClass> mClasses;
+    // offset -> aligned size of each allocation handed out
+    std::unordered_map<size_t, size_t> mAllocated;
+    size_t mCachedBytes;
+    uint64_t mReleases;
+};
+
+// ----------------------------------------------------------------------------
+
 Allocation::Allocation(
         const sp<MemoryDealer>& dealer,
         const sp<IMemoryHeap>& heap, ssize_t offset, size_t size)
@@ -229,19 +273,30 @@ Allocation::~Allocation()
 
 MemoryDealer::MemoryDealer(size_t size, const char* name, uint32_t flags)
     : mHeap(new MemoryHeapBase(size, flags, name)),
-    mAllocator(new SimpleBestFitAllocator(size))
+    mAllocator(new SimpleBestFitAllocator(size)),
+    mSizeClasses(NULL)
 {    
 }
 
+MemoryDealer::MemoryDealer(size_t size, const char* name, uint32_t flags,
+        AllocatorPolicy policy)
+    : mHeap(new MemoryHeapBase(size, flags, name)),
+    mAllocator(new SimpleBestFitAllocator(size)),
+    mSizeClasses(policy == SIZE_CLASSES ? new SizeClassCache(mAllocator) : NULL)
+{
+}
+
 MemoryDealer::~MemoryDealer()
 {
+    delete mSizeClasses;
     delete mAllocator;
 }
 
 sp<IMemory> MemoryDealer::allocate(size_t size)
 {
     sp<IMemory> memory;
-    const ssize_t offset = allocator()->allocate(size);
+    const ssize_t offset = mSizeClasses ? mSizeClasses->allocate(size) :
+            ssize_t(allocator()->allocate(size));
     if (offset >= 0) {
         memory = new Allocation(this, heap(), offset, size);
     }
@@ -250,12 +305,21 @@ sp<IMemory> MemoryDealer::allocate(size_t size)
 
 void MemoryDealer::deallocate(size_t offset)
 {
-    allocator()->deallocate(offset);
+    if (mSizeClasses) {
+        mSizeClasses->deallocate(offset);
+    } else {
+        allocator()->deallocate(offset);
+    }
 }
 
 void MemoryDealer::dump(const char* what) const
 {
     allocator()->dump(what);
+    if (mSizeClasses) {
+        String8 result;
+        mSizeClasses->dump(result);
+        ALOGD("%s", result.string());
+    }
 }
 
 const sp<IMemoryHeap>& MemoryDealer::heap() const {
@@ -315,6 +379,14 @@ status_t SimpleBestFitAllocator::deallocate(size_t offset)
     return NAME_NOT_FOUND;
 }
 
+void SimpleBestFitAllocator::deallocate(const std::vector<size_t>& offsets)
+{
+    Mutex::Autolock _l(mLock);
+    for (size_t offset : offsets) {
+        dealloc(offset);
+    }
+}
+
 ssize_t SimpleBestFitAllocator::alloc(size_t size, uint32_t flags)
 {
     if (size == 0) {
@@ -437,6 +509,9 @@ void SimpleBestFitAllocator::dump_l(String8& result,
         const char* what) const
 {
     size_t size = 0;
+    size_t freeSize = 0;
+    size_t freeChunks = 0;
+    size_t largestFree = 0;
     int32_t i = 0;
     chunk_t const* cur = mList.head();
     
@@ -461,8 +536,14 @@ void SimpleBestFitAllocator::dump_l(String8& result,
         
         result.append(buffer);
 
-        if (!cur->free)
+        if (!cur->free) {
             size += cur->size*kMemoryAlign;
+        } else {
+            freeSize += cur->size*kMemoryAlign;
+            freeChunks++;
+            if (cur->size*kMemoryAlign > largestFree)
+                largestFree = cur->size*kMemoryAlign;
+        }
 
         i++;
         cur = cur->next;
@@ -470,6 +551,102 @@ void SimpleBestFitAllocator::dump_l(String8& result,
     snprintf(buffer, SIZE,
             "  size allocated: %u (%u KB)\n", int(size), int(size/1024));
     result.append(buffer);
+    // The share of the free memory that isn't usable for the largest request
+    snprintf(buffer, SIZE,
+            "  free: %u KB in %zu blocks, largest %u KB, fragmentation %u%%\n",
+            int(freeSize/1024), freeChunks, int(largestFree/1024),
+            freeSize ? unsigned(100 - largestFree*100/freeSize) : 0u);
+    result.append(buffer);
+}
+
+// ----------------------------------------------------------------------------
+
+SizeClassCache::SizeClassCache(SimpleBestFitAllocator* allocator)
+    : mAllocator(allocator), mCachedBytes(0), mReleases(0)
+{
+}
+
+ssize_t SizeClassCache::allocate(size_t size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    const size_t align = SimpleBestFitAllocator::getAllocationAlignment();
+    const size_t alignedSize = (size + align - 1) & ~(align - 1);
+
+    Mutex::Autolock _l(mLock);
+    auto sizeClass = mClasses.find(alignedSize);
+    if (sizeClass == mClasses.end() && mClasses.size() < kMaxSizeClasses) {
+        sizeClass = mClasses.emplace(alignedSize, SizeClass()).first;
+    }
+    if (sizeClass != mClasses.end()) {
+        SizeClass& c = sizeClass->second;
+        if (!c.free.empty()) {
+            const size_t offset = c.free.back();
+            c.free.pop_back();
+            c.hits++;
+            mCachedBytes -= alignedSize;
+            mAllocated[offset] = alignedSize;
+            return offset;
+        }
+        c.misses++;
+    }
+
+    ssize_t offset = mAllocator->allocate(alignedSize);
+    if (offset < 0 && mCachedBytes > 0) {
+        // The cached blocks may be what stands in the way
+        releaseCachedLocked();
+        offset = mAllocator->allocate(alignedSize);
+    }
+    if (offset >= 0) {
+        mAllocated[offset] = alignedSize;
+    }
+    return offset;
+}
+
+void SizeClassCache::deallocate(size_t offset)
+{
+    Mutex::Autolock _l(mLock);
+    auto allocated = mAllocated.find(offset);
+    if (allocated == mAllocated.end()) {
+        mAllocator->deallocate(offset);
+        return;
+    }
+    const size_t alignedSize = allocated->second;
+    mAllocated.erase(allocated);
+
+    auto sizeClass = mClasses.find(alignedSize);
+    if (sizeClass == mClasses.end()) {
+        mAllocator->deallocate(offset);
+        return;
+    }
+    sizeClass->second.free.push_back(offset);
+    mCachedBytes += alignedSize;
+}
+
+void SizeClassCache::releaseCachedLocked()
+{
+    std::vector<size_t> offsets;
+    for (auto& sizeClass : mClasses) {
+        offsets.insert(offsets.end(), sizeClass.second.free.begin(),
+                sizeClass.second.free.end());
+        sizeClass.second.free.clear();
+    }
+    mAllocator->deallocate(offsets);
+    mCachedBytes = 0;
+    mReleases++;
+}
+
+void SizeClassCache::dump(String8& result) const
+{
+    Mutex::Autolock _l(mLock);
+    result.appendFormat("  size classes: %zu, cached %zu KB, released %" PRIu64 " times\n",
+            mClasses.size(), mCachedBytes / 1024, mReleases);
+    for (const auto& sizeClass : mClasses) {
+        const SizeClass& c = sizeClass.second;
+        result.appendFormat("    %8zu bytes: %zu free, %" PRIu64 " hits, %" PRIu64 " misses\n",
+                sizeClass.first, c.free.size(), c.hits, c.misses);
+    }
 }
 
 
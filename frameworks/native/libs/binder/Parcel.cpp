@@ -30,6 +30,8 @@
 #include <sys/resource.h>
 #include <unistd.h>
 
+#include <new>
+
 #include <binder/Binder.h>
 #include <binder/BpBinder.h>
 #include <binder/IPCThreadState.h>
@@ -92,6 +94,86 @@ static size_t gParcelGlobalAllocCount = 0;
 
 static size_t gMaxFds = 0;
 
+// Most transactions carry less than PARCEL_POOLED_BUFFER_SIZE bytes. Parcels
+// that small get a buffer of exactly that size, taken from a per-thread cache
+// of buffers that earlier parcels on the thread released, so that a thread
+// doing transactions in a loop doesn't go to malloc for each one. Pooled
+// buffers are ordinary malloc() buffers and can be realloc()ed or free()d.
+static const size_t PARCEL_POOLED_BUFFER_SIZE = 256;
+static const size_t PARCEL_MAX_POOLED_BUFFERS = 8;
+
+struct ParcelBufferPool {
+    void* buffers[PARCEL_MAX_POOLED_BUFFERS];
+    size_t count;
+};
+
+static pthread_once_t gParcelBufferPoolKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t gParcelBufferPoolKey;
+static bool gParcelBufferPoolKeyValid = false;
+
+static void destroyParcelBufferPool(void* value)
+{
+    ParcelBufferPool* pool = static_cast<ParcelBufferPool*>(value);
+    while (pool->count > 0) {
+        free(pool->buffers[--pool->count]);
+    }
+    delete pool;
+}
+
+static void createParcelBufferPoolKey()
+{
+    gParcelBufferPoolKeyValid =
+            pthread_key_create(&gParcelBufferPoolKey, destroyParcelBufferPool) == 0;
+    ALOGW_IF(!gParcelBufferPoolKeyValid, "Unable to create the parcel buffer pool key");
+}
+
+static ParcelBufferPool* getParcelBufferPool(bool create)
+{
+    pthread_once(&gParcelBufferPoolKeyOnce, createParcelBufferPoolKey);
+    if (!gParcelBufferPoolKeyValid) {
+        return NULL;
+    }
+    ParcelBufferPool* pool =
+            static_cast<ParcelBufferPool*>(pthread_getspecific(gParcelBufferPoolKey));
+    if (pool == NULL && create) {
+        // Parcels freed by other thread-specific destructors while the thread
+        // exits may create a new pool; it is destroyed in the next round of
+        // destructor calls.
+        pool = new (std::nothrow) ParcelBufferPool();
+        if (pool != NULL && pthread_setspecific(gParcelBufferPoolKey, pool) != 0) {
+            delete pool;
+            pool = NULL;
+        }
+    }
+    return pool;
+}
+
+// Allocates a buffer of at least *capacity bytes, and updates *capacity to
+// the size of the buffer.
+static uint8_t* allocParcelBuffer(size_t* capacity)
+{
+    if (*capacity > PARCEL_POOLED_BUFFER_SIZE) {
+        return static_cast<uint8_t*>(malloc(*capacity));
+    }
+    *capacity = PARCEL_POOLED_BUFFER_SIZE;
+    ParcelBufferPool* pool = getParcelBufferPool(false);
+    if (pool != NULL && pool->count > 0) {
+        return static_cast<uint8_t*>(pool->buffers[--pool->count]);
+    }
+    return static_cast<uint8_t*>(malloc(PARCEL_POOLED_BUFFER_SIZE));
+}
+
+static void freeParcelBuffer(uint8_t* data, size_t capacity)
+{
+    ParcelBufferPool* pool = capacity == PARCEL_POOLED_BUFFER_SIZE ?
+            getParcelBufferPool(true) : NULL;
+    if (pool == NULL || pool->count >= PARCEL_MAX_POOLED_BUFFERS) {
+        free(data);
+        return;
+    }
+    pool->buffers[pool->count++] = data;
+}
+
 // Maximum size of a blob to transfer in-place.
 static const size_t BLOB_INPLACE_LIMIT = 16 * 1024;
 
@@ -1255,6 +1337,34 @@ status_t Parcel::writeDupImmutableBlobFileDescriptor(int fd)
     return writeDupFileDescriptor(fd);
 }
 
+status_t Parcel::writeByteArrayBlob(size_t len, const uint8_t* val)
+{
+    if (len > INT32_MAX) {
+        // don't accept size_t values which may have come from an
+        // inadvertent conversion from a negative int.
+        return BAD_VALUE;
+    }
+    if (!val && len > 0) return BAD_VALUE;
+
+    status_t status = writeInt32(static_cast<int32_t>(len));
+    if (status) return status;
+
+    WritableBlob blob;
+    status = writeBlob(len, false, &blob);
+    if (status) return status;
+
+    if (len > 0) {
+        memcpy(blob.data(), val, len);
+    }
+    blob.release();
+    return NO_ERROR;
+}
+
+status_t Parcel::writeByteVectorBlob(const std::vector<uint8_t>& val)
+{
+    return writeByteArrayBlob(val.size(), val.data());
+}
+
 status_t Parcel::write(const FlattenableHelperInterface& val)
 {
     status_t err;
@@ -2204,6 +2314,31 @@ status_t Parcel::readBlob(size_t len, ReadableBlob* outBlob) const
     return NO_ERROR;
 }
 
+status_t Parcel::readByteVectorBlob(std::vector<uint8_t>* val) const
+{
+    val->clear();
+
+    int32_t size;
+    status_t status = readInt32(&size);
+    if (status) return status;
+    if (size < 0) return BAD_VALUE;
+
+    ReadableBlob blob;
+    status = readBlob(size, &blob);
+    if (status) return status;
+
+    // A region smaller than the advertised size would fault on access
+    if (blob.fd() >= 0 && ashmem_get_size_region(blob.fd()) < size) {
+        blob.release();
+        return BAD_VALUE;
+    }
+
+    const uint8_t* data = static_cast<const uint8_t*>(blob.data());
+    val->assign(data, data + size);
+    blob.release();
+    return NO_ERROR;
+}
+
 status_t Parcel::read(FlattenableHelperInterface& val) const
 {
     // size
@@ -2462,7 +2597,7 @@ void Parcel::freeDataNoInit()
               gParcelGlobalAllocCount--;
             }
             pthread_mutex_unlock(&gParcelGlobalAllocSizeLock);
-            free(mData);
+            freeParcelBuffer(mData, mDataCapacity);
         }
         if (mObjects) free(mObjects);
     }
@@ -2563,7 +2698,8 @@ status_t Parcel::continueWrite(size_t desired)
 
         // If there is a different owner, we need to take
         // posession.
-        uint8_t* data = (uint8_t*)malloc(desired);
+        size_t capacity = desired;
+        uint8_t* data = allocParcelBuffer(&capacity);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
@@ -2597,9 +2733,9 @@ status_t Parcel::continueWrite(size_t desired)
         mOwner(this, mData, mDataSize, mObjects, mObjectsSize, mOwnerCookie);
         mOwner = NULL;
 
-        LOG_ALLOC("Parcel %p: taking ownership of %zu capacity", this, desired);
+        LOG_ALLOC("Parcel %p: taking ownership of %zu capacity", this, capacity);
         pthread_mutex_lock(&gParcelGlobalAllocSizeLock);
-        gParcelGlobalAllocSize += desired;
+        gParcelGlobalAllocSize += capacity;
         gParcelGlobalAllocCount++;
         pthread_mutex_unlock(&gParcelGlobalAllocSizeLock);
 
@@ -2607,7 +2743,7 @@ status_t Parcel::continueWrite(size_t desired)
         mObjects = objects;
         mDataSize = (mDataSize < desired) ? mDataSize : desired;
         ALOGV("continueWrite Setting data size of %p to %zu", this, mDataSize);
-        mDataCapacity = desired;
+        mDataCapacity = capacity;
         mObjectsSize = mObjectsCapacity = objectsSize;
         mNextObjectHint = 0;
 
@@ -2662,7 +2798,8 @@ status_t Parcel::continueWrite(size_t desired)
 
     } else {
         // This is the first data.  Easy!
-        uint8_t* data = (uint8_t*)malloc(desired);
+        size_t capacity = desired;
+        uint8_t* data = allocParcelBuffer(&capacity);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
@@ -2673,9 +2810,9 @@ status_t Parcel::continueWrite(size_t desired)
             ALOGE("continueWrite: %zu/%p/%zu/%zu", mDataCapacity, mObjects, mObjectsCapacity, desired);
         }
 
-        LOG_ALLOC("Parcel %p: allocating with %zu capacity", this, desired);
+        LOG_ALLOC("Parcel %p: allocating with %zu capacity", this, capacity);
         pthread_mutex_lock(&gParcelGlobalAllocSizeLock);
-        gParcelGlobalAllocSize += desired;
+        gParcelGlobalAllocSize += capacity;
         gParcelGlobalAllocCount++;
         pthread_mutex_unlock(&gParcelGlobalAllocSizeLock);
 
@@ -2683,7 +2820,7 @@ status_t Parcel::continueWrite(size_t desired)
         mDataSize = mDataPos = 0;
         ALOGV("continueWrite Setting data size of %p to %zu", this, mDataSize);
         ALOGV("continueWrite Setting data pos of %p to %zu", this, mDataPos);
-        mDataCapacity = desired;
+        mDataCapacity = capacity;
     }
 
     return NO_ERROR;
@@ -19,6 +19,8 @@
 #include <binder/PersistableBundle.h>
 #include <private/binder/ParcelValTypes.h>
 
+#include <string.h>
+
 #include <limits>
 
 #include <binder/IBinder.h>
@@ -91,6 +93,19 @@ status_t PersistableBundle::writeToParcel(Parcel* parcel) const {
      * frameworks/base/core/java/android/os/BaseBundle.java.
      */
 
+    if (mParcelledValid) {
+        // Also avoids parsing a bundle that is only being passed on.
+        if (mParcelled.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+            ALOGE("Parcel length (%zu) too large to store in 32-bit signed int",
+                  mParcelled.size());
+            return BAD_VALUE;
+        }
+        RETURN_IF_FAILED(parcel->writeInt32(static_cast<int32_t>(mParcelled.size())));
+        RETURN_IF_FAILED(parcel->writeInt32(BUNDLE_MAGIC));
+        RETURN_IF_FAILED(parcel->write(mParcelled.data(), mParcelled.size()));
+        return NO_ERROR;
+    }
+
     // Special case for empty bundles.
     if (empty()) {
         RETURN_IF_FAILED(parcel->writeInt32(0));
@@ -114,6 +129,9 @@ status_t PersistableBundle::writeToParcel(Parcel* parcel) const {
     }
     RETURN_IF_FAILED(parcel->writeInt32(static_cast<int32_t>(length)));
     parcel->setDataPosition(end_pos);
+
+    mParcelled.assign(parcel->data() + start_pos, parcel->data() + end_pos);
+    mParcelledValid = true;
     return NO_ERROR;
 }
 
@@ -127,8 +145,41 @@ status_t PersistableBundle::readFromParcel(const Parcel* parcel) {
         ALOGE("Bad length in parcel: %d", length);
         return UNEXPECTED_NULL;
     }
+    if (length == 0 || !empty()) {
+        // Entries read into a bundle that already has some are merged with them.
+        return readFromParcelInner(parcel, static_cast<size_t>(length));
+    }
 
-    return readFromParcelInner(parcel, static_cast<size_t>(length));
+    int32_t magic;
+    RETURN_IF_FAILED(parcel->readInt32(&magic));
+    if (magic != BUNDLE_MAGIC) {
+        ALOGE("Bad magic number for PersistableBundle: 0x%08x", magic);
+        return BAD_VALUE;
+    }
+    const uint8_t* entries = static_cast<const uint8_t*>(parcel->readInplace(length));
+    if (entries == nullptr || length < static_cast<int32_t>(sizeof(int32_t))) {
+        ALOGE("Bad length in parcel: %d", length);
+        return BAD_VALUE;
+    }
+    mParcelled.assign(entries, entries + length);
+    mParcelledValid = true;
+    mPendingUnparcel = true;
+    return NO_ERROR;
+}
+
+void PersistableBundle::unparcel() const {
+    if (!mPendingUnparcel) return;
+    mPendingUnparcel = false;
+
+    Parcel parcel;
+    parcel.setData(mParcelled.data(), mParcelled.size());
+    status_t err = const_cast<PersistableBundle*>(this)->readEntries(&parcel);
+    if (err != NO_ERROR) {
+        ALOGE("Failed to unparcel PersistableBundle: %d", err);
+        // Don't pass the malformed entries on either
+        mParcelled.clear();
+        mParcelledValid = false;
+    }
 }
 
 bool PersistableBundle::empty() const {
@@ -136,6 +187,12 @@ bool PersistableBundle::empty() const {
 }
 
 size_t PersistableBundle::size() const {
+    if (mPendingUnparcel) {
+        // The entries start with their count
+        int32_t num_entries;
+        memcpy(&num_entries, mParcelled.data(), sizeof(num_entries));
+        return num_entries > 0 ? static_cast<size_t>(num_entries) : 0u;
+    }
     return (mBoolMap.size() +
             mIntMap.size() +
             mLongMap.size() +
@@ -150,6 +207,11 @@ size_t PersistableBundle::size() const {
 }
 
 size_t PersistableBundle::erase(const String16& key) {
+    // Every setter goes through here
+    unparcel();
+    mParcelled.clear();
+    mParcelledValid = false;
+
     RETURN_IF_ENTRY_ERASED(mBoolMap, key);
     RETURN_IF_ENTRY_ERASED(mIntMap, key);
     RETURN_IF_ENTRY_ERASED(mLongMap, key);
@@ -219,90 +281,112 @@ void PersistableBundle::putPersistableBundle(const String16& key, const Persista
 }
 
 bool PersistableBundle::getBoolean(const String16& key, bool* out) const {
+    unparcel();
     return getValue(key, out, mBoolMap);
 }
 
 bool PersistableBundle::getInt(const String16& key, int32_t* out) const {
+    unparcel();
     return getValue(key, out, mIntMap);
 }
 
 bool PersistableBundle::getLong(const String16& key, int64_t* out) const {
+    unparcel();
     return getValue(key, out, mLongMap);
 }
 
 bool PersistableBundle::getDouble(const String16& key, double* out) const {
+    unparcel();
     return getValue(key, out, mDoubleMap);
 }
 
 bool PersistableBundle::getString(const String16& key, String16* out) const {
+    unparcel();
     return getValue(key, out, mStringMap);
 }
 
 bool PersistableBundle::getBooleanVector(const String16& key, vector<bool>* out) const {
+    unparcel();
     return getValue(key, out, mBoolVectorMap);
 }
 
 bool PersistableBundle::getIntVector(const String16& key, vector<int32_t>* out) const {
+    unparcel();
     return getValue(key, out, mIntVectorMap);
 }
 
 bool PersistableBundle::getLongVector(const String16& key, vector<int64_t>* out) const {
+    unparcel();
     return getValue(key, out, mLongVectorMap);
 }
 
 bool PersistableBundle::getDoubleVector(const String16& key, vector<double>* out) const {
+    unparcel();
     return getValue(key, out, mDoubleVectorMap);
 }
 
 bool PersistableBundle::getStringVector(const String16& key, vector<String16>* out) const {
+    unparcel();
     return getValue(key, out, mStringVectorMap);
 }
 
 bool PersistableBundle::getPersistableBundle(const String16& key, PersistableBundle* out) const {
+    unparcel();
     return getValue(key, out, mPersistableBundleMap);
 }
 
 set<String16> PersistableBundle::getBooleanKeys() const {
+    unparcel();
     return getKeys(mBoolMap);
 }
 
 set<String16> PersistableBundle::getIntKeys() const {
+    unparcel();
     return getKeys(mIntMap);
 }
 
 set<String16> PersistableBundle::getLongKeys() const {
+    unparcel();
     return getKeys(mLongMap);
 }
 
 set<String16> PersistableBundle::getDoubleKeys() const {
+    unparcel();
     return getKeys(mDoubleMap);
 }
 
 set<String16> PersistableBundle::getStringKeys() const {
+    unparcel();
     return getKeys(mStringMap);
 }
 
 set<String16> PersistableBundle::getBooleanVectorKeys() const {
+    unparcel();
     return getKeys(mBoolVectorMap);
 }
 
 set<String16> PersistableBundle::getIntVectorKeys() const {
+    unparcel();
     return getKeys(mIntVectorMap);
 }
 
 set<String16> PersistableBundle::getLongVectorKeys() const {
+    unparcel();
     return getKeys(mLongVectorMap);
 }
 
 set<String16> PersistableBundle::getDoubleVectorKeys() const {
+    unparcel();
     return getKeys(mDoubleVectorMap);
 }
 
 set<String16> PersistableBundle::getStringVectorKeys() const {
+    unparcel();
     return getKeys(mStringVectorMap);
 }
 
 set<String16> PersistableBundle::getPersistableBundleKeys() const {
+    unparcel();
     return getKeys(mPersistableBundleMap);
 }
 
@@ -389,6 +473,9 @@ status_t PersistableBundle::readFromParcelInner(const Parcel* parcel, size_t len
         // Empty PersistableBundle or end of data.
         return NO_ERROR;
     }
+    unparcel();
+    mParcelled.clear();
+    mParcelledValid = false;
 
     int32_t magic;
     RETURN_IF_FAILED(parcel->readInt32(&magic));
@@ -397,6 +484,10 @@ status_t PersistableBundle::readFromParcelInner(const Parcel* parcel, size_t len
         return BAD_VALUE;
     }
 
+    return readEntries(parcel);
+}
+
+status_t PersistableBundle::readEntries(const Parcel* parcel) {
     /*
      * To keep this implementation in sync with unparcel() in
      * frameworks/base/core/java/android/os/BaseBundle.java, the number of
@@ -22,6 +22,7 @@
 #include <binder/BpBinder.h>
 #include <binder/IPCThreadState.h>
 #include <utils/Log.h>
+#include <utils/SystemClock.h>
 #include <utils/String8.h>
 #include <binder/IServiceManager.h>
 #include <utils/String8.h>
@@ -29,9 +30,11 @@
 
 #include <private/binder/binder_module.h>
 #include <private/binder/Static.h>
+#include <private/binder/TransactionStats.h>
 
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -40,6 +43,8 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+
 #define BINDER_VM_SIZE ((1 * 1024 * 1024) - sysconf(_SC_PAGE_SIZE) * 2)
 #define DEFAULT_MAX_BINDER_THREADS 15
 
@@ -154,6 +159,9 @@ void ProcessState::startThreadPool()
     if (!mThreadPoolStarted) {
         mThreadPoolStarted = true;
         spawnPooledThread(true);
+        for (size_t i = 1; i < mMinThreads; i++) {
+            spawnPooledThread(true);
+        }
     }
 }
 
@@ -364,6 +372,41 @@ status_t ProcessState::setThreadPoolMaxThreadCount(size_t maxThreads) {
     return result;
 }
 
+void ProcessState::setThreadPoolMinThreadCount(size_t minThreads) {
+    AutoMutex _l(mLock);
+    if (mThreadPoolStarted) {
+        // The pool already has at least its main thread
+        for (size_t i = std::max(mMinThreads, size_t(1)); i < minThreads; i++) {
+            spawnPooledThread(true);
+        }
+    }
+    mMinThreads = std::max(mMinThreads, minThreads);
+}
+
+void ProcessState::dumpThreadPoolStats(String8& result) {
+    pthread_mutex_lock(&mThreadCountLock);
+    result.appendFormat("Binder thread pool: %zu pooled threads (max %zu spawned, min %zu), "
+            "%zu executing, %zu peak\n", mPooledThreadsCount, mMaxThreads, mMinThreads,
+            mExecutingThreadsCount, mPeakExecutingThreadsCount);
+    int64_t totalStarvationTimeMs = mTotalStarvationTimeMs;
+    if (mStarvationStartTimeMs != 0) {
+        totalStarvationTimeMs += uptimeMillis() - mStarvationStartTimeMs;
+    }
+    result.appendFormat("  commands: %" PRIu64 ", starved: %" PRIu64 " times for %" PRId64
+            " ms total (max %" PRId64 " ms)%s\n", mCommandsCount, mStarvationCount,
+            totalStarvationTimeMs, mMaxStarvationTimeMs,
+            mStarvationStartTimeMs != 0 ? ", starved now" : "");
+    pthread_mutex_unlock(&mThreadCountLock);
+}
+
+void ProcessState::setTransactionStatsEnabled(bool enabled) {
+    TransactionStats::self().setEnabled(enabled);
+}
+
+void ProcessState::dumpTransactionStats(String8& result) {
+    TransactionStats::self().dump(result);
+}
+
 void ProcessState::giveThreadPoolName() {
     androidSetThreadName( makeBinderThreadName().string() );
 }
@@ -409,10 +452,17 @@ ProcessState::ProcessState(const char *driver)
     , mExecutingThreadsCount(0)
     , mMaxThreads(DEFAULT_MAX_BINDER_THREADS)
     , mStarvationStartTimeMs(0)
+    , mPooledThreadsCount(0)
+    , mPeakExecutingThreadsCount(0)
+    , mCommandsCount(0)
+    , mStarvationCount(0)
+    , mTotalStarvationTimeMs(0)
+    , mMaxStarvationTimeMs(0)
     , mManagesContexts(false)
     , mBinderContextCheckFunc(NULL)
     , mBinderContextUserData(NULL)
     , mThreadPoolStarted(false)
+    , mMinThreads(1)
     , mThreadPoolSeq(1)
 {
     if (mDriverFD >= 0) {
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "TransactionStats"
+
+#include <private/binder/TransactionStats.h>
+
+#include <binder/IBinder.h>
+#include <binder/Parcel.h>
+
+#include <inttypes.h>
+#include <string.h>
+
+namespace android {
+
+// ---------------------------------------------------------------------------
+
+static size_t latencyBucket(uint64_t latencyUs)
+{
+    size_t bucket = 0;
+    while (latencyUs != 0 && bucket < TransactionStats::kLatencyBuckets - 1) {
+        latencyUs >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// The upper bound in microseconds of the bucket holding the given percentile
+static uint64_t latencyPercentile(const TransactionStats::Entry& entry, uint32_t percent)
+{
+    const uint64_t target = (entry.count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < TransactionStats::kLatencyBuckets - 1; i++) {
+        seen += entry.histogram[i];
+        if (seen >= target) {
+            return uint64_t(1) << i;
+        }
+    }
+    return entry.maxLatencyUs;
+}
+
+// The interface token written by Parcel::writeInterfaceToken(): the strict
+// mode policy followed by the descriptor as a String16.
+static String16 readInterfaceToken(const Parcel& data)
+{
+    const size_t size = data.dataSize();
+    if (size < 2 * sizeof(int32_t)) {
+        return String16();
+    }
+    int32_t len;
+    memcpy(&len, data.data() + sizeof(int32_t), sizeof(len));
+    if (len <= 0 || size_t(len) >= (size - 2 * sizeof(int32_t)) / sizeof(char16_t)) {
+        return String16();
+    }
+    return String16(reinterpret_cast<const char16_t*>(data.data() + 2 * sizeof(int32_t)),
+            size_t(len));
+}
+
+static void record(TransactionStats::Entry& entry, size_t bytes, status_t error,
+        nsecs_t latency)
+{
+    const uint64_t latencyUs = uint64_t(ns2us(latency));
+    entry.count++;
+    if (error != NO_ERROR) {
+        entry.errors++;
+    }
+    entry.totalBytes += bytes;
+    if (bytes > entry.maxBytes) {
+        entry.maxBytes = bytes;
+    }
+    entry.totalLatencyUs += latencyUs;
+    if (latencyUs > entry.maxLatencyUs) {
+        entry.maxLatencyUs = latencyUs;
+    }
+    entry.histogram[latencyBucket(latencyUs)]++;
+}
+
+// ---------------------------------------------------------------------------
+
+TransactionStats::Entry::Entry()
+    : count(0), errors(0), totalBytes(0), maxBytes(0), totalLatencyUs(0), maxLatencyUs(0)
+{
+    memset(histogram, 0, sizeof(histogram));
+}
+
+void TransactionStats::Entry::merge(const Entry& other)
+{
+    count += other.count;
+    errors += other.errors;
+    totalBytes += other.totalBytes;
+    if (other.maxBytes > maxBytes) {
+        maxBytes = other.maxBytes;
+    }
+    totalLatencyUs += other.totalLatencyUs;
+    if (other.maxLatencyUs > maxLatencyUs) {
+        maxLatencyUs = other.maxLatencyUs;
+    }
+    for (size_t i = 0; i < kLatencyBuckets; i++) {
+        histogram[i] += other.histogram[i];
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+static pthread_once_t gTransactionStatsOnce = PTHREAD_ONCE_INIT;
+static TransactionStats* gTransactionStats = NULL;
+
+TransactionStats& TransactionStats::self()
+{
+    // Never destroyed, since binder threads can outlive static destructors
+    pthread_once(&gTransactionStatsOnce, [] { gTransactionStats = new TransactionStats(); });
+    return *gTransactionStats;
+}
+
+TransactionStats::TransactionStats()
+    : mEnabled(false)
+{
+    pthread_key_create(&mThreadKey, threadDestructor);
+}
+
+void TransactionStats::setEnabled(bool enabled)
+{
+    Mutex::Autolock _l(mLock);
+    if (enabled && !isEnabled()) {
+        for (size_t i = 0; i < mThreads.size(); i++) {
+            Mutex::Autolock _tl(mThreads[i]->lock);
+            mThreads[i]->outgoing.clear();
+            mThreads[i]->incoming.clear();
+        }
+        mRetiredOutgoing.clear();
+        mRetiredIncoming.clear();
+    }
+    mEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void TransactionStats::recordOutgoing(int32_t handle, uint32_t code, const Parcel& data,
+        size_t bytes, status_t error, nsecs_t latency)
+{
+    ThreadStats* stats = threadStats();
+    Mutex::Autolock _l(stats->lock);
+    const auto key = std::make_pair(handle, code);
+    auto entry = stats->outgoing.find(key);
+    if (entry == stats->outgoing.end()) {
+        entry = stats->outgoing.emplace(key, Entry()).first;
+        if (code >= IBinder::FIRST_CALL_TRANSACTION && code <= IBinder::LAST_CALL_TRANSACTION) {
+            entry->second.descriptor = readInterfaceToken(data);
+        }
+        if (entry->second.descriptor.size() == 0) {
+            entry->second.descriptor = String16(String8::format("<handle %d>", handle));
+        }
+    }
+    record(entry->second, bytes, error, latency);
+}
+
+void TransactionStats::recordIncoming(const String16& descriptor, uint32_t code,
+        size_t bytes, status_t error, nsecs_t latency)
+{
+    ThreadStats* stats = threadStats();
+    Mutex::Autolock _l(stats->lock);
+    const auto key = std::make_pair(descriptor.string(), code);
+    auto entry = stats->incoming.find(key);
+    if (entry == stats->incoming.end()) {
+        entry = stats->incoming.emplace(key, Entry()).first;
+        entry->second.descriptor = descriptor.size() ? descriptor : String16("<unnamed>");
+    }
+    record(entry->second, bytes, error, latency);
+}
+
+TransactionStats::ThreadStats* TransactionStats::threadStats()
+{
+    ThreadStats* stats = static_cast<ThreadStats*>(pthread_getspecific(mThreadKey));
+    if (stats == NULL) {
+        stats = new ThreadStats();
+        pthread_setspecific(mThreadKey, stats);
+        Mutex::Autolock _l(mLock);
+        mThreads.add(stats);
+    }
+    return stats;
+}
+
+void TransactionStats::threadDestructor(void* st)
+{
+    ThreadStats* const stats = static_cast<ThreadStats*>(st);
+    TransactionStats& self = TransactionStats::self();
+    {
+        Mutex::Autolock _l(self.mLock);
+        for (size_t i = 0; i < self.mThreads.size(); i++) {
+            if (self.mThreads[i] == stats) {
+                self.mThreads.removeAt(i);
+                break;
+            }
+        }
+        if (self.isEnabled()) {
+            Mutex::Autolock _tl(stats->lock);
+            add(self.mRetiredOutgoing, self.mRetiredIncoming, *stats);
+        }
+    }
+    delete stats;
+}
+
+void TransactionStats::dump(String8& result)
+{
+    if (!isEnabled()) {
+        result.append("Binder transaction stats: disabled\n");
+        return;
+    }
+    Totals outgoing;
+    Totals incoming;
+    {
+        Mutex::Autolock _l(mLock);
+        outgoing = mRetiredOutgoing;
+        incoming = mRetiredIncoming;
+        for (size_t i = 0; i < mThreads.size(); i++) {
+            Mutex::Autolock _tl(mThreads[i]->lock);
+            add(outgoing, incoming, *mThreads[i]);
+        }
+    }
+    dumpTotals(result, "outgoing", outgoing);
+    dumpTotals(result, "incoming", incoming);
+}
+
+void TransactionStats::add(Totals& outgoing, Totals& incoming, const ThreadStats& stats)
+{
+    for (const auto& entry : stats.outgoing) {
+        outgoing[std::make_pair(entry.second.descriptor, entry.first.second)]
+                .merge(entry.second);
+    }
+    for (const auto& entry : stats.incoming) {
+        incoming[std::make_pair(entry.second.descriptor, entry.first.second)]
+                .merge(entry.second);
+    }
+}
+
+void TransactionStats::dumpTotals(String8& result, const char* title, const Totals& totals)
+{
+    result.appendFormat("Binder %s transactions: %zu interface/code pairs\n", title,
+            totals.size());
+    for (const auto& total : totals) {
+        const Entry& e = total.second;
+        if (e.count == 0) {
+            continue;
+        }
+        result.appendFormat("  %s code %u: %" PRIu64 " calls, %" PRIu64 " errors, "
+                "%" PRIu64 " / %zu bytes avg/max, latency us avg %" PRIu64
+                " p50 <%" PRIu64 " p90 <%" PRIu64 " p99 <%" PRIu64 " max %" PRIu64 "\n",
+                String8(total.first.first).string(), total.first.second, e.count, e.errors,
+                e.totalBytes / e.count, e.maxBytes, e.totalLatencyUs / e.count,
+                latencyPercentile(e, 50), latencyPercentile(e, 90),
+                latencyPercentile(e, 99), e.maxLatencyUs);
+    }
+}
+
+}; // namespace android
@@ -41,6 +41,10 @@ public:
                                     Parcel* reply,
                                     uint32_t flags = 0);
 
+            // Queues a oneway transaction on the calling thread, to be sent
+            // with the others by IPCThreadState::flushOnewayTransactions().
+            status_t    queueOnewayTransaction(uint32_t code, const Parcel& data);
+
     virtual status_t    linkToDeath(const sp<DeathRecipient>& recipient,
                                     void* cookie = NULL,
                                     uint32_t flags = 0);
@@ -231,6 +231,13 @@ public:
     // as long as it keeps a dup of the blob file descriptor handy for later.
     status_t            writeDupImmutableBlobFileDescriptor(int fd);
 
+    // Writes a byte array as an immutable blob: in place when it is small, and
+    // by way of an anonymous shared memory region when it is large, so that
+    // large payloads are not copied through the binder transaction buffer.
+    // Read it back with readByteVectorBlob().
+    status_t            writeByteArrayBlob(size_t len, const uint8_t* val);
+    status_t            writeByteVectorBlob(const std::vector<uint8_t>& val);
+
     status_t            writeObject(const flat_binder_object& val, bool nullMetaData);
 
     // Like Parcel.java's writeNoException().  Just writes a zero int32.
@@ -375,6 +382,10 @@ public:
     // The caller should call release() on the blob after reading its contents.
     status_t            readBlob(size_t len, ReadableBlob* outBlob) const;
 
+    // Reads a byte array written with writeByteArrayBlob() or
+    // writeByteVectorBlob().
+    status_t            readByteVectorBlob(std::vector<uint8_t>* val) const;
+
     const flat_binder_object* readObject(bool nullMetaData) const;
 
     // Explicitly close all file descriptors in the parcel.
@@ -20,10 +20,12 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <gtest/gtest.h>
 
 #include <binder/Binder.h>
+#include <binder/BpBinder.h>
 #include <binder/IBinder.h>
 #include <binder/IPCThreadState.h>
 #include <binder/IServiceManager.h>
@@ -483,6 +485,67 @@ TEST_F(BinderLibTest, CallBack)
     EXPECT_EQ(NO_ERROR, ret);
 }
 
+TEST_F(BinderLibTest, QueuedOnewayTransactions)
+{
+    status_t ret;
+    BpBinder* proxy = m_server->remoteBinder();
+    ASSERT_TRUE(proxy != NULL);
+    for (int i = 0; i < 10; i++) {
+        Parcel data;
+        ret = proxy->queueOnewayTransaction(BINDER_LIB_TEST_NOP_TRANSACTION, data);
+        EXPECT_EQ(NO_ERROR, ret);
+    }
+    sp<BinderLibTestCallBack> callBack = new BinderLibTestCallBack();
+    {
+        Parcel data;
+        data.writeStrongBinder(callBack);
+        ret = proxy->queueOnewayTransaction(BINDER_LIB_TEST_NOP_CALL_BACK, data);
+        EXPECT_EQ(NO_ERROR, ret);
+    }
+    ret = IPCThreadState::self()->flushOnewayTransactions();
+    EXPECT_EQ(NO_ERROR, ret);
+    ret = callBack->waitEvent(5);
+    EXPECT_EQ(NO_ERROR, ret);
+    ret = callBack->getResult();
+    EXPECT_EQ(NO_ERROR, ret);
+}
+
+TEST_F(BinderLibTest, QueuedOnewayTransactionFlushedByTransact)
+{
+    status_t ret;
+    BpBinder* proxy = m_server->remoteBinder();
+    ASSERT_TRUE(proxy != NULL);
+    sp<BinderLibTestCallBack> callBack = new BinderLibTestCallBack();
+    {
+        Parcel data;
+        data.writeStrongBinder(callBack);
+        ret = proxy->queueOnewayTransaction(BINDER_LIB_TEST_NOP_CALL_BACK, data);
+        EXPECT_EQ(NO_ERROR, ret);
+    }
+    Parcel data, reply;
+    ret = m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, &reply);
+    EXPECT_EQ(NO_ERROR, ret);
+    ret = callBack->waitEvent(5);
+    EXPECT_EQ(NO_ERROR, ret);
+}
+
+TEST_F(BinderLibTest, TransactionStats)
+{
+    status_t ret;
+    ProcessState::self()->setTransactionStatsEnabled(true);
+    for (int i = 0; i < 3; i++) {
+        Parcel data, reply;
+        data.writeInterfaceToken(String16("test.binderLib.stats"));
+        ret = m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, &reply);
+        EXPECT_EQ(NO_ERROR, ret);
+    }
+    String8 result;
+    ProcessState::self()->dumpTransactionStats(result);
+    ProcessState::self()->setTransactionStatsEnabled(false);
+    EXPECT_TRUE(strstr(result.string(), "test.binderLib.stats") != NULL) << result.string();
+    EXPECT_TRUE(strstr(result.string(), ": 3 calls, 0 errors") != NULL) << result.string();
+}
+
 TEST_F(BinderLibTest, AddServer)
 {
     sp<IBinder> server = addServer();
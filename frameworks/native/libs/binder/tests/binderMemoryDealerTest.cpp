@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <binder/IMemory.h>
+#include <binder/MemoryDealer.h>
+
+using ::android::IMemory;
+using ::android::MemoryDealer;
+using ::android::sp;
+
+namespace {
+
+const size_t kBufferSize = 4096;
+const size_t kBufferCount = 8;
+
+class MemoryDealerTest : public ::testing::TestWithParam<MemoryDealer::AllocatorPolicy> {
+protected:
+    sp<MemoryDealer> createDealer() {
+        return new MemoryDealer(kBufferSize * kBufferCount, "MemoryDealerTest", 0, GetParam());
+    }
+};
+
+} // namespace
+
+TEST_P(MemoryDealerTest, FillsHeapWithBuffersOfOneSize) {
+    sp<MemoryDealer> dealer = createDealer();
+    std::vector<sp<IMemory>> buffers;
+    for (size_t i = 0; i < kBufferCount; i++) {
+        sp<IMemory> buffer = dealer->allocate(kBufferSize);
+        ASSERT_NE(nullptr, buffer.get());
+        buffers.push_back(buffer);
+    }
+    EXPECT_EQ(nullptr, dealer->allocate(kBufferSize).get());
+}
+
+TEST_P(MemoryDealerTest, ReusesFreedBuffers) {
+    sp<MemoryDealer> dealer = createDealer();
+    for (int i = 0; i < 100; i++) {
+        std::vector<sp<IMemory>> buffers;
+        for (size_t j = 0; j < kBufferCount; j++) {
+            sp<IMemory> buffer = dealer->allocate(kBufferSize);
+            ASSERT_NE(nullptr, buffer.get());
+            static_cast<uint8_t*>(buffer->pointer())[0] = uint8_t(j);
+            buffers.push_back(buffer);
+        }
+    }
+}
+
+TEST_P(MemoryDealerTest, FreedSmallBuffersMakeRoomForLargeOne) {
+    sp<MemoryDealer> dealer = createDealer();
+    {
+        std::vector<sp<IMemory>> buffers;
+        for (size_t i = 0; i < kBufferCount * 4; i++) {
+            sp<IMemory> buffer = dealer->allocate(kBufferSize / 4);
+            ASSERT_NE(nullptr, buffer.get());
+            buffers.push_back(buffer);
+        }
+    }
+    EXPECT_NE(nullptr, dealer->allocate(kBufferSize * kBufferCount).get());
+}
+
+INSTANTIATE_TEST_CASE_P(Policies, MemoryDealerTest,
+        ::testing::Values(MemoryDealer::BEST_FIT, MemoryDealer::SIZE_CLASSES));
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <binder/Parcel.h>
+#include <binder/PersistableBundle.h>
+#include <utils/String16.h>
+
+using ::android::Parcel;
+using ::android::String16;
+using ::android::os::PersistableBundle;
+
+TEST(Parcel, SmallParcelsRoundTrip) {
+    for (int i = 0; i < 100; i++) {
+        Parcel p;
+        ASSERT_EQ(android::NO_ERROR, p.writeInt32(i));
+        ASSERT_EQ(android::NO_ERROR, p.writeString16(String16("small parcel")));
+        p.setDataPosition(0);
+        EXPECT_EQ(i, p.readInt32());
+        EXPECT_EQ(String16("small parcel"), p.readString16());
+    }
+}
+
+TEST(Parcel, SmallParcelDoesNotGrow) {
+    Parcel p;
+    ASSERT_EQ(android::NO_ERROR, p.writeInt32(0));
+    const size_t capacity = p.dataCapacity();
+    const uint8_t* data = p.data();
+    while (p.dataSize() + sizeof(int32_t) <= capacity) {
+        ASSERT_EQ(android::NO_ERROR, p.writeInt32(1));
+    }
+    EXPECT_EQ(capacity, p.dataCapacity());
+    EXPECT_EQ(data, p.data());
+}
+
+TEST(Parcel, GrowsPastSmallBuffer) {
+    Parcel p;
+    for (int32_t i = 0; i < 4096; i++) {
+        ASSERT_EQ(android::NO_ERROR, p.writeInt32(i));
+    }
+    p.setDataPosition(0);
+    for (int32_t i = 0; i < 4096; i++) {
+        ASSERT_EQ(i, p.readInt32());
+    }
+}
+
+TEST(Parcel, FreedOnAnotherThread) {
+    std::unique_ptr<Parcel> p(new Parcel());
+    ASSERT_EQ(android::NO_ERROR, p->writeInt32(42));
+    std::thread([&p]() {
+        p.reset();
+        Parcel other;
+        EXPECT_EQ(android::NO_ERROR, other.writeInt32(7));
+    }).join();
+
+    Parcel q;
+    ASSERT_EQ(android::NO_ERROR, q.writeInt32(42));
+    q.setDataPosition(0);
+    EXPECT_EQ(42, q.readInt32());
+}
+
+static void checkByteVectorBlob(size_t size) {
+    std::vector<uint8_t> in(size);
+    for (size_t i = 0; i < size; i++) {
+        in[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    Parcel p;
+    ASSERT_EQ(android::NO_ERROR, p.writeByteVectorBlob(in));
+    ASSERT_EQ(android::NO_ERROR, p.writeInt32(42));
+    p.setDataPosition(0);
+
+    std::vector<uint8_t> out;
+    ASSERT_EQ(android::NO_ERROR, p.readByteVectorBlob(&out));
+    EXPECT_EQ(in, out);
+    EXPECT_EQ(42, p.readInt32());
+}
+
+TEST(Parcel, SmallByteVectorBlobStaysInPlace) {
+    checkByteVectorBlob(0);
+    checkByteVectorBlob(100);
+
+    Parcel p;
+    ASSERT_EQ(android::NO_ERROR, p.writeByteVectorBlob(std::vector<uint8_t>(100)));
+    EXPECT_FALSE(p.hasFileDescriptors());
+}
+
+TEST(Parcel, LargeByteVectorBlobUsesSharedMemory) {
+    checkByteVectorBlob(1024 * 1024);
+
+    Parcel p;
+    ASSERT_EQ(android::NO_ERROR, p.writeByteVectorBlob(std::vector<uint8_t>(1024 * 1024)));
+    EXPECT_TRUE(p.hasFileDescriptors());
+    EXPECT_LT(p.dataSize(), 1024u);
+}
+
+TEST(Parcel, TruncatedByteVectorBlob) {
+    Parcel p;
+    ASSERT_EQ(android::NO_ERROR, p.writeInt32(1000));
+    p.setDataPosition(0);
+    std::vector<uint8_t> out;
+    EXPECT_NE(android::NO_ERROR, p.readByteVectorBlob(&out));
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(PersistableBundle, LazyRoundTrip) {
+    PersistableBundle nested;
+    nested.putString(String16("name"), String16("value"));
+    PersistableBundle in;
+    in.putInt(String16("int"), 42);
+    in.putLongVector(String16("longs"), std::vector<int64_t>{1, 2, 3});
+    in.putPersistableBundle(String16("nested"), nested);
+
+    Parcel p;
+    ASSERT_EQ(android::NO_ERROR, in.writeToParcel(&p));
+    p.setDataPosition(0);
+    PersistableBundle out;
+    ASSERT_EQ(android::NO_ERROR, out.readFromParcel(&p));
+    EXPECT_EQ(p.dataSize(), p.dataPosition());
+    EXPECT_EQ(3u, out.size());
+
+    // Passing the bundle on writes the same bytes without parsing it
+    Parcel forwarded;
+    ASSERT_EQ(android::NO_ERROR, out.writeToParcel(&forwarded));
+    ASSERT_EQ(p.dataSize(), forwarded.dataSize());
+    EXPECT_EQ(0, memcmp(p.data(), forwarded.data(), p.dataSize()));
+
+    int32_t value;
+    EXPECT_TRUE(out.getInt(String16("int"), &value));
+    EXPECT_EQ(42, value);
+    EXPECT_EQ(in, out);
+}
+
+TEST(PersistableBundle, ModifiedAfterRead) {
+    PersistableBundle in;
+    in.putInt(String16("int"), 42);
+    Parcel p;
+    ASSERT_EQ(android::NO_ERROR, in.writeToParcel(&p));
+    p.setDataPosition(0);
+    PersistableBundle out;
+    ASSERT_EQ(android::NO_ERROR, out.readFromParcel(&p));
+
+    out.putBoolean(String16("bool"), true);
+    EXPECT_EQ(2u, out.size());
+    Parcel p2;
+    ASSERT_EQ(android::NO_ERROR, out.writeToParcel(&p2));
+    p2.setDataPosition(0);
+    PersistableBundle out2;
+    ASSERT_EQ(android::NO_ERROR, out2.readFromParcel(&p2));
+    EXPECT_EQ(out, out2);
+    bool flag;
+    EXPECT_TRUE(out2.getBoolean(String16("bool"), &flag));
+    EXPECT_TRUE(flag);
+}
@@ -33,6 +33,7 @@
 
 #include <gui/BufferItem.h>
 #include <gui/BufferQueueCore.h>
+#include <gui/GraphicBufferPool.h>
 #include <gui/IConsumerListener.h>
 #include <gui/IProducerListener.h>
 #include <gui/ISurfaceComposer.h>
@@ -224,6 +225,19 @@ void BufferQueueCore::clearBufferSlotLocked(int slot) {
     }
 }
 
+void BufferQueueCore::recycleBufferSlotLocked(int slot) {
+    const BufferSlot& bufferSlot(mSlots[slot]);
+    // A pending EGL fence can't be handed over with the buffer, and the
+    // shared buffer may still be in use by the consumer
+    if (bufferSlot.mGraphicBuffer != NULL && mConnectedPid >= 0 &&
+            bufferSlot.mEglFence == EGL_NO_SYNC_KHR &&
+            !bufferSlot.mBufferState.mShared) {
+        GraphicBufferPool::get().recycle(mConnectedPid,
+                bufferSlot.mGraphicBuffer, bufferSlot.mFence);
+    }
+    clearBufferSlotLocked(slot);
+}
+
 void BufferQueueCore::freeAllBuffersLocked() {
     for (int s : mFreeSlots) {
         clearBufferSlotLocked(s);
@@ -231,7 +245,7 @@ void BufferQueueCore::freeAllBuffersLocked() {
 
     for (int s : mFreeBuffers) {
         mFreeSlots.insert(s);
-        clearBufferSlotLocked(s);
+        recycleBufferSlotLocked(s);
     }
     mFreeBuffers.clear();
 
@@ -294,7 +308,7 @@ bool BufferQueueCore::adjustAvailableSlotsLocked(int delta) {
                 mFreeSlots.erase(slot);
             } else if (!mFreeBuffers.empty()) {
                 int slot = mFreeBuffers.back();
-                clearBufferSlotLocked(slot);
+                recycleBufferSlotLocked(slot);
                 mUnusedSlots.push_back(slot);
                 mFreeBuffers.pop_back();
             } else {
@@ -33,6 +33,7 @@
 #include <gui/BufferQueueCore.h>
 #include <gui/BufferQueueProducer.h>
 #include <gui/GLConsumer.h>
+#include <gui/GraphicBufferPool.h>
 #include <gui/IConsumerListener.h>
 #include <gui/IProducerListener.h>
 
@@ -378,6 +379,7 @@ status_t BufferQueueProducer::dequeueBuffer(int* outSlot, sp<android::Fence>* ou
     EGLDisplay eglDisplay = EGL_NO_DISPLAY;
     EGLSyncKHR eglFence = EGL_NO_SYNC_KHR;
     bool attachedByConsumer = false;
+    pid_t connectedPid = -1;
 
     { // Autolock scope
         Mutex::Autolock lock(mCore->mMutex);
@@ -423,7 +425,7 @@ status_t BufferQueueProducer::dequeueBuffer(int* outSlot, sp<android::Fence>* ou
                         return BAD_VALUE;
                     }
                     mCore->mFreeSlots.insert(found);
-                    mCore->clearBufferSlotLocked(found);
+                    mCore->recycleBufferSlotLocked(found);
                     found = BufferItem::INVALID_BUFFER_SLOT;
                     continue;
                 }
@@ -453,6 +455,13 @@ status_t BufferQueueProducer::dequeueBuffer(int* outSlot, sp<android::Fence>* ou
         if ((buffer == NULL) ||
                 buffer->needsReallocation(width, height, format, BQ_LAYER_COUNT, usage))
         {
+            // The consumer has released the old buffer, so another surface of
+            // the same producer may be able to use it
+            if (buffer != NULL && mSlots[found].mEglFence == EGL_NO_SYNC_KHR) {
+                GraphicBufferPool::get().recycle(mCore->mConnectedPid, buffer,
+                        mSlots[found].mFence);
+            }
+            connectedPid = mCore->mConnectedPid;
             mSlots[found].mAcquireCalled = false;
             mSlots[found].mGraphicBuffer = NULL;
             mSlots[found].mRequestBufferCalled = false;
@@ -498,10 +507,17 @@ status_t BufferQueueProducer::dequeueBuffer(int* outSlot, sp<android::Fence>* ou
     } // Autolock scope
 
     if (returnFlags & BUFFER_NEEDS_REALLOCATION) {
-        BQ_LOGV("dequeueBuffer: allocating a new buffer for slot %d", *outSlot);
-        sp<GraphicBuffer> graphicBuffer = new GraphicBuffer(
-                width, height, format, BQ_LAYER_COUNT, usage,
-                {mConsumerName.string(), mConsumerName.size()});
+        sp<Fence> pooledFence;
+        sp<GraphicBuffer> graphicBuffer = GraphicBufferPool::get().take(connectedPid,
+                width, height, format, BQ_LAYER_COUNT, usage, &pooledFence);
+        if (graphicBuffer != NULL) {
+            BQ_LOGV("dequeueBuffer: using a pooled buffer for slot %d", *outSlot);
+        } else {
+            BQ_LOGV("dequeueBuffer: allocating a new buffer for slot %d", *outSlot);
+            graphicBuffer = new GraphicBuffer(
+                    width, height, format, BQ_LAYER_COUNT, usage,
+                    {mConsumerName.string(), mConsumerName.size()});
+        }
 
         status_t error = graphicBuffer->initCheck();
 
@@ -511,6 +527,9 @@ status_t BufferQueueProducer::dequeueBuffer(int* outSlot, sp<android::Fence>* ou
             if (error == NO_ERROR && !mCore->mIsAbandoned) {
                 graphicBuffer->setGenerationNumber(mCore->mGenerationNumber);
                 mSlots[*outSlot].mGraphicBuffer = graphicBuffer;
+                if (pooledFence != NULL) {
+                    *outFence = pooledFence;
+                }
             }
 
             mCore->mIsAllocating = false;
@@ -1327,6 +1346,7 @@ void BufferQueueProducer::allocateBuffers(uint32_t width, uint32_t height,
         uint32_t allocHeight = 0;
         PixelFormat allocFormat = PIXEL_FORMAT_UNKNOWN;
         uint64_t allocUsage = 0;
+        pid_t connectedPid = -1;
         { // Autolock scope
             Mutex::Autolock lock(mCore->mMutex);
             mCore->waitWhileAllocatingLocked();
@@ -1346,15 +1366,23 @@ void BufferQueueProducer::allocateBuffers(uint32_t width, uint32_t height,
             allocHeight = height > 0 ? height : mCore->mDefaultHeight;
             allocFormat = format != 0 ? format : mCore->mDefaultBufferFormat;
             allocUsage = usage | mCore->mConsumerUsageBits;
+            connectedPid = mCore->mConnectedPid;
 
             mCore->mIsAllocating = true;
         } // Autolock scope
 
         Vector<sp<GraphicBuffer>> buffers;
+        Vector<sp<Fence>> fences;
         for (size_t i = 0; i <  newBufferCount; ++i) {
-            sp<GraphicBuffer> graphicBuffer = new GraphicBuffer(
-                    allocWidth, allocHeight, allocFormat, BQ_LAYER_COUNT,
-                    allocUsage, {mConsumerName.string(), mConsumerName.size()});
+            sp<Fence> fence(Fence::NO_FENCE);
+            sp<GraphicBuffer> graphicBuffer = GraphicBufferPool::get().take(
+                    connectedPid, allocWidth, allocHeight, allocFormat,
+                    BQ_LAYER_COUNT, allocUsage, &fence);
+            if (graphicBuffer == NULL) {
+                graphicBuffer = new GraphicBuffer(
+                        allocWidth, allocHeight, allocFormat, BQ_LAYER_COUNT,
+                        allocUsage, {mConsumerName.string(), mConsumerName.size()});
+            }
 
             status_t result = graphicBuffer->initCheck();
 
@@ -1367,6 +1395,7 @@ void BufferQueueProducer::allocateBuffers(uint32_t width, uint32_t height,
                 return;
             }
             buffers.push_back(graphicBuffer);
+            fences.push_back(fence);
         }
 
         { // Autolock scope
@@ -1394,7 +1423,7 @@ void BufferQueueProducer::allocateBuffers(uint32_t width, uint32_t height,
                 auto slot = mCore->mFreeSlots.begin();
                 mCore->clearBufferSlotLocked(*slot); // Clean up the slot first
                 mSlots[*slot].mGraphicBuffer = buffers[i];
-                mSlots[*slot].mFence = Fence::NO_FENCE;
+                mSlots[*slot].mFence = fences[i];
 
                 // freeBufferLocked puts this slot on the free slots list. Since
                 // we then attached a buffer, move the slot to free buffer list.
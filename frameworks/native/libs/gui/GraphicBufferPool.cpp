@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define LOG_TAG "GraphicBufferPool"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+//#define LOG_NDEBUG 0
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include <cutils/properties.h>
+
+#include <gui/GraphicBufferPool.h>
+
+#include <log/log.h>
+#include <utils/String8.h>
+#include <utils/Trace.h>
+
+namespace android {
+// ---------------------------------------------------------------------------
+
+ANDROID_SINGLETON_STATIC_INSTANCE(GraphicBufferPool)
+
+constexpr nsecs_t GraphicBufferPool::MAX_AGE;
+
+GraphicBufferPool::GraphicBufferPool()
+  : mMaxSize(0),
+    mSize(0),
+    mHitCount(0),
+    mMissCount(0)
+{
+    char value[PROPERTY_VALUE_MAX];
+    property_get("ro.bq.buffer_pool_size_kb", value, "0");
+    mMaxSize = static_cast<size_t>(atoi(value)) * 1024;
+}
+
+bool GraphicBufferPool::isEnabled() const {
+    Mutex::Autolock lock(mMutex);
+    return mMaxSize > 0;
+}
+
+void GraphicBufferPool::setMaxSize(size_t maxSizeBytes) {
+    std::list<Entry> evicted;
+    Mutex::Autolock lock(mMutex);
+    mMaxSize = maxSizeBytes;
+    evictLocked(systemTime(), &evicted);
+}
+
+sp<GraphicBuffer> GraphicBufferPool::take(pid_t owner, uint32_t width,
+        uint32_t height, PixelFormat format, uint32_t layerCount,
+        uint64_t usage, sp<Fence>* outFence) {
+    std::list<Entry> evicted;
+    Mutex::Autolock lock(mMutex);
+    if (mMaxSize == 0) {
+        return NULL;
+    }
+    evictLocked(systemTime(), &evicted);
+
+    for (auto it = mEntries.rbegin(); it != mEntries.rend(); ++it) {
+        const sp<GraphicBuffer>& buffer(it->buffer);
+        if (it->owner == owner && buffer->getWidth() == width &&
+                buffer->getHeight() == height &&
+                buffer->getPixelFormat() == format &&
+                buffer->getLayerCount() == layerCount &&
+                buffer->getUsage() == usage) {
+            ATRACE_NAME("GraphicBufferPool::take");
+            sp<GraphicBuffer> result(buffer);
+            *outFence = it->fence;
+            mSize -= it->size;
+            mEntries.erase(std::next(it).base());
+            mHitCount++;
+            return result;
+        }
+    }
+    mMissCount++;
+    return NULL;
+}
+
+void GraphicBufferPool::recycle(pid_t owner, const sp<GraphicBuffer>& buffer,
+        const sp<Fence>& fence) {
+    if (buffer == NULL) {
+        return;
+    }
+
+    std::list<Entry> evicted;
+    Mutex::Autolock lock(mMutex);
+    const size_t size = getBufferSize(buffer);
+    if (size == 0 || size > mMaxSize) {
+        return;
+    }
+    ALOGV("recycle: %u x %u, format %d, usage %#" PRIx64 " from pid %d",
+            buffer->getWidth(), buffer->getHeight(), buffer->getPixelFormat(),
+            buffer->getUsage(), owner);
+    const nsecs_t now = systemTime();
+    mEntries.push_back({owner, buffer,
+            fence != NULL ? fence : Fence::NO_FENCE, size, now});
+    mSize += size;
+    evictLocked(now, &evicted);
+}
+
+void GraphicBufferPool::clear() {
+    std::list<Entry> evicted;
+    Mutex::Autolock lock(mMutex);
+    evicted.swap(mEntries);
+    mSize = 0;
+}
+
+void GraphicBufferPool::dump(String8& result) const {
+    Mutex::Autolock lock(mMutex);
+    result.appendFormat("GraphicBufferPool: %zu buffers, %zu of %zu KiB, "
+            "%zu hits, %zu misses\n", mEntries.size(), mSize / 1024,
+            mMaxSize / 1024, mHitCount, mMissCount);
+}
+
+size_t GraphicBufferPool::getBufferSize(const sp<GraphicBuffer>& buffer) {
+    // Formats without a fixed bytes per pixel are YUV formats, assume 12bpp
+    const uint32_t bpp = bytesPerPixel(buffer->getPixelFormat());
+    const size_t pixels = static_cast<size_t>(buffer->getStride()) *
+            buffer->getHeight() * buffer->getLayerCount();
+    return bpp > 0 ? pixels * bpp : pixels * 3 / 2;
+}
+
+void GraphicBufferPool::evictLocked(nsecs_t now, std::list<Entry>* outEvicted) {
+    while (!mEntries.empty() && (mSize > mMaxSize ||
+            now - mEntries.front().recycleTime > MAX_AGE)) {
+        mSize -= mEntries.front().size;
+        outEvicted->splice(outEvicted->end(), mEntries, mEntries.begin());
+    }
+}
+
+// ---------------------------------------------------------------------------
+}; // namespace android
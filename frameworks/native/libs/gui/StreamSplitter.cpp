@@ -62,9 +62,9 @@ StreamSplitter::StreamSplitter(const sp<IGraphicBufferConsumer>& inputQueue)
 
 StreamSplitter::~StreamSplitter() {
     mInput->consumerDisconnect();
-    Vector<sp<IGraphicBufferProducer> >::iterator output = mOutputs.begin();
+    Vector<Output>::iterator output = mOutputs.begin();
     for (; output != mOutputs.end(); ++output) {
-        (*output)->disconnect(NATIVE_WINDOW_API_CPU);
+        output->queue->disconnect(NATIVE_WINDOW_API_CPU);
     }
 
     if (mBuffers.size() > 0) {
@@ -73,7 +73,7 @@ StreamSplitter::~StreamSplitter() {
 }
 
 status_t StreamSplitter::addOutput(
-        const sp<IGraphicBufferProducer>& outputQueue) {
+        const sp<IGraphicBufferProducer>& outputQueue, bool latestOnly) {
     if (outputQueue == NULL) {
         ALOGE("addOutput: outputQueue must not be NULL");
         return BAD_VALUE;
@@ -91,7 +91,10 @@ status_t StreamSplitter::addOutput(
         return status;
     }
 
-    mOutputs.push_back(outputQueue);
+    Output output;
+    output.queue = outputQueue;
+    output.latestOnly = latestOnly;
+    mOutputs.push_back(output);
 
     return NO_ERROR;
 }
@@ -101,6 +104,21 @@ void StreamSplitter::setName(const String8 &name) {
     mInput->setConsumerName(name);
 }
 
+void StreamSplitter::dump(String8& result, const char* prefix) {
+    Mutex::Autolock lock(mMutex);
+    result.appendFormat("%sStreamSplitter: %d outstanding buffers%s\n", prefix,
+            mOutstandingBuffers, mIsAbandoned ? " (abandoned)" : "");
+    for (size_t i = 0; i < mOutputs.size(); ++i) {
+        const Output& output = mOutputs[i];
+        const uint64_t released = output.buffersQueued - output.buffersHeld;
+        result.appendFormat("%s  output %zu%s: queued=%" PRIu64
+                " skipped=%" PRIu64 " held=%zu avgRelease=%.2fms\n", prefix, i,
+                output.latestOnly ? " (latest only)" : "",
+                output.buffersQueued, output.buffersSkipped, output.buffersHeld,
+                released > 0 ? output.totalReleaseTime / (released * 1e6) : 0.0);
+    }
+}
+
 void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
     ATRACE_CALL();
     Mutex::Autolock lock(mMutex);
@@ -108,7 +126,8 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
     // The current policy is that if any one consumer is consuming buffers too
     // slowly, the splitter will stall the rest of the outputs by not acquiring
     // any more buffers from the input. This will cause back pressure on the
-    // input queue, slowing down its producer.
+    // input queue, slowing down its producer. Outputs added as latest-only
+    // never hold more than one buffer, so they can't cause such a stall.
 
     // If there are too many outstanding buffers, we block until a buffer is
     // released back to the input in onBufferReleased
@@ -139,8 +158,8 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
             "detaching buffer from input failed (%d)", status);
 
     // Initialize our reference count for this buffer
-    mBuffers.add(bufferItem.mGraphicBuffer->getId(),
-            new BufferTracker(bufferItem.mGraphicBuffer));
+    sp<BufferTracker> tracker(new BufferTracker(bufferItem.mGraphicBuffer));
+    mBuffers.add(bufferItem.mGraphicBuffer->getId(), tracker);
 
     IGraphicBufferProducer::QueueBufferInput queueInput(
             bufferItem.mTimestamp, bufferItem.mIsAutoTimestamp,
@@ -149,17 +168,27 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
             bufferItem.mTransform, bufferItem.mFence);
 
     // Attach and queue the buffer to each of the outputs
-    Vector<sp<IGraphicBufferProducer> >::iterator output = mOutputs.begin();
+    size_t releaseCount = 0;
+    Vector<Output>::iterator output = mOutputs.begin();
     for (; output != mOutputs.end(); ++output) {
+        // A latest-only output still holding a buffer skips this one, which
+        // counts as released by it right away
+        if (output->latestOnly && output->buffersHeld > 0) {
+            ++output->buffersSkipped;
+            releaseCount = tracker->incrementReleaseCountLocked();
+            ALOGV("skipped buffer %#" PRIx64 " for output %p",
+                    bufferItem.mGraphicBuffer->getId(), output->queue.get());
+            continue;
+        }
+
         int slot;
-        status = (*output)->attachBuffer(&slot, bufferItem.mGraphicBuffer);
+        status = output->queue->attachBuffer(&slot, bufferItem.mGraphicBuffer);
         if (status == NO_INIT) {
             // If we just discovered that this output has been abandoned, note
             // that, increment the release count so that we still release this
             // buffer eventually, and move on to the next output
             onAbandonedLocked();
-            mBuffers.editValueFor(bufferItem.mGraphicBuffer->getId())->
-                    incrementReleaseCountLocked();
+            releaseCount = tracker->incrementReleaseCountLocked();
             continue;
         } else {
             LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
@@ -167,22 +196,28 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
         }
 
         IGraphicBufferProducer::QueueBufferOutput queueOutput;
-        status = (*output)->queueBuffer(slot, queueInput, &queueOutput);
+        status = output->queue->queueBuffer(slot, queueInput, &queueOutput);
         if (status == NO_INIT) {
             // If we just discovered that this output has been abandoned, note
             // that, increment the release count so that we still release this
             // buffer eventually, and move on to the next output
             onAbandonedLocked();
-            mBuffers.editValueFor(bufferItem.mGraphicBuffer->getId())->
-                    incrementReleaseCountLocked();
+            releaseCount = tracker->incrementReleaseCountLocked();
             continue;
         } else {
             LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
                     "queueing buffer to output failed (%d)", status);
         }
 
+        ++output->buffersHeld;
+        ++output->buffersQueued;
         ALOGV("queued buffer %#" PRIx64 " to output %p",
-                bufferItem.mGraphicBuffer->getId(), output->get());
+                bufferItem.mGraphicBuffer->getId(), output->queue.get());
+    }
+
+    // If no output took the buffer, nothing will release it later
+    if (releaseCount >= mOutputs.size()) {
+        releaseToInputLocked(tracker);
     }
 }
 
@@ -207,7 +242,13 @@ void StreamSplitter::onBufferReleasedByOutput(
     ALOGV("detached buffer %#" PRIx64 " from output %p",
           buffer->getId(), from.get());
 
-    const sp<BufferTracker>& tracker = mBuffers.editValueFor(buffer->getId());
+    sp<BufferTracker> tracker = mBuffers.editValueFor(buffer->getId());
+
+    Output* output = findOutputLocked(from);
+    if (output != NULL) {
+        --output->buffersHeld;
+        output->totalReleaseTime += systemTime() - tracker->getQueueTime();
+    }
 
     // Merge the release fence of the incoming buffer so that the fence we send
     // back to the input includes all of the outputs' fences
@@ -221,16 +262,33 @@ void StreamSplitter::onBufferReleasedByOutput(
         return;
     }
 
+    releaseToInputLocked(tracker);
+}
+
+StreamSplitter::Output* StreamSplitter::findOutputLocked(
+        const sp<IGraphicBufferProducer>& queue) {
+    sp<IBinder> binder = IInterface::asBinder(queue);
+    for (size_t i = 0; i < mOutputs.size(); ++i) {
+        if (IInterface::asBinder(mOutputs[i].queue) == binder) {
+            return &mOutputs.editItemAt(i);
+        }
+    }
+    return NULL;
+}
+
+void StreamSplitter::releaseToInputLocked(const sp<BufferTracker>& tracker) {
+    const uint64_t bufferId = tracker->getBuffer()->getId();
+
     // If we've been abandoned, we can't return the buffer to the input, so just
     // stop tracking it and move on
     if (mIsAbandoned) {
-        mBuffers.removeItem(buffer->getId());
+        mBuffers.removeItem(bufferId);
         return;
     }
 
     // Attach and release the buffer back to the input
     int consumerSlot;
-    status = mInput->attachBuffer(&consumerSlot, tracker->getBuffer());
+    status_t status = mInput->attachBuffer(&consumerSlot, tracker->getBuffer());
     LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
             "attaching buffer to input failed (%d)", status);
 
@@ -239,11 +297,11 @@ void StreamSplitter::onBufferReleasedByOutput(
     LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
             "releasing buffer to input failed (%d)", status);
 
-    ALOGV("released buffer %#" PRIx64 " to input", buffer->getId());
+    ALOGV("released buffer %#" PRIx64 " to input", bufferId);
 
     // We no longer need to track the buffer once it has been returned to the
     // input
-    mBuffers.removeItem(buffer->getId());
+    mBuffers.removeItem(bufferId);
 
     // Notify any waiting onFrameAvailable calls
     --mOutstandingBuffers;
@@ -276,7 +334,8 @@ void StreamSplitter::OutputListener::binderDied(const wp<IBinder>& /* who */) {
 }
 
 StreamSplitter::BufferTracker::BufferTracker(const sp<GraphicBuffer>& buffer)
-      : mBuffer(buffer), mMergedFence(Fence::NO_FENCE), mReleaseCount(0) {}
+      : mBuffer(buffer), mMergedFence(Fence::NO_FENCE), mReleaseCount(0),
+        mQueueTime(systemTime()) {}
 
 StreamSplitter::BufferTracker::~BufferTracker() {}
 
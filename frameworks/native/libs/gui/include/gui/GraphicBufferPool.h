@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANDROID_GUI_GRAPHICBUFFERPOOL_H
+#define ANDROID_GUI_GRAPHICBUFFERPOOL_H
+
+#include <list>
+
+#include <sys/types.h>
+
+#include <ui/Fence.h>
+#include <ui/GraphicBuffer.h>
+#include <ui/PixelFormat.h>
+
+#include <utils/Mutex.h>
+#include <utils/Singleton.h>
+#include <utils/StrongPointer.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+class String8;
+
+// GraphicBufferPool keeps buffers that a BufferQueue freed so that another
+// BufferQueue in the same process can use them instead of allocating, for
+// example when a surface is resized back and forth or a new surface of the
+// same size is created.
+//
+// Only buffers that were free in their BufferQueue are recycled: the consumer
+// has released them, and their release fence is handed out with the buffer.
+// A buffer is only given back to the same producer process it was recycled
+// from, with the exact same size, format, layer count and usage, so contents
+// never cross processes and usage bits such as protected never leak.
+//
+// The pool is disabled unless ro.bq.buffer_pool_size_kb is set to the number
+// of kilobytes it may hold. Buffers older than MAX_AGE are released the next
+// time the pool is used.
+class GraphicBufferPool : public Singleton<GraphicBufferPool> {
+public:
+    static inline GraphicBufferPool& get() { return getInstance(); }
+
+    bool isEnabled() const;
+
+    // Overrides ro.bq.buffer_pool_size_kb. A size of 0 disables the pool and
+    // releases everything in it.
+    void setMaxSize(size_t maxSizeBytes);
+
+    // Returns a matching buffer and the fence to wait on before writing to
+    // it, or NULL if the pool has none.
+    sp<GraphicBuffer> take(pid_t owner, uint32_t width, uint32_t height,
+            PixelFormat format, uint32_t layerCount, uint64_t usage,
+            sp<Fence>* outFence);
+
+    // Adds a buffer to the pool. The buffer must not be used after fence
+    // signals other than by the caller of take().
+    void recycle(pid_t owner, const sp<GraphicBuffer>& buffer,
+            const sp<Fence>& fence);
+
+    // Releases every buffer in the pool
+    void clear();
+
+    void dump(String8& result) const;
+
+private:
+    friend class Singleton<GraphicBufferPool>;
+
+    static constexpr nsecs_t MAX_AGE = s2ns(2);
+
+    struct Entry {
+        pid_t owner;
+        sp<GraphicBuffer> buffer;
+        sp<Fence> fence;
+        size_t size;
+        nsecs_t recycleTime;
+    };
+
+    GraphicBufferPool();
+
+    static size_t getBufferSize(const sp<GraphicBuffer>& buffer);
+
+    // Moves entries that are too old, or don't fit in the pool anymore, to
+    // outEvicted so they can be released after mMutex is unlocked
+    void evictLocked(nsecs_t now, std::list<Entry>* outEvicted);
+
+    mutable Mutex mMutex;
+    size_t mMaxSize;
+    size_t mSize;
+    // Least recently recycled first
+    std::list<Entry> mEntries;
+    size_t mHitCount;
+    size_t mMissCount;
+};
+
+}; // namespace android
+
+#endif // ANDROID_GUI_GRAPHICBUFFERPOOL_H
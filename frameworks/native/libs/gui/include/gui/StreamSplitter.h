@@ -24,6 +24,7 @@
 #include <utils/KeyedVector.h>
 #include <utils/Mutex.h>
 #include <utils/StrongPointer.h>
+#include <utils/Timers.h>
 
 namespace android {
 
@@ -61,11 +62,23 @@ public:
     // outputQueue has not been added to the splitter. BAD_VALUE is returned if
     // outputQueue is NULL. See IGraphicBufferProducer::connect for explanations
     // of other error codes.
-    status_t addOutput(const sp<IGraphicBufferProducer>& outputQueue);
+    //
+    // By default an output receives every buffer, and a consumer that is slow
+    // to release them stalls the input and therefore every other output. If
+    // latestOnly is true, a buffer is skipped for this output (and counts as
+    // already released by it) while the output still holds an earlier one, so
+    // that a slow consumer only sees fewer frames. This suits outputs such as
+    // previews or analysis, which only care about the most recent frame.
+    status_t addOutput(const sp<IGraphicBufferProducer>& outputQueue,
+            bool latestOnly = false);
 
     // setName sets the consumer name of the input queue
     void setName(const String8& name);
 
+    // dump appends, for each output, the number of buffers queued to it and
+    // skipped for it, and the average time it took to release a buffer
+    void dump(String8& result, const char* prefix);
+
 private:
     // From IConsumerListener
     //
@@ -132,6 +145,7 @@ private:
 
         const sp<GraphicBuffer>& getBuffer() const { return mBuffer; }
         const sp<Fence>& getMergedFence() const { return mMergedFence; }
+        nsecs_t getQueueTime() const { return mQueueTime; }
 
         void mergeFence(const sp<Fence>& with);
 
@@ -151,8 +165,34 @@ private:
         sp<GraphicBuffer> mBuffer; // One instance that holds this native handle
         sp<Fence> mMergedFence;
         size_t mReleaseCount;
+        nsecs_t mQueueTime;
+    };
+
+    // State kept for each output BufferQueue. Only accessed with mMutex held.
+    struct Output {
+        Output() : latestOnly(false), buffersHeld(0), buffersQueued(0),
+                buffersSkipped(0), totalReleaseTime(0) {}
+
+        sp<IGraphicBufferProducer> queue;
+        bool latestOnly;
+        // Number of buffers queued to this output and not yet released by it
+        size_t buffersHeld;
+        uint64_t buffersQueued;
+        uint64_t buffersSkipped;
+        // Sum of the queue-to-release times of the released buffers
+        nsecs_t totalReleaseTime;
     };
 
+    // Finds the state of the output whose producer interface is queue, or
+    // returns NULL if it isn't one of our outputs. Must be called with mMutex
+    // locked.
+    Output* findOutputLocked(const sp<IGraphicBufferProducer>& queue);
+
+    // Called once every output has released (or skipped) the buffer tracked
+    // by tracker. Releases it back to the input and allows a blocked
+    // onFrameAvailable call to proceed. Must be called with mMutex locked.
+    void releaseToInputLocked(const sp<BufferTracker>& tracker);
+
     // Only called from createSplitter
     StreamSplitter(const sp<IGraphicBufferConsumer>& inputQueue);
 
@@ -171,7 +211,7 @@ private:
     Condition mReleaseCondition;
     int mOutstandingBuffers;
     sp<IGraphicBufferConsumer> mInput;
-    Vector<sp<IGraphicBufferProducer> > mOutputs;
+    Vector<Output> mOutputs;
 
     // Map of GraphicBuffer IDs (GraphicBuffer::getId()) to buffer tracking
     // objects (which are mostly for counting how many outputs have released the
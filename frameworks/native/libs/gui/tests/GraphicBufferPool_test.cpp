@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define LOG_TAG "GraphicBufferPool_test"
+//#define LOG_NDEBUG 0
+
+#include "DummyConsumer.h"
+
+#include <gui/BufferItem.h>
+#include <gui/BufferQueue.h>
+#include <gui/GraphicBufferPool.h>
+#include <gui/IProducerListener.h>
+
+#include <ui/GraphicBuffer.h>
+
+#include <system/window.h>
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <vector>
+
+namespace android {
+
+static constexpr uint64_t TEST_USAGE = GRALLOC_USAGE_SW_READ_OFTEN;
+static constexpr size_t TEST_POOL_SIZE = 4 * 1024 * 1024;
+
+class GraphicBufferPoolTest : public ::testing::Test {
+protected:
+    GraphicBufferPoolTest() : mPool(GraphicBufferPool::get()) {}
+
+    void SetUp() override {
+        mPool.setMaxSize(TEST_POOL_SIZE);
+    }
+
+    void TearDown() override {
+        mPool.setMaxSize(0);
+    }
+
+    sp<GraphicBuffer> allocate(uint32_t width, uint32_t height) {
+        sp<GraphicBuffer> buffer(new GraphicBuffer(width, height,
+                PIXEL_FORMAT_RGBA_8888, 1, TEST_USAGE, "GraphicBufferPool_test"));
+        EXPECT_EQ(NO_ERROR, buffer->initCheck());
+        return buffer;
+    }
+
+    sp<GraphicBuffer> take(pid_t owner, uint32_t width, uint32_t height,
+            uint64_t usage = TEST_USAGE) {
+        sp<Fence> fence;
+        return mPool.take(owner, width, height, PIXEL_FORMAT_RGBA_8888, 1,
+                usage, &fence);
+    }
+
+    GraphicBufferPool& mPool;
+};
+
+TEST_F(GraphicBufferPoolTest, DisabledPoolKeepsNothing) {
+    mPool.setMaxSize(0);
+    sp<GraphicBuffer> buffer(allocate(16, 16));
+    mPool.recycle(getpid(), buffer, Fence::NO_FENCE);
+    ASSERT_EQ(nullptr, take(getpid(), 16, 16));
+}
+
+TEST_F(GraphicBufferPoolTest, TakeReturnsMatchingBuffer) {
+    pid_t owner = getpid();
+    sp<GraphicBuffer> buffer(allocate(16, 16));
+    mPool.recycle(owner, buffer, Fence::NO_FENCE);
+
+    ASSERT_EQ(nullptr, take(owner, 32, 16));
+    ASSERT_EQ(nullptr, take(owner, 16, 16, TEST_USAGE | GRALLOC_USAGE_SW_WRITE_OFTEN));
+    ASSERT_EQ(nullptr, take(owner + 1, 16, 16));
+
+    sp<Fence> fence;
+    sp<GraphicBuffer> pooled(mPool.take(owner, 16, 16, PIXEL_FORMAT_RGBA_8888,
+            1, TEST_USAGE, &fence));
+    ASSERT_EQ(buffer, pooled);
+    ASSERT_EQ(Fence::NO_FENCE, fence);
+
+    // Each recycled buffer is only handed out once
+    ASSERT_EQ(nullptr, take(owner, 16, 16));
+}
+
+TEST_F(GraphicBufferPoolTest, EvictsOldestWhenFull) {
+    pid_t owner = getpid();
+    // 256x1024 RGBA is 1MiB, so only the last four fit in the pool
+    std::vector<sp<GraphicBuffer>> buffers;
+    for (int i = 0; i < 5; i++) {
+        buffers.push_back(allocate(256, 1024));
+        mPool.recycle(owner, buffers.back(), Fence::NO_FENCE);
+    }
+
+    std::vector<sp<GraphicBuffer>> pooled;
+    for (sp<GraphicBuffer> buffer = take(owner, 256, 1024); buffer != nullptr;
+            buffer = take(owner, 256, 1024)) {
+        pooled.push_back(buffer);
+    }
+    ASSERT_GE(pooled.size(), 1u);
+    ASSERT_LE(pooled.size(), 4u);
+    for (const auto& buffer : pooled) {
+        ASSERT_NE(buffers[0], buffer);
+    }
+}
+
+TEST_F(GraphicBufferPoolTest, BufferQueueReusesFreedBuffer) {
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+    BufferQueue::createBufferQueue(&producer, &consumer);
+    ASSERT_EQ(OK, consumer->consumerConnect(new DummyConsumer, false));
+    IGraphicBufferProducer::QueueBufferOutput qbo;
+    ASSERT_EQ(OK, producer->connect(new DummyProducerListener,
+            NATIVE_WINDOW_API_CPU, false, &qbo));
+
+    int slot;
+    sp<Fence> fence;
+    sp<GraphicBuffer> first;
+    IGraphicBufferProducer::QueueBufferInput qbi(0, false,
+            HAL_DATASPACE_UNKNOWN, Rect(0, 0, 16, 16),
+            NATIVE_WINDOW_SCALING_MODE_FREEZE, 0, Fence::NO_FENCE);
+    ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION,
+            producer->dequeueBuffer(&slot, &fence, 16, 16, PIXEL_FORMAT_RGBA_8888,
+                    TEST_USAGE, nullptr, nullptr));
+    ASSERT_EQ(OK, producer->requestBuffer(slot, &first));
+    ASSERT_EQ(OK, producer->queueBuffer(slot, qbi, &qbo));
+    BufferItem item;
+    ASSERT_EQ(OK, consumer->acquireBuffer(&item, 0));
+    ASSERT_EQ(OK, consumer->releaseBuffer(item.mSlot, item.mFrameNumber,
+            EGL_NO_DISPLAY, EGL_NO_SYNC_KHR, Fence::NO_FENCE));
+
+    // Disconnecting frees the released buffer into the pool, where the next
+    // BufferQueue of this process picks it up
+    ASSERT_EQ(OK, producer->disconnect(NATIVE_WINDOW_API_CPU));
+
+    sp<IGraphicBufferProducer> otherProducer;
+    sp<IGraphicBufferConsumer> otherConsumer;
+    BufferQueue::createBufferQueue(&otherProducer, &otherConsumer);
+    ASSERT_EQ(OK, otherConsumer->consumerConnect(new DummyConsumer, false));
+    ASSERT_EQ(OK, otherProducer->connect(new DummyProducerListener,
+            NATIVE_WINDOW_API_CPU, false, &qbo));
+
+    sp<GraphicBuffer> second;
+    ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION,
+            otherProducer->dequeueBuffer(&slot, &fence, 16, 16, PIXEL_FORMAT_RGBA_8888,
+                    TEST_USAGE, nullptr, nullptr));
+    ASSERT_EQ(OK, otherProducer->requestBuffer(slot, &second));
+    ASSERT_EQ(first->getId(), second->getId());
+}
+
+} // namespace android
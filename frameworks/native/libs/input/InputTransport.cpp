@@ -23,14 +23,20 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <math.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <atomic>
+
+#include <cutils/ashmem.h>
 #include <cutils/properties.h>
 #include <log/log.h>
 
 #include <input/InputTransport.h>
+#include <input/VelocityTracker.h>
 
 namespace android {
 
@@ -97,10 +103,40 @@ size_t InputMessage::size() const {
 }
 
 
+// --- InputChannel ---
+
+// --- InputChannel::MessageRing ---
+
+/*
+ * Single producer, single consumer ring of messages in shared memory. The counters
+ * only ever grow; each end only writes its own and checks the other's for sanity
+ * since the peer may not be trusted.
+ */
+struct InputChannel::MessageRing {
+    static const uint64_t CAPACITY = 16;
+
+    struct Slot {
+        uint32_t size;
+        InputMessage message;
+    };
+
+    alignas(64) std::atomic<uint64_t> head; // next slot written by the sender
+    alignas(64) std::atomic<uint64_t> tail; // next slot read by the receiver
+    Slot slots[CAPACITY];
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+        "ring counters must be lock free to be shared between processes");
+
+// The region holds the server to client ring followed by the client to server ring.
+#define RING_REGION_SIZE (2 * sizeof(MessageRing))
+
+
 // --- InputChannel ---
 
 InputChannel::InputChannel(const String8& name, int fd) :
-        mName(name), mFd(fd) {
+        mName(name), mFd(fd), mRingFd(-1), mIsServer(false), mRingRegion(NULL),
+        mSendRing(NULL), mReceiveRing(NULL) {
 #if DEBUG_CHANNEL_LIFECYCLE
     ALOGD("Input channel constructed: name='%s', fd=%d",
             mName.string(), fd);
@@ -111,12 +147,39 @@ InputChannel::InputChannel(const String8& name, int fd) :
             "non-blocking.  errno=%d", mName.string(), errno);
 }
 
+InputChannel::InputChannel(const String8& name, int fd, int ringFd, bool isServer) :
+        InputChannel(name, fd) {
+    mRingFd = ringFd;
+    mIsServer = isServer;
+
+    int size = ashmem_get_size_region(ringFd);
+    if (size < 0 || size_t(size) < RING_REGION_SIZE) {
+        ALOGE("channel '%s' ~ Ring region has the wrong size %d", mName.string(), size);
+        return;
+    }
+    void* region = mmap(NULL, RING_REGION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, ringFd, 0);
+    if (region == MAP_FAILED) {
+        ALOGE("channel '%s' ~ Could not map ring region.  errno=%d", mName.string(), errno);
+        return;
+    }
+    mRingRegion = region;
+    MessageRing* rings = static_cast<MessageRing*>(region);
+    mSendRing = isServer ? &rings[0] : &rings[1];
+    mReceiveRing = isServer ? &rings[1] : &rings[0];
+}
+
 InputChannel::~InputChannel() {
 #if DEBUG_CHANNEL_LIFECYCLE
     ALOGD("Input channel destroyed: name='%s', fd=%d",
             mName.string(), mFd);
 #endif
 
+    if (mRingRegion) {
+        munmap(mRingRegion, RING_REGION_SIZE);
+    }
+    if (mRingFd >= 0) {
+        ::close(mRingFd);
+    }
     ::close(mFd);
 }
 
@@ -148,7 +211,115 @@ status_t InputChannel::openInputChannelPair(const String8& name,
     return OK;
 }
 
+status_t InputChannel::openSharedMemoryInputChannelPair(const String8& name,
+        sp<InputChannel>& outServerChannel, sp<InputChannel>& outClientChannel) {
+    sp<InputChannel> serverChannel, clientChannel;
+    status_t result = openInputChannelPair(name, serverChannel, clientChannel);
+    if (result != OK) {
+        outServerChannel.clear();
+        outClientChannel.clear();
+        return result;
+    }
+
+    // The region starts out zeroed, which is two empty rings.
+    int serverRingFd = ashmem_create_region(name.string(), RING_REGION_SIZE);
+    int clientRingFd = serverRingFd >= 0 ? ::dup(serverRingFd) : -1;
+    if (clientRingFd < 0) {
+        result = -errno;
+        ALOGE("channel '%s' ~ Could not create ring region.  errno=%d", name.string(), errno);
+        if (serverRingFd >= 0) {
+            ::close(serverRingFd);
+        }
+        outServerChannel.clear();
+        outClientChannel.clear();
+        return result;
+    }
+
+    outServerChannel = new InputChannel(serverChannel->getName(), ::dup(serverChannel->getFd()),
+            serverRingFd, true);
+    outClientChannel = new InputChannel(clientChannel->getName(), ::dup(clientChannel->getFd()),
+            clientRingFd, false);
+    if (!outServerChannel->mSendRing || !outClientChannel->mSendRing) {
+        outServerChannel.clear();
+        outClientChannel.clear();
+        return NO_MEMORY;
+    }
+    return OK;
+}
+
+status_t InputChannel::sendWakeup() {
+    uint8_t wakeup = 0;
+    ssize_t nWrite;
+    do {
+        nWrite = ::send(mFd, &wakeup, sizeof(wakeup), MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (nWrite == -1 && errno == EINTR);
+
+    if (nWrite < 0) {
+        int error = errno;
+        if (error == EAGAIN || error == EWOULDBLOCK) {
+            // The receiver has plenty of wakeups pending already.
+            return OK;
+        }
+        if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED || error == ECONNRESET) {
+            return DEAD_OBJECT;
+        }
+        return -error;
+    }
+    return OK;
+}
+
+status_t InputChannel::drainWakeups() {
+    uint8_t wakeups[64];
+    for (;;) {
+        ssize_t nRead = ::recv(mFd, wakeups, sizeof(wakeups), MSG_DONTWAIT);
+        if (nRead < 0) {
+            int error = errno;
+            if (error == EINTR) {
+                continue;
+            }
+            if (error == EAGAIN || error == EWOULDBLOCK) {
+                return OK;
+            }
+            if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED) {
+                return DEAD_OBJECT;
+            }
+            return -error;
+        }
+        if (nRead == 0) { // check for EOF
+            return DEAD_OBJECT;
+        }
+    }
+}
+
 status_t InputChannel::sendMessage(const InputMessage* msg) {
+    if (mSendRing) {
+        MessageRing* ring = mSendRing;
+        uint64_t head = ring->head.load(std::memory_order_relaxed);
+        uint64_t tail = ring->tail.load(std::memory_order_acquire);
+        if (tail > head) {
+            ALOGE("channel '%s' ~ ring is corrupted", mName.string());
+            return BAD_VALUE;
+        }
+        if (head - tail >= MessageRing::CAPACITY) {
+            return WOULD_BLOCK;
+        }
+
+        MessageRing::Slot& slot = ring->slots[head % MessageRing::CAPACITY];
+        slot.size = msg->size();
+        memcpy(&slot.message, msg, slot.size);
+        ring->head.store(head + 1, std::memory_order_seq_cst);
+
+#if DEBUG_CHANNEL_MESSAGES
+        ALOGD("channel '%s' ~ queued message of type %d", mName.string(), msg->header.type);
+#endif
+        // If the receiver had taken every message before this one, it may be waiting
+        // for the socket; otherwise it will see this message before it waits again.
+        if (ring->tail.load(std::memory_order_seq_cst) == head) {
+            return sendWakeup();
+        }
+        return OK;
+    }
+
     size_t msgLength = msg->size();
     ssize_t nWrite;
     do {
@@ -185,6 +356,48 @@ status_t InputChannel::sendMessage(const InputMessage* msg) {
 }
 
 status_t InputChannel::receiveMessage(InputMessage* msg) {
+    if (mReceiveRing) {
+        MessageRing* ring = mReceiveRing;
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_seq_cst);
+        if (head == tail) {
+            // Only clear the wakeups once the ring is empty, so that the fd stays
+            // readable while messages are left; then check again for messages that
+            // were sent meanwhile.
+            status_t result = drainWakeups();
+            if (result != OK) {
+                return result;
+            }
+            head = ring->head.load(std::memory_order_seq_cst);
+            if (head == tail) {
+                return WOULD_BLOCK;
+            }
+        }
+        if (tail > head || head - tail > MessageRing::CAPACITY) {
+            ALOGE("channel '%s' ~ ring is corrupted", mName.string());
+            return BAD_VALUE;
+        }
+
+        const MessageRing::Slot& slot = ring->slots[tail % MessageRing::CAPACITY];
+        size_t size = slot.size;
+        if (size > sizeof(InputMessage)) {
+            return BAD_VALUE;
+        }
+        memcpy(msg, &slot.message, size);
+        ring->tail.store(tail + 1, std::memory_order_seq_cst);
+
+        if (!msg->isValid(size)) {
+#if DEBUG_CHANNEL_MESSAGES
+            ALOGD("channel '%s' ~ received invalid message", mName.string());
+#endif
+            return BAD_VALUE;
+        }
+#if DEBUG_CHANNEL_MESSAGES
+        ALOGD("channel '%s' ~ received message of type %d", mName.string(), msg->header.type);
+#endif
+        return OK;
+    }
+
     ssize_t nRead;
     do {
         nRead = ::recv(mFd, msg, sizeof(InputMessage), MSG_DONTWAIT);
@@ -226,7 +439,18 @@ status_t InputChannel::receiveMessage(InputMessage* msg) {
 
 sp<InputChannel> InputChannel::dup() const {
     int fd = ::dup(getFd());
-    return fd >= 0 ? new InputChannel(getName(), fd) : NULL;
+    if (fd < 0) {
+        return NULL;
+    }
+    if (mRingFd < 0) {
+        return new InputChannel(getName(), fd);
+    }
+    int ringFd = ::dup(mRingFd);
+    if (ringFd < 0) {
+        ::close(fd);
+        return NULL;
+    }
+    return new InputChannel(getName(), fd, ringFd, mIsServer);
 }
 
 
@@ -375,9 +599,18 @@ status_t InputPublisher::receiveFinishedSignal(uint32_t* outSeq, bool* outHandle
 InputConsumer::InputConsumer(const sp<InputChannel>& channel) :
         mResampleTouch(isTouchResamplingEnabled()),
         mChannel(channel), mMsgDeferred(false) {
+    char strategy[PROPERTY_VALUE_MAX];
+    int32_t predictionMs = property_get_int32("ro.input.prediction_ms", 0);
+    if (property_get("ro.input.prediction_strategy", strategy, NULL) > 0 && predictionMs > 0) {
+        setMotionPrediction(-1, AINPUT_SOURCE_TOUCHSCREEN, strategy,
+                predictionMs * NANOS_PER_MS);
+    }
 }
 
 InputConsumer::~InputConsumer() {
+    for (size_t i = 0; i < mPredictors.size(); i++) {
+        delete mPredictors.itemAt(i).tracker;
+    }
 }
 
 bool InputConsumer::isTouchResamplingEnabled() {
@@ -601,6 +834,8 @@ void InputConsumer::updateTouchState(InputMessage* msg) {
         TouchState& touchState = mTouchStates.editItemAt(index);
         touchState.initialize(deviceId, source);
         touchState.addHistory(msg);
+        removePredictor(deviceId, source);
+        updatePredictor(touchState, msg);
         break;
     }
 
@@ -609,6 +844,7 @@ void InputConsumer::updateTouchState(InputMessage* msg) {
         if (index >= 0) {
             TouchState& touchState = mTouchStates.editItemAt(index);
             touchState.addHistory(msg);
+            updatePredictor(touchState, msg);
             if (eventTime < touchState.lastResample.eventTime) {
                 rewriteMessage(touchState, msg);
             } else {
@@ -625,6 +861,8 @@ void InputConsumer::updateTouchState(InputMessage* msg) {
             touchState.lastResample.idBits.clearBit(msg->body.motion.getActionId());
             rewriteMessage(touchState, msg);
         }
+        // The predictor starts over with the new set of pointers on the next move.
+        removePredictor(deviceId, source);
         break;
     }
 
@@ -635,6 +873,7 @@ void InputConsumer::updateTouchState(InputMessage* msg) {
             rewriteMessage(touchState, msg);
             touchState.lastResample.idBits.clearBit(msg->body.motion.getActionId());
         }
+        removePredictor(deviceId, source);
         break;
     }
 
@@ -655,6 +894,7 @@ void InputConsumer::updateTouchState(InputMessage* msg) {
             rewriteMessage(touchState, msg);
             mTouchStates.removeAt(index);
         }
+        removePredictor(deviceId, source);
         break;
     }
     }
@@ -716,6 +956,12 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
         }
     }
 
+    // Without a later sample to interpolate with, a predictor can do better than
+    // extrapolating from the last two samples.
+    if (!next && predictTouchState(touchState, sampleTime, event)) {
+        return;
+    }
+
     // Find the data to use for resampling.
     const History* other;
     History future;
@@ -804,6 +1050,227 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
     event->addSample(sampleTime, touchState.lastResample.pointers);
 }
 
+void InputConsumer::setMotionPrediction(int32_t deviceId, int32_t source,
+        const char* strategy, nsecs_t horizon) {
+    ssize_t index = -1;
+    for (size_t i = 0; i < mPredictionConfigs.size(); i++) {
+        const PredictionConfig& config = mPredictionConfigs.itemAt(i);
+        if (config.deviceId == deviceId && config.source == source) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        if (horizon <= 0) {
+            return;
+        }
+        PredictionConfig config;
+        config.deviceId = deviceId;
+        config.source = source;
+        config.horizon = 0;
+        config.errorCount = 0;
+        config.totalError = 0;
+        config.maxError = 0;
+        index = mPredictionConfigs.add(config);
+    }
+
+    // Settings are disabled rather than removed, to keep their telemetry.
+    PredictionConfig& config = mPredictionConfigs.editItemAt(index);
+    config.strategy.setTo(strategy);
+    config.horizon = horizon > 0 ? horizon : 0;
+
+    // Predictors are recreated with the new settings.
+    for (size_t i = 0; i < mPredictors.size(); i++) {
+        delete mPredictors.itemAt(i).tracker;
+    }
+    mPredictors.clear();
+}
+
+bool InputConsumer::getMotionPredictionStats(int32_t deviceId, int32_t source,
+        MotionPredictionStats* outStats) const {
+    for (size_t i = 0; i < mPredictionConfigs.size(); i++) {
+        const PredictionConfig& config = mPredictionConfigs.itemAt(i);
+        if (config.deviceId == deviceId && config.source == source) {
+            outStats->count = config.errorCount;
+            outStats->meanError = config.errorCount
+                    ? float(config.totalError / config.errorCount) : 0;
+            outStats->maxError = config.maxError;
+            return true;
+        }
+    }
+    return false;
+}
+
+ssize_t InputConsumer::findPredictionConfig(int32_t deviceId, int32_t source) const {
+    // A setting for the device takes precedence over one for any device.
+    ssize_t anyDevice = -1;
+    for (size_t i = 0; i < mPredictionConfigs.size(); i++) {
+        const PredictionConfig& config = mPredictionConfigs.itemAt(i);
+        if (config.source != source) {
+            continue;
+        }
+        if (config.deviceId == deviceId) {
+            return config.horizon > 0 ? ssize_t(i) : -1;
+        }
+        if (config.deviceId == -1 && config.horizon > 0) {
+            anyDevice = i;
+        }
+    }
+    return anyDevice;
+}
+
+ssize_t InputConsumer::findPredictor(int32_t deviceId, int32_t source) const {
+    for (size_t i = 0; i < mPredictors.size(); i++) {
+        const Predictor& predictor = mPredictors.itemAt(i);
+        if (predictor.deviceId == deviceId && predictor.source == source) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void InputConsumer::removePredictor(int32_t deviceId, int32_t source) {
+    ssize_t index = findPredictor(deviceId, source);
+    if (index >= 0) {
+        delete mPredictors.itemAt(index).tracker;
+        mPredictors.removeAt(index);
+    }
+}
+
+void InputConsumer::updatePredictor(const TouchState& state, const InputMessage* msg) {
+    int32_t deviceId = msg->body.motion.deviceId;
+    int32_t source = msg->body.motion.source;
+    ssize_t configIndex = findPredictionConfig(deviceId, source);
+    if (configIndex < 0) {
+        return;
+    }
+    ssize_t index = findPredictor(deviceId, source);
+    if (index < 0) {
+        Predictor predictor;
+        predictor.deviceId = deviceId;
+        predictor.source = source;
+        predictor.tracker = new VelocityTracker(
+                mPredictionConfigs.itemAt(configIndex).strategy.string());
+        predictor.configIndex = configIndex;
+        predictor.predictionTime = 0;
+        predictor.predictionIdBits.clear();
+        index = mPredictors.add(predictor);
+    }
+    Predictor& predictor = mPredictors.editItemAt(index);
+    const History* current = state.getHistory(0);
+
+    // Once the actual positions at the time of the last prediction are known,
+    // record how far off it was.
+    if (!predictor.predictionIdBits.isEmpty()
+            && current->eventTime >= predictor.predictionTime) {
+        const History* previous = state.historySize >= 2 ? state.getHistory(1) : NULL;
+        if (previous && previous->eventTime <= predictor.predictionTime
+                && current->eventTime > previous->eventTime) {
+            PredictionConfig& config = mPredictionConfigs.editItemAt(predictor.configIndex);
+            float alpha = float(predictor.predictionTime - previous->eventTime)
+                    / (current->eventTime - previous->eventTime);
+            BitSet32 idBits(predictor.predictionIdBits.value
+                    & current->idBits.value & previous->idBits.value);
+            while (!idBits.isEmpty()) {
+                uint32_t id = idBits.clearFirstMarkedBit();
+                const PointerCoords& previousCoords = previous->getPointerById(id);
+                const PointerCoords& currentCoords = current->getPointerById(id);
+                float error = hypotf(
+                        lerp(previousCoords.getX(), currentCoords.getX(), alpha)
+                                - predictor.predictionX[id],
+                        lerp(previousCoords.getY(), currentCoords.getY(), alpha)
+                                - predictor.predictionY[id]);
+                config.errorCount += 1;
+                config.totalError += error;
+                if (error > config.maxError) {
+                    config.maxError = error;
+                }
+            }
+        }
+        predictor.predictionIdBits.clear();
+    }
+
+    VelocityTracker::Position positions[MAX_POINTERS];
+    uint32_t count = 0;
+    for (BitSet32 idBits(current->idBits); !idBits.isEmpty(); ) {
+        const PointerCoords& coords = current->getPointerById(idBits.clearFirstMarkedBit());
+        positions[count].x = coords.getX();
+        positions[count].y = coords.getY();
+        count++;
+    }
+    predictor.tracker->addMovement(current->eventTime, current->idBits, positions);
+}
+
+bool InputConsumer::predictTouchState(TouchState& state, nsecs_t sampleTime,
+        MotionEvent* event) {
+    ssize_t index = findPredictor(event->getDeviceId(), event->getSource());
+    if (index < 0) {
+        return false;
+    }
+    Predictor& predictor = mPredictors.editItemAt(index);
+    const PredictionConfig& config = mPredictionConfigs.itemAt(predictor.configIndex);
+    const History* current = state.getHistory(0);
+
+    // Predict where the pointers will be when the frame is presented, but report the
+    // sample no later than extrapolation would, so that its time stays close to the
+    // time of the actual samples.
+    nsecs_t predictionTime = sampleTime + RESAMPLE_LATENCY + config.horizon;
+    nsecs_t resampleTime = min(sampleTime, current->eventTime + RESAMPLE_MAX_PREDICTION);
+
+    size_t pointerCount = event->getPointerCount();
+    float x[MAX_POINTERS], y[MAX_POINTERS];
+    for (size_t i = 0; i < pointerCount; i++) {
+        uint32_t id = event->getPointerId(i);
+        const PointerCoords& currentCoords = current->getPointerById(id);
+        int32_t toolType = event->getToolType(i);
+        if (!shouldResampleTool(toolType) && toolType != AMOTION_EVENT_TOOL_TYPE_STYLUS) {
+            x[i] = currentCoords.getX();
+            y[i] = currentCoords.getY();
+            continue;
+        }
+        VelocityTracker::Estimator estimator;
+        if (!predictor.tracker->getEstimator(id, &estimator) || estimator.degree < 1) {
+#if DEBUG_RESAMPLING
+            ALOGD("Not predicted, no estimate for id %d", id);
+#endif
+            return false;
+        }
+        float t = (predictionTime - estimator.time) * 0.000000001f;
+        float tn = 1;
+        x[i] = 0;
+        y[i] = 0;
+        for (uint32_t n = 0; n <= estimator.degree; n++) {
+            x[i] += estimator.xCoeff[n] * tn;
+            y[i] += estimator.yCoeff[n] * tn;
+            tn *= t;
+        }
+    }
+
+    state.lastResample.eventTime = resampleTime;
+    state.lastResample.idBits.clear();
+    predictor.predictionTime = predictionTime;
+    predictor.predictionIdBits.clear();
+    for (size_t i = 0; i < pointerCount; i++) {
+        uint32_t id = event->getPointerId(i);
+        state.lastResample.idToIndex[id] = i;
+        state.lastResample.idBits.markBit(id);
+        PointerCoords& resampledCoords = state.lastResample.pointers[i];
+        resampledCoords.copyFrom(current->getPointerById(id));
+        resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_X, x[i]);
+        resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_Y, y[i]);
+        predictor.predictionIdBits.markBit(id);
+        predictor.predictionX[id] = x[i];
+        predictor.predictionY[id] = y[i];
+#if DEBUG_RESAMPLING
+        ALOGD("[%d] - predicted (%0.3f, %0.3f) at %lld ns", id, x[i], y[i],
+                predictionTime - current->eventTime);
+#endif
+    }
+
+    event->addSample(resampleTime, state.lastResample.pointers);
+    return true;
+}
+
 bool InputConsumer::shouldResampleTool(int32_t toolType) {
     return toolType == AMOTION_EVENT_TOOL_TYPE_FINGER
             || toolType == AMOTION_EVENT_TOOL_TYPE_UNKNOWN;
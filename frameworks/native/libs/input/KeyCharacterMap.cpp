@@ -18,6 +18,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #ifdef __ANDROID__
 #include <binder/Parcel.h>
@@ -30,6 +31,7 @@
 
 #include <utils/Log.h>
 #include <utils/Errors.h>
+#include <utils/Mutex.h>
 #include <utils/Tokenizer.h>
 #include <utils/Timers.h>
 
@@ -106,10 +108,40 @@ KeyCharacterMap::~KeyCharacterMap() {
     }
 }
 
+// Maps loaded from files, reused while the file looks unchanged and is asked for in the
+// same format.  Loaded maps are immutable, and combine() copies rather than modifies them.
+struct CachedKeyCharacterMap {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    KeyCharacterMap::Format format;
+    sp<KeyCharacterMap> map;
+};
+
+static Mutex gCacheLock;
+static KeyedVector<String8, CachedKeyCharacterMap> gCache;
+
 status_t KeyCharacterMap::load(const String8& filename,
         Format format, sp<KeyCharacterMap>* outMap) {
     outMap->clear();
 
+    struct stat st;
+    bool cacheable = stat(filename.string(), &st) == 0;
+    if (cacheable) {
+        AutoMutex _l(gCacheLock);
+        ssize_t index = gCache.indexOfKey(filename);
+        if (index >= 0) {
+            const CachedKeyCharacterMap& cached = gCache.valueAt(index);
+            if (cached.dev == st.st_dev && cached.ino == st.st_ino
+                    && cached.size == st.st_size && cached.mtime == st.st_mtime
+                    && cached.format == format) {
+                *outMap = cached.map;
+                return OK;
+            }
+        }
+    }
+
     Tokenizer* tokenizer;
     status_t status = Tokenizer::open(filename, &tokenizer);
     if (status) {
@@ -117,6 +149,18 @@ status_t KeyCharacterMap::load(const String8& filename,
     } else {
         status = load(tokenizer, format, outMap);
         delete tokenizer;
+
+        if (!status && cacheable) {
+            CachedKeyCharacterMap cached;
+            cached.dev = st.st_dev;
+            cached.ino = st.st_ino;
+            cached.size = st.st_size;
+            cached.mtime = st.st_mtime;
+            cached.format = format;
+            cached.map = *outMap;
+            AutoMutex _l(gCacheLock);
+            gCache.replaceValueFor(filename, cached);
+        }
     }
     return status;
 }
@@ -17,6 +17,7 @@
 #define LOG_TAG "KeyLayoutMap"
 
 #include <stdlib.h>
+#include <sys/stat.h>
 
 #include <android/keycodes.h>
 #include <input/InputEventLabels.h>
@@ -24,6 +25,7 @@
 #include <input/KeyLayoutMap.h>
 #include <utils/Log.h>
 #include <utils/Errors.h>
+#include <utils/Mutex.h>
 #include <utils/Tokenizer.h>
 #include <utils/Timers.h>
 
@@ -41,6 +43,19 @@ namespace android {
 
 static const char* WHITESPACE = " \t\r";
 
+// Maps loaded from each file, so that devices sharing a layout don't each parse it again
+// when they are added.  An entry is only reused while the file looks unchanged.
+struct CachedKeyLayoutMap {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    sp<KeyLayoutMap> map;
+};
+
+static Mutex gCacheLock;
+static KeyedVector<String8, CachedKeyLayoutMap> gCache;
+
 // --- KeyLayoutMap ---
 
 KeyLayoutMap::KeyLayoutMap() {
@@ -52,6 +67,21 @@ KeyLayoutMap::~KeyLayoutMap() {
 status_t KeyLayoutMap::load(const String8& filename, sp<KeyLayoutMap>* outMap) {
     outMap->clear();
 
+    struct stat st;
+    bool cacheable = stat(filename.string(), &st) == 0;
+    if (cacheable) {
+        AutoMutex _l(gCacheLock);
+        ssize_t index = gCache.indexOfKey(filename);
+        if (index >= 0) {
+            const CachedKeyLayoutMap& cached = gCache.valueAt(index);
+            if (cached.dev == st.st_dev && cached.ino == st.st_ino
+                    && cached.size == st.st_size && cached.mtime == st.st_mtime) {
+                *outMap = cached.map;
+                return OK;
+            }
+        }
+    }
+
     Tokenizer* tokenizer;
     status_t status = Tokenizer::open(filename, &tokenizer);
     if (status) {
@@ -75,6 +105,17 @@ status_t KeyLayoutMap::load(const String8& filename, sp<KeyLayoutMap>* outMap) {
 #endif
             if (!status) {
                 *outMap = map;
+
+                if (cacheable) {
+                    CachedKeyLayoutMap cached;
+                    cached.dev = st.st_dev;
+                    cached.ino = st.st_ino;
+                    cached.size = st.st_size;
+                    cached.mtime = st.st_mtime;
+                    cached.map = map;
+                    AutoMutex _l(gCacheLock);
+                    gCache.replaceValueFor(filename, cached);
+                }
             }
         }
         delete tokenizer;
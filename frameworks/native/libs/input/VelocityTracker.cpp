@@ -432,18 +432,21 @@ void LeastSquaresVelocityTrackerStrategy::addMovement(nsecs_t eventTime, BitSet3
  * Finally we solve the system of linear equations given by R1 B = (Qtranspose W Y)
  * to find B.
  *
+ * The decomposition only depends on X and W, so when several vectors Y are fitted
+ * against the same X and W (as the x and y coordinates of a pointer are), it is done
+ * once and only the last step is repeated for each of them.
+ *
  * For efficiency, we lay out A and Q column-wise in memory because we frequently
  * operate on the column vectors.  Conversely, we lay out R row-wise.
  *
  * http://en.wikipedia.org/wiki/Numerical_methods_for_linear_least_squares
  * http://en.wikipedia.org/wiki/Gram-Schmidt
  */
-static bool solveLeastSquares(const float* x, const float* y,
-        const float* w, uint32_t m, uint32_t n, float* outB, float* outDet) {
+static bool solveLeastSquares(const float* x, const float* const* ys, uint32_t count,
+        const float* w, uint32_t m, uint32_t n, float* const* outBs, float* outDets) {
 #if DEBUG_STRATEGY
-    ALOGD("solveLeastSquares: m=%d, n=%d, x=%s, y=%s, w=%s", int(m), int(n),
-            vectorToString(x, m).c_str(), vectorToString(y, m).c_str(),
-            vectorToString(w, m).c_str());
+    ALOGD("solveLeastSquares: m=%d, n=%d, x=%s, w=%s", int(m), int(n),
+            vectorToString(x, m).c_str(), vectorToString(w, m).c_str());
 #endif
 
     // Expand the X vector to a matrix A, pre-multiplied by the weights.
@@ -506,53 +509,61 @@ static bool solveLeastSquares(const float* x, const float* y,
     ALOGD("  - qr=%s", matrixToString(&qr[0][0], m, n, false /*rowMajor*/).c_str());
 #endif
 
-    // Solve R B = Qt W Y to find B.  This is easy because R is upper triangular.
-    // We just work from bottom-right to top-left calculating B's coefficients.
-    float wy[m];
-    for (uint32_t h = 0; h < m; h++) {
-        wy[h] = y[h] * w[h];
-    }
-    for (uint32_t i = n; i != 0; ) {
-        i--;
-        outB[i] = vectorDot(&q[i][0], wy, m);
-        for (uint32_t j = n - 1; j > i; j--) {
-            outB[i] -= r[i][j] * outB[j];
+    for (uint32_t k = 0; k < count; k++) {
+        const float* y = ys[k];
+        float* outB = outBs[k];
+#if DEBUG_STRATEGY
+        ALOGD("  - y=%s", vectorToString(y, m).c_str());
+#endif
+
+        // Solve R B = Qt W Y to find B.  This is easy because R is upper triangular.
+        // We just work from bottom-right to top-left calculating B's coefficients.
+        float wy[m];
+        for (uint32_t h = 0; h < m; h++) {
+            wy[h] = y[h] * w[h];
+        }
+        for (uint32_t i = n; i != 0; ) {
+            i--;
+            outB[i] = vectorDot(&q[i][0], wy, m);
+            for (uint32_t j = n - 1; j > i; j--) {
+                outB[i] -= r[i][j] * outB[j];
+            }
+            outB[i] /= r[i][i];
         }
-        outB[i] /= r[i][i];
-    }
 #if DEBUG_STRATEGY
-    ALOGD("  - b=%s", vectorToString(outB, n).c_str());
+        ALOGD("  - b=%s", vectorToString(outB, n).c_str());
 #endif
 
-    // Calculate the coefficient of determination as 1 - (SSerr / SStot) where
-    // SSerr is the residual sum of squares (variance of the error),
-    // and SStot is the total sum of squares (variance of the data) where each
-    // has been weighted.
-    float ymean = 0;
-    for (uint32_t h = 0; h < m; h++) {
-        ymean += y[h];
-    }
-    ymean /= m;
+        // Calculate the coefficient of determination as 1 - (SSerr / SStot) where
+        // SSerr is the residual sum of squares (variance of the error),
+        // and SStot is the total sum of squares (variance of the data) where each
+        // has been weighted.
+        float ymean = 0;
+        for (uint32_t h = 0; h < m; h++) {
+            ymean += y[h];
+        }
+        ymean /= m;
 
-    float sserr = 0;
-    float sstot = 0;
-    for (uint32_t h = 0; h < m; h++) {
-        float err = y[h] - outB[0];
-        float term = 1;
-        for (uint32_t i = 1; i < n; i++) {
-            term *= x[h];
-            err -= term * outB[i];
+        float sserr = 0;
+        float sstot = 0;
+        for (uint32_t h = 0; h < m; h++) {
+            float err = y[h] - outB[0];
+            float term = 1;
+            for (uint32_t i = 1; i < n; i++) {
+                term *= x[h];
+                err -= term * outB[i];
+            }
+            sserr += w[h] * w[h] * err * err;
+            float var = y[h] - ymean;
+            sstot += w[h] * w[h] * var * var;
         }
-        sserr += w[h] * w[h] * err * err;
-        float var = y[h] - ymean;
-        sstot += w[h] * w[h] * var * var;
-    }
-    *outDet = sstot > 0.000001f ? 1.0f - (sserr / sstot) : 1;
+        outDets[k] = sstot > 0.000001f ? 1.0f - (sserr / sstot) : 1;
 #if DEBUG_STRATEGY
-    ALOGD("  - sserr=%f", sserr);
-    ALOGD("  - sstot=%f", sstot);
-    ALOGD("  - det=%f", *outDet);
+        ALOGD("  - sserr=%f", sserr);
+        ALOGD("  - sstot=%f", sstot);
+        ALOGD("  - det=%f", outDets[k]);
 #endif
+    }
     return true;
 }
 
@@ -597,13 +608,14 @@ bool LeastSquaresVelocityTrackerStrategy::getEstimator(uint32_t id,
         degree = m - 1;
     }
     if (degree >= 1) {
-        float xdet, ydet;
+        const float* ys[] = { x, y };
+        float* outBs[] = { outEstimator->xCoeff, outEstimator->yCoeff };
+        float dets[2];
         uint32_t n = degree + 1;
-        if (solveLeastSquares(time, x, w, m, n, outEstimator->xCoeff, &xdet)
-                && solveLeastSquares(time, y, w, m, n, outEstimator->yCoeff, &ydet)) {
+        if (solveLeastSquares(time, ys, 2, w, m, n, outBs, dets)) {
             outEstimator->time = newestMovement.eventTime;
             outEstimator->degree = degree;
-            outEstimator->confidence = xdet * ydet;
+            outEstimator->confidence = dets[0] * dets[1];
 #if DEBUG_STRATEGY
             ALOGD("estimate: degree=%d, xCoeff=%s, yCoeff=%s, confidence=%f",
                     int(outEstimator->degree),
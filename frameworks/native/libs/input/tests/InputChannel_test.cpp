@@ -155,5 +155,79 @@ TEST_F(InputChannelTest, SendSignal_WhenPeerClosed_ReturnsAnError) {
             << "sendMessage should have returned DEAD_OBJECT";
 }
 
+TEST_F(InputChannelTest, OpenSharedMemoryInputChannelPair_ExchangesMessagesInOrder) {
+    sp<InputChannel> serverChannel, clientChannel;
+
+    status_t result = InputChannel::openSharedMemoryInputChannelPair(String8("channel name"),
+            serverChannel, clientChannel);
+
+    ASSERT_EQ(OK, result)
+            << "should have successfully opened a channel pair";
+    EXPECT_GE(serverChannel->getRingFd(), 0)
+            << "server channel should have a ring region";
+    EXPECT_TRUE(serverChannel->isServer());
+    EXPECT_FALSE(clientChannel->isServer());
+
+    // Server->Client communication, until the ring is full
+    size_t sent = 0;
+    for (;;) {
+        InputMessage serverMsg;
+        memset(&serverMsg, 0, sizeof(InputMessage));
+        serverMsg.header.type = InputMessage::TYPE_KEY;
+        serverMsg.body.key.seq = sent + 1;
+        result = serverChannel->sendMessage(&serverMsg);
+        if (result != OK) {
+            break;
+        }
+        sent++;
+    }
+    EXPECT_EQ(WOULD_BLOCK, result)
+            << "sendMessage should have returned WOULD_BLOCK once the ring is full";
+    EXPECT_GT(sent, 1U);
+
+    for (size_t i = 0; i < sent; i++) {
+        InputMessage clientMsg;
+        ASSERT_EQ(OK, clientChannel->receiveMessage(&clientMsg))
+                << "client channel should be able to receive message from server channel";
+        EXPECT_EQ(InputMessage::TYPE_KEY, clientMsg.header.type);
+        EXPECT_EQ(i + 1, clientMsg.body.key.seq)
+                << "client channel should receive messages in order";
+    }
+    InputMessage msg;
+    EXPECT_EQ(WOULD_BLOCK, clientChannel->receiveMessage(&msg))
+            << "receiveMessage should have returned WOULD_BLOCK once the ring is empty";
+
+    // Client->Server communication
+    InputMessage clientReply;
+    memset(&clientReply, 0, sizeof(InputMessage));
+    clientReply.header.type = InputMessage::TYPE_FINISHED;
+    clientReply.body.finished.seq = 0x11223344;
+    clientReply.body.finished.handled = true;
+    EXPECT_EQ(OK, clientChannel->sendMessage(&clientReply))
+            << "client channel should be able to send message to server channel";
+
+    InputMessage serverReply;
+    EXPECT_EQ(OK, serverChannel->receiveMessage(&serverReply))
+            << "server channel should be able to receive message from client channel";
+    EXPECT_EQ(clientReply.body.finished.seq, serverReply.body.finished.seq)
+            << "server channel should receive the correct message from client channel";
+}
+
+TEST_F(InputChannelTest, SharedMemoryChannel_ReceiveWhenPeerClosed_ReturnsAnError) {
+    sp<InputChannel> serverChannel, clientChannel;
+
+    status_t result = InputChannel::openSharedMemoryInputChannelPair(String8("channel name"),
+            serverChannel, clientChannel);
+
+    ASSERT_EQ(OK, result)
+            << "should have successfully opened a channel pair";
+
+    serverChannel.clear(); // close server channel
+
+    InputMessage msg;
+    EXPECT_EQ(DEAD_OBJECT, clientChannel->receiveMessage(&msg))
+            << "receiveMessage should have returned DEAD_OBJECT";
+}
+
 
 } // namespace android
@@ -286,4 +286,18 @@ TEST_F(InputPublisherAndConsumerTest, PublishMultipleEvents_EndToEnd) {
     ASSERT_NO_FATAL_FAILURE(PublishAndConsumeKeyEvent());
 }
 
+TEST_F(InputPublisherAndConsumerTest, SetMotionPrediction_KeepsStatsWhenDisabled) {
+    InputConsumer::MotionPredictionStats stats;
+    EXPECT_FALSE(mConsumer->getMotionPredictionStats(7, AINPUT_SOURCE_TOUCHSCREEN, &stats));
+
+    mConsumer->setMotionPrediction(7, AINPUT_SOURCE_TOUCHSCREEN, "lsq2", 10 * 1000000LL);
+    ASSERT_TRUE(mConsumer->getMotionPredictionStats(7, AINPUT_SOURCE_TOUCHSCREEN, &stats));
+    EXPECT_EQ(0U, stats.count);
+    EXPECT_EQ(0, stats.meanError);
+
+    mConsumer->setMotionPrediction(7, AINPUT_SOURCE_TOUCHSCREEN, "lsq2", 0);
+    EXPECT_TRUE(mConsumer->getMotionPredictionStats(7, AINPUT_SOURCE_TOUCHSCREEN, &stats));
+    EXPECT_FALSE(mConsumer->getMotionPredictionStats(8, AINPUT_SOURCE_TOUCHSCREEN, &stats));
+}
+
 } // namespace android
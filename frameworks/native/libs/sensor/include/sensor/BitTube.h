@@ -22,6 +22,8 @@
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
 
+struct iovec;
+
 namespace android {
 // ----------------------------------------------------------------------------
 class Parcel;
@@ -55,6 +57,11 @@ public:
         return sendObjects(tube, events, count, sizeof(T));
     }
 
+    // send objects (sized blobs) gathered from several buffers as a single message, without
+    // first copying them together. All objects are guaranteed to be written or the call fails.
+    static ssize_t sendObjects(const sp<BitTube>& tube,
+            const struct iovec* iov, int iovcnt, size_t objSize);
+
     // receive objects (sized blobs). If the receiving buffer isn't large enough,
     // excess messages are silently discarded.
     template <typename T>
@@ -71,6 +78,7 @@ private:
 
     // send a message. The write is guaranteed to send the whole message or fail.
     ssize_t write(void const* vaddr, size_t size);
+    ssize_t write(const struct iovec* iov, int iovcnt);
 
     // receive a message. the passed buffer must be at least as large as the
     // write call used to send the message, excess data is silently discarded.
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define LOG_TAG "FenceMonitor"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+//#define LOG_NDEBUG 0
+
+#include <ui/FenceMonitor.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <utils/Log.h>
+#include <utils/Trace.h>
+
+namespace android {
+
+ANDROID_SINGLETON_STATIC_INSTANCE(FenceMonitor)
+
+constexpr size_t FenceMonitor::MAX_FENCES;
+
+// How often FenceMonitor drops the fences whose FenceTimes are gone
+static constexpr nsecs_t REMOVE_EXPIRED_INTERVAL = ms2ns(1000);
+static constexpr int MAX_EVENTS = 32;
+
+FenceMonitor::FenceMonitor()
+  : mEpollFd(epoll_create1(EPOLL_CLOEXEC)),
+    mEventFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+    if (mEpollFd < 0 || mEventFd < 0) {
+        ALOGE("Failed to create the epoll set: %s (%d)", strerror(errno), errno);
+        return;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = mEventFd;
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mEventFd, &event) != 0) {
+        ALOGE("Failed to watch the event fd: %s (%d)", strerror(errno), errno);
+        return;
+    }
+
+    mThread = std::thread(&FenceMonitor::threadMain, this);
+}
+
+FenceMonitor::~FenceMonitor() {
+    if (mThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mExit = true;
+        }
+        uint64_t value = 1;
+        if (write(mEventFd, &value, sizeof(value)) < 0) {
+            ALOGE("Failed to wake the monitor thread: %s (%d)", strerror(errno), errno);
+        }
+        mThread.join();
+    }
+
+    for (const auto& watched : mWatched) {
+        close(watched.first);
+    }
+    if (mEventFd >= 0) {
+        close(mEventFd);
+    }
+    if (mEpollFd >= 0) {
+        close(mEpollFd);
+    }
+}
+
+void FenceMonitor::monitor(const std::shared_ptr<FenceTime>& fence) {
+    if (!mThread.joinable() || fence == nullptr || !fence->isValid() ||
+            fence->getCachedSignalTime() != Fence::SIGNAL_TIME_PENDING) {
+        return;
+    }
+
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPending.push_back(fence);
+        if (!mWakeRequested) {
+            mWakeRequested = true;
+            wake = true;
+        }
+    }
+    if (wake) {
+        uint64_t value = 1;
+        if (write(mEventFd, &value, sizeof(value)) < 0) {
+            ALOGE("Failed to wake the monitor thread: %s (%d)", strerror(errno), errno);
+        }
+    }
+}
+
+void FenceMonitor::threadMain() {
+    epoll_event events[MAX_EVENTS];
+    nsecs_t lastRemoveExpiredTime = systemTime();
+    while (true) {
+        int count = epoll_wait(mEpollFd, events, MAX_EVENTS,
+                static_cast<int>(ns2ms(REMOVE_EXPIRED_INTERVAL)));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ALOGE("epoll_wait failed: %s (%d)", strerror(errno), errno);
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            const int fd = events[i].data.fd;
+            if (fd == mEventFd) {
+                // Only resets the counter, the pending fences are read below
+                uint64_t value;
+                if (read(mEventFd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                    ALOGE("Failed to read the event fd: %s (%d)", strerror(errno), errno);
+                }
+            } else {
+                onFenceSignaled(fd);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mExit) {
+                return;
+            }
+        }
+        watchPendingFences();
+
+        const nsecs_t now = systemTime();
+        if (now - lastRemoveExpiredTime >= REMOVE_EXPIRED_INTERVAL) {
+            removeExpiredFences();
+            lastRemoveExpiredTime = now;
+        }
+    }
+}
+
+void FenceMonitor::watchPendingFences() {
+    std::vector<std::weak_ptr<FenceTime>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        pending.swap(mPending);
+        mWakeRequested = false;
+    }
+
+    for (const auto& weakFence : pending) {
+        std::shared_ptr<FenceTime> fence = weakFence.lock();
+        if (fence == nullptr || mWatched.size() >= MAX_FENCES) {
+            continue;
+        }
+
+        int fd = -1;
+        {
+            std::lock_guard<std::mutex> lock(fence->mMutex);
+            if (fence->mFence.get() != nullptr) {
+                fd = fence->mFence->dup();
+            }
+        }
+        if (fd < 0) {
+            // Already signaled, or not a real fence
+            continue;
+        }
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            ALOGV("Failed to watch fence fd %d: %s (%d)", fd, strerror(errno), errno);
+            close(fd);
+            continue;
+        }
+        fence->mMonitored.store(true, std::memory_order_relaxed);
+        mWatched[fd] = fence;
+    }
+}
+
+void FenceMonitor::onFenceSignaled(int fd) {
+    ATRACE_CALL();
+    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+
+    auto watched = mWatched.find(fd);
+    if (watched != mWatched.end()) {
+        std::shared_ptr<FenceTime> fence = watched->second.lock();
+        if (fence != nullptr) {
+            fence->querySignalTime();
+            // If the fence reported an error instead, whoever polls it next
+            // queries it again
+            fence->mMonitored.store(false, std::memory_order_relaxed);
+        }
+        mWatched.erase(watched);
+    }
+    close(fd);
+}
+
+void FenceMonitor::removeExpiredFences() {
+    for (auto watched = mWatched.begin(); watched != mWatched.end();) {
+        if (watched->second.expired()) {
+            epoll_ctl(mEpollFd, EPOLL_CTL_DEL, watched->first, nullptr);
+            close(watched->first);
+            watched = mWatched.erase(watched);
+        } else {
+            ++watched;
+        }
+    }
+}
+
+}; // namespace android
@@ -15,6 +15,7 @@
 */
 
 #include <ui/FenceTime.h>
+#include <ui/FenceMonitor.h>
 
 #define LOG_TAG "FenceTime"
 
@@ -116,6 +117,20 @@ nsecs_t FenceTime::getSignalTime() {
         return signalTime;
     }
 
+    // The FenceMonitor sets the signal time once the fence signals.
+    if (mMonitored.load(std::memory_order_relaxed)) {
+        return Fence::SIGNAL_TIME_PENDING;
+    }
+
+    return querySignalTime();
+}
+
+nsecs_t FenceTime::querySignalTime() {
+    nsecs_t signalTime = mSignalTime.load(std::memory_order_relaxed);
+    if (signalTime != Fence::SIGNAL_TIME_PENDING) {
+        return signalTime;
+    }
+
     // Hold a reference to the fence on the stack in case the class'
     // reference is removed by another thread. This prevents the
     // fence from being destroyed until the end of this method, where
@@ -271,8 +286,16 @@ status_t FenceTime::Snapshot::unflatten(
 // ============================================================================
 // FenceTimeline
 // ============================================================================
+void FenceTimeline::setMonitored(bool monitored) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMonitored = monitored;
+}
+
 void FenceTimeline::push(const std::shared_ptr<FenceTime>& fence) {
     std::lock_guard<std::mutex> lock(mMutex);
+    if (mMonitored) {
+        FenceMonitor::getInstance().monitor(fence);
+    }
     while (mQueue.size() >= MAX_ENTRIES) {
         // This is a sanity check to make sure the queue doesn't grow unbounded.
         // MAX_ENTRIES should be big enough not to trigger this path.
@@ -69,6 +69,14 @@ status_t GraphicBufferMapper::freeBuffer(buffer_handle_t handle)
 {
     ATRACE_CALL();
 
+    {
+        // The handle may be reused by another buffer.
+        Mutex::Autolock _l(mLockedBuffersLock);
+        ALOGW_IF(mLockedBuffers.indexOfKey(handle) >= 0,
+                "freeBuffer(%p): buffer is still locked", handle);
+        mLockedBuffers.removeItem(handle);
+    }
+
     mMapper->freeBuffer(handle);
 
     return NO_ERROR;
@@ -83,6 +91,62 @@ static inline Gralloc2::IMapper::Rect asGralloc2Rect(const Rect& rect) {
     return outRect;
 }
 
+bool GraphicBufferMapper::lockFromCache(buffer_handle_t handle,
+        uint64_t usage, const Rect& bounds, bool isYCbCr, void** vaddr,
+        android_ycbcr* ycbcr, int fenceFd)
+{
+    {
+        Mutex::Autolock _l(mLockedBuffersLock);
+        ssize_t index = mLockedBuffers.indexOfKey(handle);
+        if (index < 0) {
+            return false;
+        }
+        LockedBuffer& locked(mLockedBuffers.editValueAt(index));
+        if (locked.isYCbCr != isYCbCr || (usage & ~locked.usage) != 0 ||
+                locked.bounds.left > bounds.left ||
+                locked.bounds.top > bounds.top ||
+                locked.bounds.right < bounds.right ||
+                locked.bounds.bottom < bounds.bottom) {
+            return false;
+        }
+        locked.lockCount++;
+        if (isYCbCr) {
+            *ycbcr = locked.ycbcr;
+        } else {
+            *vaddr = locked.vaddr;
+        }
+    }
+
+    // The HAL would wait for the acquire fence before returning.
+    if (fenceFd >= 0) {
+        sync_wait(fenceFd, -1);
+        close(fenceFd);
+    }
+    return true;
+}
+
+void GraphicBufferMapper::addLock(buffer_handle_t handle, uint64_t usage,
+        const Rect& bounds, bool isYCbCr, void* vaddr,
+        const android_ycbcr* ycbcr)
+{
+    Mutex::Autolock _l(mLockedBuffersLock);
+    ssize_t index = mLockedBuffers.indexOfKey(handle);
+    if (index < 0) {
+        LockedBuffer locked{};
+        locked.usage = usage;
+        locked.bounds = bounds;
+        locked.isYCbCr = isYCbCr;
+        locked.vaddr = vaddr;
+        if (ycbcr) {
+            locked.ycbcr = *ycbcr;
+        }
+        index = mLockedBuffers.add(handle, locked);
+    }
+    LockedBuffer& locked(mLockedBuffers.editValueAt(index));
+    locked.lockCount++;
+    locked.halLockCount++;
+}
+
 status_t GraphicBufferMapper::lock(buffer_handle_t handle, uint32_t usage,
         const Rect& bounds, void** vaddr)
 {
@@ -120,11 +184,19 @@ status_t GraphicBufferMapper::lockAsync(buffer_handle_t handle,
 
     const uint64_t usage = static_cast<uint64_t>(
             android_convertGralloc1To0Usage(producerUsage, consumerUsage));
+    if (lockFromCache(handle, usage, bounds, false, vaddr, nullptr,
+            fenceFd)) {
+        return NO_ERROR;
+    }
+
     Gralloc2::Error error = mMapper->lock(handle, usage,
             asGralloc2Rect(bounds), fenceFd, vaddr);
 
     ALOGW_IF(error != Gralloc2::Error::NONE, "lock(%p, ...) failed: %d",
             handle, error);
+    if (error == Gralloc2::Error::NONE) {
+        addLock(handle, usage, bounds, false, *vaddr, nullptr);
+    }
 
     return static_cast<status_t>(error);
 }
@@ -157,6 +229,10 @@ status_t GraphicBufferMapper::lockAsyncYCbCr(buffer_handle_t handle,
 {
     ATRACE_CALL();
 
+    if (lockFromCache(handle, usage, bounds, true, nullptr, ycbcr, fenceFd)) {
+        return NO_ERROR;
+    }
+
     Gralloc2::YCbCrLayout layout;
     Gralloc2::Error error = mMapper->lock(handle, usage,
             asGralloc2Rect(bounds), fenceFd, &layout);
@@ -167,6 +243,7 @@ status_t GraphicBufferMapper::lockAsyncYCbCr(buffer_handle_t handle,
         ycbcr->ystride = static_cast<size_t>(layout.yStride);
         ycbcr->cstride = static_cast<size_t>(layout.cStride);
         ycbcr->chroma_step = static_cast<size_t>(layout.chromaStep);
+        addLock(handle, usage, bounds, true, nullptr, ycbcr);
     }
 
     return static_cast<status_t>(error);
@@ -176,10 +253,75 @@ status_t GraphicBufferMapper::unlockAsync(buffer_handle_t handle, int *fenceFd)
 {
     ATRACE_CALL();
 
+    {
+        Mutex::Autolock _l(mLockedBuffersLock);
+        ssize_t index = mLockedBuffers.indexOfKey(handle);
+        if (index >= 0) {
+            LockedBuffer& locked(mLockedBuffers.editValueAt(index));
+            bool fromCache = locked.lockCount > locked.halLockCount;
+            locked.lockCount--;
+            if (fromCache) {
+                *fenceFd = -1;
+                return NO_ERROR;
+            }
+            locked.halLockCount--;
+            if (locked.lockCount == 0) {
+                mLockedBuffers.removeItemsAt(index);
+            }
+        }
+    }
+
     *fenceFd = mMapper->unlock(handle);
 
     return NO_ERROR;
 }
 
+status_t GraphicBufferMapper::lockMultipleAsync(size_t count,
+        const buffer_handle_t* handles, uint64_t producerUsage,
+        uint64_t consumerUsage, const Rect& bounds, void** outVaddrs,
+        const int* fenceFds)
+{
+    ATRACE_CALL();
+
+    for (size_t i = 0; i < count; i++) {
+        int fenceFd = fenceFds ? fenceFds[i] : -1;
+        status_t error = lockAsync(handles[i], producerUsage, consumerUsage,
+                bounds, &outVaddrs[i], fenceFd);
+        if (error != NO_ERROR) {
+            for (size_t j = i + 1; fenceFds && j < count; j++) {
+                if (fenceFds[j] >= 0) {
+                    close(fenceFds[j]);
+                }
+            }
+            for (size_t j = 0; j < i; j++) {
+                int releaseFence = -1;
+                unlockAsync(handles[j], &releaseFence);
+                if (releaseFence >= 0) {
+                    close(releaseFence);
+                }
+            }
+            return error;
+        }
+    }
+
+    return NO_ERROR;
+}
+
+status_t GraphicBufferMapper::unlockMultipleAsync(size_t count,
+        const buffer_handle_t* handles, int* outFenceFds)
+{
+    ATRACE_CALL();
+
+    status_t result = NO_ERROR;
+    for (size_t i = 0; i < count; i++) {
+        status_t error = unlockAsync(handles[i], &outFenceFds[i]);
+        if (result == NO_ERROR) {
+            result = error;
+        }
+    }
+
+    return result;
+}
+
 // ---------------------------------------------------------------------------
 }; // namespace android
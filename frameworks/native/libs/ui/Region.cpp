@@ -271,6 +271,25 @@ bool Region::isTriviallyEqual(const Region& region) const {
     return begin() == region.begin();
 }
 
+bool Region::hasSameRects(const Region& region) const {
+    if (isTriviallyEqual(region)) {
+        return true;
+    }
+    size_t count = 0;
+    size_t otherCount = 0;
+    Rect const* rects = getArray(&count);
+    Rect const* otherRects = region.getArray(&otherCount);
+    if (count != otherCount) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (rects[i] != otherRects[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // ----------------------------------------------------------------------------
 
 void Region::addRectUnchecked(int l, int t, int r, int b)
@@ -424,9 +443,13 @@ class Region::rasterizer : public region_operator<Rect>::region_rasterizer
     Vector<Rect> span;
     Rect* cur;
 public:
-    explicit rasterizer(Region& reg)
+    // capacityHint is the expected number of rects of the result, reserving
+    // it up front avoids growing the storage one span at a time
+    rasterizer(Region& reg, size_t capacityHint)
         : bounds(INT_MAX, 0, INT_MIN, 0), storage(reg.mStorage), head(), tail(), cur() {
         storage.clear();
+        storage.setCapacity(capacityHint + 1);
+        span.setCapacity(capacityHint);
     }
 
     virtual ~rasterizer();
@@ -583,6 +606,76 @@ bool Region::validate(const Region& reg, const char* name, bool silent)
     return result;
 }
 
+static inline bool containsRect(const Rect& outer, const Rect& inner) {
+    return outer.left <= inner.left && outer.top <= inner.top &&
+            outer.right >= inner.right && outer.bottom >= inner.bottom;
+}
+
+bool Region::trivial_operation(uint32_t op, Region& dst,
+        const Region& lhs, const Region* rhs, const Rect& rhsRect)
+{
+    const Rect lhsBounds(lhs.getBounds());
+    const Rect rhsBounds(rhs ? rhs->getBounds() : rhsRect);
+    // INVALID_RECT is used as a signal value, let the rasterizer deal with it
+    if (!lhsBounds.isValid() || !rhsBounds.isValid()) {
+        return false;
+    }
+
+    const bool lhsIsRect = lhs.isRect();
+    const bool rhsIsRect = !rhs || rhs->isRect();
+    Rect intersection;
+    const bool overlap = lhsBounds.intersect(rhsBounds, &intersection);
+
+    // the rhs is copied last as it may alias dst
+    switch (op) {
+        case op_and:
+            if (!overlap) {
+                dst.clear();
+            } else if (lhsIsRect && rhsIsRect) {
+                dst.set(intersection);
+            } else if (rhsIsRect && containsRect(rhsBounds, lhsBounds)) {
+                dst = lhs;
+            } else if (lhsIsRect && containsRect(lhsBounds, rhsBounds)) {
+                if (rhs) dst = *rhs; else dst.set(rhsRect);
+            } else {
+                return false;
+            }
+            return true;
+        case op_or:
+            if (rhsBounds.isEmpty()) {
+                dst = lhs;
+            } else if (lhsBounds.isEmpty()) {
+                if (rhs) dst = *rhs; else dst.set(rhsRect);
+            } else if (rhsIsRect && containsRect(rhsBounds, lhsBounds)) {
+                dst.set(rhsBounds);
+            } else if (lhsIsRect && containsRect(lhsBounds, rhsBounds)) {
+                dst = lhs;
+            } else {
+                return false;
+            }
+            return true;
+        case op_nand:
+            if (!overlap) {
+                dst = lhs;
+            } else if (rhsIsRect && containsRect(rhsBounds, lhsBounds)) {
+                dst.clear();
+            } else {
+                return false;
+            }
+            return true;
+        case op_xor:
+            if (rhsBounds.isEmpty()) {
+                dst = lhs;
+            } else if (lhsBounds.isEmpty()) {
+                if (rhs) dst = *rhs; else dst.set(rhsRect);
+            } else {
+                return false;
+            }
+            return true;
+    }
+    return false;
+}
+
 void Region::boolean_operation(uint32_t op, Region& dst,
         const Region& lhs,
         const Region& rhs, int dx, int dy)
@@ -593,6 +686,12 @@ void Region::boolean_operation(uint32_t op, Region& dst,
     validate(dst, "boolean_operation (before): dst");
 #endif
 
+#if !VALIDATE_WITH_CORECG
+    if (!dx && !dy && trivial_operation(op, dst, lhs, &rhs, Rect())) {
+        return;
+    }
+#endif
+
     size_t lhs_count;
     Rect const * const lhs_rects = lhs.getArray(&lhs_count);
 
@@ -603,7 +702,7 @@ void Region::boolean_operation(uint32_t op, Region& dst,
     region_operator<Rect>::region rhs_region(rhs_rects, rhs_count, dx, dy);
     region_operator<Rect> operation(op, lhs_region, rhs_region);
     { // scope for rasterizer (dtor has side effects)
-        rasterizer r(dst);
+        rasterizer r(dst, lhs_count + rhs_count);
         operation(r);
     }
 
@@ -708,6 +807,12 @@ void Region::boolean_operation(uint32_t op, Region& dst,
 #if VALIDATE_WITH_CORECG || VALIDATE_REGIONS
     boolean_operation(op, dst, lhs, Region(rhs), dx, dy);
 #else
+    Rect translated(rhs);
+    translated.offsetBy(dx, dy);
+    if (trivial_operation(op, dst, lhs, nullptr, translated)) {
+        return;
+    }
+
     size_t lhs_count;
     Rect const * const lhs_rects = lhs.getArray(&lhs_count);
 
@@ -715,7 +820,7 @@ void Region::boolean_operation(uint32_t op, Region& dst,
     region_operator<Rect>::region rhs_region(&rhs, 1, dx, dy);
     region_operator<Rect> operation(op, lhs_region, rhs_region);
     { // scope for rasterizer (dtor has side effects)
-        rasterizer r(dst);
+        rasterizer r(dst, lhs_count + 1);
         operation(r);
     }
 
@@ -22,6 +22,9 @@
 
 #include <memory>
 
+#include <ui/Rect.h>
+#include <utils/KeyedVector.h>
+#include <utils/Mutex.h>
 #include <utils/Singleton.h>
 
 
@@ -38,8 +41,6 @@ namespace Gralloc2 {
 class Mapper;
 }
 
-class Rect;
-
 class GraphicBufferMapper : public Singleton<GraphicBufferMapper>
 {
 public:
@@ -74,6 +75,20 @@ public:
 
     status_t unlockAsync(buffer_handle_t handle, int *fenceFd);
 
+    // Locks count buffers with the same usage and bounds. fenceFds may be
+    // null; otherwise the ownership of each fence is transferred to the
+    // callee, even on errors. If any buffer fails to lock, the buffers
+    // already locked are unlocked again and the error is returned.
+    status_t lockMultipleAsync(size_t count, const buffer_handle_t* handles,
+            uint64_t producerUsage, uint64_t consumerUsage, const Rect& bounds,
+            void** outVaddrs, const int* fenceFds);
+
+    // Unlocks count buffers, returning a release fence (or -1) for each in
+    // outFenceFds. The first error is returned, but every buffer is
+    // unlocked.
+    status_t unlockMultipleAsync(size_t count, const buffer_handle_t* handles,
+            int* outFenceFds);
+
     const Gralloc2::Mapper& getGrallocMapper() const
     {
         return *mMapper;
@@ -84,7 +99,32 @@ private:
 
     GraphicBufferMapper();
 
+    // A buffer locked through this mapper. Locking it again, for usage and
+    // bounds that the existing lock covers, reuses its mapping instead of
+    // going through the HAL; that lock is released without the HAL as well,
+    // and the HAL unlock, which flushes CPU caches, is done by the last
+    // unlock of the buffer.
+    struct LockedBuffer {
+        uint64_t usage;
+        Rect bounds;
+        bool isYCbCr;
+        void* vaddr;
+        android_ycbcr ycbcr;
+        // Locks held, and how many of them went through the HAL.
+        uint32_t lockCount;
+        uint32_t halLockCount;
+    };
+
+    bool lockFromCache(buffer_handle_t handle, uint64_t usage,
+            const Rect& bounds, bool isYCbCr, void** vaddr,
+            android_ycbcr* ycbcr, int fenceFd);
+    void addLock(buffer_handle_t handle, uint64_t usage, const Rect& bounds,
+            bool isYCbCr, void* vaddr, const android_ycbcr* ycbcr);
+
     const std::unique_ptr<const Gralloc2::Mapper> mMapper;
+
+    Mutex mLockedBuffersLock;
+    KeyedVector<buffer_handle_t, LockedBuffer> mLockedBuffers;
 };
 
 // ---------------------------------------------------------------------------
@@ -116,6 +116,9 @@ public:
     // returns true if the regions share the same underlying storage
     bool isTriviallyEqual(const Region& region) const;
 
+    // returns true if the regions consist of the same rects
+    bool hasSameRects(const Region& region) const;
+
 
     /* various ways to access the rectangle list */
 
@@ -164,6 +167,12 @@ private:
     static void boolean_operation(uint32_t op, Region& dst,
             const Region& lhs, const Rect& rhs);
 
+    // Computes the operations whose result is empty, a single rect or one of
+    // the operands without going through the rasterizer. rhs is nullptr when
+    // the rhs operand is rhsRect. Returns false if the operation isn't trivial.
+    static bool trivial_operation(uint32_t op, Region& dst,
+            const Region& lhs, const Region* rhs, const Rect& rhsRect);
+
     static void translate(Region& reg, int dx, int dy);
     static void translate(Region& dst, const Region& reg, int dx, int dy);
 
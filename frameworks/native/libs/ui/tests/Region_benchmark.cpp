@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <ui/Region.h>
+#include <ui/Rect.h>
+#include <benchmark/benchmark.h>
+
+namespace android {
+
+// Roughly the shape of a layer's visible region: a rect with a few opaque
+// windows above it punched out
+static Region makeVisibleRegion() {
+    Region r(Rect(0, 0, 1440, 2560));
+    r.subtractSelf(Rect(0, 0, 1440, 84));
+    r.subtractSelf(Rect(100, 600, 1340, 1800));
+    r.subtractSelf(Rect(0, 2392, 1440, 2560));
+    return r;
+}
+
+static Region makeRandomRegion(int count) {
+    srandom(12345);
+    Region r;
+    for (int i = 0; i < count; i++) {
+        const int x = random() % 1400;
+        const int y = random() % 2500;
+        r.orSelf(Rect(x, y, x + 40 + random() % 200, y + 40 + random() % 200));
+    }
+    return r;
+}
+
+static void BM_Region_rectOrRect(benchmark::State& state) {
+    const Rect lhs(0, 0, 1440, 2560);
+    const Rect rhs(100, 100, 200, 200);
+    while (state.KeepRunning()) {
+        Region r(lhs);
+        r.orSelf(rhs);
+        benchmark::DoNotOptimize(r.begin());
+    }
+}
+BENCHMARK(BM_Region_rectOrRect);
+
+static void BM_Region_rectAndRect(benchmark::State& state) {
+    const Rect lhs(0, 0, 1440, 2560);
+    const Rect rhs(100, 100, 2000, 200);
+    while (state.KeepRunning()) {
+        Region r(lhs);
+        r.andSelf(rhs);
+        benchmark::DoNotOptimize(r.begin());
+    }
+}
+BENCHMARK(BM_Region_rectAndRect);
+
+static void BM_Region_disjointSubtract(benchmark::State& state) {
+    const Region lhs(makeVisibleRegion());
+    const Region rhs(Rect(2000, 2000, 2100, 2100));
+    while (state.KeepRunning()) {
+        Region r(lhs.subtract(rhs));
+        benchmark::DoNotOptimize(r.begin());
+    }
+}
+BENCHMARK(BM_Region_disjointSubtract);
+
+static void BM_Region_regionAndRect(benchmark::State& state) {
+    const Region lhs(makeVisibleRegion());
+    const Rect rhs(0, 500, 1440, 1000);
+    while (state.KeepRunning()) {
+        Region r(lhs.intersect(rhs));
+        benchmark::DoNotOptimize(r.begin());
+    }
+}
+BENCHMARK(BM_Region_regionAndRect);
+
+static void BM_Region_regionSubtractRegion(benchmark::State& state) {
+    const Region lhs(makeRandomRegion(state.range(0)));
+    const Region rhs(makeVisibleRegion());
+    while (state.KeepRunning()) {
+        Region r(lhs.subtract(rhs));
+        benchmark::DoNotOptimize(r.begin());
+    }
+}
+BENCHMARK(BM_Region_regionSubtractRegion)->Arg(4)->Arg(16)->Arg(64);
+
+static void BM_Region_accumulate(benchmark::State& state) {
+    const int count = state.range(0);
+    while (state.KeepRunning()) {
+        srandom(12345);
+        Region r;
+        for (int i = 0; i < count; i++) {
+            const int x = random() % 1400;
+            const int y = random() % 2500;
+            r.orSelf(Rect(x, y, x + 100, y + 100));
+        }
+        benchmark::DoNotOptimize(r.begin());
+    }
+}
+BENCHMARK(BM_Region_accumulate)->Arg(4)->Arg(16)->Arg(64);
+
+}; // namespace android
+
+BENCHMARK_MAIN();
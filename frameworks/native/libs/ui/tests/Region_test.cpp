@@ -152,5 +152,76 @@ TEST_F(RegionTest, Random_TJunction) {
     }
 }
 
+static Region randomRegion(int maxX, int maxY) {
+    Region r;
+    for (int i = 0; i < maxX; i++) {
+        for (int j = 0; j < maxY; j++) {
+            if (random() % 2) {
+                r.orSelf(Rect(i, j, i + 1, j + 1));
+            }
+        }
+    }
+    return r;
+}
+
+static void expectPixels(const Region& lhs, const Region& rhs, const Region& result,
+        bool (*op)(bool, bool)) {
+    for (int x = -1; x <= X_MAX; x++) {
+        for (int y = -1; y <= Y_MAX; y++) {
+            EXPECT_EQ(op(lhs.contains(x, y), rhs.contains(x, y)), result.contains(x, y))
+                    << "at " << x << "," << y;
+        }
+    }
+}
+
+TEST_F(RegionTest, Random_BooleanOperations) {
+    srandom(12345);
+
+    for (int iter = 0; iter < ITER_MAX / 10; iter++) {
+        Region lhs = randomRegion(X_MAX, Y_MAX);
+        Region rhs = randomRegion(X_MAX / 2, Y_MAX / 2);
+        expectPixels(lhs, rhs, lhs | rhs, [](bool a, bool b) { return a || b; });
+        expectPixels(lhs, rhs, lhs & rhs, [](bool a, bool b) { return a && b; });
+        expectPixels(lhs, rhs, lhs - rhs, [](bool a, bool b) { return a && !b; });
+        expectPixels(lhs, rhs, lhs ^ rhs, [](bool a, bool b) { return a != b; });
+    }
+}
+
+TEST_F(RegionTest, TrivialOperations) {
+    const Rect rect(0, 0, 4, 4);
+    const Rect inner(1, 1, 3, 3);
+    const Rect outside(10, 10, 12, 12);
+    Region region(Rect(0, 0, 2, 2));
+    region.orSelf(Rect(2, 2, 4, 4));
+
+    // rect vs rect
+    EXPECT_EQ(inner, Region(rect).intersect(Rect(1, 1, 10, 3)).intersect(inner).getBounds());
+    EXPECT_TRUE(Region(rect).intersect(outside).isEmpty());
+    EXPECT_TRUE(Region(inner).subtract(rect).isEmpty());
+    EXPECT_TRUE(Region(rect).merge(inner).isRect());
+    EXPECT_EQ(rect, Region(rect).merge(inner).getBounds());
+
+    // rect vs region
+    EXPECT_TRUE(region.intersect(rect).isTriviallyEqual(region));
+    EXPECT_TRUE(region.subtract(outside).isTriviallyEqual(region));
+    EXPECT_TRUE(region.subtract(rect).isEmpty());
+    EXPECT_TRUE(Region(rect).intersect(region).isTriviallyEqual(region));
+    EXPECT_TRUE(Region(rect).merge(region).isRect());
+    EXPECT_TRUE(Region().merge(region).isTriviallyEqual(region));
+    EXPECT_TRUE(region.mergeExclusive(Region()).isTriviallyEqual(region));
+
+    // operations on self
+    Region self(region);
+    self.orSelf(self);
+    EXPECT_TRUE((self ^ region).isEmpty());
+    self.andSelf(self);
+    EXPECT_TRUE((self ^ region).isEmpty());
+
+    // the invalid signal value isn't treated as an empty region
+    Region invalid(Region::INVALID_REGION);
+    invalid.orSelf(Region());
+    EXPECT_FALSE(invalid.isTriviallyEqual(Region::INVALID_REGION));
+}
+
 }; // namespace android
 
@@ -32,9 +32,9 @@ class BufferHubQueue : public pdx::Client {
   // a new consumer queue client or nullptr on failure.
   std::unique_ptr<ConsumerQueue> CreateConsumerQueue();
 
-  // Creates a new consumer queue that is attached to the producer. This queue
-  // sets each of its imported consumer buffers to the ignored state to avoid
-  // participation in lifecycle events.
+  // Creates a new consumer queue that is attached to the producer. BufferHub
+  // creates each of its consumer buffers in the ignored state, so that the
+  // queue doesn't participate in lifecycle events.
   std::unique_ptr<ConsumerQueue> CreateSilentConsumerQueue();
 
   // Returns whether the buffer queue is in async mode.
@@ -50,7 +50,9 @@ class BufferHubQueue : public pdx::Client {
   uint32_t default_format() const { return default_format_; }
 
   // Creates a new consumer in handle form for immediate transport over RPC.
-  pdx::Status<pdx::LocalChannelHandle> CreateConsumerQueueHandle();
+  // The consumer buffers of a |silent| queue are ignored, as described above.
+  pdx::Status<pdx::LocalChannelHandle> CreateConsumerQueueHandle(
+      bool silent = false);
 
   // Returns the number of buffers avaiable for dequeue.
   size_t count() const { return available_buffers_.GetSize(); }
@@ -175,20 +175,37 @@ Status<void> SendPayload::Send(const BorrowedHandle& socket_fd) {
 }
 
 Status<void> SendPayload::Send(const BorrowedHandle& socket_fd,
-                               const ucred* cred) {
+                               const ucred* cred, const iovec* data_vec,
+                               size_t vec_count) {
   SendInterface* sender = sender_ ? sender_ : &g_socket_sender;
   MessagePreamble preamble;
   preamble.magic = kMagicPreamble;
   preamble.data_size = buffer_.size();
   preamble.fd_count = file_handles_.size();
-  Status<void> ret = SendAll(sender, socket_fd, &preamble, sizeof(preamble));
-  if (!ret)
-    return ret;
+
+  // The preamble, the payload and the trailing data normally go out in a
+  // single sendmsg(). When file descriptors are attached, the preamble is sent
+  // on its own: the receiver reads it without a control buffer, which would
+  // close any descriptors attached to the same segment.
+  iovec* send_vect =
+      static_cast<iovec*>(alloca(sizeof(iovec) * (vec_count + 2)));
+  size_t send_count = 0;
+  if (file_handles_.empty()) {
+    send_vect[send_count++] = {&preamble, sizeof(preamble)};
+  } else {
+    Status<void> ret = SendAll(sender, socket_fd, &preamble, sizeof(preamble));
+    if (!ret)
+      return ret;
+  }
+  send_vect[send_count++] = {buffer_.data(), buffer_.size()};
+  for (size_t i = 0; i < vec_count; i++) {
+    if (data_vec[i].iov_len > 0)
+      send_vect[send_count++] = data_vec[i];
+  }
 
   msghdr msg = {};
-  iovec recv_vect = {buffer_.data(), buffer_.size()};
-  msg.msg_iov = &recv_vect;
-  msg.msg_iovlen = 1;
+  msg.msg_iov = send_vect;
+  msg.msg_iovlen = send_count;
 
   if (cred || !file_handles_.empty()) {
     const size_t fd_bytes = file_handles_.size() * sizeof(int);
@@ -3,6 +3,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+using testing::Invoke;
 using testing::Return;
 using testing::SetErrnoAndReturn;
 using testing::_;
@@ -14,6 +15,7 @@ using android::pdx::uds::SendAll;
 using android::pdx::uds::SendMsgAll;
 using android::pdx::uds::RecvAll;
 using android::pdx::uds::RecvMsgAll;
+using android::pdx::uds::SendPayload;
 
 namespace {
 
@@ -290,6 +292,32 @@ TEST_F(SendMessageTest, Error2) {
   EXPECT_EQ(EBADF, status.error());
 }
 
+// SendPayload
+TEST_F(SendTest, PayloadWithData) {
+  SendPayload payload{&sender_};
+  memset(payload.GetNextWriteBufferSection(16), 0, 16);
+  const iovec data[] = {{IntToPtr(kPtr), 100}, {nullptr, 0},
+                        {IntToPtr(kPtr + 200), 50}};
+
+  // Preamble, payload and data go out in a single message; empty chunks are
+  // dropped.
+  EXPECT_CALL(sender_, Send(_, _, _, _)).Times(0);
+  EXPECT_CALL(sender_, SendMessage(kSocketFd, _, MSG_NOSIGNAL))
+      .WillOnce(Invoke([](int, const msghdr* msg, int) -> ssize_t {
+        EXPECT_EQ(4u, msg->msg_iovlen);
+        EXPECT_EQ(16u, msg->msg_iov[1].iov_len);
+        EXPECT_EQ(IntToPtr(kPtr), msg->msg_iov[2].iov_base);
+        EXPECT_EQ(IntToPtr(kPtr + 200), msg->msg_iov[3].iov_base);
+        ssize_t size = 0;
+        for (size_t i = 0; i < msg->msg_iovlen; i++)
+          size += msg->msg_iov[i].iov_len;
+        return size;
+      }));
+
+  auto status = payload.Send(kSocket, nullptr, data, 3);
+  EXPECT_TRUE(status);
+}
+
 // RecvMsgAll
 TEST_F(RecvMessageTest, Complete) {
   EXPECT_CALL(receiver_,
@@ -628,11 +628,9 @@ Status<void> Endpoint::MessageReply(Message* message, int return_code) {
 
   state->response.ret_code = return_code;
   state->response.recv_len = state->response_data.size();
-  auto status = SendData(channel_socket, state->response);
-  if (status && !state->response_data.empty()) {
-    status = SendData(channel_socket, state->response_data.data(),
-                      state->response_data.size());
-  }
+  iovec response_vect = {state->response_data.data(),
+                          state->response_data.size()};
+  auto status = SendData(channel_socket, state->response, &response_vect, 1);
 
   if (status)
     status = ReenableEpollEvent(channel_socket);
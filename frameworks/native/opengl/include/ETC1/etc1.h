@@ -67,6 +67,23 @@ etc1_uint32 etc1_get_encoded_data_size(etc1_uint32 width, etc1_uint32 height);
 int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 height,
         etc1_uint32 pixelSize, etc1_uint32 stride, etc1_byte* pOut);
 
+// Encoding quality for etc1_encode_image_with_options.
+// ETC1_QUALITY_HIGH searches every modifier table for each sub-block, like etc1_encode_image.
+// ETC1_QUALITY_FAST only searches the three tables that best match the spread of each sub-block's
+// colors. It takes about half the time, for a slightly higher error.
+
+#define ETC1_QUALITY_FAST 0
+#define ETC1_QUALITY_HIGH 1
+
+// Encode an entire image, like etc1_encode_image, with the given quality.
+// threadCount is the maximum number of threads to encode with, including the calling thread, or
+// 0 to use one per CPU. Small images use fewer threads. The output doesn't depend on threadCount.
+// returns non-zero if there is an error.
+
+int etc1_encode_image_with_options(const etc1_byte* pIn, etc1_uint32 width,
+        etc1_uint32 height, etc1_uint32 pixelSize, etc1_uint32 stride,
+        etc1_byte* pOut, int quality, etc1_uint32 threadCount);
+
 // Decode an entire image.
 // pIn - pointer to encoded data.
 // pOut - pointer to the image data. Will be written such that
@@ -22,7 +22,8 @@
 
 #include <cutils/properties.h>
 #include <log/log.h>
-#include <chrono>
+
+#include <algorithm>
 
 namespace android {
 
@@ -30,7 +31,7 @@ namespace android {
 static const uint32_t blobCacheMagic = ('_' << 24) + ('B' << 16) + ('b' << 8) + '$';
 
 // BlobCache::Header::mBlobCacheVersion value
-static const uint32_t blobCacheVersion = 3;
+static const uint32_t blobCacheVersion = 4;
 
 // BlobCache::Header::mDeviceVersion value
 static const uint32_t blobCacheDeviceVersion = 1;
@@ -39,16 +40,9 @@ BlobCache::BlobCache(size_t maxKeySize, size_t maxValueSize, size_t maxTotalSize
         mMaxKeySize(maxKeySize),
         mMaxValueSize(maxValueSize),
         mMaxTotalSize(maxTotalSize),
-        mTotalSize(0) {
-    int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
-#ifdef _WIN32
-    srand(now);
-#else
-    mRandState[0] = (now >> 0) & 0xFFFF;
-    mRandState[1] = (now >> 16) & 0xFFFF;
-    mRandState[2] = (now >> 32) & 0xFFFF;
-#endif
-    ALOGV("initializing random seed using %lld", (unsigned long long)now);
+        mTotalSize(0),
+        mClock(0),
+        mEvictionCount(0) {
 }
 
 void BlobCache::set(const void* key, size_t keySize, const void* value,
@@ -100,7 +94,9 @@ void BlobCache::set(const void* key, size_t keySize, const void* value,
                     break;
                 }
             }
-            mCacheEntries.insert(index, CacheEntry(keyBlob, valueBlob));
+            CacheEntry entry(keyBlob, valueBlob);
+            entry.setValue(valueBlob, ++mClock);
+            mCacheEntries.insert(index, entry);
             mTotalSize = newTotalSize;
             ALOGV("set: created new cache entry with %zu byte key and %zu byte value",
                     keySize, valueSize);
@@ -121,7 +117,7 @@ void BlobCache::set(const void* key, size_t keySize, const void* value,
                     break;
                 }
             }
-            index->setValue(valueBlob);
+            index->setValue(valueBlob, ++mClock);
             mTotalSize = newTotalSize;
             ALOGV("set: updated existing cache entry with %zu byte key and %zu byte "
                     "value", keySize, valueSize);
@@ -147,6 +143,7 @@ size_t BlobCache::get(const void* key, size_t keySize, void* value,
 
     // The key was found. Return the value if the caller's buffer is large
     // enough.
+    index->setLastUse(++mClock);
     std::shared_ptr<Blob> valueBlob(index->getValue());
     size_t valueBlobSize = valueBlob->getSize();
     if (valueBlobSize <= valueSize) {
@@ -164,15 +161,86 @@ static inline size_t align4(size_t size) {
 }
 
 size_t BlobCache::getFlattenedSize() const {
-    size_t size = align4(sizeof(Header) + PROPERTY_VALUE_MAX);
+    return align4(sizeof(Header) + PROPERTY_VALUE_MAX) + getFlattenedEntriesSize(0);
+}
+
+size_t BlobCache::getFlattenedEntriesSize(uint64_t since) const {
+    size_t size = 0;
     for (const CacheEntry& e :  mCacheEntries) {
-        std::shared_ptr<Blob> const& keyBlob = e.getKey();
-        std::shared_ptr<Blob> const& valueBlob = e.getValue();
-        size += align4(sizeof(EntryHeader) + keyBlob->getSize() + valueBlob->getSize());
+        if (e.getSetTime() > since) {
+            size += align4(sizeof(EntryHeader) + e.getKey()->getSize() +
+                    e.getValue()->getSize());
+        }
     }
     return size;
 }
 
+std::vector<const BlobCache::CacheEntry*> BlobCache::getEntriesByLastUse(uint64_t since) const {
+    std::vector<const CacheEntry*> entries;
+    entries.reserve(mCacheEntries.size());
+    for (const CacheEntry& e :  mCacheEntries) {
+        if (e.getSetTime() > since) {
+            entries.push_back(&e);
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const CacheEntry* a, const CacheEntry* b) {
+        return a->getLastUse() < b->getLastUse();
+    });
+    return entries;
+}
+
+ssize_t BlobCache::flattenEntry(const CacheEntry& e, uint8_t* buffer, size_t size) {
+    std::shared_ptr<Blob> const& keyBlob = e.getKey();
+    std::shared_ptr<Blob> const& valueBlob = e.getValue();
+    size_t keySize = keyBlob->getSize();
+    size_t valueSize = valueBlob->getSize();
+
+    size_t entrySize = sizeof(EntryHeader) + keySize + valueSize;
+    size_t totalSize = align4(entrySize);
+    if (totalSize > size) {
+        return -EINVAL;
+    }
+
+    EntryHeader* eheader = reinterpret_cast<EntryHeader*>(buffer);
+    eheader->mKeySize = keySize;
+    eheader->mValueSize = valueSize;
+
+    memcpy(eheader->mData, keyBlob->getData(), keySize);
+    memcpy(eheader->mData + keySize, valueBlob->getData(), valueSize);
+
+    if (totalSize > entrySize) {
+        // We have padding bytes. Those will get written to storage, and contribute to the CRC,
+        // so make sure we zero-them to have reproducible results.
+        memset(eheader->mData + keySize + valueSize, 0, totalSize - entrySize);
+    }
+
+    return totalSize;
+}
+
+ssize_t BlobCache::unflattenEntry(const uint8_t* buffer, size_t size) {
+    if (sizeof(EntryHeader) > size) {
+        return -EINVAL;
+    }
+
+    const EntryHeader* eheader = reinterpret_cast<const EntryHeader*>(buffer);
+    size_t keySize = eheader->mKeySize;
+    size_t valueSize = eheader->mValueSize;
+    if (keySize > size || valueSize > size) {
+        return -EINVAL;
+    }
+    size_t entrySize = sizeof(EntryHeader) + keySize + valueSize;
+
+    size_t totalSize = align4(entrySize);
+    if (totalSize > size) {
+        return -EINVAL;
+    }
+
+    const uint8_t* data = eheader->mData;
+    set(data, keySize, data + keySize, valueSize);
+
+    return totalSize;
+}
+
 int BlobCache::flatten(void* buffer, size_t size) const {
     // Write the cache header
     if (size < sizeof(Header)) {
@@ -191,33 +259,23 @@ int BlobCache::flatten(void* buffer, size_t size) const {
     // Write cache entries
     uint8_t* byteBuffer = reinterpret_cast<uint8_t*>(buffer);
     off_t byteOffset = align4(sizeof(Header) + header->mBuildIdLength);
-    for (const CacheEntry& e :  mCacheEntries) {
-        std::shared_ptr<Blob> const& keyBlob = e.getKey();
-        std::shared_ptr<Blob> const& valueBlob = e.getValue();
-        size_t keySize = keyBlob->getSize();
-        size_t valueSize = valueBlob->getSize();
-
-        size_t entrySize = sizeof(EntryHeader) + keySize + valueSize;
-        size_t totalSize = align4(entrySize);
-        if (byteOffset + totalSize > size) {
+    if (static_cast<size_t>(byteOffset) > size) {
+        ALOGE("flatten: not enough room for cache entries");
+        return -EINVAL;
+    }
+    return flattenEntries(0, byteBuffer + byteOffset, size - byteOffset);
+}
+
+int BlobCache::flattenEntries(uint64_t since, void* buffer, size_t size) const {
+    uint8_t* byteBuffer = reinterpret_cast<uint8_t*>(buffer);
+    size_t byteOffset = 0;
+    for (const CacheEntry* e : getEntriesByLastUse(since)) {
+        ssize_t entrySize = flattenEntry(*e, byteBuffer + byteOffset, size - byteOffset);
+        if (entrySize < 0) {
             ALOGE("flatten: not enough room for cache entries");
             return -EINVAL;
         }
-
-        EntryHeader* eheader = reinterpret_cast<EntryHeader*>(&byteBuffer[byteOffset]);
-        eheader->mKeySize = keySize;
-        eheader->mValueSize = valueSize;
-
-        memcpy(eheader->mData, keyBlob->getData(), keySize);
-        memcpy(eheader->mData + keySize, valueBlob->getData(), valueSize);
-
-        if (totalSize > entrySize) {
-            // We have padding bytes. Those will get written to storage, and contribute to the CRC,
-            // so make sure we zero-them to have reproducible results.
-            memset(eheader->mData + keySize + valueSize, 0, totalSize - entrySize);
-        }
-
-        byteOffset += totalSize;
+        byteOffset += entrySize;
     }
 
     return 0;
@@ -226,6 +284,7 @@ int BlobCache::flatten(void* buffer, size_t size) const {
 int BlobCache::unflatten(void const* buffer, size_t size) {
     // All errors should result in the BlobCache being in an empty state.
     mCacheEntries.clear();
+    mTotalSize = 0;
 
     // Read the cache header
     if (size < sizeof(Header)) {
@@ -249,54 +308,70 @@ int BlobCache::unflatten(void const* buffer, size_t size) {
 
     // Read cache entries
     const uint8_t* byteBuffer = reinterpret_cast<const uint8_t*>(buffer);
-    off_t byteOffset = align4(sizeof(Header) + header->mBuildIdLength);
+    size_t byteOffset = align4(sizeof(Header) + header->mBuildIdLength);
     size_t numEntries = header->mNumEntries;
     for (size_t i = 0; i < numEntries; i++) {
-        if (byteOffset + sizeof(EntryHeader) > size) {
+        ssize_t entrySize = byteOffset <= size ?
+                unflattenEntry(byteBuffer + byteOffset, size - byteOffset) : -EINVAL;
+        if (entrySize < 0) {
             mCacheEntries.clear();
+            mTotalSize = 0;
             ALOGE("unflatten: not enough room for cache entry headers");
             return -EINVAL;
         }
+        byteOffset += entrySize;
+    }
 
-        const EntryHeader* eheader = reinterpret_cast<const EntryHeader*>(
-                &byteBuffer[byteOffset]);
-        size_t keySize = eheader->mKeySize;
-        size_t valueSize = eheader->mValueSize;
-        size_t entrySize = sizeof(EntryHeader) + keySize + valueSize;
+    return 0;
+}
 
-        size_t totalSize = align4(entrySize);
-        if (byteOffset + totalSize > size) {
-            mCacheEntries.clear();
-            ALOGE("unflatten: not enough room for cache entry headers");
+int BlobCache::unflattenEntries(void const* buffer, size_t size) {
+    const uint8_t* byteBuffer = reinterpret_cast<const uint8_t*>(buffer);
+    size_t byteOffset = 0;
+    while (byteOffset < size) {
+        ssize_t entrySize = unflattenEntry(byteBuffer + byteOffset, size - byteOffset);
+        if (entrySize < 0) {
+            ALOGE("unflattenEntries: not enough room for cache entry headers");
             return -EINVAL;
         }
-
-        const uint8_t* data = eheader->mData;
-        set(data, keySize, data + keySize, valueSize);
-
-        byteOffset += totalSize;
+        byteOffset += entrySize;
     }
-
     return 0;
 }
 
-long int BlobCache::blob_random() {
-#ifdef _WIN32
-    return rand();
-#else
-    return nrand48(mRandState);
-#endif
+uint64_t BlobCache::getClock() const {
+    return mClock;
+}
+
+uint64_t BlobCache::getEvictionCount() const {
+    return mEvictionCount;
 }
 
 void BlobCache::clean() {
-    // Remove a random cache entry until the total cache size gets below half
-    // the maximum total cache size.
-    while (mTotalSize > mMaxTotalSize / 2) {
-        size_t i = size_t(blob_random() % (mCacheEntries.size()));
-        const CacheEntry& entry(mCacheEntries[i]);
-        mTotalSize -= entry.getKey()->getSize() + entry.getValue()->getSize();
-        mCacheEntries.erase(mCacheEntries.begin() + i);
+    // Find the most recent use before which entries must go for the total
+    // cache size to get below half the maximum total cache size.  Uses are
+    // unique clock values.
+    std::vector<std::pair<uint64_t, size_t>> uses;
+    uses.reserve(mCacheEntries.size());
+    for (const CacheEntry& e : mCacheEntries) {
+        uses.emplace_back(e.getLastUse(), e.getKey()->getSize() + e.getValue()->getSize());
+    }
+    std::sort(uses.begin(), uses.end());
+
+    uint64_t threshold = 0;
+    for (const auto& use : uses) {
+        if (mTotalSize <= mMaxTotalSize / 2) {
+            break;
+        }
+        mTotalSize -= use.second;
+        threshold = use.first;
     }
+
+    // Remove them in a single pass, keeping the other entries sorted by key.
+    auto end = std::remove_if(mCacheEntries.begin(), mCacheEntries.end(),
+            [threshold](const CacheEntry& e) { return e.getLastUse() <= threshold; });
+    mEvictionCount += mCacheEntries.end() - end;
+    mCacheEntries.erase(end, mCacheEntries.end());
 }
 
 bool BlobCache::isCleanable() const {
@@ -334,18 +409,24 @@ size_t BlobCache::Blob::getSize() const {
     return mSize;
 }
 
-BlobCache::CacheEntry::CacheEntry() {
+BlobCache::CacheEntry::CacheEntry():
+        mLastUse(0),
+        mSetTime(0) {
 }
 
 BlobCache::CacheEntry::CacheEntry(
         const std::shared_ptr<Blob>& key, const std::shared_ptr<Blob>& value):
         mKey(key),
-        mValue(value) {
+        mValue(value),
+        mLastUse(0),
+        mSetTime(0) {
 }
 
 BlobCache::CacheEntry::CacheEntry(const CacheEntry& ce):
         mKey(ce.mKey),
-        mValue(ce.mValue) {
+        mValue(ce.mValue),
+        mLastUse(ce.mLastUse),
+        mSetTime(ce.mSetTime) {
 }
 
 bool BlobCache::CacheEntry::operator<(const CacheEntry& rhs) const {
@@ -355,6 +436,8 @@ bool BlobCache::CacheEntry::operator<(const CacheEntry& rhs) const {
 const BlobCache::CacheEntry& BlobCache::CacheEntry::operator=(const CacheEntry& rhs) {
     mKey = rhs.mKey;
     mValue = rhs.mValue;
+    mLastUse = rhs.mLastUse;
+    mSetTime = rhs.mSetTime;
     return *this;
 }
 
@@ -366,8 +449,22 @@ std::shared_ptr<BlobCache::Blob> BlobCache::CacheEntry::getValue() const {
     return mValue;
 }
 
-void BlobCache::CacheEntry::setValue(const std::shared_ptr<Blob>& value) {
+void BlobCache::CacheEntry::setValue(const std::shared_ptr<Blob>& value, uint64_t time) {
     mValue = value;
+    mLastUse = time;
+    mSetTime = time;
+}
+
+uint64_t BlobCache::CacheEntry::getLastUse() const {
+    return mLastUse;
+}
+
+uint64_t BlobCache::CacheEntry::getSetTime() const {
+    return mSetTime;
+}
+
+void BlobCache::CacheEntry::setLastUse(uint64_t time) {
+    mLastUse = time;
 }
 
 } // namespace android
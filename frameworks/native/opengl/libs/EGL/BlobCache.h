@@ -18,6 +18,8 @@
 #define ANDROID_BLOB_CACHE_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
 
 #include <memory>
 #include <vector>
@@ -47,7 +49,8 @@ public:
     // put in the cache (based on the maxKeySize, maxValueSize, and maxTotalSize
     // values specified to the BlobCache constructor), then the key/value pair
     // will be in the cache after set returns.  Note, however, that a subsequent
-    // call to set may evict old key/value pairs from the cache.
+    // call to set may evict old key/value pairs from the cache.  The entries
+    // that were least recently set or retrieved are evicted first.
     //
     // Preconditions:
     //   key != NULL
@@ -83,7 +86,9 @@ public:
     // flatten serializes the current contents of the cache into the memory
     // pointed to by 'buffer'.  The serialized cache contents can later be
     // loaded into a BlobCache object using the unflatten method.  The contents
-    // of the BlobCache object will not be modified.
+    // of the BlobCache object will not be modified.  Entries are written from
+    // the least to the most recently used, so the order of evictions survives
+    // a round trip.
     //
     // Preconditions:
     //   size >= this.getFlattenedSize()
@@ -97,15 +102,37 @@ public:
     //
     int unflatten(void const* buffer, size_t size);
 
+protected:
+    // getClock returns the time of the latest set or get.  Each of them
+    // advances the clock by one.
+    uint64_t getClock() const;
+
+    // getEvictionCount returns the number of entries evicted so far.
+    uint64_t getEvictionCount() const;
+
+    // getFlattenedEntriesSize returns the number of bytes flattenEntries needs
+    // to store the entries set after the given clock value.
+    size_t getFlattenedEntriesSize(uint64_t since) const;
+
+    // flattenEntries serializes the entries set after the given clock value,
+    // without a cache header, so that they can be appended to an earlier
+    // serialization of the cache.
+    //
+    // Preconditions:
+    //   size >= this.getFlattenedEntriesSize(since)
+    int flattenEntries(uint64_t since, void* buffer, size_t size) const;
+
+    // unflattenEntries adds entries serialized by flattenEntries to the cache,
+    // replacing the values of existing keys.  Unlike unflatten, it keeps the
+    // current contents of the cache, even if an error occurs.
+    int unflattenEntries(void const* buffer, size_t size);
+
 private:
     // Copying is disallowed.
     BlobCache(const BlobCache&);
     void operator=(const BlobCache&);
 
-    // A random function helper to get around MinGW not having nrand48()
-    long int blob_random();
-
-    // clean evicts a randomly chosen set of entries from the cache such that
+    // clean evicts the least recently used entries from the cache such that
     // the total size of all remaining entries is less than mMaxTotalSize/2.
     void clean();
 
@@ -153,7 +180,12 @@ private:
         std::shared_ptr<Blob> getKey() const;
         std::shared_ptr<Blob> getValue() const;
 
-        void setValue(const std::shared_ptr<Blob>& value);
+        void setValue(const std::shared_ptr<Blob>& value, uint64_t time);
+
+        uint64_t getLastUse() const;
+        uint64_t getSetTime() const;
+
+        void setLastUse(uint64_t time);
 
     private:
 
@@ -162,8 +194,27 @@ private:
 
         // mValue is the cached data associated with the key.
         std::shared_ptr<Blob> mValue;
+
+        // mLastUse is the clock value of the latest set or get of the entry.
+        uint64_t mLastUse;
+
+        // mSetTime is the clock value of the latest set of the entry.
+        uint64_t mSetTime;
     };
 
+    // getEntriesByLastUse returns the entries set after the given clock value,
+    // from the least to the most recently used.
+    std::vector<const CacheEntry*> getEntriesByLastUse(uint64_t since) const;
+
+    // flattenEntry serializes one entry at 'buffer', returning the number of
+    // bytes used or -EINVAL if it doesn't fit in 'size' bytes.
+    static ssize_t flattenEntry(const CacheEntry& e, uint8_t* buffer, size_t size);
+
+    // unflattenEntry adds the entry serialized at 'buffer' to the cache,
+    // returning the number of bytes read or -EINVAL if it doesn't fit in
+    // 'size' bytes.
+    ssize_t unflattenEntry(const uint8_t* buffer, size_t size);
+
     // A Header is the header for the entire BlobCache serialization format. No
     // need to make this portable, so we simply write the struct out.
     struct Header {
@@ -231,9 +282,12 @@ private:
     // the cache.
     size_t mTotalSize;
 
-    // mRandState is the pseudo-random number generator state. It is passed to
-    // nrand48 to generate random numbers when needed.
-    unsigned short mRandState[3];
+    // mClock counts the calls to set and get, to order the entries by their
+    // last use.
+    uint64_t mClock;
+
+    // mEvictionCount is the number of entries removed by clean.
+    uint64_t mEvictionCount;
 
     // mCacheEntries stores all the cache entries that are resident in memory.
     // Cache entries are added to it by the 'set' method.
@@ -0,0 +1,316 @@
+/*
+ ** Copyright 2017, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+
+#include "FileBlobCache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <log/log.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+
+// Cache file header: the magic, the CRC and the size of the snapshot that
+// follows it.  The snapshot holds the driver id and the serialized cache, and
+// is followed by batches of appended entries.
+static const char* cacheFileMagic = "EGL%";
+static const size_t cacheFileHeaderSize = 12;
+
+// Header of a batch of appended entries: its size and CRC.
+static const size_t cacheBatchHeaderSize = 8;
+
+namespace android {
+
+static inline size_t align4(size_t size) {
+    return (size + 3) & ~3;
+}
+
+static uint32_t crc32c(const uint8_t* buf, size_t len) {
+    const uint32_t polyBits = 0x82F63B78;
+    uint32_t r = 0;
+    for (size_t i = 0; i < len; i++) {
+        r ^= buf[i];
+        for (int j = 0; j < 8; j++) {
+            if (r & 1) {
+                r = (r >> 1) ^ polyBits;
+            } else {
+                r >>= 1;
+            }
+        }
+    }
+    return r;
+}
+
+FileBlobCache::FileBlobCache(size_t maxKeySize, size_t maxValueSize, size_t maxTotalSize,
+        const std::string& filename, const std::string& driverId)
+        : BlobCache(maxKeySize, maxValueSize, maxTotalSize)
+        , mFilename(filename)
+        , mDriverId(driverId)
+        , mMaxFileSize(maxTotalSize * 2)
+        , mFileSize(0)
+        , mSavedClock(0)
+        , mSavedEvictionCount(0) {
+    if (mFilename.length() > 0) {
+        size_t headerSize = cacheFileHeaderSize;
+
+        int fd = open(mFilename.c_str(), O_RDONLY, 0);
+        if (fd == -1) {
+            if (errno != ENOENT) {
+                ALOGE("error opening cache file %s: %s (%d)", mFilename.c_str(),
+                        strerror(errno), errno);
+            }
+            return;
+        }
+
+        struct stat statBuf;
+        if (fstat(fd, &statBuf) == -1) {
+            ALOGE("error stat'ing cache file: %s (%d)", strerror(errno), errno);
+            close(fd);
+            return;
+        }
+
+        // Sanity check the size before trying to mmap it.
+        size_t fileSize = statBuf.st_size;
+        if (fileSize > mMaxFileSize) {
+            ALOGE("cache file is too large: %#" PRIx64,
+                  static_cast<off64_t>(statBuf.st_size));
+            close(fd);
+            return;
+        }
+        if (fileSize < headerSize) {
+            ALOGE("cache file is too small: %zu", fileSize);
+            close(fd);
+            return;
+        }
+
+        uint8_t* buf = reinterpret_cast<uint8_t*>(mmap(NULL, fileSize,
+                PROT_READ, MAP_PRIVATE, fd, 0));
+        if (buf == MAP_FAILED) {
+            ALOGE("error mmaping cache file: %s (%d)", strerror(errno),
+                    errno);
+            close(fd);
+            return;
+        }
+
+        // Check the file magic and CRC
+        const uint32_t* header = reinterpret_cast<const uint32_t*>(buf);
+        size_t snapshotSize = header[2];
+        if (memcmp(buf, cacheFileMagic, 4) != 0) {
+            ALOGE("cache file has bad mojo");
+            munmap(buf, fileSize);
+            close(fd);
+            return;
+        }
+        if (snapshotSize < sizeof(uint32_t) || snapshotSize > fileSize - headerSize ||
+                crc32c(buf + headerSize, snapshotSize) != header[1]) {
+            ALOGE("cache file failed CRC check");
+            munmap(buf, fileSize);
+            close(fd);
+            return;
+        }
+
+        // Values produced by another driver build are useless.
+        size_t driverIdLength = *reinterpret_cast<const uint32_t*>(buf + headerSize);
+        size_t driverIdSize = align4(sizeof(uint32_t) + driverIdLength);
+        if (driverIdLength > snapshotSize || driverIdSize > snapshotSize ||
+                mDriverId.compare(0, std::string::npos,
+                        reinterpret_cast<const char*>(buf + headerSize + sizeof(uint32_t)),
+                        driverIdLength) != 0) {
+            ALOGI("ignoring cache file written by another driver");
+            munmap(buf, fileSize);
+            close(fd);
+            return;
+        }
+
+        int err = unflatten(buf + headerSize + driverIdSize, snapshotSize - driverIdSize);
+        if (err < 0) {
+            ALOGE("error reading cache contents: %s (%d)", strerror(-err),
+                    -err);
+            munmap(buf, fileSize);
+            close(fd);
+            return;
+        }
+
+        // Replay the appended batches.  A batch that is incomplete or fails
+        // its CRC was cut short by a crash, and ends the valid contents.
+        size_t offset = headerSize + snapshotSize;
+        bool valid = true;
+        while (offset < fileSize) {
+            const uint32_t* batchHeader = reinterpret_cast<const uint32_t*>(buf + offset);
+            if (fileSize - offset < cacheBatchHeaderSize ||
+                    batchHeader[0] > fileSize - offset - cacheBatchHeaderSize ||
+                    crc32c(buf + offset + cacheBatchHeaderSize, batchHeader[0]) !=
+                            batchHeader[1]) {
+                ALOGW("ignoring incomplete cache file batch at %zu", offset);
+                valid = false;
+                break;
+            }
+            if (unflattenEntries(buf + offset + cacheBatchHeaderSize, batchHeader[0]) < 0) {
+                valid = false;
+                break;
+            }
+            offset += cacheBatchHeaderSize + batchHeader[0];
+        }
+
+        munmap(buf, fileSize);
+        close(fd);
+
+        // Entries evicted while loading are still in the file, which must be
+        // rewritten before anything is appended to it.
+        mSavedClock = getClock();
+        mSavedEvictionCount = getEvictionCount();
+        if (valid && mSavedEvictionCount == 0) {
+            mFileSize = offset;
+        }
+    }
+}
+
+void FileBlobCache::writeToFile() {
+    if (mFilename.length() > 0) {
+        if (mFileSize > 0 && getEvictionCount() == mSavedEvictionCount) {
+            if (appendToFile()) {
+                return;
+            }
+        }
+        rewriteFile();
+    }
+}
+
+bool FileBlobCache::appendToFile() {
+    size_t batchSize = getFlattenedEntriesSize(mSavedClock);
+    if (batchSize == 0) {
+        return true;
+    }
+    size_t size = cacheBatchHeaderSize + batchSize;
+    if (mFileSize + size > mMaxFileSize) {
+        return false;
+    }
+
+    int fd = open(mFilename.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+
+    std::unique_ptr<uint8_t[]> buf(new uint8_t[size]);
+    int err = flattenEntries(mSavedClock, buf.get() + cacheBatchHeaderSize, batchSize);
+    if (err < 0) {
+        close(fd);
+        return false;
+    }
+    uint32_t* batchHeader = reinterpret_cast<uint32_t*>(buf.get());
+    batchHeader[0] = batchSize;
+    batchHeader[1] = crc32c(buf.get() + cacheBatchHeaderSize, batchSize);
+
+    if (pwrite(fd, buf.get(), size, mFileSize) != static_cast<ssize_t>(size)) {
+        ALOGE("error appending to cache file: %s (%d)", strerror(errno), errno);
+        close(fd);
+        return false;
+    }
+    close(fd);
+
+    mFileSize += size;
+    mSavedClock = getClock();
+    return true;
+}
+
+void FileBlobCache::rewriteFile() {
+    mFileSize = 0;
+
+    size_t driverIdSize = align4(sizeof(uint32_t) + mDriverId.size());
+    size_t cacheSize = getFlattenedSize();
+    size_t headerSize = cacheFileHeaderSize;
+    const char* fname = mFilename.c_str();
+
+    // Try to create the file with no permissions so we can write it
+    // without anyone trying to read it.
+    int fd = open(fname, O_CREAT | O_EXCL | O_RDWR, 0);
+    if (fd == -1) {
+        if (errno == EEXIST) {
+            // The file exists, delete it and try again.
+            if (unlink(fname) == -1) {
+                // No point in retrying if the unlink failed.
+                ALOGE("error unlinking cache file %s: %s (%d)", fname,
+                        strerror(errno), errno);
+                return;
+            }
+            // Retry now that we've unlinked the file.
+            fd = open(fname, O_CREAT | O_EXCL | O_RDWR, 0);
+        }
+        if (fd == -1) {
+            ALOGE("error creating cache file %s: %s (%d)", fname,
+                    strerror(errno), errno);
+            return;
+        }
+    }
+
+    size_t snapshotSize = driverIdSize + cacheSize;
+    size_t fileSize = headerSize + snapshotSize;
+
+    uint8_t* buf = new uint8_t [fileSize];
+    if (!buf) {
+        ALOGE("error allocating buffer for cache contents: %s (%d)",
+                strerror(errno), errno);
+        close(fd);
+        unlink(fname);
+        return;
+    }
+
+    // Write the driver id, padded with zeroes for a reproducible CRC.
+    memset(buf + headerSize, 0, driverIdSize);
+    *reinterpret_cast<uint32_t*>(buf + headerSize) = mDriverId.size();
+    memcpy(buf + headerSize + sizeof(uint32_t), mDriverId.data(), mDriverId.size());
+
+    int err = flatten(buf + headerSize + driverIdSize, cacheSize);
+    if (err < 0) {
+        ALOGE("error writing cache contents: %s (%d)", strerror(-err),
+                -err);
+        delete [] buf;
+        close(fd);
+        unlink(fname);
+        return;
+    }
+
+    // Write the file magic, CRC and snapshot size
+    memcpy(buf, cacheFileMagic, 4);
+    uint32_t* header = reinterpret_cast<uint32_t*>(buf);
+    header[1] = crc32c(buf + headerSize, snapshotSize);
+    header[2] = snapshotSize;
+
+    if (write(fd, buf, fileSize) != static_cast<ssize_t>(fileSize)) {
+        ALOGE("error writing cache file: %s (%d)", strerror(errno),
+                errno);
+        delete [] buf;
+        close(fd);
+        unlink(fname);
+        return;
+    }
+
+    delete [] buf;
+    // Writable by its owner for the batches appended later.
+    fchmod(fd, S_IRUSR | S_IWUSR);
+    close(fd);
+
+    mFileSize = fileSize;
+    mSavedClock = getClock();
+    mSavedEvictionCount = getEvictionCount();
+}
+
+} // namespace android
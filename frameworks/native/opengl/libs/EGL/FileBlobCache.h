@@ -0,0 +1,79 @@
+/*
+ ** Copyright 2017, The Android Open Source Project
+ **
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ **
+ **     http://www.apache.org/licenses/LICENSE-2.0
+ **
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ */
+
+
+#ifndef ANDROID_FILE_BLOB_CACHE_H
+#define ANDROID_FILE_BLOB_CACHE_H
+
+#include "BlobCache.h"
+#include <string>
+
+namespace android {
+
+// A FileBlobCache is a BlobCache whose contents are read from a file when it
+// is created, and can be written back to it.  The file starts with a magic
+// and a CRC of the serialized cache, so that a truncated or corrupted file is
+// ignored rather than loaded.  Like BlobCache, it is not thread-safe.
+//
+// As long as no entry gets evicted, writeToFile only appends the entries set
+// since the previous write to the file, each batch with its own CRC, instead
+// of rewriting the whole cache.
+class FileBlobCache : public BlobCache {
+public:
+    // FileBlobCache attempts to load the saved cache contents from disk into
+    // the BlobCache.  An empty filename gives an in-memory only cache.  A file
+    // written with a different driverId, which identifies the build of the
+    // driver producing the cached values, is ignored.
+    FileBlobCache(size_t maxKeySize, size_t maxValueSize, size_t maxTotalSize,
+            const std::string& filename, const std::string& driverId = std::string());
+
+    // writeToFile attempts to save the current contents of the BlobCache to
+    // disk.
+    void writeToFile();
+
+private:
+    // appendToFile attempts to append the entries set since the last write
+    // to the file, returning false if the whole file must be written instead.
+    bool appendToFile();
+
+    // rewriteFile replaces the file with the current contents of the cache.
+    void rewriteFile();
+
+    // mFilename is the name of the file for storing cache contents.
+    std::string mFilename;
+
+    // mDriverId is saved in the file, which is only loaded by caches with the
+    // same driverId.
+    std::string mDriverId;
+
+    // mMaxFileSize is the largest file that will be loaded.  Appends that
+    // would make the file larger rewrite it instead.
+    const size_t mMaxFileSize;
+
+    // mFileSize is the size of the valid contents of the file, where the next
+    // batch of entries gets appended.  It is 0 when the file doesn't match
+    // the cache, in which case the next write rewrites it.
+    size_t mFileSize;
+
+    // mSavedClock and mSavedEvictionCount are the values of getClock and
+    // getEvictionCount when the file was last loaded or written.
+    uint64_t mSavedClock;
+    uint64_t mSavedEvictionCount;
+};
+
+} // namespace android
+
+#endif // ANDROID_FILE_BLOB_CACHE_H
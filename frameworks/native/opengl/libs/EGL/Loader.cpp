@@ -517,13 +517,6 @@ void *Loader::load_driver(const char* kind,
         }
     }
 
-    if (mask & GLESv1_CM) {
-        init_api(dso, gl_names,
-            (__eglMustCastToProperFunctionPointerType*)
-                &cnx->hooks[egl_connection_t::GLESv1_INDEX]->gl,
-            getProcAddress);
-    }
-
     if (mask & GLESv2) {
       init_api(dso, gl_names,
             (__eglMustCastToProperFunctionPointerType*)
@@ -531,6 +524,21 @@ void *Loader::load_driver(const char* kind,
             getProcAddress);
     }
 
+    if (mask & GLESv1_CM) {
+        if (mask & GLESv2) {
+            // A single library implements both APIs: the same entry points
+            // would resolve to the same functions, so reuse the GLESv2 table
+            // rather than looking up every name again.
+            cnx->hooks[egl_connection_t::GLESv1_INDEX]->gl =
+                    cnx->hooks[egl_connection_t::GLESv2_INDEX]->gl;
+        } else {
+            init_api(dso, gl_names,
+                (__eglMustCastToProperFunctionPointerType*)
+                    &cnx->hooks[egl_connection_t::GLESv1_INDEX]->gl,
+                getProcAddress);
+        }
+    }
+
     return dso;
 }
 
@@ -20,7 +20,7 @@
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 
-#include "BlobCache.h"
+#include "FileBlobCache.h"
 
 #include <memory>
 #include <mutex>
@@ -67,6 +67,11 @@ public:
     // cache contents from one program invocation to another.
     void setCacheFilename(const char* filename);
 
+    // setCacheMaxSize sets the maximum total size in bytes of the cache
+    // entries.  It has to be called before the cache is first used, and 0
+    // restores the default size.
+    void setCacheMaxSize(size_t maxSize);
+
 private:
     // Creation and (the lack of) destruction is handled internally.
     egl_cache_t();
@@ -86,10 +91,6 @@ private:
     // disk.
     void saveBlobCacheLocked();
 
-    // loadBlobCache attempts to load the saved cache contents from disk into
-    // mBlobCache.
-    void loadBlobCacheLocked();
-
     // mInitialized indicates whether the egl_cache_t is in the initialized
     // state.  It is initialized to false at construction time, and gets set to
     // true when initialize is called.  It is set back to false when terminate
@@ -101,7 +102,7 @@ private:
     // mBlobCache is the cache in which the key/value blob pairs are stored.  It
     // is initially NULL, and will be initialized by getBlobCacheLocked the
     // first time it's needed.
-    std::unique_ptr<BlobCache> mBlobCache;
+    std::unique_ptr<FileBlobCache> mBlobCache;
 
     // mFilename is the name of the file for storing cache contents in between
     // program invocations.  It is initialized to an empty string at
@@ -110,6 +111,15 @@ private:
     // from disk.
     std::string mFilename;
 
+    // mMaxTotalSize is the size set with setCacheMaxSize, or 0 to use the
+    // default size.
+    size_t mMaxTotalSize;
+
+    // mDriverId identifies the build of the driver, so that the cache file
+    // of another driver isn't loaded.  It is set when the display is
+    // initialized.
+    std::string mDriverId;
+
     // mSavePending indicates whether or not a deferred save operation is
     // pending.  Each time a key/value pair is inserted into the cache via
     // setBlob, a deferred save is initiated if one is not already pending.
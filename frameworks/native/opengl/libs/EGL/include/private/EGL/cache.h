@@ -16,10 +16,16 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #include <cutils/compiler.h>
 
 namespace android {
 
 ANDROID_API void egl_set_cache_filename(const char* filename);
 
+// Sets the maximum size in bytes of the cache of the process, 0 for the
+// default.  It must be called before the cache is first used.
+ANDROID_API void egl_set_cache_max_size(size_t maxSize);
+
 } // namespace android
@@ -16,6 +16,11 @@
 
 #include <string.h>
 
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 /* From http://www.khronos.org/registry/gles/extensions/OES/OES_compressed_ETC1_RGB8_texture.txt
 
  The number of bits that represent a 4x4 texel block is 64 bits if
@@ -295,46 +300,56 @@ inline int square(int x) {
     return x * x;
 }
 
-static etc1_uint32 chooseModifier(const etc1_byte* pBaseColors,
-        const etc1_byte* pIn, etc1_uint32 *pLow, int bitIndex,
-        const int* pModifierTable) {
-    etc1_uint32 bestScore = ~0;
-    int bestIndex = 0;
+// The four colors a sub-block can decode to with a given base color and
+// modifier table. Each channel is kept in its own array so that the four
+// candidates of a pixel are scored together, which the compiler vectorizes.
+typedef struct {
+    int r[4];
+    int g[4];
+    int b[4];
+} etc_palette;
+
+static
+void etc_make_palette(const etc1_byte* pBaseColors, const int* pModifierTable,
+        etc_palette* pPalette) {
+    for (int i = 0; i < 4; i++) {
+        int modifier = pModifierTable[i];
+        pPalette->r[i] = clamp(pBaseColors[0] + modifier);
+        pPalette->g[i] = clamp(pBaseColors[1] + modifier);
+        pPalette->b[i] = clamp(pBaseColors[2] + modifier);
+    }
+}
+
+static etc1_uint32 chooseModifier(const etc_palette* pPalette,
+        const etc1_byte* pIn, etc1_uint32 *pLow, int bitIndex) {
     int pixelR = pIn[0];
     int pixelG = pIn[1];
     int pixelB = pIn[2];
-    int r = pBaseColors[0];
-    int g = pBaseColors[1];
-    int b = pBaseColors[2];
+    etc1_uint32 scores[4];
     for (int i = 0; i < 4; i++) {
-        int modifier = pModifierTable[i];
-        int decodedG = clamp(g + modifier);
-        etc1_uint32 score = (etc1_uint32) (6 * square(decodedG - pixelG));
-        if (score >= bestScore) {
-            continue;
-        }
-        int decodedR = clamp(r + modifier);
-        score += (etc1_uint32) (3 * square(decodedR - pixelR));
-        if (score >= bestScore) {
-            continue;
-        }
-        int decodedB = clamp(b + modifier);
-        score += (etc1_uint32) square(decodedB - pixelB);
-        if (score < bestScore) {
-            bestScore = score;
+        scores[i] = (etc1_uint32) (3 * square(pPalette->r[i] - pixelR)
+                + 6 * square(pPalette->g[i] - pixelG)
+                + square(pPalette->b[i] - pixelB));
+    }
+    // Ties go to the lowest index.
+    int bestIndex = 0;
+    for (int i = 1; i < 4; i++) {
+        if (scores[i] < scores[bestIndex]) {
             bestIndex = i;
         }
     }
     etc1_uint32 lowMask = (((bestIndex >> 1) << 16) | (bestIndex & 1))
             << bitIndex;
     *pLow |= lowMask;
-    return bestScore;
+    return scores[bestIndex];
 }
 
 static
 void etc_encode_subblock_helper(const etc1_byte* pIn, etc1_uint32 inMask,
         etc_compressed* pCompressed, bool flipped, bool second,
         const etc1_byte* pBaseColors, const int* pModifierTable) {
+    etc_palette palette;
+    etc_make_palette(pBaseColors, pModifierTable, &palette);
     int score = pCompressed->score;
     if (flipped) {
         int by = 0;
@@ -346,8 +361,8 @@ void etc_encode_subblock_helper(const etc1_byte* pIn, etc1_uint32 inMask,
             for (int x = 0; x < 4; x++) {
                 int i = x + 4 * yy;
                 if (inMask & (1 << i)) {
-                    score += chooseModifier(pBaseColors, pIn + i * 3,
-                            &pCompressed->low, yy + x * 4, pModifierTable);
+                    score += chooseModifier(&palette, pIn + i * 3,
+                            &pCompressed->low, yy + x * 4);
                 }
             }
         }
@@ -361,8 +376,8 @@ void etc_encode_subblock_helper(const etc1_byte* pIn, etc1_uint32 inMask,
                 int xx = bx + x;
                 int i = xx + 4 * y;
                 if (inMask & (1 << i)) {
-                    score += chooseModifier(pBaseColors, pIn + i * 3,
-                            &pCompressed->low, y + xx * 4, pModifierTable);
+                    score += chooseModifier(&palette, pIn + i * 3,
+                            &pCompressed->low, y + xx * 4);
                 }
             }
         }
@@ -429,9 +444,62 @@ static void etc_encodeBaseColors(etc1_byte* pBaseColors,
     pBaseColors[5] = b2;
 }
 
+// Returns the largest weighted luminance difference between the valid pixels
+// of a sub-block and its base color.
+static
+int etc_subblock_spread(const etc1_byte* pIn, etc1_uint32 inMask,
+        bool flipped, bool second, const etc1_byte* pBaseColors) {
+    int spread = 0;
+    for (int i = 0; i < 16; i++) {
+        int x = i & 3;
+        int y = i >> 2;
+        bool inSecond = flipped ? (y >= 2) : (x >= 2);
+        if (inSecond != second || !(inMask & (1 << i))) {
+            continue;
+        }
+        const etc1_byte* p = pIn + i * 3;
+        int d = (3 * (p[0] - pBaseColors[0]) + 6 * (p[1] - pBaseColors[1])
+                + (p[2] - pBaseColors[2])) / 10;
+        if (d < 0) {
+            d = -d;
+        }
+        if (d > spread) {
+            spread = d;
+        }
+    }
+    return spread;
+}
+
+// Picks the modifier tables to try for a sub-block. ETC1_QUALITY_HIGH tries
+// all of them; ETC1_QUALITY_FAST only the table whose largest modifier is
+// closest to the spread of the sub-block's colors, and its two neighbours.
+static
+void etc_choose_tables(const etc1_byte* pIn, etc1_uint32 inMask,
+        bool flipped, bool second, const etc1_byte* pBaseColors, int quality,
+        int* pFirst, int* pLast) {
+    if (quality != ETC1_QUALITY_FAST) {
+        *pFirst = 0;
+        *pLast = 7;
+        return;
+    }
+    int spread = etc_subblock_spread(pIn, inMask, flipped, second,
+            pBaseColors);
+    int best = 0;
+    for (int i = 1; i < 8; i++) {
+        int d = kModifierTable[i * 4 + 1] - spread;
+        int bestD = kModifierTable[best * 4 + 1] - spread;
+        if (square(d) < square(bestD)) {
+            best = i;
+        }
+    }
+    *pFirst = best > 0 ? best - 1 : 0;
+    *pLast = best < 7 ? best + 1 : 7;
+}
+
 static
 void etc_encode_block_helper(const etc1_byte* pIn, etc1_uint32 inMask,
-        const etc1_byte* pColors, etc_compressed* pCompressed, bool flipped) {
+        const etc1_byte* pColors, etc_compressed* pCompressed, bool flipped,
+        int quality) {
     pCompressed->score = ~0;
     pCompressed->high = (flipped ? 1 : 0);
     pCompressed->low = 0;
@@ -442,8 +510,11 @@ void etc_encode_block_helper(const etc1_byte* pIn, etc1_uint32 inMask,
 
     int originalHigh = pCompressed->high;
 
-    const int* pModifierTable = kModifierTable;
-    for (int i = 0; i < 8; i++, pModifierTable += 4) {
+    int first, last;
+    etc_choose_tables(pIn, inMask, flipped, false, pBaseColors, quality,
+            &first, &last);
+    const int* pModifierTable = kModifierTable + first * 4;
+    for (int i = first; i <= last; i++, pModifierTable += 4) {
         etc_compressed temp;
         temp.score = 0;
         temp.high = originalHigh | (i << 5);
@@ -452,16 +523,18 @@ void etc_encode_block_helper(const etc1_byte* pIn, etc1_uint32 inMask,
                 pBaseColors, pModifierTable);
         take_best(pCompressed, &temp);
     }
-    pModifierTable = kModifierTable;
+    etc_choose_tables(pIn, inMask, flipped, true, pBaseColors + 3, quality,
+            &first, &last);
+    pModifierTable = kModifierTable + first * 4;
     etc_compressed firstHalf = *pCompressed;
-    for (int i = 0; i < 8; i++, pModifierTable += 4) {
+    for (int i = first; i <= last; i++, pModifierTable += 4) {
         etc_compressed temp;
         temp.score = firstHalf.score;
         temp.high = firstHalf.high | (i << 2);
         temp.low = firstHalf.low;
         etc_encode_subblock_helper(pIn, inMask, &temp, flipped, true,
                 pBaseColors + 3, pModifierTable);
-        if (i == 0) {
+        if (i == first) {
             *pCompressed = temp;
         } else {
             take_best(pCompressed, &temp);
@@ -481,8 +554,9 @@ static void writeBigEndian(etc1_byte* pOut, etc1_uint32 d) {
 // pixel is valid or not. Invalid pixel color values are ignored when compressing.
 // Output is an ETC1 compressed version of the data.
 
-void etc1_encode_block(const etc1_byte* pIn, etc1_uint32 inMask,
-        etc1_byte* pOut) {
+static
+void etc_encode_block(const etc1_byte* pIn, etc1_uint32 inMask,
+        etc1_byte* pOut, int quality) {
     etc1_byte colors[6];
     etc1_byte flippedColors[6];
     etc_average_colors_subblock(pIn, inMask, colors, false, false);
@@ -491,39 +565,55 @@ void etc1_encode_block(const etc1_byte* pIn, etc1_uint32 inMask,
     etc_average_colors_subblock(pIn, inMask, flippedColors + 3, true, true);
 
     etc_compressed a, b;
-    etc_encode_block_helper(pIn, inMask, colors, &a, false);
-    etc_encode_block_helper(pIn, inMask, flippedColors, &b, true);
+    etc_encode_block_helper(pIn, inMask, colors, &a, false, quality);
+    etc_encode_block_helper(pIn, inMask, flippedColors, &b, true, quality);
     take_best(&a, &b);
     writeBigEndian(pOut, a.high);
     writeBigEndian(pOut + 4, a.low);
 }
 
+void etc1_encode_block(const etc1_byte* pIn, etc1_uint32 inMask,
+        etc1_byte* pOut) {
+    etc_encode_block(pIn, inMask, pOut, ETC1_QUALITY_HIGH);
+}
+
 // Return the size of the encoded image data (does not include size of PKM header).
 
 etc1_uint32 etc1_get_encoded_data_size(etc1_uint32 width, etc1_uint32 height) {
     return (((width + 3) & ~3) * ((height + 3) & ~3)) >> 1;
 }
 
-// Encode an entire image.
-// pIn - pointer to the image data. Formatted such that the Red component of
-//       pixel (x,y) is at pIn + pixelSize * x + stride * y + redOffset;
-// pOut - pointer to encoded data. Must be large enough to store entire encoded image.
-
-int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 height,
-        etc1_uint32 pixelSize, etc1_uint32 stride, etc1_byte* pOut) {
-    if (pixelSize < 2 || pixelSize > 3) {
-        return -1;
-    }
+typedef struct {
+    const etc1_byte* pIn;
+    etc1_uint32 width;
+    etc1_uint32 height;
+    etc1_uint32 pixelSize;
+    etc1_uint32 stride;
+    etc1_byte* pOut;
+    int quality;
+    // Rows of blocks to encode, from firstRow up to but excluding endRow.
+    etc1_uint32 firstRow;
+    etc1_uint32 endRow;
+} etc_encode_job;
+
+static void etc_encode_rows(const etc_encode_job* pJob) {
     static const unsigned short kYMask[] = { 0x0, 0xf, 0xff, 0xfff, 0xffff };
     static const unsigned short kXMask[] = { 0x0, 0x1111, 0x3333, 0x7777,
             0xffff };
     etc1_byte block[ETC1_DECODED_BLOCK_SIZE];
     etc1_byte encoded[ETC1_ENCODED_BLOCK_SIZE];
 
+    const etc1_byte* pIn = pJob->pIn;
+    etc1_uint32 width = pJob->width;
+    etc1_uint32 height = pJob->height;
+    etc1_uint32 pixelSize = pJob->pixelSize;
+    etc1_uint32 stride = pJob->stride;
+
     etc1_uint32 encodedWidth = (width + 3) & ~3;
-    etc1_uint32 encodedHeight = (height + 3) & ~3;
+    etc1_byte* pOut = pJob->pOut
+            + pJob->firstRow * (encodedWidth / 4) * ETC1_ENCODED_BLOCK_SIZE;
 
-    for (etc1_uint32 y = 0; y < encodedHeight; y += 4) {
+    for (etc1_uint32 y = pJob->firstRow * 4; y < pJob->endRow * 4; y += 4) {
         etc1_uint32 yEnd = height - y;
         if (yEnd > 4) {
             yEnd = 4;
@@ -550,11 +640,102 @@ int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 heigh
                     }
                 }
             }
-            etc1_encode_block(block, mask, encoded);
+            etc_encode_block(block, mask, encoded, pJob->quality);
             memcpy(pOut, encoded, sizeof(encoded));
             pOut += sizeof(encoded);
         }
     }
+}
+
+#ifndef _WIN32
+static void* etc_encode_rows_thread(void* pJob) {
+    etc_encode_rows((const etc_encode_job*) pJob);
+    return NULL;
+}
+#endif
+
+// Encode an entire image.
+// pIn - pointer to the image data. Formatted such that the Red component of
+//       pixel (x,y) is at pIn + pixelSize * x + stride * y + redOffset;
+// pOut - pointer to encoded data. Must be large enough to store entire encoded image.
+
+int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 pixelSize, etc1_uint32 stride, etc1_byte* pOut) {
+    return etc1_encode_image_with_options(pIn, width, height, pixelSize, stride, pOut,
+            ETC1_QUALITY_HIGH, 1);
+}
+
+// Encode an entire image, with the given quality and number of threads.
+// Each thread encodes a band of consecutive rows of blocks, so the output
+// doesn't depend on the number of threads.
+
+int etc1_encode_image_with_options(const etc1_byte* pIn, etc1_uint32 width,
+        etc1_uint32 height, etc1_uint32 pixelSize, etc1_uint32 stride,
+        etc1_byte* pOut, int quality, etc1_uint32 threadCount) {
+    if (pixelSize < 2 || pixelSize > 3) {
+        return -1;
+    }
+    if (quality != ETC1_QUALITY_FAST && quality != ETC1_QUALITY_HIGH) {
+        return -1;
+    }
+
+    // Threads are not worth starting for less than this many rows of blocks each.
+    static const etc1_uint32 kMinRowsPerThread = 8;
+    static const etc1_uint32 kMaxThreads = 16;
+
+    etc1_uint32 rows = (height + 3) / 4;
+#ifdef _WIN32
+    threadCount = 1;
+#else
+    if (threadCount == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cpus > 0 ? (etc1_uint32) cpus : 1;
+    }
+#endif
+    if (threadCount > kMaxThreads) {
+        threadCount = kMaxThreads;
+    }
+    if (threadCount > rows / kMinRowsPerThread) {
+        threadCount = rows / kMinRowsPerThread;
+    }
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+
+    etc_encode_job jobs[kMaxThreads];
+    for (etc1_uint32 i = 0; i < threadCount; i++) {
+        etc_encode_job* pJob = &jobs[i];
+        pJob->pIn = pIn;
+        pJob->width = width;
+        pJob->height = height;
+        pJob->pixelSize = pixelSize;
+        pJob->stride = stride;
+        pJob->pOut = pOut;
+        pJob->quality = quality;
+        pJob->firstRow = rows * i / threadCount;
+        pJob->endRow = rows * (i + 1) / threadCount;
+    }
+
+#ifndef _WIN32
+    // The calling thread encodes the first band. A band whose thread can't be
+    // started is encoded by the calling thread as well.
+    pthread_t threads[kMaxThreads];
+    bool started[kMaxThreads];
+    for (etc1_uint32 i = 1; i < threadCount; i++) {
+        started[i] = pthread_create(&threads[i], NULL, etc_encode_rows_thread,
+                &jobs[i]) == 0;
+    }
+    etc_encode_rows(&jobs[0]);
+    for (etc1_uint32 i = 1; i < threadCount; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            etc_encode_rows(&jobs[i]);
+        }
+    }
+#else
+    etc_encode_rows(&jobs[0]);
+#endif
     return 0;
 }
 
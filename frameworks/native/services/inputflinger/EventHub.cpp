@@ -848,8 +848,16 @@ size_t EventHub::getEvents(int timeoutMillis, RawEvent* buffer, size_t bufferSiz
 
             Device* device = mDevices.valueAt(deviceIndex);
             if (eventItem.events & EPOLLIN) {
+                // Share the remaining capacity with the other devices that have events pending,
+                // so that a device reporting at a high rate cannot fill the whole buffer and
+                // delay the others until the next call.  Events left unread are still pending
+                // in the kernel and will be reported by the next epoll_wait().
+                size_t readCapacity = capacity / (countPendingDeviceEventsLocked() + 1);
+                if (readCapacity == 0) {
+                    readCapacity = 1;
+                }
                 int32_t readSize = read(device->fd, readBuffer,
-                        sizeof(struct input_event) * capacity);
+                        sizeof(struct input_event) * readCapacity);
                 if (readSize == 0 || (readSize < 0 && errno == ENODEV)) {
                     // Device was removed before INotify noticed.
                     ALOGW("could not get event, removed? (fd: %d size: %" PRId32
@@ -1033,6 +1041,7 @@ size_t EventHub::getEvents(int timeoutMillis, RawEvent* buffer, size_t bufferSiz
         } else {
             // Some events occurred.
             mPendingEventCount = size_t(pollResult);
+            prioritizePendingEventsLocked();
         }
     }
 
@@ -1040,6 +1049,39 @@ size_t EventHub::getEvents(int timeoutMillis, RawEvent* buffer, size_t bufferSiz
     return event - buffer;
 }
 
+void EventHub::prioritizePendingEventsLocked() {
+    // Handle touch devices first so that their events are returned ahead of those of
+    // other devices that became ready at the same time.  The relative order of all other
+    // items is preserved.
+    size_t front = 0;
+    for (size_t i = 0; i < mPendingEventCount; i++) {
+        ssize_t deviceIndex = mDevices.indexOfKey(mPendingEventItems[i].data.u32);
+        if (deviceIndex < 0 || !(mDevices.valueAt(deviceIndex)->classes
+                & (INPUT_DEVICE_CLASS_TOUCH | INPUT_DEVICE_CLASS_EXTERNAL_STYLUS))) {
+            continue;
+        }
+        if (i != front) {
+            struct epoll_event item = mPendingEventItems[i];
+            memmove(&mPendingEventItems[front + 1], &mPendingEventItems[front],
+                    (i - front) * sizeof(struct epoll_event));
+            mPendingEventItems[front] = item;
+        }
+        front += 1;
+    }
+}
+
+size_t EventHub::countPendingDeviceEventsLocked() const {
+    size_t count = 0;
+    for (size_t i = mPendingEventIndex; i < mPendingEventCount; i++) {
+        const struct epoll_event& eventItem = mPendingEventItems[i];
+        if (eventItem.data.u32 != EPOLL_ID_INOTIFY && eventItem.data.u32 != EPOLL_ID_WAKE
+                && (eventItem.events & EPOLLIN)) {
+            count += 1;
+        }
+    }
+    return count;
+}
+
 void EventHub::wake() {
     ALOGV("wake() called");
 
@@ -414,6 +414,9 @@ private:
     void scanDevicesLocked();
     status_t readNotifyLocked();
 
+    void prioritizePendingEventsLocked();
+    size_t countPendingDeviceEventsLocked() const;
+
     Device* getDeviceByDescriptorLocked(String8& descriptor) const;
     Device* getDeviceLocked(int32_t deviceId) const;
     Device* getDeviceByPathLocked(const char* devicePath) const;
@@ -307,6 +307,7 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t* nextWakeupTime) {
         } else {
             // Inbound queue has at least one entry.
             mPendingEvent = mInboundQueue.dequeueAtHead();
+            mPendingEvent->dequeueTime = currentTime;
             traceInboundQueueLengthLocked();
         }
 
@@ -407,6 +408,7 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t* nextWakeupTime) {
 
 bool InputDispatcher::enqueueInboundEventLocked(EventEntry* entry) {
     bool needWake = mInboundQueue.isEmpty();
+    entry->enqueueTime = now();
     mInboundQueue.enqueueAtTail(entry);
     traceInboundQueueLengthLocked();
 
@@ -475,24 +477,18 @@ void InputDispatcher::addRecentEventLocked(EventEntry* entry) {
 
 sp<InputWindowHandle> InputDispatcher::findTouchedWindowAtLocked(int32_t displayId,
         int32_t x, int32_t y) {
-    // Traverse windows from front to back to find touched window.
-    size_t numWindows = mWindowHandles.size();
-    for (size_t i = 0; i < numWindows; i++) {
-        sp<InputWindowHandle> windowHandle = mWindowHandles.itemAt(i);
+    // Traverse windows that may contain the point from front to back to find touched window.
+    mTouchHitIndex.getTouchCandidates(displayId, x, y, &mTempTouchCandidates);
+    size_t numCandidates = mTempTouchCandidates.size();
+    for (size_t i = 0; i < numCandidates; i++) {
+        sp<InputWindowHandle> windowHandle = mWindowHandles.itemAt(mTempTouchCandidates.itemAt(i));
         const InputWindowInfo* windowInfo = windowHandle->getInfo();
-        if (windowInfo->displayId == displayId) {
-            int32_t flags = windowInfo->layoutParamsFlags;
-
-            if (windowInfo->visible) {
-                if (!(flags & InputWindowInfo::FLAG_NOT_TOUCHABLE)) {
-                    bool isTouchModal = (flags & (InputWindowInfo::FLAG_NOT_FOCUSABLE
-                            | InputWindowInfo::FLAG_NOT_TOUCH_MODAL)) == 0;
-                    if (isTouchModal || windowInfo->touchableRegionContainsPoint(x, y)) {
-                        // Found window.
-                        return windowHandle;
-                    }
-                }
-            }
+        int32_t flags = windowInfo->layoutParamsFlags;
+        bool isTouchModal = (flags & (InputWindowInfo::FLAG_NOT_FOCUSABLE
+                | InputWindowInfo::FLAG_NOT_TOUCH_MODAL)) == 0;
+        if (isTouchModal || windowInfo->touchableRegionContainsPoint(x, y)) {
+            // Found window.
+            return windowHandle;
         }
     }
     return NULL;
@@ -1210,31 +1206,35 @@ int32_t InputDispatcher::findTouchedWindowTargetsLocked(nsecs_t currentTime,
         sp<InputWindowHandle> newTouchedWindowHandle;
         bool isTouchModal = false;
 
-        // Traverse windows from front to back to find touched window and outside targets.
-        size_t numWindows = mWindowHandles.size();
-        for (size_t i = 0; i < numWindows; i++) {
-            sp<InputWindowHandle> windowHandle = mWindowHandles.itemAt(i);
+        // Traverse windows that may contain the point from front to back to find
+        // touched window.
+        size_t touchedWindowIndex = mWindowHandles.size();
+        mTouchHitIndex.getTouchCandidates(displayId, x, y, &mTempTouchCandidates);
+        size_t numCandidates = mTempTouchCandidates.size();
+        for (size_t i = 0; i < numCandidates; i++) {
+            size_t windowIndex = mTempTouchCandidates.itemAt(i);
+            const sp<InputWindowHandle>& windowHandle = mWindowHandles.itemAt(windowIndex);
             const InputWindowInfo* windowInfo = windowHandle->getInfo();
-            if (windowInfo->displayId != displayId) {
-                continue; // wrong display
-            }
-
             int32_t flags = windowInfo->layoutParamsFlags;
-            if (windowInfo->visible) {
-                if (! (flags & InputWindowInfo::FLAG_NOT_TOUCHABLE)) {
-                    isTouchModal = (flags & (InputWindowInfo::FLAG_NOT_FOCUSABLE
-                            | InputWindowInfo::FLAG_NOT_TOUCH_MODAL)) == 0;
-                    if (isTouchModal || windowInfo->touchableRegionContainsPoint(x, y)) {
-                        newTouchedWindowHandle = windowHandle;
-                        break; // found touched window, exit window loop
-                    }
-                }
+            isTouchModal = (flags & (InputWindowInfo::FLAG_NOT_FOCUSABLE
+                    | InputWindowInfo::FLAG_NOT_TOUCH_MODAL)) == 0;
+            if (isTouchModal || windowInfo->touchableRegionContainsPoint(x, y)) {
+                newTouchedWindowHandle = windowHandle;
+                touchedWindowIndex = windowIndex;
+                break; // found touched window, exit window loop
+            }
+        }
 
-                if (maskedAction == AMOTION_EVENT_ACTION_DOWN
-                        && (flags & InputWindowInfo::FLAG_WATCH_OUTSIDE_TOUCH)) {
-                    mTempTouchState.addOrUpdateWindow(
-                            windowHandle, InputTarget::FLAG_DISPATCH_AS_OUTSIDE, BitSet32(0));
-                }
+        // Windows in front of the touched window that watch for outside touches
+        // are outside targets.
+        if (maskedAction == AMOTION_EVENT_ACTION_DOWN) {
+            const Vector<size_t>& outsideTouchWindows =
+                    mTouchHitIndex.getOutsideTouchWindows(displayId);
+            for (size_t i = 0; i < outsideTouchWindows.size()
+                    && outsideTouchWindows.itemAt(i) < touchedWindowIndex; i++) {
+                mTempTouchState.addOrUpdateWindow(
+                        mWindowHandles.itemAt(outsideTouchWindows.itemAt(i)),
+                        InputTarget::FLAG_DISPATCH_AS_OUTSIDE, BitSet32(0));
             }
         }
 
@@ -1436,18 +1436,14 @@ int32_t InputDispatcher::findTouchedWindowTargetsLocked(nsecs_t currentTime,
         sp<InputWindowHandle> foregroundWindowHandle =
                 mTempTouchState.getFirstForegroundWindowHandle();
         if (foregroundWindowHandle->getInfo()->hasWallpaper) {
-            for (size_t i = 0; i < mWindowHandles.size(); i++) {
-                sp<InputWindowHandle> windowHandle = mWindowHandles.itemAt(i);
-                const InputWindowInfo* info = windowHandle->getInfo();
-                if (info->displayId == displayId
-                        && windowHandle->getInfo()->layoutParamsType
-                                == InputWindowInfo::TYPE_WALLPAPER) {
-                    mTempTouchState.addOrUpdateWindow(windowHandle,
-                            InputTarget::FLAG_WINDOW_IS_OBSCURED
-                                    | InputTarget::FLAG_WINDOW_IS_PARTIALLY_OBSCURED
-                                    | InputTarget::FLAG_DISPATCH_AS_IS,
-                            BitSet32(0));
-                }
+            const Vector<size_t>& wallpaperWindows =
+                    mTouchHitIndex.getWallpaperWindows(displayId);
+            for (size_t i = 0; i < wallpaperWindows.size(); i++) {
+                mTempTouchState.addOrUpdateWindow(mWindowHandles.itemAt(wallpaperWindows.itemAt(i)),
+                        InputTarget::FLAG_WINDOW_IS_OBSCURED
+                                | InputTarget::FLAG_WINDOW_IS_PARTIALLY_OBSCURED
+                                | InputTarget::FLAG_DISPATCH_AS_IS,
+                        BitSet32(0));
             }
         }
     }
@@ -1957,6 +1953,7 @@ void InputDispatcher::enqueueDispatchEntryLocked(
     }
 
     // Enqueue the dispatch entry.
+    dispatchEntry->enqueueTime = now();
     connection->outboundQueue.enqueueAtTail(dispatchEntry);
     traceOutboundQueueLengthLocked(connection);
 }
@@ -2881,6 +2878,8 @@ void InputDispatcher::setInputWindows(const Vector<sp<InputWindowHandle> >& inpu
             mLastHoverWindowHandle = NULL;
         }
 
+        mTouchHitIndex.build(mWindowHandles);
+
         if (mFocusedWindowHandle != newFocusedWindowHandle) {
             if (mFocusedWindowHandle != NULL) {
 #if DEBUG_FOCUS
@@ -3573,6 +3572,7 @@ void InputDispatcher::doDispatchCycleFinishedLockedInterruptible(
             dispatchEntry->eventEntry->appendDescription(msg);
             ALOGI("%s", msg.string());
         }
+        recordLatencyLocked(connection, dispatchEntry, finishTime);
 
         bool restartEvent;
         if (dispatchEntry->eventEntry->type == EventEntry::TYPE_KEY) {
@@ -3803,6 +3803,37 @@ void InputDispatcher::updateDispatchStatisticsLocked(nsecs_t currentTime, const
     // TODO Write some statistics about how long we spend waiting.
 }
 
+void InputDispatcher::recordLatencyLocked(const sp<Connection>& connection,
+        const DispatchEntry* dispatchEntry, nsecs_t finishTime) {
+    // Only events from input devices that went through the whole pipeline are recorded,
+    // not injected or synthesized ones.
+    const EventEntry* entry = dispatchEntry->eventEntry;
+    if (entry->isInjected() || !entry->enqueueTime || !entry->dequeueTime) {
+        return;
+    }
+
+    int32_t deviceId;
+    switch (entry->type) {
+    case EventEntry::TYPE_KEY:
+        deviceId = static_cast<const KeyEntry*>(entry)->deviceId;
+        break;
+    case EventEntry::TYPE_MOTION:
+        deviceId = static_cast<const MotionEntry*>(entry)->deviceId;
+        break;
+    default:
+        return;
+    }
+
+    InputLatencyStats::Timeline timeline;
+    timeline.eventTime = entry->eventTime;
+    timeline.enqueueTime = entry->enqueueTime;
+    timeline.dequeueTime = entry->dequeueTime;
+    timeline.dispatchTime = dispatchEntry->enqueueTime;
+    timeline.deliveryTime = dispatchEntry->deliveryTime;
+    timeline.finishTime = finishTime;
+    mLatencyStats.record(deviceId, String8(connection->getWindowName()), timeline);
+}
+
 void InputDispatcher::traceInboundQueueLengthLocked() {
     if (ATRACE_ENABLED()) {
         ATRACE_INT("iq", mInboundQueue.count());
@@ -3830,6 +3861,7 @@ void InputDispatcher::dump(String8& dump) {
 
     dump.append("Input Dispatcher State:\n");
     dumpDispatchStateLocked(dump);
+    mLatencyStats.dump(dump);
 
     if (!mLastANRState.isEmpty()) {
         dump.append("\nInput Dispatcher State at time of last ANR:\n");
@@ -3872,7 +3904,7 @@ void InputDispatcher::InjectionState::release() {
 
 InputDispatcher::EventEntry::EventEntry(int32_t type, nsecs_t eventTime, uint32_t policyFlags) :
         refCount(1), type(type), eventTime(eventTime), policyFlags(policyFlags),
-        injectionState(NULL), dispatchInProgress(false) {
+        injectionState(NULL), enqueueTime(0), dequeueTime(0), dispatchInProgress(false) {
 }
 
 InputDispatcher::EventEntry::~EventEntry() {
@@ -4015,7 +4047,7 @@ InputDispatcher::DispatchEntry::DispatchEntry(EventEntry* eventEntry,
         seq(nextSeq()),
         eventEntry(eventEntry), targetFlags(targetFlags),
         xOffset(xOffset), yOffset(yOffset), scaleFactor(scaleFactor),
-        deliveryTime(0), resolvedAction(0), resolvedFlags(0) {
+        enqueueTime(0), deliveryTime(0), resolvedAction(0), resolvedFlags(0) {
     eventEntry->refCount += 1;
 }
 
@@ -34,6 +34,8 @@
 #include <limits.h>
 
 #include "InputWindow.h"
+#include "InputLatencyStats.h"
+#include "TouchHitIndex.h"
 #include "InputApplication.h"
 #include "InputListener.h"
 
@@ -440,6 +442,10 @@ private:
         uint32_t policyFlags;
         InjectionState* injectionState;
 
+        // Times when the event entered and left the inbound queue, or 0 if it never did.
+        nsecs_t enqueueTime;
+        nsecs_t dequeueTime;
+
         bool dispatchInProgress; // initially false, set to true while dispatching
 
         inline bool isInjected() const { return injectionState != NULL; }
@@ -546,6 +552,7 @@ private:
         float xOffset;
         float yOffset;
         float scaleFactor;
+        nsecs_t enqueueTime; // time when the event was queued for the connection
         nsecs_t deliveryTime; // time when the event was actually delivered
 
         // Set to the resolved action and flags when the event is enqueued.
@@ -954,6 +961,14 @@ private:
     bool mInputFilterEnabled;
 
     Vector<sp<InputWindowHandle> > mWindowHandles;
+    // Spatial index of mWindowHandles for finding touched windows
+    TouchHitIndex mTouchHitIndex;
+
+    // Latency of the events delivered to applications.
+    InputLatencyStats mLatencyStats;
+    void recordLatencyLocked(const sp<Connection>& connection,
+            const DispatchEntry* dispatchEntry, nsecs_t finishTime);
+    Vector<size_t> mTempTouchCandidates;
 
     sp<InputWindowHandle> getWindowHandleLocked(const sp<InputChannel>& inputChannel) const;
     bool hasWindowHandleLocked(const sp<InputWindowHandle>& windowHandle) const;
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "InputLatencyStats"
+#define ATRACE_TAG ATRACE_TAG_INPUT
+
+#include "InputLatencyStats.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <cutils/properties.h>
+#include <utils/Trace.h>
+
+#define INDENT "  "
+#define INDENT2 "    "
+#define INDENT3 "      "
+
+namespace android {
+
+static const char* STAGE_LABELS[] = {
+    "read", "inbound", "dispatch", "outbound", "app", "total",
+};
+
+InputLatencyStats::InputLatencyStats() :
+        mTraceInterval(property_get_int32("debug.input.latency_trace_interval", 0)),
+        mTraceCountdown(0) {
+}
+
+void InputLatencyStats::Histogram::add(nsecs_t latency) {
+    if (latency < 0) {
+        latency = 0;
+    }
+    nsecs_t micros = latency / 1000;
+    size_t bucket = 0;
+    while (bucket < BUCKET_COUNT - 1 && micros >= (nsecs_t(1) << bucket)) {
+        bucket += 1;
+    }
+    buckets[bucket] += 1;
+    count += 1;
+    total += latency;
+    if (latency > max) {
+        max = latency;
+    }
+}
+
+nsecs_t InputLatencyStats::Histogram::percentile(uint32_t percent) const {
+    // Report the upper bound of the bucket holding the percentile, but never more
+    // than the maximum seen.
+    uint64_t threshold = (count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT - 1; i++) {
+        seen += buckets[i];
+        if (seen >= threshold) {
+            nsecs_t bound = (nsecs_t(1) << i) * 1000;
+            return bound < max ? bound : max;
+        }
+    }
+    return max;
+}
+
+void InputLatencyStats::initializeEntry(Entry& entry) {
+    memset(&entry, 0, sizeof(entry));
+}
+
+void InputLatencyStats::addToEntry(Entry& entry, const nsecs_t latencies[STAGE_COUNT],
+        nsecs_t now) {
+    entry.lastUpdateTime = now;
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        entry.stages[i].add(latencies[i]);
+    }
+}
+
+void InputLatencyStats::record(int32_t deviceId, const String8& windowName,
+        const Timeline& timeline) {
+    nsecs_t latencies[STAGE_COUNT];
+    latencies[STAGE_READ] = timeline.enqueueTime - timeline.eventTime;
+    latencies[STAGE_INBOUND] = timeline.dequeueTime - timeline.enqueueTime;
+    latencies[STAGE_DISPATCH] = timeline.dispatchTime - timeline.dequeueTime;
+    latencies[STAGE_OUTBOUND] = timeline.deliveryTime - timeline.dispatchTime;
+    latencies[STAGE_APP] = timeline.finishTime - timeline.deliveryTime;
+    latencies[STAGE_TOTAL] = timeline.finishTime - timeline.eventTime;
+
+    ssize_t index = mDevices.indexOfKey(deviceId);
+    if (index < 0) {
+        Entry entry;
+        initializeEntry(entry);
+        index = mDevices.add(deviceId, entry);
+    }
+    addToEntry(mDevices.editValueAt(index), latencies, timeline.finishTime);
+
+    index = mWindows.indexOfKey(windowName);
+    if (index < 0) {
+        if (mWindows.size() >= MAX_WINDOWS) {
+            size_t oldest = 0;
+            for (size_t i = 1; i < mWindows.size(); i++) {
+                if (mWindows.valueAt(i).lastUpdateTime
+                        < mWindows.valueAt(oldest).lastUpdateTime) {
+                    oldest = i;
+                }
+            }
+            mWindows.removeItemsAt(oldest);
+        }
+        Entry entry;
+        initializeEntry(entry);
+        index = mWindows.add(windowName, entry);
+    }
+    addToEntry(mWindows.editValueAt(index), latencies, timeline.finishTime);
+
+    if (mTraceInterval) {
+        traceLatencies(latencies);
+    }
+}
+
+void InputLatencyStats::traceLatencies(const nsecs_t latencies[STAGE_COUNT]) {
+    if (mTraceCountdown > 0) {
+        mTraceCountdown -= 1;
+        return;
+    }
+    mTraceCountdown = mTraceInterval - 1;
+    if (ATRACE_ENABLED()) {
+        char counterName[40];
+        for (size_t i = 0; i < STAGE_COUNT; i++) {
+            snprintf(counterName, sizeof(counterName), "latency:%s", STAGE_LABELS[i]);
+            ATRACE_INT(counterName, int32_t(latencies[i] / 1000));
+        }
+    }
+}
+
+void InputLatencyStats::clear() {
+    mDevices.clear();
+    mWindows.clear();
+}
+
+void InputLatencyStats::dumpEntry(String8& dump, const Entry& entry) {
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        const Histogram& histogram = entry.stages[i];
+        dump.appendFormat(INDENT3 "%s: mean=%0.2fms, p50=%0.2fms, p90=%0.2fms, "
+                "p99=%0.2fms, max=%0.2fms\n", STAGE_LABELS[i],
+                histogram.count ? histogram.total / histogram.count * 0.000001f : 0.0f,
+                histogram.percentile(50) * 0.000001f, histogram.percentile(90) * 0.000001f,
+                histogram.percentile(99) * 0.000001f, histogram.max * 0.000001f);
+    }
+}
+
+void InputLatencyStats::dump(String8& dump) const {
+    dump.append(INDENT "Latency:\n");
+    if (mDevices.isEmpty()) {
+        dump.append(INDENT2 "<no events>\n");
+        return;
+    }
+    for (size_t i = 0; i < mDevices.size(); i++) {
+        const Entry& entry = mDevices.valueAt(i);
+        dump.appendFormat(INDENT2 "Device %d: events=%" PRIu64 "\n", mDevices.keyAt(i),
+                entry.stages[STAGE_TOTAL].count);
+        dumpEntry(dump, entry);
+    }
+    for (size_t i = 0; i < mWindows.size(); i++) {
+        const Entry& entry = mWindows.valueAt(i);
+        dump.appendFormat(INDENT2 "Window '%s': events=%" PRIu64 "\n",
+                mWindows.keyAt(i).string(), entry.stages[STAGE_TOTAL].count);
+        dumpEntry(dump, entry);
+    }
+}
+
+} // namespace android
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UI_INPUT_LATENCY_STATS_H
+#define _UI_INPUT_LATENCY_STATS_H
+
+#include <stdint.h>
+
+#include <utils/KeyedVector.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+/*
+ * Latency histograms of the input events delivered to applications, per input device
+ * and per window, broken down by the stage of the pipeline the events spent their time in.
+ *
+ * Times are recorded once the application has finished handling an event, and are
+ * bucketed by powers of two of microseconds.  Not thread-safe; the dispatcher calls it
+ * with its lock held.
+ */
+class InputLatencyStats {
+public:
+    enum Stage {
+        // From the kernel timestamp until the event was queued by the dispatcher,
+        // time spent in the EventHub and the InputReader.
+        STAGE_READ,
+        // Waiting in the dispatcher's inbound queue.
+        STAGE_INBOUND,
+        // From leaving the inbound queue until being queued for the connection,
+        // including the time spent waiting for the target window to become ready.
+        STAGE_DISPATCH,
+        // Waiting in the connection's outbound queue.
+        STAGE_OUTBOUND,
+        // From being published to the application until it finished handling the event.
+        STAGE_APP,
+        // From the kernel timestamp until the application finished handling the event.
+        STAGE_TOTAL,
+
+        STAGE_COUNT
+    };
+
+    /* The times an event reached each stage. */
+    struct Timeline {
+        nsecs_t eventTime;
+        nsecs_t enqueueTime;
+        nsecs_t dequeueTime;
+        nsecs_t dispatchTime;
+        nsecs_t deliveryTime;
+        nsecs_t finishTime;
+    };
+
+    InputLatencyStats();
+
+    void record(int32_t deviceId, const String8& windowName, const Timeline& timeline);
+    void clear();
+    void dump(String8& dump) const;
+
+    /* Emits the stage latencies of every Nth event as atrace counters, or of none if 0.
+     * Initially set from the debug.input.latency_trace_interval property. */
+    void setTraceInterval(uint32_t interval) { mTraceInterval = interval; }
+
+private:
+    // Bucket i counts latencies below 2^i us, the last one everything above.
+    static const size_t BUCKET_COUNT = 24;
+
+    // Maximum number of windows tracked; the least recently updated one is dropped.
+    static const size_t MAX_WINDOWS = 32;
+
+    struct Histogram {
+        uint64_t count;
+        nsecs_t total;
+        nsecs_t max;
+        uint32_t buckets[BUCKET_COUNT];
+
+        void add(nsecs_t latency);
+        nsecs_t percentile(uint32_t percent) const;
+    };
+
+    struct Entry {
+        nsecs_t lastUpdateTime;
+        Histogram stages[STAGE_COUNT];
+    };
+
+    KeyedVector<int32_t, Entry> mDevices;
+    KeyedVector<String8, Entry> mWindows;
+    uint32_t mTraceInterval;
+    uint32_t mTraceCountdown;
+
+    static void initializeEntry(Entry& entry);
+    static void addToEntry(Entry& entry, const nsecs_t latencies[STAGE_COUNT], nsecs_t now);
+    static void dumpEntry(String8& dump, const Entry& entry);
+    void traceLatencies(const nsecs_t latencies[STAGE_COUNT]);
+};
+
+} // namespace android
+
+#endif // _UI_INPUT_LATENCY_STATS_H
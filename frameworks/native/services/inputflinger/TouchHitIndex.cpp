@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "TouchHitIndex"
+
+#include "TouchHitIndex.h"
+
+#include <algorithm>
+
+namespace android {
+
+// Whether the window can only receive touches inside its touchable region
+static bool isIndexedByRegion(const InputWindowInfo* info) {
+    return info->visible
+            && !(info->layoutParamsFlags & InputWindowInfo::FLAG_NOT_TOUCHABLE)
+            && (info->layoutParamsFlags & (InputWindowInfo::FLAG_NOT_FOCUSABLE
+                    | InputWindowInfo::FLAG_NOT_TOUCH_MODAL)) != 0
+            && !info->touchableRegion.isEmpty();
+}
+
+TouchHitIndex::TouchHitIndex() {
+}
+
+TouchHitIndex::~TouchHitIndex() {
+    clear();
+}
+
+void TouchHitIndex::clear() {
+    for (size_t i = 0; i < mDisplays.size(); i++) {
+        delete mDisplays.valueAt(i);
+    }
+    mDisplays.clear();
+}
+
+TouchHitIndex::DisplayIndex* TouchHitIndex::editDisplayIndex(int32_t displayId) {
+    ssize_t index = mDisplays.indexOfKey(displayId);
+    if (index >= 0) {
+        return mDisplays.valueAt(index);
+    }
+    DisplayIndex* display = new DisplayIndex();
+    display->bounds = Rect::EMPTY_RECT;
+    display->cellWidth = 1;
+    display->cellHeight = 1;
+    mDisplays.add(displayId, display);
+    return display;
+}
+
+void TouchHitIndex::build(const Vector<sp<InputWindowHandle> >& windowHandles) {
+    clear();
+
+    // First find the area covered by the windows indexed in the grid.
+    size_t numWindows = windowHandles.size();
+    for (size_t i = 0; i < numWindows; i++) {
+        const InputWindowInfo* info = windowHandles.itemAt(i)->getInfo();
+        DisplayIndex* display = editDisplayIndex(info->displayId);
+        int32_t flags = info->layoutParamsFlags;
+
+        if (info->layoutParamsType == InputWindowInfo::TYPE_WALLPAPER) {
+            display->wallpaperWindows.add(i);
+        }
+        if (!info->visible) {
+            continue;
+        }
+        if (flags & InputWindowInfo::FLAG_WATCH_OUTSIDE_TOUCH) {
+            display->outsideTouchWindows.add(i);
+        }
+        if (flags & InputWindowInfo::FLAG_NOT_TOUCHABLE) {
+            continue;
+        }
+        if (!(flags & (InputWindowInfo::FLAG_NOT_FOCUSABLE
+                | InputWindowInfo::FLAG_NOT_TOUCH_MODAL))) {
+            display->modalWindows.add(i);
+            continue;
+        }
+        if (isIndexedByRegion(info)) {
+            Rect windowBounds = info->touchableRegion.getBounds();
+            Rect& bounds = display->bounds;
+            if (bounds.isEmpty()) {
+                bounds = windowBounds;
+            } else {
+                bounds.left = std::min(bounds.left, windowBounds.left);
+                bounds.top = std::min(bounds.top, windowBounds.top);
+                bounds.right = std::max(bounds.right, windowBounds.right);
+                bounds.bottom = std::max(bounds.bottom, windowBounds.bottom);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < mDisplays.size(); i++) {
+        DisplayIndex* display = mDisplays.valueAt(i);
+        if (!display->bounds.isEmpty()) {
+            display->cellWidth = (display->bounds.getWidth() + GRID_SIZE - 1) / GRID_SIZE;
+            display->cellHeight = (display->bounds.getHeight() + GRID_SIZE - 1) / GRID_SIZE;
+        }
+    }
+
+    // Then add each window to the cells its touchable region bounds intersect.
+    for (size_t i = 0; i < numWindows; i++) {
+        const InputWindowInfo* info = windowHandles.itemAt(i)->getInfo();
+        if (!isIndexedByRegion(info)) {
+            continue;
+        }
+        DisplayIndex* display = mDisplays.valueFor(info->displayId);
+        const Rect& bounds = display->bounds;
+        Rect windowBounds = info->touchableRegion.getBounds();
+        int32_t left = (windowBounds.left - bounds.left) / display->cellWidth;
+        int32_t right = (windowBounds.right - 1 - bounds.left) / display->cellWidth;
+        int32_t top = (windowBounds.top - bounds.top) / display->cellHeight;
+        int32_t bottom = (windowBounds.bottom - 1 - bounds.top) / display->cellHeight;
+        for (int32_t cy = top; cy <= bottom; cy++) {
+            for (int32_t cx = left; cx <= right; cx++) {
+                display->cells[cy * GRID_SIZE + cx].add(i);
+            }
+        }
+    }
+}
+
+void TouchHitIndex::getTouchCandidates(int32_t displayId, int32_t x, int32_t y,
+        Vector<size_t>* outIndices) const {
+    outIndices->clear();
+    ssize_t index = mDisplays.indexOfKey(displayId);
+    if (index < 0) {
+        return;
+    }
+    const DisplayIndex* display = mDisplays.valueAt(index);
+    const Vector<size_t>& modal = display->modalWindows;
+    const Rect& bounds = display->bounds;
+    if (x < bounds.left || x >= bounds.right || y < bounds.top || y >= bounds.bottom) {
+        outIndices->appendVector(modal);
+        return;
+    }
+
+    // Merge the modal windows with the cell's, keeping the z-order.
+    int32_t cx = (x - bounds.left) / display->cellWidth;
+    int32_t cy = (y - bounds.top) / display->cellHeight;
+    const Vector<size_t>& cell = display->cells[cy * GRID_SIZE + cx];
+    outIndices->setCapacity(modal.size() + cell.size());
+    size_t m = 0;
+    size_t c = 0;
+    while (m < modal.size() || c < cell.size()) {
+        if (c == cell.size() || (m < modal.size() && modal.itemAt(m) < cell.itemAt(c))) {
+            outIndices->add(modal.itemAt(m++));
+        } else {
+            outIndices->add(cell.itemAt(c++));
+        }
+    }
+}
+
+const Vector<size_t>& TouchHitIndex::getOutsideTouchWindows(int32_t displayId) const {
+    ssize_t index = mDisplays.indexOfKey(displayId);
+    return index >= 0 ? mDisplays.valueAt(index)->outsideTouchWindows : mEmpty;
+}
+
+const Vector<size_t>& TouchHitIndex::getWallpaperWindows(int32_t displayId) const {
+    ssize_t index = mDisplays.indexOfKey(displayId);
+    return index >= 0 ? mDisplays.valueAt(index)->wallpaperWindows : mEmpty;
+}
+
+} // namespace android
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _UI_INPUT_TOUCH_HIT_INDEX_H
+#define _UI_INPUT_TOUCH_HIT_INDEX_H
+
+#include <ui/Rect.h>
+#include <utils/KeyedVector.h>
+#include <utils/StrongPointer.h>
+#include <utils/Vector.h>
+
+#include "InputWindow.h"
+
+namespace android {
+
+/*
+ * Spatial index of the windows that can receive touches, used to avoid scanning
+ * every window for each new touch.
+ *
+ * Each display's touchable area is divided into a grid, and each cell lists the
+ * windows whose touchable region bounds intersect it. Windows are referred to by
+ * their index in the list passed to build(), which is in z-order (front first),
+ * so the index must be rebuilt whenever that list or the window info changes.
+ */
+class TouchHitIndex {
+public:
+    TouchHitIndex();
+    ~TouchHitIndex();
+
+    void build(const Vector<sp<InputWindowHandle> >& windowHandles);
+    void clear();
+
+    /* Replaces outIndices with the indices, in z-order, of the visible touchable
+     * windows on the display that may contain the point: touch modal windows, and
+     * windows whose touchable region bounds contain it. Callers still have to
+     * check the touchable region itself. */
+    void getTouchCandidates(int32_t displayId, int32_t x, int32_t y,
+            Vector<size_t>* outIndices) const;
+
+    /* Visible windows on the display that watch for outside touches, in z-order. */
+    const Vector<size_t>& getOutsideTouchWindows(int32_t displayId) const;
+
+    /* Wallpaper windows on the display, in z-order. */
+    const Vector<size_t>& getWallpaperWindows(int32_t displayId) const;
+
+private:
+    static const int32_t GRID_SIZE = 16;
+
+    struct DisplayIndex {
+        Rect bounds;
+        int32_t cellWidth;
+        int32_t cellHeight;
+        // Touch modal windows receive touches anywhere on the display
+        Vector<size_t> modalWindows;
+        Vector<size_t> cells[GRID_SIZE * GRID_SIZE];
+        Vector<size_t> outsideTouchWindows;
+        Vector<size_t> wallpaperWindows;
+    };
+
+    KeyedVector<int32_t, DisplayIndex*> mDisplays;
+    const Vector<size_t> mEmpty;
+
+    DisplayIndex* editDisplayIndex(int32_t displayId);
+
+    TouchHitIndex(const TouchHitIndex&);
+    TouchHitIndex& operator=(const TouchHitIndex&);
+};
+
+} // namespace android
+
+#endif // _UI_INPUT_TOUCH_HIT_INDEX_H
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../InputLatencyStats.h"
+
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+namespace android {
+
+static const nsecs_t MS = 1000000;
+
+static InputLatencyStats::Timeline makeTimeline(nsecs_t start, nsecs_t stageTime) {
+    InputLatencyStats::Timeline timeline;
+    timeline.eventTime = start;
+    timeline.enqueueTime = start + stageTime;
+    timeline.dequeueTime = start + 2 * stageTime;
+    timeline.dispatchTime = start + 3 * stageTime;
+    timeline.deliveryTime = start + 4 * stageTime;
+    timeline.finishTime = start + 5 * stageTime;
+    return timeline;
+}
+
+static bool contains(const String8& dump, const char* text) {
+    return strstr(dump.string(), text) != NULL;
+}
+
+TEST(InputLatencyStatsTest, Dump_WhenEmpty_ReportsNoEvents) {
+    InputLatencyStats stats;
+    String8 dump;
+    stats.dump(dump);
+    EXPECT_TRUE(contains(dump, "<no events>"));
+}
+
+TEST(InputLatencyStatsTest, Record_AddsEventToDeviceAndWindow) {
+    InputLatencyStats stats;
+    stats.record(3, String8("window"), makeTimeline(100 * MS, 1 * MS));
+    stats.record(3, String8("window"), makeTimeline(200 * MS, 1 * MS));
+
+    String8 dump;
+    stats.dump(dump);
+    EXPECT_TRUE(contains(dump, "Device 3: events=2\n"));
+    EXPECT_TRUE(contains(dump, "Window 'window': events=2\n"));
+    EXPECT_TRUE(contains(dump, "read: mean=1.00ms"));
+    EXPECT_TRUE(contains(dump, "total: mean=5.00ms"));
+    EXPECT_TRUE(contains(dump, "max=5.00ms"));
+}
+
+TEST(InputLatencyStatsTest, Record_WhenTooManyWindows_DropsLeastRecentlyUpdated) {
+    InputLatencyStats stats;
+    stats.record(1, String8("first"), makeTimeline(0, MS));
+    for (int i = 0; i < 32; i++) {
+        stats.record(1, String8::format("window %d", i), makeTimeline((i + 1) * MS, MS));
+    }
+    stats.record(1, String8("window 0"), makeTimeline(100 * MS, MS));
+
+    String8 dump;
+    stats.dump(dump);
+    EXPECT_FALSE(contains(dump, "'first'"));
+    EXPECT_TRUE(contains(dump, "Window 'window 0': events=2\n"));
+    EXPECT_TRUE(contains(dump, "Window 'window 31': events=1\n"));
+}
+
+TEST(InputLatencyStatsTest, Clear_RemovesAllEvents) {
+    InputLatencyStats stats;
+    stats.record(1, String8("window"), makeTimeline(0, MS));
+    stats.clear();
+
+    String8 dump;
+    stats.dump(dump);
+    EXPECT_TRUE(contains(dump, "<no events>"));
+}
+
+} // namespace android
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../TouchHitIndex.h"
+
+#include <gtest/gtest.h>
+
+namespace android {
+
+// An arbitrary display id.
+static const int32_t DISPLAY_ID = 0;
+
+// --- FakeWindowHandle ---
+
+class FakeWindowHandle : public InputWindowHandle {
+public:
+    FakeWindowHandle(int32_t displayId, const Rect& touchableRegion, int32_t flags) :
+            InputWindowHandle(NULL) {
+        mInfo = new InputWindowInfo();
+        mInfo->layoutParamsFlags = flags;
+        mInfo->layoutParamsType = InputWindowInfo::TYPE_APPLICATION;
+        mInfo->visible = true;
+        mInfo->displayId = displayId;
+        mInfo->addTouchableRegion(touchableRegion);
+    }
+
+    InputWindowInfo* editInfo() {
+        return mInfo;
+    }
+
+    virtual bool updateInfo() {
+        return true;
+    }
+};
+
+// --- TouchHitIndexTest ---
+
+class TouchHitIndexTest : public testing::Test {
+protected:
+    Vector<sp<InputWindowHandle> > mWindowHandles;
+    TouchHitIndex mIndex;
+
+    sp<FakeWindowHandle> addWindow(const Rect& touchableRegion,
+            int32_t flags = InputWindowInfo::FLAG_NOT_TOUCH_MODAL,
+            int32_t displayId = DISPLAY_ID) {
+        sp<FakeWindowHandle> windowHandle = new FakeWindowHandle(displayId, touchableRegion, flags);
+        mWindowHandles.add(windowHandle);
+        return windowHandle;
+    }
+
+    Vector<size_t> getCandidates(int32_t x, int32_t y, int32_t displayId = DISPLAY_ID) {
+        Vector<size_t> candidates;
+        mIndex.getTouchCandidates(displayId, x, y, &candidates);
+        return candidates;
+    }
+};
+
+TEST_F(TouchHitIndexTest, CandidatesContainPointInZOrder) {
+    addWindow(Rect(0, 0, 100, 100));
+    addWindow(Rect(500, 500, 600, 600));
+    addWindow(Rect(0, 0, 1000, 1000));
+    mIndex.build(mWindowHandles);
+
+    Vector<size_t> candidates = getCandidates(50, 50);
+    ASSERT_EQ(2U, candidates.size());
+    EXPECT_EQ(0U, candidates[0]);
+    EXPECT_EQ(2U, candidates[1]);
+
+    candidates = getCandidates(550, 550);
+    ASSERT_EQ(2U, candidates.size());
+    EXPECT_EQ(1U, candidates[0]);
+    EXPECT_EQ(2U, candidates[1]);
+
+    EXPECT_EQ(0U, getCandidates(2000, 2000).size());
+}
+
+TEST_F(TouchHitIndexTest, ModalWindowsAreAlwaysCandidates) {
+    addWindow(Rect(0, 0, 100, 100));
+    addWindow(Rect(0, 0, 10, 10), 0);
+    addWindow(Rect(0, 0, 1000, 1000));
+    mIndex.build(mWindowHandles);
+
+    Vector<size_t> candidates = getCandidates(50, 50);
+    ASSERT_EQ(3U, candidates.size());
+    EXPECT_EQ(0U, candidates[0]);
+    EXPECT_EQ(1U, candidates[1]);
+    EXPECT_EQ(2U, candidates[2]);
+
+    candidates = getCandidates(-10, 5000);
+    ASSERT_EQ(1U, candidates.size());
+    EXPECT_EQ(1U, candidates[0]);
+}
+
+TEST_F(TouchHitIndexTest, SkipsWindowsThatCannotBeTouched) {
+    addWindow(Rect(0, 0, 100, 100), InputWindowInfo::FLAG_NOT_TOUCH_MODAL
+            | InputWindowInfo::FLAG_NOT_TOUCHABLE);
+    addWindow(Rect(0, 0, 100, 100))->editInfo()->visible = false;
+    addWindow(Rect(0, 0, 100, 100), InputWindowInfo::FLAG_NOT_TOUCH_MODAL, DISPLAY_ID + 1);
+    addWindow(Rect(0, 0, 100, 100));
+    mIndex.build(mWindowHandles);
+
+    Vector<size_t> candidates = getCandidates(50, 50);
+    ASSERT_EQ(1U, candidates.size());
+    EXPECT_EQ(3U, candidates[0]);
+
+    candidates = getCandidates(50, 50, DISPLAY_ID + 1);
+    ASSERT_EQ(1U, candidates.size());
+    EXPECT_EQ(2U, candidates[0]);
+}
+
+TEST_F(TouchHitIndexTest, OutsideTouchAndWallpaperWindows) {
+    addWindow(Rect(0, 0, 100, 100), InputWindowInfo::FLAG_NOT_TOUCH_MODAL
+            | InputWindowInfo::FLAG_WATCH_OUTSIDE_TOUCH | InputWindowInfo::FLAG_NOT_TOUCHABLE);
+    addWindow(Rect(0, 0, 100, 100))->editInfo()->layoutParamsType =
+            InputWindowInfo::TYPE_WALLPAPER;
+    mIndex.build(mWindowHandles);
+
+    const Vector<size_t>& outside = mIndex.getOutsideTouchWindows(DISPLAY_ID);
+    ASSERT_EQ(1U, outside.size());
+    EXPECT_EQ(0U, outside[0]);
+    const Vector<size_t>& wallpapers = mIndex.getWallpaperWindows(DISPLAY_ID);
+    ASSERT_EQ(1U, wallpapers.size());
+    EXPECT_EQ(1U, wallpapers[0]);
+    EXPECT_EQ(0U, mIndex.getWallpaperWindows(DISPLAY_ID + 1).size());
+}
+
+} // namespace android
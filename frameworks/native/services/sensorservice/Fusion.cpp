@@ -487,7 +487,21 @@ void Fusion::predict(const vec3_t& w, float dT) {
     if (x0.w < 0)
         x0 = -x0;
 
-    P = Phi*P*transpose(Phi) + GQGt;
+    // Phi01 is 0 and Phi11 is I33, so only the non-trivial blocks of Phi*P*Phi' are computed:
+    //
+    //  P00 = (Phi00*P00 + Phi10*P01)*Phi00' + C*Phi10'
+    //  P10 = C = Phi00*P10 + Phi10*P11
+    //  P11 = P11
+    //
+    // which takes 6 3x3 matrix products instead of 16.
+    const mat33_t& Phi00(Phi[0][0]);
+    const mat33_t& Phi10(Phi[1][0]);
+    const mat33_t C(Phi00*P[1][0] + Phi10*P[1][1]);
+    P[0][0] = (Phi00*P[0][0] + Phi10*P[0][1])*transpose(Phi00) + C*transpose(Phi10)
+            + GQGt[0][0];
+    P[1][0] = C + GQGt[1][0];
+    P[1][1] += GQGt[1][1];
+    P[0][1] = transpose(P[1][0]);
 
     checkState();
 }
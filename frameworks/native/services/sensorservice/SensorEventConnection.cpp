@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <limits.h>
 #include <sys/socket.h>
 #include <utils/threads.h>
 
@@ -225,7 +226,9 @@ status_t SensorService::SensorEventConnection::sendEvents(
     // filter out events not for this connection
     int count = 0;
     Mutex::Autolock _l(mConnectionLock);
+    bool filtered = scratch != NULL;
     if (scratch) {
+        mSendRuns.clear();
         size_t i=0;
         while (i<numEvents) {
             int32_t sensor_handle = buffer[i].sensor;
@@ -271,12 +274,14 @@ status_t SensorService::SensorEventConnection::sendEvents(
                 // corresponding flush_complete_event.
                 if (buffer[i].type == SENSOR_TYPE_META_DATA) {
                     if (mapFlushEventsToConnections[i] == this) {
-                        scratch[count++] = buffer[i];
+                        addToSendRunsLocked(&buffer[i]);
+                        count++;
                     }
                     ++i;
                 } else {
-                    // Regular sensor event, just copy it to the scratch buffer.
-                    scratch[count++] = buffer[i++];
+                    // Regular sensor event, just add it to the runs to send.
+                    addToSendRunsLocked(&buffer[i++]);
+                    count++;
                 }
             } while ((i<numEvents) && ((buffer[i].sensor == sensor_handle &&
                                         buffer[i].type != SENSOR_TYPE_META_DATA) ||
@@ -297,6 +302,15 @@ status_t SensorService::SensorEventConnection::sendEvents(
 #if DEBUG_CONNECTIONS
      mEventsReceived += count;
 #endif
+    if (filtered) {
+        // Only copy the events for this connection out of the shared buffer if they cannot be
+        // sent straight from it.
+        if (sendRunsLocked(count)) {
+            return status_t(NO_ERROR);
+        }
+        copySendRunsLocked(scratch);
+    }
+
     if (mCacheSize != 0) {
         // There are some events in the cache which need to be sent first. Copy this buffer to
         // the end of cache.
@@ -516,6 +530,58 @@ int SensorService::SensorEventConnection::findWakeUpSensorEventLocked(
     return -1;
 }
 
+void SensorService::SensorEventConnection::addToSendRunsLocked(sensors_event_t const* event) {
+    if (!mSendRuns.empty()) {
+        struct iovec& run = mSendRuns.back();
+        if (static_cast<const char*>(run.iov_base) + run.iov_len
+                == reinterpret_cast<const char*>(event)) {
+            run.iov_len += sizeof(sensors_event_t);
+            return;
+        }
+    }
+    struct iovec run;
+    run.iov_base = const_cast<sensors_event_t*>(event);
+    run.iov_len = sizeof(sensors_event_t);
+    mSendRuns.push_back(run);
+}
+
+bool SensorService::SensorEventConnection::sendRunsLocked(size_t count) {
+    // Cached events have to be sent first, and the wake-up flag is set in a copy of the event
+    // since the buffer is shared with the other connections.
+    if (mCacheSize != 0 || mSendRuns.size() > IOV_MAX) {
+        return false;
+    }
+    for (size_t i = 0; i < mSendRuns.size(); i++) {
+        sensors_event_t const* events = static_cast<sensors_event_t const*>(
+                mSendRuns[i].iov_base);
+        size_t runCount = mSendRuns[i].iov_len / sizeof(sensors_event_t);
+        if (findWakeUpSensorEventLocked(events, static_cast<int>(runCount)) >= 0) {
+            return false;
+        }
+    }
+
+    // NOTE: ASensorEvent and sensors_event_t are the same type.
+    ssize_t size = BitTube::sendObjects(mChannel, mSendRuns.data(), mSendRuns.size(),
+            sizeof(ASensorEvent));
+    if (size < 0) {
+        return false;
+    }
+#if DEBUG_CONNECTIONS
+    mEventsSent += count;
+#else
+    UNUSED(count);
+#endif
+    return true;
+}
+
+void SensorService::SensorEventConnection::copySendRunsLocked(sensors_event_t* scratch) {
+    char* dest = reinterpret_cast<char*>(scratch);
+    for (size_t i = 0; i < mSendRuns.size(); i++) {
+        memcpy(dest, mSendRuns[i].iov_base, mSendRuns[i].iov_len);
+        dest += mSendRuns[i].iov_len;
+    }
+}
+
 sp<BitTube> SensorService::SensorEventConnection::getSensorChannel() const
 {
     return mChannel;
@@ -19,6 +19,9 @@
 
 #include <stdint.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+
+#include <vector>
 
 #include <utils/Vector.h>
 #include <utils/SortedVector.h>
@@ -88,6 +91,18 @@ private:
     // flag set. SOCK_SEQPACKET ensures that either the entire packet is read or dropped.
     int findWakeUpSensorEventLocked(sensors_event_t const* scratch, int count);
 
+    // Adds an event from the buffer passed to sendEvents() to mSendRuns, extending the last run
+    // if the event directly follows it.
+    void addToSendRunsLocked(sensors_event_t const* event);
+
+    // Sends the events in mSendRuns straight from the buffer they were filtered out of, if none
+    // of them needs to be cached or flagged for a wake-up ack. Returns false if they were not
+    // sent, in which case they have to be copied together and sent through the regular path.
+    bool sendRunsLocked(size_t count);
+
+    // Copies the events in mSendRuns into the scratch buffer.
+    void copySendRunsLocked(sensors_event_t* scratch);
+
     // Send pending flush_complete events. There may have been flush_complete_events that are
     // dropped which need to be sent separately before other events. On older HALs (1_0) this method
     // emulates the behavior of flush().
@@ -158,6 +173,10 @@ private:
 
     sensors_event_t *mEventCache;
     int mCacheSize, mMaxCacheSize;
+
+    // Runs of consecutive events for this connection in the buffer passed to sendEvents().
+    // Protected by mConnectionLock.
+    std::vector<struct iovec> mSendRuns;
     String8 mPackageName;
     const String16 mOpPackageName;
 #if DEBUG_CONNECTIONS
@@ -62,6 +62,8 @@ class SensorFusion : public Singleton<SensorFusion> {
 
 public:
     void process(const sensors_event_t& event);
+    // Processes a block of events in order, as if passed to process() one at a time.
+    void process(const sensors_event_t* events, size_t count);
 
     bool isEnabled() const {
         return mEnabled[FUSION_9AXIS] ||
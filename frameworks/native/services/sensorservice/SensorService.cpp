@@ -535,14 +535,13 @@ bool SensorService::threadLoop() {
              mSensorEventBuffer[i].flags = 0;
         }
 
-        // Make a copy of the connection vector as some connections may be removed during the course
-        // of this loop (especially when one-shot sensor events are present in the sensor_event
-        // buffer). Promote all connections to StrongPointers before the lock is acquired. If the
-        // destructor of the sp gets called when the lock is acquired, it may result in a deadlock
-        // as ~SensorEventConnection() needs to acquire mLock again for cleanup. So copy all the
-        // strongPointers to a vector before the lock is acquired.
+        // Strong pointers to the connections events are sent to. Some connections may be removed
+        // during the course of this loop (especially when one-shot sensor events are present in
+        // the sensor_event buffer). If the destructor of the sp gets called when the lock is
+        // acquired, it may result in a deadlock as ~SensorEventConnection() needs to acquire mLock
+        // again for cleanup. So the vector is declared before the lock is acquired, so that it is
+        // only destroyed after the lock is released.
         SortedVector< sp<SensorEventConnection> > activeConnections;
-        populateActiveConnections(&activeConnections);
 
         Mutex::Autolock _l(mLock);
         // Poll has returned. Hold a wakelock if one of the events is from a wake up sensor. The
@@ -570,9 +569,7 @@ bool SensorService::threadLoop() {
                 size_t k = 0;
                 SensorFusion& fusion(SensorFusion::getInstance());
                 if (fusion.isEnabled()) {
-                    for (size_t i=0 ; i<size_t(count) ; i++) {
-                        fusion.process(event[i]);
-                    }
+                    fusion.process(event, size_t(count));
                 }
                 for (size_t i=0 ; i<size_t(count) && k<minBufferSize ; i++) {
                     for (int handle : mActiveVirtualSensors) {
@@ -667,19 +664,26 @@ bool SensorService::threadLoop() {
                         ALOGE("Dynamic sensor release error.");
                     }
 
-                    size_t numConnections = activeConnections.size();
-                    for (size_t i=0 ; i < numConnections; ++i) {
-                        if (activeConnections[i] != NULL) {
-                            activeConnections[i]->removeSensor(handle);
+                    auto subscribers = mSubscribers.find(handle);
+                    if (subscribers != mSubscribers.end()) {
+                        for (size_t j = 0; j < subscribers->second.size(); ++j) {
+                            sp<SensorEventConnection> connection(
+                                    subscribers->second[j].promote());
+                            if (connection != NULL) {
+                                connection->removeSensor(handle);
+                                activeConnections.add(connection);
+                            }
                         }
+                        mSubscribers.erase(subscribers);
                     }
                 }
             }
         }
 
 
-        // Send our events to clients. Check the state of wake lock for each client and release the
-        // lock if none of the clients need it.
+        // Send our events to the clients that enabled their sensors. Check the state of wake lock
+        // for each of them, and release the lock if none of the clients need it.
+        populateSubscribedConnectionsLocked(mSensorEventBuffer, count, &activeConnections);
         bool needsWakeLock = false;
         size_t numConnections = activeConnections.size();
         for (size_t i=0 ; i < numConnections; ++i) {
@@ -697,7 +701,8 @@ bool SensorService::threadLoop() {
         }
 
         if (mWakeLockAcquired && !needsWakeLock) {
-            setWakeLockAcquiredLocked(false);
+            // Clients that were not sent events this time may still hold it.
+            checkWakeLockStateLocked();
         }
     } while (!Thread::exitPending());
 
@@ -1179,6 +1184,7 @@ void SensorService::cleanupConnection(SensorEventConnection* c) {
     }
     c->updateLooperRegistration(mLooper);
     mActiveConnections.remove(connection);
+    removeSubscriberLocked(connection);
     BatteryService::cleanup(c->getUid());
     if (c->needsWakeLock()) {
         checkWakeLockStateLocked();
@@ -1259,6 +1265,7 @@ status_t SensorService::enable(const sp<SensorEventConnection>& connection,
 
     if (connection->addSensor(handle)) {
         BatteryService::enableSensor(connection->getUid(), handle);
+        addSubscriberLocked(handle, connection);
         // the sensor was added (which means it wasn't already there)
         // so, see if this connection becomes active
         if (mActiveConnections.indexOf(connection) < 0) {
@@ -1360,6 +1367,7 @@ status_t SensorService::cleanupWithoutDisableLocked(
         if (connection->removeSensor(handle)) {
             BatteryService::disableSensor(connection->getUid(), handle);
         }
+        removeSubscriberLocked(handle, connection);
         if (connection->hasAnySensor() == false) {
             connection->updateLooperRegistration(mLooper);
             mActiveConnections.remove(connection);
@@ -1517,6 +1525,61 @@ void SensorService::populateActiveConnections(
     }
 }
 
+void SensorService::addSubscriberLocked(int handle,
+        const wp<SensorEventConnection>& connection) {
+    mSubscribers[handle].add(connection);
+}
+
+void SensorService::removeSubscriberLocked(int handle,
+        const wp<SensorEventConnection>& connection) {
+    auto subscribers = mSubscribers.find(handle);
+    if (subscribers != mSubscribers.end()) {
+        subscribers->second.remove(connection);
+        if (subscribers->second.isEmpty()) {
+            mSubscribers.erase(subscribers);
+        }
+    }
+}
+
+void SensorService::removeSubscriberLocked(const wp<SensorEventConnection>& connection) {
+    for (auto subscribers = mSubscribers.begin(); subscribers != mSubscribers.end(); ) {
+        subscribers->second.remove(connection);
+        if (subscribers->second.isEmpty()) {
+            subscribers = mSubscribers.erase(subscribers);
+        } else {
+            ++subscribers;
+        }
+    }
+}
+
+void SensorService::populateSubscribedConnectionsLocked(sensors_event_t const* buffer,
+        size_t count, SortedVector< sp<SensorEventConnection> >* connections) {
+    // Events usually come in runs from the same sensor, so only look up the subscribers when the
+    // sensor changes.
+    int lastHandle = -1;
+    bool first = true;
+    for (size_t i = 0; i < count; ++i) {
+        const int handle = buffer[i].type == SENSOR_TYPE_META_DATA ?
+                buffer[i].meta_data.sensor : buffer[i].sensor;
+        if (!first && handle == lastHandle) {
+            continue;
+        }
+        first = false;
+        lastHandle = handle;
+
+        auto subscribers = mSubscribers.find(handle);
+        if (subscribers == mSubscribers.end()) {
+            continue;
+        }
+        for (size_t j = 0; j < subscribers->second.size(); ++j) {
+            sp<SensorEventConnection> connection(subscribers->second[j].promote());
+            if (connection != NULL) {
+                connections->add(connection);
+            }
+        }
+    }
+}
+
 bool SensorService::isWhiteListedPackage(const String8& packageName) {
     return (packageName.contains(mWhiteListedPackage.string()));
 }
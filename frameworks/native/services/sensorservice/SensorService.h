@@ -205,6 +205,17 @@ private:
     // to the output vector.
     void populateActiveConnections( SortedVector< sp<SensorEventConnection> >* activeConnections);
 
+    // Maintain mSubscribers, the index of the connections that have each sensor enabled.
+    void addSubscriberLocked(int handle, const wp<SensorEventConnection>& connection);
+    void removeSubscriberLocked(int handle, const wp<SensorEventConnection>& connection);
+    void removeSubscriberLocked(const wp<SensorEventConnection>& connection);
+
+    // Promote the connections that have enabled any of the sensors with events in the buffer to
+    // strong references and add them to the output vector. As with populateActiveConnections(),
+    // the output vector must outlive mLock being held.
+    void populateSubscribedConnectionsLocked(sensors_event_t const* buffer, size_t count,
+            SortedVector< sp<SensorEventConnection> >* connections);
+
     // If SensorService is operating in RESTRICTED mode, only select whitelisted packages are
     // allowed to register for or call flush on sensors. Typically only cts test packages are
     // allowed.
@@ -242,6 +253,7 @@ private:
     DefaultKeyedVector<int, SensorRecord*> mActiveSensors;
     std::unordered_set<int> mActiveVirtualSensors;
     SortedVector< wp<SensorEventConnection> > mActiveConnections;
+    std::unordered_map<int, SortedVector< wp<SensorEventConnection> > > mSubscribers;
     bool mWakeLockAcquired;
     sensors_event_t *mSensorEventBuffer, *mSensorEventScratch;
     wp<const SensorEventConnection> * mMapFlushEventsToConnections;
@@ -12,6 +12,8 @@ LOCAL_SRC_FILES := \
     StartPropertySetThread.cpp \
     EventThread.cpp \
     FrameTracker.cpp \
+    PhaseOffsetTuner.cpp \
+    StageTimingTracker.cpp \
     GpuService.cpp \
     Layer.cpp \
     LayerDim.cpp \
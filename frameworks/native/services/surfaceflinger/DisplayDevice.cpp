@@ -347,6 +347,16 @@ void DisplayDevice::swapBuffers(HWComposer& hwc) const {
 }
 
 #ifdef USE_HWC2
+void DisplayDevice::reuseClientTarget() const {
+    // With no new buffer queued, advanceFrame() sets the current buffer as
+    // the client target again, which the HWC still holds in its cache
+    status_t result = mDisplaySurface->advanceFrame();
+    if (result != NO_ERROR) {
+        ALOGE("[%s] failed pushing previous frame to HWC: %d",
+                mDisplayName.string(), result);
+    }
+}
+
 void DisplayDevice::onSwapBuffersCompleted() const {
     mDisplaySurface->onFrameCommitted();
 }
@@ -414,6 +424,9 @@ Region DisplayDevice::getDirtyRegion(bool repaintEverything) const {
 // ----------------------------------------------------------------------------
 void DisplayDevice::setPowerMode(int mode) {
     mPowerMode = mode;
+#ifdef USE_HWC2
+    clientTargetState.layers.clear();
+#endif
 }
 
 int DisplayDevice::getPowerMode()  const {
@@ -498,6 +511,9 @@ status_t DisplayDevice::orientationToTransfrom(
 
 void DisplayDevice::setDisplaySize(const int newWidth, const int newHeight) {
     dirtyRegion.set(getBounds());
+#ifdef USE_HWC2
+    clientTargetState.layers.clear();
+#endif
 
     if (mSurface != EGL_NO_SURFACE) {
         eglDestroySurface(mDisplay, mSurface);
@@ -519,6 +535,9 @@ void DisplayDevice::setDisplaySize(const int newWidth, const int newHeight) {
 
 void DisplayDevice::setProjection(int orientation,
         const Rect& newViewport, const Rect& newFrame) {
+#ifdef USE_HWC2
+    clientTargetState.layers.clear();
+#endif
     Rect viewport(newViewport);
     Rect frame(newFrame);
 
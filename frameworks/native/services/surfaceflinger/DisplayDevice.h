@@ -41,6 +41,7 @@
 
 #ifdef USE_HWC2
 #include <memory>
+#include <vector>
 #endif
 
 struct ANativeWindow;
@@ -66,6 +67,33 @@ public:
     Region undefinedRegion;
     bool lastCompositionHadVisibleLayers;
 
+#ifdef USE_HWC2
+    // What the current client target buffer was composed from. SurfaceFlinger
+    // hands that buffer to the HWC again instead of redrawing it as long as
+    // none of it changed.
+    struct ClientTargetLayer {
+        int32_t sequence;
+        int32_t compositionType;
+        // whether the layer's area was cleared for device composition
+        bool cleared;
+        // in screen space
+        Region visibleRegion;
+
+        bool operator==(const ClientTargetLayer& rhs) const {
+            return sequence == rhs.sequence && compositionType == rhs.compositionType &&
+                    cleared == rhs.cleared && visibleRegion.hasSameRects(rhs.visibleRegion);
+        }
+    };
+    struct ClientTargetState {
+        // in z-order, empty when the client target can't be reused
+        std::vector<ClientTargetLayer> layers;
+        Region undefinedRegion;
+        bool hasDeviceComposition = false;
+        android_color_mode_t colorMode = HAL_COLOR_MODE_NATIVE;
+    };
+    mutable ClientTargetState clientTargetState;
+#endif
+
     enum DisplayType {
         DISPLAY_ID_INVALID = -1,
         DISPLAY_PRIMARY     = HWC_DISPLAY_PRIMARY,
@@ -155,6 +183,10 @@ public:
 #endif
 
     void swapBuffers(HWComposer& hwc) const;
+#ifdef USE_HWC2
+    // presents the current client target again without composing a new one
+    void reuseClientTarget() const;
+#endif
 #ifndef USE_HWC2
     status_t compositionComplete() const;
 #endif
@@ -21,6 +21,8 @@
 
 #include <cutils/compiler.h>
 
+#include <binder/IPCThreadState.h>
+
 #include <gui/IDisplayEventConnection.h>
 #include <gui/DisplayEventReceiver.h>
 
@@ -379,8 +381,11 @@ void EventThread::dump(String8& result) const {
     for (size_t i=0 ; i<mDisplayEventConnections.size() ; i++) {
         sp<Connection> connection =
                 mDisplayEventConnections.itemAt(i).promote();
-        result.appendFormat("    %p: count=%d\n",
-                connection.get(), connection!=NULL ? connection->count : 0);
+        if (connection != NULL) {
+            connection->dump(result);
+        } else {
+            result.appendFormat("    %p: count=0\n", connection.get());
+        }
     }
 }
 
@@ -388,7 +393,9 @@ void EventThread::dump(String8& result) const {
 
 EventThread::Connection::Connection(
         const sp<EventThread>& eventThread)
-    : count(-1), mEventThread(eventThread), mChannel(gui::BitTube::DefaultSize)
+    : count(-1), mEventThread(eventThread), mChannel(gui::BitTube::DefaultSize),
+      mPid(IPCThreadState::self()->getCallingPid()),
+      mEventsPosted(0), mEventsDropped(0), mPostDuration(0)
 {
 }
 
@@ -418,8 +425,25 @@ void EventThread::Connection::requestNextVsync() {
 
 status_t EventThread::Connection::postEvent(
         const DisplayEventReceiver::Event& event) {
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
     ssize_t size = DisplayEventReceiver::sendEvents(&mChannel, &event, 1);
-    return size < 0 ? status_t(size) : status_t(NO_ERROR);
+    mPostDuration += systemTime(SYSTEM_TIME_MONOTONIC) - start;
+    if (size < 0) {
+        mEventsDropped++;
+        return status_t(size);
+    }
+    mEventsPosted++;
+    return NO_ERROR;
+}
+
+void EventThread::Connection::dump(String8& result) const {
+    const uint32_t posted = mEventsPosted;
+    const uint32_t dropped = mEventsDropped;
+    const nsecs_t duration = mPostDuration;
+    result.appendFormat("    %p: count=%d pid=%d posted=%u dropped=%u"
+            " post-time=%.3fms (avg %.1fus)\n",
+            this, count, mPid, posted, dropped, duration / 1e6,
+            (posted + dropped) ? duration / 1e3 / (posted + dropped) : 0.0);
 }
 
 // ---------------------------------------------------------------------------
@@ -17,6 +17,8 @@
 #ifndef ANDROID_SURFACE_FLINGER_EVENT_THREAD_H
 #define ANDROID_SURFACE_FLINGER_EVENT_THREAD_H
 
+#include <atomic>
+
 #include <stdint.h>
 #include <sys/types.h>
 
@@ -66,6 +68,8 @@ class EventThread : public Thread, private VSyncSource::Callback {
         // count ==-1 : one-shot event that fired this round / disabled
         int32_t count;
 
+        void dump(String8& result) const;
+
     private:
         virtual ~Connection();
         virtual void onFirstRef();
@@ -74,6 +78,13 @@ class EventThread : public Thread, private VSyncSource::Callback {
         void requestNextVsync() override;    // asynchronous
         sp<EventThread> const mEventThread;
         gui::BitTube mChannel;
+
+        // Process that created the connection, and what delivering its events has cost,
+        // for dumpsys.
+        const pid_t mPid;
+        std::atomic<uint32_t> mEventsPosted;
+        std::atomic<uint32_t> mEventsDropped;
+        std::atomic<nsecs_t> mPostDuration;
     };
 
 public:
@@ -165,6 +165,9 @@ Layer::Layer(SurfaceFlinger* flinger, const sp<Client>& client,
     CompositorTiming compositorTiming;
     flinger->getCompositorTiming(&compositorTiming);
     mFrameEventHistory.initializeCompositorTiming(compositorTiming);
+
+    mAcquireTimeline.setMonitored(flinger->mUseFenceMonitor);
+    mReleaseTimeline.setMonitored(flinger->mUseFenceMonitor);
 }
 
 void Layer::onFirstRef() {
@@ -591,6 +594,9 @@ void Layer::setGeometry(
 #ifdef USE_HWC2
     const auto hwcId = displayDevice->getHwcDisplayId();
     auto& hwcInfo = mHwcLayers[hwcId];
+    // the geometry may override some of the per-frame state (e.g. the
+    // transform of solid color layers), send all of it again
+    hwcInfo.perFrameState = HWCInfo::PerFrameState();
 #else
     layer.setDefaultState();
 #endif
@@ -807,29 +813,42 @@ void Layer::setPerFrameData(const sp<const DisplayDevice>& displayDevice) {
     auto hwcId = displayDevice->getHwcDisplayId();
     auto& hwcInfo = mHwcLayers[hwcId];
     auto& hwcLayer = hwcInfo.layer;
-    auto error = hwcLayer->setVisibleRegion(visible);
-    if (error != HWC2::Error::None) {
-        ALOGE("[%s] Failed to set visible region: %s (%d)", mName.string(),
-                to_string(error).c_str(), static_cast<int32_t>(error));
-        visible.dump(LOG_TAG);
+    auto& sent = hwcInfo.perFrameState;
+    if (!sent.visibleRegionSet || !visible.hasSameRects(sent.visibleRegion)) {
+        auto error = hwcLayer->setVisibleRegion(visible);
+        sent.visibleRegionSet = error == HWC2::Error::None;
+        sent.visibleRegion = visible;
+        if (error != HWC2::Error::None) {
+            ALOGE("[%s] Failed to set visible region: %s (%d)", mName.string(),
+                    to_string(error).c_str(), static_cast<int32_t>(error));
+            visible.dump(LOG_TAG);
+        }
     }
 
-    error = hwcLayer->setSurfaceDamage(surfaceDamageRegion);
-    if (error != HWC2::Error::None) {
-        ALOGE("[%s] Failed to set surface damage: %s (%d)", mName.string(),
-                to_string(error).c_str(), static_cast<int32_t>(error));
-        surfaceDamageRegion.dump(LOG_TAG);
+    if (!sent.surfaceDamageSet || !surfaceDamageRegion.hasSameRects(sent.surfaceDamage)) {
+        auto error = hwcLayer->setSurfaceDamage(surfaceDamageRegion);
+        sent.surfaceDamageSet = error == HWC2::Error::None;
+        sent.surfaceDamage = surfaceDamageRegion;
+        if (error != HWC2::Error::None) {
+            ALOGE("[%s] Failed to set surface damage: %s (%d)", mName.string(),
+                    to_string(error).c_str(), static_cast<int32_t>(error));
+            surfaceDamageRegion.dump(LOG_TAG);
+        }
     }
 
     // Sideband layers
     if (mSidebandStream.get()) {
         setCompositionType(hwcId, HWC2::Composition::Sideband);
         ALOGV("[%s] Requesting Sideband composition", mName.string());
-        error = hwcLayer->setSidebandStream(mSidebandStream->handle());
-        if (error != HWC2::Error::None) {
-            ALOGE("[%s] Failed to set sideband stream %p: %s (%d)",
-                    mName.string(), mSidebandStream->handle(),
-                    to_string(error).c_str(), static_cast<int32_t>(error));
+        if (sent.sidebandStream != mSidebandStream->handle()) {
+            auto error = hwcLayer->setSidebandStream(mSidebandStream->handle());
+            sent.sidebandStream = error == HWC2::Error::None ?
+                    mSidebandStream->handle() : nullptr;
+            if (error != HWC2::Error::None) {
+                ALOGE("[%s] Failed to set sideband stream %p: %s (%d)",
+                        mName.string(), mSidebandStream->handle(),
+                        to_string(error).c_str(), static_cast<int32_t>(error));
+            }
         }
         return;
     }
@@ -845,9 +864,13 @@ void Layer::setPerFrameData(const sp<const DisplayDevice>& displayDevice) {
     // SolidColor layers
     if (mActiveBuffer == nullptr) {
         setCompositionType(hwcId, HWC2::Composition::SolidColor);
+        if (sent.solidColorSet) {
+            return;
+        }
 
         // For now, we only support black for DimLayer
-        error = hwcLayer->setColor({0, 0, 0, 255});
+        auto error = hwcLayer->setColor({0, 0, 0, 255});
+        sent.solidColorSet = error == HWC2::Error::None;
         if (error != HWC2::Error::None) {
             ALOGE("[%s] Failed to set color: %s (%d)", mName.string(),
                     to_string(error).c_str(), static_cast<int32_t>(error));
@@ -856,6 +879,7 @@ void Layer::setPerFrameData(const sp<const DisplayDevice>& displayDevice) {
         // Clear out the transform, because it doesn't make sense absent a
         // source buffer
         error = hwcLayer->setTransform(HWC2::Transform::None);
+        sent.solidColorSet &= error == HWC2::Error::None;
         if (error != HWC2::Error::None) {
             ALOGE("[%s] Failed to clear transform: %s (%d)", mName.string(),
                     to_string(error).c_str(), static_cast<int32_t>(error));
@@ -863,6 +887,9 @@ void Layer::setPerFrameData(const sp<const DisplayDevice>& displayDevice) {
 
         return;
     }
+    // the transform was cleared while this was a solid color layer, it is
+    // restored by the next geometry update
+    sent.solidColorSet = false;
 
     // Device or Cursor layers
     if (mPotentialCursor) {
@@ -873,12 +900,16 @@ void Layer::setPerFrameData(const sp<const DisplayDevice>& displayDevice) {
         setCompositionType(hwcId, HWC2::Composition::Device);
     }
 
-    ALOGV("setPerFrameData: dataspace = %d", mCurrentState.dataSpace);
-    error = hwcLayer->setDataspace(mCurrentState.dataSpace);
-    if (error != HWC2::Error::None) {
-        ALOGE("[%s] Failed to set dataspace %d: %s (%d)", mName.string(),
-              mCurrentState.dataSpace, to_string(error).c_str(),
-              static_cast<int32_t>(error));
+    if (!sent.dataspaceSet || sent.dataspace != mCurrentState.dataSpace) {
+        ALOGV("setPerFrameData: dataspace = %d", mCurrentState.dataSpace);
+        auto error = hwcLayer->setDataspace(mCurrentState.dataSpace);
+        sent.dataspaceSet = error == HWC2::Error::None;
+        sent.dataspace = mCurrentState.dataSpace;
+        if (error != HWC2::Error::None) {
+            ALOGE("[%s] Failed to set dataspace %d: %s (%d)", mName.string(),
+                  mCurrentState.dataSpace, to_string(error).c_str(),
+                  static_cast<int32_t>(error));
+        }
     }
 
     uint32_t hwcSlot = 0;
@@ -886,8 +917,17 @@ void Layer::setPerFrameData(const sp<const DisplayDevice>& displayDevice) {
     hwcInfo.bufferCache.getHwcBuffer(mActiveBufferSlot, mActiveBuffer,
             &hwcSlot, &hwcBuffer);
 
+    // A null hwcBuffer means the HWC already has this buffer in hwcSlot, if
+    // it is also the one it is displaying no new frame was latched
     auto acquireFence = mSurfaceFlingerConsumer->getCurrentFence();
-    error = hwcLayer->setBuffer(hwcSlot, hwcBuffer, acquireFence);
+    if (sent.bufferSet && hwcBuffer == nullptr && sent.bufferSlot == hwcSlot &&
+            sent.acquireFence == acquireFence) {
+        return;
+    }
+    auto error = hwcLayer->setBuffer(hwcSlot, hwcBuffer, acquireFence);
+    sent.bufferSet = error == HWC2::Error::None;
+    sent.bufferSlot = hwcSlot;
+    sent.acquireFence = acquireFence;
     if (error != HWC2::Error::None) {
         ALOGE("[%s] Failed to set buffer %p: %s (%d)", mName.string(),
                 mActiveBuffer->handle, to_string(error).c_str(),
@@ -1469,6 +1509,44 @@ void Layer::setVisibleNonTransparentRegion(const Region&
     this->visibleNonTransparentRegion = setVisibleNonTransparentRegion;
 }
 
+Layer::VisibilityInputs Layer::computeVisibilityInputs() const {
+    const Layer::State& s(getDrawingState());
+    VisibilityInputs inputs;
+    inputs.valid = true;
+    if (!isVisible()) {
+        return inputs;
+    }
+    inputs.bounds = computeScreenBounds();
+    inputs.transform = getTransform();
+    inputs.translucent = !isOpaque(s);
+    if (inputs.translucent) {
+        inputs.activeTransparentRegion = s.activeTransparentRegion;
+    }
+#ifdef USE_HWC2
+    const bool opaqueAlpha = s.alpha == 1.0f;
+#else
+    const bool opaqueAlpha = s.alpha == 0xFF;
+#endif
+    inputs.opaque = opaqueAlpha && !inputs.translucent &&
+            ((inputs.transform.getOrientation() & Transform::ROT_INVALID) == false);
+    return inputs;
+}
+
+bool Layer::VisibilityInputs::operator==(const VisibilityInputs& rhs) const {
+    // The transparent region is compared by storage: regions are copy on
+    // write so an untouched region shares its buffer, and a rewritten one is
+    // conservatively treated as changed.
+    return valid && rhs.valid &&
+            bounds == rhs.bounds &&
+            translucent == rhs.translucent &&
+            opaque == rhs.opaque &&
+            transform[0] == rhs.transform[0] &&
+            transform[1] == rhs.transform[1] &&
+            transform[2] == rhs.transform[2] &&
+            ((activeTransparentRegion.isEmpty() && rhs.activeTransparentRegion.isEmpty()) ||
+                    activeTransparentRegion.isTriviallyEqual(rhs.activeTransparentRegion));
+}
+
 // ----------------------------------------------------------------------------
 // transaction
 // ----------------------------------------------------------------------------
@@ -86,6 +86,26 @@ public:
     // the same.
     int32_t sequence;
 
+    // Everything SurfaceFlinger::computeVisibleRegions() derives a layer's
+    // regions from. Comparing a fresh snapshot against the one recorded at
+    // the last computation tells whether the layer's visibility can have
+    // changed.
+    struct VisibilityInputs {
+        // screen bounds of the layer, empty when the layer is hidden
+        Rect bounds;
+        Transform transform;
+        Region activeTransparentRegion;
+        bool translucent = false;
+        bool opaque = false;
+        bool valid = false;
+
+        bool operator==(const VisibilityInputs& rhs) const;
+        bool operator!=(const VisibilityInputs& rhs) const {
+            return !operator==(rhs);
+        }
+    };
+    VisibilityInputs lastVisibilityInputs;
+
     enum { // flags for doTransaction()
         eDontUpdateGeometryState = 0x00000001,
         eVisibleRegion = 0x00000002,
@@ -401,6 +421,12 @@ public:
     void setVisibleNonTransparentRegion(const Region&
             visibleNonTransparentRegion);
 
+    /*
+     * computeVisibilityInputs - snapshots the state the visible regions of
+     * this layer are computed from.
+     */
+    VisibilityInputs computeVisibilityInputs() const;
+
     /*
      * latchBuffer - called each time the screen is redrawn and returns whether
      * the visible regions need to be recomputed (this is a fairly heavy
@@ -764,6 +790,22 @@ private:
         Rect displayFrame;
         FloatRect sourceCrop;
         HWComposerBufferCache bufferCache;
+
+        // Per-frame state last sent to the HWC layer. HWC2 layer state
+        // persists across frames, so unchanged values aren't sent again.
+        struct PerFrameState {
+            bool visibleRegionSet = false;
+            Region visibleRegion;
+            bool surfaceDamageSet = false;
+            Region surfaceDamage;
+            bool dataspaceSet = false;
+            android_dataspace dataspace = HAL_DATASPACE_UNKNOWN;
+            bool solidColorSet = false;
+            const native_handle_t* sidebandStream = nullptr;
+            bool bufferSet = false;
+            uint32_t bufferSlot = 0;
+            sp<Fence> acquireFence;
+        } perFrameState;
     };
 
     // A layer can be attached to multiple displays when operating in mirror mode
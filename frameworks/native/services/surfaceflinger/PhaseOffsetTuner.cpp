@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <inttypes.h>
+
+#include <algorithm>
+
+#include <utils/String8.h>
+#include <utils/Trace.h>
+
+#include "PhaseOffsetTuner.h"
+
+namespace android {
+
+constexpr nsecs_t PhaseOffsetTuner::kStep;
+constexpr nsecs_t PhaseOffsetTuner::kMaxAdjustment;
+constexpr nsecs_t PhaseOffsetTuner::kSfMargin;
+
+PhaseOffsetTuner::PhaseOffsetTuner(nsecs_t appPhaseOffset, nsecs_t sfPhaseOffset) :
+        mEnabled(false),
+        mRefreshPeriod(0),
+        mConfigured{appPhaseOffset, sfPhaseOffset},
+        mCurrent{appPhaseOffset, sfPhaseOffset},
+        mSfFramesMissed(0),
+        mAppFramesLatched(0),
+        mAppFramesLate(0),
+        mSfHoldWindows(0),
+        mAppHoldWindows(0),
+        mWindowCount(0),
+        mTotalSfFramesMissed(0),
+        mTotalAppFramesLate(0),
+        mSfBackoffCount(0),
+        mAppBackoffCount(0),
+        mLastSfDuration95(0) {
+    mSfDurations.reserve(kWindowSize);
+}
+
+void PhaseOffsetTuner::setEnabled(bool enabled) {
+    Mutex::Autolock lock(mMutex);
+    mEnabled = enabled;
+    resetWindowLocked();
+}
+
+bool PhaseOffsetTuner::isEnabled() const {
+    Mutex::Autolock lock(mMutex);
+    return mEnabled;
+}
+
+void PhaseOffsetTuner::setRefreshPeriod(nsecs_t period) {
+    Mutex::Autolock lock(mMutex);
+    mRefreshPeriod = period;
+    resetWindowLocked();
+}
+
+void PhaseOffsetTuner::onSfFrameMissed() {
+    Mutex::Autolock lock(mMutex);
+    mSfFramesMissed++;
+    mTotalSfFramesMissed++;
+}
+
+void PhaseOffsetTuner::onAppFrames(size_t latched, size_t late) {
+    Mutex::Autolock lock(mMutex);
+    mAppFramesLatched += latched;
+    mAppFramesLate += late;
+    mTotalAppFramesLate += late;
+}
+
+bool PhaseOffsetTuner::onSfFrame(nsecs_t duration) {
+    Mutex::Autolock lock(mMutex);
+    if (!mEnabled || mRefreshPeriod <= 0) {
+        return false;
+    }
+
+    mSfDurations.push_back(duration);
+    if (mSfDurations.size() < kWindowSize) {
+        return false;
+    }
+
+    bool changed = updateOffsetsLocked();
+    resetWindowLocked();
+    return changed;
+}
+
+PhaseOffsetTuner::Offsets PhaseOffsetTuner::getOffsets() const {
+    Mutex::Autolock lock(mMutex);
+    return mCurrent;
+}
+
+bool PhaseOffsetTuner::updateOffsetsLocked() {
+    ATRACE_CALL();
+    mWindowCount++;
+
+    auto percentile95 = mSfDurations.begin() + (mSfDurations.size() * 95) / 100;
+    std::nth_element(mSfDurations.begin(), percentile95, mSfDurations.end());
+    mLastSfDuration95 = *percentile95;
+
+    Offsets offsets = mCurrent;
+
+    // A missed frame or two per window is expected from long transactions
+    // and client composition spikes
+    const nsecs_t sfLatest = mRefreshPeriod - mLastSfDuration95 - kSfMargin;
+    if (mSfFramesMissed > 1 || offsets.sf > sfLatest) {
+        offsets.sf -= kStep;
+        mSfHoldWindows = kHoldWindows;
+        mSfBackoffCount++;
+    } else if (mSfHoldWindows > 0) {
+        mSfHoldWindows--;
+    } else if (offsets.sf + kStep <= sfLatest) {
+        offsets.sf += kStep;
+    }
+
+    if (mAppFramesLate > std::max<size_t>(1, mAppFramesLatched / 100)) {
+        offsets.app -= kStep;
+        mAppHoldWindows = kHoldWindows;
+        mAppBackoffCount++;
+    } else if (mAppHoldWindows > 0) {
+        mAppHoldWindows--;
+    } else if (mAppFramesLatched > 0 && mAppFramesLate == 0) {
+        offsets.app += kStep;
+    }
+
+    offsets.sf = std::min(std::max(offsets.sf, mConfigured.sf - kMaxAdjustment),
+            mConfigured.sf + kMaxAdjustment);
+    offsets.app = std::min(std::max(offsets.app, mConfigured.app - kMaxAdjustment),
+            mConfigured.app + kMaxAdjustment);
+
+    bool changed = offsets.app != mCurrent.app || offsets.sf != mCurrent.sf;
+    mCurrent = offsets;
+    ATRACE_INT64("AppPhaseOffset", mCurrent.app);
+    ATRACE_INT64("SfPhaseOffset", mCurrent.sf);
+    return changed;
+}
+
+void PhaseOffsetTuner::resetWindowLocked() {
+    mSfDurations.clear();
+    mSfFramesMissed = 0;
+    mAppFramesLatched = 0;
+    mAppFramesLate = 0;
+}
+
+void PhaseOffsetTuner::dump(String8& result) const {
+    Mutex::Autolock lock(mMutex);
+    result.appendFormat("Phase offset tuner: %s\n", mEnabled ? "enabled" : "disabled");
+    result.appendFormat("  app phase %" PRId64 " ns (configured %" PRId64 " ns), "
+            "sf phase %" PRId64 " ns (configured %" PRId64 " ns)\n",
+            mCurrent.app, mConfigured.app, mCurrent.sf, mConfigured.sf);
+    result.appendFormat("  windows: %zu, sf backoffs: %zu, app backoffs: %zu\n",
+            mWindowCount, mSfBackoffCount, mAppBackoffCount);
+    result.appendFormat("  sf frames missed: %zu, app frames late: %zu\n",
+            mTotalSfFramesMissed, mTotalAppFramesLate);
+    result.appendFormat("  last window sf duration 95th percentile: %.2f ms\n",
+            mLastSfDuration95 / 1e6);
+}
+
+} // namespace android
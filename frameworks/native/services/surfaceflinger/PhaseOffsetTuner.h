@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANDROID_PHASE_OFFSET_TUNER_H
+#define ANDROID_PHASE_OFFSET_TUNER_H
+
+#include <stddef.h>
+
+#include <vector>
+
+#include <utils/Mutex.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+class String8;
+
+// PhaseOffsetTuner adapts the app and SurfaceFlinger vsync phase offsets to
+// the measured frame times. The configured offsets are the starting point,
+// and the tuned offsets stay within kMaxAdjustment of them.
+//
+// Once per window of frames, each offset is moved by kStep:
+//   - SurfaceFlinger wakes up later while its 95th percentile frame duration
+//     still fits before the next vsync, and earlier when it missed frames.
+//   - Apps wake up later while every queued buffer was ready in time for
+//     SurfaceFlinger to latch it, and earlier when buffers were not ready.
+// After moving an offset earlier, it is held for kHoldWindows windows so the
+// tuner doesn't keep oscillating around the point where frames start to drop.
+//
+// All the on*() methods are called from the SurfaceFlinger main thread.
+class PhaseOffsetTuner {
+public:
+    struct Offsets {
+        nsecs_t app;
+        nsecs_t sf;
+    };
+
+    PhaseOffsetTuner(nsecs_t appPhaseOffset, nsecs_t sfPhaseOffset);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    void setRefreshPeriod(nsecs_t period);
+
+    // onSfFrameMissed is called when SurfaceFlinger wakes up while the
+    // previous frame has not been presented yet.
+    void onSfFrameMissed();
+
+    // onAppFrames is called after latching buffers, with the number of
+    // layers that were latched and the number that had a buffer queued but
+    // not yet ready.
+    void onAppFrames(size_t latched, size_t late);
+
+    // onSfFrame is called at the end of each composition with the time
+    // SurfaceFlinger spent on the frame since waking up. Returns true when
+    // the offsets changed and should be applied to the event threads.
+    bool onSfFrame(nsecs_t duration);
+
+    Offsets getOffsets() const;
+
+    void dump(String8& result) const;
+
+private:
+    enum { kWindowSize = 120 };
+    enum { kHoldWindows = 10 };
+    static constexpr nsecs_t kStep = 500000;
+    static constexpr nsecs_t kMaxAdjustment = 4000000;
+    // Slack left between the end of composition and the next vsync
+    static constexpr nsecs_t kSfMargin = 1000000;
+
+    bool updateOffsetsLocked();
+    void resetWindowLocked();
+
+    mutable Mutex mMutex;
+
+    bool mEnabled;
+    nsecs_t mRefreshPeriod;
+    const Offsets mConfigured;
+    Offsets mCurrent;
+
+    // The current window
+    std::vector<nsecs_t> mSfDurations;
+    size_t mSfFramesMissed;
+    size_t mAppFramesLatched;
+    size_t mAppFramesLate;
+
+    size_t mSfHoldWindows;
+    size_t mAppHoldWindows;
+
+    // Statistics
+    size_t mWindowCount;
+    size_t mTotalSfFramesMissed;
+    size_t mTotalAppFramesLate;
+    size_t mSfBackoffCount;
+    size_t mAppBackoffCount;
+    nsecs_t mLastSfDuration95;
+};
+
+}
+
+#endif // ANDROID_PHASE_OFFSET_TUNER_H
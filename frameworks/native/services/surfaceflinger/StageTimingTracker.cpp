@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <limits>
+
+#include <binder/Parcel.h>
+#include <utils/String8.h>
+
+#include "StageTimingTracker.h"
+
+namespace android {
+
+StageTimingTracker::StageTimingTracker() :
+        mEnabled(false) {
+    clearLocked();
+}
+
+void StageTimingTracker::setEnabled(bool enabled) {
+    Mutex::Autolock lock(mMutex);
+    if (enabled) {
+        clearLocked();
+        for (StageSamples& stage : mStages) {
+            stage.samples.reserve(kMaxSamples);
+        }
+    }
+    mEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void StageTimingTracker::record(Stage stage, nsecs_t duration) {
+    if (!isEnabled() || stage < 0 || stage >= STAGE_COUNT) {
+        return;
+    }
+    Mutex::Autolock lock(mMutex);
+    StageSamples& s = mStages[stage];
+    if (s.samples.size() < kMaxSamples) {
+        s.samples.push_back(duration);
+    } else {
+        s.samples[s.next] = duration;
+    }
+    s.next = (s.next + 1) % kMaxSamples;
+    s.count++;
+    s.min = std::min(s.min, duration);
+    s.total += duration;
+    s.max = std::max(s.max, duration);
+}
+
+StageTimingTracker::Stats StageTimingTracker::getStats(Stage stage) const {
+    Stats stats = {};
+    if (stage < 0 || stage >= STAGE_COUNT) {
+        return stats;
+    }
+
+    std::vector<nsecs_t> sorted;
+    {
+        Mutex::Autolock lock(mMutex);
+        const StageSamples& s = mStages[stage];
+        if (s.count == 0) {
+            return stats;
+        }
+        stats.count = s.count;
+        stats.min = s.min;
+        stats.mean = s.total / static_cast<nsecs_t>(s.count);
+        stats.max = s.max;
+        sorted = s.samples;
+    }
+
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](size_t p) {
+        return sorted[std::min(sorted.size() - 1, sorted.size() * p / 100)];
+    };
+    stats.p50 = percentile(50);
+    stats.p90 = percentile(90);
+    stats.p99 = percentile(99);
+    return stats;
+}
+
+void StageTimingTracker::writeToParcel(Parcel* parcel) const {
+    parcel->writeInt32(STAGE_COUNT);
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const Stats stats = getStats(static_cast<Stage>(i));
+        parcel->writeInt64(static_cast<int64_t>(stats.count));
+        parcel->writeInt64(stats.min);
+        parcel->writeInt64(stats.mean);
+        parcel->writeInt64(stats.p50);
+        parcel->writeInt64(stats.p90);
+        parcel->writeInt64(stats.p99);
+        parcel->writeInt64(stats.max);
+    }
+}
+
+void StageTimingTracker::dump(String8& result) const {
+    result.appendFormat("Stage timing: %s\n", isEnabled() ? "enabled" : "disabled");
+    result.append("  stage               count      min     mean      p50      p90      p99"
+            "      max (us)\n");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const Stage stage = static_cast<Stage>(i);
+        const Stats stats = getStats(stage);
+        result.appendFormat("  %-16s %8zu %8" PRId64 " %8" PRId64 " %8" PRId64 " %8" PRId64
+                " %8" PRId64 " %8" PRId64 "\n", getStageName(stage), stats.count,
+                ns2us(stats.min), ns2us(stats.mean), ns2us(stats.p50), ns2us(stats.p90),
+                ns2us(stats.p99), ns2us(stats.max));
+    }
+}
+
+const char* StageTimingTracker::getStageName(Stage stage) {
+    switch (stage) {
+        case TRANSACTION: return "transaction";
+        case LATCH: return "latch";
+        case PRE_COMPOSITION: return "pre-composition";
+        case VISIBLE_REGIONS: return "visible-regions";
+        case SET_UP_HWC: return "set-up-hwc";
+        case COMPOSITION: return "composition";
+        case POST_COMPOSITION: return "post-composition";
+        default: return "unknown";
+    }
+}
+
+void StageTimingTracker::clearLocked() {
+    for (StageSamples& stage : mStages) {
+        stage.samples.clear();
+        stage.next = 0;
+        stage.count = 0;
+        stage.min = std::numeric_limits<nsecs_t>::max();
+        stage.total = 0;
+        stage.max = 0;
+    }
+}
+
+} // namespace android
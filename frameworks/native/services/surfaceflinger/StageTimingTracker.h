@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANDROID_STAGE_TIMING_TRACKER_H
+#define ANDROID_STAGE_TIMING_TRACKER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include <utils/Mutex.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+class Parcel;
+class String8;
+
+// StageTimingTracker records how long the SurfaceFlinger main thread spends in
+// each stage of a frame, so that benchmarks can measure the CPU cost of
+// composition independently of the GPU and the display. It is disabled by
+// default; record() is a single relaxed load while disabled.
+//
+// record() is called from the SurfaceFlinger main thread; the other methods
+// may be called from binder threads.
+class StageTimingTracker {
+public:
+    enum Stage {
+        TRANSACTION = 0,
+        LATCH,
+        PRE_COMPOSITION,
+        VISIBLE_REGIONS,
+        SET_UP_HWC,
+        COMPOSITION,
+        POST_COMPOSITION,
+        STAGE_COUNT
+    };
+
+    struct Stats {
+        size_t count;
+        nsecs_t min;
+        nsecs_t mean;
+        nsecs_t p50;
+        nsecs_t p90;
+        nsecs_t p99;
+        nsecs_t max;
+    };
+
+    // Times the enclosing scope and records it against a stage
+    class Scope {
+    public:
+        Scope(StageTimingTracker& tracker, Stage stage)
+            : mTracker(tracker), mStage(stage),
+              mStart(tracker.isEnabled() ? systemTime(SYSTEM_TIME_MONOTONIC) : 0) {}
+        ~Scope() {
+            if (mStart != 0) {
+                mTracker.record(mStage, systemTime(SYSTEM_TIME_MONOTONIC) - mStart);
+            }
+        }
+    private:
+        StageTimingTracker& mTracker;
+        const Stage mStage;
+        const nsecs_t mStart;
+    };
+
+    StageTimingTracker();
+
+    // Enabling the tracker discards previously recorded samples
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+
+    void record(Stage stage, nsecs_t duration);
+
+    Stats getStats(Stage stage) const;
+
+    // Writes STAGE_COUNT followed by the Stats of each stage, as int64s
+    void writeToParcel(Parcel* parcel) const;
+
+    void dump(String8& result) const;
+
+    static const char* getStageName(Stage stage);
+
+private:
+    // Samples kept per stage for the percentiles; older samples still count
+    // towards the count, min, mean and max.
+    enum { kMaxSamples = 4096 };
+
+    struct StageSamples {
+        std::vector<nsecs_t> samples;
+        size_t next;
+        size_t count;
+        nsecs_t min;
+        nsecs_t total;
+        nsecs_t max;
+    };
+
+    void clearLocked();
+
+    std::atomic<bool> mEnabled;
+
+    mutable Mutex mMutex;
+    StageSamples mStages[STAGE_COUNT];
+};
+
+}
+
+#endif // ANDROID_STAGE_TIMING_TRACKER_H
@@ -36,6 +36,7 @@
 #include <binder/IPCThreadState.h>
 #include <binder/IServiceManager.h>
 #include <binder/PermissionCache.h>
+#include <binder/ProcessState.h>
 
 #include <dvr/vr_flinger.h>
 
@@ -225,6 +226,12 @@ SurfaceFlinger::SurfaceFlinger()
     mPropagateBackpressure = !atoi(value);
     ALOGI_IF(!mPropagateBackpressure, "Disabling backpressure propagation");
 
+    mPhaseOffsetTuner = std::make_unique<PhaseOffsetTuner>(
+            vsyncPhaseOffsetNs, sfVsyncPhaseOffsetNs);
+    property_get("debug.sf.adaptive_phase_offsets", value, "0");
+    mPhaseOffsetTuner->setEnabled(atoi(value));
+    ALOGI_IF(mPhaseOffsetTuner->isEnabled(), "Enabling adaptive phase offsets");
+
     property_get("debug.sf.enable_hwc_vds", value, "0");
     mUseHwcVirtualDisplays = atoi(value);
     ALOGI_IF(!mUseHwcVirtualDisplays, "Enabling HWC virtual displays");
@@ -233,6 +240,12 @@ SurfaceFlinger::SurfaceFlinger()
     mLayerTripleBufferingDisabled = atoi(value);
     ALOGI_IF(mLayerTripleBufferingDisabled, "Disabling Triple Buffering");
 
+    property_get("debug.sf.disable_fence_monitor", value, "0");
+    mUseFenceMonitor = !atoi(value);
+    ALOGI_IF(!mUseFenceMonitor, "Disabling the fence monitor");
+    mGlCompositionDoneTimeline.setMonitored(mUseFenceMonitor);
+    mDisplayTimeline.setMonitored(mUseFenceMonitor);
+
     // We should be reading 'persist.sys.sf.color_saturation' here
     // but since /data may be encrypted, we need to wait until after vold
     // comes online to attempt to read the property. The property is
@@ -1388,6 +1401,7 @@ void SurfaceFlinger::updateVrFlinger() {
         const auto& activeConfig = mHwc->getActiveConfig(HWC_DISPLAY_PRIMARY);
         const nsecs_t period = activeConfig->getVsyncPeriod();
         mAnimFrameTracker.setDisplayRefreshPeriod(period);
+        mPhaseOffsetTuner->setRefreshPeriod(period);
 
         // Use phase of 0 since phase is not known.
         // Use latency of 0, which will snap to the ideal latency.
@@ -1403,11 +1417,15 @@ void SurfaceFlinger::onMessageReceived(int32_t what) {
     ATRACE_CALL();
     switch (what) {
         case MessageQueue::INVALIDATE: {
+            mFrameStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
             bool frameMissed = !mHadClientComposition &&
                     mPreviousPresentFence != Fence::NO_FENCE &&
                     (mPreviousPresentFence->getSignalTime() ==
                             Fence::SIGNAL_TIME_PENDING);
             ATRACE_INT("FrameMissed", static_cast<int>(frameMissed));
+            if (frameMissed) {
+                mPhaseOffsetTuner->onSfFrameMissed();
+            }
             if (mPropagateBackpressure && frameMissed) {
                 signalLayerUpdate();
                 break;
@@ -1437,6 +1455,8 @@ void SurfaceFlinger::onMessageReceived(int32_t what) {
 }
 
 bool SurfaceFlinger::handleMessageTransaction() {
+    StageTimingTracker::Scope timing(mStageTiming, StageTimingTracker::TRANSACTION);
+    applyQueuedTransactions();
     uint32_t transactionFlags = peekTransactionFlags();
     if (transactionFlags) {
         handleTransaction(transactionFlags);
@@ -1447,6 +1467,7 @@ bool SurfaceFlinger::handleMessageTransaction() {
 
 bool SurfaceFlinger::handleMessageInvalidate() {
     ATRACE_CALL();
+    StageTimingTracker::Scope timing(mStageTiming, StageTimingTracker::LATCH);
     return handlePageFlip();
 }
 
@@ -1457,12 +1478,27 @@ void SurfaceFlinger::handleMessageRefresh() {
 
     nsecs_t refreshStartTime = systemTime(SYSTEM_TIME_MONOTONIC);
 
-    preComposition(refreshStartTime);
-    rebuildLayerStacks();
-    setUpHWComposer();
+    {
+        StageTimingTracker::Scope timing(mStageTiming, StageTimingTracker::PRE_COMPOSITION);
+        preComposition(refreshStartTime);
+    }
+    {
+        StageTimingTracker::Scope timing(mStageTiming, StageTimingTracker::VISIBLE_REGIONS);
+        rebuildLayerStacks();
+    }
+    {
+        StageTimingTracker::Scope timing(mStageTiming, StageTimingTracker::SET_UP_HWC);
+        setUpHWComposer();
+    }
     doDebugFlashRegions();
-    doComposition();
-    postComposition(refreshStartTime);
+    {
+        StageTimingTracker::Scope timing(mStageTiming, StageTimingTracker::COMPOSITION);
+        doComposition();
+    }
+    {
+        StageTimingTracker::Scope timing(mStageTiming, StageTimingTracker::POST_COMPOSITION);
+        postComposition(refreshStartTime);
+    }
 
     mPreviousPresentFence = mHwc->getPresentFence(HWC_DISPLAY_PRIMARY);
 
@@ -1474,6 +1510,16 @@ void SurfaceFlinger::handleMessageRefresh() {
     }
 
     mLayersWithQueuedFrames.clear();
+
+    // A refresh that wasn't preceded by an invalidate starts on its own
+    const nsecs_t frameStartTime = (mFrameStartTime > 0 && mFrameStartTime <= refreshStartTime) ?
+            mFrameStartTime : refreshStartTime;
+    mFrameStartTime = 0;
+    if (mPhaseOffsetTuner->onSfFrame(systemTime(SYSTEM_TIME_MONOTONIC) - frameStartTime)) {
+        const PhaseOffsetTuner::Offsets offsets = mPhaseOffsetTuner->getOffsets();
+        mEventThread->setPhaseOffset(offsets.app);
+        mSFEventThread->setPhaseOffset(offsets.sf);
+    }
 }
 
 void SurfaceFlinger::doDebugFlashRegions()
@@ -1708,6 +1754,9 @@ void SurfaceFlinger::rebuildLayerStacks() {
         mVisibleRegionsDirty = false;
         invalidateHwcGeometry();
 
+        // displays mirroring the same layer stack share its regions
+        std::map<uint32_t, std::pair<Region, Region>> computedLayerStacks;
+
         for (size_t dpy=0 ; dpy<mDisplays.size() ; dpy++) {
             Region opaqueRegion;
             Region dirtyRegion;
@@ -1716,9 +1765,16 @@ void SurfaceFlinger::rebuildLayerStacks() {
             const Transform& tr(displayDevice->getTransform());
             const Rect bounds(displayDevice->getBounds());
             if (displayDevice->isDisplayOn()) {
-                computeVisibleRegions(
-                        displayDevice->getLayerStack(), dirtyRegion,
-                        opaqueRegion);
+                const uint32_t layerStack = displayDevice->getLayerStack();
+                auto computed = computedLayerStacks.find(layerStack);
+                if (computed == computedLayerStacks.end()) {
+                    computeVisibleRegions(layerStack, dirtyRegion, opaqueRegion);
+                    computedLayerStacks.emplace(layerStack,
+                            std::make_pair(dirtyRegion, opaqueRegion));
+                } else {
+                    dirtyRegion = computed->second.first;
+                    opaqueRegion = computed->second.second;
+                }
 
                 mDrawingState.traverseInZOrder([&](Layer* layer) {
                     if (layer->getLayerStack() == displayDevice->getLayerStack()) {
@@ -1883,6 +1939,8 @@ void SurfaceFlinger::setUpHWComposer() {
             continue;
         }
         if (colorMatrix != mPreviousColorMatrix) {
+            // the client target may have the old matrix applied
+            displayDevice->clientTargetState.layers.clear();
             status_t result = mHwc->setColorTransform(hwcId, colorMatrix);
             ALOGE_IF(result != NO_ERROR, "Failed to set color transform on "
                     "display %zd: %d", displayId, result);
@@ -2340,136 +2398,202 @@ void SurfaceFlinger::commitTransaction()
     mTransactionCV.broadcast();
 }
 
+// Computes the regions of a single layer given the union of the footprints
+// and of the opaque regions of the layers above it. Only the parts of those
+// unions overlapping the layer's old or new footprint matter.
+static void computeLayerVisibleRegions(Layer* layer, const Layer::VisibilityInputs& inputs,
+        const Region& aboveOpaqueLayers, const Region& aboveCoveredLayers,
+        Region& outDirtyRegion)
+{
+    /*
+     * visibleRegion: area of a surface that is visible on screen
+     * and not fully transparent. This is essentially the layer's
+     * footprint minus the opaque regions above it.
+     * Areas covered by a translucent surface are considered visible.
+     */
+    Region visibleRegion(inputs.bounds);
+
+    /*
+     * transparentRegion: area of a surface that is hinted to be completely
+     * transparent. This is only used to tell when the layer has no visible
+     * non-transparent regions and can be removed from the layer list. It
+     * does not affect the visibleRegion of this layer or any layers
+     * beneath it. The hint may not be correct if apps don't respect the
+     * SurfaceView restrictions (which, sadly, some don't).
+     */
+    Region transparentRegion;
+
+    // Remove the transparent area from the visible region
+    if (inputs.translucent && !visibleRegion.isEmpty() && inputs.transform.preserveRects()) {
+        // transform the transparent region, if the transformation is too
+        // complex we can't do the transparent region optimization.
+        transparentRegion = inputs.transform.transform(inputs.activeTransparentRegion);
+    }
+
+    /*
+     * coveredRegion: area of a surface that is covered by all
+     * visible regions above it (which includes the translucent areas).
+     */
+    const Region coveredRegion(aboveCoveredLayers.intersect(visibleRegion));
+
+    // subtract the opaque region covered by the layers above us
+    visibleRegion.subtractSelf(aboveOpaqueLayers);
+
+    // compute this layer's dirty region
+    Region dirty;
+    if (layer->contentDirty) {
+        // we need to invalidate the whole region
+        dirty = visibleRegion;
+        // as well, as the old visible region
+        dirty.orSelf(layer->visibleRegion);
+        layer->contentDirty = false;
+    } else {
+        /* compute the exposed region:
+         *   the exposed region consists of two components:
+         *   1) what's VISIBLE now and was COVERED before
+         *   2) what's EXPOSED now less what was EXPOSED before
+         *
+         * note that (1) is conservative, we start with the whole
+         * visible region but only keep what used to be covered by
+         * something -- which mean it may have been exposed.
+         *
+         * (2) handles areas that were not covered by anything but got
+         * exposed because of a resize.
+         */
+        const Region newExposed = visibleRegion - coveredRegion;
+        const Region oldVisibleRegion = layer->visibleRegion;
+        const Region oldCoveredRegion = layer->coveredRegion;
+        const Region oldExposed = oldVisibleRegion - oldCoveredRegion;
+        dirty = (visibleRegion&oldCoveredRegion) | (newExposed-oldExposed);
+    }
+    dirty.subtractSelf(aboveOpaqueLayers);
+
+    // accumulate to the screen dirty region
+    outDirtyRegion.orSelf(dirty);
+
+    // Store the visible region in screen space
+    layer->setVisibleRegion(visibleRegion);
+    layer->setCoveredRegion(coveredRegion);
+    layer->setVisibleNonTransparentRegion(
+            visibleRegion.subtract(transparentRegion));
+    layer->lastVisibilityInputs = inputs;
+}
+
 void SurfaceFlinger::computeVisibleRegions(uint32_t layerStack,
         Region& outDirtyRegion, Region& outOpaqueRegion)
 {
     ATRACE_CALL();
     ALOGV("computeVisibleRegions");
 
-    Region aboveOpaqueLayers;
-    Region aboveCoveredLayers;
-    Region dirty;
-
     outDirtyRegion.clear();
 
+    // the layers of the given layer stack, front to back
+    std::vector<Layer*> layers;
+    std::vector<Layer::VisibilityInputs> inputs;
     mDrawingState.traverseInReverseZOrder([&](Layer* layer) {
-        // start with the whole surface at its current location
-        const Layer::State& s(layer->getDrawingState());
-
-        // only consider the layers on the given layer stack
         if (layer->getLayerStack() != layerStack)
             return;
+        layers.push_back(layer);
+        inputs.push_back(layer->computeVisibilityInputs());
+    });
 
-        /*
-         * opaqueRegion: area of a surface that is fully opaque.
-         */
-        Region opaqueRegion;
-
-        /*
-         * visibleRegion: area of a surface that is visible on screen
-         * and not fully transparent. This is essentially the layer's
-         * footprint minus the opaque regions above it.
-         * Areas covered by a translucent surface are considered visible.
-         */
-        Region visibleRegion;
-
-        /*
-         * coveredRegion: area of a surface that is covered by all
-         * visible regions above it (which includes the translucent areas).
-         */
-        Region coveredRegion;
-
-        /*
-         * transparentRegion: area of a surface that is hinted to be completely
-         * transparent. This is only used to tell when the layer has no visible
-         * non-transparent regions and can be removed from the layer list. It
-         * does not affect the visibleRegion of this layer or any layers
-         * beneath it. The hint may not be correct if apps don't respect the
-         * SurfaceView restrictions (which, sadly, some don't).
-         */
-        Region transparentRegion;
-
-
-        // handle hidden surfaces by setting the visible region to empty
-        if (CC_LIKELY(layer->isVisible())) {
-            const bool translucent = !layer->isOpaque(s);
-            Rect bounds(layer->computeScreenBounds());
-            visibleRegion.set(bounds);
-            Transform tr = layer->getTransform();
-            if (!visibleRegion.isEmpty()) {
-                // Remove the transparent area from the visible region
-                if (translucent) {
-                    if (tr.preserveRects()) {
-                        // transform the transparent region
-                        transparentRegion = tr.transform(s.activeTransparentRegion);
-                    } else {
-                        // transformation too complex, can't do the
-                        // transparent region optimization.
-                        transparentRegion.clear();
-                    }
-                }
+    /*
+     * The regions of a layer only depend on its own inputs and on the layers
+     * above it overlapping it. As long as the z-order of the stack is the
+     * same as at the last computation, only the layers whose inputs changed
+     * and the layers overlapping the old or new bounds of those need to be
+     * re-evaluated, the others keep their regions.
+     */
+    LayerStackVisibility& cache(mLayerStackVisibility[layerStack]);
+    bool fullRebuild = cache.layerSequences.size() != layers.size();
+    for (size_t i = 0; !fullRebuild && i < layers.size(); i++) {
+        fullRebuild = cache.layerSequences[i] != layers[i]->sequence;
+    }
+
+    std::vector<bool> reevaluate(layers.size(), true);
+    if (!fullRebuild) {
+        std::vector<Rect> changedAreas;
+        for (size_t i = 0; i < layers.size(); i++) {
+            const Layer::VisibilityInputs& last(layers[i]->lastVisibilityInputs);
+            if (inputs[i] != last) {
+                if (!last.bounds.isEmpty()) changedAreas.push_back(last.bounds);
+                if (!inputs[i].bounds.isEmpty()) changedAreas.push_back(inputs[i].bounds);
+            } else {
+                // a layer whose content is dirty doesn't affect the others
+                reevaluate[i] = layers[i]->contentDirty;
+            }
+        }
 
-                // compute the opaque region
-                const int32_t layerOrientation = tr.getOrientation();
-                if (s.alpha == 1.0f && !translucent &&
-                        ((layerOrientation & Transform::ROT_INVALID) == false)) {
-                    // the opaque region is the layer's footprint
-                    opaqueRegion = visibleRegion;
-                }
+        size_t reevaluateCount = 0;
+        for (size_t i = 0; i < layers.size(); i++) {
+            Rect unused;
+            for (size_t j = 0; !reevaluate[i] && j < changedAreas.size(); j++) {
+                reevaluate[i] = inputs[i].bounds.intersect(changedAreas[j], &unused);
             }
+            reevaluateCount += reevaluate[i];
         }
 
-        // Clip the covered region to the visible region
-        coveredRegion = aboveCoveredLayers.intersect(visibleRegion);
+        if (reevaluateCount == 0) {
+            outOpaqueRegion = cache.opaqueRegion;
+            return;
+        }
 
-        // Update aboveCoveredLayers for next (lower) layer
-        aboveCoveredLayers.orSelf(visibleRegion);
+        // querying the layers above each re-evaluated layer costs more than
+        // accumulating over the whole stack once most of it is affected
+        fullRebuild = reevaluateCount * 2 > layers.size();
+    }
 
-        // subtract the opaque region covered by the layers above us
-        visibleRegion.subtractSelf(aboveOpaqueLayers);
+    if (fullRebuild) {
+        Region aboveOpaqueLayers;
+        Region aboveCoveredLayers;
+        for (size_t i = 0; i < layers.size(); i++) {
+            computeLayerVisibleRegions(layers[i], inputs[i],
+                    aboveOpaqueLayers, aboveCoveredLayers, outDirtyRegion);
 
-        // compute this layer's dirty region
-        if (layer->contentDirty) {
-            // we need to invalidate the whole region
-            dirty = visibleRegion;
-            // as well, as the old visible region
-            dirty.orSelf(layer->visibleRegion);
-            layer->contentDirty = false;
-        } else {
-            /* compute the exposed region:
-             *   the exposed region consists of two components:
-             *   1) what's VISIBLE now and was COVERED before
-             *   2) what's EXPOSED now less what was EXPOSED before
-             *
-             * note that (1) is conservative, we start with the whole
-             * visible region but only keep what used to be covered by
-             * something -- which mean it may have been exposed.
-             *
-             * (2) handles areas that were not covered by anything but got
-             * exposed because of a resize.
-             */
-            const Region newExposed = visibleRegion - coveredRegion;
-            const Region oldVisibleRegion = layer->visibleRegion;
-            const Region oldCoveredRegion = layer->coveredRegion;
-            const Region oldExposed = oldVisibleRegion - oldCoveredRegion;
-            dirty = (visibleRegion&oldCoveredRegion) | (newExposed-oldExposed);
-        }
-        dirty.subtractSelf(aboveOpaqueLayers);
-
-        // accumulate to the screen dirty region
-        outDirtyRegion.orSelf(dirty);
-
-        // Update aboveOpaqueLayers for next (lower) layer
-        aboveOpaqueLayers.orSelf(opaqueRegion);
-
-        // Store the visible region in screen space
-        layer->setVisibleRegion(visibleRegion);
-        layer->setCoveredRegion(coveredRegion);
-        layer->setVisibleNonTransparentRegion(
-                visibleRegion.subtract(transparentRegion));
-    });
+            // Update aboveCoveredLayers and aboveOpaqueLayers for next (lower) layer
+            aboveCoveredLayers.orSelf(inputs[i].bounds);
+            if (inputs[i].opaque) {
+                aboveOpaqueLayers.orSelf(inputs[i].bounds);
+            }
+        }
+        outOpaqueRegion = aboveOpaqueLayers;
+
+        cache.layerSequences.resize(layers.size());
+        for (size_t i = 0; i < layers.size(); i++) {
+            cache.layerSequences[i] = layers[i]->sequence;
+        }
+    } else {
+        for (size_t i = 0; i < layers.size(); i++) {
+            if (!reevaluate[i]) continue;
+
+            // the dirty region also covers the old footprint of the layer, so
+            // gather the layers above overlapping either footprint
+            const Rect& oldBounds(layers[i]->lastVisibilityInputs.bounds);
+            const Rect& newBounds(inputs[i].bounds);
+            Region aboveOpaqueLayers;
+            Region aboveCoveredLayers;
+            for (size_t j = 0; j < i; j++) {
+                Rect unused;
+                const Rect& bounds(inputs[j].bounds);
+                if (bounds.intersect(newBounds, &unused) || bounds.intersect(oldBounds, &unused)) {
+                    aboveCoveredLayers.orSelf(bounds);
+                    if (inputs[j].opaque) {
+                        aboveOpaqueLayers.orSelf(bounds);
+                    }
+                }
+            }
+            computeLayerVisibleRegions(layers[i], inputs[i],
+                    aboveOpaqueLayers, aboveCoveredLayers, outDirtyRegion);
+        }
 
-    outOpaqueRegion = aboveOpaqueLayers;
+        outOpaqueRegion.clear();
+        for (size_t i = 0; i < layers.size(); i++) {
+            if (inputs[i].opaque) {
+                outOpaqueRegion.orSelf(inputs[i].bounds);
+            }
+        }
+    }
+    cache.opaqueRegion = outOpaqueRegion;
 }
 
 void SurfaceFlinger::invalidateLayerStack(uint32_t layerStack,
@@ -2514,14 +2638,20 @@ bool SurfaceFlinger::handlePageFlip()
         }
     });
 
+    size_t layersLatched = 0;
     for (auto& layer : mLayersWithQueuedFrames) {
         const Region dirty(layer->latchBuffer(visibleRegions, latchTime));
         layer->useSurfaceDamage();
         invalidateLayerStack(layer->getLayerStack(), dirty);
         if (layer->isBufferLatched()) {
             newDataLatched = true;
+            layersLatched++;
         }
     }
+    // Buffers due this vsync that weren't latched were mostly still being
+    // rendered
+    mPhaseOffsetTuner->onAppFrames(layersLatched,
+            mLayersWithQueuedFrames.size() - layersLatched);
 
     mVisibleRegionsDirty |= visibleRegions;
 
@@ -2558,6 +2688,18 @@ void SurfaceFlinger::doDisplayComposition(
 
     ALOGV("doDisplayComposition");
 
+    DisplayDevice::ClientTargetState clientTargetState;
+    const bool cacheClientTarget = isClientTargetCacheable(displayDevice);
+    if (cacheClientTarget) {
+        getClientTargetState(displayDevice, &clientTargetState);
+        if (canReuseClientTarget(displayDevice, inDirtyRegion, clientTargetState)) {
+            ATRACE_NAME("reuseClientTarget");
+            displayDevice->reuseClientTarget();
+            return;
+        }
+    }
+    displayDevice->clientTargetState.layers.clear();
+
     Region dirtyRegion(inDirtyRegion);
 
     // compute the invalid region
@@ -2585,6 +2727,10 @@ void SurfaceFlinger::doDisplayComposition(
 
     if (!doComposeSurfaces(displayDevice, dirtyRegion)) return;
 
+    if (cacheClientTarget) {
+        displayDevice->clientTargetState = std::move(clientTargetState);
+    }
+
     // update the swap region and clear the dirty region
     displayDevice->swapRegion.orSelf(dirtyRegion);
 
@@ -2592,6 +2738,66 @@ void SurfaceFlinger::doDisplayComposition(
     displayDevice->swapBuffers(getHwComposer());
 }
 
+bool SurfaceFlinger::isClientTargetCacheable(
+        const sp<const DisplayDevice>& displayDevice) const
+{
+    // Virtual displays consume every client target buffer, and the debug
+    // flashes draw over the client target directly
+    const auto hwcId = displayDevice->getHwcDisplayId();
+    return hwcId >= 0 &&
+            displayDevice->getDisplayType() < DisplayDevice::DISPLAY_VIRTUAL &&
+            !mDebugRegion &&
+            mHwc->hasClientComposition(hwcId);
+}
+
+void SurfaceFlinger::getClientTargetState(const sp<const DisplayDevice>& displayDevice,
+        DisplayDevice::ClientTargetState* outState) const
+{
+    const auto hwcId = displayDevice->getHwcDisplayId();
+    const Transform& tr(displayDevice->getTransform());
+    outState->layers.clear();
+    bool firstLayer = true;
+    for (auto& layer : displayDevice->getVisibleLayersSortedByZ()) {
+        const Layer::State& state(layer->getDrawingState());
+        const auto compositionType = layer->getCompositionType(hwcId);
+        DisplayDevice::ClientTargetLayer entry;
+        entry.sequence = layer->sequence;
+        entry.compositionType = static_cast<int32_t>(compositionType);
+        // matches the clearing done by doComposeSurfaces()
+        entry.cleared = compositionType != HWC2::Composition::Client &&
+                layer->getClearClientTarget(hwcId) && !firstLayer &&
+                layer->isOpaque(state) && (state.alpha == 1.0f);
+        entry.visibleRegion = tr.transform(layer->visibleRegion);
+        outState->layers.push_back(entry);
+        firstLayer = false;
+    }
+    outState->undefinedRegion = displayDevice->undefinedRegion;
+    outState->hasDeviceComposition = mHwc->hasDeviceComposition(hwcId);
+    outState->colorMode = displayDevice->getActiveColorMode();
+}
+
+bool SurfaceFlinger::canReuseClientTarget(const sp<const DisplayDevice>& displayDevice,
+        const Region& dirty, const DisplayDevice::ClientTargetState& state) const
+{
+    const DisplayDevice::ClientTargetState& last(displayDevice->clientTargetState);
+    if (last.layers.empty() || last.layers != state.layers ||
+            !last.undefinedRegion.hasSameRects(state.undefinedRegion) ||
+            last.hasDeviceComposition != state.hasDeviceComposition ||
+            last.colorMode != state.colorMode) {
+        return false;
+    }
+
+    // With the same layers, composition and geometry, the client composited
+    // layers can only have changed where they are dirty
+    for (const auto& entry : state.layers) {
+        if (entry.compositionType == static_cast<int32_t>(HWC2::Composition::Client) &&
+                !dirty.intersect(entry.visibleRegion).isEmpty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool SurfaceFlinger::doComposeSurfaces(
         const sp<const DisplayDevice>& displayDevice, const Region& dirty)
 {
@@ -2848,6 +3054,20 @@ void SurfaceFlinger::setTransactionState(
         uint32_t flags)
 {
     ATRACE_CALL();
+
+    // Layer-only transactions that nobody waits for are queued without
+    // taking mStateLock, so that clients updating many layers don't contend
+    // with the main thread. They all take effect in the next
+    // handleMessageTransaction().
+    if (displays.isEmpty() && !(flags & (eSynchronous | eAnimation)) &&
+            !mInterceptor.isEnabled()) {
+        if (!state.isEmpty()) {
+            mTransactionQueue.push(state);
+            signalTransaction();
+        }
+        return;
+    }
+
     Mutex::Autolock _l(mStateLock);
     uint32_t transactionFlags = 0;
 
@@ -2867,32 +3087,16 @@ void SurfaceFlinger::setTransactionState(
         }
     }
 
+    // Earlier transactions that are still queued go first
+    transactionFlags |= applyQueuedTransactionsLocked();
+
     size_t count = displays.size();
     for (size_t i=0 ; i<count ; i++) {
         const DisplayState& s(displays[i]);
         transactionFlags |= setDisplayStateLocked(s);
     }
 
-    count = state.size();
-    for (size_t i=0 ; i<count ; i++) {
-        const ComposerState& s(state[i]);
-        // Here we need to check that the interface we're given is indeed
-        // one of our own. A malicious client could give us a NULL
-        // IInterface, or one of its own or even one of our own but a
-        // different type. All these situations would cause us to crash.
-        //
-        // NOTE: it would be better to use RTTI as we could directly check
-        // that we have a Client*. however, RTTI is disabled in Android.
-        if (s.client != NULL) {
-            sp<IBinder> binder = IInterface::asBinder(s.client);
-            if (binder != NULL) {
-                if (binder->queryLocalInterface(ISurfaceComposerClient::descriptor) != NULL) {
-                    sp<Client> client( static_cast<Client *>(s.client.get()) );
-                    transactionFlags |= setClientStateLocked(client, s.state);
-                }
-            }
-        }
-    }
+    transactionFlags |= setClientStatesLocked(state);
 
     // If a synchronous transaction is explicitly requested without any changes,
     // force a transaction anyway. This can be used as a flush mechanism for
@@ -2930,6 +3134,58 @@ void SurfaceFlinger::setTransactionState(
     }
 }
 
+uint32_t SurfaceFlinger::setClientStatesLocked(const Vector<ComposerState>& state)
+{
+    uint32_t transactionFlags = 0;
+    size_t count = state.size();
+    for (size_t i=0 ; i<count ; i++) {
+        const ComposerState& s(state[i]);
+        // Here we need to check that the interface we're given is indeed
+        // one of our own. A malicious client could give us a NULL
+        // IInterface, or one of its own or even one of our own but a
+        // different type. All these situations would cause us to crash.
+        //
+        // NOTE: it would be better to use RTTI as we could directly check
+        // that we have a Client*. however, RTTI is disabled in Android.
+        if (s.client != NULL) {
+            sp<IBinder> binder = IInterface::asBinder(s.client);
+            if (binder != NULL) {
+                if (binder->queryLocalInterface(ISurfaceComposerClient::descriptor) != NULL) {
+                    sp<Client> client( static_cast<Client *>(s.client.get()) );
+                    transactionFlags |= setClientStateLocked(client, s.state);
+                }
+            }
+        }
+    }
+    return transactionFlags;
+}
+
+void SurfaceFlinger::applyQueuedTransactions()
+{
+    if (mTransactionQueue.isEmpty()) {
+        return;
+    }
+
+    ATRACE_CALL();
+    Mutex::Autolock _l(mStateLock);
+    // The transaction is handled right after this, so there is no need to
+    // signal it
+    android_atomic_or(applyQueuedTransactionsLocked(), &mTransactionFlags);
+}
+
+uint32_t SurfaceFlinger::applyQueuedTransactionsLocked()
+{
+    if (mTransactionQueue.isEmpty()) {
+        return 0;
+    }
+
+    uint32_t transactionFlags = 0;
+    for (const auto& state : mTransactionQueue.take()) {
+        transactionFlags |= setClientStatesLocked(state);
+    }
+    return transactionFlags;
+}
+
 uint32_t SurfaceFlinger::setDisplayStateLocked(const DisplayState& s)
 {
     ssize_t dpyIdx = mCurrentState.displays.indexOfKey(s.token);
@@ -3261,6 +3517,7 @@ void SurfaceFlinger::onInitializeDisplays() {
     const auto& activeConfig = mHwc->getActiveConfig(HWC_DISPLAY_PRIMARY);
     const nsecs_t period = activeConfig->getVsyncPeriod();
     mAnimFrameTracker.setDisplayRefreshPeriod(period);
+    mPhaseOffsetTuner->setRefreshPeriod(period);
 
     // Use phase of 0 since phase is not known.
     // Use latency of 0, which will snap to the ideal latency.
@@ -3470,6 +3727,24 @@ status_t SurfaceFlinger::dump(int fd, const Vector<String16>& args)
                 dumpWideColorInfo(result);
                 dumpAll = false;
             }
+
+            if ((index < numArgs) && (args[index] == String16("--stage-timing"))) {
+                index++;
+                mStageTiming.dump(result);
+                dumpAll = false;
+            }
+
+            if ((index < numArgs) && (args[index] == String16("--binder-stats"))) {
+                index++;
+                if ((index < numArgs) && (args[index] == String16("enable") ||
+                        args[index] == String16("disable"))) {
+                    ProcessState::self()->setTransactionStatsEnabled(
+                            args[index] == String16("enable"));
+                    index++;
+                }
+                ProcessState::self()->dumpTransactionStats(result);
+                dumpAll = false;
+            }
         }
 
         if (dumpAll) {
@@ -3715,6 +3990,7 @@ void SurfaceFlinger::dumpAllLocked(const Vector<String16>& args, size_t& index,
         vsyncPhaseOffsetNs, sfVsyncPhaseOffsetNs,
         dispSyncPresentTimeOffset, activeConfig->getVsyncPeriod());
     result.append("\n");
+    mPhaseOffsetTuner->dump(result);
 
     // Dump static screen stats
     result.append("\n");
@@ -3723,6 +3999,9 @@ void SurfaceFlinger::dumpAllLocked(const Vector<String16>& args, size_t& index,
 
     dumpBufferingStats(result);
 
+    ProcessState::self()->dumpThreadPoolStats(result);
+    result.append("\n");
+
     /*
      * Dump the visible layer list
      */
@@ -4062,11 +4341,13 @@ status_t SurfaceFlinger::onTransact(
             }
             case 1018: { // Modify Choreographer's phase offset
                 n = data.readInt32();
+                mPhaseOffsetTuner->setEnabled(false);
                 mEventThread->setPhaseOffset(static_cast<nsecs_t>(n));
                 return NO_ERROR;
             }
             case 1019: { // Modify SurfaceFlinger's phase offset
                 n = data.readInt32();
+                mPhaseOffsetTuner->setEnabled(false);
                 mSFEventThread->setPhaseOffset(static_cast<nsecs_t>(n));
                 return NO_ERROR;
             }
@@ -4094,6 +4375,15 @@ status_t SurfaceFlinger::onTransact(
                 repaintEverything();
                 return NO_ERROR;
             }
+            case 1023: { // Per-stage composition timing
+                // 1 enables and resets, 0 disables, anything else only reads the stats
+                n = data.readInt32();
+                if (n == 0 || n == 1) {
+                    mStageTiming.setEnabled(n == 1);
+                }
+                mStageTiming.writeToParcel(reply);
+                return NO_ERROR;
+            }
         }
     }
     return err;
@@ -4272,9 +4562,17 @@ status_t SurfaceFlinger::captureScreen(const sp<IBinder>& display,
 
         status_t result = NO_ERROR;
         int fd = -1;
+        sp<const DisplayDevice> device;
         {
             Mutex::Autolock _l(mStateLock);
-            sp<const DisplayDevice> device(getDisplayDeviceLocked(display));
+            device = getDisplayDeviceLocked(display);
+        }
+        // Rendering only reads the drawing state, which belongs to this thread, so mStateLock
+        // isn't held meanwhile: transactions from binder threads (e.g. the window animations
+        // running while recents thumbnails are taken) don't have to wait for the capture.
+        if (device == nullptr) {
+            result = NAME_NOT_FOUND;
+        } else {
             result = captureScreenImplLocked(device, buffer, sourceCrop, reqWidth, reqHeight,
                                              minLayerZ, maxLayerZ, useIdentityTransform,
                                              rotationFlags, isLocalScreenshot, &fd);
@@ -55,9 +55,12 @@
 #include "DisplayDevice.h"
 #include "DispSync.h"
 #include "FrameTracker.h"
+#include "PhaseOffsetTuner.h"
+#include "StageTimingTracker.h"
 #include "LayerVector.h"
 #include "MessageQueue.h"
 #include "SurfaceInterceptor.h"
+#include "TransactionQueue.h"
 #include "StartPropertySetThread.h"
 
 #include "DisplayHardware/HWComposer.h"
@@ -368,6 +371,10 @@ private:
     uint32_t setTransactionFlags(uint32_t flags);
     void commitTransaction();
     uint32_t setClientStateLocked(const sp<Client>& client, const layer_state_t& s);
+    uint32_t setClientStatesLocked(const Vector<ComposerState>& state);
+    // Applies the transactions queued by setTransactionState()
+    void applyQueuedTransactions();
+    uint32_t applyQueuedTransactionsLocked();
     uint32_t setDisplayStateLocked(const DisplayState& s);
 
     /* ------------------------------------------------------------------------
@@ -414,6 +421,8 @@ private:
 
     void startBootAnim();
 
+    // These run on the main thread. With HWC2 they are called without mStateLock, as they only
+    // read the drawing state.
     void renderScreenImplLocked(
             const sp<const DisplayDevice>& hw,
             Rect sourceCrop, uint32_t reqWidth, uint32_t reqHeight,
@@ -543,6 +552,16 @@ private:
     // has been destroyed and is no longer valid.
     bool doComposeSurfaces(const sp<const DisplayDevice>& displayDevice, const Region& dirty);
 
+#ifdef USE_HWC2
+    // Client target caching: when nothing drawn into a display's client
+    // target changed, the previous one is presented again
+    bool isClientTargetCacheable(const sp<const DisplayDevice>& displayDevice) const;
+    void getClientTargetState(const sp<const DisplayDevice>& displayDevice,
+            DisplayDevice::ClientTargetState* outState) const;
+    bool canReuseClientTarget(const sp<const DisplayDevice>& displayDevice, const Region& dirty,
+            const DisplayDevice::ClientTargetState& state) const;
+#endif
+
     void postFramebuffer();
     void drawWormhole(const sp<const DisplayDevice>& displayDevice, const Region& region) const;
 
@@ -614,6 +633,8 @@ private:
     mutable Mutex mStateLock;
     State mCurrentState{LayerVector::StateSet::Current};
     volatile int32_t mTransactionFlags;
+    // asynchronous layer-only transactions, applied at the next vsync
+    TransactionQueue mTransactionQueue;
     Condition mTransactionCV;
     bool mTransactionPending;
     bool mAnimTransactionPending;
@@ -654,6 +675,14 @@ private:
     // don't need synchronization
     State mDrawingState{LayerVector::StateSet::Drawing};
     bool mVisibleRegionsDirty;
+
+    // Result of the last visible region computation of a layer stack
+    struct LayerStackVisibility {
+        // sequence numbers of the layers of the stack, front to back
+        std::vector<int32_t> layerSequences;
+        Region opaqueRegion;
+    };
+    std::map<uint32_t, LayerStackVisibility> mLayerStackVisibility;
 #ifndef USE_HWC2
     bool mHwWorkListDirty;
 #else
@@ -685,6 +714,10 @@ private:
     bool mForceFullDamage;
 #ifdef USE_HWC2
     bool mPropagateBackpressure = true;
+    std::unique_ptr<PhaseOffsetTuner> mPhaseOffsetTuner;
+    // when SurfaceFlinger woke up for the current frame
+    nsecs_t mFrameStartTime = 0;
+    StageTimingTracker mStageTiming;
 #endif
     SurfaceInterceptor mInterceptor;
     bool mUseHwcVirtualDisplays = false;
@@ -692,6 +725,9 @@ private:
     // Restrict layers to use two buffers in their bufferqueues.
     bool mLayerTripleBufferingDisabled = false;
 
+    // Whether the FenceMonitor waits for the fences of the FenceTimelines
+    bool mUseFenceMonitor = false;
+
     // these are thread safe
     mutable MessageQueue mEventQueue;
     FrameTracker mAnimFrameTracker;
@@ -21,6 +21,7 @@
 #include "SurfaceFlinger.h"
 #include "SurfaceInterceptor.h"
 
+#include <chrono>
 #include <fstream>
 
 #include <android-base/file.h>
@@ -29,6 +30,11 @@
 
 namespace android {
 
+// How often the drain thread moves records from the ring into the trace
+constexpr auto RECORD_DRAIN_INTERVAL = std::chrono::milliseconds(100);
+
+constexpr size_t SurfaceInterceptor::RECORD_RING_SIZE;
+
 // ----------------------------------------------------------------------------
 
 SurfaceInterceptor::SurfaceInterceptor(SurfaceFlinger* flinger)
@@ -36,6 +42,18 @@ SurfaceInterceptor::SurfaceInterceptor(SurfaceFlinger* flinger)
 {
 }
 
+SurfaceInterceptor::~SurfaceInterceptor()
+{
+    {
+        std::lock_guard<std::mutex> protoGuard(mTraceMutex);
+        mStopDrainThread = true;
+    }
+    mDrainCondition.notify_one();
+    if (mDrainThread.joinable()) {
+        mDrainThread.join();
+    }
+}
+
 void SurfaceInterceptor::enable(const SortedVector<sp<Layer>>& layers,
         const DefaultKeyedVector< wp<IBinder>, DisplayDeviceState>& displays)
 {
@@ -43,10 +61,23 @@ void SurfaceInterceptor::enable(const SortedVector<sp<Layer>>& layers,
         return;
     }
     ATRACE_CALL();
-    mEnabled = true;
-    std::lock_guard<std::mutex> protoGuard(mTraceMutex);
-    saveExistingDisplaysLocked(displays);
-    saveExistingSurfacesLocked(layers);
+    {
+        std::lock_guard<std::mutex> protoGuard(mTraceMutex);
+        if (mRecords == nullptr) {
+            mRecords.reset(new RecordSlot[RECORD_RING_SIZE]);
+            for (size_t i = 0; i < RECORD_RING_SIZE; i++) {
+                mRecords[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        } else {
+            // Drop anything recorded while the previous trace was stopping
+            drainRecordsLocked(false);
+        }
+        mEnabled = true;
+        mStopDrainThread = false;
+        saveExistingDisplaysLocked(displays);
+        saveExistingSurfacesLocked(layers);
+    }
+    mDrainThread = std::thread(&SurfaceInterceptor::drainThreadMain, this);
 }
 
 void SurfaceInterceptor::disable() {
@@ -54,8 +85,20 @@ void SurfaceInterceptor::disable() {
         return;
     }
     ATRACE_CALL();
+    {
+        std::lock_guard<std::mutex> protoGuard(mTraceMutex);
+        mStopDrainThread = true;
+    }
+    mDrainCondition.notify_one();
+    if (mDrainThread.joinable()) {
+        mDrainThread.join();
+    }
+
     std::lock_guard<std::mutex> protoGuard(mTraceMutex);
+    drainRecordsLocked(true);
     mEnabled = false;
+    uint32_t dropped = mRecordsDropped.exchange(0);
+    ALOGW_IF(dropped > 0, "Dropped %u buffer update and vsync records", dropped);
     status_t err(writeProtoFileLocked());
     ALOGE_IF(err == PERMISSION_DENIED, "Could not save the proto file! Permission denied");
     ALOGE_IF(err == NOT_ENOUGH_DATA, "Could not save the proto file! There are missing fields");
@@ -158,7 +201,67 @@ int32_t SurfaceInterceptor::getLayerId(const sp<const Layer>& layer) {
     return layer->sequence;
 }
 
+void SurfaceInterceptor::pushRecord(const Record& record) {
+    size_t position = mRecordWritePosition.load(std::memory_order_relaxed);
+    for (;;) {
+        RecordSlot& slot(mRecords[position & (RECORD_RING_SIZE - 1)]);
+        const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (diff == 0) {
+            if (mRecordWritePosition.compare_exchange_weak(position, position + 1,
+                    std::memory_order_relaxed)) {
+                slot.record = record;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return;
+            }
+        } else if (diff < 0) {
+            // The drain thread is behind, the ring is full
+            mRecordsDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            position = mRecordWritePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void SurfaceInterceptor::drainRecordsLocked(bool addToTrace) {
+    for (;;) {
+        RecordSlot& slot(mRecords[mRecordReadPosition & (RECORD_RING_SIZE - 1)]);
+        if (slot.sequence.load(std::memory_order_acquire) != mRecordReadPosition + 1) {
+            break;
+        }
+        const Record record(slot.record);
+        slot.sequence.store(mRecordReadPosition + RECORD_RING_SIZE, std::memory_order_release);
+        mRecordReadPosition++;
+
+        if (!addToTrace) {
+            continue;
+        }
+        Increment* increment(mTrace.add_increment());
+        increment->set_time_stamp(record.timeStamp);
+        switch (record.type) {
+            case Record::Type::BufferUpdate:
+                addBufferUpdateLocked(increment, record.layerId, record.width, record.height,
+                        record.frameNumber);
+                break;
+            case Record::Type::VSync:
+                addVSyncUpdateLocked(increment, record.vsyncTime);
+                break;
+        }
+    }
+}
+
+void SurfaceInterceptor::drainThreadMain() {
+    std::unique_lock<std::mutex> lock(mTraceMutex);
+    while (!mStopDrainThread) {
+        mDrainCondition.wait_for(lock, RECORD_DRAIN_INTERVAL);
+        drainRecordsLocked(true);
+    }
+}
+
 Increment* SurfaceInterceptor::createTraceIncrementLocked() {
+    // Records from before this increment go first
+    drainRecordsLocked(true);
     Increment* increment(mTrace.add_increment());
     increment->set_time_stamp(systemTime());
     return increment;
@@ -429,11 +532,11 @@ void SurfaceInterceptor::addSurfaceDeletionLocked(Increment* increment,
     deletion->set_id(getLayerId(layer));
 }
 
-void SurfaceInterceptor::addBufferUpdateLocked(Increment* increment, const sp<const Layer>& layer,
+void SurfaceInterceptor::addBufferUpdateLocked(Increment* increment, int32_t layerId,
         uint32_t width, uint32_t height, uint64_t frameNumber)
 {
     BufferUpdate* update(increment->mutable_buffer_update());
-    update->set_id(getLayerId(layer));
+    update->set_id(layerId);
     update->set_w(width);
     update->set_h(height);
     update->set_frame_number(frameNumber);
@@ -554,16 +657,25 @@ void SurfaceInterceptor::saveBufferUpdate(const sp<const Layer>& layer, uint32_t
         return;
     }
     ATRACE_CALL();
-    std::lock_guard<std::mutex> protoGuard(mTraceMutex);
-    addBufferUpdateLocked(createTraceIncrementLocked(), layer, width, height, frameNumber);
+    Record record {};
+    record.type = Record::Type::BufferUpdate;
+    record.layerId = getLayerId(layer);
+    record.width = width;
+    record.height = height;
+    record.frameNumber = frameNumber;
+    record.timeStamp = systemTime();
+    pushRecord(record);
 }
 
 void SurfaceInterceptor::saveVSyncEvent(nsecs_t timestamp) {
     if (!mEnabled) {
         return;
     }
-    std::lock_guard<std::mutex> protoGuard(mTraceMutex);
-    addVSyncUpdateLocked(createTraceIncrementLocked(), timestamp);
+    Record record {};
+    record.type = Record::Type::VSync;
+    record.vsyncTime = timestamp;
+    record.timeStamp = systemTime();
+    pushRecord(record);
 }
 
 void SurfaceInterceptor::saveDisplayCreation(const DisplayDeviceState& info) {
@@ -19,7 +19,11 @@
 
 #include <frameworks/native/cmds/surfacereplayer/proto/src/trace.pb.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <thread>
 
 #include <utils/SortedVector.h>
 #include <utils/Vector.h>
@@ -41,6 +45,7 @@ constexpr auto DEFAULT_FILENAME = "/data/SurfaceTrace.dat";
 class SurfaceInterceptor {
 public:
     SurfaceInterceptor(SurfaceFlinger* const flinger);
+    ~SurfaceInterceptor();
     // Both vectors are used to capture the current state of SF as the initial snapshot in the trace
     void enable(const SortedVector<sp<Layer>>& layers,
             const DefaultKeyedVector< wp<IBinder>, DisplayDeviceState>& displays);
@@ -65,6 +70,39 @@ public:
     void saveVSyncEvent(nsecs_t timestamp);
 
 private:
+    // Buffer updates and vsync events come in on every frame, so they are
+    // stored as compact records in a lock-free ring instead of being added to
+    // the trace by the caller. The records are turned into increments by the
+    // drain thread, and before any other increment is added so that the trace
+    // stays in order.
+    struct Record {
+        enum class Type : uint32_t {
+            BufferUpdate,
+            VSync,
+        };
+        Type type;
+        int32_t layerId;
+        uint32_t width;
+        uint32_t height;
+        uint64_t frameNumber;
+        nsecs_t vsyncTime;
+        nsecs_t timeStamp;
+    };
+    struct RecordSlot {
+        // Equals the write position the slot is free for, or that position
+        // plus one once the record is written
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+    // Must be a power of two
+    static constexpr size_t RECORD_RING_SIZE = 4096;
+
+    void pushRecord(const Record& record);
+    // Records are only added to the trace when addToTrace is set, otherwise
+    // they are discarded
+    void drainRecordsLocked(bool addToTrace);
+    void drainThreadMain();
+
     // The creation increments of Surfaces and Displays do not contain enough information to capture
     // the initial state of each object, so a transaction with all of the missing properties is
     // performed at the initial snapshot for each display and surface.
@@ -82,7 +120,7 @@ private:
     Increment* createTraceIncrementLocked();
     void addSurfaceCreationLocked(Increment* increment, const sp<const Layer>& layer);
     void addSurfaceDeletionLocked(Increment* increment, const sp<const Layer>& layer);
-    void addBufferUpdateLocked(Increment* increment, const sp<const Layer>& layer, uint32_t width,
+    void addBufferUpdateLocked(Increment* increment, int32_t layerId, uint32_t width,
             uint32_t height, uint64_t frameNumber);
     void addVSyncUpdateLocked(Increment* increment, nsecs_t timestamp);
     void addDisplayCreationLocked(Increment* increment, const DisplayDeviceState& info);
@@ -132,6 +170,15 @@ private:
     std::mutex mTraceMutex {};
     Trace mTrace {};
     SurfaceFlinger* const mFlinger;
+
+    std::unique_ptr<RecordSlot[]> mRecords;
+    std::atomic<size_t> mRecordWritePosition {0};
+    std::atomic<uint32_t> mRecordsDropped {0};
+    // protected by mTraceMutex
+    size_t mRecordReadPosition {0};
+    bool mStopDrainThread {false};
+    std::condition_variable mDrainCondition {};
+    std::thread mDrainThread {};
 };
 
 }
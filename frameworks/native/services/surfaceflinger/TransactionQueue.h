@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANDROID_TRANSACTION_QUEUE_H
+#define ANDROID_TRANSACTION_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include <private/gui/LayerState.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+// TransactionQueue holds layer state updates until the main thread applies
+// them. Any number of binder threads can push without taking a lock; the
+// main thread takes everything queued so far with a single exchange.
+class TransactionQueue
+{
+public:
+    TransactionQueue() : mHead(nullptr) { }
+    ~TransactionQueue() {
+        take();
+    }
+
+    TransactionQueue(const TransactionQueue&) = delete;
+    TransactionQueue& operator=(const TransactionQueue&) = delete;
+
+    void push(const Vector<ComposerState>& states) {
+        Node* node = new Node{states, mHead.load(std::memory_order_relaxed)};
+        while (!mHead.compare_exchange_weak(node->next, node,
+                std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    bool isEmpty() const {
+        return mHead.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // Removes and returns all queued transactions, oldest first.
+    std::vector<Vector<ComposerState>> take() {
+        Node* node = mHead.exchange(nullptr, std::memory_order_acquire);
+        std::vector<Vector<ComposerState>> transactions;
+        while (node != nullptr) {
+            transactions.push_back(node->states);
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+        // The list is newest first
+        std::reverse(transactions.begin(), transactions.end());
+        return transactions;
+    }
+
+private:
+    struct Node {
+        Vector<ComposerState> states;
+        Node* next;
+    };
+
+    std::atomic<Node*> mHead;
+};
+
+}; // namespace android
+
+#endif // ANDROID_TRANSACTION_QUEUE_H
@@ -20,8 +20,10 @@ namespace dvr {
 
 ConsumerChannel::ConsumerChannel(BufferHubService* service, int buffer_id,
                                  int channel_id,
-                                 const std::shared_ptr<Channel> producer)
+                                 const std::shared_ptr<Channel> producer,
+                                 bool ignored)
     : BufferHubChannel(service, buffer_id, channel_id, kConsumerType),
+      ignored_(ignored),
       producer_(producer) {
   GetProducer()->AddConsumer(this);
 }
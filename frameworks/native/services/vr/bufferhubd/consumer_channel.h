@@ -15,8 +15,11 @@ class ConsumerChannel : public BufferHubChannel {
   using Channel = pdx::Channel;
   using Message = pdx::Message;
 
+  // A consumer created with |ignored| set starts out ignoring events, as if
+  // ConsumerSetIgnore(true) had been called before anything was posted.
   ConsumerChannel(BufferHubService* service, int buffer_id, int channel_id,
-                  const std::shared_ptr<Channel> producer);
+                  const std::shared_ptr<Channel> producer,
+                  bool ignored = false);
   ~ConsumerChannel() override;
 
   bool HandleMessage(Message& message) override;
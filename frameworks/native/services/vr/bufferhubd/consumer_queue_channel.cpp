@@ -15,10 +15,11 @@ namespace dvr {
 
 ConsumerQueueChannel::ConsumerQueueChannel(
     BufferHubService* service, int buffer_id, int channel_id,
-    const std::shared_ptr<Channel>& producer)
+    const std::shared_ptr<Channel>& producer, bool silent)
     : BufferHubChannel(service, buffer_id, channel_id, kConsumerQueueType),
       producer_(producer),
-      capacity_(0) {
+      capacity_(0),
+      silent_(silent) {
   GetProducer()->AddConsumer(this);
 }
 
@@ -115,7 +116,7 @@ ConsumerQueueChannel::OnConsumerQueueImportBuffers(Message& message) {
       continue;
     }
 
-    auto status = producer_channel->CreateConsumer(message);
+    auto status = producer_channel->CreateConsumer(message, silent_);
 
     // If no buffers are imported successfully, clear available and return an
     // error. Otherwise, return all consumer handles already imported
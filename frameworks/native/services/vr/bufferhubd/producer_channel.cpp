@@ -128,7 +128,8 @@ Status<NativeBufferHandle<BorrowedHandle>> ProducerChannel::OnGetBuffer(
   return {NativeBufferHandle<BorrowedHandle>(buffer_, buffer_id())};
 }
 
-Status<RemoteChannelHandle> ProducerChannel::CreateConsumer(Message& message) {
+Status<RemoteChannelHandle> ProducerChannel::CreateConsumer(Message& message,
+                                                            bool ignored) {
   ATRACE_NAME("ProducerChannel::CreateConsumer");
   ALOGD_IF(TRACE, "ProducerChannel::CreateConsumer: buffer_id=%d", buffer_id());
 
@@ -142,7 +143,7 @@ Status<RemoteChannelHandle> ProducerChannel::CreateConsumer(Message& message) {
   }
 
   auto consumer = std::make_shared<ConsumerChannel>(
-      service(), buffer_id(), channel_id, shared_from_this());
+      service(), buffer_id(), channel_id, shared_from_this(), ignored);
   const auto channel_status = service()->SetChannel(channel_id, consumer);
   if (!channel_status) {
     ALOGE(
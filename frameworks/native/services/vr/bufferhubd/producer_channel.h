@@ -44,7 +44,8 @@ class ProducerChannel : public BufferHubChannel {
 
   pdx::Status<NativeBufferHandle<BorrowedHandle>> OnGetBuffer(Message& message);
 
-  pdx::Status<RemoteChannelHandle> CreateConsumer(Message& message);
+  pdx::Status<RemoteChannelHandle> CreateConsumer(Message& message,
+                                                  bool ignored = false);
   pdx::Status<RemoteChannelHandle> OnNewConsumer(Message& message);
 
   pdx::Status<std::pair<BorrowedFence, BufferWrapper<std::uint8_t*>>>
@@ -24,9 +24,10 @@ class ProducerQueueChannel : public BufferHubChannel {
   // Handles client request to create a new consumer queue attached to current
   // producer queue.
   // Returns a handle for the service channel, as well as the size of the
-  // metadata associated with the queue.
+  // metadata associated with the queue. The consumers of a |silent| queue are
+  // created in the ignored state.
   pdx::Status<pdx::RemoteChannelHandle> OnCreateConsumerQueue(
-      pdx::Message& message);
+      pdx::Message& message, bool silent);
 
   pdx::Status<QueueInfo> OnGetQueueInfo(pdx::Message& message);
 
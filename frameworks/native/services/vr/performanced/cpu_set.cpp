@@ -237,23 +237,26 @@ UniqueFile CpuSet::OpenFilePointer(const std::string& name, int flags) const {
 }
 
 Status<void> CpuSet::AttachTask(pid_t task_id) const {
-  auto file = OpenFile("tasks", O_RDWR);
-  if (file.get() >= 0) {
-    std::ostringstream stream;
-    stream << task_id;
-    std::string value = stream.str();
-
-    const bool ret = base::WriteStringToFd(value, file.get());
-    if (!ret)
-      return ErrorStatus(errno);
-    else
-      return {};
-  } else {
-    const int error = errno;
-    ALOGE("CpuSet::AttachTask: Failed to open %s/tasks: %s", path_.c_str(),
-          strerror(error));
-    return ErrorStatus(error);
+  std::lock_guard<std::mutex> lock(tasks_mutex_);
+  if (tasks_fd_.get() < 0) {
+    tasks_fd_ = OpenFile("tasks", O_WRONLY | O_CLOEXEC);
+    if (tasks_fd_.get() < 0) {
+      const int error = errno;
+      ALOGE("CpuSet::AttachTask: Failed to open %s/tasks: %s", path_.c_str(),
+            strerror(error));
+      return ErrorStatus(error);
+    }
   }
+
+  std::ostringstream stream;
+  stream << task_id;
+  std::string value = stream.str();
+
+  const bool ret = base::WriteStringToFd(value, tasks_fd_.get());
+  if (!ret)
+    return ErrorStatus(errno);
+  else
+    return {};
 }
 
 std::vector<pid_t> CpuSet::GetTasks() const {
@@ -53,6 +53,11 @@ class CpuSet {
   base::unique_fd cpuset_fd_;
   std::vector<std::unique_ptr<CpuSet>> children_;
 
+  // The tasks file is kept open after the first AttachTask() call, since each
+  // write to it moves one task and the file doesn't need to be rewound.
+  mutable std::mutex tasks_mutex_;
+  mutable base::unique_fd tasks_fd_;
+
   static void SetPrefixEnabled(bool enabled) { prefix_enabled_ = enabled; }
   static bool prefix_enabled_;
 
@@ -1141,10 +1141,8 @@ bool EnsureInitialized() {
     static bool initialized;
 
     std::call_once(once_flag, []() {
-        if (driver::OpenHAL()) {
-            DiscoverLayers();
+        if (driver::OpenHAL())
             initialized = true;
-        }
     });
 
     return initialized;
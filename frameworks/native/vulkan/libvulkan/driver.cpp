@@ -71,8 +71,17 @@ class Hal {
 
     int GetDebugReportIndex() const { return debug_report_index_; }
 
+    // Same as the HAL's vkEnumerateInstanceExtensionProperties without a
+    // layer, from the copy made when the HAL was opened.
+    VkResult EnumerateInstanceExtensions(uint32_t* count,
+                                         VkExtensionProperties* props) const;
+
    private:
-    Hal() : dev_(nullptr), debug_report_index_(-1) {}
+    Hal()
+        : dev_(nullptr),
+          debug_report_index_(-1),
+          instance_extensions_(nullptr),
+          instance_extension_count_(0) {}
     Hal(const Hal&) = delete;
     Hal& operator=(const Hal&) = delete;
 
@@ -82,6 +91,11 @@ class Hal {
 
     const hwvulkan_device_t* dev_;
     int debug_report_index_;
+
+    // The HAL's instance extensions never change, so they are only
+    // enumerated once rather than for every instance created.
+    VkExtensionProperties* instance_extensions_;
+    uint32_t instance_extension_count_;
 };
 
 class CreateInfoWrapper {
@@ -281,11 +295,31 @@ bool Hal::InitDebugReportIndex() {
         }
     }
 
-    free(exts);
+    // Kept for the lifetime of the process, like the HAL itself.
+    instance_extensions_ = exts;
+    instance_extension_count_ = count;
 
     return true;
 }
 
+VkResult Hal::EnumerateInstanceExtensions(uint32_t* count,
+                                          VkExtensionProperties* props) const {
+    if (!instance_extensions_)
+        return dev_->EnumerateInstanceExtensionProperties(nullptr, count,
+                                                          props);
+
+    if (!props) {
+        *count = instance_extension_count_;
+        return VK_SUCCESS;
+    }
+
+    uint32_t copied = std::min(*count, instance_extension_count_);
+    std::copy_n(instance_extensions_, copied, props);
+    *count = copied;
+
+    return (copied == instance_extension_count_) ? VK_SUCCESS : VK_INCOMPLETE;
+}
+
 CreateInfoWrapper::CreateInfoWrapper(const VkInstanceCreateInfo& create_info,
                                      const VkAllocationCallbacks& allocator)
     : is_instance_(true),
@@ -407,8 +441,7 @@ VkResult CreateInfoWrapper::SanitizeExtensions() {
 
 VkResult CreateInfoWrapper::QueryExtensionCount(uint32_t& count) const {
     if (is_instance_) {
-        return Hal::Device().EnumerateInstanceExtensionProperties(
-            nullptr, &count, nullptr);
+        return Hal::Get().EnumerateInstanceExtensions(&count, nullptr);
     } else {
         const auto& driver = GetData(physical_dev_).driver;
         return driver.EnumerateDeviceExtensionProperties(physical_dev_, nullptr,
@@ -420,8 +453,7 @@ VkResult CreateInfoWrapper::EnumerateExtensions(
     uint32_t& count,
     VkExtensionProperties* props) const {
     if (is_instance_) {
-        return Hal::Device().EnumerateInstanceExtensionProperties(
-            nullptr, &count, props);
+        return Hal::Get().EnumerateInstanceExtensions(&count, props);
     } else {
         const auto& driver = GetData(physical_dev_).driver;
         return driver.EnumerateDeviceExtensionProperties(physical_dev_, nullptr,
@@ -751,8 +783,11 @@ VkResult EnumerateInstanceExtensionProperties(
         }
     }
 
-    VkResult result = Hal::Device().EnumerateInstanceExtensionProperties(
-        pLayerName, pPropertyCount, pProperties);
+    VkResult result =
+        (pLayerName) ? Hal::Device().EnumerateInstanceExtensionProperties(
+                           pLayerName, pPropertyCount, pProperties)
+                     : Hal::Get().EnumerateInstanceExtensions(pPropertyCount,
+                                                              pProperties);
 
     if (!pLayerName && (result == VK_SUCCESS || result == VK_INCOMPLETE)) {
         int idx = Hal::Get().GetDebugReportIndex();
@@ -424,15 +424,22 @@ void* GetLayerGetProcAddr(const Layer& layer,
 }  // anonymous namespace
 
 void DiscoverLayers() {
-    if (property_get_bool("ro.debuggable", false) &&
-        prctl(PR_GET_DUMPABLE, 0, 0, 0, 0)) {
-        DiscoverLayersInPathList(kSystemLayerLibraryDir);
-    }
-    if (!LoaderData::GetInstance().layer_path.empty())
-        DiscoverLayersInPathList(LoaderData::GetInstance().layer_path);
+    // Discovering a layer means loading its library, and listing the layer
+    // path may mean opening the application APK. Most applications never
+    // use a layer, so this only happens the first time layers are looked up.
+    static std::once_flag once_flag;
+    std::call_once(once_flag, []() {
+        if (property_get_bool("ro.debuggable", false) &&
+            prctl(PR_GET_DUMPABLE, 0, 0, 0, 0)) {
+            DiscoverLayersInPathList(kSystemLayerLibraryDir);
+        }
+        if (!LoaderData::GetInstance().layer_path.empty())
+            DiscoverLayersInPathList(LoaderData::GetInstance().layer_path);
+    });
 }
 
 uint32_t GetLayerCount() {
+    DiscoverLayers();
     return static_cast<uint32_t>(g_instance_layers.size());
 }
 
@@ -441,6 +448,7 @@ const Layer& GetLayer(uint32_t index) {
 }
 
 const Layer* FindLayer(const char* name) {
+    DiscoverLayers();
     auto layer =
         std::find_if(g_instance_layers.cbegin(), g_instance_layers.cend(),
                      [=](const Layer& entry) {
@@ -42,6 +42,8 @@ class LayerRef {
     const Layer* layer_;
 };
 
+// Discovers the available layers, once. GetLayerCount and FindLayer call it,
+// so the layer libraries are only loaded if layers are looked up.
 void DiscoverLayers();
 
 uint32_t GetLayerCount();
@@ -363,20 +363,21 @@ uint32_t get_num_ready_timings(Swapchain& swapchain) {
     return num_ready;
 }
 
-// TODO(ianelliott): DEAL WITH RETURN VALUE (e.g. VK_INCOMPLETE)!!!
-void copy_ready_timings(Swapchain& swapchain,
-                        uint32_t* count,
-                        VkPastPresentationTimingGOOGLE* timings) {
+// Returns VK_INCOMPLETE if some ready timings didn't fit in *count; they are
+// kept for the next call.
+VkResult copy_ready_timings(Swapchain& swapchain,
+                            uint32_t* count,
+                            VkPastPresentationTimingGOOGLE* timings) {
     if (swapchain.timing.empty()) {
         *count = 0;
-        return;
+        return VK_SUCCESS;
     }
 
     size_t last_ready = swapchain.timing.size() - 1;
     while (!swapchain.timing[last_ready].ready()) {
         if (last_ready == 0) {
             *count = 0;
-            return;
+            return VK_SUCCESS;
         }
         last_ready--;
     }
@@ -397,6 +398,11 @@ void copy_ready_timings(Swapchain& swapchain,
     swapchain.timing.removeItemsAt(0, num_to_remove);
 
     *count = num_copied;
+    for (size_t i = 0; i + num_to_remove <= last_ready; i++) {
+        if (swapchain.timing[i].ready())
+            return VK_INCOMPLETE;
+    }
+    return VK_SUCCESS;
 }
 
 android_pixel_format GetNativePixelFormat(VkFormat format) {
@@ -567,9 +573,22 @@ VkResult GetPhysicalDeviceSurfaceCapabilitiesKHR(
         return VK_ERROR_SURFACE_LOST_KHR;
     }
 
-    // TODO(jessehall): Figure out what the min/max values should be.
+    int min_undequeued_buffers;
+    err = window->query(window, NATIVE_WINDOW_MIN_UNDEQUEUED_BUFFERS,
+                        &min_undequeued_buffers);
+    if (err != 0 || min_undequeued_buffers < 0) {
+        ALOGE("NATIVE_WINDOW_MIN_UNDEQUEUED_BUFFERS query failed: %s (%d) value=%d",
+              strerror(-err), err, min_undequeued_buffers);
+        return VK_ERROR_SURFACE_LOST_KHR;
+    }
+
+    // CreateSwapchainKHR allocates minImageCount - 1 images on top of the
+    // ones the consumer holds (plus one in mailbox mode), which must all fit
+    // in the buffer queue slots.
     capabilities->minImageCount = 2;
-    capabilities->maxImageCount = 3;
+    capabilities->maxImageCount = std::max(
+        3u, static_cast<uint32_t>(android::BufferQueueDefs::NUM_BUFFER_SLOTS -
+                                  min_undequeued_buffers));
 
     capabilities->currentExtent =
         VkExtent2D{static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
@@ -981,6 +1000,15 @@ VkResult CreateSwapchainKHR(VkDevice device,
     uint32_t min_undequeued_buffers = static_cast<uint32_t>(query_value);
     uint32_t num_images =
         (create_info->minImageCount - 1) + min_undequeued_buffers;
+    // In mailbox mode a new frame replaces the queued one instead of waiting
+    // for it to be latched, so keep one more image for the application to
+    // render into while one is on screen and another one is queued. Vulkan
+    // allows swapchains with more images than requested.
+    if (create_info->presentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+        num_images++;
+    num_images = std::min(
+        num_images,
+        static_cast<uint32_t>(android::BufferQueueDefs::NUM_BUFFER_SLOTS));
 
     // Lower layer insists that we have at least two buffers. This is wasteful
     // and we'd like to relax it in the shared case, but not all the pieces are
@@ -1509,6 +1537,15 @@ VkResult GetRefreshCycleDurationGOOGLE(
     Swapchain& swapchain = *SwapchainFromHandle(swapchain_handle);
     VkResult result = VK_SUCCESS;
 
+    // The display may have switched modes since the swapchain was created,
+    // and applications pace their frames with this value.
+    int64_t refresh_duration;
+    if (native_window_get_refresh_cycle_duration(
+            swapchain.surface.window.get(), &refresh_duration) ==
+            android::NO_ERROR) {
+        swapchain.refresh_duration = refresh_duration;
+    }
+
     pDisplayTimingProperties->refreshDuration =
             static_cast<uint64_t>(swapchain.refresh_duration);
 
@@ -1532,8 +1569,10 @@ VkResult GetPastPresentationTimingGOOGLE(
     }
 
     if (timings) {
-        // TODO(ianelliott): plumb return value (e.g. VK_INCOMPLETE)
-        copy_ready_timings(swapchain, count, timings);
+        // Look for newly available timestamps first, so that the timings
+        // returned are the same as the ones just counted.
+        get_num_ready_timings(swapchain);
+        result = copy_ready_timings(swapchain, count, timings);
     } else {
         *count = get_num_ready_timings(swapchain);
     }
@@ -108,6 +108,8 @@ public:
     void decode(int tick);
 
 private:
+    int contiguous(int index, int count) const;
+
     enum {
         NORMAL = 0,
         SEND_ONLY = 1,
@@ -233,6 +235,15 @@ void AudioStream::sendDtmf(int event)
     }
 }
 
+// Returns how many of the count samples starting at index are stored one after
+// another in the jitter buffer, before it wraps around. Working on such runs
+// instead of masking every index lets the loops below be vectorized.
+int AudioStream::contiguous(int index, int count) const
+{
+    int room = mBufferMask + 1 - (index & mBufferMask);
+    return (count < room) ? count : room;
+}
+
 bool AudioStream::mix(int32_t *output, int head, int tail, int sampleRate)
 {
     if (mMode == SEND_ONLY) {
@@ -253,8 +264,14 @@ bool AudioStream::mix(int32_t *output, int head, int tail, int sampleRate)
     tail *= mSampleRate;
 
     if (sampleRate == mSampleRate) {
-        for (int i = head; i - tail < 0; ++i) {
-            output[i - head] += mBuffer[i & mBufferMask];
+        for (int i = head; i - tail < 0; ) {
+            int length = contiguous(i, tail - i);
+            const int16_t *input = &mBuffer[i & mBufferMask];
+            for (int j = 0; j < length; ++j) {
+                output[j] += input[j];
+            }
+            output += length;
+            i += length;
         }
     } else {
         // TODO: implement resampling.
@@ -452,8 +469,10 @@ void AudioStream::decode(int tick)
             mBufferTail = mBufferHead;
         } else {
             int tail = (tick + mInterval) * mSampleRate;
-            for (int i = mBufferTail * mSampleRate; i - tail < 0; ++i) {
-                mBuffer[i & mBufferMask] = 0;
+            for (int i = mBufferTail * mSampleRate; i - tail < 0; ) {
+                int length = contiguous(i, tail - i);
+                memset(&mBuffer[i & mBufferMask], 0, length * sizeof(int16_t));
+                i += length;
             }
             mBufferTail = tick + mInterval;
         }
@@ -461,9 +480,11 @@ void AudioStream::decode(int tick)
 
     // Append to the jitter buffer.
     int tail = mBufferTail * mSampleRate;
-    for (int i = 0; i < count; ++i) {
-        mBuffer[tail & mBufferMask] = samples[i];
-        ++tail;
+    for (int i = 0; i < count; ) {
+        int length = contiguous(tail, count - i);
+        memcpy(&mBuffer[tail & mBufferMask], &samples[i], length * sizeof(int16_t));
+        i += length;
+        tail += length;
     }
     mBufferTail += mInterval;
 }
@@ -23,6 +23,10 @@
 #define LOG_TAG "Echo"
 #include <utils/Log.h>
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "EchoSuppressor.h"
 
 // It is very difficult to do echo cancellation at this level due to the lack of
@@ -39,6 +43,29 @@
 // we use integer arithmetic as much as possible and do lots of bookkeeping.
 // Again, parameters and thresholds are chosen by experiments.
 
+// Returns the sum of xs[i] * ys[i], modulo 2^32 like the rest of the bookkeeping.
+// This is where most of the time goes: it runs for every position of the tail.
+static uint32_t dotProduct(const uint16_t *xs, const uint16_t *ys, int count)
+{
+    uint32_t sum = 0;
+    int i = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    uint32x4_t sums = vdupq_n_u32(0);
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t x = vld1q_u16(&xs[i]);
+        uint16x8_t y = vld1q_u16(&ys[i]);
+        sums = vmlal_u16(sums, vget_low_u16(x), vget_low_u16(y));
+        sums = vmlal_u16(sums, vget_high_u16(x), vget_high_u16(y));
+    }
+    sum = vgetq_lane_u32(sums, 0) + vgetq_lane_u32(sums, 1) +
+        vgetq_lane_u32(sums, 2) + vgetq_lane_u32(sums, 3);
+#endif
+    for (; i < count; ++i) {
+        sum += (uint32_t)xs[i] * ys[i];
+    }
+    return sum;
+}
+
 EchoSuppressor::EchoSuppressor(int sampleCount, int tailLength)
 {
     tailLength += sampleCount * 4;
@@ -97,9 +124,7 @@ EchoSuppressor::~EchoSuppressor()
 void EchoSuppressor::run(int16_t *playbacked, int16_t *recorded)
 {
     // Update Xs.
-    for (int i = mTailLength - 1; i >= 0; --i) {
-        mXs[i + mWindowSize] = mXs[i];
-    }
+    memmove(&mXs[mWindowSize], mXs, sizeof(*mXs) * mTailLength);
     for (int i = mWindowSize - 1, j = 0; i >= 0; --i, j += mScale) {
         uint32_t sum = 0;
         for (int k = 0; k < mScale; ++k) {
@@ -112,9 +137,11 @@ void EchoSuppressor::run(int16_t *playbacked, int16_t *recorded)
     }
 
     // Update XSums, X2Sums, and XRecords.
-    for (int i = mTailLength - mWindowSize - 1; i >= 0; --i) {
-        mXSums[i + mWindowSize] = mXSums[i];
-        mX2Sums[i + mWindowSize] = mX2Sums[i];
+    if (mTailLength > mWindowSize) {
+        memmove(&mXSums[mWindowSize], mXSums,
+                sizeof(*mXSums) * (mTailLength - mWindowSize));
+        memmove(&mX2Sums[mWindowSize], mX2Sums,
+                sizeof(*mX2Sums) * (mTailLength - mWindowSize));
     }
     uint16_t *xRecords = &mXRecords[mRecordOffset * mWindowSize];
     for (int i = mWindowSize - 1; i >= 0; --i) {
@@ -152,10 +179,7 @@ void EchoSuppressor::run(int16_t *playbacked, int16_t *recorded)
     // Update XYSums and XYRecords.
     uint32_t *xyRecords = &mXYRecords[mRecordOffset * mTailLength];
     for (int i = mTailLength - 1; i >= 0; --i) {
-        uint32_t xySum = 0;
-        for (int j = mWindowSize - 1; j >= 0; --j) {
-            xySum += mXs[i + j] * ys[j];
-        }
+        uint32_t xySum = dotProduct(&mXs[i], ys, mWindowSize);
         mXYSums[i] += xySum - xyRecords[i];
         xyRecords[i] = xySum;
     }
@@ -250,6 +250,11 @@ void ScriptIntrinsicBlur::setRadius(float radius) {
     }
 }
 
+void ScriptIntrinsicBlur::setBoxApproximation(bool enable) {
+    int32_t value = enable ? 1 : 0;
+    Script::setVar(2, &value, sizeof(value));
+}
+
 
 
 sp<ScriptIntrinsicColorMatrix> ScriptIntrinsicColorMatrix::create(const sp<RS>& rs) {
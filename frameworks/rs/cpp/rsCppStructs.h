@@ -3885,6 +3885,13 @@ class ScriptIntrinsicBlur : public ScriptIntrinsic {
      * @param[in] radius radius of the blur
      */
     void setRadius(float radius);
+    /**
+     * Approximates the gaussian with three successive box blurs, whose cost
+     * doesn't depend on the radius. The result differs slightly from the
+     * gaussian. Only whole-allocation launches are approximated.
+     * @param[in] enable whether to approximate the blur
+     */
+    void setBoxApproximation(bool enable);
 };
 
 /**
@@ -141,22 +141,32 @@ void * RsdCpuReferenceImpl::helperThreadProc(void *vrsc) {
 // Launch a kernel.
 // The callback function is called to execute the kernel.
 void RsdCpuReferenceImpl::launchThreads(WorkerCallback_t cbk, void *data) {
+    launchThreads(cbk, data, mWorkers.mCount);
+}
+
+void RsdCpuReferenceImpl::launchThreads(WorkerCallback_t cbk, void *data,
+                                        uint32_t helperCount) {
+    helperCount = rsMin(helperCount, mWorkers.mCount);
+
     mWorkers.mLaunchData = data;
     mWorkers.mLaunchCallback = cbk;
 
     // fast path for very small launches
     MTLaunchStructCommon *mtls = (MTLaunchStructCommon *)data;
-    if (mtls && mtls->dimPtr->y <= 1 && mtls->end.x <= mtls->start.x + mtls->mSliceSize) {
+    if (helperCount == 0 ||
+        (mtls && mtls->dimPtr->y <= 1 && mtls->end.x <= mtls->start.x + mtls->mSliceSize)) {
         if (mWorkers.mLaunchCallback) {
             mWorkers.mLaunchCallback(mWorkers.mLaunchData, 0);
         }
         return;
     }
 
-    mWorkers.mRunningCount = mWorkers.mCount;
+    // Helpers that aren't woken up keep waiting on their signal, and don't
+    // count as running.
+    mWorkers.mRunningCount = helperCount;
     __sync_synchronize();
 
-    for (uint32_t ct = 0; ct < mWorkers.mCount; ct++) {
+    for (uint32_t ct = 0; ct < helperCount; ct++) {
         mWorkers.mLaunchSignals[ct].set();
     }
 
@@ -415,23 +425,44 @@ static void walk_general_foreach(void *usr, uint32_t idx) {
     }
 }
 
+// Claims the next chunk of [start, end) for a worker of a 1D or 2D foreach
+// launch, returning false once the whole range has been claimed. mSliceNum
+// counts the items already claimed.
+//
+// Each chunk is a fraction of what remains, so chunks start large, which
+// keeps atomic operations rare, and shrink towards the end of the launch.
+// A worker on a slow core then can't hold up the whole launch with a large
+// chunk claimed late. Chunks are never smaller than mSliceSize.
+static bool ClaimChunk(MTLaunchStructCommon *mtls, uint32_t start, uint32_t end,
+                       uint32_t *chunkStart, uint32_t *chunkEnd) {
+    const uint32_t total = end - start;
+    const uint32_t divisor = mtls->rs->getThreadCount() * 4;
+    uint32_t claimed = (uint32_t)mtls->mSliceNum;
+
+    while (claimed < total) {
+        uint32_t chunk = rsMax(mtls->mSliceSize, (total - claimed) / divisor);
+        chunk = rsMin(chunk, total - claimed);
+
+        uint32_t prev = (uint32_t)__sync_val_compare_and_swap(
+                &mtls->mSliceNum, (int)claimed, (int)(claimed + chunk));
+        if (prev == claimed) {
+            *chunkStart = start + claimed;
+            *chunkEnd = *chunkStart + chunk;
+            return true;
+        }
+        claimed = prev;
+    }
+    return false;
+}
+
 static void walk_2d_foreach(void *usr, uint32_t idx) {
     MTLaunchStructForEach *mtls = (MTLaunchStructForEach *)usr;
     RsExpandKernelDriverInfo fep = mtls->fep;
     fep.lid = idx;
     ForEachFunc_t fn = mtls->kernel;
 
-    while (1) {
-        uint32_t slice  = (uint32_t)__sync_fetch_and_add(&mtls->mSliceNum, 1);
-        uint32_t yStart = mtls->start.y + slice * mtls->mSliceSize;
-        uint32_t yEnd   = yStart + mtls->mSliceSize;
-
-        yEnd = rsMin(yEnd, mtls->end.y);
-
-        if (yEnd <= yStart) {
-            return;
-        }
-
+    uint32_t yStart, yEnd;
+    while (ClaimChunk(mtls, mtls->start.y, mtls->end.y, &yStart, &yEnd)) {
         for (fep.current.y = yStart; fep.current.y < yEnd; fep.current.y++) {
             FepPtrSetup(mtls, &fep, mtls->start.x, fep.current.y);
 
@@ -446,17 +477,8 @@ static void walk_1d_foreach(void *usr, uint32_t idx) {
     fep.lid = idx;
     ForEachFunc_t fn = mtls->kernel;
 
-    while (1) {
-        uint32_t slice  = (uint32_t)__sync_fetch_and_add(&mtls->mSliceNum, 1);
-        uint32_t xStart = mtls->start.x + slice * mtls->mSliceSize;
-        uint32_t xEnd   = xStart + mtls->mSliceSize;
-
-        xEnd = rsMin(xEnd, mtls->end.x);
-
-        if (xEnd <= xStart) {
-            return;
-        }
-
+    uint32_t xStart, xEnd;
+    while (ClaimChunk(mtls, mtls->start.x, mtls->end.x, &xStart, &xEnd)) {
         FepPtrSetup(mtls, &fep, xStart, 0);
 
         fn(&fep, xStart, xEnd, fep.outStride[0]);
@@ -823,6 +845,23 @@ void RsdCpuReferenceImpl::launchReduceParallel(const Allocation ** ains,
 }
 
 
+// Launches that touch fewer bytes than this run on the calling thread only:
+// waking up a helper thread would cost more than the work it could take.
+static const size_t kMinThreadedLaunchBytes = 32 * 1024;
+
+// Returns how many helper threads a 1D or 2D foreach launch of count items,
+// of itemBytes bytes each, should wake up. itemBytes is zero when unknown.
+static uint32_t HelpersForLaunch(uint32_t count, uint32_t sliceSize,
+                                 size_t itemBytes, uint32_t helpers) {
+    if (itemBytes && (size_t)count * itemBytes < kMinThreadedLaunchBytes) {
+        return 0;
+    }
+    // Chunks are at least sliceSize items, so there are no more than this
+    // many for the helpers and the calling thread to take.
+    uint32_t slices = (count + sliceSize - 1) / sliceSize;
+    return rsMin(helpers, slices - 1);
+}
+
 void RsdCpuReferenceImpl::launchForEach(const Allocation ** ains,
                                         uint32_t inLen,
                                         Allocation* aout,
@@ -850,13 +889,16 @@ void RsdCpuReferenceImpl::launchForEach(const Allocation ** ains,
         } else if (mtls->fep.dim.y > 1) {
             uint32_t s1 = mtls->fep.dim.y / ((mWorkers.mCount + 1) * 4);
             uint32_t s2 = 0;
+            size_t rowBytes = 0;
 
             // This chooses our slice size to rate limit atomic ops to
             // one per 16k bytes of reads/writes.
             if ((mtls->aout[0] != nullptr) && mtls->aout[0]->mHal.drvState.lod[0].stride) {
-                s2 = targetByteChunk / mtls->aout[0]->mHal.drvState.lod[0].stride;
+                rowBytes = mtls->aout[0]->mHal.drvState.lod[0].stride;
+                s2 = targetByteChunk / rowBytes;
             } else if (mtls->ains[0]) {
-                s2 = targetByteChunk / mtls->ains[0]->mHal.drvState.lod[0].stride;
+                rowBytes = mtls->ains[0]->mHal.drvState.lod[0].stride;
+                s2 = targetByteChunk / rowBytes;
             } else {
                 // Launch option only case
                 // Use s1 based only on the dimensions
@@ -868,17 +910,23 @@ void RsdCpuReferenceImpl::launchForEach(const Allocation ** ains,
                 mtls->mSliceSize = 1;
             }
 
-            launchThreads(walk_2d_foreach, mtls);
+            mtls->mSliceNum = 0;
+            launchThreads(walk_2d_foreach, mtls,
+                          HelpersForLaunch(mtls->end.y - mtls->start.y, mtls->mSliceSize,
+                                           rowBytes, mWorkers.mCount));
         } else {
             uint32_t s1 = mtls->fep.dim.x / ((mWorkers.mCount + 1) * 4);
             uint32_t s2 = 0;
+            size_t elementBytes = 0;
 
             // This chooses our slice size to rate limit atomic ops to
             // one per 16k bytes of reads/writes.
             if ((mtls->aout[0] != nullptr) && mtls->aout[0]->getType()->getElementSizeBytes()) {
-                s2 = targetByteChunk / mtls->aout[0]->getType()->getElementSizeBytes();
+                elementBytes = mtls->aout[0]->getType()->getElementSizeBytes();
+                s2 = targetByteChunk / elementBytes;
             } else if (mtls->ains[0]) {
-                s2 = targetByteChunk / mtls->ains[0]->getType()->getElementSizeBytes();
+                elementBytes = mtls->ains[0]->getType()->getElementSizeBytes();
+                s2 = targetByteChunk / elementBytes;
             } else {
                 // Launch option only case
                 // Use s1 based only on the dimensions
@@ -890,7 +938,10 @@ void RsdCpuReferenceImpl::launchForEach(const Allocation ** ains,
                 mtls->mSliceSize = 1;
             }
 
-            launchThreads(walk_1d_foreach, mtls);
+            mtls->mSliceNum = 0;
+            launchThreads(walk_1d_foreach, mtls,
+                          HelpersForLaunch(mtls->end.x - mtls->start.x, mtls->mSliceSize,
+                                           elementBytes, mWorkers.mCount));
         }
         mInKernel = false;
 
@@ -155,6 +155,8 @@ public:
     bool init(uint32_t version_major, uint32_t version_minor, sym_lookup_t, script_lookup_t);
     void setPriority(int32_t priority) override;
     virtual void launchThreads(WorkerCallback_t cbk, void *data);
+    // Same as above, but only wakes up helperCount of the helper threads.
+    void launchThreads(WorkerCallback_t cbk, void *data, uint32_t helperCount);
     static void * helperThreadProc(void *vrsc);
     RsdCpuScriptImpl * setTLS(RsdCpuScriptImpl *sc);
 
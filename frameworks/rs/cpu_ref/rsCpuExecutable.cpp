@@ -165,6 +165,47 @@ bool SharedLibraryUtils::createSharedLibrary(const char *driverName,
 
 }
 
+static std::string contentCacheName(const char *cacheDir,
+                                    const char *contentKey) {
+    std::string name(cacheDir);
+    name.append("/librs@");
+    name.append(contentKey);
+    name.append(".so");
+    return name;
+}
+
+bool SharedLibraryUtils::restoreFromContentCache(const char *cacheDir,
+                                                 const char *resName,
+                                                 const char *contentKey) {
+    std::string cachedName = contentCacheName(cacheDir, contentKey);
+    if (access(cachedName.c_str(), R_OK) != 0) {
+        return false;
+    }
+    std::string scriptSOName = findSharedObjectName(cacheDir, resName);
+    if (copyFile(scriptSOName.c_str(), cachedName.c_str()) != 0) {
+        unlink(scriptSOName.c_str());
+        return false;
+    }
+    return true;
+}
+
+void SharedLibraryUtils::saveToContentCache(const char *cacheDir,
+                                            const char *resName,
+                                            const char *contentKey) {
+    std::string scriptSOName = findSharedObjectName(cacheDir, resName);
+    std::string cachedName = contentCacheName(cacheDir, contentKey);
+    // Write a temporary file and rename it, so that a concurrent
+    // restoreFromContentCache() never sees a partial library.
+    std::string tmpName(cachedName);
+    tmpName.append("#");
+    tmpName.append(getRandomString(6));
+    if (copyFile(tmpName.c_str(), scriptSOName.c_str()) != 0 ||
+        rename(tmpName.c_str(), cachedName.c_str()) != 0) {
+        ALOGW("Could not save %s to the content cache", scriptSOName.c_str());
+        unlink(tmpName.c_str());
+    }
+}
+
 #endif  // RS_COMPATIBILITY_LIB
 
 const char* RsdCpuScriptImpl::BCC_EXE_PATH = "/system/bin/bcc";
@@ -39,6 +39,21 @@ public:
                                     const char* resName,
                                     const bool reuse = true,
                                     std::string *SOPath = nullptr);
+
+    // Copies the shared library previously saved under contentKey by
+    // saveToContentCache() to the name loadSharedLibrary() uses for resName.
+    // Returns false if there is no such library. The library is copied rather
+    // than linked, since the dynamic linker de-dupes loaded libraries by
+    // inode and scripts with different names must not share globals.
+    static bool restoreFromContentCache(const char *cacheDir,
+                                        const char *resName,
+                                        const char *contentKey);
+
+    // Saves a copy of the shared library compiled for resName under
+    // contentKey, so that scripts with the same content key can reuse it
+    // without compiling.
+    static void saveToContentCache(const char *cacheDir, const char *resName,
+                                   const char *contentKey);
 #endif
 
     // Load the shared library referred to by cacheDir and resName. If we have
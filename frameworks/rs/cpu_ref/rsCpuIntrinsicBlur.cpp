@@ -28,6 +28,13 @@ public:
     void setGlobalVar(uint32_t slot, const void *data, size_t dataLength) override;
     void setGlobalObj(uint32_t slot, ObjectBase *data) override;
 
+    void preLaunch(uint32_t slot, const Allocation ** ains,
+                   uint32_t inLen, Allocation * aout, const void * usr,
+                   uint32_t usrLen, const RsScriptCall *sc) override;
+    void postLaunch(uint32_t slot, const Allocation ** ains,
+                    uint32_t inLen, Allocation * aout, const void * usr,
+                    uint32_t usrLen, const RsScriptCall *sc) override;
+
     ~RsdCpuScriptIntrinsicBlur() override;
     RsdCpuScriptIntrinsicBlur(RsdCpuReferenceImpl *ctx, const Script *s, const Element *e);
 
@@ -44,6 +51,16 @@ protected:
     int mIradius;
     ObjectBaseRef<Allocation> mAlloc;
 
+    // When set, the blur is approximated with three successive box blurs,
+    // whose cost doesn't depend on the radius. The whole output is then
+    // computed by preLaunch, and the kernels have nothing left to do.
+    bool mBoxApproximation;
+    bool mBoxDone;
+    int mBoxRadii[3];
+    // Result of the horizontal passes, in 8.8 fixed point.
+    uint16_t *mBoxTemp;
+    size_t mBoxTempSize;
+
     static void kernelU4(const RsExpandKernelDriverInfo *info,
                          uint32_t xstart, uint32_t xend,
                          uint32_t outstep);
@@ -51,6 +68,8 @@ protected:
                          uint32_t xstart, uint32_t xend,
                          uint32_t outstep);
     void ComputeGaussianWeights();
+    void ComputeBoxRadii();
+    void boxBlur(Allocation *aout);
 };
 
 
@@ -97,15 +116,42 @@ void RsdCpuScriptIntrinsicBlur::ComputeGaussianWeights() {
     }
 }
 
+// Picks three box sizes whose successive application has about the same
+// standard deviation as the gaussian of the current radius.
+// See W. Jarosz, "Fast Image Convolutions", SIGGRAPH 2001.
+void RsdCpuScriptIntrinsicBlur::ComputeBoxRadii() {
+    const int n = 3;
+    float sigma = 0.4f * mRadius + 0.6f;
+    int wl = (int)floorf(sqrtf(12.0f * sigma * sigma / n + 1.0f));
+    if ((wl & 1) == 0) {
+        wl--;
+    }
+    int wu = wl + 2;
+    int m = (int)roundf((12.0f * sigma * sigma - n * wl * wl - 4 * n * wl - 3 * n) /
+                        (-4.0f * wl - 4.0f));
+    for (int i = 0; i < n; i++) {
+        mBoxRadii[i] = ((i < m ? wl : wu) - 1) / 2;
+    }
+}
+
 void RsdCpuScriptIntrinsicBlur::setGlobalObj(uint32_t slot, ObjectBase *data) {
     rsAssert(slot == 1);
     mAlloc.set(static_cast<Allocation *>(data));
 }
 
 void RsdCpuScriptIntrinsicBlur::setGlobalVar(uint32_t slot, const void *data, size_t dataLength) {
-    rsAssert(slot == 0);
-    mRadius = ((const float *)data)[0];
-    ComputeGaussianWeights();
+    switch (slot) {
+    case 0:
+        mRadius = ((const float *)data)[0];
+        ComputeGaussianWeights();
+        ComputeBoxRadii();
+        break;
+    case 2:
+        mBoxApproximation = ((const int32_t *)data)[0] != 0;
+        break;
+    default:
+        rsAssert(0);
+    }
 }
 
 
@@ -297,6 +343,9 @@ void RsdCpuScriptIntrinsicBlur::kernelU4(const RsExpandKernelDriverInfo *info,
         ALOGE("Blur executed without input, skipping");
         return;
     }
+    if (cp->mBoxDone) {
+        return;
+    }
     const uchar *pin = (const uchar *)cp->mAlloc->mHal.drvState.lod[0].mallocPtr;
     const size_t stride = cp->mAlloc->mHal.drvState.lod[0].stride;
 
@@ -368,6 +417,9 @@ void RsdCpuScriptIntrinsicBlur::kernelU1(const RsExpandKernelDriverInfo *info,
         ALOGE("Blur executed without input, skipping");
         return;
     }
+    if (cp->mBoxDone) {
+        return;
+    }
     const uchar *pin = (const uchar *)cp->mAlloc->mHal.drvState.lod[0].mallocPtr;
     const size_t stride = cp->mAlloc->mHal.drvState.lod[0].stride;
 
@@ -435,6 +487,186 @@ void RsdCpuScriptIntrinsicBlur::kernelU1(const RsExpandKernelDriverInfo *info,
     }
 }
 
+// Box blurs a line of n values, stride apart, with clamped edges.
+static void BoxLine(const uint16_t *src, uint16_t *dst, int n, int stride, int r) {
+    const float scale = 1.0f / (2 * r + 1);
+    int32_t sum = 0;
+    for (int k = -r; k <= r; k++) {
+        sum += src[rsMin(rsMax(k, 0), n - 1) * stride];
+    }
+    for (int x = 0; x < n; x++) {
+        dst[x * stride] = (uint16_t)(sum * scale + 0.5f);
+        sum += src[rsMin(x + r + 1, n - 1) * stride] - src[rsMax(x - r, 0) * stride];
+    }
+}
+
+// Box blurs the columns of h rows of w values. Consecutive rows are
+// srcStride and dstStride values apart. All the columns are summed
+// together, a row at a time, which the compiler vectorizes.
+static void BoxColumns(const uint16_t *src, size_t srcStride, uint16_t *dst, size_t dstStride,
+                       int w, int h, int r, int32_t *sums) {
+    const float scale = 1.0f / (2 * r + 1);
+    memset(sums, 0, w * sizeof(int32_t));
+    for (int k = -r; k <= r; k++) {
+        const uint16_t *row = src + rsMin(rsMax(k, 0), h - 1) * srcStride;
+        for (int j = 0; j < w; j++) {
+            sums[j] += row[j];
+        }
+    }
+    for (int y = 0; y < h; y++) {
+        uint16_t *out = dst + y * dstStride;
+        for (int j = 0; j < w; j++) {
+            out[j] = (uint16_t)(sums[j] * scale + 0.5f);
+        }
+        const uint16_t *add = src + rsMin(y + r + 1, h - 1) * srcStride;
+        const uint16_t *sub = src + rsMax(y - r, 0) * srcStride;
+        for (int j = 0; j < w; j++) {
+            sums[j] += add[j] - sub[j];
+        }
+    }
+}
+
+// Columns of the image, counted in bytes, that a worker blurs vertically at
+// a time. A strip and its intermediate results stay in the cache while its
+// three passes run.
+static const int kBoxStripWidth = 64;
+
+struct BoxBlurLaunch : public MTLaunchStructCommon {
+    RsLaunchDimensions dim;
+
+    const uchar *in;
+    size_t inStride;
+    uchar *out;
+    size_t outStride;
+    // Values per row (pixels times vector size), and rows.
+    int rowValues;
+    int rows;
+    int vecSize;
+    const int *radii;
+    uint16_t *temp;
+};
+
+static void BoxBlurRows(void *usr, uint32_t idx) {
+    BoxBlurLaunch *mtls = (BoxBlurLaunch *)usr;
+    const int n = mtls->rowValues / mtls->vecSize;
+    uint16_t *line = (uint16_t *)malloc(2 * mtls->rowValues * sizeof(uint16_t));
+    if (!line) {
+        return;
+    }
+    uint16_t *line2 = line + mtls->rowValues;
+
+    while (1) {
+        int y = __sync_fetch_and_add(&mtls->mSliceNum, 1);
+        if (y >= mtls->rows) {
+            break;
+        }
+        const uchar *in = mtls->in + y * mtls->inStride;
+        for (int i = 0; i < mtls->rowValues; i++) {
+            line[i] = in[i] << 8;
+        }
+        uint16_t *out = mtls->temp + (size_t)y * mtls->rowValues;
+        for (int c = 0; c < mtls->vecSize; c++) {
+            BoxLine(line + c, line2 + c, n, mtls->vecSize, mtls->radii[0]);
+            BoxLine(line2 + c, line + c, n, mtls->vecSize, mtls->radii[1]);
+            BoxLine(line + c, out + c, n, mtls->vecSize, mtls->radii[2]);
+        }
+    }
+    free(line);
+}
+
+static void BoxBlurColumns(void *usr, uint32_t idx) {
+    BoxBlurLaunch *mtls = (BoxBlurLaunch *)usr;
+    const int h = mtls->rows;
+    uint16_t *a = (uint16_t *)malloc(2 * h * kBoxStripWidth * sizeof(uint16_t));
+    int32_t *sums = (int32_t *)malloc(kBoxStripWidth * sizeof(int32_t));
+    if (!a || !sums) {
+        free(a);
+        free(sums);
+        return;
+    }
+    uint16_t *b = a + h * kBoxStripWidth;
+
+    while (1) {
+        int strip = __sync_fetch_and_add(&mtls->mSliceNum, 1);
+        int x1 = strip * kBoxStripWidth;
+        if (x1 >= mtls->rowValues) {
+            break;
+        }
+        int w = rsMin(kBoxStripWidth, mtls->rowValues - x1);
+
+        BoxColumns(mtls->temp + x1, mtls->rowValues, a, w, w, h, mtls->radii[0], sums);
+        BoxColumns(a, w, b, w, w, h, mtls->radii[1], sums);
+        BoxColumns(b, w, a, w, w, h, mtls->radii[2], sums);
+
+        for (int y = 0; y < h; y++) {
+            const uint16_t *src = a + y * w;
+            uchar *out = mtls->out + y * mtls->outStride + x1;
+            for (int j = 0; j < w; j++) {
+                out[j] = (uchar)rsMin((src[j] + 128) >> 8, 255);
+            }
+        }
+    }
+    free(a);
+    free(sums);
+}
+
+void RsdCpuScriptIntrinsicBlur::boxBlur(Allocation *aout) {
+    BoxBlurLaunch mtls;
+    memset(&mtls, 0, sizeof(mtls));
+
+    mtls.vecSize = mAlloc->getType()->getElement()->getVectorSize();
+    mtls.rowValues = aout->mHal.drvState.lod[0].dimX * mtls.vecSize;
+    mtls.rows = rsMax(aout->mHal.drvState.lod[0].dimY, 1U);
+    mtls.in = (const uchar *)mAlloc->mHal.drvState.lod[0].mallocPtr;
+    mtls.inStride = mAlloc->mHal.drvState.lod[0].stride;
+    mtls.out = (uchar *)aout->mHal.drvState.lod[0].mallocPtr;
+    mtls.outStride = aout->mHal.drvState.lod[0].stride;
+    mtls.radii = mBoxRadii;
+
+    size_t tempSize = (size_t)mtls.rowValues * mtls.rows;
+    if (tempSize > mBoxTempSize) {
+        free(mBoxTemp);
+        mBoxTemp = (uint16_t *)malloc(tempSize * sizeof(uint16_t));
+        mBoxTempSize = mBoxTemp ? tempSize : 0;
+    }
+    if (!mBoxTemp) {
+        return;
+    }
+    mtls.temp = mBoxTemp;
+
+    // Keep launchThreads off its single-slice shortcut, which the rows and
+    // strips don't map to.
+    mtls.rs = mCtx;
+    mtls.dim.y = mtls.rows + 1;
+    mtls.dimPtr = &mtls.dim;
+    mtls.mSliceSize = 1;
+
+    mtls.mSliceNum = 0;
+    mCtx->launchThreads(BoxBlurRows, &mtls);
+    mtls.mSliceNum = 0;
+    mCtx->launchThreads(BoxBlurColumns, &mtls);
+
+    mBoxDone = true;
+}
+
+void RsdCpuScriptIntrinsicBlur::preLaunch(uint32_t slot, const Allocation ** ains,
+                                          uint32_t inLen, Allocation * aout,
+                                          const void * usr, uint32_t usrLen,
+                                          const RsScriptCall *sc) {
+    // Launches limited to part of the output use the gaussian kernels.
+    mBoxDone = false;
+    if (mBoxApproximation && !sc && aout && mAlloc.get()) {
+        boxBlur(aout);
+    }
+}
+
+void RsdCpuScriptIntrinsicBlur::postLaunch(uint32_t slot, const Allocation ** ains,
+                                           uint32_t inLen, Allocation * aout,
+                                           const void * usr, uint32_t usrLen,
+                                           const RsScriptCall *sc) {
+    mBoxDone = false;
+}
+
 RsdCpuScriptIntrinsicBlur::RsdCpuScriptIntrinsicBlur(RsdCpuReferenceImpl *ctx,
                                                      const Script *s, const Element *e)
             : RsdCpuScriptIntrinsic(ctx, s, e, RS_SCRIPT_INTRINSIC_ID_BLUR) {
@@ -452,6 +684,10 @@ RsdCpuScriptIntrinsicBlur::RsdCpuScriptIntrinsicBlur(RsdCpuReferenceImpl *ctx,
     }
     rsAssert(mRootPtr);
     mRadius = 5;
+    mBoxApproximation = false;
+    mBoxDone = false;
+    mBoxTemp = nullptr;
+    mBoxTempSize = 0;
 
     mScratch = new void *[mCtx->getThreadCount()];
     mScratchSize = new size_t[mCtx->getThreadCount()];
@@ -459,9 +695,12 @@ RsdCpuScriptIntrinsicBlur::RsdCpuScriptIntrinsicBlur(RsdCpuReferenceImpl *ctx,
     memset(mScratchSize, 0, sizeof(size_t) * mCtx->getThreadCount());
 
     ComputeGaussianWeights();
+    ComputeBoxRadii();
 }
 
 RsdCpuScriptIntrinsicBlur::~RsdCpuScriptIntrinsicBlur() {
+    free(mBoxTemp);
+
     uint32_t threads = mCtx->getThreadCount();
     if (mScratch) {
         for (size_t i = 0; i < threads; i++) {
@@ -477,7 +716,7 @@ RsdCpuScriptIntrinsicBlur::~RsdCpuScriptIntrinsicBlur() {
 }
 
 void RsdCpuScriptIntrinsicBlur::populateScript(Script *s) {
-    s->mHal.info.exportedVariableCount = 2;
+    s->mHal.info.exportedVariableCount = 3;
 }
 
 void RsdCpuScriptIntrinsicBlur::invokeFreeChildren() {
@@ -30,6 +30,7 @@
 
     #include <zlib.h>
     #include <sys/file.h>
+    #include <sys/stat.h>
     #include <sys/types.h>
     #include <unistd.h>
 
@@ -42,6 +43,7 @@
 #include <dlfcn.h>
 #include <stdlib.h>
 #include <string.h>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 
@@ -197,6 +199,58 @@ bool addFileToChecksum(const char *fileName, uint32_t &checksum) {
     return true;
 }
 
+// 64-bit FNV-1a, used to name compiled scripts by their content.
+uint64_t hashBytes(uint64_t hash, const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint64_t hashString(uint64_t hash, const char *str) {
+    // Include the terminator so that consecutive strings can't be confused.
+    return str ? hashBytes(hash, str, strlen(str) + 1) : hashBytes(hash, "", 1);
+}
+
+// Identifies the compiler or library at path by its size and modification
+// time, which change with every update of the system image.
+uint64_t hashFileIdentity(uint64_t hash, const char *path) {
+    struct stat st;
+    if (path == nullptr || stat(path, &st) != 0) {
+        return hashString(hash, path);
+    }
+    int64_t identity[] = { st.st_size, st.st_mtime };
+    hash = hashString(hash, path);
+    return hashBytes(hash, identity, sizeof(identity));
+}
+
+// Returns a key for the shared object compiled from bitcode with the given
+// options. Two scripts with the same key can use the same shared object,
+// whatever their names. The command line is not hashed since it contains the
+// names of the script's files; the options it is built from are hashed
+// instead.
+std::string constructContentKey(uint8_t const *bitcode, size_t bitcodeSize,
+                                const char *coreLib, const char *driverName,
+                                const char *bccPluginName, int optLevel,
+                                bool emitGlobalInfo,
+                                bool emitGlobalInfoSkipConstant,
+                                uint32_t buildChecksum) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = hashBytes(hash, bitcode, bitcodeSize);
+    hash = hashFileIdentity(hash, android::renderscript::RsdCpuScriptImpl::BCC_EXE_PATH);
+    hash = hashFileIdentity(hash, coreLib);
+    hash = hashString(hash, driverName);
+    hash = hashString(hash, bccPluginName);
+    int32_t options[] = { optLevel, emitGlobalInfo, emitGlobalInfoSkipConstant,
+                          static_cast<int32_t>(buildChecksum) };
+    hash = hashBytes(hash, options, sizeof(options));
+
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return ss.str();
+}
+
 #endif  // !defined(RS_COMPATIBILITY_LIB)
 }  // namespace
 
@@ -371,6 +425,7 @@ bool RsdCpuScriptImpl::init(char const *resName, char const *cacheDir,
     compileArguments.push_back(nullptr);
 
     const bool reuse = !is_force_recompile() && !useRSDebugContext;
+    std::string contentKey;
     if (reuse) {
         mScriptSO = SharedLibraryUtils::loadSharedLibrary(cacheDir, resName);
 
@@ -379,6 +434,23 @@ bool RsdCpuScriptImpl::init(char const *resName, char const *cacheDir,
             dlclose(mScriptSO);
             mScriptSO = nullptr;
         }
+
+        // Another script of this application may have been compiled from
+        // the same bitcode, e.g. under a different name.
+        if (mScriptSO == nullptr) {
+            contentKey = constructContentKey(
+                bitcode, bitcodeSize, core_lib,
+                mCtx->getContext()->getDriverName(), bccPluginName, optLevel,
+                emitGlobalInfo, emitGlobalInfoSkipConstant, mBuildChecksum);
+            if (SharedLibraryUtils::restoreFromContentCache(
+                    cacheDir, resName, contentKey.c_str())) {
+                mScriptSO = SharedLibraryUtils::loadSharedLibrary(cacheDir, resName);
+                if (mScriptSO != nullptr && !storeRSInfoFromSO()) {
+                    dlclose(mScriptSO);
+                    mScriptSO = nullptr;
+                }
+            }
+        }
     }
 
     // If reuse is desired and we can't, it's either not there or out of date.
@@ -417,6 +489,11 @@ bool RsdCpuScriptImpl::init(char const *resName, char const *cacheDir,
         if (!storeRSInfoFromSO()) {
             goto error;
         }
+
+        if (reuse) {
+            SharedLibraryUtils::saveToContentCache(cacheDir, resName,
+                                                   contentKey.c_str());
+        }
     }
 
     mBitcodeFilePath.assign(bcFileName.c_str());
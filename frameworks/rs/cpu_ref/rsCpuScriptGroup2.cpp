@@ -34,16 +34,31 @@ namespace {
 
 const size_t DefaultKernelArgCount = 2;
 
-void groupRoot(const RsExpandKernelDriverInfo *kinfo, uint32_t xstart,
-               uint32_t xend, uint32_t outstep) {
+// Bytes of inputs and outputs that all the closures of an unfused batch
+// touch per tile. The closures run one after the other over a tile, so that
+// an intermediate result is still in the cache when the next kernel reads
+// it, rather than written out to memory for the whole range first.
+const size_t GroupTileBytes = 64 * 1024;
+
+// Returns the number of bytes the closures read and write per cell.
+size_t bytesPerCell(const List<CPUClosure*>& closures) {
+    size_t bytes = 0;
+    for (CPUClosure* cpuClosure : closures) {
+        const Closure* closure = cpuClosure->mClosure;
+        for (size_t i = 0; i < closure->mNumArg; i++) {
+            const Allocation* a = (const Allocation*)closure->mArgs[i];
+            bytes += a->mHal.state.elementSizeBytes;
+        }
+        bytes += closure->mReturnValue->mHal.state.elementSizeBytes;
+    }
+    return bytes;
+}
+
+void groupRootTile(const RsExpandKernelDriverInfo *kinfo, uint32_t xstart,
+                   uint32_t xend) {
     const List<CPUClosure*>& closures = *(List<CPUClosure*>*)kinfo->usr;
     RsExpandKernelDriverInfo *mutable_kinfo = const_cast<RsExpandKernelDriverInfo *>(kinfo);
 
-    const size_t oldInLen = mutable_kinfo->inLen;
-
-    decltype(mutable_kinfo->inStride) oldInStride;
-    memcpy(&oldInStride, &mutable_kinfo->inStride, sizeof(oldInStride));
-
     for (CPUClosure* cpuClosure : closures) {
         const Closure* closure = cpuClosure->mClosure;
 
@@ -81,6 +96,31 @@ void groupRoot(const RsExpandKernelDriverInfo *kinfo, uint32_t xstart,
         cpuClosure->mFunc(kinfo, xstart, xend, ostep);
     }
 
+    mutable_kinfo->usr = &closures;
+}
+
+void groupRoot(const RsExpandKernelDriverInfo *kinfo, uint32_t xstart,
+               uint32_t xend, uint32_t outstep) {
+    const List<CPUClosure*>& closures = *(List<CPUClosure*>*)kinfo->usr;
+    RsExpandKernelDriverInfo *mutable_kinfo = const_cast<RsExpandKernelDriverInfo *>(kinfo);
+
+    const size_t oldInLen = mutable_kinfo->inLen;
+
+    decltype(mutable_kinfo->inStride) oldInStride;
+    memcpy(&oldInStride, &mutable_kinfo->inStride, sizeof(oldInStride));
+
+    // Kernels in a batch are chained through their first argument, one cell
+    // at a time, so the range can be split at any cell.
+    const size_t cellBytes = bytesPerCell(closures);
+    const uint32_t tileCells = (uint32_t)rsMax((size_t)1,
+                                               GroupTileBytes / rsMax((size_t)1, cellBytes));
+
+    for (uint32_t tileStart = xstart; tileStart < xend; ) {
+        const uint32_t tileEnd = (xend - tileStart > tileCells) ? tileStart + tileCells : xend;
+        groupRootTile(kinfo, tileStart, tileEnd);
+        tileStart = tileEnd;
+    }
+
     mutable_kinfo->inLen = oldInLen;
     mutable_kinfo->usr = &closures;
     memcpy(&mutable_kinfo->inStride, &oldInStride, sizeof(oldInStride));
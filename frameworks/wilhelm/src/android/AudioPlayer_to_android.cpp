@@ -1252,50 +1252,58 @@ static void audioTrack_callBack_pullFromBuffQueue(int event, void* user, void *i
         // retrieve data from the buffer queue
         interface_lock_exclusive(&ap->mBufferQueue);
 
-        if (ap->mBufferQueue.mCallbackPending) {
-            // call callback with lock not held
+        if (ap->mBufferQueue.mCallbacksPending != 0) {
+            // call callback with lock not held, once per buffer played out
             slBufferQueueCallback callback = ap->mBufferQueue.mCallback;
-            if (NULL != callback) {
+            if (NULL == callback) {
+                ap->mBufferQueue.mCallbacksPending = 0;
+            }
+            while (NULL != callback && ap->mBufferQueue.mCallbacksPending != 0) {
+                ap->mBufferQueue.mCallbacksPending--;
                 callbackPContext = ap->mBufferQueue.mContext;
                 interface_unlock_exclusive(&ap->mBufferQueue);
                 (*callback)(&ap->mBufferQueue.mItf, callbackPContext);
                 interface_lock_exclusive(&ap->mBufferQueue);
-                ap->mBufferQueue.mCallbackPending = false;
             }
         }
 
         if (ap->mBufferQueue.mState.count != 0) {
-            //SL_LOGV("nbBuffers in queue = %u",ap->mBufferQueue.mState.count);
-            assert(ap->mBufferQueue.mFront != ap->mBufferQueue.mRear);
-
-            BufferHeader *oldFront = ap->mBufferQueue.mFront;
-            BufferHeader *newFront = &oldFront[1];
-
-            size_t availSource = oldFront->mSize - ap->mBufferQueue.mSizeConsumed;
-            size_t availSink = pBuff->size;
-            size_t bytesToCopy = availSource < availSink ? availSource : availSink;
-            void *pSrc = (char *)oldFront->mBuffer + ap->mBufferQueue.mSizeConsumed;
-            memcpy(pBuff->raw, pSrc, bytesToCopy);
+            // Fill the AudioTrack buffer from as many queued buffers as needed, rather than
+            // returning a partial buffer and being called back for each small app buffer.
+            size_t sizeFilled = 0;
+            while (sizeFilled < pBuff->size && ap->mBufferQueue.mState.count != 0) {
+                //SL_LOGV("nbBuffers in queue = %u",ap->mBufferQueue.mState.count);
+                assert(ap->mBufferQueue.mFront != ap->mBufferQueue.mRear);
+
+                BufferHeader *oldFront = ap->mBufferQueue.mFront;
+                BufferHeader *newFront = &oldFront[1];
+
+                size_t availSource = oldFront->mSize - ap->mBufferQueue.mSizeConsumed;
+                size_t availSink = pBuff->size - sizeFilled;
+                size_t bytesToCopy = availSource < availSink ? availSource : availSink;
+                void *pSrc = (char *)oldFront->mBuffer + ap->mBufferQueue.mSizeConsumed;
+                memcpy((char *)pBuff->raw + sizeFilled, pSrc, bytesToCopy);
+                sizeFilled += bytesToCopy;
+
+                if (bytesToCopy < availSource) {
+                    ap->mBufferQueue.mSizeConsumed += bytesToCopy;
+                } else {
+                    // consumed an entire buffer, dequeue
+                    ap->mBufferQueue.mSizeConsumed = 0;
+                    if (newFront ==
+                            &ap->mBufferQueue.mArray
+                                [ap->mBufferQueue.mNumBuffers + 1])
+                    {
+                        newFront = ap->mBufferQueue.mArray;
+                    }
+                    ap->mBufferQueue.mFront = newFront;
 
-            if (bytesToCopy < availSource) {
-                ap->mBufferQueue.mSizeConsumed += bytesToCopy;
-                // pBuff->size is already equal to bytesToCopy in this case
-            } else {
-                // consumed an entire buffer, dequeue
-                pBuff->size = bytesToCopy;
-                ap->mBufferQueue.mSizeConsumed = 0;
-                if (newFront ==
-                        &ap->mBufferQueue.mArray
-                            [ap->mBufferQueue.mNumBuffers + 1])
-                {
-                    newFront = ap->mBufferQueue.mArray;
+                    ap->mBufferQueue.mState.count--;
+                    ap->mBufferQueue.mState.playIndex++;
+                    ap->mBufferQueue.mCallbacksPending++;
                 }
-                ap->mBufferQueue.mFront = newFront;
-
-                ap->mBufferQueue.mState.count--;
-                ap->mBufferQueue.mState.playIndex++;
-                ap->mBufferQueue.mCallbackPending = true;
             }
+            pBuff->size = sizeFilled;
         } else { // empty queue
             // signal no data available
             pBuff->size = 0;
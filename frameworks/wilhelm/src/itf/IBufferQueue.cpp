@@ -97,7 +97,7 @@ SLresult IBufferQueue_Clear(SLBufferQueueItf self)
         thiz->mState.count = 0;
         thiz->mState.playIndex = 0;
         thiz->mSizeConsumed = 0;
-        thiz->mCallbackPending = false;
+        thiz->mCallbacksPending = 0;
     }
 #endif
 
@@ -189,7 +189,7 @@ void IBufferQueue_init(void *self)
     thiz->mRear = NULL;
 #ifdef ANDROID
     thiz->mSizeConsumed = 0;
-    thiz->mCallbackPending = false;
+    thiz->mCallbacksPending = 0;
 #endif
     BufferHeader *bufferHeader = thiz->mTypical;
     unsigned i;
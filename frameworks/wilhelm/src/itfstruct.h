@@ -239,7 +239,8 @@ typedef struct BufferQueue_interface {
     BufferHeader *mFront, *mRear;
 #ifdef ANDROID
     SLuint32 mSizeConsumed;
-    bool mCallbackPending;
+    // number of buffers played out whose callback has not been called yet
+    SLuint32 mCallbacksPending;
 #endif
     // saves a malloc in the typical case
 #define BUFFER_HEADER_TYPICAL 4